@@ -0,0 +1,131 @@
+#pragma once
+
+#include "cluster/cluster_settings.h"
+#include "core/checkpoint.h"
+#include "core/keyspace_scheduler.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class LineSocket;
+
+/**
+ * Leases keyspace chunks to cluster workers
+ *
+ * Workers connect over TCP and exchange one-line text messages:
+ *   HELLO node fingerprint     -> WELCOME heartbeat | REJECT reason
+ *   LEASE                      -> CHUNK id begin end | WAIT seconds | DONE | STOP
+ *   COMPLETE id tested seconds -> OK
+ *   HEARTBEAT                  -> OK
+ *   FOUND id password_hex      -> OK, and STOP to every other worker
+ * STOP may also arrive unsolicited at any time.
+ *
+ * Every message from a worker renews its leases. A lease not renewed for
+ * three heartbeat intervals, or whose connection drops, goes back to the
+ * front of the queue for the next worker that asks. Lease sizes follow
+ * each node's measured rate: a lease is about progress_sync_interval
+ * seconds of that node's work, capped near the end at the node's share of
+ * what is left so fast and slow nodes finish together. A lease is at most
+ * twice the node's previous one, so a single early measurement cannot
+ * hand one node most of the keyspace.
+ */
+class ClusterCoordinator {
+public:
+    explicit ClusterCoordinator(const ClusterSettings& settings);
+    ~ClusterCoordinator();
+
+    ClusterCoordinator(const ClusterCoordinator&) = delete;
+    ClusterCoordinator& operator=(const ClusterCoordinator&) = delete;
+
+    /**
+     * Bind the coordinator port and prepare the keyspace
+     * @param keyspace Full search space
+     * @param fingerprint Checkpoint::fingerprint of the search; workers must match it
+     * @param completed Ranges already tested, e.g. from a checkpoint
+     * @return false if the port cannot be bound
+     */
+    bool start(const KeyspaceRange& keyspace, const std::string& fingerprint,
+               const std::vector<KeyspaceRange>& completed = {});
+
+    /**
+     * Serve workers until the keyspace is exhausted, the password is found
+     * or stop() is called
+     * @param checkpoint Saved whenever it is due and once more on return (may be null)
+     * @return true if a worker found the password
+     */
+    bool run(Checkpoint* checkpoint = nullptr);
+
+    /**
+     * Handle pending connections and messages once
+     * @param timeout_ms Longest time to wait for activity
+     */
+    void poll_once(int timeout_ms);
+
+    /**
+     * Make run() return; safe to call from another thread or a signal handler
+     */
+    void stop() { stopped_.store(true); }
+
+    bool finished() const;
+    bool found() const { return found_; }
+    const std::string& get_found_password() const { return found_password_; }
+    uint16_t port() const { return port_; }
+    size_t worker_count() const { return connections_.size(); }
+    size_t active_leases() const { return leases_.size(); }
+    uint64_t expired_leases() const { return expired_leases_; }
+
+    /**
+     * Current progress as a checkpoint
+     */
+    CheckpointState checkpoint_state() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Connection {
+        std::unique_ptr<LineSocket> socket;
+        int node_id = -1;
+        bool welcomed = false;
+        double rate = 0.0;          // Smoothed candidates per second
+        uint64_t last_lease = 0;    // Size of the previous lease
+        Clock::time_point last_seen;
+    };
+
+    struct Lease {
+        KeyspaceRange range;
+        int fd;                     // Connection holding the lease
+        Clock::time_point issued;
+    };
+
+    ClusterSettings settings_;
+    int listen_fd_;
+    uint16_t port_;
+    std::string fingerprint_;
+    KeyspaceRange keyspace_;
+
+    std::map<int, Connection> connections_;       // by socket descriptor
+    std::deque<KeyspaceRange> pending_;           // Not yet leased; returned leases go first
+    std::map<uint64_t, Lease> leases_;
+    uint64_t next_lease_id_;
+    CompletedRanges completed_;
+    uint64_t candidates_tested_;
+    uint64_t expired_leases_;
+    Clock::time_point started_;
+
+    bool found_;
+    std::string found_password_;
+    std::atomic<bool> stopped_;
+
+    void accept_connection();
+    bool handle_message(int fd, Connection& connection, const std::string& message);
+    std::string lease_chunk(int fd, Connection& connection);
+    uint64_t chunk_size(const Connection& connection) const;
+    void expire_leases();
+    void release_leases(int fd);
+    void broadcast(const std::string& message);
+};
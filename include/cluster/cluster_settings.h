@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Cluster settings from config/cluster.yaml
+ *
+ * Only the keys the coordinator and workers use are read; every other key
+ * is left to the deployment tooling.
+ */
+struct ClusterSettings {
+    bool enabled = false;
+    int total_nodes = 1;
+    int node_id = 0;
+    std::string coordinator_host = "localhost";
+    uint16_t coordinator_port = 8080;
+
+    uint64_t work_chunk_size = 1000000;   // First lease for a node with no measured rate
+    int progress_sync_interval = 30;      // Seconds of work per lease once a rate is known
+    int result_sync_interval = 5;         // Longest a worker waits before asking again
+
+    int timeout = 30;                     // Connect/send timeout in seconds
+    int retry_attempts = 3;
+    int heartbeat_interval = 10;          // Leases expire after three missed heartbeats
+
+    bool monitoring_enabled = false;      // Serve /metrics on metrics_port
+    int metrics_port = 9090;
+
+    /**
+     * Read a cluster.yaml file
+     * @param file_path Path to the file
+     * @return false if the file cannot be read or a value is invalid
+     */
+    bool load_file(const std::string& file_path);
+};
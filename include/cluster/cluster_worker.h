@@ -0,0 +1,95 @@
+#pragma once
+
+#include "cluster/cluster_settings.h"
+#include "core/keyspace_scheduler.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class LineSocket;
+
+/**
+ * Cluster worker side of the ClusterCoordinator protocol
+ *
+ * lease() hands out the next chunk for the local engine to search, and
+ * complete() reports it with the measured time so later leases are sized
+ * to this node. A background thread sends heartbeats while chunks are
+ * being searched, and a reader thread picks up the coordinator's STOP
+ * broadcast: stop_requested() turns true and the stop callback runs, so
+ * local workers can abandon their current chunk immediately.
+ */
+class ClusterWorker {
+public:
+    explicit ClusterWorker(const ClusterSettings& settings);
+    ~ClusterWorker();
+
+    ClusterWorker(const ClusterWorker&) = delete;
+    ClusterWorker& operator=(const ClusterWorker&) = delete;
+
+    /**
+     * Connect to the coordinator, retrying up to retry_attempts times
+     * @param fingerprint Checkpoint::fingerprint of the local search
+     * @return false if the coordinator is unreachable or rejects the search
+     */
+    bool connect(const std::string& fingerprint);
+
+    /**
+     * Get the next chunk, waiting while all work is leased out
+     * @param chunk Output range
+     * @param lease_id Output lease, passed back to complete()
+     * @return false once the search is over or the connection is lost
+     */
+    bool lease(KeyspaceRange& chunk, uint64_t& lease_id);
+
+    /**
+     * Report a fully searched chunk
+     * @param lease_id Lease from lease()
+     * @param tested Candidates tested
+     * @param seconds Time spent
+     * @return false if the coordinator could not be told
+     */
+    bool complete(uint64_t lease_id, uint64_t tested, double seconds);
+
+    /**
+     * Report the password; the coordinator stops every other node
+     */
+    bool report_found(uint64_t lease_id, const std::string& password);
+
+    /**
+     * Called once, from the reader thread, when the coordinator says stop
+     */
+    void set_stop_callback(std::function<void()> callback) { stop_callback_ = std::move(callback); }
+
+    bool stop_requested() const { return stopped_.load(); }
+    void disconnect();
+
+private:
+    ClusterSettings settings_;
+    std::unique_ptr<LineSocket> socket_;
+
+    std::mutex request_lock_;        // One request in flight at a time
+    std::mutex reply_lock_;
+    std::condition_variable reply_ready_;
+    std::deque<std::string> replies_;
+    bool connected_;
+
+    std::atomic<bool> stopped_;
+    std::atomic<bool> shutting_down_;
+    std::function<void()> stop_callback_;
+
+    std::thread reader_;
+    std::thread heartbeat_;
+    std::mutex heartbeat_lock_;
+    std::condition_variable heartbeat_wakeup_;
+
+    bool request(const std::string& message, std::string& reply);
+    void read_loop();
+    void heartbeat_loop();
+    void request_stop();
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "utils/metrics.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+/**
+ * Minimal HTTP endpoint serving a MetricsRegistry to Prometheus
+ *
+ * Answers GET /metrics on its own thread, one connection at a time; a
+ * scrape renders the registry and never touches the search threads.
+ */
+class MetricsServer {
+public:
+    explicit MetricsServer(const MetricsRegistry& registry = MetricsRegistry::global());
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    /**
+     * Listen on a port and start serving
+     * @param port TCP port (0 = any free port)
+     * @return false if the port cannot be bound
+     */
+    bool start(uint16_t port);
+
+    /**
+     * Stop serving and close the port
+     */
+    void stop();
+
+    /**
+     * Port actually bound, 0 before start()
+     */
+    uint16_t port() const { return port_; }
+
+    const std::string& get_last_error() const { return last_error_; }
+
+private:
+    const MetricsRegistry& registry_;
+    int listen_fd_;
+    uint16_t port_;
+    std::atomic<bool> stop_;
+    std::thread thread_;
+    std::string last_error_;
+
+    void run();
+    void serve(int fd);
+};
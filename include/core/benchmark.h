@@ -0,0 +1,133 @@
+#pragma once
+
+#include "utils/scrypt.h"
+#include "wallets/bitcoin_core_mkey.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Candidate throughput measured with synthetic wallets
+ *
+ * Each case builds a master-key record whose password is known, runs full
+ * batches of mask candidates through one backend and checks that the
+ * known password, placed last in every batch, is the one reported. A
+ * backend that reports nothing or the wrong candidate fails the case
+ * instead of producing an optimistic number.
+ *
+ * The scrypt backends measure the BIP38 key derivation the same way, once
+ * per run rather than per PBKDF2 iteration count: cpu-scrypt keeps full V
+ * tables, cpu-scrypt-tmto runs the lookup gap scrypt_plan_tmto picks for
+ * a memory budget, as the GPU scrypt paths do.
+ */
+enum class BenchmarkBackend {
+    CPU_SCALAR,
+    CPU_AVX2,
+    CPU_AVX512,
+    CUDA,
+    OPENCL,
+    CPU_SCRYPT,
+    CPU_SCRYPT_TMTO
+};
+
+struct BenchmarkOptions {
+    std::vector<uint32_t> iterations = {25000, 100000};  // PBKDF2-SHA512 iteration counts
+    std::vector<size_t> batch_sizes;                     // Candidates per batch, empty for backend defaults
+    std::vector<BenchmarkBackend> backends;              // Empty runs every backend this build and host have
+    double min_seconds = 2.0;                            // Batches are repeated until this much time passed
+    int threads = 0;                                     // CPU threads, 0 = one per hardware thread
+    ScryptParams scrypt = {16384, 8, 8};                 // scrypt cost of the scrypt backends (BIP38)
+    size_t scrypt_memory_budget = 0;                     // V table bytes for cpu-scrypt-tmto, 0 = a quarter
+                                                         // of one full table per thread
+};
+
+struct BenchmarkResult {
+    std::string wallet_format;
+    std::string kdf;
+    uint32_t iterations = 0;          // PBKDF2 iteration count, or N for scrypt
+    uint32_t scrypt_r = 0;            // scrypt only
+    uint32_t scrypt_p = 0;
+    uint32_t lookup_gap = 0;          // scrypt only, 1 = full V tables
+    std::string backend;
+    int device = -1;                  // GPU ordinal or index, -1 for the CPU
+    size_t batch_size = 0;
+    uint64_t candidates = 0;
+    double seconds = 0.0;
+    double candidates_per_second = 0.0;
+    bool verified = false;            // Every batch reported exactly the known password
+    std::string error;
+};
+
+class BenchmarkRunner {
+public:
+    explicit BenchmarkRunner(const BenchmarkOptions& options);
+
+    /**
+     * Run every combination of iteration count, backend, device and batch size
+     * @return one result per case, failed cases carry an error
+     */
+    std::vector<BenchmarkResult> run();
+
+    /**
+     * Render results with the host description as a JSON document
+     * @param results Output of run()
+     * @return JSON text
+     */
+    static std::string to_json(const std::vector<BenchmarkResult>& results);
+
+    /**
+     * Build a master-key record that the given password opens
+     * @param password Known password
+     * @param iterations PBKDF2-SHA512 iteration count
+     * @return verification record for the master-key check
+     */
+    static BitcoinCoreMKeyCheck make_synthetic_wallet(const std::string& password, uint32_t iterations);
+
+    /**
+     * Get the printable name of a backend
+     * @param backend Backend
+     * @return name as used on the command line
+     */
+    static std::string backend_name(BenchmarkBackend backend);
+
+    /**
+     * Parse a backend name (cpu-scalar, cpu-avx2, cpu-avx512, cuda, opencl, cpu-scrypt,
+     * cpu-scrypt-tmto)
+     * @param name Backend name
+     * @param backend Parsed backend
+     * @return true if the name is known
+     */
+    static bool parse_backend(const std::string& name, BenchmarkBackend& backend);
+
+private:
+    BenchmarkOptions options_;
+
+    bool is_available(BenchmarkBackend backend) const;
+    std::vector<size_t> batch_sizes_for(BenchmarkBackend backend) const;
+    size_t cpu_threads() const;
+    void run_cpu(BenchmarkBackend backend, uint32_t iterations, std::vector<BenchmarkResult>& results) const;
+    void run_cuda(uint32_t iterations, std::vector<BenchmarkResult>& results) const;
+    void run_opencl(uint32_t iterations, std::vector<BenchmarkResult>& results) const;
+    void run_scrypt(BenchmarkBackend backend, std::vector<BenchmarkResult>& results) const;
+};
+
+/**
+ * Parse the comma-separated lists of the benchmark command line
+ * @param iterations Iteration counts, e.g. "25000,100000", empty keeps the default
+ * @param batch_sizes Candidates per batch, empty keeps the backend defaults
+ * @param backends Backend names, empty runs every available backend
+ * @param options Options to update
+ * @param error Reason when parsing fails
+ * @return true if every list parsed
+ */
+bool parse_benchmark_lists(const std::string& iterations, const std::string& batch_sizes,
+                           const std::string& backends, BenchmarkOptions& options, std::string& error);
+
+/**
+ * Run the benchmark, log one line per case and write the JSON report
+ * @param options Benchmark options
+ * @param json_file Report path, empty for standard output
+ * @return process exit code: 0 if every case verified, 1 otherwise
+ */
+int run_benchmark_mode(const BenchmarkOptions& options, const std::string& json_file);
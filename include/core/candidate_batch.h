@@ -0,0 +1,212 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Contiguous, fixed-stride batch of password candidates
+ *
+ * Each slot is `stride` bytes: one length byte followed by the candidate
+ * bytes, zero padded. The whole batch is one flat buffer, so generators
+ * write candidates in place, CPU workers read them through pointers and
+ * GPU backends upload the buffer as-is.
+ */
+class CandidateBatch {
+public:
+    static constexpr size_t DEFAULT_STRIDE = 64;
+    static constexpr size_t MAX_STRIDE = 256;
+
+    /**
+     * Create a batch over caller-provided storage
+     * @param storage Buffer of at least capacity * stride bytes
+     * @param capacity Maximum number of candidates
+     * @param stride Slot size in bytes, including the length byte
+     * @throws std::invalid_argument if stride is below 2 or above MAX_STRIDE
+     */
+    CandidateBatch(uint8_t* storage, size_t capacity, size_t stride = DEFAULT_STRIDE);
+
+    /**
+     * Create a batch that owns its storage
+     * @param capacity Maximum number of candidates
+     * @param stride Slot size in bytes, including the length byte
+     * @throws std::invalid_argument if stride is below 2 or above MAX_STRIDE
+     */
+    explicit CandidateBatch(size_t capacity, size_t stride = DEFAULT_STRIDE);
+
+    CandidateBatch(const CandidateBatch&) = delete;
+    CandidateBatch& operator=(const CandidateBatch&) = delete;
+
+    /**
+     * Append a candidate
+     * @param data Candidate bytes
+     * @param length Candidate length
+     * @return false if the batch is full or the candidate exceeds max_length()
+     */
+    bool push(const char* data, size_t length);
+    bool push(const std::string& candidate) { return push(candidate.data(), candidate.size()); }
+
+    /**
+     * Append candidates from another batch
+     * Slots are block-copied when both batches share a stride.
+     * @param source Batch to copy from
+     * @param start Index of the first candidate to copy
+     * @param count Maximum number of candidates to copy
+     * @return number of candidates appended
+     */
+    size_t append(const CandidateBatch& source, size_t start, size_t count);
+
+    /**
+     * Reserve the next slot for in-place generation
+     * @return pointer to the zeroed candidate bytes of the new slot, nullptr
+     *         if full; the caller must follow up with set_length()
+     */
+    uint8_t* append_slot();
+
+    /**
+     * Reserve the next slot without zeroing it, for generators that write
+     * all max_length() candidate bytes, padding included
+     * @return pointer to the candidate bytes of the new slot, nullptr if
+     *         full; the caller must follow up with set_length()
+     */
+    uint8_t* append_raw_slot();
+
+    /**
+     * Set the length of a candidate written in place
+     * @param index Candidate index
+     * @param length Candidate length (at most max_length())
+     */
+    void set_length(size_t index, size_t length) { slot(index)[0] = static_cast<uint8_t>(length); }
+
+    /**
+     * Drop all candidates, keeping the storage
+     */
+    void clear() { size_ = 0; }
+
+    /**
+     * Shrink the batch to its first `count` candidates
+     */
+    void truncate(size_t count) { if (count < size_) size_ = count; }
+
+    // Candidate access
+    const uint8_t* data(size_t index) const { return slot(index) + 1; }
+    uint8_t* mutable_data(size_t index) { return slot(index) + 1; }
+    size_t length(size_t index) const { return slot(index)[0]; }
+    std::string to_string(size_t index) const;
+
+    /**
+     * Length of the longest candidate, for backends that specialise on it
+     */
+    size_t longest() const;
+
+    // Raw slot access for uploads
+    const uint8_t* slot(size_t index) const { return storage_ + index * stride_; }
+    uint8_t* slot(size_t index) { return storage_ + index * stride_; }
+    const uint8_t* buffer() const { return storage_; }
+    size_t buffer_size() const { return size_ * stride_; }
+
+    // Dimensions
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    size_t stride() const { return stride_; }
+    size_t max_length() const { return stride_ - 1; }
+    bool empty() const { return size_ == 0; }
+    bool full() const { return size_ == capacity_; }
+
+private:
+    std::vector<uint8_t> owned_storage_;
+    uint8_t* storage_;
+    size_t capacity_;
+    size_t stride_;
+    size_t size_;
+};
+
+/**
+ * Reusable pool of candidate batches
+ *
+ * Batches are allocated once and recycled when their handle goes out of
+ * scope, so steady-state generation performs no heap allocation. When a
+ * batch limit is set, acquire() blocks until a consumer returns a batch,
+ * which gives generators natural back-pressure.
+ */
+class CandidateArena {
+public:
+    using Allocator = std::function<uint8_t*(size_t)>;
+    using Deallocator = std::function<void(uint8_t*)>;
+
+    /**
+     * Returns batches to their arena instead of freeing them
+     */
+    class Recycler {
+    public:
+        explicit Recycler(CandidateArena* arena = nullptr) : arena_(arena) {}
+        void operator()(CandidateBatch* batch) const;
+    private:
+        CandidateArena* arena_;
+    };
+
+    using BatchPtr = std::unique_ptr<CandidateBatch, Recycler>;
+
+    /**
+     * Create an arena backed by ordinary heap memory
+     * @param batch_capacity Candidates per batch
+     * @param stride Slot size in bytes
+     * @param max_batches Maximum batches in flight (0 = unlimited)
+     * @throws std::invalid_argument if stride is below 2 or above MAX_STRIDE
+     */
+    CandidateArena(size_t batch_capacity, size_t stride = CandidateBatch::DEFAULT_STRIDE,
+                   size_t max_batches = 0);
+
+    /**
+     * Create an arena with custom storage (e.g. pinned host memory)
+     */
+    CandidateArena(size_t batch_capacity, size_t stride, size_t max_batches,
+                   Allocator allocator, Deallocator deallocator);
+
+    ~CandidateArena();
+
+    CandidateArena(const CandidateArena&) = delete;
+    CandidateArena& operator=(const CandidateArena&) = delete;
+
+    /**
+     * Take an empty batch from the pool, allocating one if none is free
+     * @return batch handle that recycles itself on destruction
+     */
+    BatchPtr acquire();
+
+    /**
+     * Take an empty batch without blocking
+     * @return batch handle, or an empty handle if the limit is reached
+     */
+    BatchPtr try_acquire();
+
+    size_t get_batch_capacity() const { return batch_capacity_; }
+    size_t get_stride() const { return stride_; }
+    size_t get_allocated_batches() const;
+    size_t get_free_batches() const;
+
+private:
+    struct Block {
+        uint8_t* storage;
+        std::unique_ptr<CandidateBatch> batch;
+    };
+
+    size_t batch_capacity_;
+    size_t stride_;
+    size_t max_batches_;
+    Allocator allocator_;
+    Deallocator deallocator_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+    std::vector<Block> blocks_;
+    std::vector<CandidateBatch*> free_list_;
+
+    CandidateBatch* allocate_batch();
+    void release(CandidateBatch* batch);
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "core/keyspace_scheduler.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Set of keyspace ranges that have been fully tested
+ *
+ * Workers add each chunk once its batch has been checked. Adjacent chunks
+ * merge on insert, so with work stealing the set holds on the order of one
+ * range per worker and steal, however many chunks were processed.
+ */
+class CompletedRanges {
+public:
+    CompletedRanges() = default;
+
+    /**
+     * Record a tested range; safe to call from any worker
+     */
+    void add(const KeyspaceRange& range);
+
+    /**
+     * Replace the contents, e.g. with the ranges of a loaded checkpoint
+     */
+    void assign(const std::vector<KeyspaceRange>& ranges);
+
+    /**
+     * Completed ranges, sorted and merged
+     */
+    std::vector<KeyspaceRange> ranges() const;
+
+    /**
+     * Parts of a keyspace not yet completed, sorted
+     */
+    std::vector<KeyspaceRange> remaining(const KeyspaceRange& keyspace) const;
+
+    /**
+     * Number of completed indices
+     */
+    KeyspaceIndex count() const;
+
+private:
+    mutable std::mutex lock_;
+    std::map<KeyspaceIndex, KeyspaceIndex> ranges_;   // begin -> end
+};
+
+/**
+ * Resume point of one dictionary range: the next word's byte offset and
+ * the next rule to apply to it (see RuleExpander)
+ */
+struct DictionaryPosition {
+    uint64_t offset;
+    uint64_t end;
+    uint32_t rule;
+};
+
+/**
+ * Settings that define a brute-force keyspace and its order
+ *
+ * The cluster coordinator and every worker fingerprint their search from
+ * this, so all of them must fill it from the same resolved configuration.
+ */
+struct BruteForceSearch {
+    std::string charset = "mixed";
+    std::string custom_charset;     // Characters when charset is "custom"
+    int min_length = 1;
+    int max_length = 12;
+    std::string prefix;
+    std::string suffix;
+    std::string markov_file;        // Empty for index order
+
+    /**
+     * Canonical text of the settings
+     * @param markov_digest MarkovModel::digest() of markov_file, if any
+     */
+    std::string parameters(const std::string& markov_digest = "") const;
+};
+
+/**
+ * Everything needed to continue a search after a restart
+ */
+struct CheckpointState {
+    std::string fingerprint;                  // Checkpoint::fingerprint of wallet and search settings
+    KeyspaceRange keyspace{0, 0};
+    std::vector<KeyspaceRange> completed;     // Brute-force progress
+    std::vector<DictionaryPosition> dictionary;  // Dictionary progress, one per range
+    uint64_t candidates_tested = 0;
+    double elapsed_seconds = 0.0;
+    double candidates_per_second = 0.0;
+};
+
+/**
+ * Periodic, crash-safe checkpoint file
+ *
+ * The state is written as a small text file next to a temporary copy,
+ * flushed to disk and renamed over the previous checkpoint, so the file on
+ * disk is always either the old or the new checkpoint in full. A write
+ * costs one small file regardless of how many candidates were tested.
+ */
+class Checkpoint {
+public:
+    /**
+     * @param file_path Checkpoint file
+     * @param interval_seconds Minimum time between periodic saves (e.g. progress_interval)
+     */
+    explicit Checkpoint(const std::string& file_path, double interval_seconds = 10.0);
+
+    /**
+     * Identify a wallet and search so a checkpoint is never applied to another
+     * @param wallet_file Wallet path; the file contents are hashed
+     * @param search_parameters Settings that define the candidate space
+     *        (mode, charset, lengths, prefix/suffix, dictionary, rules)
+     * @return hex digest, empty if the wallet cannot be read
+     */
+    static std::string fingerprint(const std::string& wallet_file, const std::string& search_parameters);
+
+    /**
+     * Fingerprint of a brute-force search; trains the Markov model, if
+     * any, since its counts rather than its file name define the order
+     * @param wallet_file Wallet path
+     * @param search Keyspace settings
+     * @param error Reason on failure
+     * @return hex digest, empty if the wallet or Markov file cannot be read
+     */
+    static std::string fingerprint(const std::string& wallet_file, const BruteForceSearch& search,
+                                   std::string& error);
+
+    /**
+     * Check whether the save interval has elapsed since the last write
+     */
+    bool due() const;
+
+    /**
+     * Write the checkpoint atomically and restart the interval
+     * @param state State to persist
+     * @return true if successful
+     */
+    bool save(const CheckpointState& state);
+
+    /**
+     * Read the checkpoint
+     * @param state Output
+     * @return false if the file is missing or malformed
+     */
+    bool load(CheckpointState& state);
+
+    /**
+     * Delete the checkpoint once the search has finished
+     */
+    void remove();
+
+    const std::string& get_file_path() const { return file_path_; }
+    const std::string& get_last_error() const { return last_error_; }
+
+private:
+    std::string file_path_;
+    std::chrono::steady_clock::duration interval_;
+    std::chrono::steady_clock::time_point last_save_;
+    std::string last_error_;
+};
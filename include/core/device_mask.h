@@ -0,0 +1,73 @@
+#pragma once
+
+#include "utils/host_device.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Mask candidates generated where they are tested
+ *
+ * MaskGenerator::device_segment() describes a run of consecutive
+ * candidates of one mask: per position, where its charset starts in the
+ * flattened table from MaskGenerator::device_charsets(), its size, and
+ * the digit of the run's first candidate. Candidate i of the run is that
+ * start advanced by i, last position fastest, exactly as fill() numbers
+ * them. The segment is plain data and small enough to pass as a kernel
+ * argument, so a device only ever receives charsets and start digits,
+ * never candidate bytes.
+ */
+#define DEVICE_MASK_MAX_LENGTH 32
+#define DEVICE_MASK_MAX_CHARS 4096
+
+struct DeviceMaskSegment {
+    uint32_t length;
+    uint32_t count;                                   // Candidates in the run
+    uint16_t charset_offset[DEVICE_MASK_MAX_LENGTH];  // Into the flattened charsets
+    uint16_t radix[DEVICE_MASK_MAX_LENGTH];
+    uint16_t start[DEVICE_MASK_MAX_LENGTH];           // Digits of candidate 0
+};
+
+/**
+ * Digits of candidate i of a segment
+ * @param segment Segment description
+ * @param index Candidate in [0, segment.count)
+ * @param digits Output, segment.length digits
+ */
+BTC_HOST_DEVICE inline void device_mask_digits(const DeviceMaskSegment& segment, uint32_t index, uint16_t* digits) {
+    uint32_t carry = index;
+    for (int p = static_cast<int>(segment.length) - 1; p >= 0; p--) {
+        // A mask radix is at most 256, so digit + carry cannot wrap
+        const uint32_t digit = segment.start[p] + carry % segment.radix[p];
+        carry = carry / segment.radix[p] + (digit >= segment.radix[p] ? 1 : 0);
+        digits[p] = static_cast<uint16_t>(digit >= segment.radix[p] ? digit - segment.radix[p] : digit);
+    }
+}
+
+/**
+ * Write the characters for a set of digits
+ * @param segment Segment description
+ * @param charsets Flattened charsets
+ * @param digits Digits, segment.length of them
+ * @param candidate Output, segment.length bytes
+ */
+BTC_HOST_DEVICE inline void device_mask_write(const DeviceMaskSegment& segment, const uint8_t* charsets,
+                                              const uint16_t* digits, uint8_t* candidate) {
+    for (uint32_t p = 0; p < segment.length; p++) {
+        candidate[p] = charsets[segment.charset_offset[p] + digits[p]];
+    }
+}
+
+/**
+ * Advance digits to the next candidate of the segment
+ * @return the leftmost position that changed
+ */
+BTC_HOST_DEVICE inline int device_mask_increment(const DeviceMaskSegment& segment, uint16_t* digits) {
+    int p = static_cast<int>(segment.length) - 1;
+    while (p > 0 && ++digits[p] == segment.radix[p]) {
+        digits[p--] = 0;
+    }
+    if (p == 0) {
+        digits[0]++;
+    }
+    return p;
+}
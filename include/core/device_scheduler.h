@@ -0,0 +1,202 @@
+#pragma once
+
+#include "core/keyspace_scheduler.h"
+#include "utils/metrics.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Kinds of device that can search a share of the keyspace
+ */
+enum class ComputeDeviceKind {
+    CPU,             // One CPU worker thread
+    CUDA,            // Discrete NVIDIA GPU
+    CUDA_INTEGRATED, // Tegra, MX and other shared-memory NVIDIA GPUs
+    OPENCL           // Integrated GPU driven through OpenCL
+};
+
+/**
+ * One device fed by a DeviceScheduler
+ */
+struct ComputeDevice {
+    ComputeDeviceKind kind = ComputeDeviceKind::CPU;
+    std::string name;
+    int device_id = 0;          // CUDA ordinal, OpenCL device index or CPU worker number
+    uint64_t min_chunk = 1;     // Smallest useful chunk, e.g. one kernel launch
+    uint64_t max_chunk = 0;     // Largest chunk the device buffers hold; 0 = unlimited
+};
+
+/**
+ * Name of a device kind for logs
+ */
+const char* compute_device_kind_name(ComputeDeviceKind kind);
+
+/**
+ * Metric labels of a device: backend ("cpu", "cuda" or "opencl") and device id
+ */
+MetricLabels compute_device_labels(ComputeDeviceKind kind, int device_id);
+
+/**
+ * Enumerate the devices a run can use
+ *
+ * Every CUDA device (discrete or integrated) and, when OpenCL is enabled,
+ * every integrated GPU found by IntegratedGPUManager becomes one device.
+ * Both come from the cached device inventory, so no GPU context is created.
+ * Each GPU is driven by a host thread, so the CPU gets the remaining
+ * threads as CPU devices, at least one.
+ * @param cpu_threads Total CPU threads to use
+ * @param use_gpu Include GPUs
+ * @param batch_size Smallest chunk handed to a GPU
+ * @param cuda_device Only this CUDA device (-1 = all of them)
+ * @return Devices, GPUs first
+ */
+std::vector<ComputeDevice> detect_compute_devices(size_t cpu_threads, bool use_gpu, uint64_t batch_size,
+                                                  int cuda_device = -1);
+
+/**
+ * Throughput over a sliding window of recent work
+ *
+ * Samples older than window_seconds of busy time are dropped, so the rate
+ * follows a device that throttles or speeds up instead of averaging over
+ * the whole run. The newest sample is always kept, however long it took.
+ */
+class ThroughputWindow {
+public:
+    explicit ThroughputWindow(double window_seconds = 5.0);
+
+    /**
+     * Record a finished chunk
+     * @param count Candidates tested
+     * @param seconds Time the device spent on them
+     */
+    void add(uint64_t count, double seconds);
+
+    /**
+     * Candidates per second over the window, 0 before the first sample
+     */
+    double rate() const { return seconds_ > 0.0 ? count_ / seconds_ : 0.0; }
+
+    size_t sample_count() const { return samples_.size(); }
+
+private:
+    struct Sample {
+        uint64_t count;
+        double seconds;
+    };
+
+    double window_seconds_;
+    std::deque<Sample> samples_;
+    double count_;
+    double seconds_;
+};
+
+/**
+ * Feeds CPU workers and GPUs from one keyspace
+ *
+ * Each device pulls chunks from a shared KeyspaceScheduler, so a device
+ * that runs dry steals from the others and none sits idle while work is
+ * left. Chunk sizes follow each device's throughput over a sliding window:
+ * a chunk is about target_seconds of that device's work, and never more
+ * than its throughput-weighted share of what is left, so all devices
+ * finish at about the same time. A device with no measurement yet gets its
+ * min_chunk.
+ *
+ * Reported chunks also feed the per-device counters and latency histogram
+ * of the global MetricsRegistry, and keyspace progress is exported while
+ * the scheduler lives.
+ */
+class DeviceScheduler {
+public:
+    /**
+     * @param devices Devices to feed, one worker each
+     * @param ranges Sorted, non-overlapping ranges to search
+     * @param target_seconds Work per chunk once a device is measured
+     * @param window_seconds Length of each device's throughput window
+     */
+    DeviceScheduler(const std::vector<ComputeDevice>& devices, const std::vector<KeyspaceRange>& ranges,
+                    double target_seconds = 0.5, double window_seconds = 5.0);
+
+    ~DeviceScheduler();
+
+    DeviceScheduler(const DeviceScheduler&) = delete;
+    DeviceScheduler& operator=(const DeviceScheduler&) = delete;
+
+    /**
+     * Claim the next chunk for a device, sized from its measured throughput
+     * @param device Device index
+     * @param chunk Output range
+     * @return false when the keyspace is exhausted or the scheduler was stopped
+     */
+    bool next_chunk(size_t device, KeyspaceRange& chunk);
+
+    /**
+     * Record a finished chunk; only the device's own thread may call this
+     * @param device Device index
+     * @param count Candidates tested
+     * @param seconds Time spent
+     */
+    void report(size_t device, uint64_t count, double seconds);
+
+    /**
+     * Run every device on its own thread until the keyspace is exhausted;
+     * each chunk is timed and reported
+     * @param process Called per chunk; return false to stop all devices
+     */
+    void run(const std::function<bool(size_t device, const KeyspaceRange& chunk)>& process);
+
+    void stop() { keyspace_.stop(); }
+    bool stopped() const { return keyspace_.stopped(); }
+
+    /**
+     * Chunk size the device would be given now
+     */
+    uint64_t chunk_size(size_t device) const;
+
+    /**
+     * Measured candidates per second of one device, 0 if not measured yet
+     */
+    double rate(size_t device) const { return devices_[device].rate.load(std::memory_order_relaxed); }
+
+    /**
+     * Sum of all measured rates
+     */
+    double total_rate() const;
+
+    /**
+     * Each device's fraction of the measured throughput
+     */
+    std::vector<double> shares() const;
+
+    /**
+     * One line per device with its rate and share, for progress logs
+     */
+    std::string summary() const;
+
+    size_t device_count() const { return device_count_; }
+    const ComputeDevice& device(size_t index) const { return devices_[index].device; }
+    const KeyspaceScheduler& keyspace() const { return keyspace_; }
+
+private:
+    struct alignas(KeyspaceScheduler::CACHE_LINE_SIZE) DeviceState {
+        ComputeDevice device;
+        ThroughputWindow window;              // Owned by the device's thread
+        std::atomic<double> rate{0.0};        // Published from window for the other devices
+        MetricCounter* tested = nullptr;
+        MetricGauge* measured_rate = nullptr;
+        LatencyHistogram* chunk_seconds = nullptr;
+    };
+
+    size_t device_count_;
+    double target_seconds_;
+    std::unique_ptr<DeviceState[]> devices_;
+    KeyspaceScheduler keyspace_;
+    KeyspaceIndex total_;
+
+    void register_metrics();
+};
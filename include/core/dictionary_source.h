@@ -0,0 +1,113 @@
+#pragma once
+
+#include "core/candidate_batch.h"
+#include "utils/mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Byte range of a wordlist, always starting at the beginning of a line
+ */
+struct DictionaryRange {
+    uint64_t begin;
+    uint64_t end;
+};
+
+class DictionarySource;
+
+/**
+ * Sequential reader over one range of a dictionary
+ *
+ * Words are returned as views into the mapping, so no line is copied or
+ * allocated. offset() is the start of the first unread line and can be
+ * stored to resume the range after a restart. Pages behind the cursor are
+ * handed back to the kernel as it advances, keeping resident memory bounded
+ * regardless of wordlist size.
+ */
+class DictionaryCursor {
+public:
+    DictionaryCursor(const DictionarySource& source, const DictionaryRange& range);
+
+    /**
+     * Next non-empty line, without its line ending
+     * @param word Output view, valid while the source stays open
+     * @return false at the end of the range
+     */
+    bool next(std::string_view& word);
+
+    /**
+     * Append words to a batch until it is full or the range ends
+     * Words that do not fit the batch stride are skipped and counted.
+     * @param batch Destination
+     * @return number of words appended
+     */
+    size_t fill(CandidateBatch& batch);
+
+    uint64_t offset() const { return position_; }
+    uint64_t end() const { return end_; }
+    bool done() const { return position_ >= end_; }
+    uint64_t skipped() const { return skipped_; }
+
+private:
+    const DictionarySource& source_;
+    uint64_t position_;
+    uint64_t end_;
+    uint64_t released_;     // Everything below this offset has been released
+    uint64_t skipped_;
+
+    // Release everything below bound, the start of the line being returned
+    void release_behind(uint64_t bound);
+};
+
+/**
+ * Memory-mapped wordlist that opens in constant time and splits into
+ * newline-aligned ranges for parallel workers
+ */
+class DictionarySource {
+public:
+    // Cursors release and prefetch in windows of this size
+    static constexpr uint64_t WINDOW_SIZE = 64ull << 20;
+
+    DictionarySource() = default;
+
+    /**
+     * Map a wordlist
+     * @param file_path Path to the dictionary
+     * @return true if successful
+     */
+    bool open(const std::string& file_path);
+
+    /**
+     * Split the remaining file into newline-aligned ranges
+     * @param parts Number of ranges wanted
+     * @param start_offset Byte offset to start from (e.g. a resumed cursor)
+     * @return up to `parts` non-empty ranges covering [start_offset, size)
+     */
+    std::vector<DictionaryRange> split(size_t parts, uint64_t start_offset = 0) const;
+
+    /**
+     * Cursor over a range
+     */
+    DictionaryCursor cursor(const DictionaryRange& range) const { return DictionaryCursor(*this, range); }
+
+    /**
+     * Cursor over the whole file
+     */
+    DictionaryCursor cursor() const { return cursor({0, size()}); }
+
+    const char* data() const { return reinterpret_cast<const char*>(file_.data()); }
+    uint64_t size() const { return file_.size(); }
+    bool is_open() const { return file_.is_open(); }
+    const std::string& get_last_error() const { return last_error_; }
+
+private:
+    friend class DictionaryCursor;
+
+    MappedFile file_;
+    std::string last_error_;
+
+    uint64_t align_to_line(uint64_t offset) const;
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Position in a candidate keyspace; mask spaces overflow 64 bits quickly
+ */
+typedef unsigned __int128 KeyspaceIndex;
+
+/**
+ * Half-open index range [begin, end)
+ */
+struct KeyspaceRange {
+    KeyspaceIndex begin;
+    KeyspaceIndex end;
+
+    KeyspaceIndex size() const { return end > begin ? end - begin : 0; }
+    bool empty() const { return end <= begin; }
+};
+
+/**
+ * Decimal representation of a keyspace index for logs and checkpoints
+ */
+std::string keyspace_index_to_string(KeyspaceIndex value);
+
+/**
+ * Parse a decimal keyspace index
+ * @param text Decimal digits only
+ * @param value Output
+ * @return false if the text is empty, not decimal or exceeds 128 bits
+ */
+bool keyspace_index_from_string(const std::string& text, KeyspaceIndex& value);
+
+/**
+ * Work-stealing scheduler over a contiguous keyspace
+ *
+ * The keyspace is split evenly between workers up front. Each worker takes
+ * chunks from the front of its own range; when the range is exhausted it
+ * steals the back half of the largest range left. The hot path touches only
+ * the worker's own cache line, and progress is summed from per-worker
+ * counters on demand rather than through a shared lock.
+ *
+ * A resumed search schedules only the gaps a checkpoint left open; each
+ * worker then holds a queue of ranges and works through them in order.
+ */
+class KeyspaceScheduler {
+public:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    /**
+     * @param keyspace Range to schedule
+     * @param worker_count Number of workers
+     * @param min_steal Ranges at or below this size are taken whole instead of split
+     */
+    KeyspaceScheduler(const KeyspaceRange& keyspace, size_t worker_count, uint64_t min_steal = 1024);
+
+    /**
+     * Schedule several disjoint ranges, e.g. the remainder of a checkpoint
+     * @param ranges Sorted, non-overlapping ranges
+     * @param worker_count Number of workers
+     * @param min_steal Ranges at or below this size are taken whole instead of split
+     */
+    KeyspaceScheduler(const std::vector<KeyspaceRange>& ranges, size_t worker_count, uint64_t min_steal = 1024);
+
+    KeyspaceScheduler(const KeyspaceScheduler&) = delete;
+    KeyspaceScheduler& operator=(const KeyspaceScheduler&) = delete;
+
+    /**
+     * Claim the next chunk for a worker, stealing if its own range is empty
+     * @param worker Worker index
+     * @param max_count Largest chunk to claim (usually the batch size)
+     * @param chunk Output range
+     * @return false when the keyspace is exhausted or the scheduler was stopped
+     */
+    bool next_chunk(size_t worker, uint64_t max_count, KeyspaceRange& chunk);
+
+    /**
+     * Record candidates a worker has finished testing
+     */
+    void report(size_t worker, uint64_t count) {
+        workers_[worker].completed.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    /**
+     * Stop handing out work, e.g. once the password is found
+     */
+    void stop() { stopped_.store(true, std::memory_order_release); }
+    bool stopped() const { return stopped_.load(std::memory_order_acquire); }
+
+    /**
+     * Run workers on their own threads until the keyspace is exhausted
+     * @param max_count Chunk size passed to next_chunk
+     * @param process Called per chunk; return false to stop all workers
+     */
+    void run(uint64_t max_count, const std::function<bool(size_t worker, const KeyspaceRange& chunk)>& process);
+
+    /**
+     * Candidates reported as tested so far
+     */
+    KeyspaceIndex completed() const;
+
+    /**
+     * Candidates not yet handed out, summed from the advisory per-worker
+     * hints without locking; for sizing decisions, not exact accounting
+     */
+    KeyspaceIndex remaining() const;
+
+    /**
+     * Ranges not yet handed out, sorted; chunks in progress are not included
+     */
+    std::vector<KeyspaceRange> unclaimed_ranges() const;
+
+    size_t worker_count() const { return worker_count_; }
+    uint64_t steal_count() const { return steals_.load(std::memory_order_relaxed); }
+    const KeyspaceRange& keyspace() const { return keyspace_; }
+
+private:
+    // One cache line per worker so a worker's own updates never contend
+    struct alignas(CACHE_LINE_SIZE) WorkerState {
+        mutable std::mutex lock;                  // Taken by the owner and, rarely, a thief
+        KeyspaceIndex next = 0;
+        KeyspaceIndex end = 0;
+        std::vector<KeyspaceRange> queued;        // Further ranges, taken from the back
+        std::atomic<uint64_t> remaining_hint{0};  // Saturated count of unclaimed indices for victim selection
+        std::atomic<uint64_t> completed{0};
+    };
+
+    KeyspaceRange keyspace_;
+    size_t worker_count_;
+    uint64_t min_steal_;
+    std::unique_ptr<WorkerState[]> workers_;
+    std::atomic<bool> stopped_;
+    std::atomic<uint64_t> steals_;
+
+    void assign(const std::vector<KeyspaceRange>& ranges);
+    bool steal(size_t thief);
+    static void update_hint(WorkerState& state);
+};
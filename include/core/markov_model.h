@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Per-position character Markov chains trained on a password corpus
+ *
+ * For every position the model counts which character follows which, so
+ * it can rank the candidates of one position given the character before
+ * it. Ranks are coarse levels: a character sits one level lower for every
+ * halving of its count relative to the most frequent one, as in OMEN.
+ * MaskGenerator::set_markov_model() sums these levels over a candidate to
+ * enumerate a keyspace most probable first.
+ *
+ * Positions from POSITIONS - 1 on share one set of counts, and a context
+ * never seen in training falls back to the counts of its position alone.
+ */
+class MarkovModel {
+public:
+    static constexpr size_t POSITIONS = 32;
+    static constexpr uint8_t MAX_LEVEL = 9;
+
+    // Previous-character context of the first position
+    static constexpr int START = 256;
+
+    MarkovModel();
+
+    /**
+     * Count one word
+     * @param word Training word, e.g. a leaked password or a known fragment
+     * @param weight How many times to count it
+     */
+    void train(std::string_view word, uint32_t weight = 1);
+
+    /**
+     * Count every line of a word list
+     * @param file_path Word list, one word per line
+     * @param weight How many times to count each line
+     * @return false if the file cannot be read
+     */
+    bool train_file(const std::string& file_path, uint32_t weight = 1);
+
+    /**
+     * Levels of the characters of one position, 0 = most probable
+     * @param position Position in the candidate
+     * @param previous Character before it, START at position 0
+     * @param chars Characters the position can take
+     * @param levels Output, one level per character of chars
+     */
+    void levels(size_t position, int previous, const std::string& chars, uint8_t* levels) const;
+
+    /**
+     * Hex digest of the counts, so checkpoints and cluster nodes can tell
+     * orderings apart
+     */
+    std::string digest() const;
+
+    uint64_t get_word_count() const { return words_; }
+    const std::string& get_last_error() const { return last_error_; }
+
+private:
+    static constexpr size_t CONTEXTS = 257;
+
+    std::vector<uint32_t> transitions_;   // [position][previous][next]
+    std::vector<uint32_t> positional_;    // [position][next], the fallback
+    uint64_t words_;
+    std::string last_error_;
+};
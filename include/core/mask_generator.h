@@ -0,0 +1,198 @@
+#pragma once
+
+#include "core/candidate_batch.h"
+#include "core/device_mask.h"
+#include "core/keyspace_scheduler.h"
+#include "core/markov_model.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Indexable mask keyspace
+ *
+ * A mask is a sequence of positions, each drawing from a charset:
+ *   ?l  a-z          ?u  A-Z          ?d  0-9
+ *   ?s  printable symbols and space   ?a  ?l?u?d?s
+ *   ?h  0-9a-f       ?H  0-9A-F       ?1..?4  custom charsets
+ *   ??  a literal '?'; any other character is a literal position
+ * Several masks (e.g. one per length) form one keyspace laid end to end.
+ *
+ * Every candidate has a 128-bit index. candidate_at() and index_of() convert
+ * between the two in time linear in the mask length, independent of the
+ * keyspace size, so ranges can be split, resumed or distributed cheaply.
+ * fill() walks consecutive indices odometer-style, touching only the
+ * positions that change from one candidate to the next.
+ *
+ * With a MarkovModel set, the same candidates are numbered most probable
+ * first instead: by the sum of their per-position levels, then by mask.
+ * Index conversion stays linear in the mask length (times the charset
+ * size), so checkpoints, work stealing and cluster leases are unchanged.
+ */
+class MaskGenerator {
+public:
+    static constexpr int CUSTOM_CHARSET_COUNT = 4;
+
+    MaskGenerator() = default;
+
+    /**
+     * Define custom charset ?1..?4; may itself use the built-in ?x classes
+     * @param slot Charset number, 1 to CUSTOM_CHARSET_COUNT
+     * @param definition Characters or ?x classes
+     * @return false if the slot or definition is invalid
+     */
+    bool set_custom_charset(int slot, const std::string& definition);
+
+    /**
+     * Append a mask to the keyspace
+     * @param mask Mask string
+     * @return false on syntax error or if the keyspace would exceed 128 bits
+     */
+    bool add_mask(const std::string& mask);
+
+    /**
+     * Append the brute-force space described by the recovery configuration
+     * (charset name, length range, fixed prefix and suffix)
+     * @param charset lowercase, uppercase, digits, symbols, mixed or custom
+     * @param custom_charset Characters used when charset is "custom"
+     * @param min_length Shortest total length, including prefix and suffix
+     * @param max_length Longest total length, including prefix and suffix
+     * @param prefix Fixed leading text
+     * @param suffix Fixed trailing text
+     * @return false if the charset is unknown or the range is invalid
+     */
+    bool add_charset_range(const std::string& charset, const std::string& custom_charset,
+                           size_t min_length, size_t max_length,
+                           const std::string& prefix = "", const std::string& suffix = "");
+
+    /**
+     * Number the keyspace most probable first under a Markov model
+     *
+     * Applies to masks added before and after the call. Every (mask, level
+     * sum) pair is one block of the keyspace, counted by dynamic
+     * programming over the mask positions; inside a block, each position
+     * takes its characters in level order.
+     * @param model Trained model, nullptr to restore mask order
+     */
+    void set_markov_model(std::shared_ptr<const MarkovModel> model);
+
+    bool is_markov_ordered() const { return markov_ != nullptr; }
+
+    /**
+     * Total number of candidates
+     */
+    KeyspaceIndex size() const { return total_size_; }
+
+    /**
+     * Longest candidate in the keyspace
+     */
+    size_t max_length() const { return max_length_; }
+
+    /**
+     * Candidate for an index
+     * @param index Position in [0, size())
+     * @param candidate Output
+     * @return false if the index is out of range
+     */
+    bool candidate_at(KeyspaceIndex index, std::string& candidate) const;
+
+    /**
+     * Index of a candidate (first matching mask)
+     * @param candidate Candidate text
+     * @param index Output
+     * @return false if the candidate is not in the keyspace
+     */
+    bool index_of(const std::string& candidate, KeyspaceIndex& index) const;
+
+    /**
+     * Append consecutive candidates to a batch
+     * @param start Index of the first candidate
+     * @param count Maximum number of candidates
+     * @param batch Destination; filling stops when it is full
+     * @return number of candidates appended
+     */
+    size_t fill(KeyspaceIndex start, uint64_t count, CandidateBatch& batch) const;
+
+    /**
+     * Every charset flattened into one table for device_segment(), each
+     * charset's characters in turn
+     * @param chars Output table
+     * @return false if the charsets exceed DEVICE_MASK_MAX_CHARS
+     */
+    bool device_charsets(std::vector<uint8_t>& chars) const;
+
+    /**
+     * Describe consecutive candidates for generation on a device
+     *
+     * The segment stops at the end of the mask holding start, so a range
+     * spanning several masks takes one segment per mask.
+     * @param start Index of the first candidate
+     * @param count Most candidates to cover; at most UINT32_MAX are
+     * @param segment Output
+     * @return false if the keyspace is Markov-ordered, start is out of
+     *         range or its mask is longer than DEVICE_MASK_MAX_LENGTH
+     */
+    bool device_segment(KeyspaceIndex start, uint64_t count, DeviceMaskSegment& segment) const;
+
+    const std::string& get_last_error() const { return last_error_; }
+
+private:
+    struct Charset {
+        std::string chars;
+        int16_t position[256];    // Index of each byte in chars, -1 if absent
+    };
+
+    struct Mask {
+        std::vector<uint16_t> charsets;   // Charset id per position
+        KeyspaceIndex size;
+        KeyspaceIndex offset;             // Index of this mask's first candidate
+    };
+
+    // One mask position under a Markov model. The state is the digit of
+    // the previous position (always 0 at position 0)
+    struct MarkovPosition {
+        size_t states;
+        size_t radix;
+        std::vector<uint16_t> order;   // states x radix digits, most probable first
+        std::vector<uint8_t> levels;   // Level of each entry of order
+    };
+
+    struct MarkovMask {
+        std::vector<MarkovPosition> positions;
+        uint32_t max_level;            // Largest level sum
+        // Per position p (0..length): states(p) x (max_level + 1) counts of
+        // ways to fill positions p.. with an exact level sum
+        std::vector<std::vector<KeyspaceIndex>> completions;
+    };
+
+    struct MarkovBlock {
+        uint32_t mask;
+        uint32_t level;                // Level sum of every candidate in the block
+        KeyspaceIndex size;
+        KeyspaceIndex offset;
+    };
+
+    std::vector<Charset> charsets_;
+    std::vector<Mask> masks_;
+    std::shared_ptr<const MarkovModel> markov_;
+    std::vector<MarkovMask> markov_masks_;
+    std::vector<MarkovBlock> markov_blocks_;   // In enumeration order
+    std::string custom_[CUSTOM_CHARSET_COUNT];
+    KeyspaceIndex total_size_ = 0;
+    size_t max_length_ = 0;
+    mutable std::string last_error_;
+
+    bool expand_class(char symbol, std::string& chars) const;
+    bool expand_definition(const std::string& definition, bool allow_custom, std::string& chars) const;
+    uint16_t intern_charset(const std::string& chars);
+    bool push_mask(std::vector<uint16_t> positions);
+    size_t find_mask(KeyspaceIndex index) const;
+    MarkovMask build_markov_mask(const Mask& mask) const;
+    void build_markov_blocks();
+    size_t find_markov_block(KeyspaceIndex index) const;
+    size_t fill_markov(KeyspaceIndex start, uint64_t count, CandidateBatch& batch) const;
+    void markov_candidate(const MarkovBlock& block, KeyspaceIndex local, uint8_t* out) const;
+    bool markov_index_of(size_t mask_index, const std::string& candidate, KeyspaceIndex& index) const;
+};
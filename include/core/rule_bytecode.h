@@ -0,0 +1,121 @@
+#pragma once
+
+#include "utils/host_device.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Compiled password-rule programs shared by the host and CUDA kernels
+ *
+ * A rule is a sequence of opcodes terminated by RULE_OP_END. Programs are
+ * produced and validated by RuleEngine, then stored back to back in one
+ * flat buffer with an offset per rule, so the same bytes can be walked on
+ * the CPU or copied into device constant memory unchanged.
+ *
+ * Encoding (one byte per field):
+ *   RULE_OP_APPEND n c1..cn     append n bytes
+ *   RULE_OP_PREPEND n c1..cn    prepend n bytes
+ *   RULE_OP_SUBSTITUTE x y      replace every x with y
+ *   any other opcode            no operands
+ */
+#define RULE_MAX_PROGRAM_LENGTH 255
+#define RULE_MAX_RULES 4096
+#define RULE_MAX_BYTECODE 32768
+
+enum RuleOpcode : uint8_t {
+    RULE_OP_END = 0,
+    RULE_OP_NOOP,
+    RULE_OP_LOWER,
+    RULE_OP_UPPER,
+    RULE_OP_CAPITALIZE,
+    RULE_OP_TOGGLE_CASE,
+    RULE_OP_REVERSE,
+    RULE_OP_DUPLICATE,
+    RULE_OP_APPEND,
+    RULE_OP_PREPEND,
+    RULE_OP_SUBSTITUTE
+};
+
+BTC_HOST_DEVICE inline uint8_t rule_to_lower(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<uint8_t>(c + 32) : c;
+}
+
+BTC_HOST_DEVICE inline uint8_t rule_to_upper(uint8_t c) {
+    return (c >= 'a' && c <= 'z') ? static_cast<uint8_t>(c - 32) : c;
+}
+
+/**
+ * Run a rule program over a word in place
+ * @param program Validated bytecode ending in RULE_OP_END
+ * @param word Buffer holding the base word, at least max_length bytes
+ * @param length Length of the base word
+ * @param max_length Largest result the buffer can hold
+ * @return length of the transformed word, or -1 if it would exceed max_length
+ */
+BTC_HOST_DEVICE inline int rule_apply(const uint8_t* program, uint8_t* word, int length, int max_length) {
+    for (;;) {
+        switch (*program++) {
+            case RULE_OP_END:
+                return length;
+            case RULE_OP_NOOP:
+                break;
+            case RULE_OP_LOWER:
+                for (int i = 0; i < length; i++) word[i] = rule_to_lower(word[i]);
+                break;
+            case RULE_OP_UPPER:
+                for (int i = 0; i < length; i++) word[i] = rule_to_upper(word[i]);
+                break;
+            case RULE_OP_CAPITALIZE:
+                if (length > 0) word[0] = rule_to_upper(word[0]);
+                for (int i = 1; i < length; i++) word[i] = rule_to_lower(word[i]);
+                break;
+            case RULE_OP_TOGGLE_CASE:
+                for (int i = 0; i < length; i++) {
+                    const uint8_t lower = rule_to_lower(word[i]);
+                    word[i] = lower != word[i] ? lower : rule_to_upper(word[i]);
+                }
+                break;
+            case RULE_OP_REVERSE:
+                for (int i = 0, j = length - 1; i < j; i++, j--) {
+                    const uint8_t c = word[i];
+                    word[i] = word[j];
+                    word[j] = c;
+                }
+                break;
+            case RULE_OP_DUPLICATE:
+                if (length * 2 > max_length) return -1;
+                for (int i = 0; i < length; i++) word[length + i] = word[i];
+                length *= 2;
+                break;
+            case RULE_OP_APPEND: {
+                const int count = *program++;
+                if (length + count > max_length) return -1;
+                for (int i = 0; i < count; i++) word[length + i] = program[i];
+                length += count;
+                program += count;
+                break;
+            }
+            case RULE_OP_PREPEND: {
+                const int count = *program++;
+                if (length + count > max_length) return -1;
+                for (int i = length; i-- > 0;) word[i + count] = word[i];
+                for (int i = 0; i < count; i++) word[i] = program[i];
+                length += count;
+                program += count;
+                break;
+            }
+            case RULE_OP_SUBSTITUTE: {
+                const uint8_t from = program[0];
+                const uint8_t to = program[1];
+                for (int i = 0; i < length; i++) {
+                    if (word[i] == from) word[i] = to;
+                }
+                program += 2;
+                break;
+            }
+            default:
+                // RuleEngine never emits unknown opcodes
+                return -1;
+        }
+    }
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "core/candidate_batch.h"
+#include "core/dictionary_source.h"
+#include "core/rule_bytecode.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Password rules compiled to bytecode
+ *
+ * Two line formats are accepted; '#' starts a comment line:
+ *   name:$word:t1,t2,...   one rule per comma-separated transformation
+ *   t                      a single rule
+ * A transformation is one or more space-separated operations applied in
+ * order:
+ *   :        keep the word      l  lowercase       u  uppercase
+ *   c        capitalize         t  toggle case     r  reverse
+ *   d        duplicate          sXY  replace X with Y
+ *   $text    append text        text$  prepend text
+ * A three-character operation starting with s is always a substitution,
+ * so a two-character prefix starting with s is written "a$ s$".
+ *
+ * Rules are parsed once; applying one is a single pass over its bytecode
+ * on the candidate slot, with no allocation.
+ */
+class RuleEngine {
+public:
+    RuleEngine() = default;
+
+    /**
+     * Read a rules file
+     * @param file_path Path to the rules file
+     * @return false if the file cannot be read or a line does not parse
+     */
+    bool load_file(const std::string& file_path);
+
+    /**
+     * Parse one rules-file line
+     * @param line Line text; blank lines and comments are accepted and ignored
+     * @return false on syntax error or if a limit would be exceeded
+     */
+    bool add_line(const std::string& line);
+
+    /**
+     * Compile a single rule
+     * @param rule Space-separated operations
+     * @return false on syntax error or if a limit would be exceeded
+     */
+    bool add_rule(const std::string& rule);
+
+    /**
+     * Apply a rule to a word in place
+     * @param rule Rule index
+     * @param word Buffer holding the base word, at least max_length bytes
+     * @param length Length of the base word
+     * @param max_length Largest result the buffer can hold
+     * @return length of the result, or -1 if it does not fit
+     */
+    int apply(size_t rule, uint8_t* word, size_t length, size_t max_length) const {
+        return rule_apply(program(rule), word, static_cast<int>(length), static_cast<int>(max_length));
+    }
+
+    /**
+     * Apply a rule to a word
+     * @param rule Rule index
+     * @param word Base word
+     * @param result Output
+     * @return false if the result would exceed the largest candidate slot
+     */
+    bool apply(size_t rule, std::string_view word, std::string& result) const;
+
+    /**
+     * Expand words from one batch into another as a word x rule cross product
+     * Each word is copied into its output slot once per rule and transformed
+     * there. Results that do not fit the output stride are dropped.
+     * @param words Base words
+     * @param word_index First word to expand; advanced as words complete
+     * @param rule_index Next rule for that word; advanced with word_index
+     * @param batch Destination; expansion stops when it is full
+     * @return number of candidates appended
+     */
+    size_t expand(const CandidateBatch& words, size_t& word_index, size_t& rule_index,
+                  CandidateBatch& batch) const;
+
+    size_t size() const { return offsets_.size(); }
+    bool empty() const { return offsets_.empty(); }
+    const uint8_t* program(size_t rule) const { return bytecode_.data() + offsets_[rule]; }
+
+    // Flat program storage for device uploads
+    const std::vector<uint8_t>& bytecode() const { return bytecode_; }
+    const std::vector<uint32_t>& offsets() const { return offsets_; }
+
+    const std::string& get_last_error() const { return last_error_; }
+
+private:
+    std::vector<uint8_t> bytecode_;
+    std::vector<uint32_t> offsets_;
+    std::string last_error_;
+
+    bool compile(const std::string& rule, std::vector<uint8_t>& program);
+    bool compile_operation(const std::string& operation, std::vector<uint8_t>& program);
+};
+
+/**
+ * Lazy word x rule expansion over a dictionary
+ *
+ * Each word is read from the cursor once and run through every rule before
+ * the next word is read, so the expanded candidate space is never stored.
+ * word_offset() and rule_index() identify the next candidate; a cursor
+ * opened at that offset and an expander started at that rule resume the
+ * search exactly.
+ */
+class RuleExpander {
+public:
+    /**
+     * @param rules Compiled rules (must not be empty)
+     * @param words Dictionary cursor positioned at a line start
+     * @param first_rule Rule to apply first to the cursor's first word
+     */
+    RuleExpander(const RuleEngine& rules, DictionaryCursor& words, size_t first_rule = 0);
+
+    /**
+     * Append candidates until the batch is full or the dictionary range ends
+     * @param batch Destination
+     * @return number of candidates appended
+     */
+    size_t fill(CandidateBatch& batch);
+
+    uint64_t word_offset() const { return has_word_ ? word_offset_ : words_.offset(); }
+    size_t rule_index() const { return rule_; }
+    bool done() const { return !has_word_ && words_.done(); }
+
+    // Candidates dropped because the transformed word did not fit a slot
+    uint64_t rejected() const { return rejected_; }
+
+private:
+    const RuleEngine& rules_;
+    DictionaryCursor& words_;
+    std::string_view word_;
+    uint64_t word_offset_;
+    size_t rule_;
+    bool has_word_;
+    uint64_t rejected_;
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "core/candidate_batch.h"
+#include "utils/mapped_file.h"
+#include "utils/scrypt.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Persistent record of the candidates already tested against one wallet
+ *
+ * Each candidate is reduced to a 64-bit fingerprint, a truncated SHA-256
+ * keyed by the wallet's KDF salt and iteration count, so the index of one
+ * wallet is useless against another and a re-encrypted wallet starts
+ * empty. The file holds a header and a few sorted runs of fingerprints and
+ * is memory-mapped, so lookups touch only the pages they search.
+ *
+ * Candidates tested in this run collect in memory until flush() appends
+ * them as a new run; once MAX_RUNS runs exist they are merged into one,
+ * written beside the index and renamed over it. Exact fingerprints rather
+ * than a Bloom filter keep the chance of skipping an untested candidate at
+ * about size() / 2^64 per lookup.
+ */
+class TestedCandidateIndex {
+public:
+    // Runs kept side by side before flush() merges them
+    static constexpr size_t MAX_RUNS = 8;
+
+    TestedCandidateIndex() = default;
+    ~TestedCandidateIndex();
+
+    TestedCandidateIndex(const TestedCandidateIndex&) = delete;
+    TestedCandidateIndex& operator=(const TestedCandidateIndex&) = delete;
+
+    /**
+     * Per-user directory for index files when none is configured
+     */
+    static std::string default_directory();
+
+    /**
+     * Index file name for a wallet, derived from its KDF parameters
+     * @param salt KDF salt
+     * @param salt_length Salt length
+     * @param iterations KDF iteration count
+     * @return file name without directory
+     */
+    static std::string file_name(const uint8_t* salt, size_t salt_length, uint32_t iterations);
+
+    /**
+     * Open an index, creating it if the file does not exist
+     * @param file_path Index file
+     * @param salt KDF salt of the wallet
+     * @param salt_length Salt length
+     * @param iterations KDF iteration count
+     * @return false if the file belongs to another wallet, is malformed or cannot be created
+     */
+    bool open(const std::string& file_path, const uint8_t* salt, size_t salt_length, uint32_t iterations);
+
+    /**
+     * Write pending fingerprints and release the file
+     */
+    void close();
+
+    /**
+     * Fingerprint of a candidate under this index's wallet key
+     */
+    uint64_t fingerprint(const uint8_t* data, size_t length) const;
+
+    /**
+     * Check whether a candidate was tested before or recorded in this run
+     */
+    bool contains(const uint8_t* data, size_t length) const;
+
+    /**
+     * Drop candidates that were already tested, and repeats within the
+     * batch, before the batch reaches the KDF. Kept candidates move up in
+     * order, so their indices change.
+     * @param batch Batch to filter in place
+     * @return number of candidates dropped
+     */
+    size_t filter(CandidateBatch& batch) const;
+
+    /**
+     * Record the candidates of a batch once they have been tested; safe to
+     * call from any worker
+     */
+    void record(const CandidateBatch& batch);
+    void record(const uint8_t* data, size_t length);
+
+    /**
+     * Persist the candidates recorded since the last flush
+     * @return true if successful
+     */
+    bool flush();
+
+    /**
+     * Tested candidates, both on disk and pending
+     */
+    uint64_t size() const;
+
+    size_t pending_count() const;
+    size_t run_count() const;
+    bool is_open() const { return opened_; }
+    const std::string& get_file_path() const { return file_path_; }
+    const std::string& get_last_error() const { return last_error_; }
+
+private:
+    struct Run {
+        const uint64_t* begin;
+        const uint64_t* end;
+    };
+
+    std::string file_path_;
+    bool opened_ = false;
+    uint8_t wallet_key_[32] = {};
+    SHA256Context keyed_;                  // SHA-256 state after the wallet key block
+
+    mutable std::mutex lock_;
+    MappedFile file_;
+    std::vector<Run> runs_;
+    uint64_t stored_ = 0;
+    std::unordered_set<uint64_t> pending_;
+    bool needs_rewrite_ = false;           // The file ends in a torn run
+    std::string last_error_;
+
+    bool map_runs(bool& torn);
+    bool stored_contains(uint64_t fingerprint) const;
+    bool append_run(const std::vector<uint64_t>& fingerprints);
+    bool rewrite(const std::vector<uint64_t>& extra);
+};
@@ -4,6 +4,7 @@
 
 #include <cuda_runtime.h>
 #include <device_launch_parameters.h>
+#include "gpu/gpu_sensors.h"
 #include <string>
 #include <vector>
 #include <memory>
@@ -67,6 +68,9 @@ struct CUDAIntegratedProfile {
     bool enable_thermal_throttling;
     bool use_streams;
     int stream_count;
+    float thermal_throttling_threshold = 0.0f;  // Celsius, 0 = driver default
+    float power_limit_watts = 0.0f;             // 0 = unknown
+    float performance_scaling_factor = 1.0f;
     std::map<std::string, int> kernel_parameters;
 };
 
@@ -79,7 +83,9 @@ public:
     ~CUDAIntegratedManager();
 
     /**
-     * Initialize CUDA runtime for integrated GPUs
+     * Check that the device inventory holds a CUDA device
+     * Devices are described from the inventory, so the manager never
+     * creates a context.
      * @return true if successful
      */
     bool initialize();
@@ -90,6 +96,20 @@ public:
      */
     std::vector<CUDAIntegratedInfo> detect_cuda_integrated_gpus();
 
+    /**
+     * Detect every CUDA device, discrete and integrated
+     * @return one entry per device that can be queried
+     */
+    std::vector<CUDAIntegratedInfo> detect_cuda_gpus();
+
+    /**
+     * Describe one CUDA device
+     * @param device_id CUDA device ID
+     * @param gpu_info Output
+     * @return false if the device cannot be queried
+     */
+    bool get_device_info(int device_id, CUDAIntegratedInfo& gpu_info);
+
     /**
      * Get the best CUDA integrated GPU
      * @return pointer to best GPU info, nullptr if none found
@@ -147,7 +167,17 @@ public:
     float get_gpu_temperature(int device_id);
 
     /**
-     * Cleanup CUDA resources
+     * Sample temperature, clocks, power and throttle state
+     * Discrete GPUs are read through NVML, integrated ones from sysfs.
+     * @param device_id CUDA device ID
+     * @param reading Output
+     * @return false if no sensor could be read
+     */
+    bool read_gpu_sensors(int device_id, GpuSensorReading& reading);
+
+    /**
+     * Release the manager; device contexts are left alone, since every
+     * recovery instance in the process shares them
      */
     void cleanup();
 
@@ -242,3 +272,5 @@ private:
     float get_memory_throughput_ratio();
     int get_optimal_thread_count();
 };
+
+#endif // ENABLE_CUDA
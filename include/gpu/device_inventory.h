@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * APIs a GPU in the inventory is driven through
+ */
+enum class InventoryBackend {
+    OPENCL,
+    CUDA
+};
+
+/**
+ * One GPU as found at startup, before any context is created on it
+ *
+ * OpenCL entries are the Intel and AMD GPUs in opencl_integrated_devices()
+ * order. CUDA entries also carry the cudaDeviceProp fields that
+ * CUDAIntegratedManager classifies and profiles devices by.
+ */
+struct InventoryDevice {
+    InventoryBackend backend = InventoryBackend::OPENCL;
+    int index = 0;                  // Position in opencl_integrated_devices(), or CUDA ordinal
+    std::string name;
+    std::string vendor;             // "Intel", "AMD" or "NVIDIA"
+    std::string device_version;     // CL_DEVICE_VERSION, or compute capability "major.minor"
+    std::string driver_version;     // CL_DRIVER_VERSION, or the CUDA driver version
+    uint64_t global_memory = 0;
+    int compute_units = 0;          // Compute units or multiprocessors
+    int max_work_group_size = 0;    // Work-group or thread-block limit
+    int max_clock_mhz = 0;
+    bool integrated = false;        // CL_DEVICE_HOST_UNIFIED_MEMORY or cudaDeviceProp::integrated
+
+    // CUDA only
+    bool unified_addressing = false;
+    uint64_t shared_memory_per_block = 0;
+    int max_threads_per_multiprocessor = 0;
+    int warp_size = 0;
+    int max_grid_size[3] = {0, 0, 0};
+    int max_block_size[3] = {0, 0, 0};
+    int memory_bus_width = 0;       // Bits
+    int memory_clock_khz = 0;
+    int clock_khz = 0;
+};
+
+/**
+ * Every GPU the process can use, from a single pass over the drivers
+ */
+struct DeviceInventory {
+    std::string fingerprint;        // device_fingerprint() the devices were found under
+    std::vector<InventoryDevice> devices;
+    bool from_cache = false;
+
+    /**
+     * Devices of one backend, in index order
+     */
+    std::vector<InventoryDevice> backend_devices(InventoryBackend backend) const;
+
+    /**
+     * Look up a device by backend and index
+     * @return nullptr if there is no such device
+     */
+    const InventoryDevice* find(InventoryBackend backend, int index) const;
+};
+
+/**
+ * Device inventory persisted across runs
+ *
+ * The file holds the devices found under one host fingerprint. Loading it
+ * under any other fingerprint is a miss, so a driver, ICD or GPU change
+ * forces a rescan. The file is rewritten through a temporary file so
+ * workers sharing a host never read half of it.
+ */
+class DeviceInventoryCache {
+public:
+    /**
+     * @param file_path Cache file; empty uses default_path()
+     */
+    explicit DeviceInventoryCache(const std::string& file_path = "");
+
+    /**
+     * $XDG_CACHE_HOME/btc-recovery/devices.tsv, or under ~/.cache
+     */
+    static std::string default_path();
+
+    /**
+     * Read the inventory stored for a fingerprint
+     * @param fingerprint Current device_fingerprint()
+     * @param inventory Output
+     * @return false on a miss: no file, another fingerprint or a corrupt file
+     */
+    bool load(const std::string& fingerprint, DeviceInventory& inventory) const;
+
+    /**
+     * Replace the stored inventory
+     * @return false if the file cannot be written
+     */
+    bool store(const DeviceInventory& inventory);
+
+    const std::string& get_file_path() const { return file_path_; }
+    const std::string& get_last_error() const { return last_error_; }
+
+private:
+    std::string file_path_;
+    std::string last_error_;
+};
+
+/**
+ * Hash of everything the device list depends on that can be read without
+ * loading a GPU driver: installed OpenCL ICDs, kernel driver module
+ * versions, the display adapters on the PCI bus, the CUDA driver and
+ * runtime versions, the environment variables that filter devices, and
+ * the backends compiled in
+ */
+std::string device_fingerprint();
+
+/**
+ * Enumerate the OpenCL platforms and CUDA devices once, without creating
+ * a context on any device
+ */
+DeviceInventory scan_devices();
+
+/**
+ * The process-wide inventory
+ *
+ * The first call loads the cache, or scans and stores a new one when the
+ * fingerprint changed; later calls return the same inventory.
+ */
+const DeviceInventory& device_inventory();
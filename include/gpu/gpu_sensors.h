@@ -0,0 +1,67 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * One sample of a GPU's thermal and clock state; -1 marks a value the
+ * platform does not report
+ */
+struct GpuSensorReading {
+    float temperature_c = -1.0f;
+    int graphics_clock_mhz = -1;
+    int memory_clock_mhz = -1;
+    float power_w = -1.0f;
+    bool thermal_throttling = false;   // Clocks held down by temperature
+    bool power_throttling = false;     // Clocks held down by the power cap
+};
+
+/**
+ * GPU sensors without a CUDA dependency
+ *
+ * Discrete NVIDIA GPUs are read through NVML, loaded at runtime so the
+ * binary still starts where the driver ships no libnvidia-ml. Tegra and
+ * other SoC GPUs have no NVML; their GPU thermal zone and devfreq clock
+ * are read from sysfs instead.
+ */
+class GpuSensors {
+public:
+    /**
+     * @param sysfs_root Where sysfs is mounted; tests point this at a fake tree
+     */
+    explicit GpuSensors(const std::string& sysfs_root = "/sys");
+    ~GpuSensors();
+
+    GpuSensors(const GpuSensors&) = delete;
+    GpuSensors& operator=(const GpuSensors&) = delete;
+
+    /**
+     * Process-wide instance over the real /sys; NVML is loaded once
+     */
+    static GpuSensors& instance();
+
+    /**
+     * Sample one GPU
+     * @param pci_bus_id Bus id from cudaDeviceGetPCIBusId, e.g. "0000:01:00.0";
+     *                   empty for an SoC GPU, which is read from sysfs
+     * @param reading Output
+     * @return false if no sensor could be read
+     */
+    bool read(const std::string& pci_bus_id, GpuSensorReading& reading);
+
+    /**
+     * Whether NVML was found and initialized
+     */
+    bool has_nvml() const;
+
+private:
+    struct Nvml;
+
+    std::string sysfs_root_;
+    std::unique_ptr<Nvml> nvml_;
+    std::mutex mutex_;
+
+    bool read_nvml(const std::string& pci_bus_id, GpuSensorReading& reading);
+    bool read_sysfs(GpuSensorReading& reading);
+};
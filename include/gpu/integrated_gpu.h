@@ -5,6 +5,8 @@
 #include <memory>
 #include <map>
 
+struct InventoryDevice;
+
 /**
  * Integrated GPU types
  */
@@ -64,6 +66,8 @@ public:
 
     /**
      * Detect available integrated GPUs
+     * Devices come from the shared device inventory, and the result is
+     * kept for later calls on this manager.
      * @return vector of detected integrated GPUs
      */
     std::vector<IntegratedGPUInfo> detect_integrated_gpus();
@@ -74,6 +78,13 @@ public:
      */
     std::unique_ptr<IntegratedGPUInfo> get_best_integrated_gpu();
 
+    /**
+     * Describe one OpenCL device of the inventory
+     * @param device OpenCL inventory entry
+     * @return GPU information with the vendor's type and TDP
+     */
+    IntegratedGPUInfo describe_opencl_device(const InventoryDevice& device);
+
     /**
      * Get performance profile for specific GPU type
      * @param type Integrated GPU type
@@ -110,12 +121,15 @@ public:
 
 private:
     std::vector<IntegratedGPUProfile> profiles_;
+    std::vector<IntegratedGPUInfo> gpus_;
+    bool detected_;
 
     // Detection methods
     std::vector<IntegratedGPUInfo> detect_intel_gpus();
     std::vector<IntegratedGPUInfo> detect_amd_gpus();
     std::vector<IntegratedGPUInfo> detect_apple_gpus();
     std::vector<IntegratedGPUInfo> detect_nvidia_integrated_gpus();
+    IntegratedGPUInfo describe_opencl_gpu(const InventoryDevice& device);
 
     // GPU type identification
     IntegratedGPUType identify_intel_gpu(const std::string& device_name);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "wallets/bitcoin_core_mkey.h"
+#include <cstddef>
+#include <string>
+
+/**
+ * Password-length buckets the verification kernels are instantiated for
+ *
+ * A kernel built for a bucket loads at most that many key bytes, so the
+ * HMAC key words past it fold to constants and the whole key stays in
+ * registers instead of a per-thread buffer in local memory. Longer
+ * candidates take the generic kernel (bucket 0), which handles any length.
+ */
+static constexpr size_t KERNEL_LENGTH_BUCKETS[] = {8, 16, 32, 64};
+static constexpr size_t KERNEL_LENGTH_BUCKET_COUNT = sizeof(KERNEL_LENGTH_BUCKETS) / sizeof(KERNEL_LENGTH_BUCKETS[0]);
+
+// Entry point of nvrtc_mkey_kernel_source()
+#define NVRTC_MKEY_KERNEL_NAME "cuda_verify_master_key_specialised"
+
+/**
+ * Smallest bucket that holds every candidate of a batch
+ * @param max_length Longest candidate the kernel will see
+ * @return bucket, 0 if only the generic kernel can take it
+ */
+size_t kernel_length_bucket(size_t max_length);
+
+/**
+ * Position of a bucket in KERNEL_LENGTH_BUCKETS, -1 for the generic kernel
+ */
+int kernel_length_bucket_index(size_t bucket);
+
+/**
+ * CUDA C++ source of a verification kernel specialised for one wallet
+ * The record, its salt block and its iteration count are compile-time
+ * constants of the module, so NVRTC can unroll the PBKDF2 loop bound and
+ * fold the salt into the first compression. The source includes
+ * "wallets/bitcoin_core_mkey.h"; the caller supplies the headers.
+ * @param check Verification record
+ * @param bucket Length bucket from kernel_length_bucket(), not 0
+ * @return kernel source defining NVRTC_MKEY_KERNEL_NAME
+ */
+std::string nvrtc_mkey_kernel_source(const BitcoinCoreMKeyCheck& check, size_t bucket);
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Kernel launch geometry and batch size for one device
+ */
+struct LaunchConfig {
+    int threads_per_block = 0;
+    int candidates_per_thread = 1;   // Grid-stride iterations each thread runs per launch
+    int batch_size = 0;              // Candidates per pipeline slot
+
+    /**
+     * Blocks needed to cover one full batch
+     */
+    int blocks_per_grid() const;
+
+    bool valid() const { return threads_per_block > 0 && candidates_per_thread > 0 && batch_size > 0; }
+    bool operator==(const LaunchConfig& other) const {
+        return threads_per_block == other.threads_per_block && candidates_per_thread == other.candidates_per_thread &&
+               batch_size == other.batch_size;
+    }
+};
+
+/**
+ * Values each launch parameter may take during an autotune sweep
+ */
+struct LaunchSearchSpace {
+    std::vector<int> threads_per_block;
+    std::vector<int> candidates_per_thread;
+    std::vector<int> batch_size;
+
+    /**
+     * Sweep around a device's static profile
+     * @param max_threads_per_block Device limit
+     * @param max_batch_size Largest batch the device memory allows
+     * @param base Profile geometry the sweep starts from
+     */
+    static LaunchSearchSpace around(int max_threads_per_block, int max_batch_size, const LaunchConfig& base);
+};
+
+/**
+ * Pick the fastest launch configuration by measuring it
+ *
+ * The search is coordinate descent from the start point: each parameter in
+ * turn is swept with the others fixed, keeping the best, until a full pass
+ * changes nothing. That needs a few dozen measurements rather than the full
+ * cross product, which keeps the startup stage short.
+ * @param space Values to try
+ * @param start Starting configuration, usually the static profile
+ * @param measure Candidates per second for a configuration; <= 0 if it cannot run
+ * @param best_rate Output rate of the winner
+ * @return Fastest configuration found; start if nothing ran faster
+ */
+LaunchConfig autotune_launch(const LaunchSearchSpace& space, const LaunchConfig& start,
+                             const std::function<double(const LaunchConfig&)>& measure, double& best_rate);
+
+/**
+ * Identity of a tuning result: device, driver and wallet KDF cost
+ */
+struct TuningKey {
+    std::string device_name;
+    std::string compute_capability;
+    int driver_version = 0;
+    uint32_t kdf_iterations = 0;
+
+    bool operator<(const TuningKey& other) const;
+};
+
+/**
+ * Autotune results persisted across runs
+ *
+ * One tab-separated line per key, rewritten through a temporary file so a
+ * crash never leaves a half-written cache. A missing or unreadable cache
+ * behaves as an empty one.
+ */
+class TuningCache {
+public:
+    /**
+     * @param file_path Cache file; empty uses default_path()
+     */
+    explicit TuningCache(const std::string& file_path = "");
+
+    /**
+     * $XDG_CACHE_HOME/btc-recovery/launch_tuning.tsv, or under ~/.cache
+     */
+    static std::string default_path();
+
+    /**
+     * Read the cache file; entries already in memory are replaced
+     * @return false if the file exists but is malformed
+     */
+    bool load();
+
+    /**
+     * Find a stored configuration
+     * @param key Device, driver and KDF cost
+     * @param config Output
+     * @param rate Output measured rate, may be null
+     * @return false if the key has no entry
+     */
+    bool lookup(const TuningKey& key, LaunchConfig& config, double* rate = nullptr) const;
+
+    /**
+     * Store a configuration and write the cache file
+     * @return false if the file cannot be written
+     */
+    bool store(const TuningKey& key, const LaunchConfig& config, double rate);
+
+    size_t size() const { return entries_.size(); }
+    const std::string& get_file_path() const { return file_path_; }
+    const std::string& get_last_error() const { return last_error_; }
+
+private:
+    struct Entry {
+        LaunchConfig config;
+        double rate;
+    };
+
+    std::string file_path_;
+    std::map<TuningKey, Entry> entries_;
+    std::string last_error_;
+
+    bool save();
+};
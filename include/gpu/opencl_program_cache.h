@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * Everything a compiled OpenCL program binary depends on
+ *
+ * A binary is only reusable on the same device, with the same driver and
+ * build options, for the same kernel source; any change here means a
+ * rebuild.
+ */
+struct ProgramCacheKey {
+    std::string device_name;
+    std::string device_version;     // CL_DEVICE_VERSION
+    std::string driver_version;     // CL_DRIVER_VERSION
+    std::string platform_version;   // CL_PLATFORM_VERSION
+    std::string build_options;
+    std::string source;             // Hashed into the identity, not stored
+
+    /**
+     * One-line description of the key, stored in the cache file and
+     * compared on load so a hash collision can never return a wrong binary
+     */
+    std::string identity() const;
+};
+
+/**
+ * Compiled OpenCL program binaries persisted across runs
+ *
+ * Each key gets its own file, named by a hash of its identity and
+ * rewritten through a temporary file, so several processes on one host
+ * can share the directory. A missing, stale or corrupt file is a cache
+ * miss and the program is built from source again.
+ */
+class ProgramBinaryCache {
+public:
+    /**
+     * @param directory Cache directory; empty uses default_directory()
+     */
+    explicit ProgramBinaryCache(const std::string& directory = "");
+
+    /**
+     * $XDG_CACHE_HOME/btc-recovery/opencl, or under ~/.cache
+     */
+    static std::string default_directory();
+
+    /**
+     * Read the binary stored for a key
+     * @param key Device, driver, options and source
+     * @param binary Output program binary
+     * @return false on a miss
+     */
+    bool load(const ProgramCacheKey& key, std::vector<unsigned char>& binary) const;
+
+    /**
+     * Store a binary for a key, replacing any previous one
+     * @return false if the file cannot be written
+     */
+    bool store(const ProgramCacheKey& key, const std::vector<unsigned char>& binary);
+
+    /**
+     * Drop the entry for a key, e.g. a binary the driver rejected
+     */
+    void remove(const ProgramCacheKey& key);
+
+    /**
+     * File that holds the entry for a key
+     */
+    std::string path_for(const ProgramCacheKey& key) const;
+
+    const std::string& get_directory() const { return directory_; }
+    const std::string& get_last_error() const { return last_error_; }
+
+private:
+    std::string directory_;
+    std::string last_error_;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#ifdef ENABLE_OPENCL
+
+// The backends only use the OpenCL 1.2 API, which every integrated GPU
+// driver still supports
+#ifndef CL_TARGET_OPENCL_VERSION
+#define CL_TARGET_OPENCL_VERSION 120
+#endif
+
+#include "gpu/opencl_program_cache.h"
+#include <CL/cl.h>
+#include <string>
+#include <vector>
+
+/**
+ * One OpenCL GPU a recovery backend can drive
+ */
+struct OpenCLDevice {
+    cl_platform_id platform = nullptr;
+    cl_device_id device = nullptr;
+    std::string name;
+    std::string vendor;
+    bool host_unified_memory = false;  // Shares physical memory with the host
+};
+
+/**
+ * Name of an OpenCL error code for logs
+ */
+const char* opencl_error_string(cl_int error);
+
+/**
+ * Read a string property of a device
+ */
+std::string opencl_device_string(cl_device_id device, cl_device_info param);
+
+/**
+ * Read a string property of a platform
+ */
+std::string opencl_platform_string(cl_platform_id platform, cl_platform_info param);
+
+/**
+ * GPUs on the Intel and AMD platforms, in the order IntegratedGPUManager
+ * reports them, so an OPENCL ComputeDevice id indexes this list
+ * The platforms are enumerated on the first call only.
+ * @return devices, empty if OpenCL has no such platform
+ */
+std::vector<OpenCLDevice> opencl_integrated_devices();
+
+/**
+ * Build a program for one device, reusing a cached binary when possible
+ *
+ * A binary cached for this device, driver, options and source is loaded
+ * with clCreateProgramWithBinary; if the driver rejects it the entry is
+ * dropped and the program is built from source, and the new binary is
+ * stored for the next run.
+ * @param context Context holding the device
+ * @param device Target device
+ * @param source Kernel source
+ * @param options Build options
+ * @param cache Binary cache, may be null to always build from source
+ * @param from_cache Output, whether the cached binary was used; may be null
+ * @return program, nullptr on failure (the build log is logged)
+ */
+cl_program opencl_build_program(cl_context context, const OpenCLDevice& device, const char* source,
+                                const std::string& options, ProgramBinaryCache* cache, bool* from_cache = nullptr);
+
+#endif // ENABLE_OPENCL
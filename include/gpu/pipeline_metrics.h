@@ -0,0 +1,53 @@
+#pragma once
+
+#include "core/device_scheduler.h"
+#include "utils/metrics.h"
+
+/**
+ * Per-device latency histograms of a GPU batch pipeline
+ *
+ * A batch is generated into staging memory, copied to the device, verified
+ * by the kernel, its result copied back and checked on the host. Each
+ * phase has its own histogram so a slow bus or a throttled GPU shows up as
+ * the phase it slows. in_flight is the number of batches queued on the
+ * device, and governor_level the share of full throughput the thermal
+ * governor currently allows it.
+ */
+struct PipelineMetrics {
+    LatencyHistogram* generate = nullptr;
+    LatencyHistogram* host_to_device = nullptr;
+    LatencyHistogram* kernel = nullptr;
+    LatencyHistogram* device_to_host = nullptr;
+    LatencyHistogram* verify = nullptr;
+    MetricGauge* in_flight = nullptr;
+    MetricGauge* governor_level = nullptr;
+
+    /**
+     * Register the series of one device in the global registry
+     * @param kind Backend of the device, for the labels DeviceScheduler uses
+     * @param device_id CUDA ordinal or OpenCL device index
+     */
+    static PipelineMetrics create(ComputeDeviceKind kind, int device_id) {
+        MetricsRegistry& registry = MetricsRegistry::global();
+        const MetricLabels labels = compute_device_labels(kind, device_id);
+        auto phase = [&](const char* name) {
+            MetricLabels phase_labels = labels;
+            phase_labels.emplace_back("phase", name);
+            return &registry.histogram("btc_recovery_batch_phase_seconds",
+                                       "Time per GPU batch in each pipeline phase", phase_labels);
+        };
+
+        PipelineMetrics metrics;
+        metrics.generate = phase("generate");
+        metrics.host_to_device = phase("h2d");
+        metrics.kernel = phase("kernel");
+        metrics.device_to_host = phase("d2h");
+        metrics.verify = phase("verify");
+        metrics.in_flight = &registry.gauge("btc_recovery_pipeline_batches_in_flight",
+                                            "GPU batches queued and not yet retired", labels);
+        metrics.governor_level = &registry.gauge("btc_recovery_thermal_governor_level",
+                                                 "Share of full throughput the thermal governor allows", labels);
+        metrics.governor_level->set(1.0);
+        return metrics;
+    }
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "gpu/gpu_sensors.h"
+#include <cstdint>
+
+/**
+ * Thermal and power envelope a governed device should stay inside
+ */
+struct ThermalLimits {
+    float throttle_temperature_c = 0.0f;   // Where the device starts throttling, 0 = DEFAULT_THROTTLE_C
+    float power_limit_w = 0.0f;            // Sustained board power, 0 = unknown
+    float margin_c = 3.0f;                 // How far below the throttle point to settle
+};
+
+/**
+ * Pacing of a governed batch pipeline
+ */
+struct ThermalSetting {
+    double batch_fraction = 1.0;   // Share of a slot's capacity filled per batch
+    double occupancy = 1.0;        // Share of the launch grid's blocks
+    double duty_cycle = 1.0;       // Share of wall time the device is given work
+
+    /**
+     * Host pause after a batch that kept the device busy for busy_seconds
+     */
+    double idle_after(double busy_seconds) const;
+};
+
+/**
+ * Closed-loop governor that keeps a long run just below the throttle point
+ *
+ * Once a laptop or Jetson GPU reaches its hard thermal limit the firmware
+ * drops clocks far below what the heat actually requires, so running
+ * flat out loses candidates per hour. The governor samples temperature,
+ * power and throttle reasons once per SAMPLE_INTERVAL and steers a single
+ * level between MIN_LEVEL and 1: multiplicative decrease whenever the
+ * device throttles, runs hotter than the target or draws more than its
+ * power limit, additive increase while it has clear headroom, and no
+ * change inside the band in between, so the level settles where the heat
+ * the device makes matches what it can shed.
+ *
+ * The level is spent first on occupancy, which keeps clocks up while fewer
+ * multiprocessors run, and below OCCUPANCY_FLOOR on the duty cycle, with
+ * batches shortened alongside so the idle gaps stay short against the
+ * device's thermal time constant.
+ *
+ * The governor is plain arithmetic over readings; the backend samples the
+ * sensors and applies the setting. A device that reports neither its
+ * temperature nor its power draw is never paced.
+ */
+class ThermalGovernor {
+public:
+    static constexpr float DEFAULT_THROTTLE_C = 87.0f;
+    static constexpr double SAMPLE_INTERVAL = 1.0;        // Seconds between control steps
+    static constexpr double MIN_LEVEL = 0.2;
+    static constexpr double OCCUPANCY_FLOOR = 0.5;
+    static constexpr double DECREASE = 0.85;              // Level factor on a hot sample
+    static constexpr double INCREASE = 0.05;              // Level step on a cool sample
+    static constexpr float HEADROOM_C = 4.0f;             // Band below the target that holds the level
+
+    ThermalGovernor() = default;
+    explicit ThermalGovernor(const ThermalLimits& limits);
+
+    /**
+     * Count candidates handed to the device, for the sustained rate
+     */
+    void record(uint64_t candidates);
+
+    /**
+     * Whether a control step is due
+     * @param now Seconds on a monotonic clock
+     */
+    bool due(double now) const;
+
+    /**
+     * Run one control step
+     * @param reading Sensor sample taken just now
+     * @param now Seconds on a monotonic clock, as passed to due()
+     * @return true if the setting changed
+     */
+    bool update(const GpuSensorReading& reading, double now);
+
+    /**
+     * Pacing implied by a level, MIN_LEVEL to 1
+     */
+    static ThermalSetting setting_for(double level);
+
+    const ThermalSetting& setting() const { return setting_; }
+    double level() const { return level_; }
+    float target_temperature() const { return target_c_; }
+
+    /**
+     * Candidates per second over the last few control steps
+     */
+    double sustained_rate() const { return sustained_rate_; }
+
+    /**
+     * Whether the last step found the device over its envelope
+     */
+    bool is_limiting() const { return limiting_; }
+
+private:
+    float target_c_ = DEFAULT_THROTTLE_C - 3.0f;
+    float power_limit_w_ = 0.0f;
+    double level_ = 1.0;
+    ThermalSetting setting_;
+    bool limiting_ = false;
+
+    bool started_ = false;
+    double last_step_ = 0.0;
+    uint64_t candidates_ = 0;
+    double sustained_rate_ = 0.0;
+};
@@ -0,0 +1,212 @@
+#pragma once
+
+#include "utils/host_device.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Portable single-block AES-256 shared by the CPU and CUDA paths
+ *
+ * Only what password verification needs: key expansion and decryption of
+ * one block. Table lookups are byte-wise and nothing allocates, so the
+ * same code runs inside CUDA kernels and on hosts without AES-NI.
+ */
+
+#define AES_SBOX_TABLE { \
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76, \
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0, \
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15, \
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75, \
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84, \
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf, \
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8, \
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2, \
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73, \
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb, \
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79, \
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08, \
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a, \
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e, \
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf, \
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16  \
+}
+
+#define AES_INV_SBOX_TABLE { \
+    0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb, \
+    0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb, \
+    0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e, \
+    0x08, 0x2e, 0xa1, 0x66, 0x28, 0xd9, 0x24, 0xb2, 0x76, 0x5b, 0xa2, 0x49, 0x6d, 0x8b, 0xd1, 0x25, \
+    0x72, 0xf8, 0xf6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xd4, 0xa4, 0x5c, 0xcc, 0x5d, 0x65, 0xb6, 0x92, \
+    0x6c, 0x70, 0x48, 0x50, 0xfd, 0xed, 0xb9, 0xda, 0x5e, 0x15, 0x46, 0x57, 0xa7, 0x8d, 0x9d, 0x84, \
+    0x90, 0xd8, 0xab, 0x00, 0x8c, 0xbc, 0xd3, 0x0a, 0xf7, 0xe4, 0x58, 0x05, 0xb8, 0xb3, 0x45, 0x06, \
+    0xd0, 0x2c, 0x1e, 0x8f, 0xca, 0x3f, 0x0f, 0x02, 0xc1, 0xaf, 0xbd, 0x03, 0x01, 0x13, 0x8a, 0x6b, \
+    0x3a, 0x91, 0x11, 0x41, 0x4f, 0x67, 0xdc, 0xea, 0x97, 0xf2, 0xcf, 0xce, 0xf0, 0xb4, 0xe6, 0x73, \
+    0x96, 0xac, 0x74, 0x22, 0xe7, 0xad, 0x35, 0x85, 0xe2, 0xf9, 0x37, 0xe8, 0x1c, 0x75, 0xdf, 0x6e, \
+    0x47, 0xf1, 0x1a, 0x71, 0x1d, 0x29, 0xc5, 0x89, 0x6f, 0xb7, 0x62, 0x0e, 0xaa, 0x18, 0xbe, 0x1b, \
+    0xfc, 0x56, 0x3e, 0x4b, 0xc6, 0xd2, 0x79, 0x20, 0x9a, 0xdb, 0xc0, 0xfe, 0x78, 0xcd, 0x5a, 0xf4, \
+    0x1f, 0xdd, 0xa8, 0x33, 0x88, 0x07, 0xc7, 0x31, 0xb1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xec, 0x5f, \
+    0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef, \
+    0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61, \
+    0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d  \
+}
+
+static const uint8_t AES_SBOX_HOST[256] = AES_SBOX_TABLE;
+static const uint8_t AES_INV_SBOX_HOST[256] = AES_INV_SBOX_TABLE;
+#ifdef __CUDACC__
+static __constant__ uint8_t AES_SBOX_DEVICE[256] = AES_SBOX_TABLE;
+static __constant__ uint8_t AES_INV_SBOX_DEVICE[256] = AES_INV_SBOX_TABLE;
+#endif
+
+static const size_t AES256_KEY_SIZE = 32;
+static const size_t AES_BLOCK_BYTES = 16;
+static const int AES256_ROUNDS = 14;
+static const size_t AES256_ROUND_KEY_BYTES = (AES256_ROUNDS + 1) * 16;
+
+BTC_HOST_DEVICE inline uint8_t aes_sbox(uint8_t x) {
+#ifdef __CUDA_ARCH__
+    return AES_SBOX_DEVICE[x];
+#else
+    return AES_SBOX_HOST[x];
+#endif
+}
+
+BTC_HOST_DEVICE inline uint8_t aes_inv_sbox(uint8_t x) {
+#ifdef __CUDA_ARCH__
+    return AES_INV_SBOX_DEVICE[x];
+#else
+    return AES_INV_SBOX_HOST[x];
+#endif
+}
+
+BTC_HOST_DEVICE inline uint8_t aes_xtime(uint8_t x) {
+    return static_cast<uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1b : 0x00));
+}
+
+/**
+ * Expand a 256-bit key into the 15 round keys of the cipher
+ * @param key 32-byte key
+ * @param round_keys Output, AES256_ROUND_KEY_BYTES bytes
+ */
+BTC_HOST_DEVICE inline void aes256_expand_key(const uint8_t* key, uint8_t* round_keys) {
+    for (int i = 0; i < 32; i++) {
+        round_keys[i] = key[i];
+    }
+
+    uint8_t rcon = 0x01;
+    for (int i = 8; i < 60; i++) {
+        uint8_t temp[4];
+        for (int j = 0; j < 4; j++) {
+            temp[j] = round_keys[(i - 1) * 4 + j];
+        }
+
+        if (i % 8 == 0) {
+            // RotWord, SubWord and the round constant
+            uint8_t first = temp[0];
+            temp[0] = static_cast<uint8_t>(aes_sbox(temp[1]) ^ rcon);
+            temp[1] = aes_sbox(temp[2]);
+            temp[2] = aes_sbox(temp[3]);
+            temp[3] = aes_sbox(first);
+            rcon = aes_xtime(rcon);
+        } else if (i % 8 == 4) {
+            for (int j = 0; j < 4; j++) {
+                temp[j] = aes_sbox(temp[j]);
+            }
+        }
+
+        for (int j = 0; j < 4; j++) {
+            round_keys[i * 4 + j] = round_keys[(i - 8) * 4 + j] ^ temp[j];
+        }
+    }
+}
+
+/**
+ * Decrypt one block with expanded round keys
+ * @param round_keys Output of aes256_expand_key
+ * @param in 16-byte ciphertext block
+ * @param out 16-byte plaintext block (may alias in)
+ */
+BTC_HOST_DEVICE inline void aes256_decrypt_block(const uint8_t* round_keys, const uint8_t* in, uint8_t* out) {
+    // State is column-major: byte (row r, column c) is s[r + 4 * c]
+    uint8_t s[16];
+    for (int i = 0; i < 16; i++) {
+        s[i] = in[i] ^ round_keys[AES256_ROUNDS * 16 + i];
+    }
+
+    for (int round = AES256_ROUNDS - 1; round >= 0; round--) {
+        // InvShiftRows + InvSubBytes
+        uint8_t t[16];
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) {
+                t[r + 4 * c] = aes_inv_sbox(s[r + 4 * ((c - r + 4) & 3)]);
+            }
+        }
+
+        // AddRoundKey
+        for (int i = 0; i < 16; i++) {
+            s[i] = t[i] ^ round_keys[round * 16 + i];
+        }
+
+        if (round == 0) {
+            break;
+        }
+
+        // InvMixColumns
+        for (int c = 0; c < 4; c++) {
+            uint8_t* col = s + 4 * c;
+            uint8_t a0 = col[0], a1 = col[1], a2 = col[2], a3 = col[3];
+            uint8_t x0 = aes_xtime(a0), x1 = aes_xtime(a1), x2 = aes_xtime(a2), x3 = aes_xtime(a3);
+            uint8_t y0 = aes_xtime(x0), y1 = aes_xtime(x1), y2 = aes_xtime(x2), y3 = aes_xtime(x3);
+            uint8_t z0 = aes_xtime(y0), z1 = aes_xtime(y1), z2 = aes_xtime(y2), z3 = aes_xtime(y3);
+            // 14 = 8^4^2, 11 = 8^2^1, 13 = 8^4^1, 9 = 8^1
+            col[0] = (z0 ^ y0 ^ x0) ^ (z1 ^ x1 ^ a1) ^ (z2 ^ y2 ^ a2) ^ (z3 ^ a3);
+            col[1] = (z0 ^ a0) ^ (z1 ^ y1 ^ x1) ^ (z2 ^ x2 ^ a2) ^ (z3 ^ y3 ^ a3);
+            col[2] = (z0 ^ y0 ^ a0) ^ (z1 ^ a1) ^ (z2 ^ y2 ^ x2) ^ (z3 ^ x3 ^ a3);
+            col[3] = (z0 ^ x0 ^ a0) ^ (z1 ^ y1 ^ a1) ^ (z2 ^ a2) ^ (z3 ^ y3 ^ x3);
+        }
+    }
+
+    for (int i = 0; i < 16; i++) {
+        out[i] = s[i];
+    }
+}
+
+/**
+ * Decrypt the final block of an AES-256-CBC ciphertext
+ * @param key 32-byte key
+ * @param previous_block Ciphertext block before the last one (or the IV)
+ * @param last_block Final ciphertext block
+ * @param plaintext Output, 16 bytes
+ */
+BTC_HOST_DEVICE inline void aes256_cbc_decrypt_last_block(const uint8_t* key, const uint8_t* previous_block,
+                                                          const uint8_t* last_block, uint8_t* plaintext) {
+    uint8_t round_keys[AES256_ROUND_KEY_BYTES];
+    aes256_expand_key(key, round_keys);
+    aes256_decrypt_block(round_keys, last_block, plaintext);
+    for (int i = 0; i < 16; i++) {
+        plaintext[i] ^= previous_block[i];
+    }
+}
+
+/**
+ * Check PKCS#7 padding of a final plaintext block
+ * @param block 16-byte plaintext block
+ * @param expected_padding Required pad length, or 0 to accept any valid padding
+ * @return true if the padding is well-formed
+ */
+BTC_HOST_DEVICE inline bool pkcs7_padding_valid(const uint8_t* block, uint8_t expected_padding = 0) {
+    const uint8_t padding = block[15];
+    if (padding == 0 || padding > 16) {
+        return false;
+    }
+    if (expected_padding != 0 && padding != expected_padding) {
+        return false;
+    }
+
+    // Branch-free accumulation keeps warps converged on the GPU
+    uint8_t mismatch = 0;
+    for (int i = 0; i < 16; i++) {
+        const uint8_t in_pad = static_cast<uint8_t>(i >= 16 - padding);
+        mismatch |= static_cast<uint8_t>((block[i] ^ padding) * in_pad);
+    }
+    return mismatch == 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Fast-reject check for AES-256-CBC encrypted keys
+ *
+ * Decrypts only the final ciphertext block and checks its PKCS#7 padding,
+ * with no cipher context allocation. AES-NI is used when the CPU has it,
+ * otherwise the portable implementation from aes256_block.h. Passing the
+ * check is necessary but not sufficient for a correct key: callers run the
+ * full decrypt only for candidates that pass.
+ */
+class AES256Verifier {
+public:
+    /**
+     * Check whether AES-NI is available in this build and on this CPU
+     * @return true if the hardware path is used
+     */
+    static bool has_aes_ni();
+
+    /**
+     * Decrypt the final CBC block and check its padding
+     * @param key 32-byte AES key
+     * @param previous_block Ciphertext block before the last one (or the IV)
+     * @param last_block Final ciphertext block
+     * @param expected_padding Required pad length, or 0 to accept any valid padding
+     * @return true if the padding is well-formed
+     */
+    static bool check_last_block(const uint8_t* key, const uint8_t* previous_block,
+                                 const uint8_t* last_block, uint8_t expected_padding = 0);
+
+    /**
+     * Decrypt the final CBC block into plaintext
+     * @param key 32-byte AES key
+     * @param previous_block Ciphertext block before the last one (or the IV)
+     * @param last_block Final ciphertext block
+     * @param plaintext Output, 16 bytes
+     */
+    static void decrypt_last_block(const uint8_t* key, const uint8_t* previous_block,
+                                   const uint8_t* last_block, uint8_t* plaintext);
+};
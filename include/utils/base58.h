@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Base58 and Base58Check encoding (Bitcoin alphabet)
+ */
+class Base58 {
+public:
+    /**
+     * Encode raw bytes
+     * @param data Input bytes
+     * @param length Input length
+     * @return Base58 string, one '1' per leading zero byte
+     */
+    static std::string encode(const uint8_t* data, size_t length);
+
+    /**
+     * Append the 4-byte double-SHA256 checksum and encode
+     * @param payload Version byte(s) followed by the payload
+     * @param length Payload length, at most MAX_CHECK_PAYLOAD
+     * @return Base58Check string, empty if the payload is too long
+     */
+    static std::string encode_check(const uint8_t* payload, size_t length);
+
+    static constexpr size_t MAX_CHECK_PAYLOAD = 128;
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ * Function qualifiers for code shared between host C++ and CUDA device code.
+ * Headers that are included from both .cpp and .cu files mark their
+ * functions with BTC_HOST_DEVICE so nvcc emits a device copy as well.
+ */
+#ifdef __CUDACC__
+#define BTC_HOST_DEVICE __host__ __device__
+#else
+#define BTC_HOST_DEVICE
+#endif
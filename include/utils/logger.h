@@ -1,9 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <fstream>
 #include <mutex>
 #include <memory>
+#include <vector>
 
 /**
  * Log levels
@@ -15,32 +18,58 @@ enum class LogLevel {
     ERROR = 3
 };
 
+/**
+ * Level-checked logging: the message expression is only evaluated when the
+ * level is enabled, so a disabled call costs one relaxed atomic load
+ */
+#define LOG_DEBUG(message) do { if (Logger::enabled(LogLevel::DEBUG)) Logger::debug(message); } while (0)
+#define LOG_INFO(message) do { if (Logger::enabled(LogLevel::INFO)) Logger::info(message); } while (0)
+#define LOG_WARN(message) do { if (Logger::enabled(LogLevel::WARN)) Logger::warn(message); } while (0)
+#define LOG_ERROR(message) do { if (Logger::enabled(LogLevel::ERROR)) Logger::error(message); } while (0)
+
+class AsyncLogSink;
+
 /**
  * Thread-safe logger class
+ *
+ * By default each message is formatted and written by the calling thread.
+ * In asynchronous mode callers only move the message into a per-thread
+ * lock-free ring; a background thread timestamps, formats and writes the
+ * records in batches. Errors are flushed before the call returns.
  */
 class Logger {
 public:
+    // Public so instance_ can delete it; drains the asynchronous writer
+    ~Logger();
+
     /**
      * Initialize the logger
      * @param level Log level string ("debug", "info", "warn", "error")
      * @param console_output Enable console output
      * @param log_file Optional log file path
+     * @param async Write through the background thread; call before worker
+     *              threads start logging
      */
-    static void initialize(const std::string& level, bool console_output = true, 
-                          const std::string& log_file = "");
+    static void initialize(const std::string& level, bool console_output = true,
+                          const std::string& log_file = "", bool async = false);
 
     /**
      * Log messages at different levels
      */
-    static void debug(const std::string& message);
-    static void info(const std::string& message);
-    static void warn(const std::string& message);
-    static void error(const std::string& message);
+    static void debug(std::string message);
+    static void info(std::string message);
+    static void warn(std::string message);
+    static void error(std::string message);
 
     /**
      * Log with custom level
      */
-    static void log(LogLevel level, const std::string& message);
+    static void log(LogLevel level, std::string message);
+
+    /**
+     * Whether messages at a level are written; lock-free, for hot paths
+     */
+    static bool enabled(LogLevel level) { return level >= level_.load(std::memory_order_relaxed); }
 
     /**
      * Set log level
@@ -60,6 +89,8 @@ public:
 
     /**
      * Flush all pending log messages
+     * In asynchronous mode this waits until the writer has written every
+     * record logged before the call.
      */
     static void flush();
 
@@ -69,20 +100,31 @@ public:
     static void shutdown();
 
 private:
+    friend class AsyncLogSink;
+
+    struct Record {
+        LogLevel level;
+        std::chrono::system_clock::time_point time;
+        std::string message;
+    };
+
     static std::unique_ptr<Logger> instance_;
+    static std::atomic<Logger*> current_;
+    static std::atomic<LogLevel> level_;
     static std::mutex mutex_;
 
-    LogLevel current_level_;
     bool console_output_;
     std::string log_file_path_;
     std::ofstream log_file_;
     std::mutex log_mutex_;
+    std::unique_ptr<AsyncLogSink> async_sink_;
 
     Logger();
-    ~Logger();
 
-    void write_log(LogLevel level, const std::string& message);
-    std::string get_timestamp() const;
+    void write_log(LogLevel level, std::string message);
+    void write_records(const std::vector<Record>& records);
+    std::string format_record(const Record& record) const;
+    std::string get_timestamp(std::chrono::system_clock::time_point time) const;
     std::string level_to_string(LogLevel level) const;
     LogLevel string_to_level(const std::string& level) const;
 
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Non-owning view of a byte range, typically inside a MappedFile
+ */
+struct ByteSpan {
+    const uint8_t* ptr = nullptr;
+    size_t length = 0;
+
+    ByteSpan() = default;
+    ByteSpan(const uint8_t* data, size_t size) : ptr(data), length(size) {}
+
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    const uint8_t* begin() const { return ptr; }
+    const uint8_t* end() const { return ptr + length; }
+    uint8_t operator[](size_t index) const { return ptr[index]; }
+
+    /**
+     * Sub-range of this span, clamped to its bounds
+     */
+    ByteSpan subspan(size_t offset, size_t count) const {
+        if (offset > length) return ByteSpan();
+        return ByteSpan(ptr + offset, count < length - offset ? count : length - offset);
+    }
+
+    std::vector<uint8_t> to_vector() const { return std::vector<uint8_t>(begin(), end()); }
+};
+
+/**
+ * Read-only memory-mapped file
+ *
+ * Pages are only brought in when touched, so walking a large file's
+ * structure costs memory proportional to what is actually read. On
+ * platforms without mmap the file is read into an owned buffer instead.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /**
+     * Map a file read-only
+     * @param file_path Path to file
+     * @return true if successful
+     */
+    bool open(const std::string& file_path);
+
+    /**
+     * Unmap the file; spans into it become invalid
+     */
+    void close();
+
+    /**
+     * Hint that the given range will be read soon
+     */
+    void prefetch(size_t offset, size_t length) const;
+
+    /**
+     * Hint that the file will be read front to back, enabling aggressive readahead
+     */
+    void advise_sequential() const;
+
+    /**
+     * Hint that the given range is no longer needed, letting the kernel drop its pages
+     */
+    void release(size_t offset, size_t length) const;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool is_open() const { return opened_; }
+    ByteSpan span() const { return ByteSpan(data_, size_); }
+    ByteSpan span(size_t offset, size_t length) const { return span().subspan(offset, length); }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool opened_ = false;
+    std::vector<uint8_t> fallback_;
+};
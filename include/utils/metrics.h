@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Label names and values of one time series, e.g. {{"backend", "cuda"}, {"device", "0"}}
+ */
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * Monotonic count; add() is a single relaxed atomic increment
+ */
+class MetricCounter {
+public:
+    void add(uint64_t count = 1) { value_.fetch_add(count, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+/**
+ * Last written value; set() is a single relaxed atomic store
+ */
+class MetricGauge {
+public:
+    void set(double value) { value_.store(value, std::memory_order_relaxed); }
+    double value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> value_{0.0};
+};
+
+/**
+ * Latency distribution over fixed buckets from 100 us to 60 s
+ *
+ * observe() costs two relaxed increments; the sum is kept in whole
+ * nanoseconds so no floating-point compare-and-swap is needed.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t BUCKET_COUNT = 18;
+
+    // Upper bounds in seconds; one more bucket catches everything above
+    static const double BUCKET_BOUNDS[BUCKET_COUNT];
+
+    /**
+     * Record one duration
+     * @param seconds Observed latency; negative values are counted as 0
+     */
+    void observe(double seconds);
+
+    /**
+     * Observations in one bucket, not cumulative
+     * @param index 0..BUCKET_COUNT, the last being +Inf
+     */
+    uint64_t bucket(size_t index) const { return buckets_[index].load(std::memory_order_relaxed); }
+
+    uint64_t count() const;
+    double sum() const { return sum_nanoseconds_.load(std::memory_order_relaxed) / 1e9; }
+
+private:
+    std::atomic<uint64_t> buckets_[BUCKET_COUNT + 1] = {};
+    std::atomic<uint64_t> sum_nanoseconds_{0};
+};
+
+/**
+ * Process-wide set of metrics, rendered in the Prometheus text format
+ *
+ * Metrics are created once, off the hot path, and the returned references
+ * stay valid for the life of the registry; asking again for the same name
+ * and labels returns the same metric. Values that are expensive to read,
+ * such as GPU sensors, are registered as callbacks and sampled only when
+ * the endpoint is scraped.
+ */
+class MetricsRegistry {
+public:
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    /**
+     * Registry the /metrics endpoint serves
+     */
+    static MetricsRegistry& global();
+
+    /**
+     * Get or create a metric
+     * @param name Metric name, e.g. "btc_recovery_candidates_tested_total"
+     * @param help One-line description for the HELP comment
+     * @param labels Labels of this series
+     * @throws std::logic_error if name is already registered with another type
+     */
+    MetricCounter& counter(const std::string& name, const std::string& help, const MetricLabels& labels = {});
+    MetricGauge& gauge(const std::string& name, const std::string& help, const MetricLabels& labels = {});
+    LatencyHistogram& histogram(const std::string& name, const std::string& help, const MetricLabels& labels = {});
+
+    /**
+     * Register a gauge sampled at scrape time
+     * @param owner Tag for remove_callbacks(), normally the object sample captures
+     * @param sample Called under the registry lock; return NaN to omit the series
+     * @throws std::logic_error if name is already registered with another type
+     */
+    void add_callback(const void* owner, const std::string& name, const std::string& help,
+                      const MetricLabels& labels, std::function<double()> sample);
+
+    /**
+     * Drop every callback registered by owner; once this returns none of
+     * them is running or will run again
+     */
+    void remove_callbacks(const void* owner);
+
+    /**
+     * All metrics in the Prometheus text exposition format, version 0.0.4
+     */
+    std::string render() const;
+
+private:
+    enum class MetricType { COUNTER, GAUGE, HISTOGRAM };
+
+    struct Series {
+        std::string labels;   // Rendered label set, without braces
+        std::unique_ptr<MetricCounter> counter;
+        std::unique_ptr<MetricGauge> gauge;
+        std::unique_ptr<LatencyHistogram> histogram;
+        const void* owner = nullptr;
+        std::function<double()> sample;
+    };
+
+    struct Family {
+        MetricType type;
+        std::string help;
+        std::vector<Series> series;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family> families_;
+
+    Series& find_or_add(const std::string& name, const std::string& help, MetricType type,
+                        const MetricLabels& labels);
+};
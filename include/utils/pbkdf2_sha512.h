@@ -0,0 +1,453 @@
+#pragma once
+
+#include "utils/host_device.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Reference PBKDF2-HMAC-SHA512 shared by the CPU and CUDA paths
+ *
+ * The HMAC ipad/opad midstates are computed once per password; every
+ * iteration after the first then costs exactly two SHA-512 compressions
+ * on fixed-shape 128-byte blocks. Nothing here allocates, so the same
+ * code runs inside CUDA kernels and on the host.
+ */
+
+#define PBKDF2_SHA512_ROUND_CONSTANTS { \
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL, \
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL, \
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL, \
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL, \
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL, \
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL, \
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL, \
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL, \
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL, \
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL, \
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL, \
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL, \
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL, \
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL, \
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL, \
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL, \
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL, \
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL, \
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL, \
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL  \
+}
+
+static const uint64_t SHA512_ROUND_CONSTANTS_HOST[80] = PBKDF2_SHA512_ROUND_CONSTANTS;
+#ifdef __CUDACC__
+static __constant__ uint64_t SHA512_ROUND_CONSTANTS_DEVICE[80] = PBKDF2_SHA512_ROUND_CONSTANTS;
+#endif
+
+// Padding words for a 64-byte message that follows one 128-byte HMAC pad
+// block, i.e. a total message length of 192 bytes
+static const uint64_t SHA512_PAD_WORD = 0x8000000000000000ULL;
+static const uint64_t SHA512_HMAC_DIGEST_BITS = (128 + 64) * 8;
+
+/**
+ * HMAC-SHA512 midstates after absorbing the key XOR ipad/opad blocks
+ */
+struct HMACSHA512State {
+    uint64_t inner[8];
+    uint64_t outer[8];
+};
+
+BTC_HOST_DEVICE inline uint64_t sha512_round_constant(int t) {
+#ifdef __CUDA_ARCH__
+    return SHA512_ROUND_CONSTANTS_DEVICE[t];
+#else
+    return SHA512_ROUND_CONSTANTS_HOST[t];
+#endif
+}
+
+BTC_HOST_DEVICE inline uint64_t sha512_rotr(uint64_t x, int n) {
+    return (x >> n) | (x << (64 - n));
+}
+
+BTC_HOST_DEVICE inline uint64_t sha512_load_be64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+BTC_HOST_DEVICE inline void sha512_store_be64(uint8_t* p, uint64_t v) {
+    for (int i = 7; i >= 0; i--) {
+        p[i] = static_cast<uint8_t>(v);
+        v >>= 8;
+    }
+}
+
+BTC_HOST_DEVICE inline void sha512_initial_state(uint64_t state[8]) {
+    state[0] = 0x6a09e667f3bcc908ULL;
+    state[1] = 0xbb67ae8584caa73bULL;
+    state[2] = 0x3c6ef372fe94f82bULL;
+    state[3] = 0xa54ff53a5f1d36f1ULL;
+    state[4] = 0x510e527fade682d1ULL;
+    state[5] = 0x9b05688c2b3e6c1fULL;
+    state[6] = 0x1f83d9abfb41bd6bULL;
+    state[7] = 0x5be0cd19137e2179ULL;
+}
+
+/**
+ * SHA-512 compression of one block of big-endian message words
+ * @param state Chaining state, updated in place
+ * @param w Message words (overwritten by the rolling schedule)
+ */
+BTC_HOST_DEVICE inline void sha512_compress(uint64_t state[8], uint64_t w[16]) {
+    uint64_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint64_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int t = 0; t < 80; t++) {
+        uint64_t wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            uint64_t w15 = w[(t - 15) & 15];
+            uint64_t w2 = w[(t - 2) & 15];
+            uint64_t s0 = sha512_rotr(w15, 1) ^ sha512_rotr(w15, 8) ^ (w15 >> 7);
+            uint64_t s1 = sha512_rotr(w2, 19) ^ sha512_rotr(w2, 61) ^ (w2 >> 6);
+            wt = w[t & 15] + s0 + w[(t - 7) & 15] + s1;
+            w[t & 15] = wt;
+        }
+
+        uint64_t big_s1 = sha512_rotr(e, 14) ^ sha512_rotr(e, 18) ^ sha512_rotr(e, 41);
+        uint64_t ch = ((f ^ g) & e) ^ g;
+        uint64_t t1 = h + big_s1 + ch + sha512_round_constant(t) + wt;
+        uint64_t big_s0 = sha512_rotr(a, 28) ^ sha512_rotr(a, 34) ^ sha512_rotr(a, 39);
+        uint64_t maj = (a & b) | (c & (a | b));
+        uint64_t t2 = big_s0 + maj;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+BTC_HOST_DEVICE inline void sha512_compress_bytes(uint64_t state[8], const uint8_t* block) {
+    uint64_t w[16];
+    for (int i = 0; i < 16; i++) {
+        w[i] = sha512_load_be64(block + i * 8);
+    }
+    sha512_compress(state, w);
+}
+
+/**
+ * Incremental SHA-512 that can resume from an HMAC pad midstate
+ */
+struct SHA512Stream {
+    uint64_t state[8];
+    uint8_t buffer[128];
+    uint32_t buffered;
+    uint64_t total_bytes;
+
+    BTC_HOST_DEVICE void reset() {
+        sha512_initial_state(state);
+        buffered = 0;
+        total_bytes = 0;
+    }
+
+    BTC_HOST_DEVICE void resume(const uint64_t midstate[8], uint64_t bytes_hashed) {
+        for (int i = 0; i < 8; i++) {
+            state[i] = midstate[i];
+        }
+        buffered = 0;
+        total_bytes = bytes_hashed;
+    }
+
+    BTC_HOST_DEVICE void update(const uint8_t* data, size_t length) {
+        total_bytes += length;
+        for (size_t i = 0; i < length; i++) {
+            buffer[buffered++] = data[i];
+            if (buffered == sizeof(buffer)) {
+                sha512_compress_bytes(state, buffer);
+                buffered = 0;
+            }
+        }
+    }
+
+    BTC_HOST_DEVICE void finish(uint64_t digest[8]) {
+        const uint64_t bit_length = total_bytes * 8;
+        buffer[buffered++] = 0x80;
+        if (buffered > 112) {
+            while (buffered < sizeof(buffer)) {
+                buffer[buffered++] = 0;
+            }
+            sha512_compress_bytes(state, buffer);
+            buffered = 0;
+        }
+        while (buffered < 120) {
+            buffer[buffered++] = 0;
+        }
+        sha512_store_be64(buffer + 120, bit_length);
+        sha512_compress_bytes(state, buffer);
+        for (int i = 0; i < 8; i++) {
+            digest[i] = state[i];
+        }
+    }
+};
+
+/**
+ * Compute the HMAC-SHA512 ipad/opad midstates for a key
+ * @param key Key bytes (the candidate password)
+ * @param key_length Key length; keys over 128 bytes are hashed first
+ * @param pads Output midstates
+ */
+BTC_HOST_DEVICE inline void hmac_sha512_precompute(const uint8_t* key, size_t key_length, HMACSHA512State& pads) {
+    uint8_t block[128];
+    for (int i = 0; i < 128; i++) {
+        block[i] = 0;
+    }
+
+    if (key_length > sizeof(block)) {
+        SHA512Stream stream;
+        uint64_t digest[8];
+        stream.reset();
+        stream.update(key, key_length);
+        stream.finish(digest);
+        for (int i = 0; i < 8; i++) {
+            sha512_store_be64(block + i * 8, digest[i]);
+        }
+    } else {
+        for (size_t i = 0; i < key_length; i++) {
+            block[i] = key[i];
+        }
+    }
+
+    uint64_t w[16];
+    for (int i = 0; i < 16; i++) {
+        w[i] = sha512_load_be64(block + i * 8) ^ 0x3636363636363636ULL;
+    }
+    sha512_initial_state(pads.inner);
+    sha512_compress(pads.inner, w);
+
+    for (int i = 0; i < 16; i++) {
+        w[i] = sha512_load_be64(block + i * 8) ^ 0x5c5c5c5c5c5c5c5cULL;
+    }
+    sha512_initial_state(pads.outer);
+    sha512_compress(pads.outer, w);
+}
+
+/**
+ * Finish an HMAC whose inner hash digest is known: H(opad || inner_digest)
+ */
+BTC_HOST_DEVICE inline void hmac_sha512_outer(const HMACSHA512State& pads, const uint64_t inner_digest[8],
+                                              uint64_t mac[8]) {
+    uint64_t w[16];
+    for (int i = 0; i < 8; i++) {
+        w[i] = inner_digest[i];
+        mac[i] = pads.outer[i];
+    }
+    w[8] = SHA512_PAD_WORD;
+    for (int i = 9; i < 15; i++) {
+        w[i] = 0;
+    }
+    w[15] = SHA512_HMAC_DIGEST_BITS;
+    sha512_compress(mac, w);
+}
+
+/**
+ * Compute U1 = HMAC(P, salt || INT(block_index))
+ * @param pads Password midstates
+ * @param salt Salt bytes
+ * @param salt_length Salt length
+ * @param block_index 1-based PBKDF2 block index
+ * @param u Output U1 words
+ */
+BTC_HOST_DEVICE inline void pbkdf2_sha512_first_block(const HMACSHA512State& pads,
+                                                      const uint8_t* salt, size_t salt_length,
+                                                      uint32_t block_index, uint64_t u[8]) {
+    const uint8_t index_bytes[4] = {
+        static_cast<uint8_t>(block_index >> 24), static_cast<uint8_t>(block_index >> 16),
+        static_cast<uint8_t>(block_index >> 8), static_cast<uint8_t>(block_index)
+    };
+
+    SHA512Stream stream;
+    stream.resume(pads.inner, 128);
+    stream.update(salt, salt_length);
+    stream.update(index_bytes, sizeof(index_bytes));
+    uint64_t inner_digest[8];
+    stream.finish(inner_digest);
+
+    hmac_sha512_outer(pads, inner_digest, u);
+}
+
+/**
+ * Longest salt whose first PBKDF2 inner block, salt || INT(i) plus
+ * padding, fits one SHA-512 block
+ */
+#define PBKDF2_SHA512_SHORT_SALT_MAX 107
+
+/**
+ * Message words of the first PBKDF2 inner block for a salt of at most
+ * PBKDF2_SHA512_SHORT_SALT_MAX bytes. They do not depend on the password,
+ * so a wallet's words are computed once and every candidate's U1 costs a
+ * single compression on them.
+ * @param salt Salt bytes
+ * @param salt_length Salt length
+ * @param block_index 1-based PBKDF2 block index
+ * @param words Output message words
+ */
+BTC_HOST_DEVICE inline void pbkdf2_sha512_salt_block(const uint8_t* salt, size_t salt_length, uint32_t block_index,
+                                                     uint64_t words[16]) {
+    uint8_t block[128];
+    for (int i = 0; i < 128; i++) {
+        block[i] = 0;
+    }
+    for (size_t i = 0; i < salt_length; i++) {
+        block[i] = salt[i];
+    }
+    block[salt_length] = static_cast<uint8_t>(block_index >> 24);
+    block[salt_length + 1] = static_cast<uint8_t>(block_index >> 16);
+    block[salt_length + 2] = static_cast<uint8_t>(block_index >> 8);
+    block[salt_length + 3] = static_cast<uint8_t>(block_index);
+    block[salt_length + 4] = 0x80;
+    for (int i = 0; i < 15; i++) {
+        words[i] = sha512_load_be64(block + i * 8);
+    }
+    words[15] = (128 + salt_length + 4) * 8;
+}
+
+/**
+ * Compute U1 from precomputed salt block words
+ * @param pads Password midstates
+ * @param salt_block Words from pbkdf2_sha512_salt_block()
+ * @param u Output U1 words
+ */
+BTC_HOST_DEVICE inline void pbkdf2_sha512_first_block_words(const HMACSHA512State& pads, const uint64_t salt_block[16],
+                                                            uint64_t u[8]) {
+    uint64_t w[16];
+    uint64_t inner_digest[8];
+    for (int i = 0; i < 16; i++) {
+        w[i] = salt_block[i];
+    }
+    for (int i = 0; i < 8; i++) {
+        inner_digest[i] = pads.inner[i];
+    }
+    sha512_compress(inner_digest, w);
+    hmac_sha512_outer(pads, inner_digest, u);
+}
+
+/**
+ * HMAC-SHA512 midstates for a key of at most MAX_LENGTH bytes
+ * The key is loaded straight into message words with no block buffer, and
+ * words past MAX_LENGTH are constant zero, so a kernel instantiated for a
+ * short length bucket keeps the whole key in registers.
+ * @param key Key bytes
+ * @param key_length Key length, at most MAX_LENGTH
+ * @param pads Output midstates
+ */
+template <size_t MAX_LENGTH>
+BTC_HOST_DEVICE inline void hmac_sha512_precompute_short(const uint8_t* key, size_t key_length,
+                                                         HMACSHA512State& pads) {
+    static_assert(MAX_LENGTH > 0 && MAX_LENGTH <= 128, "Short HMAC keys fit one SHA-512 block");
+    uint64_t key_words[16];
+    for (int i = 0; i < 16; i++) {
+        uint64_t v = 0;
+        for (int j = 0; j < 8; j++) {
+            const size_t at = (size_t)i * 8 + j;
+            v = (v << 8) | (at < MAX_LENGTH && at < key_length ? key[at] : 0);
+        }
+        key_words[i] = v;
+    }
+
+    uint64_t w[16];
+    for (int i = 0; i < 16; i++) {
+        w[i] = key_words[i] ^ 0x3636363636363636ULL;
+    }
+    sha512_initial_state(pads.inner);
+    sha512_compress(pads.inner, w);
+
+    for (int i = 0; i < 16; i++) {
+        w[i] = key_words[i] ^ 0x5c5c5c5c5c5c5c5cULL;
+    }
+    sha512_initial_state(pads.outer);
+    sha512_compress(pads.outer, w);
+}
+
+/**
+ * Run PBKDF2 iterations 2..N: U_j = HMAC(P, U_{j-1}), T ^= U_j
+ * @param pads Password midstates
+ * @param u Previous U block, updated to the last one computed
+ * @param t Running XOR of all U blocks
+ * @param rounds Number of additional iterations
+ */
+BTC_HOST_DEVICE inline void pbkdf2_sha512_iterate(const HMACSHA512State& pads, uint64_t u[8], uint64_t t[8],
+                                                  uint32_t rounds) {
+    for (uint32_t r = 0; r < rounds; r++) {
+        uint64_t w[16];
+        uint64_t inner_digest[8];
+        for (int i = 0; i < 8; i++) {
+            w[i] = u[i];
+            inner_digest[i] = pads.inner[i];
+        }
+        w[8] = SHA512_PAD_WORD;
+        for (int i = 9; i < 15; i++) {
+            w[i] = 0;
+        }
+        w[15] = SHA512_HMAC_DIGEST_BITS;
+        sha512_compress(inner_digest, w);
+
+        hmac_sha512_outer(pads, inner_digest, u);
+        for (int i = 0; i < 8; i++) {
+            t[i] ^= u[i];
+        }
+    }
+}
+
+/**
+ * Derive a key with PBKDF2-HMAC-SHA512
+ * @param password Password bytes
+ * @param password_length Password length
+ * @param salt Salt bytes
+ * @param salt_length Salt length
+ * @param iterations Iteration count (at least 1)
+ * @param derived_key Output buffer
+ * @param key_length Output length in bytes
+ */
+BTC_HOST_DEVICE inline void pbkdf2_hmac_sha512(const uint8_t* password, size_t password_length,
+                                               const uint8_t* salt, size_t salt_length,
+                                               uint32_t iterations,
+                                               uint8_t* derived_key, size_t key_length) {
+    HMACSHA512State pads;
+    hmac_sha512_precompute(password, password_length, pads);
+
+    for (uint32_t block = 1; key_length > 0; block++) {
+        uint64_t u[8], t[8];
+        pbkdf2_sha512_first_block(pads, salt, salt_length, block, u);
+        for (int i = 0; i < 8; i++) {
+            t[i] = u[i];
+        }
+        if (iterations > 1) {
+            pbkdf2_sha512_iterate(pads, u, t, iterations - 1);
+        }
+
+        uint8_t digest[64];
+        for (int i = 0; i < 8; i++) {
+            sha512_store_be64(digest + i * 8, t[i]);
+        }
+        const size_t take = key_length < 64 ? key_length : 64;
+        for (size_t i = 0; i < take; i++) {
+            derived_key[i] = digest[i];
+        }
+        derived_key += take;
+        key_length -= take;
+    }
+}
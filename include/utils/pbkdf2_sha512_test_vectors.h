@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Known-answer vectors for PBKDF2-HMAC-SHA512
+ *
+ * Shared by the unit tests and by the start-up self-test of the GPU
+ * backends, so every implementation is checked against the same data.
+ */
+struct PBKDF2SHA512TestVector {
+    const char* password;
+    const char* salt;
+    uint32_t iterations;
+    size_t key_length;
+    const char* expected_hex;
+};
+
+static const PBKDF2SHA512TestVector PBKDF2_SHA512_TEST_VECTORS[] = {
+    {"password", "salt", 1, 64,
+     "867f70cf1ade02cff3752599a3a53dc4af34c7a669815ae5d513554e1c8cf252"
+     "c02d470a285a0501bad999bfe943c08f050235d7d68b1da55e63f73b60a57fce"},
+    {"password", "salt", 2, 64,
+     "e1d9c16aa681708a45f5c7c4e215ceb66e011a2e9f0040713f18aefdb866d53c"
+     "f76cab2868a39b9f7840edce4fef5a82be67335c77a6068e04112754f27ccf4e"},
+    {"password", "salt", 4096, 64,
+     "d197b1b33db0143e018b12f3d1d1479e6cdebdcc97c5c0f87f6902e072f457b5"
+     "143f30602641b3d55cd335988cb36b84376060ecd532e039b742a239434af2d5"},
+    {"passwordPASSWORDpassword", "saltSALTsaltSALTsaltSALTsaltSALTsalt", 4096, 64,
+     "8c0511f4c6e597c6ac6315d8f0362e225f3c501495ba23b868c005174dc4ee71"
+     "115b59f9e60cd9532fa33e0f75aefe30225c583a186cd82bd4daea9724a3d3b8"},
+    // Bitcoin Core shape: 8-byte salt, 25000 iterations, 32-byte key
+    {"correct horse battery staple", "\x3e\x6f\x1a\x92\x05\xd4\x7b\xc8", 25000, 32,
+     "87e4f6d561c82e885eb9af7b6fdb7666532ac2e2db9e8b64e4e36fe2c444a47b"}
+};
+
+static const size_t PBKDF2_SHA512_TEST_VECTOR_COUNT =
+    sizeof(PBKDF2_SHA512_TEST_VECTORS) / sizeof(PBKDF2_SHA512_TEST_VECTORS[0]);
@@ -0,0 +1,441 @@
+#pragma once
+
+#include "utils/host_device.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Reference scrypt (RFC 7914) shared by the CPU and CUDA paths
+ *
+ * scrypt = PBKDF2-HMAC-SHA256 (1 iteration) to expand the password into p
+ * blocks of 128 * r bytes, ROMix on each block, and PBKDF2-HMAC-SHA256
+ * again with the mixed blocks as salt. ROMix dominates: it writes N blocks
+ * to a table V and reads them back in data-dependent order.
+ *
+ * ROMix takes a lookup gap g: only every g-th entry of V is stored and the
+ * others are recomputed from the nearest stored one when read. Memory per
+ * lane falls to 1/g for roughly (g - 1) / 2 extra BlockMix calls per read,
+ * which lets a GPU keep far more lanes resident than full 16 MB tables
+ * would allow. Nothing here allocates.
+ */
+
+struct ScryptParams {
+    uint32_t N;   // CPU/memory cost, a power of two
+    uint32_t r;   // Block size factor
+    uint32_t p;   // Parallelisation factor
+};
+
+// BIP38 fixes the parameters for every encrypted key
+static const ScryptParams SCRYPT_BIP38_PARAMS = {16384, 8, 8};
+
+/**
+ * Check parameters against RFC 7914 limits
+ * @return true if N is a power of two above 1 and p * r < 2^30
+ */
+BTC_HOST_DEVICE inline bool scrypt_params_valid(const ScryptParams& params) {
+    return params.N > 1 && (params.N & (params.N - 1)) == 0 && params.r > 0 && params.p > 0 &&
+           static_cast<uint64_t>(params.r) * params.p < (1ULL << 30);
+}
+
+/**
+ * 32-bit words in one ROMix block (128 * r bytes)
+ */
+BTC_HOST_DEVICE inline size_t scrypt_block_words(uint32_t r) {
+    return 32 * static_cast<size_t>(r);
+}
+
+/**
+ * Stored V entries with the given lookup gap
+ */
+BTC_HOST_DEVICE inline size_t scrypt_table_entries(uint32_t N, uint32_t lookup_gap) {
+    return (N + lookup_gap - 1) / lookup_gap;
+}
+
+/**
+ * Scratch words scrypt_romix needs: the V table plus two working blocks
+ */
+BTC_HOST_DEVICE inline size_t scrypt_scratch_words(const ScryptParams& params, uint32_t lookup_gap) {
+    return (scrypt_table_entries(params.N, lookup_gap) + 2) * scrypt_block_words(params.r);
+}
+
+#define SCRYPT_SHA256_ROUND_CONSTANTS { \
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5, \
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, \
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, \
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, \
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, \
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, \
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3, \
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2  \
+}
+
+static const uint32_t SHA256_ROUND_CONSTANTS_HOST[64] = SCRYPT_SHA256_ROUND_CONSTANTS;
+#ifdef __CUDACC__
+static __constant__ uint32_t SHA256_ROUND_CONSTANTS_DEVICE[64] = SCRYPT_SHA256_ROUND_CONSTANTS;
+#endif
+
+BTC_HOST_DEVICE inline uint32_t sha256_round_constant(int t) {
+#ifdef __CUDA_ARCH__
+    return SHA256_ROUND_CONSTANTS_DEVICE[t];
+#else
+    return SHA256_ROUND_CONSTANTS_HOST[t];
+#endif
+}
+
+BTC_HOST_DEVICE inline uint32_t scrypt_rotr32(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+BTC_HOST_DEVICE inline uint32_t scrypt_rotl32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+BTC_HOST_DEVICE inline uint32_t scrypt_load_le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+BTC_HOST_DEVICE inline void scrypt_store_le32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+/**
+ * SHA-256 compression of one block already loaded as big-endian words
+ * @param state Chaining state, updated in place
+ * @param w Message words (overwritten by the schedule)
+ */
+BTC_HOST_DEVICE inline void sha256_compress_words(uint32_t state[8], uint32_t w[16]) {
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int t = 0; t < 64; t++) {
+        uint32_t wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            uint32_t w15 = w[(t - 15) & 15];
+            uint32_t w2 = w[(t - 2) & 15];
+            uint32_t s0 = scrypt_rotr32(w15, 7) ^ scrypt_rotr32(w15, 18) ^ (w15 >> 3);
+            uint32_t s1 = scrypt_rotr32(w2, 17) ^ scrypt_rotr32(w2, 19) ^ (w2 >> 10);
+            wt = w[t & 15] + s0 + w[(t - 7) & 15] + s1;
+            w[t & 15] = wt;
+        }
+
+        uint32_t big_s1 = scrypt_rotr32(e, 6) ^ scrypt_rotr32(e, 11) ^ scrypt_rotr32(e, 25);
+        uint32_t ch = ((f ^ g) & e) ^ g;
+        uint32_t t1 = h + big_s1 + ch + sha256_round_constant(t) + wt;
+        uint32_t big_s0 = scrypt_rotr32(a, 2) ^ scrypt_rotr32(a, 13) ^ scrypt_rotr32(a, 22);
+        uint32_t maj = (a & b) | (c & (a | b));
+        uint32_t t2 = big_s0 + maj;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+/**
+ * SHA-256 compression of one 64-byte block
+ * @param state Chaining state, updated in place
+ * @param block Message block
+ */
+BTC_HOST_DEVICE inline void sha256_compress(uint32_t state[8], const uint8_t block[64]) {
+    uint32_t w[16];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) | (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+               (static_cast<uint32_t>(block[i * 4 + 2]) << 8) | static_cast<uint32_t>(block[i * 4 + 3]);
+    }
+    sha256_compress_words(state, w);
+}
+
+/**
+ * Streaming SHA-256 for the variable-length HMAC inputs of scrypt
+ */
+struct SHA256Context {
+    uint32_t state[8];
+    uint8_t block[64];
+    uint32_t used;
+    uint64_t total;
+};
+
+BTC_HOST_DEVICE inline void sha256_init(SHA256Context& ctx) {
+    ctx.state[0] = 0x6a09e667; ctx.state[1] = 0xbb67ae85; ctx.state[2] = 0x3c6ef372; ctx.state[3] = 0xa54ff53a;
+    ctx.state[4] = 0x510e527f; ctx.state[5] = 0x9b05688c; ctx.state[6] = 0x1f83d9ab; ctx.state[7] = 0x5be0cd19;
+    ctx.used = 0;
+    ctx.total = 0;
+}
+
+BTC_HOST_DEVICE inline void sha256_update(SHA256Context& ctx, const uint8_t* data, size_t length) {
+    ctx.total += length;
+    for (size_t i = 0; i < length; i++) {
+        ctx.block[ctx.used++] = data[i];
+        if (ctx.used == 64) {
+            sha256_compress(ctx.state, ctx.block);
+            ctx.used = 0;
+        }
+    }
+}
+
+BTC_HOST_DEVICE inline void sha256_final(SHA256Context& ctx, uint8_t digest[32]) {
+    const uint64_t bits = ctx.total * 8;
+    const uint8_t pad = 0x80;
+    const uint8_t zero = 0;
+    sha256_update(ctx, &pad, 1);
+    while (ctx.used != 56) {
+        sha256_update(ctx, &zero, 1);
+    }
+    uint8_t length[8];
+    for (int i = 0; i < 8; i++) {
+        length[i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+    }
+    sha256_update(ctx, length, 8);
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4] = static_cast<uint8_t>(ctx.state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(ctx.state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(ctx.state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(ctx.state[i]);
+    }
+}
+
+/**
+ * PBKDF2-HMAC-SHA256, as scrypt uses it before and after ROMix
+ * @param password Password bytes (the HMAC key)
+ * @param password_length Password length
+ * @param salt Salt bytes
+ * @param salt_length Salt length
+ * @param iterations Iteration count, 1 for scrypt
+ * @param derived_key Output buffer
+ * @param key_length Bytes to derive
+ */
+BTC_HOST_DEVICE inline void pbkdf2_hmac_sha256(const uint8_t* password, size_t password_length,
+                                               const uint8_t* salt, size_t salt_length, uint32_t iterations,
+                                               uint8_t* derived_key, size_t key_length) {
+    uint8_t key[64] = {0};
+    if (password_length > 64) {
+        SHA256Context ctx;
+        sha256_init(ctx);
+        sha256_update(ctx, password, password_length);
+        sha256_final(ctx, key);
+    } else {
+        for (size_t i = 0; i < password_length; i++) {
+            key[i] = password[i];
+        }
+    }
+
+    uint8_t pad[64];
+    SHA256Context inner;
+    SHA256Context outer;
+    for (int i = 0; i < 64; i++) {
+        pad[i] = key[i] ^ 0x36;
+    }
+    sha256_init(inner);
+    sha256_update(inner, pad, 64);
+    for (int i = 0; i < 64; i++) {
+        pad[i] = key[i] ^ 0x5c;
+    }
+    sha256_init(outer);
+    sha256_update(outer, pad, 64);
+
+    for (uint32_t block = 1; key_length > 0; block++) {
+        const uint8_t index[4] = {static_cast<uint8_t>(block >> 24), static_cast<uint8_t>(block >> 16),
+                                  static_cast<uint8_t>(block >> 8), static_cast<uint8_t>(block)};
+        uint8_t u[32];
+        SHA256Context ctx = inner;
+        sha256_update(ctx, salt, salt_length);
+        sha256_update(ctx, index, 4);
+        sha256_final(ctx, u);
+        ctx = outer;
+        sha256_update(ctx, u, 32);
+        sha256_final(ctx, u);
+
+        uint8_t t[32];
+        for (int i = 0; i < 32; i++) {
+            t[i] = u[i];
+        }
+        for (uint32_t iteration = 1; iteration < iterations; iteration++) {
+            ctx = inner;
+            sha256_update(ctx, u, 32);
+            sha256_final(ctx, u);
+            ctx = outer;
+            sha256_update(ctx, u, 32);
+            sha256_final(ctx, u);
+            for (int i = 0; i < 32; i++) {
+                t[i] ^= u[i];
+            }
+        }
+
+        const size_t take = key_length < 32 ? key_length : 32;
+        for (size_t i = 0; i < take; i++) {
+            derived_key[i] = t[i];
+        }
+        derived_key += take;
+        key_length -= take;
+    }
+}
+
+/**
+ * Salsa20/8 core on one 64-byte block of little-endian words
+ */
+BTC_HOST_DEVICE inline void scrypt_salsa20_8(uint32_t b[16]) {
+    uint32_t x[16];
+    for (int i = 0; i < 16; i++) {
+        x[i] = b[i];
+    }
+    for (int round = 0; round < 8; round += 2) {
+        // Columns
+        x[4] ^= scrypt_rotl32(x[0] + x[12], 7);   x[8] ^= scrypt_rotl32(x[4] + x[0], 9);
+        x[12] ^= scrypt_rotl32(x[8] + x[4], 13);  x[0] ^= scrypt_rotl32(x[12] + x[8], 18);
+        x[9] ^= scrypt_rotl32(x[5] + x[1], 7);    x[13] ^= scrypt_rotl32(x[9] + x[5], 9);
+        x[1] ^= scrypt_rotl32(x[13] + x[9], 13);  x[5] ^= scrypt_rotl32(x[1] + x[13], 18);
+        x[14] ^= scrypt_rotl32(x[10] + x[6], 7);  x[2] ^= scrypt_rotl32(x[14] + x[10], 9);
+        x[6] ^= scrypt_rotl32(x[2] + x[14], 13);  x[10] ^= scrypt_rotl32(x[6] + x[2], 18);
+        x[3] ^= scrypt_rotl32(x[15] + x[11], 7);  x[7] ^= scrypt_rotl32(x[3] + x[15], 9);
+        x[11] ^= scrypt_rotl32(x[7] + x[3], 13);  x[15] ^= scrypt_rotl32(x[11] + x[7], 18);
+        // Rows
+        x[1] ^= scrypt_rotl32(x[0] + x[3], 7);    x[2] ^= scrypt_rotl32(x[1] + x[0], 9);
+        x[3] ^= scrypt_rotl32(x[2] + x[1], 13);   x[0] ^= scrypt_rotl32(x[3] + x[2], 18);
+        x[6] ^= scrypt_rotl32(x[5] + x[4], 7);    x[7] ^= scrypt_rotl32(x[6] + x[5], 9);
+        x[4] ^= scrypt_rotl32(x[7] + x[6], 13);   x[5] ^= scrypt_rotl32(x[4] + x[7], 18);
+        x[11] ^= scrypt_rotl32(x[10] + x[9], 7);  x[8] ^= scrypt_rotl32(x[11] + x[10], 9);
+        x[9] ^= scrypt_rotl32(x[8] + x[11], 13);  x[10] ^= scrypt_rotl32(x[9] + x[8], 18);
+        x[12] ^= scrypt_rotl32(x[15] + x[14], 7); x[13] ^= scrypt_rotl32(x[12] + x[15], 9);
+        x[14] ^= scrypt_rotl32(x[13] + x[12], 13); x[15] ^= scrypt_rotl32(x[14] + x[13], 18);
+    }
+    for (int i = 0; i < 16; i++) {
+        b[i] += x[i];
+    }
+}
+
+/**
+ * BlockMix-Salsa20/8: out = BlockMix(in), 32 * r words each, no overlap
+ */
+BTC_HOST_DEVICE inline void scrypt_block_mix(const uint32_t* in, uint32_t* out, uint32_t r) {
+    uint32_t x[16];
+    const uint32_t* last = in + (2 * r - 1) * 16;
+    for (int i = 0; i < 16; i++) {
+        x[i] = last[i];
+    }
+    for (uint32_t i = 0; i < 2 * r; i++) {
+        const uint32_t* block = in + i * 16;
+        for (int k = 0; k < 16; k++) {
+            x[k] ^= block[k];
+        }
+        scrypt_salsa20_8(x);
+        // Even blocks go to the first half of the output, odd ones to the second
+        uint32_t* target = out + ((i >> 1) + (i & 1) * r) * 16;
+        for (int k = 0; k < 16; k++) {
+            target[k] = x[k];
+        }
+    }
+}
+
+/**
+ * ROMix with a lookup gap
+ * @param x Block to mix in place, 32 * r little-endian words
+ * @param scratch scrypt_scratch_words(params, lookup_gap) words
+ * @param N Cost parameter
+ * @param r Block size factor
+ * @param lookup_gap Store every lookup_gap-th V entry (1 = the full table)
+ */
+BTC_HOST_DEVICE inline void scrypt_romix(uint32_t* x, uint32_t* scratch, uint32_t N, uint32_t r,
+                                         uint32_t lookup_gap) {
+    const size_t words = scrypt_block_words(r);
+    uint32_t* v = scratch;
+    uint32_t* t = v + scrypt_table_entries(N, lookup_gap) * words;
+    uint32_t* u = t + words;
+
+    for (uint32_t i = 0; i < N; i++) {
+        if (i % lookup_gap == 0) {
+            uint32_t* entry = v + (i / lookup_gap) * words;
+            for (size_t k = 0; k < words; k++) {
+                entry[k] = x[k];
+            }
+        }
+        scrypt_block_mix(x, t, r);
+        for (size_t k = 0; k < words; k++) {
+            x[k] = t[k];
+        }
+    }
+
+    for (uint32_t i = 0; i < N; i++) {
+        const uint32_t j = x[(2 * r - 1) * 16] & (N - 1);
+        const uint32_t* entry = v + (j / lookup_gap) * words;
+
+        // Rebuild V[j] from the stored entry before it
+        const uint32_t steps = j % lookup_gap;
+        if (steps > 0) {
+            for (size_t k = 0; k < words; k++) {
+                t[k] = entry[k];
+            }
+            for (uint32_t s = 0; s < steps; s++) {
+                scrypt_block_mix(t, u, r);
+                for (size_t k = 0; k < words; k++) {
+                    t[k] = u[k];
+                }
+            }
+            entry = t;
+        }
+
+        for (size_t k = 0; k < words; k++) {
+            x[k] ^= entry[k];
+        }
+        scrypt_block_mix(x, u, r);
+        for (size_t k = 0; k < words; k++) {
+            x[k] = u[k];
+        }
+    }
+}
+
+/**
+ * Convert one lane of expanded bytes to ROMix words and back
+ */
+BTC_HOST_DEVICE inline void scrypt_bytes_to_words(const uint8_t* bytes, uint32_t* words, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        words[i] = scrypt_load_le32(bytes + i * 4);
+    }
+}
+
+BTC_HOST_DEVICE inline void scrypt_words_to_bytes(const uint32_t* words, uint8_t* bytes, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        scrypt_store_le32(bytes + i * 4, words[i]);
+    }
+}
+
+/**
+ * Full scrypt derivation, one lane after another
+ * @param password Password bytes
+ * @param password_length Password length
+ * @param salt Salt bytes
+ * @param salt_length Salt length
+ * @param params Cost parameters
+ * @param derived_key Output buffer
+ * @param key_length Bytes to derive
+ * @param blocks p * 128 * r bytes for the expanded password
+ * @param scratch scrypt_scratch_words(params, lookup_gap) + 32 * r words
+ * @param lookup_gap ROMix lookup gap
+ */
+BTC_HOST_DEVICE inline void scrypt_derive(const uint8_t* password, size_t password_length,
+                                          const uint8_t* salt, size_t salt_length, const ScryptParams& params,
+                                          uint8_t* derived_key, size_t key_length,
+                                          uint8_t* blocks, uint32_t* scratch, uint32_t lookup_gap) {
+    const size_t words = scrypt_block_words(params.r);
+    const size_t lane_bytes = words * 4;
+    uint32_t* x = scratch + scrypt_scratch_words(params, lookup_gap);
+
+    pbkdf2_hmac_sha256(password, password_length, salt, salt_length, 1, blocks, params.p * lane_bytes);
+    for (uint32_t lane = 0; lane < params.p; lane++) {
+        scrypt_bytes_to_words(blocks + lane * lane_bytes, x, words);
+        scrypt_romix(x, scratch, params.N, params.r, lookup_gap);
+        scrypt_words_to_bytes(x, blocks + lane * lane_bytes, words);
+    }
+    pbkdf2_hmac_sha256(password, password_length, blocks, params.p * lane_bytes, 1, derived_key, key_length);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "utils/scrypt.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Lookup gap and lane count for running scrypt in a fixed memory budget
+ */
+struct ScryptTmtoPlan {
+    uint32_t lookup_gap = 1;
+    size_t lanes = 0;            // ROMix lanes resident at once, 0 if even one does not fit
+    size_t bytes_per_lane = 0;   // Stored V entries of one lane
+};
+
+/**
+ * Choose the lookup gap that maximises ROMix throughput in a memory budget
+ *
+ * A device keeps min(target_lanes, budget / bytes_per_lane) lanes busy,
+ * and each lane costs 2N BlockMix calls plus about N * (gap - 1) / 2 to
+ * rebuild the entries it did not store. The gap with the best ratio wins,
+ * so a card that already fits target_lanes full tables keeps gap 1.
+ * @param params scrypt parameters
+ * @param memory_budget Bytes available for V tables
+ * @param target_lanes Lanes needed to saturate the device
+ * @param max_gap Largest gap considered
+ * @return plan, lanes 0 if nothing fits
+ */
+ScryptTmtoPlan scrypt_plan_tmto(const ScryptParams& params, size_t memory_budget, size_t target_lanes,
+                                uint32_t max_gap = 64);
+
+/**
+ * Multi-threaded CPU scrypt
+ *
+ * Each thread owns a scratch arena for one full V table, allocated on the
+ * first derive() and reused for every later batch. Work is split per ROMix
+ * lane, so the p lanes of one BIP38 candidate run on p threads. On x86-64
+ * BlockMix runs on SSE2 registers with the Salsa20/8 state kept in the
+ * diagonal order that makes every quarter-round a vector operation.
+ */
+class ScryptEngine {
+public:
+    /**
+     * @param params scrypt parameters
+     * @param threads Worker threads, 0 = one per hardware thread
+     * @param use_simd Use the SSE2 BlockMix when the build has it
+     */
+    explicit ScryptEngine(const ScryptParams& params, size_t threads = 0, bool use_simd = true);
+    ~ScryptEngine();
+
+    ScryptEngine(const ScryptEngine&) = delete;
+    ScryptEngine& operator=(const ScryptEngine&) = delete;
+
+    /**
+     * Check whether this build has the SSE2 BlockMix
+     */
+    static bool has_simd();
+
+    /**
+     * Derive keys for a batch of passwords
+     * @param passwords Array of password pointers
+     * @param lengths Array of password lengths
+     * @param count Number of passwords
+     * @param salt Salt bytes
+     * @param salt_length Salt length
+     * @param derived_keys Output buffer of count * key_length bytes
+     * @param key_length Derived key length per password
+     * @return true if successful, false on invalid parameters or allocation failure
+     */
+    bool derive(const uint8_t* const* passwords, const size_t* lengths, size_t count,
+                const uint8_t* salt, size_t salt_length, uint8_t* derived_keys, size_t key_length);
+
+    const ScryptParams& get_params() const { return params_; }
+    size_t get_thread_count() const { return thread_count_; }
+    bool uses_simd() const { return use_simd_; }
+    const std::string& get_last_error() const { return last_error_; }
+
+private:
+    struct ArenaDeleter {
+        void operator()(uint32_t* arena) const;
+    };
+    using Arena = std::unique_ptr<uint32_t[], ArenaDeleter>;
+
+    ScryptParams params_;
+    size_t thread_count_;
+    bool use_simd_;
+    std::vector<Arena> arenas_;
+    std::vector<uint8_t> blocks_;   // Expanded passwords, p lanes of 128 * r bytes each
+    std::string last_error_;
+
+    bool allocate_arenas();
+    void mix_lane(uint8_t* lane, uint32_t* arena) const;
+};
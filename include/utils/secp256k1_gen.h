@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * secp256k1 public key derivation by fixed-base multiplication
+ *
+ * k*G is assembled from a precomputed table of i * 16^w * G for every 4-bit
+ * window w, so a key costs at most 64 mixed additions and one field
+ * inversion with no doublings. The table (64 x 16 affine points, about
+ * 64 KB) is built once on first use and shared by all threads.
+ *
+ * The multiplication is not constant time; it is meant for deriving the
+ * addresses of keys already recovered on the local machine.
+ */
+class Secp256k1Gen {
+public:
+    static constexpr size_t PRIVATE_KEY_SIZE = 32;
+    static constexpr size_t UNCOMPRESSED_SIZE = 65;
+    static constexpr size_t COMPRESSED_SIZE = 33;
+
+    /**
+     * Derive the uncompressed public key (0x04 || X || Y)
+     * @param private_key 32-byte big-endian scalar
+     * @param public_key Output, 65 bytes
+     * @return false if the scalar is zero or not below the group order
+     */
+    static bool derive_public_key(const uint8_t* private_key, uint8_t* public_key);
+
+    /**
+     * Compress an uncompressed public key
+     * @param uncompressed 65-byte public key
+     * @param compressed Output, 33 bytes
+     */
+    static void compress(const uint8_t* uncompressed, uint8_t* compressed);
+
+    /**
+     * Build the multiplication table now instead of on the first derivation
+     */
+    static void precompute();
+};
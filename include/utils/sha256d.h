@@ -0,0 +1,99 @@
+#pragma once
+
+#include "utils/host_device.h"
+#include "utils/scrypt.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Double SHA-256 shared by the CPU and CUDA paths
+ *
+ * A message of up to SHA256D_SHORT_MAX bytes fits one padded block, so
+ * its double hash is exactly two compressions: the message block, then the
+ * 32-byte digest padded into a block of its own. sha256d_short_words()
+ * runs that fast path straight from message words; sha256d() handles any
+ * length.
+ */
+#define SHA256D_SHORT_MAX 55
+
+// Padding of the second block: 0x80 after the 32-byte digest, 256 bits long
+#define SHA256D_DIGEST_PAD_WORD 0x80000000u
+#define SHA256D_DIGEST_BITS 256u
+
+BTC_HOST_DEVICE inline void sha256_initial_state(uint32_t state[8]) {
+    state[0] = 0x6a09e667; state[1] = 0xbb67ae85; state[2] = 0x3c6ef372; state[3] = 0xa54ff53a;
+    state[4] = 0x510e527f; state[5] = 0x9b05688c; state[6] = 0x1f83d9ab; state[7] = 0x5be0cd19;
+}
+
+/**
+ * Load a short message into one padded SHA-256 block
+ * @param message Message bytes
+ * @param length Message length, at most SHA256D_SHORT_MAX
+ * @param w Output block as big-endian words
+ */
+BTC_HOST_DEVICE inline void sha256_pad_short(const uint8_t* message, size_t length, uint32_t w[16]) {
+    for (int i = 0; i < 16; i++) {
+        w[i] = 0;
+    }
+    for (size_t i = 0; i < length; i++) {
+        w[i >> 2] |= static_cast<uint32_t>(message[i]) << (24 - 8 * (i & 3));
+    }
+    w[length >> 2] |= 0x80u << (24 - 8 * (length & 3));
+    w[15] = static_cast<uint32_t>(length * 8);
+}
+
+/**
+ * Double SHA-256 of a message already padded into one block
+ * @param w Padded message block, overwritten
+ * @param digest Output state words of the second hash
+ */
+BTC_HOST_DEVICE inline void sha256d_short_words(uint32_t w[16], uint32_t digest[8]) {
+    uint32_t state[8];
+    sha256_initial_state(state);
+    sha256_compress_words(state, w);
+
+    for (int i = 0; i < 8; i++) {
+        w[i] = state[i];
+    }
+    w[8] = SHA256D_DIGEST_PAD_WORD;
+    for (int i = 9; i < 15; i++) {
+        w[i] = 0;
+    }
+    w[15] = SHA256D_DIGEST_BITS;
+    sha256_initial_state(digest);
+    sha256_compress_words(digest, w);
+}
+
+BTC_HOST_DEVICE inline void sha256_store_digest(const uint32_t state[8], uint8_t digest[32]) {
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4] = static_cast<uint8_t>(state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(state[i]);
+    }
+}
+
+/**
+ * SHA-256(SHA-256(message))
+ * @param message Message bytes
+ * @param length Message length
+ * @param digest Output, 32 bytes
+ */
+BTC_HOST_DEVICE inline void sha256d(const uint8_t* message, size_t length, uint8_t digest[32]) {
+    if (length <= SHA256D_SHORT_MAX) {
+        uint32_t w[16], state[8];
+        sha256_pad_short(message, length, w);
+        sha256d_short_words(w, state);
+        sha256_store_digest(state, digest);
+        return;
+    }
+
+    uint8_t inner[32];
+    SHA256Context ctx;
+    sha256_init(ctx);
+    sha256_update(ctx, message, length);
+    sha256_final(ctx, inner);
+    sha256_init(ctx);
+    sha256_update(ctx, inner, sizeof(inner));
+    sha256_final(ctx, digest);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "utils/sha512_multibuffer.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Multi-buffer double SHA-256 engine
+ *
+ * Hashes several candidate passwords per call by running one SHA-256
+ * compression per 32-bit SIMD lane (8 lanes with AVX2, 16 with AVX-512),
+ * two compressions per candidate. Candidates longer than
+ * SHA256D_SHORT_MAX bytes need more than one block and are hashed on
+ * the scalar path between the vector calls. The instruction set is the
+ * one the SHA-512 engine detected for this CPU and build.
+ */
+class SHA256dMultiBuffer {
+public:
+    static constexpr size_t MAX_LANES = 16;
+
+    /**
+     * Get the number of candidates hashed per kernel call
+     * @param level SIMD level
+     * @return lane count
+     */
+    static size_t get_lane_count(SIMDLevel level);
+
+    /**
+     * Double-hash a batch of messages
+     * @param messages Array of message pointers
+     * @param lengths Array of message lengths
+     * @param count Number of messages
+     * @param digests Output buffer of count * 32 bytes
+     * @param level SIMD level to run with
+     */
+    static void sha256d(const uint8_t* const* messages, const size_t* lengths, size_t count,
+                        uint8_t* digests, SIMDLevel level);
+
+    /**
+     * Double-hash a batch of messages using the active SIMD level
+     */
+    static void sha256d(const uint8_t* const* messages, const size_t* lengths, size_t count, uint8_t* digests) {
+        sha256d(messages, lengths, count, digests, SHA512MultiBuffer::get_active_level());
+    }
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * SIMD instruction sets supported by the multi-buffer SHA-512 kernels
+ */
+enum class SIMDLevel {
+    SCALAR,
+    AVX2,
+    AVX512
+};
+
+/**
+ * Multi-buffer PBKDF2-HMAC-SHA512 engine
+ *
+ * Derives keys for several candidate passwords per call by running one
+ * SHA-512 compression per SIMD lane (4 lanes with AVX2, 8 with AVX-512).
+ * The instruction set is picked at runtime from the host CPU capabilities.
+ */
+class SHA512MultiBuffer {
+public:
+    static constexpr size_t MAX_LANES = 8;
+
+    /**
+     * Detect the widest SIMD level supported by this CPU and build
+     * @return detected SIMD level
+     */
+    static SIMDLevel detect_simd_level();
+
+    /**
+     * Get the SIMD level used by default (detected once and cached)
+     * @return active SIMD level
+     */
+    static SIMDLevel get_active_level();
+
+    /**
+     * Get the number of candidates processed per kernel call
+     * @param level SIMD level
+     * @return lane count
+     */
+    static size_t get_lane_count(SIMDLevel level);
+
+    /**
+     * Convert SIMD level to a printable name
+     * @param level SIMD level
+     * @return level name
+     */
+    static std::string simd_level_to_string(SIMDLevel level);
+
+    /**
+     * Derive PBKDF2-HMAC-SHA512 keys for a batch of passwords
+     * @param passwords Array of password pointers
+     * @param lengths Array of password lengths
+     * @param count Number of passwords
+     * @param salt Salt bytes
+     * @param salt_length Salt length
+     * @param iterations PBKDF2 iteration count
+     * @param derived_keys Output buffer of count * key_length bytes
+     * @param key_length Derived key length per password
+     * @param level SIMD level to run with
+     */
+    static void pbkdf2_hmac_sha512(const uint8_t* const* passwords, const size_t* lengths, size_t count,
+                                   const uint8_t* salt, size_t salt_length, uint32_t iterations,
+                                   uint8_t* derived_keys, size_t key_length, SIMDLevel level);
+
+    /**
+     * Derive PBKDF2-HMAC-SHA512 keys using the active SIMD level
+     */
+    static void pbkdf2_hmac_sha512(const uint8_t* const* passwords, const size_t* lengths, size_t count,
+                                   const uint8_t* salt, size_t salt_length, uint32_t iterations,
+                                   uint8_t* derived_keys, size_t key_length) {
+        pbkdf2_hmac_sha512(passwords, lengths, count, salt, salt_length, iterations,
+                           derived_keys, key_length, get_active_level());
+    }
+};
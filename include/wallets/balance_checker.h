@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Blockchain API providers understood by BalanceChecker
+ */
+enum class BalanceProviderType {
+    BLOCKSTREAM,   // Esplora: one address per request
+    BLOCKCHAIR,    // dashboards/addresses batches up to 100 addresses
+    BLOCKCYPHER    // addrs/a;b;c/balance batches (3 without a token)
+};
+
+/**
+ * One API endpoint and the limits it should be queried under
+ */
+struct BalanceProvider {
+    BalanceProviderType type;
+    std::string name;
+    std::string endpoint;
+    std::string api_key;
+    double requests_per_second;   // Sustained token-bucket refill rate
+    double burst;                 // Bucket capacity
+    size_t batch_size;            // Addresses per request
+    long max_connections;         // Concurrent keep-alive connections to this host
+};
+
+/**
+ * Balance lookup result for one address
+ */
+struct BalanceResult {
+    bool success = false;
+    uint64_t balance_satoshis = 0;
+    int transaction_count = 0;
+    std::string provider;         // Provider that answered
+};
+
+/**
+ * Concurrent balance checker over a single curl multi handle
+ *
+ * Requests to every provider are in flight at once, each provider behind its
+ * own token bucket. TLS connections stay open in the multi handle's cache and
+ * are reused across requests, and batch endpoints are used where available.
+ * A failed request or an unparseable body sends its addresses back to the
+ * queue for the next provider that has not tried them. A rate-limit response
+ * also sends them back, but leaves the provider free to take them again once
+ * its back-off has passed.
+ */
+class BalanceChecker {
+public:
+    BalanceChecker();
+    ~BalanceChecker();
+
+    BalanceChecker(const BalanceChecker&) = delete;
+    BalanceChecker& operator=(const BalanceChecker&) = delete;
+
+    /**
+     * Register a provider; earlier providers are preferred
+     */
+    void add_provider(const BalanceProvider& provider);
+
+    /**
+     * Default limits for a provider type
+     * @param type Provider type
+     * @param name Provider name used in logs and results
+     * @param endpoint Base URL
+     * @param api_key Optional API key
+     * @return provider description with conservative free-tier limits
+     */
+    static BalanceProvider default_provider(BalanceProviderType type, const std::string& name,
+                                            const std::string& endpoint, const std::string& api_key = "");
+
+    /**
+     * Per-request timeout
+     */
+    void set_timeout(std::chrono::seconds timeout) { timeout_ = timeout; }
+
+    /**
+     * Look up all addresses
+     * @param addresses Addresses to query
+     * @param results Output, one entry per address in the same order
+     * @return number of addresses that were answered by some provider
+     */
+    size_t check(const std::vector<std::string>& addresses, std::vector<BalanceResult>& results);
+
+private:
+    struct ProviderState;
+    struct Request;
+
+    std::vector<ProviderState> providers_;
+    std::chrono::seconds timeout_;
+    void* multi_;                 // CURLM*, kept opaque so the header does not pull in curl
+    std::vector<void*> idle_handles_;
+
+    void* acquire_handle();
+    void release_handle(void* handle);
+    bool start_request(size_t provider_index, std::vector<size_t> address_indices,
+                       const std::vector<std::string>& addresses, std::vector<Request*>& in_flight);
+    static bool parse_response(const ProviderState& provider, const std::string& body,
+                               const std::vector<std::string>& addresses,
+                               const std::vector<size_t>& address_indices,
+                               std::vector<BalanceResult>& results);
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "utils/host_device.h"
+#include "utils/aes256_block.h"
+#include "utils/pbkdf2_sha512.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Fixed-size Bitcoin Core master-key verification record
+ *
+ * Holds only what is needed to accept or reject a password: the KDF salt
+ * and iteration count, and the last two ciphertext blocks of the encrypted
+ * master key. It is plain data so it can be copied into CUDA constant
+ * memory or passed through the C interface unchanged.
+ */
+#define BITCOIN_CORE_MKEY_MAX_SALT 64
+
+struct BitcoinCoreMKeyCheck {
+    uint8_t salt[BITCOIN_CORE_MKEY_MAX_SALT];
+    uint32_t salt_length;
+    uint32_t iterations;
+    uint8_t previous_block[16];  // Ciphertext block before the last one (or the IV)
+    uint8_t last_block[16];
+    uint8_t expected_padding;    // PKCS#7 pad length implied by a 32-byte master key, 0 if unknown
+    uint8_t reserved[3];
+};
+
+/**
+ * Check a derived key by decrypting only the final ciphertext block
+ * @param check Verification record
+ * @param derived_key 32-byte AES key from the KDF
+ * @return true if the final block carries valid padding
+ */
+BTC_HOST_DEVICE inline bool mkey_check_derived_key(const BitcoinCoreMKeyCheck& check, const uint8_t* derived_key) {
+    uint8_t plaintext[16];
+    aes256_cbc_decrypt_last_block(derived_key, check.previous_block, check.last_block, plaintext);
+    return pkcs7_padding_valid(plaintext, check.expected_padding);
+}
+
+/**
+ * Derive the key for a password and check it
+ * @param check Verification record
+ * @param password Candidate bytes
+ * @param password_length Candidate length
+ * @return true if the password passes the final-block check
+ */
+BTC_HOST_DEVICE inline bool mkey_check_password(const BitcoinCoreMKeyCheck& check,
+                                                const uint8_t* password, size_t password_length) {
+    uint8_t derived_key[32];
+    pbkdf2_hmac_sha512(password, password_length, check.salt, check.salt_length, check.iterations,
+                       derived_key, sizeof(derived_key));
+    return mkey_check_derived_key(check, derived_key);
+}
+
+/**
+ * Length-specialised check for kernels instantiated per length bucket
+ * Same result as mkey_check_password() for passwords of at most
+ * MAX_LENGTH bytes and salts of at most PBKDF2_SHA512_SHORT_SALT_MAX, but
+ * the key stays in registers and U1 reuses the wallet's salt block.
+ * @param check Verification record
+ * @param salt_block pbkdf2_sha512_salt_block() of the record's salt, block 1
+ * @param password Candidate bytes
+ * @param password_length Candidate length, at most MAX_LENGTH
+ * @return true if the password passes the final-block check
+ */
+template <size_t MAX_LENGTH, uint32_t ITERATIONS = 0>
+BTC_HOST_DEVICE inline bool mkey_check_password_short(const BitcoinCoreMKeyCheck& check, const uint64_t salt_block[16],
+                                                      const uint8_t* password, size_t password_length) {
+    // A non-zero ITERATIONS bakes the wallet's iteration count into the loop
+    const uint32_t iterations = ITERATIONS != 0 ? ITERATIONS : check.iterations;
+
+    HMACSHA512State pads;
+    hmac_sha512_precompute_short<MAX_LENGTH>(password, password_length, pads);
+    uint64_t u[8], t[8];
+    pbkdf2_sha512_first_block_words(pads, salt_block, u);
+    for (int i = 0; i < 8; i++) {
+        t[i] = u[i];
+    }
+    if (iterations > 1) {
+        pbkdf2_sha512_iterate(pads, u, t, iterations - 1);
+    }
+
+    uint8_t derived_key[32];
+    for (int i = 0; i < 4; i++) {
+        sha512_store_be64(derived_key + i * 8, t[i]);
+    }
+    return mkey_check_derived_key(check, derived_key);
+}
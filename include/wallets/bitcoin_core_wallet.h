@@ -1,6 +1,9 @@
 #pragma once
 
 #include "wallet_base.h"
+#include "wallets/bitcoin_core_mkey.h"
+#include "utils/sha512_multibuffer.h"
+#include "utils/mapped_file.h"
 #include <string>
 #include <vector>
 #include <map>
@@ -54,6 +57,9 @@ public:
     // WalletBase interface implementation
     bool load() override;
     bool test_password(const std::string& password) override;
+    int test_passwords(const std::string* passwords, size_t count) override;
+    int test_passwords(const CandidateBatch& batch) override;
+    using WalletBase::test_passwords;
     WalletMetadata get_metadata() const override;
     bool is_valid() const override;
     WalletFormat get_format() const override;
@@ -75,6 +81,13 @@ public:
      */
     std::vector<PrivateKeyInfo> extract_private_keys(const std::string& password);
 
+    /**
+     * Build the fixed-size master-key record used by GPU and fast-reject verifiers
+     * @param check Output verification record for the first master key
+     * @return true if the wallet has a master key that fits the record
+     */
+    bool get_master_key_check(BitcoinCoreMKeyCheck& check);
+
     /**
      * Check balances for all addresses using blockchain APIs
      * @param private_keys vector of private key info to update
@@ -112,72 +125,67 @@ public:
     WalletStats get_wallet_stats(const std::vector<PrivateKeyInfo>& keys);
 
 private:
-    // Berkeley DB parsing
-    struct BDBHeader {
-        uint32_t magic;
-        uint32_t version;
-        uint32_t page_size;
-        uint32_t flags;
-    };
-
-    struct BDBPage {
-        uint32_t page_number;
-        uint32_t page_type;
-        uint32_t prev_page;
-        uint32_t next_page;
-        std::vector<uint8_t> data;
-    };
-
-    // Wallet data structures
+    // Wallet records; spans point into wallet_file_map_ and live as long as it does
     struct MasterKey {
-        std::vector<uint8_t> encrypted_key;
-        std::vector<uint8_t> salt;
+        ByteSpan encrypted_key;
+        ByteSpan salt;
         uint32_t derive_iterations;
         uint32_t derive_method;
-        std::vector<uint8_t> other_params;
+        ByteSpan other_params;
     };
 
     struct CryptedKey {
-        std::vector<uint8_t> public_key;
-        std::vector<uint8_t> encrypted_private_key;
+        ByteSpan public_key;
+        ByteSpan encrypted_private_key;
     };
 
     // Internal data
-    std::vector<uint8_t> wallet_data_;
-    std::map<std::string, MasterKey> master_keys_;
-    std::map<std::string, CryptedKey> crypted_keys_;
+    MappedFile wallet_file_map_;
+    size_t bdb_page_size_ = 0;
+    uint32_t bdb_last_page_ = 0;
+    bool bdb_swapped_ = false;     // Database written on a host of the opposite byte order
+    std::map<uint32_t, MasterKey> master_keys_;
+    std::vector<CryptedKey> crypted_keys_;
     std::map<std::string, std::string> key_labels_;
     std::map<std::string, std::string> api_keys_;
     std::map<std::string, std::string> api_endpoints_;
     bool testnet_mode_;
     bool loaded_;
 
+    // Candidates are derived in groups that fill the SIMD lanes several times
+    // over, keeping the pointer tables and derived keys on the stack
+    static constexpr size_t DERIVATION_GROUP_SIZE = SHA512MultiBuffer::MAX_LANES * 8;
+    std::vector<uint8_t> scratch_decrypted_key_;
+
+    // Below this many keys per thread, spawning threads costs more than it saves
+    static constexpr size_t KEYS_PER_THREAD = 64;
+
     // Berkeley DB parsing methods
     bool parse_bdb_file();
-    bool parse_bdb_page(const std::vector<uint8_t>& page_data, size_t offset);
-    bool extract_key_value_pairs(const std::vector<uint8_t>& data);
+    bool walk_bdb_btree(uint32_t root_page, bool master_database);
+    bool parse_bdb_page(const uint8_t* page, bool master_database);
+    bool parse_wallet_record(ByteSpan key, ByteSpan value);
+    const uint8_t* bdb_page(uint32_t page_number) const;
 
     // Wallet decryption methods
     bool decrypt_master_key(const std::string& password, const MasterKey& master_key, 
                            std::vector<uint8_t>& decrypted_key);
-    bool decrypt_private_key(const std::vector<uint8_t>& master_key, 
+    bool decrypt_master_key_with_derived(const uint8_t* derived_key, const MasterKey& master_key,
+                                         std::vector<uint8_t>& decrypted_key);
+    int test_derivation_group(const uint8_t* const* passwords, const size_t* lengths, size_t count);
+    bool decrypt_private_key(EVP_CIPHER_CTX* ctx, const std::vector<uint8_t>& master_key,
                             const CryptedKey& crypted_key,
-                            std::vector<uint8_t>& private_key);
+                            std::vector<uint8_t>& private_key) const;
+    void derive_key_info(EVP_CIPHER_CTX* ctx, const std::vector<uint8_t>& master_key,
+                         const CryptedKey& crypted_key, std::vector<PrivateKeyInfo>& out) const;
 
     // Key format conversion methods
-    std::string private_key_to_wif(const std::vector<uint8_t>& private_key, bool compressed = true);
-    std::string public_key_to_address(const std::vector<uint8_t>& public_key, bool compressed = true);
-    std::vector<uint8_t> private_key_to_public_key(const std::vector<uint8_t>& private_key);
-
-    // Blockchain API methods
-    bool query_address_balance(const std::string& address, uint64_t& balance, int& tx_count);
-    bool query_blockstream_api(const std::string& address, uint64_t& balance, int& tx_count);
-    bool query_blockchair_api(const std::string& address, uint64_t& balance, int& tx_count);
-    bool query_blockcypher_api(const std::string& address, uint64_t& balance, int& tx_count);
+    std::string private_key_to_wif(const std::vector<uint8_t>& private_key, bool compressed = true) const;
+    std::string public_key_to_address(const std::vector<uint8_t>& public_key, bool compressed = true) const;
+    std::vector<uint8_t> private_key_to_public_key(const std::vector<uint8_t>& private_key) const;
 
     // Utility methods
-    std::vector<uint8_t> derive_key(const std::string& password, const std::vector<uint8_t>& salt, 
-                                   uint32_t iterations);
+    std::vector<uint8_t> derive_key(const std::string& password, ByteSpan salt, uint32_t iterations);
     bool verify_key_pair(const std::vector<uint8_t>& private_key, 
                         const std::vector<uint8_t>& public_key);
     std::string format_balance(uint64_t satoshis);
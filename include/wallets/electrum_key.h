@@ -0,0 +1,103 @@
+#pragma once
+
+#include "utils/host_device.h"
+#include "utils/aes256_block.h"
+#include "utils/sha256d.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Fixed-size Electrum seed verification record
+ *
+ * Electrum before 2.8 encrypts the wallet seed (or master private key)
+ * with AES-256-CBC under SHA-256d(password) and stores base64(IV ||
+ * ciphertext). Only the IV and the first ciphertext block are needed to
+ * reject a password: the first plaintext block of every such secret is
+ * drawn from a small alphabet, so a wrong key passes with odds around
+ * 2^-50 or less. The record is plain data so it can be copied into CUDA
+ * constant memory or passed through the C interface unchanged.
+ */
+#define ELECTRUM_PLAINTEXT_HEX_SEED 1   // 1.x: the seed as lowercase hex
+#define ELECTRUM_PLAINTEXT_MNEMONIC 2   // 2.x: words of a-z separated by spaces
+#define ELECTRUM_PLAINTEXT_XPRV 3       // 2.x: base58 extended private key, "xprv..."
+
+struct ElectrumKeyCheck {
+    uint8_t iv[16];
+    uint8_t first_block[16];      // First ciphertext block
+    uint32_t plaintext_kind;      // ELECTRUM_PLAINTEXT_*
+    uint32_t reserved;
+};
+
+BTC_HOST_DEVICE inline bool electrum_is_base58(uint8_t c) {
+    return (c >= '1' && c <= '9') || (c >= 'A' && c <= 'H') || (c >= 'J' && c <= 'N') ||
+           (c >= 'P' && c <= 'Z') || (c >= 'a' && c <= 'k') || (c >= 'm' && c <= 'z');
+}
+
+/**
+ * Check a decrypted first block against the alphabet of its secret
+ * @param kind ELECTRUM_PLAINTEXT_*
+ * @param plaintext 16-byte plaintext block
+ * @return true if every byte is one the secret can start with
+ */
+BTC_HOST_DEVICE inline bool electrum_plaintext_valid(uint32_t kind, const uint8_t* plaintext) {
+    switch (kind) {
+    case ELECTRUM_PLAINTEXT_HEX_SEED:
+        for (int i = 0; i < 16; i++) {
+            const uint8_t c = plaintext[i];
+            if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+                return false;
+            }
+        }
+        return true;
+    case ELECTRUM_PLAINTEXT_MNEMONIC:
+        if (plaintext[0] == ' ') {
+            return false;
+        }
+        for (int i = 0; i < 16; i++) {
+            const uint8_t c = plaintext[i];
+            if (!((c >= 'a' && c <= 'z') || c == ' ')) {
+                return false;
+            }
+        }
+        return true;
+    case ELECTRUM_PLAINTEXT_XPRV:
+        // xprv/tprv and the SLIP-132 yprv/zprv/uprv/vprv variants
+        if (plaintext[1] != 'p' || plaintext[2] != 'r' || plaintext[3] != 'v') {
+            return false;
+        }
+        for (int i = 0; i < 16; i++) {
+            if (!electrum_is_base58(plaintext[i])) {
+                return false;
+            }
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Check a derived key by decrypting only the first ciphertext block
+ * @param check Verification record
+ * @param key 32-byte AES key, SHA-256d of the password
+ * @return true if the first block decrypts to the expected alphabet
+ */
+BTC_HOST_DEVICE inline bool electrum_check_derived_key(const ElectrumKeyCheck& check, const uint8_t* key) {
+    uint8_t plaintext[16];
+    aes256_cbc_decrypt_last_block(key, check.iv, check.first_block, plaintext);
+    return electrum_plaintext_valid(check.plaintext_kind, plaintext);
+}
+
+/**
+ * Derive the key for a password and check it
+ * @param check Verification record
+ * @param password Candidate bytes (UTF-8)
+ * @param password_length Candidate length
+ * @return true if the password passes the first-block check
+ */
+BTC_HOST_DEVICE inline bool electrum_check_password(const ElectrumKeyCheck& check,
+                                                    const uint8_t* password, size_t password_length) {
+    uint8_t key[32];
+    sha256d(password, password_length, key);
+    return electrum_check_derived_key(check, key);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "wallet_base.h"
+#include "wallets/electrum_key.h"
+#include "utils/sha256d_multibuffer.h"
+#include <string>
+#include <vector>
+
+/**
+ * Electrum wallet handler for the formats before 2.8
+ *
+ * Electrum 1.x writes the wallet as a Python dict literal and 2.0-2.7 as
+ * JSON. Both keep the seed, and 2.x also the master private key, as
+ * base64(IV || AES-256-CBC ciphertext) under SHA-256d(password). Key
+ * derivation is two SHA-256 compressions, so candidates are hashed a SIMD
+ * group at a time and rejected on the first ciphertext block; only the
+ * few that pass are decrypted in full. Wallets from 2.8 on encrypt the
+ * whole file with ECIES and are not handled here.
+ */
+class ElectrumWallet : public WalletBase {
+public:
+    explicit ElectrumWallet(const std::string& wallet_file);
+    ~ElectrumWallet() override = default;
+
+    // WalletBase interface implementation
+    bool load() override;
+    bool test_password(const std::string& password) override;
+    int test_passwords(const std::string* passwords, size_t count) override;
+    int test_passwords(const CandidateBatch& batch) override;
+    using WalletBase::test_passwords;
+    WalletMetadata get_metadata() const override;
+    bool is_valid() const override;
+    WalletFormat get_format() const override;
+    EncryptionType get_encryption_type() const override;
+    uint64_t get_estimated_test_time() const override;
+
+    /**
+     * Build the fixed-size record used by GPU and fast-reject verifiers
+     * @param check Output verification record
+     * @return true if the wallet holds an encrypted secret
+     */
+    bool get_key_check(ElectrumKeyCheck& check);
+
+    /**
+     * Decrypt the wallet secret
+     * @param password The wallet password
+     * @param secret Output seed (hex or mnemonic) or master private key
+     * @return true if the password decrypts a well-formed secret
+     */
+    bool decrypt_secret(const std::string& password, std::string& secret);
+
+    /**
+     * Seed version recorded in the wallet, 0 if absent
+     */
+    int get_seed_version() const { return seed_version_; }
+
+    /**
+     * Decode standard base64, ignoring whitespace
+     * @return false on any other byte outside the alphabet
+     */
+    static bool base64_decode(const std::string& text, std::vector<uint8_t>& out);
+
+    /**
+     * Find the string value of a key in a JSON object or Python dict literal
+     * Electrum 1.x quotes with ' and 2.x with ", so either is accepted; the
+     * values looked up here never contain escapes.
+     * @return false if no key of that name has a quoted value
+     */
+    static bool find_string_field(const std::string& text, const std::string& name, std::string& value);
+
+    /**
+     * Unquoted value of a key (a number or a boolean), as find_string_field
+     */
+    static bool find_token_field(const std::string& text, const std::string& name, std::string& token);
+
+private:
+    std::vector<uint8_t> iv_;
+    std::vector<uint8_t> ciphertext_;
+    uint32_t plaintext_kind_ = 0;   // ELECTRUM_PLAINTEXT_*
+    int seed_version_ = 0;
+    bool loaded_;
+
+    // Candidates are hashed in groups that fill the SIMD lanes several
+    // times over, keeping the pointer tables and keys on the stack
+    static constexpr size_t HASH_GROUP_SIZE = SHA256dMultiBuffer::MAX_LANES * 8;
+
+    bool parse_wallet(const std::string& text);
+    int test_hash_group(const uint8_t* const* passwords, const size_t* lengths, size_t count);
+    bool decrypt_with_key(const uint8_t* key, std::string& secret) const;
+};
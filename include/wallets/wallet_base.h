@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/candidate_batch.h"
 #include <string>
 #include <vector>
 #include <memory>
@@ -64,6 +65,46 @@ public:
      */
     virtual bool test_password(const std::string& password) = 0;
 
+    /**
+     * Test a batch of passwords against the wallet
+     * Handlers with a vectorised key derivation override this; the default
+     * tests candidates one at a time.
+     * @param passwords Pointer to the first password
+     * @param count Number of passwords
+     * @return index of the correct password, -1 if none matched
+     */
+    virtual int test_passwords(const std::string* passwords, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            if (test_password(passwords[i])) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * Test a batch of passwords against the wallet
+     * @param passwords Passwords to test
+     * @return index of the correct password, -1 if none matched
+     */
+    int test_passwords(const std::vector<std::string>& passwords) {
+        return test_passwords(passwords.data(), passwords.size());
+    }
+
+    /**
+     * Test a batch of candidates read in place from batch storage
+     * @param batch Candidate batch
+     * @return index of the correct password, -1 if none matched
+     */
+    virtual int test_passwords(const CandidateBatch& batch) {
+        for (size_t i = 0; i < batch.size(); i++) {
+            if (test_password(batch.to_string(i))) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
     /**
      * Get wallet metadata
      * @return WalletMetadata structure
@@ -20,6 +20,8 @@ SECURITY_GROUP=${SECURITY_GROUP:-btc-recovery-sg}
 SUBNET_ID=${SUBNET_ID:-}
 INSTANCE_COUNT=${INSTANCE_COUNT:-1}
 CLUSTER_MODE=${CLUSTER_MODE:-false}
+CLUSTER_PORT=${CLUSTER_PORT:-8080}
+WALLET_PATH=${WALLET_PATH:-/opt/btc-recovery/wallet.dat}
 
 print_status() {
     echo -e "${GREEN}[INFO]${NC} $1"
@@ -83,7 +85,7 @@ create_security_group() {
         aws ec2 authorize-security-group-ingress \
             --group-id "$SECURITY_GROUP_ID" \
             --protocol tcp \
-            --port 8080 \
+            --port "$CLUSTER_PORT" \
             --source-group "$SECURITY_GROUP_ID" \
             --region "$AWS_REGION"
         
@@ -169,7 +171,8 @@ After=network.target
 Type=simple
 User=ubuntu
 WorkingDirectory=/opt/btc-recovery
-ExecStart=/opt/btc-recovery/build/btc-recovery --config /opt/btc-recovery/config/recovery.yaml
+EnvironmentFile=-/etc/default/btc-recovery
+ExecStart=/opt/btc-recovery/build/btc-recovery --config /opt/btc-recovery/config/recovery.yaml $CLUSTER_ARGS
 Restart=always
 RestartSec=10
 
@@ -177,6 +180,26 @@ RestartSec=10
 WantedBy=multi-user.target
 SERVICE_EOF
 
+# Cluster coordinator; only enabled on node 0
+cat > /etc/systemd/system/btc-recovery-coordinator.service << 'SERVICE_EOF'
+[Unit]
+Description=Bitcoin Wallet Recovery Cluster Coordinator
+After=network.target
+Before=btc-recovery.service
+
+[Service]
+Type=simple
+User=ubuntu
+WorkingDirectory=/opt/btc-recovery
+EnvironmentFile=-/etc/default/btc-recovery
+ExecStart=/opt/btc-recovery/build/btc-recovery --config /opt/btc-recovery/config/recovery.yaml $CLUSTER_ARGS --coordinator
+Restart=on-failure
+RestartSec=10
+
+[Install]
+WantedBy=multi-user.target
+SERVICE_EOF
+
 # Enable service
 systemctl daemon-reload
 systemctl enable btc-recovery
@@ -203,6 +226,37 @@ echo "Setup completed" > /tmp/setup_complete
 EOF
 }
 
+# User data for one cluster node: the common setup plus that node's
+# cluster.yaml. Node 0 also runs the coordinator; every node, including
+# node 0, runs a worker that leases its share of the keyspace from it.
+generate_node_user_data() {
+    local node_id=$1
+    local coordinator_host=$2
+    local output=$3
+
+    # The common script ends by marking setup complete, so the node's
+    # settings go in before that line
+    head -n -1 user_data.sh > "$output"
+    cat >> "$output" << EOF
+
+# Cluster node $node_id of $INSTANCE_COUNT
+mkdir -p /etc/btc-recovery
+cat > /etc/btc-recovery/cluster.yaml << 'CLUSTER_EOF'
+cluster:
+  enabled: true
+  total_nodes: $INSTANCE_COUNT
+  node_id: $node_id
+  coordinator_host: "$coordinator_host"
+  coordinator_port: $CLUSTER_PORT
+CLUSTER_EOF
+echo 'CLUSTER_ARGS=-w $WALLET_PATH --cluster /etc/btc-recovery/cluster.yaml' > /etc/default/btc-recovery
+EOF
+    if [[ "$node_id" == "0" ]]; then
+        echo "systemctl enable btc-recovery-coordinator" >> "$output"
+    fi
+    tail -n 1 user_data.sh >> "$output"
+}
+
 # Launch instances
 launch_instances() {
     print_status "Launching $INSTANCE_COUNT EC2 instances..."
@@ -211,22 +265,39 @@ launch_instances() {
     
     INSTANCE_IDS=()
     
+    COORDINATOR_IP=""
+    
     for ((i=0; i<INSTANCE_COUNT; i++)); do
         print_status "Launching instance $((i+1))/$INSTANCE_COUNT..."
         
+        NODE_USER_DATA=user_data.sh
+        if [[ "$CLUSTER_MODE" == "true" ]]; then
+            NODE_USER_DATA=user_data_node_$i.sh
+            generate_node_user_data "$i" "${COORDINATOR_IP:-127.0.0.1}" "$NODE_USER_DATA"
+        fi
+        
         INSTANCE_ID=$(aws ec2 run-instances \
             --image-id "$AMI_ID" \
             --count 1 \
             --instance-type "$INSTANCE_TYPE" \
             --key-name "$KEY_PAIR" \
             --security-groups "$SECURITY_GROUP" \
-            --user-data file://user_data.sh \
+            --user-data "file://$NODE_USER_DATA" \
             --region "$AWS_REGION" \
             --tag-specifications "ResourceType=instance,Tags=[{Key=Name,Value=btc-recovery-node-$i},{Key=Project,Value=btc-recovery}]" \
             --query 'Instances[0].InstanceId' --output text)
         
         INSTANCE_IDS+=("$INSTANCE_ID")
         print_status "Instance launched: $INSTANCE_ID"
+        
+        # Workers need the coordinator's address, which exists once node 0 is placed
+        if [[ "$CLUSTER_MODE" == "true" && $i -eq 0 ]]; then
+            COORDINATOR_IP=$(aws ec2 describe-instances \
+                --instance-ids "$INSTANCE_ID" \
+                --region "$AWS_REGION" \
+                --query 'Reservations[0].Instances[0].PrivateIpAddress' --output text)
+            print_status "Cluster coordinator: $COORDINATOR_IP:$CLUSTER_PORT"
+        fi
     done
     
     # Wait for instances to be running
@@ -251,7 +322,7 @@ launch_instances() {
     done
     
     # Clean up
-    rm -f user_data.sh
+    rm -f user_data.sh user_data_node_*.sh
 }
 
 # Terminate instances
@@ -313,7 +384,9 @@ main() {
             echo "  KEY_PAIR        - Key pair name [default: btc-recovery-key]"
             echo "  SECURITY_GROUP  - Security group name [default: btc-recovery-sg]"
             echo "  INSTANCE_COUNT  - Number of instances [default: 1]"
-            echo "  CLUSTER_MODE    - Enable cluster mode [default: false]"
+            echo "  CLUSTER_MODE    - Enable cluster mode; node 0 coordinates [default: false]"
+            echo "  CLUSTER_PORT    - Coordinator port [default: 8080]"
+            echo "  WALLET_PATH     - Wallet file on every node [default: /opt/btc-recovery/wallet.dat]"
             ;;
         *)
             print_error "Unknown command: $1"
@@ -0,0 +1,330 @@
+#include "cluster/cluster_coordinator.h"
+#include "line_socket.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <sstream>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// Weight of the newest sample in a node's smoothed rate
+const double RATE_SMOOTHING = 0.5;
+
+// Missed heartbeats before a node's leases are handed to someone else
+const int HEARTBEAT_GRACE = 3;
+
+bool decode_hex(const std::string& hex, std::string& bytes) {
+    if (hex.size() % 2 != 0) {
+        return false;
+    }
+    bytes.clear();
+    for (size_t i = 0; i < hex.size(); i += 2) {
+        int value = 0;
+        for (size_t j = i; j < i + 2; j++) {
+            const char c = hex[j];
+            int digit = (c >= '0' && c <= '9') ? c - '0'
+                      : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                      : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+            if (digit < 0) {
+                return false;
+            }
+            value = value * 16 + digit;
+        }
+        bytes += static_cast<char>(value);
+    }
+    return true;
+}
+
+} // namespace
+
+ClusterCoordinator::ClusterCoordinator(const ClusterSettings& settings)
+    : settings_(settings), listen_fd_(-1), port_(0), keyspace_{0, 0}, next_lease_id_(1),
+      candidates_tested_(0), expired_leases_(0), found_(false), stopped_(false) {}
+
+ClusterCoordinator::~ClusterCoordinator() {
+    connections_.clear();
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+    }
+}
+
+bool ClusterCoordinator::start(const KeyspaceRange& keyspace, const std::string& fingerprint,
+                               const std::vector<KeyspaceRange>& completed) {
+    listen_fd_ = line_socket_listen(settings_.coordinator_port, port_);
+    if (listen_fd_ < 0) {
+        Logger::error("Cannot listen on cluster port " + std::to_string(settings_.coordinator_port));
+        return false;
+    }
+
+    keyspace_ = keyspace;
+    fingerprint_ = fingerprint;
+    completed_.assign(completed);
+    const auto remaining = completed_.remaining(keyspace);
+    pending_.assign(remaining.begin(), remaining.end());
+    started_ = Clock::now();
+
+    Logger::info("Cluster coordinator listening on port " + std::to_string(port_) + ", " +
+                 keyspace_index_to_string(keyspace.size() - completed_.count()) + " candidates to lease");
+    return true;
+}
+
+bool ClusterCoordinator::finished() const {
+    return found_ || (pending_.empty() && leases_.empty());
+}
+
+bool ClusterCoordinator::run(Checkpoint* checkpoint) {
+    while (!stopped_.load() && !finished()) {
+        poll_once(200);
+        if (checkpoint && checkpoint->due() && !checkpoint->save(checkpoint_state())) {
+            Logger::warn(checkpoint->get_last_error());
+        }
+    }
+
+    // Workers still connected stop instead of asking for more work
+    broadcast("STOP");
+    if (checkpoint && !checkpoint->save(checkpoint_state())) {
+        Logger::warn(checkpoint->get_last_error());
+    }
+    return found_;
+}
+
+void ClusterCoordinator::poll_once(int timeout_ms) {
+    std::vector<pollfd> descriptors;
+    descriptors.push_back({listen_fd_, POLLIN, 0});
+    for (const auto& entry : connections_) {
+        descriptors.push_back({entry.first, POLLIN, 0});
+    }
+
+    if (::poll(descriptors.data(), descriptors.size(), timeout_ms) > 0) {
+        if (descriptors[0].revents & POLLIN) {
+            accept_connection();
+        }
+
+        std::vector<int> dropped;
+        for (size_t i = 1; i < descriptors.size(); i++) {
+            if (!descriptors[i].revents) {
+                continue;
+            }
+            const int fd = descriptors[i].fd;
+            Connection& connection = connections_[fd];
+            bool alive = connection.socket->receive();
+            connection.last_seen = Clock::now();
+
+            std::string message;
+            while (alive && connection.socket->next_line(message)) {
+                alive = handle_message(fd, connection, message);
+            }
+            if (!alive) {
+                dropped.push_back(fd);
+            }
+        }
+
+        for (int fd : dropped) {
+            Logger::info("Cluster node " + std::to_string(connections_[fd].node_id) + " disconnected");
+            release_leases(fd);
+            connections_.erase(fd);
+        }
+    }
+
+    expire_leases();
+}
+
+void ClusterCoordinator::accept_connection() {
+    const int fd = ::accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+        return;
+    }
+    Connection& connection = connections_[fd];
+    connection.socket.reset(new LineSocket(fd));
+    connection.last_seen = Clock::now();
+}
+
+bool ClusterCoordinator::handle_message(int fd, Connection& connection, const std::string& message) {
+    std::istringstream in(message);
+    std::string command;
+    in >> command;
+
+    if (command == "HELLO") {
+        std::string fingerprint;
+        in >> connection.node_id >> fingerprint;
+        if (fingerprint != fingerprint_) {
+            Logger::warn("Rejected cluster node " + std::to_string(connection.node_id) +
+                         ": different wallet or search settings");
+            connection.socket->send_line("REJECT fingerprint");
+            return false;
+        }
+        connection.welcomed = true;
+        Logger::info("Cluster node " + std::to_string(connection.node_id) + " joined");
+        bool sent = connection.socket->send_line("WELCOME " + std::to_string(settings_.heartbeat_interval));
+        return sent && (!found_ || connection.socket->send_line("STOP"));
+    }
+
+    if (!connection.welcomed) {
+        connection.socket->send_line("REJECT hello");
+        return false;
+    }
+
+    if (command == "LEASE") {
+        return connection.socket->send_line(lease_chunk(fd, connection));
+    }
+
+    if (command == "COMPLETE") {
+        uint64_t id = 0;
+        uint64_t tested = 0;
+        double seconds = 0.0;
+        in >> id >> tested >> seconds;
+
+        // A lease that already expired was handed out again; its extra
+        // coverage is harmless and simply not recorded twice
+        auto lease = leases_.find(id);
+        if (lease != leases_.end() && lease->second.fd == fd) {
+            completed_.add(lease->second.range);
+            candidates_tested_ += tested;
+            leases_.erase(lease);
+        }
+        if (seconds > 0.0 && tested > 0) {
+            const double sample = tested / seconds;
+            connection.rate = connection.rate > 0.0
+                ? RATE_SMOOTHING * sample + (1.0 - RATE_SMOOTHING) * connection.rate
+                : sample;
+        }
+        return connection.socket->send_line("OK");
+    }
+
+    if (command == "HEARTBEAT") {
+        return connection.socket->send_line("OK");
+    }
+
+    if (command == "FOUND") {
+        uint64_t id = 0;
+        std::string hex;
+        std::string password;
+        in >> id >> hex;
+        if (!found_ && decode_hex(hex, password)) {
+            found_ = true;
+            found_password_ = password;
+            Logger::info("Cluster node " + std::to_string(connection.node_id) + " found the password");
+        }
+        bool sent = connection.socket->send_line("OK");
+        broadcast("STOP");
+        return sent;
+    }
+
+    Logger::warn("Unknown cluster message: " + command);
+    return connection.socket->send_line("ERROR unknown");
+}
+
+std::string ClusterCoordinator::lease_chunk(int fd, Connection& connection) {
+    if (found_ || stopped_.load()) {
+        return "STOP";
+    }
+    if (pending_.empty()) {
+        // Outstanding leases may still expire and come back
+        return leases_.empty() ? "DONE" : "WAIT " + std::to_string(settings_.result_sync_interval);
+    }
+
+    KeyspaceRange& front = pending_.front();
+    const KeyspaceIndex size = std::min<KeyspaceIndex>(front.size(), chunk_size(connection));
+    connection.last_lease = static_cast<uint64_t>(size);
+    Lease lease;
+    lease.range = {front.begin, front.begin + size};
+    lease.fd = fd;
+    lease.issued = Clock::now();
+    front.begin += size;
+    if (front.empty()) {
+        pending_.pop_front();
+    }
+
+    const uint64_t id = next_lease_id_++;
+    leases_[id] = lease;
+    return "CHUNK " + std::to_string(id) + " " + keyspace_index_to_string(lease.range.begin) + " " +
+           keyspace_index_to_string(lease.range.end);
+}
+
+uint64_t ClusterCoordinator::chunk_size(const Connection& connection) const {
+    double remaining = 0.0;
+    for (const auto& range : pending_) {
+        remaining += static_cast<double>(range.size());
+    }
+
+    // Nodes that have not reported yet count at the average measured rate
+    double measured_rate = 0.0;
+    size_t measured = 0;
+    size_t nodes = 0;
+    for (const auto& entry : connections_) {
+        if (entry.second.welcomed) {
+            nodes++;
+            if (entry.second.rate > 0.0) {
+                measured_rate += entry.second.rate;
+                measured++;
+            }
+        }
+    }
+    const double cluster_rate = measured ? measured_rate * nodes / measured : 0.0;
+
+    double size;
+    if (connection.rate > 0.0 && cluster_rate > 0.0) {
+        // About one sync interval of this node's work, but never more than
+        // its rate-weighted share of what is left
+        size = std::min(connection.rate * settings_.progress_sync_interval,
+                        remaining * connection.rate / cluster_rate);
+        if (connection.last_lease) {
+            size = std::min(size, 2.0 * connection.last_lease);
+        }
+    } else {
+        size = std::min(static_cast<double>(settings_.work_chunk_size),
+                        remaining / std::max<size_t>(nodes, 1));
+    }
+    return static_cast<uint64_t>(std::max(1.0, std::min(size, 1e18)));
+}
+
+void ClusterCoordinator::expire_leases() {
+    const auto grace = std::chrono::seconds(settings_.heartbeat_interval * HEARTBEAT_GRACE);
+    const auto now = Clock::now();
+    for (auto it = leases_.begin(); it != leases_.end();) {
+        auto connection = connections_.find(it->second.fd);
+        if (connection == connections_.end() || now - connection->second.last_seen > grace) {
+            Logger::warn("Lease " + std::to_string(it->first) + " expired; re-leasing " +
+                         keyspace_index_to_string(it->second.range.size()) + " candidates");
+            pending_.push_front(it->second.range);
+            expired_leases_++;
+            it = leases_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ClusterCoordinator::release_leases(int fd) {
+    for (auto it = leases_.begin(); it != leases_.end();) {
+        if (it->second.fd == fd) {
+            pending_.push_front(it->second.range);
+            expired_leases_++;
+            it = leases_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ClusterCoordinator::broadcast(const std::string& message) {
+    for (auto& entry : connections_) {
+        if (entry.second.welcomed) {
+            entry.second.socket->send_line(message);
+        }
+    }
+}
+
+CheckpointState ClusterCoordinator::checkpoint_state() const {
+    CheckpointState state;
+    state.fingerprint = fingerprint_;
+    state.keyspace = keyspace_;
+    state.completed = completed_.ranges();
+    state.candidates_tested = candidates_tested_;
+    state.elapsed_seconds = std::chrono::duration<double>(Clock::now() - started_).count();
+    state.candidates_per_second = state.elapsed_seconds > 0.0 ? candidates_tested_ / state.elapsed_seconds : 0.0;
+    return state;
+}
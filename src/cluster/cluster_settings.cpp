@@ -0,0 +1,97 @@
+#include "cluster/cluster_settings.h"
+#include "utils/logger.h"
+#include <fstream>
+#include <map>
+
+namespace {
+
+std::string trim(const std::string& text) {
+    const size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    const size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+// Flatten "section:\n  key: value" into "section.key" -> value
+std::map<std::string, std::string> read_yaml_values(std::ifstream& file) {
+    std::map<std::string, std::string> values;
+    std::string line;
+    std::string section;
+    while (std::getline(file, line)) {
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        const size_t colon = line.find(':');
+        if (trim(line).empty() || colon == std::string::npos) {
+            continue;
+        }
+
+        const bool nested = line[0] == ' ' || line[0] == '\t';
+        const std::string key = trim(line.substr(0, colon));
+        std::string value = trim(line.substr(colon + 1));
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+            value = value.substr(1, value.size() - 2);
+        }
+
+        if (!nested) {
+            section = value.empty() ? key : "";
+            if (!value.empty()) {
+                values[key] = value;
+            }
+        } else if (!section.empty()) {
+            values[section + "." + key] = value;
+        }
+    }
+    return values;
+}
+
+} // namespace
+
+bool ClusterSettings::load_file(const std::string& file_path) {
+    std::ifstream file(file_path);
+    if (!file.is_open()) {
+        Logger::error("Cannot open cluster configuration: " + file_path);
+        return false;
+    }
+
+    const auto values = read_yaml_values(file);
+    auto get = [&](const std::string& key, std::string& value) {
+        auto it = values.find(key);
+        if (it == values.end()) {
+            return false;
+        }
+        value = it->second;
+        return true;
+    };
+
+    try {
+        std::string value;
+        if (get("cluster.enabled", value)) enabled = value == "true";
+        if (get("cluster.total_nodes", value)) total_nodes = std::stoi(value);
+        if (get("cluster.node_id", value)) node_id = std::stoi(value);
+        if (get("cluster.coordinator_host", value)) coordinator_host = value;
+        if (get("cluster.coordinator_port", value)) coordinator_port = static_cast<uint16_t>(std::stoi(value));
+        if (get("distribution.work_chunk_size", value)) work_chunk_size = std::stoull(value);
+        if (get("distribution.progress_sync_interval", value)) progress_sync_interval = std::stoi(value);
+        if (get("distribution.result_sync_interval", value)) result_sync_interval = std::stoi(value);
+        if (get("network.timeout", value)) timeout = std::stoi(value);
+        if (get("network.retry_attempts", value)) retry_attempts = std::stoi(value);
+        if (get("network.heartbeat_interval", value)) heartbeat_interval = std::stoi(value);
+        if (get("monitoring.enabled", value)) monitoring_enabled = value == "true";
+        if (get("monitoring.metrics_port", value)) metrics_port = std::stoi(value);
+    } catch (const std::exception&) {
+        Logger::error("Invalid value in cluster configuration: " + file_path);
+        return false;
+    }
+
+    if (work_chunk_size == 0 || heartbeat_interval <= 0 || progress_sync_interval <= 0 ||
+        result_sync_interval <= 0 || node_id < 0 || node_id >= total_nodes || metrics_port < 0 ||
+        metrics_port > 65535) {
+        Logger::error("Inconsistent cluster configuration: " + file_path);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,220 @@
+#include "cluster/cluster_worker.h"
+#include "line_socket.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+#include <sys/socket.h>
+
+ClusterWorker::ClusterWorker(const ClusterSettings& settings)
+    : settings_(settings), socket_(new LineSocket()), connected_(false), stopped_(false),
+      shutting_down_(false) {}
+
+ClusterWorker::~ClusterWorker() {
+    disconnect();
+}
+
+bool ClusterWorker::connect(const std::string& fingerprint) {
+    disconnect();
+    shutting_down_ = false;
+    stopped_ = false;
+
+    const int attempts = std::max(settings_.retry_attempts, 1);
+    for (int attempt = 1; attempt <= attempts; attempt++) {
+        if (socket_->connect(settings_.coordinator_host, settings_.coordinator_port, settings_.timeout)) {
+            break;
+        }
+        Logger::warn("Cannot reach coordinator " + settings_.coordinator_host + ":" +
+                     std::to_string(settings_.coordinator_port) + " (attempt " + std::to_string(attempt) +
+                     "/" + std::to_string(attempts) + ")");
+        if (attempt < attempts) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+    }
+    if (!socket_->is_open()) {
+        return false;
+    }
+
+    // The handshake runs before the reader thread exists
+    std::string reply;
+    if (!socket_->send_line("HELLO " + std::to_string(settings_.node_id) + " " + fingerprint)) {
+        socket_->close();
+        return false;
+    }
+    while (!socket_->next_line(reply)) {
+        if (!socket_->receive()) {
+            socket_->close();
+            Logger::error("Coordinator closed the connection during the handshake");
+            return false;
+        }
+    }
+
+    std::istringstream in(reply);
+    std::string command;
+    int heartbeat = 0;
+    in >> command >> heartbeat;
+    if (command != "WELCOME") {
+        socket_->close();
+        Logger::error("Coordinator rejected this node: " + reply);
+        return false;
+    }
+    if (heartbeat > 0) {
+        settings_.heartbeat_interval = heartbeat;
+    }
+
+    connected_ = true;
+    reader_ = std::thread(&ClusterWorker::read_loop, this);
+    heartbeat_ = std::thread(&ClusterWorker::heartbeat_loop, this);
+    Logger::info("Joined cluster as node " + std::to_string(settings_.node_id));
+    return true;
+}
+
+void ClusterWorker::disconnect() {
+    {
+        std::lock_guard<std::mutex> guard(heartbeat_lock_);
+        shutting_down_ = true;
+    }
+    if (socket_->is_open()) {
+        // Wakes the reader thread blocked in recv
+        ::shutdown(socket_->fd(), SHUT_RDWR);
+    }
+    heartbeat_wakeup_.notify_all();
+    if (heartbeat_.joinable()) heartbeat_.join();
+    if (reader_.joinable()) reader_.join();
+
+    socket_->close();
+    std::lock_guard<std::mutex> guard(reply_lock_);
+    replies_.clear();
+    connected_ = false;
+}
+
+bool ClusterWorker::lease(KeyspaceRange& chunk, uint64_t& lease_id) {
+    for (;;) {
+        std::string reply;
+        if (!request("LEASE", reply)) {
+            return false;
+        }
+
+        std::istringstream in(reply);
+        std::string command;
+        in >> command;
+        if (command == "CHUNK") {
+            std::string begin;
+            std::string end;
+            in >> lease_id >> begin >> end;
+            return keyspace_index_from_string(begin, chunk.begin) && keyspace_index_from_string(end, chunk.end);
+        }
+        if (command != "WAIT") {
+            return false;  // DONE, or anything unexpected
+        }
+
+        // Everything is leased out; ask again in case a lease expires
+        int seconds = 1;
+        in >> seconds;
+        const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(std::max(seconds, 1));
+        while (std::chrono::steady_clock::now() < until && !stopped_ && !shutting_down_) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+}
+
+bool ClusterWorker::complete(uint64_t lease_id, uint64_t tested, double seconds) {
+    std::ostringstream message;
+    message << "COMPLETE " << lease_id << " " << tested << " " << seconds;
+    std::string reply;
+    return request(message.str(), reply) && reply == "OK";
+}
+
+bool ClusterWorker::report_found(uint64_t lease_id, const std::string& password) {
+    static const char* digits = "0123456789abcdef";
+    std::string hex;
+    for (unsigned char c : password) {
+        hex += digits[c >> 4];
+        hex += digits[c & 0x0f];
+    }
+    std::string reply;
+    return request("FOUND " + std::to_string(lease_id) + " " + hex, reply) && reply == "OK";
+}
+
+bool ClusterWorker::request(const std::string& message, std::string& reply) {
+    std::lock_guard<std::mutex> request_guard(request_lock_);
+    if (stopped_ || !socket_->send_line(message)) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> guard(reply_lock_);
+    const bool answered = reply_ready_.wait_for(guard, std::chrono::seconds(settings_.timeout), [this] {
+        return !replies_.empty() || !connected_ || stopped_;
+    });
+    if (!answered) {
+        // A late reply would be taken for the answer to the next request
+        Logger::error("Coordinator did not answer within " + std::to_string(settings_.timeout) + " seconds");
+        connected_ = false;
+        return false;
+    }
+    // A reply that arrived counts even if STOP was read right behind it, as
+    // the coordinator sends after accepting a FOUND
+    if (replies_.empty()) {
+        return false;
+    }
+    reply = replies_.front();
+    replies_.pop_front();
+    return true;
+}
+
+void ClusterWorker::read_loop() {
+    std::string line;
+    for (;;) {
+        while (socket_->next_line(line)) {
+            if (line == "STOP") {
+                request_stop();
+                continue;
+            }
+            std::lock_guard<std::mutex> guard(reply_lock_);
+            replies_.push_back(line);
+            reply_ready_.notify_all();
+        }
+        if (!socket_->receive()) {
+            break;
+        }
+    }
+
+    if (!shutting_down_) {
+        Logger::warn("Lost connection to the cluster coordinator");
+    }
+    std::lock_guard<std::mutex> guard(reply_lock_);
+    connected_ = false;
+    reply_ready_.notify_all();
+}
+
+void ClusterWorker::heartbeat_loop() {
+    const auto interval = std::chrono::seconds(settings_.heartbeat_interval);
+    std::unique_lock<std::mutex> guard(heartbeat_lock_);
+    while (!shutting_down_ && !stopped_) {
+        if (heartbeat_wakeup_.wait_for(guard, interval, [this] { return shutting_down_.load(); })) {
+            break;
+        }
+        guard.unlock();
+        std::string reply;
+        const bool alive = request("HEARTBEAT", reply);
+        guard.lock();
+        if (!alive) {
+            break;
+        }
+    }
+}
+
+void ClusterWorker::request_stop() {
+    if (stopped_.exchange(true)) {
+        return;
+    }
+    Logger::info("Coordinator requested stop");
+    {
+        std::lock_guard<std::mutex> guard(reply_lock_);
+        reply_ready_.notify_all();
+    }
+    if (stop_callback_) {
+        stop_callback_();
+    }
+}
@@ -0,0 +1,136 @@
+#include "line_socket.h"
+#include <cstring>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+LineSocket::LineSocket(LineSocket&& other) noexcept : fd_(-1) {
+    *this = std::move(other);
+}
+
+LineSocket& LineSocket::operator=(LineSocket&& other) noexcept {
+    if (this != &other) {
+        close();
+        fd_ = other.fd_;
+        buffer_ = std::move(other.buffer_);
+        other.fd_ = -1;
+    }
+    return *this;
+}
+
+bool LineSocket::connect(const std::string& host, uint16_t port, int timeout_seconds) {
+    close();
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) {
+        return false;
+    }
+
+    for (addrinfo* address = addresses; address && fd_ < 0; address = address->ai_next) {
+        int fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        timeval timeout{timeout_seconds, 0};
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+            int enable = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+            fd_ = fd;
+        } else {
+            ::close(fd);
+        }
+    }
+    freeaddrinfo(addresses);
+    return fd_ >= 0;
+}
+
+bool LineSocket::send_line(const std::string& line) {
+    if (fd_ < 0) {
+        return false;
+    }
+    const std::string message = line + "\n";
+    size_t sent = 0;
+    while (sent < message.size()) {
+        const ssize_t written = ::send(fd_, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+        if (written <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool LineSocket::receive() {
+    if (fd_ < 0) {
+        return false;
+    }
+    char chunk[4096];
+    const ssize_t received = ::recv(fd_, chunk, sizeof(chunk), 0);
+    if (received <= 0) {
+        return false;
+    }
+    buffer_.append(chunk, static_cast<size_t>(received));
+    return buffer_.size() <= MAX_LINE_LENGTH || buffer_.find('\n') != std::string::npos;
+}
+
+bool LineSocket::next_line(std::string& line) {
+    const size_t newline = buffer_.find('\n');
+    if (newline == std::string::npos) {
+        return false;
+    }
+    size_t length = newline;
+    if (length > 0 && buffer_[length - 1] == '\r') {
+        length--;
+    }
+    line.assign(buffer_, 0, length);
+    buffer_.erase(0, newline + 1);
+    return true;
+}
+
+void LineSocket::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    buffer_.clear();
+}
+
+int line_socket_listen(uint16_t port, uint16_t& bound_port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, 64) != 0) {
+        ::close(fd);
+        return -1;
+    }
+
+    socklen_t length = sizeof(address);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+    bound_port = ntohs(address.sin_port);
+    return fd;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * TCP connection carrying newline-terminated text messages
+ *
+ * Shared by the cluster coordinator and workers. Reads are buffered so a
+ * poll loop can pull whatever bytes are available and then take complete
+ * lines; writes always send the whole line.
+ */
+class LineSocket {
+public:
+    // Longest accepted line; anything longer closes the connection
+    static constexpr size_t MAX_LINE_LENGTH = 4096;
+
+    explicit LineSocket(int fd = -1) : fd_(fd) {}
+    ~LineSocket() { close(); }
+
+    LineSocket(LineSocket&& other) noexcept;
+    LineSocket& operator=(LineSocket&& other) noexcept;
+    LineSocket(const LineSocket&) = delete;
+    LineSocket& operator=(const LineSocket&) = delete;
+
+    /**
+     * Connect to a host
+     * @param host Host name or address
+     * @param port TCP port
+     * @param timeout_seconds Connect and send timeout
+     * @return true if connected
+     */
+    bool connect(const std::string& host, uint16_t port, int timeout_seconds);
+
+    /**
+     * Send one message; a newline is appended
+     * @return false if the connection failed
+     */
+    bool send_line(const std::string& line);
+
+    /**
+     * Read the bytes currently available (blocks if there are none)
+     * @return false on end of stream, error or an overlong line
+     */
+    bool receive();
+
+    /**
+     * Take the next complete message from the buffer
+     * @param line Output, without the line ending
+     * @return false if no complete line is buffered
+     */
+    bool next_line(std::string& line);
+
+    void close();
+    int fd() const { return fd_; }
+    bool is_open() const { return fd_ >= 0; }
+
+private:
+    int fd_;
+    std::string buffer_;
+};
+
+/**
+ * Open a listening TCP socket
+ * @param port Port to bind (0 = any free port)
+ * @param bound_port Set to the port actually bound
+ * @return listening descriptor, -1 on failure
+ */
+int line_socket_listen(uint16_t port, uint16_t& bound_port);
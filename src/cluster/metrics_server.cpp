@@ -0,0 +1,134 @@
+#include "cluster/metrics_server.h"
+#include "line_socket.h"
+#include "utils/logger.h"
+#include <cerrno>
+#include <cstring>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace {
+
+// Longest request head accepted; a scrape sends a few hundred bytes
+const size_t MAX_REQUEST_SIZE = 8192;
+
+// How often the accept loop checks for stop()
+const int POLL_INTERVAL_MS = 250;
+
+// A client that stalls this long is dropped so the next scrape is not blocked
+const int CLIENT_TIMEOUT_SECONDS = 2;
+
+bool send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t result = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (result <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+std::string http_response(const std::string& status, const std::string& content_type, const std::string& body) {
+    return "HTTP/1.1 " + status + "\r\n"
+           "Content-Type: " + content_type + "\r\n"
+           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+           "Connection: close\r\n\r\n" + body;
+}
+
+} // namespace
+
+MetricsServer::MetricsServer(const MetricsRegistry& registry)
+    : registry_(registry), listen_fd_(-1), port_(0), stop_(false) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(uint16_t port) {
+    stop();
+
+    listen_fd_ = line_socket_listen(port, port_);
+    if (listen_fd_ < 0) {
+        last_error_ = "Cannot listen for metrics on port " + std::to_string(port) + ": " + std::strerror(errno);
+        port_ = 0;
+        return false;
+    }
+
+    stop_.store(false);
+    thread_ = std::thread(&MetricsServer::run, this);
+    Logger::info("Serving metrics on port " + std::to_string(port_) + " at /metrics");
+    return true;
+}
+
+void MetricsServer::stop() {
+    stop_.store(true);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+void MetricsServer::run() {
+    while (!stop_.load()) {
+        pollfd listener{listen_fd_, POLLIN, 0};
+        if (poll(&listener, 1, POLL_INTERVAL_MS) <= 0 || !(listener.revents & POLLIN)) {
+            continue;
+        }
+        const int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        serve(fd);
+        ::close(fd);
+    }
+}
+
+void MetricsServer::serve(int fd) {
+    timeval timeout{CLIENT_TIMEOUT_SECONDS, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // Only the request line matters, but the head is read in full so the
+    // client is not reset while still sending it
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_SIZE) {
+        const ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            break;
+        }
+        request.append(buffer, static_cast<size_t>(received));
+    }
+
+    const size_t line_end = request.find("\r\n");
+    const std::string line = request.substr(0, line_end);
+    const size_t method_end = line.find(' ');
+    const size_t path_end = line.find(' ', method_end == std::string::npos ? 0 : method_end + 1);
+    if (line_end == std::string::npos || method_end == std::string::npos || path_end == std::string::npos) {
+        send_all(fd, http_response("400 Bad Request", "text/plain", "Bad request\n"));
+        return;
+    }
+
+    const std::string method = line.substr(0, method_end);
+    std::string path = line.substr(method_end + 1, path_end - method_end - 1);
+    path = path.substr(0, path.find('?'));
+
+    if (method != "GET") {
+        send_all(fd, http_response("405 Method Not Allowed", "text/plain", "Only GET is supported\n"));
+    } else if (path == "/metrics") {
+        send_all(fd, http_response("200 OK", "text/plain; version=0.0.4; charset=utf-8", registry_.render()));
+    } else {
+        send_all(fd, http_response("404 Not Found", "text/plain", "Metrics are served at /metrics\n"));
+    }
+}
@@ -0,0 +1,750 @@
+#include "core/benchmark.h"
+#include "core/candidate_batch.h"
+#include "core/keyspace_scheduler.h"
+#include "core/mask_generator.h"
+#include "utils/aes256_verify.h"
+#include "utils/logger.h"
+#include "utils/scrypt_engine.h"
+#include "utils/sha512_multibuffer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifdef ENABLE_CUDA
+extern "C" {
+    void* cuda_integrated_recovery_create();
+    void cuda_integrated_recovery_destroy(void* recovery);
+    int cuda_integrated_recovery_device_count();
+    int cuda_integrated_recovery_initialize_with_wallet(void* recovery, int device_id,
+                                                       const unsigned char* wallet_data, int wallet_data_size);
+    int cuda_integrated_recovery_autotune(void* recovery, const char* cache_path);
+    int cuda_integrated_recovery_test_range(void* recovery, const MaskGenerator* generator,
+                                            const KeyspaceRange* range, char* found_password,
+                                            int max_password_length);
+}
+#endif
+
+#ifdef ENABLE_OPENCL
+extern "C" {
+    void* opencl_recovery_create();
+    void opencl_recovery_destroy(void* recovery);
+    int opencl_recovery_device_count();
+    int opencl_recovery_initialize_with_wallet(void* recovery, int device_index, const char* cache_directory,
+                                               const unsigned char* wallet_data, int wallet_data_size);
+    int opencl_recovery_test_range(void* recovery, const MaskGenerator* generator,
+                                   const KeyspaceRange* range, char* found_password,
+                                   int max_password_length);
+}
+#endif
+
+namespace {
+
+const char* const WALLET_FORMAT = "bitcoin-core";
+const char* const KDF_NAME = "pbkdf2-sha512";
+const char* const SCRYPT_WALLET_FORMAT = "bip38";
+const char* const SCRYPT_KDF_NAME = "scrypt";
+
+// Eight lowercase letters, far larger than any batch. The known password
+// sits at KNOWN_INDEX and every batch ends with it, so a backend that stops
+// at the first hit still tests the whole batch
+const char* const BENCHMARK_MASK = "?l?l?l?l?l?l?l?l";
+const KeyspaceIndex KNOWN_INDEX = 1000000000;
+const size_t MAX_BATCH_SIZE = 1u << 24;
+
+// Fixed so that reruns benchmark the same wallet
+const uint8_t SYNTHETIC_SALT[8] = {0x62, 0x65, 0x6e, 0x63, 0x68, 0x73, 0x61, 0x6c};
+
+// A 32-byte master key encrypts to three blocks; the last is all padding
+const uint8_t MASTER_KEY_PADDING = 16;
+
+const size_t GPU_BATCH_SIZES[] = {8192, 65536};
+const size_t CPU_BATCHES_PER_LANE[] = {4, 32};
+const size_t SCRYPT_CANDIDATES_PER_THREAD[] = {1, 4};
+
+// BIP38 derives 64 bytes: 32 to XOR with the key and 32 for AES
+const size_t SCRYPT_KEY_LENGTH = 64;
+const size_t MAX_SCRYPT_BATCH_SIZE = 1u << 16;
+
+const BenchmarkBackend ALL_BACKENDS[] = {
+    BenchmarkBackend::CPU_SCALAR, BenchmarkBackend::CPU_AVX2, BenchmarkBackend::CPU_AVX512,
+    BenchmarkBackend::CUDA, BenchmarkBackend::OPENCL, BenchmarkBackend::CPU_SCRYPT,
+    BenchmarkBackend::CPU_SCRYPT_TMTO
+};
+
+SIMDLevel backend_simd_level(BenchmarkBackend backend) {
+    switch (backend) {
+        case BenchmarkBackend::CPU_AVX512: return SIMDLevel::AVX512;
+        case BenchmarkBackend::CPU_AVX2:   return SIMDLevel::AVX2;
+        default:                           return SIMDLevel::SCALAR;
+    }
+}
+
+bool is_cpu_backend(BenchmarkBackend backend) {
+    return backend == BenchmarkBackend::CPU_SCALAR || backend == BenchmarkBackend::CPU_AVX2 ||
+           backend == BenchmarkBackend::CPU_AVX512;
+}
+
+bool is_scrypt_backend(BenchmarkBackend backend) {
+    return backend == BenchmarkBackend::CPU_SCRYPT || backend == BenchmarkBackend::CPU_SCRYPT_TMTO;
+}
+
+int gpu_device_count(BenchmarkBackend backend) {
+#ifdef ENABLE_CUDA
+    if (backend == BenchmarkBackend::CUDA) {
+        return cuda_integrated_recovery_device_count();
+    }
+#endif
+#ifdef ENABLE_OPENCL
+    if (backend == BenchmarkBackend::OPENCL) {
+        return opencl_recovery_device_count();
+    }
+#endif
+    (void)backend;
+    return 0;
+}
+
+KeyspaceRange batch_range(size_t batch_size) {
+    return {KNOWN_INDEX + 1 - batch_size, KNOWN_INDEX + 1};
+}
+
+BenchmarkResult make_result(BenchmarkBackend backend, uint32_t iterations, int device, size_t batch_size) {
+    BenchmarkResult result;
+    result.wallet_format = WALLET_FORMAT;
+    result.kdf = KDF_NAME;
+    result.iterations = iterations;
+    result.backend = BenchmarkRunner::backend_name(backend);
+    result.device = device;
+    result.batch_size = batch_size;
+    return result;
+}
+
+BenchmarkResult make_scrypt_result(BenchmarkBackend backend, const ScryptParams& params, uint32_t lookup_gap,
+                                   size_t batch_size) {
+    BenchmarkResult result = make_result(backend, params.N, -1, batch_size);
+    result.wallet_format = SCRYPT_WALLET_FORMAT;
+    result.kdf = SCRYPT_KDF_NAME;
+    result.scrypt_r = params.r;
+    result.scrypt_p = params.p;
+    result.lookup_gap = lookup_gap;
+    return result;
+}
+
+/**
+ * Derive one scrypt key with the reference implementation and full V tables
+ */
+void scrypt_reference_key(const ScryptParams& params, const std::string& password, uint8_t* key) {
+    std::vector<uint8_t> blocks(params.p * scrypt_block_words(params.r) * sizeof(uint32_t));
+    std::vector<uint32_t> scratch(scrypt_scratch_words(params, 1) + scrypt_block_words(params.r));
+    scrypt_derive(reinterpret_cast<const uint8_t*>(password.data()), password.size(), SYNTHETIC_SALT,
+                  sizeof(SYNTHETIC_SALT), params, key, SCRYPT_KEY_LENGTH, blocks.data(), scratch.data(), 1);
+}
+
+/**
+ * Run one batch repeatedly until min_seconds passed
+ * @param run_batch bool(found, error): test the batch, set found to the reported password
+ */
+template <typename RunBatch>
+void measure(BenchmarkResult& result, const std::string& expected, double min_seconds, RunBatch run_batch) {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    result.verified = true;
+    do {
+        std::string found;
+        if (!run_batch(found, result.error)) {
+            if (result.error.empty()) {
+                result.error = "Known password was not reported";
+            }
+            result.verified = false;
+            break;
+        }
+        if (found != expected) {
+            result.error = "Reported password does not match the known password";
+            result.verified = false;
+            break;
+        }
+        result.candidates += result.batch_size;
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (result.seconds < min_seconds);
+
+    if (result.verified && result.seconds > 0.0) {
+        result.candidates_per_second = result.candidates / result.seconds;
+    }
+}
+
+std::string json_string(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        switch (c) {
+            case '"':  quoted += "\\\""; break;
+            case '\\': quoted += "\\\\"; break;
+            case '\n': quoted += "\\n"; break;
+            case '\t': quoted += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    quoted += escaped;
+                } else {
+                    quoted += c;
+                }
+        }
+    }
+    return quoted + "\"";
+}
+
+template <typename Value, typename Parse>
+bool parse_list(const std::string& text, const char* what, std::vector<Value>& values, std::string& error,
+                Parse parse) {
+    if (text.empty()) {
+        return true;
+    }
+    std::vector<Value> parsed;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        Value value;
+        if (!parse(item, value)) {
+            error = std::string("Invalid ") + what + ": " + item;
+            return false;
+        }
+        parsed.push_back(value);
+    }
+    if (parsed.empty()) {
+        error = std::string("Empty ") + what + " list";
+        return false;
+    }
+    values = parsed;
+    return true;
+}
+
+bool parse_positive(const std::string& text, unsigned long long limit, unsigned long long& value) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos || text.size() > 12) {
+        return false;
+    }
+    value = std::stoull(text);
+    return value > 0 && value <= limit;
+}
+
+} // namespace
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkOptions& options) : options_(options) {}
+
+std::string BenchmarkRunner::backend_name(BenchmarkBackend backend) {
+    switch (backend) {
+        case BenchmarkBackend::CPU_SCALAR: return "cpu-scalar";
+        case BenchmarkBackend::CPU_AVX2:   return "cpu-avx2";
+        case BenchmarkBackend::CPU_AVX512: return "cpu-avx512";
+        case BenchmarkBackend::CUDA:       return "cuda";
+        case BenchmarkBackend::OPENCL:     return "opencl";
+        case BenchmarkBackend::CPU_SCRYPT: return "cpu-scrypt";
+        case BenchmarkBackend::CPU_SCRYPT_TMTO: return "cpu-scrypt-tmto";
+    }
+    return "unknown";
+}
+
+bool BenchmarkRunner::parse_backend(const std::string& name, BenchmarkBackend& backend) {
+    for (BenchmarkBackend candidate : ALL_BACKENDS) {
+        if (name == backend_name(candidate)) {
+            backend = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+BitcoinCoreMKeyCheck BenchmarkRunner::make_synthetic_wallet(const std::string& password, uint32_t iterations) {
+    BitcoinCoreMKeyCheck check;
+    memset(&check, 0, sizeof(check));
+    memcpy(check.salt, SYNTHETIC_SALT, sizeof(SYNTHETIC_SALT));
+    check.salt_length = sizeof(SYNTHETIC_SALT);
+    check.iterations = iterations;
+    check.expected_padding = MASTER_KEY_PADDING;
+    for (size_t i = 0; i < sizeof(check.last_block); i++) {
+        check.last_block[i] = static_cast<uint8_t>(0xa5 ^ (i * 29));
+    }
+
+    // Pick the block before the last so that the last decrypts to a full
+    // padding block under this password's key
+    uint8_t derived_key[32];
+    pbkdf2_hmac_sha512(reinterpret_cast<const uint8_t*>(password.data()), password.size(),
+                       check.salt, check.salt_length, iterations, derived_key, sizeof(derived_key));
+    const uint8_t zero_block[16] = {0};
+    uint8_t decrypted[16];
+    AES256Verifier::decrypt_last_block(derived_key, zero_block, check.last_block, decrypted);
+    for (size_t i = 0; i < sizeof(check.previous_block); i++) {
+        check.previous_block[i] = decrypted[i] ^ MASTER_KEY_PADDING;
+    }
+    return check;
+}
+
+bool BenchmarkRunner::is_available(BenchmarkBackend backend) const {
+    if (is_scrypt_backend(backend)) {
+        return true;
+    }
+    if (is_cpu_backend(backend)) {
+        return static_cast<int>(backend_simd_level(backend)) <=
+               static_cast<int>(SHA512MultiBuffer::detect_simd_level());
+    }
+    return gpu_device_count(backend) > 0;
+}
+
+size_t BenchmarkRunner::cpu_threads() const {
+    if (options_.threads > 0) {
+        return static_cast<size_t>(options_.threads);
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+std::vector<size_t> BenchmarkRunner::batch_sizes_for(BenchmarkBackend backend) const {
+    if (!options_.batch_sizes.empty()) {
+        return options_.batch_sizes;
+    }
+    if (is_scrypt_backend(backend)) {
+        std::vector<size_t> sizes;
+        for (size_t per_thread : SCRYPT_CANDIDATES_PER_THREAD) {
+            sizes.push_back(cpu_threads() * per_thread);
+        }
+        return sizes;
+    }
+    if (!is_cpu_backend(backend)) {
+        return std::vector<size_t>(std::begin(GPU_BATCH_SIZES), std::end(GPU_BATCH_SIZES));
+    }
+    // Enough candidates to give every thread whole lane groups
+    const size_t lanes = SHA512MultiBuffer::get_lane_count(backend_simd_level(backend));
+    std::vector<size_t> sizes;
+    for (size_t per_lane : CPU_BATCHES_PER_LANE) {
+        sizes.push_back(cpu_threads() * lanes * per_lane);
+    }
+    return sizes;
+}
+
+std::vector<BenchmarkResult> BenchmarkRunner::run() {
+    const bool explicit_backends = !options_.backends.empty();
+    const std::vector<BenchmarkBackend> backends = explicit_backends
+        ? options_.backends
+        : std::vector<BenchmarkBackend>(std::begin(ALL_BACKENDS), std::end(ALL_BACKENDS));
+
+    std::vector<BenchmarkResult> results;
+    for (uint32_t iterations : options_.iterations) {
+        for (BenchmarkBackend backend : backends) {
+            if (is_scrypt_backend(backend)) {
+                continue;  // No iteration count, run once below
+            }
+            if (!is_available(backend)) {
+                // Only report backends the caller asked for by name
+                if (explicit_backends) {
+                    BenchmarkResult result = make_result(backend, iterations, -1, 0);
+                    result.error = "Backend not available in this build or on this host";
+                    results.push_back(result);
+                }
+                continue;
+            }
+            if (is_cpu_backend(backend)) {
+                run_cpu(backend, iterations, results);
+            } else if (backend == BenchmarkBackend::CUDA) {
+                run_cuda(iterations, results);
+            } else {
+                run_opencl(iterations, results);
+            }
+        }
+    }
+    for (BenchmarkBackend backend : backends) {
+        if (is_scrypt_backend(backend)) {
+            run_scrypt(backend, results);
+        }
+    }
+    return results;
+}
+
+void BenchmarkRunner::run_cpu(BenchmarkBackend backend, uint32_t iterations,
+                              std::vector<BenchmarkResult>& results) const {
+    MaskGenerator generator;
+    generator.add_mask(BENCHMARK_MASK);
+    std::string expected;
+    generator.candidate_at(KNOWN_INDEX, expected);
+    const BitcoinCoreMKeyCheck check = make_synthetic_wallet(expected, iterations);
+
+    const SIMDLevel level = backend_simd_level(backend);
+    const size_t lanes = SHA512MultiBuffer::get_lane_count(level);
+    const size_t thread_count = cpu_threads();
+
+    for (size_t batch_size : batch_sizes_for(backend)) {
+        BenchmarkResult result = make_result(backend, iterations, -1, batch_size);
+        if (batch_size > MAX_BATCH_SIZE) {
+            result.error = "Batch size above " + std::to_string(MAX_BATCH_SIZE);
+            results.push_back(result);
+            continue;
+        }
+        CandidateBatch batch(batch_size);
+
+        measure(result, expected, options_.min_seconds, [&](std::string& found, std::string& error) {
+            // Generation is part of the measured work, as it is in a search
+            batch.clear();
+            const KeyspaceRange range = batch_range(batch_size);
+            if (generator.fill(range.begin, batch_size, batch) != batch_size) {
+                error = "Mask generator filled a short batch";
+                return false;
+            }
+
+            std::atomic<size_t> next(0);
+            std::mutex hits_mutex;
+            std::vector<size_t> hits;
+            auto worker = [&]() {
+                const uint8_t* passwords[SHA512MultiBuffer::MAX_LANES];
+                size_t lengths[SHA512MultiBuffer::MAX_LANES];
+                uint8_t keys[SHA512MultiBuffer::MAX_LANES * 32];
+                for (size_t start = next.fetch_add(lanes); start < batch.size(); start = next.fetch_add(lanes)) {
+                    const size_t count = std::min(lanes, batch.size() - start);
+                    for (size_t i = 0; i < count; i++) {
+                        passwords[i] = batch.data(start + i);
+                        lengths[i] = batch.length(start + i);
+                    }
+                    SHA512MultiBuffer::pbkdf2_hmac_sha512(passwords, lengths, count, check.salt, check.salt_length,
+                                                          check.iterations, keys, 32, level);
+                    for (size_t i = 0; i < count; i++) {
+                        if (AES256Verifier::check_last_block(keys + i * 32, check.previous_block,
+                                                             check.last_block, check.expected_padding)) {
+                            std::lock_guard<std::mutex> lock(hits_mutex);
+                            hits.push_back(start + i);
+                        }
+                    }
+                }
+            };
+
+            std::vector<std::thread> threads;
+            for (size_t t = 1; t < thread_count; t++) {
+                threads.emplace_back(worker);
+            }
+            worker();
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            if (hits.size() != 1) {
+                error = hits.empty() ? "" : "Backend accepted " + std::to_string(hits.size()) + " candidates";
+                return false;
+            }
+            found = batch.to_string(hits[0]);
+            return true;
+        });
+        results.push_back(result);
+    }
+}
+
+void BenchmarkRunner::run_cuda(uint32_t iterations, std::vector<BenchmarkResult>& results) const {
+#ifdef ENABLE_CUDA
+    MaskGenerator generator;
+    generator.add_mask(BENCHMARK_MASK);
+    std::string expected;
+    generator.candidate_at(KNOWN_INDEX, expected);
+    const BitcoinCoreMKeyCheck check = make_synthetic_wallet(expected, iterations);
+
+    for (int device = 0; device < cuda_integrated_recovery_device_count(); device++) {
+        void* recovery = cuda_integrated_recovery_create();
+        const bool ready = cuda_integrated_recovery_initialize_with_wallet(
+            recovery, device, reinterpret_cast<const unsigned char*>(&check), sizeof(check)) != 0;
+        // Benchmark the launch geometry a search would use
+        if (ready && !cuda_integrated_recovery_autotune(recovery, nullptr)) {
+            Logger::warn("Autotuning CUDA device " + std::to_string(device) + " failed, using defaults");
+        }
+
+        for (size_t batch_size : batch_sizes_for(BenchmarkBackend::CUDA)) {
+            BenchmarkResult result = make_result(BenchmarkBackend::CUDA, iterations, device, batch_size);
+            if (!ready) {
+                result.error = "CUDA device initialization failed";
+            } else if (batch_size > MAX_BATCH_SIZE) {
+                result.error = "Batch size above " + std::to_string(MAX_BATCH_SIZE);
+            } else {
+                const KeyspaceRange range = batch_range(batch_size);
+                measure(result, expected, options_.min_seconds, [&](std::string& found, std::string&) {
+                    char password[256];
+                    if (!cuda_integrated_recovery_test_range(recovery, &generator, &range,
+                                                             password, sizeof(password))) {
+                        return false;
+                    }
+                    found = password;
+                    return true;
+                });
+            }
+            results.push_back(result);
+        }
+        cuda_integrated_recovery_destroy(recovery);
+    }
+#else
+    (void)iterations;
+    (void)results;
+#endif
+}
+
+void BenchmarkRunner::run_opencl(uint32_t iterations, std::vector<BenchmarkResult>& results) const {
+#ifdef ENABLE_OPENCL
+    MaskGenerator generator;
+    generator.add_mask(BENCHMARK_MASK);
+    std::string expected;
+    generator.candidate_at(KNOWN_INDEX, expected);
+    const BitcoinCoreMKeyCheck check = make_synthetic_wallet(expected, iterations);
+
+    for (int device = 0; device < opencl_recovery_device_count(); device++) {
+        void* recovery = opencl_recovery_create();
+        const bool ready = opencl_recovery_initialize_with_wallet(
+            recovery, device, nullptr, reinterpret_cast<const unsigned char*>(&check), sizeof(check)) != 0;
+
+        for (size_t batch_size : batch_sizes_for(BenchmarkBackend::OPENCL)) {
+            BenchmarkResult result = make_result(BenchmarkBackend::OPENCL, iterations, device, batch_size);
+            if (!ready) {
+                result.error = "OpenCL device initialization failed";
+            } else if (batch_size > MAX_BATCH_SIZE) {
+                result.error = "Batch size above " + std::to_string(MAX_BATCH_SIZE);
+            } else {
+                const KeyspaceRange range = batch_range(batch_size);
+                measure(result, expected, options_.min_seconds, [&](std::string& found, std::string&) {
+                    char password[256];
+                    if (!opencl_recovery_test_range(recovery, &generator, &range, password, sizeof(password))) {
+                        return false;
+                    }
+                    found = password;
+                    return true;
+                });
+            }
+            results.push_back(result);
+        }
+        opencl_recovery_destroy(recovery);
+    }
+#else
+    (void)iterations;
+    (void)results;
+#endif
+}
+
+void BenchmarkRunner::run_scrypt(BenchmarkBackend backend, std::vector<BenchmarkResult>& results) const {
+    const ScryptParams& params = options_.scrypt;
+    const size_t thread_count = cpu_threads();
+    const std::vector<size_t> batch_sizes = batch_sizes_for(backend);
+    if (!scrypt_params_valid(params)) {
+        for (size_t batch_size : batch_sizes) {
+            BenchmarkResult result = make_scrypt_result(backend, params, 0, batch_size);
+            result.error = "Invalid scrypt parameters";
+            results.push_back(result);
+        }
+        return;
+    }
+
+    MaskGenerator generator;
+    generator.add_mask(BENCHMARK_MASK);
+    std::string expected;
+    generator.candidate_at(KNOWN_INDEX, expected);
+    uint8_t expected_key[SCRYPT_KEY_LENGTH];
+    scrypt_reference_key(params, expected, expected_key);
+
+    // derive(batch, keys, error) fills SCRYPT_KEY_LENGTH bytes per candidate
+    std::function<bool(const CandidateBatch&, uint8_t*, std::string&)> derive;
+    std::unique_ptr<ScryptEngine> engine;
+    std::vector<std::vector<uint32_t>> scratch;
+    std::vector<std::vector<uint8_t>> blocks;
+    uint32_t lookup_gap = 1;
+    std::string setup_error;
+
+    if (backend == BenchmarkBackend::CPU_SCRYPT) {
+        engine.reset(new ScryptEngine(params, thread_count));
+        derive = [&](const CandidateBatch& batch, uint8_t* keys, std::string& error) {
+            std::vector<const uint8_t*> passwords(batch.size());
+            std::vector<size_t> lengths(batch.size());
+            for (size_t i = 0; i < batch.size(); i++) {
+                passwords[i] = batch.data(i);
+                lengths[i] = batch.length(i);
+            }
+            if (!engine->derive(passwords.data(), lengths.data(), batch.size(), SYNTHETIC_SALT,
+                                sizeof(SYNTHETIC_SALT), keys, SCRYPT_KEY_LENGTH)) {
+                error = engine->get_last_error();
+                return false;
+            }
+            return true;
+        };
+    } else {
+        // One thread per lane the plan keeps resident, each rebuilding the
+        // V entries its lookup gap skipped
+        const size_t block_bytes = scrypt_block_words(params.r) * sizeof(uint32_t);
+        const size_t budget = options_.scrypt_memory_budget > 0
+            ? options_.scrypt_memory_budget
+            : thread_count * scrypt_table_entries(params.N, 1) * block_bytes / 4;
+        const ScryptTmtoPlan plan = scrypt_plan_tmto(params, budget, thread_count);
+        lookup_gap = plan.lookup_gap;
+        if (plan.lanes == 0) {
+            setup_error = "One scrypt lane does not fit in " + std::to_string(budget) + " bytes";
+        }
+        for (size_t lane = 0; lane < plan.lanes; lane++) {
+            scratch.emplace_back(scrypt_scratch_words(params, lookup_gap) + scrypt_block_words(params.r));
+            blocks.emplace_back(params.p * block_bytes);
+        }
+        derive = [&](const CandidateBatch& batch, uint8_t* keys, std::string&) {
+            std::atomic<size_t> next(0);
+            auto worker = [&](size_t lane) {
+                for (size_t i = next.fetch_add(1); i < batch.size(); i = next.fetch_add(1)) {
+                    scrypt_derive(batch.data(i), batch.length(i), SYNTHETIC_SALT, sizeof(SYNTHETIC_SALT), params,
+                                  keys + i * SCRYPT_KEY_LENGTH, SCRYPT_KEY_LENGTH, blocks[lane].data(),
+                                  scratch[lane].data(), lookup_gap);
+                }
+            };
+            std::vector<std::thread> threads;
+            for (size_t lane = 1; lane < scratch.size(); lane++) {
+                threads.emplace_back(worker, lane);
+            }
+            worker(0);
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            return true;
+        };
+    }
+
+    for (size_t batch_size : batch_sizes) {
+        BenchmarkResult result = make_scrypt_result(backend, params, lookup_gap, batch_size);
+        if (!setup_error.empty()) {
+            result.error = setup_error;
+            results.push_back(result);
+            continue;
+        }
+        if (batch_size > MAX_SCRYPT_BATCH_SIZE) {
+            result.error = "Batch size above " + std::to_string(MAX_SCRYPT_BATCH_SIZE);
+            results.push_back(result);
+            continue;
+        }
+        CandidateBatch batch(batch_size);
+        std::vector<uint8_t> keys(batch_size * SCRYPT_KEY_LENGTH);
+
+        measure(result, expected, options_.min_seconds, [&](std::string& found, std::string& error) {
+            batch.clear();
+            const KeyspaceRange range = batch_range(batch_size);
+            if (generator.fill(range.begin, batch_size, batch) != batch_size) {
+                error = "Mask generator filled a short batch";
+                return false;
+            }
+            if (!derive(batch, keys.data(), error)) {
+                return false;
+            }
+
+            std::vector<size_t> hits;
+            for (size_t i = 0; i < batch.size(); i++) {
+                if (memcmp(keys.data() + i * SCRYPT_KEY_LENGTH, expected_key, SCRYPT_KEY_LENGTH) == 0) {
+                    hits.push_back(i);
+                }
+            }
+            if (hits.size() != 1) {
+                error = hits.empty() ? "" : "Backend accepted " + std::to_string(hits.size()) + " candidates";
+                return false;
+            }
+            found = batch.to_string(hits[0]);
+            return true;
+        });
+        results.push_back(result);
+    }
+}
+
+std::string BenchmarkRunner::to_json(const std::vector<BenchmarkResult>& results) {
+    std::ostringstream out;
+    out.precision(10);
+    out << "{\n  \"host\": {\n";
+    out << "    \"cpu_threads\": " << std::max(1u, std::thread::hardware_concurrency()) << ",\n";
+    out << "    \"simd\": " << json_string(SHA512MultiBuffer::simd_level_to_string(
+                                       SHA512MultiBuffer::detect_simd_level())) << ",\n";
+    out << "    \"aes_ni\": " << (AES256Verifier::has_aes_ni() ? "true" : "false") << ",\n";
+    out << "    \"cuda_devices\": " << gpu_device_count(BenchmarkBackend::CUDA) << ",\n";
+    out << "    \"opencl_devices\": " << gpu_device_count(BenchmarkBackend::OPENCL) << "\n";
+    out << "  },\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& result = results[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {";
+        out << "\"wallet_format\": " << json_string(result.wallet_format);
+        out << ", \"kdf\": " << json_string(result.kdf);
+        out << ", \"iterations\": " << result.iterations;
+        if (result.kdf == SCRYPT_KDF_NAME) {
+            out << ", \"scrypt_r\": " << result.scrypt_r << ", \"scrypt_p\": " << result.scrypt_p;
+            out << ", \"lookup_gap\": " << result.lookup_gap;
+        }
+        out << ", \"backend\": " << json_string(result.backend);
+        out << ", \"device\": " << result.device;
+        out << ", \"batch_size\": " << result.batch_size;
+        out << ", \"candidates\": " << result.candidates;
+        out << ", \"seconds\": " << result.seconds;
+        out << ", \"candidates_per_second\": " << result.candidates_per_second;
+        out << ", \"verified\": " << (result.verified ? "true" : "false");
+        if (!result.error.empty()) {
+            out << ", \"error\": " << json_string(result.error);
+        }
+        out << "}";
+    }
+    out << (results.empty() ? "]\n}\n" : "\n  ]\n}\n");
+    return out.str();
+}
+
+bool parse_benchmark_lists(const std::string& iterations, const std::string& batch_sizes,
+                           const std::string& backends, BenchmarkOptions& options, std::string& error) {
+    auto parse_iterations = [](const std::string& text, uint32_t& value) {
+        unsigned long long parsed = 0;
+        if (!parse_positive(text, 0xffffffffULL, parsed)) {
+            return false;
+        }
+        value = static_cast<uint32_t>(parsed);
+        return true;
+    };
+    auto parse_batch_size = [](const std::string& text, size_t& value) {
+        unsigned long long parsed = 0;
+        if (!parse_positive(text, MAX_BATCH_SIZE, parsed)) {
+            return false;
+        }
+        value = static_cast<size_t>(parsed);
+        return true;
+    };
+    return parse_list(iterations, "iteration count", options.iterations, error, parse_iterations) &&
+           parse_list(batch_sizes, "batch size", options.batch_sizes, error, parse_batch_size) &&
+           parse_list(backends, "backend", options.backends, error, BenchmarkRunner::parse_backend);
+}
+
+int run_benchmark_mode(const BenchmarkOptions& options, const std::string& json_file) {
+    Logger::info("Benchmarking wallet key derivation with synthetic wallets");
+    BenchmarkRunner runner(options);
+    const std::vector<BenchmarkResult> results = runner.run();
+
+    bool all_verified = !results.empty();
+    for (const BenchmarkResult& result : results) {
+        const std::string cost = result.kdf == SCRYPT_KDF_NAME
+            ? " N=" + std::to_string(result.iterations) + " r=" + std::to_string(result.scrypt_r) +
+              " p=" + std::to_string(result.scrypt_p) + " gap=" + std::to_string(result.lookup_gap)
+            : " iterations=" + std::to_string(result.iterations);
+        std::string line = result.backend + (result.device >= 0 ? " #" + std::to_string(result.device) : "") +
+                           cost + " batch=" + std::to_string(result.batch_size) + ": ";
+        if (result.verified) {
+            char rate[32];
+            std::snprintf(rate, sizeof(rate), "%.1f", result.candidates_per_second);
+            Logger::info(line + rate + " candidates/s");
+        } else {
+            Logger::error(line + result.error);
+            all_verified = false;
+        }
+    }
+    if (results.empty()) {
+        Logger::error("No benchmark backend is available");
+    }
+
+    const std::string json = BenchmarkRunner::to_json(results);
+    if (json_file.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream out(json_file);
+        if (!(out << json)) {
+            Logger::error("Cannot write benchmark report: " + json_file);
+            return 1;
+        }
+        Logger::info("Benchmark report written to " + json_file);
+    }
+    return all_verified ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+#include "core/candidate_batch.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// The length byte caps candidates at 255 bytes, and GPU kernels size their
+// candidate buffers by MAX_STRIDE, so a wider stride is a caller error
+size_t checked_stride(size_t stride) {
+    if (stride < 2) {
+        throw std::invalid_argument("Candidate stride must hold a length byte and at least one character");
+    }
+    if (stride > CandidateBatch::MAX_STRIDE) {
+        throw std::invalid_argument("Candidate stride above " + std::to_string(CandidateBatch::MAX_STRIDE));
+    }
+    return stride;
+}
+
+} // namespace
+
+CandidateBatch::CandidateBatch(uint8_t* storage, size_t capacity, size_t stride)
+    : storage_(storage), capacity_(capacity), stride_(checked_stride(stride)), size_(0) {}
+
+CandidateBatch::CandidateBatch(size_t capacity, size_t stride)
+    : owned_storage_(capacity * checked_stride(stride)),
+      storage_(owned_storage_.data()), capacity_(capacity), stride_(stride), size_(0) {}
+
+bool CandidateBatch::push(const char* data, size_t length) {
+    if (size_ >= capacity_ || length > max_length()) {
+        return false;
+    }
+
+    uint8_t* target = slot(size_);
+    target[0] = static_cast<uint8_t>(length);
+    std::memcpy(target + 1, data, length);
+    // Zero the tail so uploads carry no stale bytes from the previous batch
+    std::memset(target + 1 + length, 0, stride_ - 1 - length);
+    size_++;
+    return true;
+}
+
+size_t CandidateBatch::append(const CandidateBatch& source, size_t start, size_t count) {
+    if (start >= source.size()) {
+        return 0;
+    }
+    count = std::min({count, source.size() - start, capacity_ - size_});
+
+    if (source.stride() == stride_) {
+        std::memcpy(slot(size_), source.slot(start), count * stride_);
+        size_ += count;
+        return count;
+    }
+
+    size_t appended = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!push(reinterpret_cast<const char*>(source.data(start + i)), source.length(start + i))) {
+            break;
+        }
+        appended++;
+    }
+    return appended;
+}
+
+uint8_t* CandidateBatch::append_slot() {
+    uint8_t* target = append_raw_slot();
+    if (target) {
+        // A recycled slot still holds the previous candidate; zero it so a
+        // shorter candidate written in place leaves no stale tail for uploads
+        std::memset(target, 0, max_length());
+    }
+    return target;
+}
+
+uint8_t* CandidateBatch::append_raw_slot() {
+    if (size_ >= capacity_) {
+        return nullptr;
+    }
+    uint8_t* target = slot(size_++);
+    target[0] = 0;
+    return target + 1;
+}
+
+std::string CandidateBatch::to_string(size_t index) const {
+    return std::string(reinterpret_cast<const char*>(data(index)), length(index));
+}
+
+size_t CandidateBatch::longest() const {
+    size_t longest = 0;
+    for (size_t i = 0; i < size_; i++) {
+        longest = std::max<size_t>(longest, storage_[i * stride_]);
+    }
+    return longest;
+}
+
+void CandidateArena::Recycler::operator()(CandidateBatch* batch) const {
+    if (arena_ && batch) {
+        arena_->release(batch);
+    }
+}
+
+CandidateArena::CandidateArena(size_t batch_capacity, size_t stride, size_t max_batches)
+    : CandidateArena(batch_capacity, stride, max_batches,
+                     [](size_t size) { return new uint8_t[size]; },
+                     [](uint8_t* storage) { delete[] storage; }) {}
+
+CandidateArena::CandidateArena(size_t batch_capacity, size_t stride, size_t max_batches,
+                               Allocator allocator, Deallocator deallocator)
+    : batch_capacity_(batch_capacity), stride_(checked_stride(stride)),
+      max_batches_(max_batches), allocator_(std::move(allocator)),
+      deallocator_(std::move(deallocator)) {}
+
+CandidateArena::~CandidateArena() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& block : blocks_) {
+        block.batch.reset();
+        deallocator_(block.storage);
+    }
+    blocks_.clear();
+    free_list_.clear();
+}
+
+CandidateArena::BatchPtr CandidateArena::acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (free_list_.empty() && (max_batches_ == 0 || blocks_.size() < max_batches_)) {
+        return BatchPtr(allocate_batch(), Recycler(this));
+    }
+
+    available_.wait(lock, [this] { return !free_list_.empty(); });
+    CandidateBatch* batch = free_list_.back();
+    free_list_.pop_back();
+    return BatchPtr(batch, Recycler(this));
+}
+
+CandidateArena::BatchPtr CandidateArena::try_acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!free_list_.empty()) {
+        CandidateBatch* batch = free_list_.back();
+        free_list_.pop_back();
+        return BatchPtr(batch, Recycler(this));
+    }
+
+    if (max_batches_ == 0 || blocks_.size() < max_batches_) {
+        return BatchPtr(allocate_batch(), Recycler(this));
+    }
+
+    return BatchPtr(nullptr, Recycler(this));
+}
+
+size_t CandidateArena::get_allocated_batches() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return blocks_.size();
+}
+
+size_t CandidateArena::get_free_batches() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_list_.size();
+}
+
+CandidateBatch* CandidateArena::allocate_batch() {
+    // Called with mutex_ held
+    Block block;
+    block.storage = allocator_(batch_capacity_ * stride_);
+    if (!block.storage) {
+        throw std::bad_alloc();
+    }
+    block.batch = std::make_unique<CandidateBatch>(block.storage, batch_capacity_, stride_);
+    CandidateBatch* batch = block.batch.get();
+    blocks_.push_back(std::move(block));
+    return batch;
+}
+
+void CandidateArena::release(CandidateBatch* batch) {
+    batch->clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_list_.push_back(batch);
+    }
+    available_.notify_one();
+}
@@ -0,0 +1,288 @@
+#include "core/checkpoint.h"
+#include "core/markov_model.h"
+#include "utils/logger.h"
+#include "utils/mapped_file.h"
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <sstream>
+
+#ifdef _WIN32
+#include <io.h>
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char* CHECKPOINT_HEADER = "btc_recovery_checkpoint 1";
+
+// FNV-1a; the fingerprint only has to tell searches apart, not resist forgery
+uint64_t fnv1a(const uint8_t* data, size_t length, uint64_t hash) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool read_index(std::istringstream& line, KeyspaceIndex& value) {
+    std::string text;
+    return (line >> text) && keyspace_index_from_string(text, value);
+}
+
+} // namespace
+
+void CompletedRanges::add(const KeyspaceRange& range) {
+    if (range.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(lock_);
+    KeyspaceIndex begin = range.begin;
+    KeyspaceIndex end = range.end;
+
+    // Merge with a range that ends at or after our start
+    auto it = ranges_.upper_bound(begin);
+    if (it != ranges_.begin()) {
+        auto previous = std::prev(it);
+        if (previous->second >= begin) {
+            begin = previous->first;
+            end = std::max(end, previous->second);
+            it = ranges_.erase(previous);
+        }
+    }
+    // ... and with every range that starts inside or right after ours
+    while (it != ranges_.end() && it->first <= end) {
+        end = std::max(end, it->second);
+        it = ranges_.erase(it);
+    }
+    ranges_.emplace(begin, end);
+}
+
+void CompletedRanges::assign(const std::vector<KeyspaceRange>& ranges) {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        ranges_.clear();
+    }
+    for (const auto& range : ranges) {
+        add(range);
+    }
+}
+
+std::vector<KeyspaceRange> CompletedRanges::ranges() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    std::vector<KeyspaceRange> result;
+    result.reserve(ranges_.size());
+    for (const auto& entry : ranges_) {
+        result.push_back({entry.first, entry.second});
+    }
+    return result;
+}
+
+std::vector<KeyspaceRange> CompletedRanges::remaining(const KeyspaceRange& keyspace) const {
+    std::lock_guard<std::mutex> guard(lock_);
+    std::vector<KeyspaceRange> result;
+    KeyspaceIndex position = keyspace.begin;
+    for (const auto& entry : ranges_) {
+        if (entry.second <= position) {
+            continue;
+        }
+        if (entry.first >= keyspace.end) {
+            break;
+        }
+        if (entry.first > position) {
+            result.push_back({position, entry.first});
+        }
+        position = entry.second;
+    }
+    if (position < keyspace.end) {
+        result.push_back({position, keyspace.end});
+    }
+    return result;
+}
+
+KeyspaceIndex CompletedRanges::count() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    KeyspaceIndex total = 0;
+    for (const auto& entry : ranges_) {
+        total += entry.second - entry.first;
+    }
+    return total;
+}
+
+std::string BruteForceSearch::parameters(const std::string& markov_digest) const {
+    // Only a custom charset adds its characters, so other searches keep their fingerprints
+    return "charset=" + charset + (charset == "custom" ? " custom=" + custom_charset : "") + " min=" + std::to_string(min_length) + " max=" + std::to_string(max_length) +
+           " prefix=" + prefix + " suffix=" + suffix + (markov_digest.empty() ? "" : " markov=" + markov_digest);
+}
+
+Checkpoint::Checkpoint(const std::string& file_path, double interval_seconds)
+    : file_path_(file_path),
+      interval_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(interval_seconds))),
+      last_save_(std::chrono::steady_clock::now()) {}
+
+std::string Checkpoint::fingerprint(const std::string& wallet_file, const std::string& search_parameters) {
+    MappedFile wallet;
+    if (!wallet.open(wallet_file)) {
+        return "";
+    }
+
+    uint64_t hash = fnv1a(wallet.data(), wallet.size(), 0xcbf29ce484222325ull);
+    hash = fnv1a(reinterpret_cast<const uint8_t*>("\0"), 1, hash);
+    hash = fnv1a(reinterpret_cast<const uint8_t*>(search_parameters.data()), search_parameters.size(), hash);
+
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    return hex;
+}
+
+std::string Checkpoint::fingerprint(const std::string& wallet_file, const BruteForceSearch& search,
+                                    std::string& error) {
+    std::string digest;
+    if (!search.markov_file.empty()) {
+        MarkovModel markov;
+        if (!markov.train_file(search.markov_file)) {
+            error = markov.get_last_error();
+            return "";
+        }
+        digest = markov.digest();
+    }
+    const std::string print = fingerprint(wallet_file, search.parameters(digest));
+    if (print.empty()) {
+        error = "Cannot read wallet file: " + wallet_file;
+    }
+    return print;
+}
+
+bool Checkpoint::due() const {
+    return std::chrono::steady_clock::now() - last_save_ >= interval_;
+}
+
+bool Checkpoint::save(const CheckpointState& state) {
+    std::ostringstream out;
+    out.precision(17);
+    out << CHECKPOINT_HEADER << "\n";
+    out << "fingerprint " << state.fingerprint << "\n";
+    out << "keyspace " << keyspace_index_to_string(state.keyspace.begin) << " "
+        << keyspace_index_to_string(state.keyspace.end) << "\n";
+    for (const auto& range : state.completed) {
+        out << "completed " << keyspace_index_to_string(range.begin) << " "
+            << keyspace_index_to_string(range.end) << "\n";
+    }
+    for (const auto& position : state.dictionary) {
+        out << "dictionary " << position.offset << " " << position.end << " " << position.rule << "\n";
+    }
+    out << "tested " << state.candidates_tested << "\n";
+    out << "elapsed " << state.elapsed_seconds << "\n";
+    out << "rate " << state.candidates_per_second << "\n";
+    const std::string contents = out.str();
+
+    // Write a sibling file, force it to disk, then rename it over the old one
+    const std::string temp_path = file_path_ + ".tmp";
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        last_error_ = "Cannot create checkpoint: " + temp_path;
+        return false;
+    }
+    bool written = std::fwrite(contents.data(), 1, contents.size(), file) == contents.size() &&
+                   std::fflush(file) == 0;
+#ifdef _WIN32
+    written = written && _commit(_fileno(file)) == 0;
+#else
+    written = written && fsync(fileno(file)) == 0;
+#endif
+    written = (std::fclose(file) == 0) && written;
+    if (!written) {
+        std::remove(temp_path.c_str());
+        last_error_ = "Cannot write checkpoint: " + temp_path;
+        return false;
+    }
+
+#ifdef _WIN32
+    const bool renamed = MoveFileExA(temp_path.c_str(), file_path_.c_str(),
+                                     MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    const bool renamed = std::rename(temp_path.c_str(), file_path_.c_str()) == 0;
+#endif
+    if (!renamed) {
+        std::remove(temp_path.c_str());
+        last_error_ = "Cannot replace checkpoint: " + file_path_;
+        return false;
+    }
+
+    last_save_ = std::chrono::steady_clock::now();
+    LOG_DEBUG("Checkpoint saved: " + file_path_ + " (" + std::to_string(state.completed.size()) +
+                  " ranges, " + std::to_string(state.candidates_tested) + " tested)");
+    return true;
+}
+
+bool Checkpoint::load(CheckpointState& state) {
+    FILE* file = std::fopen(file_path_.c_str(), "rb");
+    if (!file) {
+        last_error_ = "Cannot open checkpoint: " + file_path_;
+        return false;
+    }
+    std::string contents;
+    char buffer[4096];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.append(buffer, read);
+    }
+    std::fclose(file);
+
+    std::istringstream in(contents);
+    std::string text;
+    if (!std::getline(in, text) || text != CHECKPOINT_HEADER) {
+        last_error_ = "Not a checkpoint file: " + file_path_;
+        return false;
+    }
+
+    CheckpointState loaded;
+    size_t line_number = 1;
+    while (std::getline(in, text)) {
+        line_number++;
+        std::istringstream line(text);
+        std::string key;
+        if (!(line >> key)) {
+            continue;
+        }
+
+        bool valid = true;
+        if (key == "fingerprint") {
+            valid = static_cast<bool>(line >> loaded.fingerprint);
+        } else if (key == "keyspace") {
+            valid = read_index(line, loaded.keyspace.begin) && read_index(line, loaded.keyspace.end);
+        } else if (key == "completed") {
+            KeyspaceRange range;
+            valid = read_index(line, range.begin) && read_index(line, range.end) && range.begin < range.end;
+            loaded.completed.push_back(range);
+        } else if (key == "dictionary") {
+            DictionaryPosition position;
+            valid = static_cast<bool>(line >> position.offset >> position.end >> position.rule);
+            loaded.dictionary.push_back(position);
+        } else if (key == "tested") {
+            valid = static_cast<bool>(line >> loaded.candidates_tested);
+        } else if (key == "elapsed") {
+            valid = static_cast<bool>(line >> loaded.elapsed_seconds);
+        } else if (key == "rate") {
+            valid = static_cast<bool>(line >> loaded.candidates_per_second);
+        }
+        // Unknown keys are ignored so newer checkpoints stay readable
+
+        if (!valid) {
+            last_error_ = "Malformed checkpoint line " + std::to_string(line_number) + ": " + file_path_;
+            return false;
+        }
+    }
+
+    state = std::move(loaded);
+    return true;
+}
+
+void Checkpoint::remove() {
+    std::remove(file_path_.c_str());
+}
@@ -0,0 +1,243 @@
+#include "core/device_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#if defined(ENABLE_CUDA) || defined(ENABLE_OPENCL)
+#include "gpu/device_inventory.h"
+#endif
+
+namespace {
+
+std::vector<ComputeDevice> detect_gpus(uint64_t batch_size, int cuda_device) {
+    std::vector<ComputeDevice> gpus;
+
+#ifdef ENABLE_CUDA
+    for (const auto& info : device_inventory().backend_devices(InventoryBackend::CUDA)) {
+        if (cuda_device >= 0 && info.index != cuda_device) {
+            continue;
+        }
+        ComputeDevice device;
+        device.kind = info.integrated ? ComputeDeviceKind::CUDA_INTEGRATED : ComputeDeviceKind::CUDA;
+        device.name = info.name;
+        device.device_id = info.index;
+        device.min_chunk = batch_size;
+        gpus.push_back(device);
+    }
+#endif
+
+#ifdef ENABLE_OPENCL
+    // The inventory index is the position OpenCLRecovery::initialize() takes
+    for (const auto& info : device_inventory().backend_devices(InventoryBackend::OPENCL)) {
+        ComputeDevice device;
+        device.kind = ComputeDeviceKind::OPENCL;
+        device.name = info.name;
+        device.device_id = info.index;
+        device.min_chunk = batch_size;
+        gpus.push_back(device);
+    }
+#endif
+
+    (void)batch_size;
+    (void)cuda_device;
+    return gpus;
+}
+
+} // namespace
+
+const char* compute_device_kind_name(ComputeDeviceKind kind) {
+    switch (kind) {
+        case ComputeDeviceKind::CPU: return "CPU";
+        case ComputeDeviceKind::CUDA: return "CUDA";
+        case ComputeDeviceKind::CUDA_INTEGRATED: return "CUDA integrated";
+        case ComputeDeviceKind::OPENCL: return "OpenCL";
+    }
+    return "unknown";
+}
+
+MetricLabels compute_device_labels(ComputeDeviceKind kind, int device_id) {
+    const char* backend = kind == ComputeDeviceKind::CPU ? "cpu" : kind == ComputeDeviceKind::OPENCL ? "opencl" : "cuda";
+    return {{"backend", backend}, {"device", std::to_string(device_id)}};
+}
+
+std::vector<ComputeDevice> detect_compute_devices(size_t cpu_threads, bool use_gpu, uint64_t batch_size,
+                                                  int cuda_device) {
+    std::vector<ComputeDevice> devices;
+    if (use_gpu) {
+        devices = detect_gpus(std::max<uint64_t>(batch_size, 1), cuda_device);
+    }
+
+    // Each GPU keeps one host thread busy launching and collecting batches
+    const size_t cpu_workers = cpu_threads > devices.size() ? cpu_threads - devices.size() : 1;
+    for (size_t i = 0; i < cpu_workers; i++) {
+        ComputeDevice device;
+        device.kind = ComputeDeviceKind::CPU;
+        device.name = "CPU worker " + std::to_string(i);
+        device.device_id = static_cast<int>(i);
+        device.min_chunk = 64;
+        devices.push_back(device);
+    }
+    return devices;
+}
+
+ThroughputWindow::ThroughputWindow(double window_seconds)
+    : window_seconds_(window_seconds), count_(0.0), seconds_(0.0) {}
+
+void ThroughputWindow::add(uint64_t count, double seconds) {
+    if (seconds <= 0.0) {
+        return;
+    }
+    samples_.push_back({count, seconds});
+    count_ += static_cast<double>(count);
+    seconds_ += seconds;
+
+    while (samples_.size() > 1 && seconds_ - samples_.front().seconds >= window_seconds_) {
+        count_ -= static_cast<double>(samples_.front().count);
+        seconds_ -= samples_.front().seconds;
+        samples_.pop_front();
+    }
+}
+
+DeviceScheduler::DeviceScheduler(const std::vector<ComputeDevice>& devices, const std::vector<KeyspaceRange>& ranges,
+                                 double target_seconds, double window_seconds)
+    : device_count_(std::max<size_t>(devices.size(), 1)), target_seconds_(target_seconds),
+      devices_(new DeviceState[std::max<size_t>(devices.size(), 1)]),
+      keyspace_(ranges, std::max<size_t>(devices.size(), 1)), total_(0) {
+    for (size_t i = 0; i < devices.size(); i++) {
+        devices_[i].device = devices[i];
+        devices_[i].device.min_chunk = std::max<uint64_t>(devices[i].min_chunk, 1);
+        devices_[i].window = ThroughputWindow(window_seconds);
+    }
+    for (const auto& range : ranges) {
+        total_ += range.size();
+    }
+    register_metrics();
+}
+
+DeviceScheduler::~DeviceScheduler() {
+    MetricsRegistry::global().remove_callbacks(this);
+}
+
+void DeviceScheduler::register_metrics() {
+    MetricsRegistry& registry = MetricsRegistry::global();
+    for (size_t i = 0; i < device_count_; i++) {
+        DeviceState& state = devices_[i];
+        const MetricLabels labels = compute_device_labels(state.device.kind, state.device.device_id);
+        state.tested = &registry.counter("btc_recovery_candidates_tested_total",
+                                         "Candidates tested per device", labels);
+        state.measured_rate = &registry.gauge("btc_recovery_device_candidates_per_second",
+                                              "Throughput over the device's sliding window", labels);
+        state.chunk_seconds = &registry.histogram("btc_recovery_chunk_seconds",
+                                                  "Time a device spent on one scheduled chunk", labels);
+    }
+
+    registry.add_callback(this, "btc_recovery_keyspace_completed_percent",
+                          "Share of the keyspace reported as tested", {}, [this] {
+                              return total_ == 0 ? 100.0 : static_cast<double>(keyspace_.completed()) * 100.0 /
+                                                               static_cast<double>(total_);
+                          });
+    registry.add_callback(this, "btc_recovery_keyspace_remaining_candidates",
+                          "Candidates not yet handed to a device", {},
+                          [this] { return static_cast<double>(keyspace_.remaining()); });
+}
+
+uint64_t DeviceScheduler::chunk_size(size_t device) const {
+    const ComputeDevice& info = devices_[device].device;
+    const double own = rate(device);
+    if (own <= 0.0) {
+        return info.min_chunk;
+    }
+
+    // Devices without a measurement yet count at the average measured rate
+    double measured_rate = 0.0;
+    size_t measured = 0;
+    for (size_t i = 0; i < device_count_; i++) {
+        const double other = rate(i);
+        if (other > 0.0) {
+            measured_rate += other;
+            measured++;
+        }
+    }
+    const double total = measured_rate * device_count_ / measured;
+
+    const double remaining = static_cast<double>(keyspace_.remaining());
+    double size = std::min(own * target_seconds_, remaining * own / total);
+    size = std::max(size, static_cast<double>(info.min_chunk));
+    if (info.max_chunk) {
+        size = std::min(size, static_cast<double>(info.max_chunk));
+    }
+    return static_cast<uint64_t>(std::min(size, 1e18));
+}
+
+bool DeviceScheduler::next_chunk(size_t device, KeyspaceRange& chunk) {
+    return keyspace_.next_chunk(device, chunk_size(device), chunk);
+}
+
+void DeviceScheduler::report(size_t device, uint64_t count, double seconds) {
+    DeviceState& state = devices_[device];
+    state.window.add(count, seconds);
+    state.rate.store(state.window.rate(), std::memory_order_relaxed);
+    keyspace_.report(device, count);
+
+    state.tested->add(count);
+    state.measured_rate->set(state.window.rate());
+    state.chunk_seconds->observe(seconds);
+}
+
+void DeviceScheduler::run(const std::function<bool(size_t device, const KeyspaceRange& chunk)>& process) {
+    auto device_loop = [&](size_t device) {
+        KeyspaceRange chunk;
+        while (next_chunk(device, chunk)) {
+            const auto started = std::chrono::steady_clock::now();
+            const bool keep_going = process(device, chunk);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            report(device, static_cast<uint64_t>(chunk.size()), seconds);
+            if (!keep_going) {
+                stop();
+                break;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(device_count_ - 1);
+    for (size_t i = 1; i < device_count_; i++) {
+        threads.emplace_back(device_loop, i);
+    }
+    device_loop(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+double DeviceScheduler::total_rate() const {
+    double total = 0.0;
+    for (size_t i = 0; i < device_count_; i++) {
+        total += rate(i);
+    }
+    return total;
+}
+
+std::vector<double> DeviceScheduler::shares() const {
+    const double total = total_rate();
+    std::vector<double> result(device_count_, 0.0);
+    for (size_t i = 0; i < device_count_ && total > 0.0; i++) {
+        result[i] = rate(i) / total;
+    }
+    return result;
+}
+
+std::string DeviceScheduler::summary() const {
+    const auto fractions = shares();
+    std::string text;
+    for (size_t i = 0; i < device_count_; i++) {
+        const ComputeDevice& info = devices_[i].device;
+        char line[256];
+        std::snprintf(line, sizeof(line), "%s%s [%s]: %.0f candidates/s, %.1f%%",
+                      text.empty() ? "" : "\n", info.name.c_str(), compute_device_kind_name(info.kind),
+                      rate(i), fractions[i] * 100.0);
+        text += line;
+    }
+    return text;
+}
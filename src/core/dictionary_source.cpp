@@ -0,0 +1,112 @@
+#include "core/dictionary_source.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cstring>
+
+bool DictionarySource::open(const std::string& file_path) {
+    if (!file_.open(file_path)) {
+        last_error_ = "Cannot open dictionary: " + file_path;
+        return false;
+    }
+    file_.advise_sequential();
+    LOG_DEBUG("Mapped dictionary " + file_path + " (" + std::to_string(file_.size()) + " bytes)");
+    return true;
+}
+
+uint64_t DictionarySource::align_to_line(uint64_t offset) const {
+    if (offset == 0 || offset >= size()) {
+        return std::min(offset, size());
+    }
+    // Already at a line start if the previous byte ends a line
+    if (data()[offset - 1] == '\n') {
+        return offset;
+    }
+    const void* newline = std::memchr(data() + offset, '\n', size() - offset);
+    return newline ? static_cast<uint64_t>(static_cast<const char*>(newline) - data()) + 1 : size();
+}
+
+std::vector<DictionaryRange> DictionarySource::split(size_t parts, uint64_t start_offset) const {
+    std::vector<DictionaryRange> ranges;
+    const uint64_t begin = align_to_line(start_offset);
+    if (parts == 0 || begin >= size()) {
+        return ranges;
+    }
+
+    // Cut at even byte offsets, then move each cut forward to the next line
+    // start; only the bytes around each cut are touched
+    const uint64_t span = size() - begin;
+    uint64_t previous = begin;
+    for (size_t i = 1; i <= parts; i++) {
+        uint64_t cut = i == parts ? size() : align_to_line(begin + span / parts * i);
+        if (cut > previous) {
+            ranges.push_back({previous, cut});
+            previous = cut;
+        }
+    }
+    return ranges;
+}
+
+DictionaryCursor::DictionaryCursor(const DictionarySource& source, const DictionaryRange& range)
+    : source_(source),
+      position_(source.align_to_line(range.begin)),
+      end_(std::min(range.end, source.size())),
+      released_(position_),
+      skipped_(0) {
+    source_.file_.prefetch(position_, DictionarySource::WINDOW_SIZE);
+}
+
+void DictionaryCursor::release_behind(uint64_t bound) {
+    if (bound - released_ < DictionarySource::WINDOW_SIZE) {
+        return;
+    }
+    source_.file_.release(released_, bound - released_);
+    released_ = bound;
+    source_.file_.prefetch(position_, DictionarySource::WINDOW_SIZE);
+}
+
+bool DictionaryCursor::next(std::string_view& word) {
+    const char* data = source_.data();
+    while (position_ < end_) {
+        const uint64_t line_start = position_;
+        const char* line = data + line_start;
+        const void* newline = std::memchr(line, '\n', end_ - position_);
+        const size_t line_length = newline ? static_cast<const char*>(newline) - line : end_ - position_;
+        position_ += line_length + (newline ? 1 : 0);
+
+        size_t length = line_length;
+        if (length > 0 && line[length - 1] == '\r') {
+            length--;
+        }
+        if (length == 0) {
+            continue;
+        }
+
+        // The returned word still points into its line, so stop short of it
+        release_behind(line_start);
+        word = std::string_view(line, length);
+        return true;
+    }
+    return false;
+}
+
+size_t DictionaryCursor::fill(CandidateBatch& batch) {
+    size_t appended = 0;
+    while (!batch.full()) {
+        // Remember where this line starts so a word that cannot be taken is not lost
+        const uint64_t line_start = position_;
+        std::string_view word;
+        if (!next(word)) {
+            break;
+        }
+        if (word.size() > batch.max_length()) {
+            skipped_++;
+            continue;
+        }
+        if (!batch.push(word.data(), word.size())) {
+            position_ = line_start;
+            break;
+        }
+        appended++;
+    }
+    return appended;
+}
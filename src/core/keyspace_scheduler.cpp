@@ -0,0 +1,230 @@
+#include "core/keyspace_scheduler.h"
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+std::string keyspace_index_to_string(KeyspaceIndex value) {
+    if (value == 0) {
+        return "0";
+    }
+    std::string digits;
+    while (value > 0) {
+        digits += static_cast<char>('0' + static_cast<int>(value % 10));
+        value /= 10;
+    }
+    return std::string(digits.rbegin(), digits.rend());
+}
+
+bool keyspace_index_from_string(const std::string& text, KeyspaceIndex& value) {
+    if (text.empty()) {
+        return false;
+    }
+    const KeyspaceIndex max = ~static_cast<KeyspaceIndex>(0);
+    KeyspaceIndex result = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        const unsigned digit = static_cast<unsigned>(c - '0');
+        if (result > (max - digit) / 10) {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+    value = result;
+    return true;
+}
+
+KeyspaceScheduler::KeyspaceScheduler(const KeyspaceRange& keyspace, size_t worker_count, uint64_t min_steal)
+    : KeyspaceScheduler(std::vector<KeyspaceRange>{keyspace}, worker_count, min_steal) {}
+
+KeyspaceScheduler::KeyspaceScheduler(const std::vector<KeyspaceRange>& ranges, size_t worker_count, uint64_t min_steal)
+    : keyspace_(ranges.empty() ? KeyspaceRange{0, 0} : KeyspaceRange{ranges.front().begin, ranges.back().end}),
+      worker_count_(std::max<size_t>(worker_count, 1)), min_steal_(std::max<uint64_t>(min_steal, 1)),
+      workers_(new WorkerState[std::max<size_t>(worker_count, 1)]), stopped_(false), steals_(0) {
+    assign(ranges);
+}
+
+void KeyspaceScheduler::assign(const std::vector<KeyspaceRange>& ranges) {
+    // Even initial split of the total; the first (total % workers) workers
+    // get one extra index. A share that spans a gap becomes several pieces.
+    KeyspaceIndex total = 0;
+    for (const auto& range : ranges) {
+        total += range.size();
+    }
+    const KeyspaceIndex share = total / worker_count_;
+    const KeyspaceIndex extra = total % worker_count_;
+
+    size_t current = 0;
+    KeyspaceIndex position = ranges.empty() ? 0 : ranges[0].begin;
+    for (size_t i = 0; i < worker_count_; i++) {
+        KeyspaceIndex length = share + (i < extra ? 1 : 0);
+        std::vector<KeyspaceRange> pieces;
+        while (length > 0) {
+            while (position >= ranges[current].end) {
+                position = ranges[++current].begin;
+            }
+            const KeyspaceIndex take = std::min<KeyspaceIndex>(length, ranges[current].end - position);
+            pieces.push_back({position, position + take});
+            position += take;
+            length -= take;
+        }
+
+        WorkerState& state = workers_[i];
+        if (pieces.empty()) {
+            state.next = position;
+            state.end = position;
+        } else {
+            state.next = pieces.front().begin;
+            state.end = pieces.front().end;
+            state.queued.assign(pieces.rbegin(), pieces.rend() - 1);
+        }
+        update_hint(state);
+    }
+}
+
+void KeyspaceScheduler::update_hint(WorkerState& state) {
+    KeyspaceIndex remaining = state.end > state.next ? state.end - state.next : 0;
+    for (const auto& range : state.queued) {
+        remaining += range.size();
+    }
+    const uint64_t saturated = remaining > std::numeric_limits<uint64_t>::max()
+                                   ? std::numeric_limits<uint64_t>::max()
+                                   : static_cast<uint64_t>(remaining);
+    state.remaining_hint.store(saturated, std::memory_order_relaxed);
+}
+
+bool KeyspaceScheduler::next_chunk(size_t worker, uint64_t max_count, KeyspaceRange& chunk) {
+    WorkerState& self = workers_[worker];
+    max_count = std::max<uint64_t>(max_count, 1);
+
+    while (!stopped()) {
+        {
+            std::lock_guard<std::mutex> guard(self.lock);
+            if (self.next >= self.end && !self.queued.empty()) {
+                self.next = self.queued.back().begin;
+                self.end = self.queued.back().end;
+                self.queued.pop_back();
+            }
+            if (self.next < self.end) {
+                const KeyspaceIndex remaining = self.end - self.next;
+                chunk.begin = self.next;
+                chunk.end = self.next + std::min<KeyspaceIndex>(remaining, max_count);
+                self.next = chunk.end;
+                update_hint(self);
+                return true;
+            }
+        }
+
+        if (!steal(worker)) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+bool KeyspaceScheduler::steal(size_t thief) {
+    for (;;) {
+        // Pick the victim with the most work left; the hints are only advisory
+        size_t victim = worker_count_;
+        uint64_t best = 0;
+        for (size_t i = 0; i < worker_count_; i++) {
+            const uint64_t hint = workers_[i].remaining_hint.load(std::memory_order_relaxed);
+            if (i != thief && hint > best) {
+                best = hint;
+                victim = i;
+            }
+        }
+        if (victim == worker_count_ || stopped()) {
+            return false;
+        }
+
+        KeyspaceRange stolen{0, 0};
+        {
+            WorkerState& target = workers_[victim];
+            std::lock_guard<std::mutex> guard(target.lock);
+            if (target.next >= target.end && target.queued.empty()) {
+                update_hint(target);
+                continue;  // Drained while we were looking; pick again
+            }
+
+            if (!target.queued.empty()) {
+                // A queued range is untouched, so the one the victim would reach last moves whole
+                stolen = target.queued.front();
+                target.queued.erase(target.queued.begin());
+            } else {
+                // Take the back half so the victim keeps streaming through its front
+                const KeyspaceIndex remaining = target.end - target.next;
+                const KeyspaceIndex split = remaining <= min_steal_ ? target.next : target.next + remaining / 2;
+                stolen.begin = split;
+                stolen.end = target.end;
+                target.end = split;
+            }
+            update_hint(target);
+        }
+
+        WorkerState& self = workers_[thief];
+        {
+            std::lock_guard<std::mutex> guard(self.lock);
+            self.next = stolen.begin;
+            self.end = stolen.end;
+            update_hint(self);
+        }
+        steals_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+}
+
+void KeyspaceScheduler::run(uint64_t max_count,
+                            const std::function<bool(size_t worker, const KeyspaceRange& chunk)>& process) {
+    auto worker_loop = [&](size_t worker) {
+        KeyspaceRange chunk;
+        while (next_chunk(worker, max_count, chunk)) {
+            if (!process(worker, chunk)) {
+                stop();
+                break;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(worker_count_ - 1);
+    for (size_t i = 1; i < worker_count_; i++) {
+        threads.emplace_back(worker_loop, i);
+    }
+    worker_loop(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+KeyspaceIndex KeyspaceScheduler::completed() const {
+    KeyspaceIndex total = 0;
+    for (size_t i = 0; i < worker_count_; i++) {
+        total += workers_[i].completed.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+KeyspaceIndex KeyspaceScheduler::remaining() const {
+    KeyspaceIndex total = 0;
+    for (size_t i = 0; i < worker_count_; i++) {
+        total += workers_[i].remaining_hint.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::vector<KeyspaceRange> KeyspaceScheduler::unclaimed_ranges() const {
+    std::vector<KeyspaceRange> ranges;
+    for (size_t i = 0; i < worker_count_; i++) {
+        std::lock_guard<std::mutex> guard(workers_[i].lock);
+        if (workers_[i].next < workers_[i].end) {
+            ranges.push_back({workers_[i].next, workers_[i].end});
+        }
+        ranges.insert(ranges.end(), workers_[i].queued.begin(), workers_[i].queued.end());
+    }
+    std::sort(ranges.begin(), ranges.end(),
+              [](const KeyspaceRange& a, const KeyspaceRange& b) { return a.begin < b.begin; });
+    return ranges;
+}
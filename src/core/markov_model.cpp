@@ -0,0 +1,89 @@
+#include "core/markov_model.h"
+#include "core/dictionary_source.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+void saturating_add(uint32_t& count, uint32_t weight) {
+    count = count > UINT32_MAX - weight ? UINT32_MAX : count + weight;
+}
+
+} // namespace
+
+MarkovModel::MarkovModel()
+    : transitions_(POSITIONS * CONTEXTS * 256, 0), positional_(POSITIONS * 256, 0), words_(0) {}
+
+void MarkovModel::train(std::string_view word, uint32_t weight) {
+    if (word.empty() || weight == 0) {
+        return;
+    }
+    int previous = START;
+    for (size_t i = 0; i < word.size(); i++) {
+        const size_t position = std::min(i, POSITIONS - 1);
+        const unsigned char next = static_cast<unsigned char>(word[i]);
+        saturating_add(transitions_[(position * CONTEXTS + previous) * 256 + next], weight);
+        saturating_add(positional_[position * 256 + next], weight);
+        previous = next;
+    }
+    words_ += weight;
+}
+
+bool MarkovModel::train_file(const std::string& file_path, uint32_t weight) {
+    DictionarySource source;
+    if (!source.open(file_path)) {
+        last_error_ = source.get_last_error();
+        return false;
+    }
+    DictionaryCursor cursor = source.cursor();
+    std::string_view word;
+    while (cursor.next(word)) {
+        train(word, weight);
+    }
+    return true;
+}
+
+void MarkovModel::levels(size_t position, int previous, const std::string& chars, uint8_t* levels) const {
+    position = std::min(position, POSITIONS - 1);
+    const uint32_t* counts = &transitions_[(position * CONTEXTS + previous) * 256];
+    uint64_t total = 0;
+    for (unsigned char c : chars) {
+        total += counts[c];
+    }
+    if (total == 0) {
+        counts = &positional_[position * 256];
+    }
+
+    // Add-one smoothing keeps unseen characters a finite number of levels down
+    uint64_t most = 0;
+    for (unsigned char c : chars) {
+        most = std::max<uint64_t>(most, counts[c] + 1ull);
+    }
+    for (size_t i = 0; i < chars.size(); i++) {
+        const uint64_t count = counts[static_cast<unsigned char>(chars[i])] + 1ull;
+        uint8_t level = 0;
+        while (level < MAX_LEVEL && (count << (level + 1)) <= most) {
+            level++;
+        }
+        levels[i] = level;
+    }
+}
+
+std::string MarkovModel::digest() const {
+    // FNV-1a; the digest only has to tell trainings apart, not resist forgery
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto mix = [&hash](const std::vector<uint32_t>& counts) {
+        for (uint32_t count : counts) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                hash ^= (count >> shift) & 0xff;
+                hash *= 0x100000001b3ull;
+            }
+        }
+    };
+    mix(transitions_);
+    mix(positional_);
+
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    return hex;
+}
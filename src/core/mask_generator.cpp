@@ -0,0 +1,602 @@
+#include "core/mask_generator.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char* LOWERCASE = "abcdefghijklmnopqrstuvwxyz";
+const char* UPPERCASE = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+const char* DIGITS = "0123456789";
+const char* SYMBOLS = " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+// The documented "symbols" set for --charset, narrower than ?s
+const char* CONFIG_SYMBOLS = "!@#$%^&*()_+-=[]{}|;:,.<>?";
+
+const KeyspaceIndex KEYSPACE_MAX = ~static_cast<KeyspaceIndex>(0);
+
+// Keep first occurrences only so every character maps to exactly one digit
+std::string deduplicate(const std::string& chars) {
+    bool seen[256] = {false};
+    std::string unique;
+    for (unsigned char c : chars) {
+        if (!seen[c]) {
+            seen[c] = true;
+            unique += static_cast<char>(c);
+        }
+    }
+    return unique;
+}
+
+} // namespace
+
+bool MaskGenerator::expand_class(char symbol, std::string& chars) const {
+    switch (symbol) {
+        case 'l': chars += LOWERCASE; return true;
+        case 'u': chars += UPPERCASE; return true;
+        case 'd': chars += DIGITS; return true;
+        case 's': chars += SYMBOLS; return true;
+        case 'a': chars += std::string(LOWERCASE) + UPPERCASE + DIGITS + SYMBOLS; return true;
+        case 'h': chars += "0123456789abcdef"; return true;
+        case 'H': chars += "0123456789ABCDEF"; return true;
+        case '?': chars += '?'; return true;
+        default: return false;
+    }
+}
+
+bool MaskGenerator::expand_definition(const std::string& definition, bool allow_custom, std::string& chars) const {
+    for (size_t i = 0; i < definition.size(); i++) {
+        if (definition[i] != '?') {
+            chars += definition[i];
+            continue;
+        }
+        if (++i == definition.size()) {
+            last_error_ = "Mask ends with a bare '?'";
+            return false;
+        }
+
+        const char symbol = definition[i];
+        if (symbol >= '1' && symbol < '1' + CUSTOM_CHARSET_COUNT) {
+            const std::string& custom = custom_[symbol - '1'];
+            if (!allow_custom || custom.empty()) {
+                last_error_ = std::string("Custom charset ?") + symbol + " is not defined";
+                return false;
+            }
+            chars += custom;
+        } else if (!expand_class(symbol, chars)) {
+            last_error_ = std::string("Unknown mask class ?") + symbol;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MaskGenerator::set_custom_charset(int slot, const std::string& definition) {
+    if (slot < 1 || slot > CUSTOM_CHARSET_COUNT) {
+        last_error_ = "Custom charset slot must be 1-" + std::to_string(CUSTOM_CHARSET_COUNT);
+        return false;
+    }
+
+    std::string chars;
+    if (!expand_definition(definition, false, chars)) {
+        return false;
+    }
+    if (chars.empty()) {
+        last_error_ = "Custom charset ?" + std::to_string(slot) + " is empty";
+        return false;
+    }
+    custom_[slot - 1] = deduplicate(chars);
+    return true;
+}
+
+uint16_t MaskGenerator::intern_charset(const std::string& chars) {
+    for (size_t i = 0; i < charsets_.size(); i++) {
+        if (charsets_[i].chars == chars) {
+            return static_cast<uint16_t>(i);
+        }
+    }
+
+    Charset charset;
+    charset.chars = chars;
+    std::fill(std::begin(charset.position), std::end(charset.position), static_cast<int16_t>(-1));
+    for (size_t i = 0; i < chars.size(); i++) {
+        charset.position[static_cast<unsigned char>(chars[i])] = static_cast<int16_t>(i);
+    }
+    charsets_.push_back(charset);
+    return static_cast<uint16_t>(charsets_.size() - 1);
+}
+
+bool MaskGenerator::push_mask(std::vector<uint16_t> positions) {
+    if (positions.empty()) {
+        last_error_ = "Mask has no positions";
+        return false;
+    }
+    if (positions.size() > CandidateBatch::MAX_STRIDE - 1) {
+        last_error_ = "Mask is longer than the largest candidate slot";
+        return false;
+    }
+
+    KeyspaceIndex size = 1;
+    for (uint16_t id : positions) {
+        const KeyspaceIndex radix = charsets_[id].chars.size();
+        if (size > KEYSPACE_MAX / radix) {
+            last_error_ = "Mask keyspace exceeds 128 bits";
+            return false;
+        }
+        size *= radix;
+    }
+    if (total_size_ > KEYSPACE_MAX - size) {
+        last_error_ = "Combined keyspace exceeds 128 bits";
+        return false;
+    }
+
+    Mask mask;
+    mask.charsets = std::move(positions);
+    mask.size = size;
+    mask.offset = total_size_;
+    max_length_ = std::max(max_length_, mask.charsets.size());
+    total_size_ += size;
+    masks_.push_back(std::move(mask));
+    if (markov_) {
+        markov_masks_.push_back(build_markov_mask(masks_.back()));
+        build_markov_blocks();
+    }
+    return true;
+}
+
+bool MaskGenerator::add_mask(const std::string& mask) {
+    std::vector<uint16_t> positions;
+    for (size_t i = 0; i < mask.size(); i++) {
+        std::string chars;
+        if (mask[i] == '?') {
+            if (!expand_definition(mask.substr(i, 2), true, chars)) {
+                return false;
+            }
+            i++;
+        } else {
+            chars = mask[i];
+        }
+        positions.push_back(intern_charset(deduplicate(chars)));
+    }
+    return push_mask(std::move(positions));
+}
+
+bool MaskGenerator::add_charset_range(const std::string& charset, const std::string& custom_charset,
+                                      size_t min_length, size_t max_length,
+                                      const std::string& prefix, const std::string& suffix) {
+    std::string chars;
+    if (charset == "lowercase") {
+        chars = LOWERCASE;
+    } else if (charset == "uppercase") {
+        chars = UPPERCASE;
+    } else if (charset == "digits") {
+        chars = DIGITS;
+    } else if (charset == "symbols") {
+        chars = CONFIG_SYMBOLS;
+    } else if (charset == "mixed") {
+        chars = std::string(LOWERCASE) + UPPERCASE + DIGITS + CONFIG_SYMBOLS;
+    } else if (charset == "custom") {
+        chars = custom_charset;
+    } else {
+        last_error_ = "Unknown charset: " + charset;
+        return false;
+    }
+    chars = deduplicate(chars);
+    if (chars.empty()) {
+        last_error_ = "Charset is empty";
+        return false;
+    }
+
+    const size_t fixed = prefix.size() + suffix.size();
+    if (max_length < min_length || max_length < fixed) {
+        last_error_ = "Invalid length range";
+        return false;
+    }
+
+    const uint16_t free_id = intern_charset(chars);
+    for (size_t length = std::max(min_length, fixed); length <= max_length; length++) {
+        if (length == 0) {
+            continue;
+        }
+        std::vector<uint16_t> positions;
+        for (char c : prefix) positions.push_back(intern_charset(std::string(1, c)));
+        positions.insert(positions.end(), length - fixed, free_id);
+        for (char c : suffix) positions.push_back(intern_charset(std::string(1, c)));
+        if (!push_mask(std::move(positions))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MaskGenerator::set_markov_model(std::shared_ptr<const MarkovModel> model) {
+    markov_ = std::move(model);
+    markov_masks_.clear();
+    markov_blocks_.clear();
+    if (!markov_) {
+        return;
+    }
+    for (const Mask& mask : masks_) {
+        markov_masks_.push_back(build_markov_mask(mask));
+    }
+    build_markov_blocks();
+}
+
+MaskGenerator::MarkovMask MaskGenerator::build_markov_mask(const Mask& mask) const {
+    const size_t length = mask.charsets.size();
+    MarkovMask result;
+    result.positions.resize(length);
+    result.max_level = 0;
+
+    std::vector<uint8_t> levels;
+    for (size_t p = 0; p < length; p++) {
+        const Charset& charset = charsets_[mask.charsets[p]];
+        MarkovPosition& position = result.positions[p];
+        position.radix = charset.chars.size();
+        position.states = p == 0 ? 1 : charsets_[mask.charsets[p - 1]].chars.size();
+        position.order.resize(position.states * position.radix);
+        position.levels.resize(position.states * position.radix);
+        levels.resize(position.radix);
+
+        uint8_t deepest = 0;
+        for (size_t state = 0; state < position.states; state++) {
+            // Literal positions, such as a prefix, are certain and cost nothing
+            if (position.radix == 1) {
+                levels[0] = 0;
+            } else {
+                const int previous = p == 0 ? MarkovModel::START
+                                            : static_cast<unsigned char>(charsets_[mask.charsets[p - 1]].chars[state]);
+                markov_->levels(p, previous, charset.chars, levels.data());
+            }
+
+            uint16_t* order = &position.order[state * position.radix];
+            for (size_t digit = 0; digit < position.radix; digit++) {
+                order[digit] = static_cast<uint16_t>(digit);
+            }
+            std::stable_sort(order, order + position.radix,
+                             [&levels](uint16_t a, uint16_t b) { return levels[a] < levels[b]; });
+            for (size_t k = 0; k < position.radix; k++) {
+                position.levels[state * position.radix + k] = levels[order[k]];
+            }
+            deepest = std::max(deepest, position.levels[(state + 1) * position.radix - 1]);
+        }
+        result.max_level += deepest;
+    }
+
+    // Count completions from the last position back to the first
+    const size_t width = result.max_level + 1;
+    result.completions.resize(length + 1);
+    result.completions[length].assign(result.positions[length - 1].radix * width, 0);
+    for (size_t state = 0; state < result.positions[length - 1].radix; state++) {
+        result.completions[length][state * width] = 1;
+    }
+    for (size_t p = length; p-- > 0;) {
+        const MarkovPosition& position = result.positions[p];
+        const std::vector<KeyspaceIndex>& next = result.completions[p + 1];
+        std::vector<KeyspaceIndex>& ways = result.completions[p];
+        ways.assign(position.states * width, 0);
+        for (size_t state = 0; state < position.states; state++) {
+            for (size_t k = 0; k < position.radix; k++) {
+                const size_t entry = state * position.radix + k;
+                const uint16_t digit = position.order[entry];
+                const uint8_t level = position.levels[entry];
+                for (size_t sum = level; sum < width; sum++) {
+                    ways[state * width + sum] += next[digit * width + sum - level];
+                }
+            }
+        }
+    }
+    return result;
+}
+
+void MaskGenerator::build_markov_blocks() {
+    markov_blocks_.clear();
+    for (size_t m = 0; m < markov_masks_.size(); m++) {
+        const MarkovMask& mask = markov_masks_[m];
+        for (uint32_t level = 0; level <= mask.max_level; level++) {
+            const KeyspaceIndex size = mask.completions[0][level];
+            if (size > 0) {
+                markov_blocks_.push_back({static_cast<uint32_t>(m), level, size, 0});
+            }
+        }
+    }
+    std::stable_sort(markov_blocks_.begin(), markov_blocks_.end(),
+                     [](const MarkovBlock& a, const MarkovBlock& b) { return a.level < b.level; });
+    KeyspaceIndex offset = 0;
+    for (MarkovBlock& block : markov_blocks_) {
+        block.offset = offset;
+        offset += block.size;
+    }
+}
+
+void MaskGenerator::markov_candidate(const MarkovBlock& block, KeyspaceIndex local, uint8_t* out) const {
+    const MarkovMask& mask = markov_masks_[block.mask];
+    const Mask& positions = masks_[block.mask];
+    const size_t width = mask.max_level + 1;
+    size_t state = 0;
+    uint32_t left = block.level;
+
+    for (size_t p = 0; p < mask.positions.size(); p++) {
+        const MarkovPosition& position = mask.positions[p];
+        const std::vector<KeyspaceIndex>& next = mask.completions[p + 1];
+        const size_t base = state * position.radix;
+        uint16_t digit = position.order[base];
+        uint8_t level = position.levels[base];
+        // Skip whole sub-blocks until the one holding local
+        for (size_t k = 0; k < position.radix && position.levels[base + k] <= left; k++) {
+            digit = position.order[base + k];
+            level = position.levels[base + k];
+            const KeyspaceIndex ways = next[digit * width + left - level];
+            if (local < ways) {
+                break;
+            }
+            local -= ways;
+        }
+        out[p] = static_cast<uint8_t>(charsets_[positions.charsets[p]].chars[digit]);
+        left -= level;
+        state = digit;
+    }
+}
+
+bool MaskGenerator::markov_index_of(size_t mask_index, const std::string& candidate, KeyspaceIndex& index) const {
+    const MarkovMask& mask = markov_masks_[mask_index];
+    const size_t width = mask.max_level + 1;
+
+    // Where each digit sits in its position's order fixes the level sum
+    std::vector<size_t> ranks(candidate.size());
+    uint32_t total = 0;
+    size_t state = 0;
+    for (size_t p = 0; p < candidate.size(); p++) {
+        const MarkovPosition& position = mask.positions[p];
+        const int16_t digit = charsets_[masks_[mask_index].charsets[p]].position[static_cast<unsigned char>(candidate[p])];
+        const uint16_t* order = &position.order[state * position.radix];
+        ranks[p] = static_cast<size_t>(std::find(order, order + position.radix, digit) - order);
+        total += position.levels[state * position.radix + ranks[p]];
+        state = static_cast<size_t>(digit);
+    }
+
+    KeyspaceIndex local = 0;
+    uint32_t left = total;
+    state = 0;
+    for (size_t p = 0; p < candidate.size(); p++) {
+        const MarkovPosition& position = mask.positions[p];
+        const std::vector<KeyspaceIndex>& next = mask.completions[p + 1];
+        const size_t base = state * position.radix;
+        for (size_t k = 0; k < ranks[p]; k++) {
+            const uint8_t level = position.levels[base + k];
+            if (level > left) {
+                break;
+            }
+            local += next[position.order[base + k] * width + left - level];
+        }
+        left -= position.levels[base + ranks[p]];
+        state = position.order[base + ranks[p]];
+    }
+
+    for (const MarkovBlock& block : markov_blocks_) {
+        if (block.mask == mask_index && block.level == total) {
+            index = block.offset + local;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t MaskGenerator::find_mask(KeyspaceIndex index) const {
+    // Last mask whose offset is <= index
+    auto it = std::upper_bound(masks_.begin(), masks_.end(), index,
+                               [](KeyspaceIndex value, const Mask& mask) { return value < mask.offset; });
+    return static_cast<size_t>(it - masks_.begin()) - 1;
+}
+
+bool MaskGenerator::candidate_at(KeyspaceIndex index, std::string& candidate) const {
+    if (index >= total_size_) {
+        return false;
+    }
+
+    if (markov_) {
+        const MarkovBlock& block = markov_blocks_[find_markov_block(index)];
+        candidate.resize(masks_[block.mask].charsets.size());
+        markov_candidate(block, index - block.offset, reinterpret_cast<uint8_t*>(&candidate[0]));
+        return true;
+    }
+
+    const Mask& mask = masks_[find_mask(index)];
+    KeyspaceIndex local = index - mask.offset;
+    candidate.resize(mask.charsets.size());
+
+    // Mixed radix with the last position varying fastest
+    for (size_t p = mask.charsets.size(); p-- > 0;) {
+        const Charset& charset = charsets_[mask.charsets[p]];
+        const size_t radix = charset.chars.size();
+        candidate[p] = charset.chars[static_cast<size_t>(local % radix)];
+        local /= radix;
+    }
+    return true;
+}
+
+bool MaskGenerator::index_of(const std::string& candidate, KeyspaceIndex& index) const {
+    for (size_t m = 0; m < masks_.size(); m++) {
+        const Mask& mask = masks_[m];
+        if (mask.charsets.size() != candidate.size()) {
+            continue;
+        }
+
+        KeyspaceIndex local = 0;
+        bool matches = true;
+        for (size_t p = 0; p < candidate.size() && matches; p++) {
+            const Charset& charset = charsets_[mask.charsets[p]];
+            const int16_t digit = charset.position[static_cast<unsigned char>(candidate[p])];
+            matches = digit >= 0;
+            local = local * charset.chars.size() + static_cast<KeyspaceIndex>(matches ? digit : 0);
+        }
+        if (matches) {
+            if (markov_) {
+                return markov_index_of(m, candidate, index);
+            }
+            index = mask.offset + local;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t MaskGenerator::fill(KeyspaceIndex start, uint64_t count, CandidateBatch& batch) const {
+    if (start >= total_size_) {
+        return 0;
+    }
+    if (markov_) {
+        return fill_markov(start, count, batch);
+    }
+
+    size_t mask_index = find_mask(start);
+    uint16_t digits[CandidateBatch::MAX_STRIDE];
+    uint8_t* previous = nullptr;
+    size_t changed_from = 0;
+    size_t produced = 0;
+
+    // Seek once; everything after is odometer increments
+    {
+        const Mask& mask = masks_[mask_index];
+        KeyspaceIndex local = start - mask.offset;
+        for (size_t p = mask.charsets.size(); p-- > 0;) {
+            const size_t radix = charsets_[mask.charsets[p]].chars.size();
+            digits[p] = static_cast<uint16_t>(local % radix);
+            local /= radix;
+        }
+    }
+
+    while (produced < count) {
+        const Mask& mask = masks_[mask_index];
+        const size_t length = mask.charsets.size();
+        if (length > batch.max_length()) {
+            break;
+        }
+
+        uint8_t* slot = batch.append_raw_slot();
+        if (!slot) {
+            break;
+        }
+
+        if (previous) {
+            // Same mask as the previous slot: copy it, padding included, then
+            // rewrite only the positions the increment touched
+            std::memcpy(slot, previous, batch.max_length());
+        } else {
+            changed_from = 0;
+            std::memset(slot + length, 0, batch.max_length() - length);
+        }
+        for (size_t p = changed_from; p < length; p++) {
+            slot[p] = static_cast<uint8_t>(charsets_[mask.charsets[p]].chars[digits[p]]);
+        }
+        batch.set_length(batch.size() - 1, length);
+        produced++;
+
+        // Advance the odometer from the last position
+        size_t p = length;
+        while (p-- > 0) {
+            if (++digits[p] < charsets_[mask.charsets[p]].chars.size()) {
+                break;
+            }
+            digits[p] = 0;
+        }
+
+        if (p != static_cast<size_t>(-1)) {
+            previous = slot;
+            changed_from = p;
+            continue;
+        }
+
+        // This mask is exhausted; the next one starts from all-zero digits
+        if (++mask_index == masks_.size()) {
+            break;
+        }
+        std::fill(digits, digits + masks_[mask_index].charsets.size(), 0);
+        previous = nullptr;
+    }
+
+    return produced;
+}
+
+bool MaskGenerator::device_charsets(std::vector<uint8_t>& chars) const {
+    chars.clear();
+    for (const Charset& charset : charsets_) {
+        chars.insert(chars.end(), charset.chars.begin(), charset.chars.end());
+    }
+    if (chars.size() > DEVICE_MASK_MAX_CHARS) {
+        last_error_ = "Charsets exceed " + std::to_string(DEVICE_MASK_MAX_CHARS) + " characters";
+        return false;
+    }
+    return true;
+}
+
+bool MaskGenerator::device_segment(KeyspaceIndex start, uint64_t count, DeviceMaskSegment& segment) const {
+    // Markov order interleaves masks and digits, which the odometer walk cannot follow
+    if (markov_ || start >= total_size_ || count == 0) {
+        return false;
+    }
+    const Mask& mask = masks_[find_mask(start)];
+    const size_t length = mask.charsets.size();
+    if (length > DEVICE_MASK_MAX_LENGTH) {
+        last_error_ = "Mask is longer than " + std::to_string(DEVICE_MASK_MAX_LENGTH) + " positions";
+        return false;
+    }
+
+    // Charsets are flattened in id order, so each offset is the sum of the sizes before it
+    std::vector<uint16_t> offsets(charsets_.size());
+    size_t offset = 0;
+    for (size_t i = 0; i < charsets_.size(); i++) {
+        offsets[i] = static_cast<uint16_t>(offset);
+        offset += charsets_[i].chars.size();
+    }
+
+    const KeyspaceIndex local = start - mask.offset;
+    const KeyspaceIndex remaining = mask.size - local;
+    segment.length = static_cast<uint32_t>(length);
+    segment.count = static_cast<uint32_t>(std::min<KeyspaceIndex>(remaining, std::min<uint64_t>(count, UINT32_MAX)));
+    KeyspaceIndex digits = local;
+    for (size_t p = length; p-- > 0;) {
+        const size_t radix = charsets_[mask.charsets[p]].chars.size();
+        segment.charset_offset[p] = offsets[mask.charsets[p]];
+        segment.radix[p] = static_cast<uint16_t>(radix);
+        segment.start[p] = static_cast<uint16_t>(digits % radix);
+        digits /= radix;
+    }
+    return true;
+}
+
+size_t MaskGenerator::find_markov_block(KeyspaceIndex index) const {
+    auto it = std::upper_bound(markov_blocks_.begin(), markov_blocks_.end(), index,
+                               [](KeyspaceIndex value, const MarkovBlock& block) { return value < block.offset; });
+    return static_cast<size_t>(it - markov_blocks_.begin()) - 1;
+}
+
+size_t MaskGenerator::fill_markov(KeyspaceIndex start, uint64_t count, CandidateBatch& batch) const {
+    // Each candidate is decoded on its own; that costs charset-size steps
+    // per position, still nothing next to one KDF
+    size_t block_index = find_markov_block(start);
+    KeyspaceIndex local = start - markov_blocks_[block_index].offset;
+    size_t produced = 0;
+    while (produced < count) {
+        const MarkovBlock& block = markov_blocks_[block_index];
+        const size_t length = masks_[block.mask].charsets.size();
+        if (length > batch.max_length()) {
+            break;
+        }
+        uint8_t* slot = batch.append_raw_slot();
+        if (!slot) {
+            break;
+        }
+        std::memset(slot + length, 0, batch.max_length() - length);
+        markov_candidate(block, local, slot);
+        batch.set_length(batch.size() - 1, length);
+        produced++;
+
+        if (++local == block.size) {
+            if (++block_index == markov_blocks_.size()) {
+                break;
+            }
+            local = 0;
+        }
+    }
+    return produced;
+}
@@ -0,0 +1,265 @@
+#include "core/rule_engine.h"
+#include "utils/logger.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+std::string trim(const std::string& text) {
+    const size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    const size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+std::vector<std::string> split(const std::string& text, char separator) {
+    std::vector<std::string> parts;
+    std::string part;
+    std::istringstream stream(text);
+    while (std::getline(stream, part, separator)) {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+// Copy a word into a fresh output slot and transform it there; false if the
+// result was dropped and the slot handed back
+bool expand_into(const RuleEngine& rules, size_t rule, const uint8_t* word, size_t length,
+                 CandidateBatch& batch, uint8_t* slot) {
+    const size_t max_length = batch.max_length();
+    std::memcpy(slot, word, length);
+    const int result = rules.apply(rule, slot, length, max_length);
+    if (result < 0) {
+        batch.truncate(batch.size() - 1);
+        return false;
+    }
+    std::memset(slot + result, 0, max_length - result);
+    batch.set_length(batch.size() - 1, static_cast<size_t>(result));
+    return true;
+}
+
+} // namespace
+
+bool RuleEngine::load_file(const std::string& file_path) {
+    std::ifstream file(file_path);
+    if (!file.is_open()) {
+        last_error_ = "Cannot open rules file: " + file_path;
+        return false;
+    }
+
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        if (!add_line(line)) {
+            last_error_ = file_path + ":" + std::to_string(line_number) + ": " + last_error_;
+            return false;
+        }
+    }
+
+    LOG_DEBUG("Compiled " + std::to_string(size()) + " rules (" + std::to_string(bytecode_.size()) +
+                  " bytes) from " + file_path);
+    return true;
+}
+
+bool RuleEngine::add_line(const std::string& line) {
+    const std::string text = trim(line);
+    if (text.empty() || text[0] == '#') {
+        return true;
+    }
+
+    // name:$word:t1,t2,... expands to one rule per transformation; anything
+    // else is a single rule
+    const size_t first = text.find(':');
+    const size_t second = first == std::string::npos ? first : text.find(':', first + 1);
+    if (second == std::string::npos || text.substr(first + 1, second - first - 1) != "$word") {
+        return add_rule(text);
+    }
+
+    std::vector<std::vector<uint8_t>> programs;
+    size_t total = 0;
+    for (const std::string& transformation : split(text.substr(second + 1), ',')) {
+        std::vector<uint8_t> program;
+        if (!compile(trim(transformation), program)) {
+            return false;
+        }
+        total += program.size();
+        programs.push_back(std::move(program));
+    }
+    if (programs.empty()) {
+        last_error_ = "Rule " + text.substr(0, first) + " has no transformations";
+        return false;
+    }
+
+    // All of a line's rules are added or none are
+    if (size() + programs.size() > RULE_MAX_RULES || bytecode_.size() + total > RULE_MAX_BYTECODE) {
+        last_error_ = "Too many rules";
+        return false;
+    }
+    for (const auto& program : programs) {
+        offsets_.push_back(static_cast<uint32_t>(bytecode_.size()));
+        bytecode_.insert(bytecode_.end(), program.begin(), program.end());
+    }
+    return true;
+}
+
+bool RuleEngine::add_rule(const std::string& rule) {
+    std::vector<uint8_t> program;
+    if (!compile(trim(rule), program)) {
+        return false;
+    }
+    if (size() >= RULE_MAX_RULES || bytecode_.size() + program.size() > RULE_MAX_BYTECODE) {
+        last_error_ = "Too many rules";
+        return false;
+    }
+    offsets_.push_back(static_cast<uint32_t>(bytecode_.size()));
+    bytecode_.insert(bytecode_.end(), program.begin(), program.end());
+    return true;
+}
+
+bool RuleEngine::compile(const std::string& rule, std::vector<uint8_t>& program) {
+    std::istringstream stream(rule);
+    std::string operation;
+    bool any = false;
+    while (stream >> operation) {
+        if (!compile_operation(operation, program)) {
+            return false;
+        }
+        any = true;
+    }
+    if (!any) {
+        last_error_ = "Empty rule";
+        return false;
+    }
+
+    program.push_back(RULE_OP_END);
+    if (program.size() > RULE_MAX_PROGRAM_LENGTH) {
+        last_error_ = "Rule is too long: " + rule;
+        return false;
+    }
+    return true;
+}
+
+bool RuleEngine::compile_operation(const std::string& operation, std::vector<uint8_t>& program) {
+    // sXY comes first: "sa$" replaces a with $, it does not prepend "sa"
+    if (operation.size() == 3 && operation[0] == 's') {
+        program.push_back(RULE_OP_SUBSTITUTE);
+        program.push_back(static_cast<uint8_t>(operation[1]));
+        program.push_back(static_cast<uint8_t>(operation[2]));
+        return true;
+    }
+
+    // $text appends and text$ prepends; the text may be several characters
+    const bool append = operation.size() > 1 && operation.front() == '$';
+    const bool prepend = !append && operation.size() > 1 && operation.back() == '$';
+    if (append || prepend) {
+        const std::string text = append ? operation.substr(1) : operation.substr(0, operation.size() - 1);
+        if (text.size() > CandidateBatch::MAX_STRIDE - 1) {
+            last_error_ = "Rule text is too long: " + operation;
+            return false;
+        }
+        program.push_back(append ? RULE_OP_APPEND : RULE_OP_PREPEND);
+        program.push_back(static_cast<uint8_t>(text.size()));
+        program.insert(program.end(), text.begin(), text.end());
+        return true;
+    }
+
+    if (operation.size() == 1) {
+        switch (operation[0]) {
+            case ':': program.push_back(RULE_OP_NOOP); return true;
+            case 'l': program.push_back(RULE_OP_LOWER); return true;
+            case 'u': program.push_back(RULE_OP_UPPER); return true;
+            case 'c': program.push_back(RULE_OP_CAPITALIZE); return true;
+            case 't': program.push_back(RULE_OP_TOGGLE_CASE); return true;
+            case 'r': program.push_back(RULE_OP_REVERSE); return true;
+            case 'd': program.push_back(RULE_OP_DUPLICATE); return true;
+            default: break;
+        }
+    }
+
+    last_error_ = "Unknown rule operation: " + operation;
+    return false;
+}
+
+bool RuleEngine::apply(size_t rule, std::string_view word, std::string& result) const {
+    const size_t max_length = CandidateBatch::MAX_STRIDE - 1;
+    if (word.size() > max_length) {
+        return false;
+    }
+
+    uint8_t buffer[CandidateBatch::MAX_STRIDE];
+    std::memcpy(buffer, word.data(), word.size());
+    const int length = apply(rule, buffer, word.size(), max_length);
+    if (length < 0) {
+        return false;
+    }
+    result.assign(reinterpret_cast<const char*>(buffer), static_cast<size_t>(length));
+    return true;
+}
+
+size_t RuleEngine::expand(const CandidateBatch& words, size_t& word_index, size_t& rule_index,
+                          CandidateBatch& batch) const {
+    size_t appended = 0;
+    if (empty()) {
+        return appended;
+    }
+
+    while (word_index < words.size() && !batch.full()) {
+        const size_t length = words.length(word_index);
+        if (length <= batch.max_length()) {
+            while (rule_index < size()) {
+                uint8_t* slot = batch.append_raw_slot();
+                if (!slot) {
+                    return appended;
+                }
+                if (expand_into(*this, rule_index++, words.data(word_index), length, batch, slot)) {
+                    appended++;
+                }
+            }
+        }
+        word_index++;
+        rule_index = 0;
+    }
+    return appended;
+}
+
+RuleExpander::RuleExpander(const RuleEngine& rules, DictionaryCursor& words, size_t first_rule)
+    : rules_(rules), words_(words), word_offset_(words.offset()), rule_(first_rule),
+      has_word_(false), rejected_(0) {}
+
+size_t RuleExpander::fill(CandidateBatch& batch) {
+    size_t appended = 0;
+    while (!batch.full()) {
+        if (!has_word_) {
+            word_offset_ = words_.offset();
+            if (!words_.next(word_)) {
+                break;
+            }
+            has_word_ = true;
+        }
+
+        if (word_.size() <= batch.max_length()) {
+            const uint8_t* word = reinterpret_cast<const uint8_t*>(word_.data());
+            while (rule_ < rules_.size()) {
+                uint8_t* slot = batch.append_raw_slot();
+                if (!slot) {
+                    return appended;
+                }
+                if (expand_into(rules_, rule_++, word, word_.size(), batch, slot)) {
+                    appended++;
+                } else {
+                    rejected_++;
+                }
+            }
+        } else {
+            rejected_ += rules_.size() - rule_;
+        }
+
+        has_word_ = false;
+        rule_ = 0;
+    }
+    return appended;
+}
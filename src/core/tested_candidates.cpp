@@ -0,0 +1,423 @@
+#include "core/tested_candidates.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <queue>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char INDEX_MAGIC[8] = {'B', 'T', 'C', 'R', 'T', 'I', 'D', 'X'};
+const uint32_t INDEX_VERSION = 1;
+
+// Magic, version, reserved word and wallet key; a multiple of 8 so the
+// fingerprints of every run stay aligned in the mapping
+const size_t HEADER_SIZE = 48;
+
+const char* WALLET_KEY_DOMAIN = "btc-recovery tested candidates";
+
+// Fingerprints written per fwrite while merging runs
+const size_t WRITE_BUFFER_ENTRIES = 8192;
+
+void derive_wallet_key(const uint8_t* salt, size_t salt_length, uint32_t iterations, uint8_t key[32]) {
+    SHA256Context ctx;
+    sha256_init(ctx);
+    sha256_update(ctx, reinterpret_cast<const uint8_t*>(WALLET_KEY_DOMAIN), std::strlen(WALLET_KEY_DOMAIN));
+    uint8_t count[4] = {static_cast<uint8_t>(iterations), static_cast<uint8_t>(iterations >> 8),
+                        static_cast<uint8_t>(iterations >> 16), static_cast<uint8_t>(iterations >> 24)};
+    sha256_update(ctx, count, sizeof(count));
+    sha256_update(ctx, salt, salt_length);
+    sha256_final(ctx, key);
+}
+
+void make_header(const uint8_t wallet_key[32], uint8_t header[HEADER_SIZE]) {
+    std::memset(header, 0, HEADER_SIZE);
+    std::memcpy(header, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    std::memcpy(header + 8, &INDEX_VERSION, sizeof(INDEX_VERSION));
+    std::memcpy(header + 16, wallet_key, 32);
+}
+
+// Force a written file to disk and close it
+bool sync_and_close(FILE* file, bool written) {
+    written = written && std::fflush(file) == 0;
+#ifdef _WIN32
+    written = written && _commit(_fileno(file)) == 0;
+#else
+    written = written && fsync(fileno(file)) == 0;
+#endif
+    return (std::fclose(file) == 0) && written;
+}
+
+} // namespace
+
+std::string TestedCandidateIndex::default_directory() {
+#ifdef _WIN32
+    const char* base = std::getenv("LOCALAPPDATA");
+    const std::string directory = base ? std::string(base) : std::string(".");
+#else
+    const char* data = std::getenv("XDG_DATA_HOME");
+    const char* home = std::getenv("HOME");
+    const std::string directory = (data && *data) ? std::string(data)
+                                : home ? std::string(home) + "/.local/share" : std::string(".");
+#endif
+    return directory + "/btc-recovery/tested";
+}
+
+std::string TestedCandidateIndex::file_name(const uint8_t* salt, size_t salt_length, uint32_t iterations) {
+    uint8_t key[32];
+    derive_wallet_key(salt, salt_length, iterations, key);
+    static const char* digits = "0123456789abcdef";
+    std::string name;
+    for (size_t i = 0; i < 16; i++) {
+        name += digits[key[i] >> 4];
+        name += digits[key[i] & 0x0f];
+    }
+    return name + ".tested";
+}
+
+TestedCandidateIndex::~TestedCandidateIndex() {
+    close();
+}
+
+bool TestedCandidateIndex::open(const std::string& file_path, const uint8_t* salt, size_t salt_length,
+                                uint32_t iterations) {
+    close();
+    file_path_ = file_path;
+    derive_wallet_key(salt, salt_length, iterations, wallet_key_);
+
+    // A full block of key and padding, so each fingerprint starts from a
+    // midstate and short candidates cost one compression
+    const uint8_t zeros[32] = {};
+    sha256_init(keyed_);
+    sha256_update(keyed_, wallet_key_, sizeof(wallet_key_));
+    sha256_update(keyed_, zeros, sizeof(zeros));
+
+    std::error_code exists_error;
+    if (!std::filesystem::exists(file_path_, exists_error)) {
+        std::error_code error;
+        const std::filesystem::path parent = std::filesystem::path(file_path_).parent_path();
+        if (!parent.empty()) {
+            std::filesystem::create_directories(parent, error);
+        }
+        if (!rewrite({})) {
+            return false;
+        }
+    } else {
+        bool torn = false;
+        if (!map_runs(torn)) {
+            return false;
+        }
+        // An interrupted flush left a partial run; the next flush rewrites the file without it
+        if (torn) {
+            Logger::warn("Ignoring an incomplete run at the end of " + file_path_);
+            needs_rewrite_ = true;
+        }
+    }
+
+    opened_ = true;
+    LOG_DEBUG("Tested-candidate index " + file_path_ + ": " + std::to_string(stored_) + " candidates in " +
+              std::to_string(runs_.size()) + " runs");
+    return true;
+}
+
+void TestedCandidateIndex::close() {
+    if (opened_ && !flush()) {
+        Logger::warn(last_error_);
+    }
+    std::lock_guard<std::mutex> guard(lock_);
+    file_.close();
+    runs_.clear();
+    stored_ = 0;
+    pending_.clear();
+    needs_rewrite_ = false;
+    opened_ = false;
+}
+
+uint64_t TestedCandidateIndex::fingerprint(const uint8_t* data, size_t length) const {
+    SHA256Context ctx = keyed_;
+    sha256_update(ctx, data, length);
+    uint8_t digest[32];
+    sha256_final(ctx, digest);
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | digest[i];
+    }
+    return value;
+}
+
+bool TestedCandidateIndex::contains(const uint8_t* data, size_t length) const {
+    const uint64_t print = fingerprint(data, length);
+    std::lock_guard<std::mutex> guard(lock_);
+    return pending_.count(print) > 0 || stored_contains(print);
+}
+
+size_t TestedCandidateIndex::filter(CandidateBatch& batch) const {
+    const size_t count = batch.size();
+    if (count == 0) {
+        return 0;
+    }
+
+    // Hash outside the lock; sorted lookups walk each run front to back
+    std::vector<std::pair<uint64_t, size_t>> prints(count);
+    for (size_t i = 0; i < count; i++) {
+        prints[i] = {fingerprint(batch.data(i), batch.length(i)), i};
+    }
+    std::sort(prints.begin(), prints.end());
+
+    std::vector<uint8_t> keep(count, 1);
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        std::vector<const uint64_t*> cursors;
+        cursors.reserve(runs_.size());
+        for (const auto& run : runs_) {
+            cursors.push_back(run.begin);
+        }
+
+        for (size_t k = 0; k < count; k++) {
+            const uint64_t print = prints[k].first;
+            // Equal fingerprints sort by position, so the first copy is kept
+            bool tested = (k > 0 && prints[k - 1].first == print) || pending_.count(print) > 0;
+            for (size_t r = 0; r < runs_.size() && !tested; r++) {
+                cursors[r] = std::lower_bound(cursors[r], runs_[r].end, print);
+                tested = cursors[r] != runs_[r].end && *cursors[r] == print;
+            }
+            if (tested) {
+                keep[prints[k].second] = 0;
+            }
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (keep[i]) {
+            if (kept != i) {
+                std::memcpy(batch.slot(kept), batch.slot(i), batch.stride());
+            }
+            kept++;
+        }
+    }
+    batch.truncate(kept);
+    return count - kept;
+}
+
+void TestedCandidateIndex::record(const CandidateBatch& batch) {
+    std::vector<uint64_t> prints(batch.size());
+    for (size_t i = 0; i < batch.size(); i++) {
+        prints[i] = fingerprint(batch.data(i), batch.length(i));
+    }
+    std::lock_guard<std::mutex> guard(lock_);
+    pending_.insert(prints.begin(), prints.end());
+}
+
+void TestedCandidateIndex::record(const uint8_t* data, size_t length) {
+    const uint64_t print = fingerprint(data, length);
+    std::lock_guard<std::mutex> guard(lock_);
+    pending_.insert(print);
+}
+
+bool TestedCandidateIndex::flush() {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (!opened_) {
+        last_error_ = "Tested-candidate index is not open";
+        return false;
+    }
+    if (pending_.empty() && !needs_rewrite_) {
+        return true;
+    }
+
+    // Runs stay disjoint, which keeps size() exact and merges simple
+    std::vector<uint64_t> fresh;
+    fresh.reserve(pending_.size());
+    for (uint64_t print : pending_) {
+        if (!stored_contains(print)) {
+            fresh.push_back(print);
+        }
+    }
+    std::sort(fresh.begin(), fresh.end());
+
+    bool written = true;
+    if (needs_rewrite_ || runs_.size() >= MAX_RUNS) {
+        written = rewrite(fresh);
+    } else if (!fresh.empty()) {
+        written = append_run(fresh);
+    }
+    if (!written) {
+        return false;
+    }
+    pending_.clear();
+    return true;
+}
+
+uint64_t TestedCandidateIndex::size() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return stored_ + pending_.size();
+}
+
+size_t TestedCandidateIndex::pending_count() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return pending_.size();
+}
+
+size_t TestedCandidateIndex::run_count() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return runs_.size();
+}
+
+bool TestedCandidateIndex::map_runs(bool& torn) {
+    runs_.clear();
+    stored_ = 0;
+    torn = false;
+    if (!file_.open(file_path_)) {
+        last_error_ = "Cannot open tested-candidate index: " + file_path_;
+        return false;
+    }
+
+    const uint8_t* data = file_.data();
+    const size_t size = file_.size();
+    uint32_t version = 0;
+    if (size >= HEADER_SIZE) {
+        std::memcpy(&version, data + 8, sizeof(version));
+    }
+    if (size < HEADER_SIZE || std::memcmp(data, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+        version != INDEX_VERSION) {
+        last_error_ = "Not a tested-candidate index: " + file_path_;
+        file_.close();
+        return false;
+    }
+    if (std::memcmp(data + 16, wallet_key_, sizeof(wallet_key_)) != 0) {
+        last_error_ = "Tested-candidate index " + file_path_ + " belongs to a different wallet";
+        file_.close();
+        return false;
+    }
+
+    size_t offset = HEADER_SIZE;
+    while (offset < size) {
+        uint64_t count = 0;
+        if (size - offset < sizeof(count)) {
+            torn = true;
+            break;
+        }
+        std::memcpy(&count, data + offset, sizeof(count));
+        offset += sizeof(count);
+        if (count > (size - offset) / sizeof(uint64_t)) {
+            torn = true;
+            break;
+        }
+        const uint64_t* begin = reinterpret_cast<const uint64_t*>(data + offset);
+        runs_.push_back({begin, begin + count});
+        stored_ += count;
+        offset += count * sizeof(uint64_t);
+    }
+    return true;
+}
+
+bool TestedCandidateIndex::stored_contains(uint64_t fingerprint) const {
+    for (const auto& run : runs_) {
+        if (std::binary_search(run.begin, run.end, fingerprint)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TestedCandidateIndex::append_run(const std::vector<uint64_t>& fingerprints) {
+    FILE* file = std::fopen(file_path_.c_str(), "ab");
+    if (!file) {
+        last_error_ = "Cannot append to tested-candidate index: " + file_path_;
+        return false;
+    }
+    const uint64_t count = fingerprints.size();
+    bool written = std::fwrite(&count, sizeof(count), 1, file) == 1 &&
+                   std::fwrite(fingerprints.data(), sizeof(uint64_t), fingerprints.size(), file) ==
+                       fingerprints.size();
+    if (!sync_and_close(file, written)) {
+        // Whatever reached the file is a torn run now
+        needs_rewrite_ = true;
+        last_error_ = "Cannot write tested-candidate index: " + file_path_;
+        return false;
+    }
+
+    bool torn = false;
+    return map_runs(torn);
+}
+
+bool TestedCandidateIndex::rewrite(const std::vector<uint64_t>& extra) {
+    const std::string temp_path = file_path_ + ".tmp";
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        last_error_ = "Cannot create tested-candidate index: " + temp_path;
+        return false;
+    }
+
+    uint8_t header[HEADER_SIZE];
+    make_header(wallet_key_, header);
+    bool written = std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+
+    std::vector<Run> sources = runs_;
+    if (!extra.empty()) {
+        sources.push_back({extra.data(), extra.data() + extra.size()});
+    }
+    const uint64_t total = stored_ + extra.size();
+    if (total > 0) {
+        written = written && std::fwrite(&total, sizeof(total), 1, file) == 1;
+
+        // k-way merge of sorted, disjoint runs
+        using Head = std::pair<uint64_t, size_t>;
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+        for (size_t s = 0; s < sources.size(); s++) {
+            if (sources[s].begin != sources[s].end) {
+                heads.push({*sources[s].begin, s});
+            }
+        }
+        std::vector<uint64_t> buffer;
+        buffer.reserve(WRITE_BUFFER_ENTRIES);
+        while (!heads.empty() && written) {
+            const Head head = heads.top();
+            heads.pop();
+            buffer.push_back(head.first);
+            if (++sources[head.second].begin != sources[head.second].end) {
+                heads.push({*sources[head.second].begin, head.second});
+            }
+            if (buffer.size() == WRITE_BUFFER_ENTRIES || heads.empty()) {
+                written = std::fwrite(buffer.data(), sizeof(uint64_t), buffer.size(), file) == buffer.size();
+                buffer.clear();
+            }
+        }
+    }
+    if (!sync_and_close(file, written)) {
+        std::remove(temp_path.c_str());
+        last_error_ = "Cannot write tested-candidate index: " + temp_path;
+        return false;
+    }
+
+    // The merged runs point into the old mapping, which must go before the rename
+    file_.close();
+    runs_.clear();
+    stored_ = 0;
+    bool torn = false;
+    std::error_code error;
+    std::filesystem::rename(temp_path, file_path_, error);
+    if (error) {
+        // Keep serving the previous file
+        std::remove(temp_path.c_str());
+        const std::string message = "Cannot replace tested-candidate index: " + file_path_;
+        map_runs(torn);
+        last_error_ = message;
+        return false;
+    }
+
+    if (!map_runs(torn)) {
+        return false;
+    }
+    needs_rewrite_ = false;
+    return true;
+}
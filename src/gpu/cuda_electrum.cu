@@ -0,0 +1,442 @@
+#ifdef ENABLE_CUDA
+
+#include <cuda_runtime.h>
+#include <device_launch_parameters.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "core/candidate_batch.h"
+#include "core/device_mask.h"
+#include "core/mask_generator.h"
+#include "core/rule_bytecode.h"
+#include "utils/logger.h"
+#include "utils/sha256d.h"
+#include "wallets/electrum_key.h"
+
+namespace {
+
+const int THREADS_PER_BLOCK = 256;
+
+// Consecutive mask candidates per thread: one division-based seek, then
+// odometer increments that rewrite only the message bytes that changed
+const uint32_t CANDIDATES_PER_THREAD = 64;
+
+// Mask candidates per launch, so a found password or a cancel is noticed
+// within a fraction of a second even on the fastest devices
+const uint64_t MAX_LAUNCH_CANDIDATES = 1ull << 30;
+
+const unsigned int NOT_FOUND = UINT_MAX;
+
+} // namespace
+
+// Seed verification record, uploaded once per wallet
+__constant__ ElectrumKeyCheck c_electrum_check;
+
+// MaskGenerator::device_charsets(), uploaded once per keyspace
+__constant__ uint8_t c_mask_charsets[DEVICE_MASK_MAX_CHARS];
+
+// Compiled rule programs (RuleEngine::bytecode/offsets), uploaded once per rules file
+__constant__ uint8_t c_electrum_rule_bytecode[RULE_MAX_BYTECODE];
+__constant__ uint32_t c_electrum_rule_offsets[RULE_MAX_RULES];
+
+__device__ __forceinline__ bool electrum_check_words(uint32_t w[16]) {
+    uint32_t state[8];
+    uint8_t key[32];
+    sha256d_short_words(w, state);
+    sha256_store_digest(state, key);
+    return electrum_check_derived_key(c_electrum_check, key);
+}
+
+__device__ __forceinline__ void sha256_set_message_byte(uint32_t w[16], uint32_t index, uint8_t value) {
+    const uint32_t shift = 24 - 8 * (index & 3);
+    w[index >> 2] = (w[index >> 2] & ~(0xffu << shift)) | (static_cast<uint32_t>(value) << shift);
+}
+
+// Mask generation fused with verification: each thread seeks once to its
+// run of the segment and walks it odometer-style, so neither candidates
+// nor their hashes ever leave the device; only the index of a match does.
+// Every mask candidate fits one SHA-256 block (DEVICE_MASK_MAX_LENGTH <=
+// SHA256D_SHORT_MAX), so the padded block is kept in registers and the
+// increment patches just the positions that changed.
+__global__ void cuda_electrum_mask(DeviceMaskSegment segment, unsigned int* found_index) {
+    const uint32_t first = (blockIdx.x * blockDim.x + threadIdx.x) * CANDIDATES_PER_THREAD;
+    if (first >= segment.count) {
+        return;
+    }
+    const uint32_t last = min(segment.count, first + CANDIDATES_PER_THREAD);
+
+    uint16_t digits[DEVICE_MASK_MAX_LENGTH];
+    uint8_t candidate[DEVICE_MASK_MAX_LENGTH];
+    device_mask_digits(segment, first, digits);
+    device_mask_write(segment, c_mask_charsets, digits, candidate);
+    uint32_t block[16];
+    sha256_pad_short(candidate, segment.length, block);
+
+    for (uint32_t i = first; i < last; i++) {
+        // Stop picking up new candidates once any thread has a match
+        if (*(volatile unsigned int*)found_index != NOT_FOUND) {
+            return;
+        }
+        if (i > first) {
+            for (int p = device_mask_increment(segment, digits); p < (int)segment.length; p++) {
+                sha256_set_message_byte(block, p, c_mask_charsets[segment.charset_offset[p] + digits[p]]);
+            }
+        }
+
+        uint32_t w[16];
+        for (int j = 0; j < 16; j++) {
+            w[j] = block[j];
+        }
+        if (electrum_check_words(w)) {
+            atomicMin(found_index, i);
+            return;
+        }
+    }
+}
+
+// Host-generated candidates in the CandidateBatch slot layout, for keyspaces
+// the device cannot enumerate itself (Markov order, dictionaries)
+__global__ void cuda_electrum_batch(const unsigned char* candidates, int candidate_stride, int num_candidates,
+                                    unsigned int* found_index) {
+    int tid = blockIdx.x * blockDim.x + threadIdx.x;
+    int stride = blockDim.x * gridDim.x;
+
+    for (int i = tid; i < num_candidates; i += stride) {
+        if (*(volatile unsigned int*)found_index != NOT_FOUND) {
+            return;
+        }
+        const unsigned char* slot = candidates + (size_t)i * candidate_stride;
+        if (electrum_check_password(c_electrum_check, slot + 1, slot[0])) {
+            atomicMin(found_index, (unsigned int)i);
+            return;
+        }
+    }
+}
+
+// Rule expansion fused with verification, as in cuda_recovery.cu: only the
+// base words cross the bus and candidate i is rule (i / num_words) applied
+// to word (i % num_words)
+__global__ void cuda_electrum_rules(const unsigned char* words, int word_stride, int num_words, int rule_count,
+                                    unsigned int* found_index) {
+    int tid = blockIdx.x * blockDim.x + threadIdx.x;
+    int stride = blockDim.x * gridDim.x;
+    const int total = num_words * rule_count;
+
+    for (int i = tid; i < total; i += stride) {
+        if (*(volatile unsigned int*)found_index != NOT_FOUND) {
+            return;
+        }
+
+        const int rule = i / num_words;
+        const unsigned char* slot = words + (size_t)(i - rule * num_words) * word_stride;
+        uint8_t candidate[CandidateBatch::MAX_STRIDE];
+        int length = slot[0];
+        for (int j = 0; j < length; j++) {
+            candidate[j] = slot[1 + j];
+        }
+
+        length = rule_apply(c_electrum_rule_bytecode + c_electrum_rule_offsets[rule], candidate, length,
+                            word_stride - 1);
+        if (length >= 0 && electrum_check_password(c_electrum_check, candidate, length)) {
+            atomicMin(found_index, (unsigned int)i);
+            return;
+        }
+    }
+}
+
+static_assert(DEVICE_MASK_MAX_LENGTH <= SHA256D_SHORT_MAX, "Every device mask candidate fits one SHA-256 block");
+
+/**
+ * Electrum seed verification on one CUDA device
+ *
+ * SHA-256d and the first-block AES check are cheap enough that moving
+ * candidates over PCIe would cost more than testing them, so brute-force
+ * masks are generated on the device from the flattened charsets and a
+ * per-segment start, and dictionary words are expanded by rules on the
+ * device. Only a match index comes back, which the host turns into the
+ * password and confirms with a full decrypt.
+ */
+class CUDAElectrumEngine {
+public:
+    CUDAElectrumEngine()
+        : device_id_(-1), d_found_(nullptr), d_candidates_(nullptr), candidate_bytes_(0), rule_count_(0),
+          charsets_loaded_(false), initialized_(false) {}
+
+    ~CUDAElectrumEngine() {
+        cleanup();
+    }
+
+    /**
+     * Select a device and upload the wallet's verification record
+     * @param device_id CUDA device index
+     * @param check Record from ElectrumWallet::get_key_check
+     * @return true if successful
+     */
+    bool initialize(int device_id, const ElectrumKeyCheck& check) {
+        cleanup();
+        device_id_ = device_id;
+
+        cudaError_t error = cudaSetDevice(device_id);
+        cudaDeviceProp props;
+        if (error == cudaSuccess) {
+            error = cudaGetDeviceProperties(&props, device_id);
+        }
+        if (error == cudaSuccess) {
+            error = cudaMemcpyToSymbol(c_electrum_check, &check, sizeof(check));
+        }
+        if (error == cudaSuccess) {
+            error = cudaMalloc(&d_found_, sizeof(unsigned int));
+        }
+        if (error != cudaSuccess) {
+            Logger::error("Failed to initialize CUDA Electrum verifier on device " + std::to_string(device_id) +
+                          ": " + std::string(cudaGetErrorString(error)));
+            cleanup();
+            return false;
+        }
+
+        initialized_ = true;
+        Logger::info("CUDA Electrum verifier initialized for device: " + std::string(props.name));
+        return true;
+    }
+
+    /**
+     * Upload a keyspace's charsets for test_range()
+     * @return false if the keyspace cannot be generated on the device: Markov
+     *         order, masks over DEVICE_MASK_MAX_LENGTH or oversized charsets
+     */
+    bool upload_mask(const MaskGenerator& generator) {
+        charsets_loaded_ = false;
+        if (!initialized_ || generator.is_markov_ordered() || generator.max_length() > DEVICE_MASK_MAX_LENGTH) {
+            return false;
+        }
+        std::vector<uint8_t> charsets;
+        if (!generator.device_charsets(charsets)) {
+            Logger::error(generator.get_last_error());
+            return false;
+        }
+        cudaError_t error = cudaSetDevice(device_id_);
+        if (error == cudaSuccess && !charsets.empty()) {
+            error = cudaMemcpyToSymbol(c_mask_charsets, charsets.data(), charsets.size());
+        }
+        if (error != cudaSuccess) {
+            Logger::error("Failed to upload mask charsets: " + std::string(cudaGetErrorString(error)));
+            return false;
+        }
+        charsets_loaded_ = true;
+        return true;
+    }
+
+    /**
+     * Test a range of an uploaded mask keyspace, generated on the device
+     * @param generator Keyspace passed to upload_mask()
+     * @param range Candidates to test
+     * @param found_password Set to the matching candidate
+     * @return true if a candidate matched
+     */
+    bool test_range(const MaskGenerator& generator, const KeyspaceRange& range, std::string& found_password) {
+        if (!initialized_ || !charsets_loaded_ || range.empty() || cudaSetDevice(device_id_) != cudaSuccess) {
+            return false;
+        }
+
+        for (KeyspaceIndex next = range.begin; next < range.end; ) {
+            const KeyspaceIndex left = range.end - next;
+            DeviceMaskSegment segment;
+            if (!generator.device_segment(next, left < MAX_LAUNCH_CANDIDATES ? (uint64_t)left : MAX_LAUNCH_CANDIDATES,
+                                          segment)) {
+                Logger::error("Keyspace cannot be generated on the device: " + generator.get_last_error());
+                return false;
+            }
+
+            const uint64_t threads = (segment.count + CANDIDATES_PER_THREAD - 1) / CANDIDATES_PER_THREAD;
+            const unsigned int blocks = (unsigned int)((threads + THREADS_PER_BLOCK - 1) / THREADS_PER_BLOCK);
+            unsigned int found = NOT_FOUND;
+            cudaError_t error = cudaMemcpy(d_found_, &found, sizeof(found), cudaMemcpyHostToDevice);
+            if (error == cudaSuccess) {
+                cuda_electrum_mask<<<blocks, THREADS_PER_BLOCK>>>(segment, d_found_);
+                error = cudaGetLastError();
+            }
+            if (error == cudaSuccess) {
+                error = cudaMemcpy(&found, d_found_, sizeof(found), cudaMemcpyDeviceToHost);
+            }
+            if (error != cudaSuccess) {
+                Logger::error("CUDA Electrum mask kernel failed: " + std::string(cudaGetErrorString(error)));
+                return false;
+            }
+
+            if (found != NOT_FOUND) {
+                return generator.candidate_at(next + found, found_password);
+            }
+            next += segment.count;
+        }
+        return false;
+    }
+
+    /**
+     * Upload compiled rules for test_words()
+     * @param rule_count Number of rules; 0 tests words as-is
+     * @return true if successful
+     */
+    bool upload_rules(const uint8_t* bytecode, size_t bytecode_size, const uint32_t* offsets, size_t rule_count) {
+        rule_count_ = 0;
+        if (rule_count == 0) {
+            return true;
+        }
+        if (!initialized_ || bytecode_size > RULE_MAX_BYTECODE || rule_count > RULE_MAX_RULES) {
+            Logger::error("Rule set exceeds the device limits");
+            return false;
+        }
+
+        cudaError_t error = cudaSetDevice(device_id_);
+        if (error == cudaSuccess) {
+            error = cudaMemcpyToSymbol(c_electrum_rule_bytecode, bytecode, bytecode_size);
+        }
+        if (error == cudaSuccess) {
+            error = cudaMemcpyToSymbol(c_electrum_rule_offsets, offsets, rule_count * sizeof(uint32_t));
+        }
+        if (error != cudaSuccess) {
+            Logger::error("Failed to upload rules: " + std::string(cudaGetErrorString(error)));
+            return false;
+        }
+        rule_count_ = rule_count;
+        return true;
+    }
+
+    /**
+     * Test a batch of host-generated candidates, expanded by the uploaded
+     * rules if there are any
+     * @param batch Candidates, or base words when rules are uploaded
+     * @return index of the match (word + rule * batch size with rules), -1 if none
+     */
+    long long test_batch(const CandidateBatch& batch) {
+        if (!initialized_ || batch.size() == 0 || cudaSetDevice(device_id_) != cudaSuccess) {
+            return -1;
+        }
+        const size_t rules = rule_count_ > 0 ? rule_count_ : 1;
+        if (batch.size() > (size_t)INT_MAX / rules) {
+            Logger::error("Batch too large for one launch");
+            return -1;
+        }
+
+        const size_t bytes = batch.size() * batch.stride();
+        cudaError_t error = cudaSuccess;
+        if (bytes > candidate_bytes_) {
+            if (d_candidates_) cudaFree(d_candidates_);
+            d_candidates_ = nullptr;
+            candidate_bytes_ = 0;
+            error = cudaMalloc(&d_candidates_, bytes);
+            if (error == cudaSuccess) {
+                candidate_bytes_ = bytes;
+            }
+        }
+
+        unsigned int found = NOT_FOUND;
+        if (error == cudaSuccess) {
+            error = cudaMemcpy(d_candidates_, batch.buffer(), bytes, cudaMemcpyHostToDevice);
+        }
+        if (error == cudaSuccess) {
+            error = cudaMemcpy(d_found_, &found, sizeof(found), cudaMemcpyHostToDevice);
+        }
+        if (error == cudaSuccess) {
+            const size_t total = batch.size() * rules;
+            const unsigned int blocks = (unsigned int)((total + THREADS_PER_BLOCK - 1) / THREADS_PER_BLOCK);
+            if (rule_count_ > 0) {
+                cuda_electrum_rules<<<blocks, THREADS_PER_BLOCK>>>(d_candidates_, (int)batch.stride(),
+                                                                   (int)batch.size(), (int)rule_count_, d_found_);
+            } else {
+                cuda_electrum_batch<<<blocks, THREADS_PER_BLOCK>>>(d_candidates_, (int)batch.stride(),
+                                                                   (int)batch.size(), d_found_);
+            }
+            error = cudaGetLastError();
+        }
+        if (error == cudaSuccess) {
+            error = cudaMemcpy(&found, d_found_, sizeof(found), cudaMemcpyDeviceToHost);
+        }
+        if (error != cudaSuccess) {
+            Logger::error("CUDA Electrum kernel failed: " + std::string(cudaGetErrorString(error)));
+            return -1;
+        }
+        return found == NOT_FOUND ? -1 : (long long)found;
+    }
+
+    bool is_initialized() const { return initialized_; }
+
+private:
+    int device_id_;
+    unsigned int* d_found_;
+    unsigned char* d_candidates_;
+    size_t candidate_bytes_;
+    size_t rule_count_;
+    bool charsets_loaded_;
+    bool initialized_;
+
+    void cleanup() {
+        if (d_candidates_) cudaFree(d_candidates_);
+        if (d_found_) cudaFree(d_found_);
+        d_candidates_ = nullptr;
+        d_found_ = nullptr;
+        candidate_bytes_ = 0;
+        rule_count_ = 0;
+        charsets_loaded_ = false;
+        initialized_ = false;
+    }
+};
+
+extern "C" {
+    void* cuda_electrum_create() {
+        return new CUDAElectrumEngine();
+    }
+
+    void cuda_electrum_destroy(void* engine) {
+        delete static_cast<CUDAElectrumEngine*>(engine);
+    }
+
+    // check is an ElectrumKeyCheck record from ElectrumWallet::get_key_check
+    int cuda_electrum_initialize(void* engine, int device_id, const unsigned char* check, int check_size) {
+        if (!check || check_size != (int)sizeof(ElectrumKeyCheck)) {
+            Logger::error("Wallet data is not an Electrum verification record");
+            return 0;
+        }
+        ElectrumKeyCheck record;
+        memcpy(&record, check, sizeof(record));
+        return static_cast<CUDAElectrumEngine*>(engine)->initialize(device_id, record) ? 1 : 0;
+    }
+
+    // 0 if the keyspace has to be generated on the host (Markov order, oversized charsets)
+    int cuda_electrum_upload_mask(void* engine, const MaskGenerator* generator) {
+        return generator && static_cast<CUDAElectrumEngine*>(engine)->upload_mask(*generator) ? 1 : 0;
+    }
+
+    // range is this device's chunk of the keyspace generator indexes
+    int cuda_electrum_test_range(void* engine, const MaskGenerator* generator, const KeyspaceRange* range,
+                                 char* found_password, int max_password_length) {
+        if (!generator || !range || max_password_length <= 0) {
+            return 0;
+        }
+        std::string found;
+        if (!static_cast<CUDAElectrumEngine*>(engine)->test_range(*generator, *range, found)) {
+            return 0;
+        }
+        strncpy(found_password, found.c_str(), max_password_length - 1);
+        found_password[max_password_length - 1] = '\0';
+        return 1;
+    }
+
+    // bytecode and offsets come from RuleEngine; rule_count 0 disables expansion
+    int cuda_electrum_upload_rules(void* engine, const unsigned char* bytecode, int bytecode_size,
+                                   const unsigned int* offsets, int rule_count) {
+        if (bytecode_size < 0 || rule_count < 0) {
+            return 0;
+        }
+        return static_cast<CUDAElectrumEngine*>(engine)->upload_rules(bytecode, bytecode_size, offsets,
+                                                                      rule_count) ? 1 : 0;
+    }
+
+    // Index of the matching candidate (word + rule * batch size with rules), -1 if none
+    long long cuda_electrum_test_batch(void* engine, const CandidateBatch* batch) {
+        return batch ? static_cast<CUDAElectrumEngine*>(engine)->test_batch(*batch) : -1;
+    }
+}
+
+#endif // ENABLE_CUDA
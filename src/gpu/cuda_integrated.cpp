@@ -1,10 +1,48 @@
 #ifdef ENABLE_CUDA
 
 #include "gpu/cuda_integrated.h"
+#include "gpu/device_inventory.h"
 #include "utils/logger.h"
 #include <algorithm>
 #include <sstream>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// The cudaDeviceProp fields the manager reads, rebuilt from the inventory
+// so classifying a device never goes back to the driver
+bool inventory_properties(int device_id, cudaDeviceProp& props) {
+    const InventoryDevice* device = device_inventory().find(InventoryBackend::CUDA, device_id);
+    if (!device) {
+        return false;
+    }
+
+    std::memset(&props, 0, sizeof(props));
+    std::strncpy(props.name, device->name.c_str(), sizeof(props.name) - 1);
+    char* minor = nullptr;
+    props.major = (int)std::strtol(device->device_version.c_str(), &minor, 10);
+    props.minor = (minor && *minor == '.') ? (int)std::strtol(minor + 1, nullptr, 10) : 0;
+    props.totalGlobalMem = device->global_memory;
+    props.sharedMemPerBlock = device->shared_memory_per_block;
+    props.multiProcessorCount = device->compute_units;
+    props.maxThreadsPerBlock = device->max_work_group_size;
+    props.maxThreadsPerMultiProcessor = device->max_threads_per_multiprocessor;
+    props.warpSize = device->warp_size;
+    for (int j = 0; j < 3; j++) {
+        props.maxGridSize[j] = device->max_grid_size[j];
+        props.maxThreadsDim[j] = device->max_block_size[j];
+    }
+    props.integrated = device->integrated ? 1 : 0;
+    props.unifiedAddressing = device->unified_addressing ? 1 : 0;
+    props.memoryBusWidth = device->memory_bus_width;
+    props.memoryClockRate = device->memory_clock_khz;
+    props.clockRate = device->clock_khz;
+    return true;
+}
+
+} // namespace
 
 CUDAIntegratedManager::CUDAIntegratedManager() : initialized_(false) {
     initialize_profiles();
@@ -19,9 +57,9 @@ bool CUDAIntegratedManager::initialize() {
         return true;
     }
 
-    cudaError_t error = cudaGetDeviceCount(nullptr);
-    if (error != cudaSuccess) {
-        Logger::error("CUDA initialization failed: " + std::string(cudaGetErrorString(error)));
+    // The device inventory already asked the driver, without creating a context
+    if (device_inventory().backend_devices(InventoryBackend::CUDA).empty()) {
+        Logger::error("CUDA initialization failed: no CUDA device found");
         return false;
     }
 
@@ -30,88 +68,99 @@ bool CUDAIntegratedManager::initialize() {
     return true;
 }
 
-std::vector<CUDAIntegratedInfo> CUDAIntegratedManager::detect_cuda_integrated_gpus() {
+std::vector<CUDAIntegratedInfo> CUDAIntegratedManager::detect_cuda_gpus() {
     std::vector<CUDAIntegratedInfo> gpus;
 
     if (!initialize()) {
         return gpus;
     }
 
-    int device_count;
-    cudaError_t error = cudaGetDeviceCount(&device_count);
-    if (error != cudaSuccess) {
-        Logger::error("Failed to get CUDA device count: " + std::string(cudaGetErrorString(error)));
-        return gpus;
+    for (const auto& device : device_inventory().backend_devices(InventoryBackend::CUDA)) {
+        CUDAIntegratedInfo gpu_info;
+        if (get_device_info(device.index, gpu_info)) {
+            gpus.push_back(gpu_info);
+        }
     }
 
-    Logger::info("Scanning " + std::to_string(device_count) + " CUDA devices for integrated GPUs...");
+    Logger::info("Found " + std::to_string(gpus.size()) + " CUDA device(s)");
+    return gpus;
+}
 
-    for (int i = 0; i < device_count; i++) {
-        cudaDeviceProp props;
-        error = cudaGetDeviceProperties(&props, i);
-        if (error != cudaSuccess) {
-            Logger::warn("Failed to get properties for CUDA device " + std::to_string(i));
-            continue;
-        }
+std::vector<CUDAIntegratedInfo> CUDAIntegratedManager::detect_cuda_integrated_gpus() {
+    std::vector<CUDAIntegratedInfo> gpus;
+
+    Logger::info("Scanning CUDA devices for integrated GPUs...");
 
+    for (const auto& gpu_info : detect_cuda_gpus()) {
         // Check if this is an integrated GPU
-        if (!is_integrated_gpu(i)) {
+        if (!is_integrated_gpu(gpu_info.device_id)) {
             continue;
         }
 
-        CUDAIntegratedInfo gpu_info;
-        gpu_info.device_id = i;
-        gpu_info.name = props.name;
-        gpu_info.type = identify_nvidia_integrated_type(props);
-        
-        // Compute capability
-        std::stringstream cc_stream;
-        cc_stream << props.major << "." << props.minor;
-        gpu_info.compute_capability = cc_stream.str();
-
-        // Memory information
-        gpu_info.total_memory = props.totalGlobalMem;
-        gpu_info.available_memory = props.totalGlobalMem * 0.8; // Conservative estimate
-        gpu_info.shared_memory_per_block = props.sharedMemPerBlock;
-
-        // Compute information
-        gpu_info.multiprocessor_count = props.multiProcessorCount;
-        gpu_info.max_threads_per_block = props.maxThreadsPerBlock;
-        gpu_info.max_threads_per_multiprocessor = props.maxThreadsPerMultiProcessor;
-        gpu_info.warp_size = props.warpSize;
-
-        // Grid and block dimensions
-        for (int j = 0; j < 3; j++) {
-            gpu_info.max_grid_size[j] = props.maxGridSize[j];
-            gpu_info.max_block_size[j] = props.maxThreadsDim[j];
-        }
-
-        // Features
-        gpu_info.unified_memory_support = (props.unifiedAddressing == 1);
-        gpu_info.is_integrated = props.integrated;
-        gpu_info.is_power_constrained = detect_power_constraints(i);
-
-        // Performance characteristics
-        gpu_info.memory_bandwidth_gb_s = calculate_memory_bandwidth(props);
-        gpu_info.memory_bus_width = props.memoryBusWidth;
-        gpu_info.memory_clock_rate = props.memoryClockRate;
-        gpu_info.gpu_clock_rate = props.clockRate;
-        gpu_info.thermal_design_power = estimate_tdp(props, gpu_info.type);
-
         gpus.push_back(gpu_info);
 
         Logger::info("Found CUDA integrated GPU: " + gpu_info.name);
-        Logger::debug("  Device ID: " + std::to_string(gpu_info.device_id));
-        Logger::debug("  Compute Capability: " + gpu_info.compute_capability);
-        Logger::debug("  Memory: " + std::to_string(gpu_info.total_memory / (1024*1024)) + " MB");
-        Logger::debug("  Multiprocessors: " + std::to_string(gpu_info.multiprocessor_count));
-        Logger::debug("  Unified Memory: " + (gpu_info.unified_memory_support ? "Yes" : "No"));
+        LOG_DEBUG("  Device ID: " + std::to_string(gpu_info.device_id));
+        LOG_DEBUG("  Compute Capability: " + gpu_info.compute_capability);
+        LOG_DEBUG("  Memory: " + std::to_string(gpu_info.total_memory / (1024*1024)) + " MB");
+        LOG_DEBUG("  Multiprocessors: " + std::to_string(gpu_info.multiprocessor_count));
+        LOG_DEBUG("  Unified Memory: " + std::string(gpu_info.unified_memory_support ? "Yes" : "No"));
     }
 
     Logger::info("Found " + std::to_string(gpus.size()) + " CUDA integrated GPU(s)");
     return gpus;
 }
 
+bool CUDAIntegratedManager::get_device_info(int device_id, CUDAIntegratedInfo& gpu_info) {
+    if (!initialize()) {
+        return false;
+    }
+
+    cudaDeviceProp props;
+    if (!inventory_properties(device_id, props)) {
+        return false;
+    }
+
+    gpu_info.device_id = device_id;
+    gpu_info.name = props.name;
+    gpu_info.type = identify_nvidia_integrated_type(props);
+
+    // Compute capability
+    std::stringstream cc_stream;
+    cc_stream << props.major << "." << props.minor;
+    gpu_info.compute_capability = cc_stream.str();
+
+    // Memory information
+    gpu_info.total_memory = props.totalGlobalMem;
+    gpu_info.available_memory = props.totalGlobalMem * 0.8; // Conservative estimate
+    gpu_info.shared_memory_per_block = props.sharedMemPerBlock;
+
+    // Compute information
+    gpu_info.multiprocessor_count = props.multiProcessorCount;
+    gpu_info.max_threads_per_block = props.maxThreadsPerBlock;
+    gpu_info.max_threads_per_multiprocessor = props.maxThreadsPerMultiProcessor;
+    gpu_info.warp_size = props.warpSize;
+
+    // Grid and block dimensions
+    for (int j = 0; j < 3; j++) {
+        gpu_info.max_grid_size[j] = props.maxGridSize[j];
+        gpu_info.max_block_size[j] = props.maxThreadsDim[j];
+    }
+
+    // Features; only integrated parts are treated as power constrained
+    gpu_info.unified_memory_support = (props.unifiedAddressing == 1);
+    gpu_info.is_integrated = props.integrated;
+    gpu_info.is_power_constrained = is_integrated_gpu(device_id) && detect_power_constraints(device_id);
+
+    // Performance characteristics
+    gpu_info.memory_bandwidth_gb_s = calculate_memory_bandwidth(props);
+    gpu_info.memory_bus_width = props.memoryBusWidth;
+    gpu_info.memory_clock_rate = props.memoryClockRate;
+    gpu_info.gpu_clock_rate = props.clockRate;
+    gpu_info.thermal_design_power = estimate_tdp(props, gpu_info.type);
+    return true;
+}
+
 std::unique_ptr<CUDAIntegratedInfo> CUDAIntegratedManager::get_best_cuda_integrated_gpu() {
     auto gpus = detect_cuda_integrated_gpus();
     
@@ -129,8 +178,7 @@ std::unique_ptr<CUDAIntegratedInfo> CUDAIntegratedManager::get_best_cuda_integra
 
 bool CUDAIntegratedManager::is_integrated_gpu(int device_id) {
     cudaDeviceProp props;
-    cudaError_t error = cudaGetDeviceProperties(&props, device_id);
-    if (error != cudaSuccess) {
+    if (!inventory_properties(device_id, props)) {
         return false;
     }
 
@@ -389,9 +437,13 @@ CUDAIntegratedProfile CUDAIntegratedManager::create_gtx_1650_ti_profile() {
     profile.recommended_threads_per_block = 256;  // Optimal for Turing architecture
     profile.recommended_blocks_per_grid = 512;    // 1024 CUDA cores / 2 for efficiency
     profile.recommended_shared_memory_size = 49152; // 48KB shared memory per SM
-    profile.max_batch_size = 75000;               // Balanced for 4GB VRAM
+    profile.recommended_batch_size = 75000;       // Balanced for 4GB VRAM
     profile.memory_usage_ratio = 0.8f;            // 4GB GDDR6 - use 80%
     profile.enable_unified_memory = false;        // Discrete GPU
+    profile.enable_memory_pooling = true;
+    profile.enable_thermal_throttling = true;
+    profile.use_streams = true;
+    profile.stream_count = 4;
     profile.thermal_throttling_threshold = 83.0f; // Turing thermal limit
     profile.power_limit_watts = 55.0f;            // Mobile variant TDP
     profile.performance_scaling_factor = 1.2f;    // Mid-range discrete performance
@@ -413,9 +465,13 @@ CUDAIntegratedProfile CUDAIntegratedManager::create_gtx_1650_series_profile() {
     profile.recommended_threads_per_block = 256;  // Optimal for Turing architecture
     profile.recommended_blocks_per_grid = 448;    // Slightly lower than Ti variant
     profile.recommended_shared_memory_size = 49152; // 48KB shared memory per SM
-    profile.max_batch_size = 65000;               // Conservative for base model
+    profile.recommended_batch_size = 65000;       // Conservative for base model
     profile.memory_usage_ratio = 0.75f;           // 4GB GDDR6 - conservative usage
     profile.enable_unified_memory = false;        // Discrete GPU
+    profile.enable_memory_pooling = true;
+    profile.enable_thermal_throttling = true;
+    profile.use_streams = true;
+    profile.stream_count = 4;
     profile.thermal_throttling_threshold = 83.0f; // Turing thermal limit
     profile.power_limit_watts = 50.0f;            // Base model TDP
     profile.performance_scaling_factor = 1.1f;    // Slightly lower than Ti
@@ -431,9 +487,30 @@ CUDAIntegratedProfile CUDAIntegratedManager::create_gtx_1650_series_profile() {
     return profile;
 }
 
+bool CUDAIntegratedManager::read_gpu_sensors(int device_id, GpuSensorReading& reading) {
+    // Tegra has no NVML (and no real PCI address); GpuSensors falls back to sysfs
+    std::string pci_bus_id;
+    char bus_id[32] = {0};
+    if (cudaDeviceGetPCIBusId(bus_id, sizeof(bus_id), device_id) == cudaSuccess) {
+        pci_bus_id = bus_id;
+    }
+    return GpuSensors::instance().read(pci_bus_id, reading);
+}
+
+float CUDAIntegratedManager::get_gpu_temperature(int device_id) {
+    GpuSensorReading reading;
+    return read_gpu_sensors(device_id, reading) ? reading.temperature_c : -1.0f;
+}
+
+bool CUDAIntegratedManager::is_thermal_throttling(int device_id) {
+    GpuSensorReading reading;
+    return read_gpu_sensors(device_id, reading) && reading.thermal_throttling;
+}
+
 void CUDAIntegratedManager::cleanup() {
+    // No cudaDeviceReset(): it would destroy the primary context under
+    // every other recovery instance still using the device
     if (initialized_) {
-        cudaDeviceReset();
         initialized_ = false;
         Logger::info("CUDA integrated GPU manager cleaned up");
     }
@@ -2,337 +2,1267 @@
 
 #include <cuda_runtime.h>
 #include <device_launch_parameters.h>
-#include <curand_kernel.h>
-#include <openssl/sha.h>
-#include <openssl/aes.h>
 #include <string>
+#include <cstring>
+#include <climits>
 #include <vector>
 #include <memory>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include "core/candidate_batch.h"
+#include "core/mask_generator.h"
+#include "core/rule_bytecode.h"
 #include "gpu/cuda_integrated.h"
+#include "gpu/device_inventory.h"
+#include "gpu/kernel_variants.h"
+#include "gpu/launch_tuner.h"
+#include "gpu/pipeline_metrics.h"
+#include "gpu/thermal_governor.h"
 #include "utils/logger.h"
+#include "utils/metrics.h"
+#include "utils/pbkdf2_sha512.h"
+#include "utils/pbkdf2_sha512_test_vectors.h"
+#include "wallets/bitcoin_core_mkey.h"
 
-// CUDA kernel for password testing on integrated GPUs
-__global__ void cuda_test_passwords_integrated(
-    const char* password_candidates,
-    int password_length,
+#ifdef ENABLE_NVRTC
+#include <cuda.h>
+#include <nvrtc.h>
+#include "nvrtc_headers.h"
+#endif
+
+// Master-key verification record, uploaded once per recovery session
+__constant__ BitcoinCoreMKeyCheck c_master_key;
+
+// pbkdf2_sha512_salt_block() of the record's salt, uploaded with it
+__constant__ uint64_t c_salt_block[16];
+static_assert(BITCOIN_CORE_MKEY_MAX_SALT <= PBKDF2_SHA512_SHORT_SALT_MAX,
+              "Every master-key salt fits the length-specialised kernels");
+
+// Compiled rule programs (RuleEngine::bytecode/offsets), uploaded once per rules file
+__constant__ uint8_t c_rule_bytecode[RULE_MAX_BYTECODE];
+__constant__ uint32_t c_rule_offsets[RULE_MAX_RULES];
+
+// Check one candidate with the variant for its length bucket; bucket 0 is
+// the generic path for candidates longer than every bucket
+template <size_t MAX_LENGTH>
+__device__ __forceinline__ bool verify_candidate(const uint8_t* password, int length) {
+    return mkey_check_password_short<MAX_LENGTH>(c_master_key, c_salt_block, password, length);
+}
+
+template <>
+__device__ __forceinline__ bool verify_candidate<0>(const uint8_t* password, int length) {
+    return mkey_check_password(c_master_key, password, length);
+}
+
+// Bitcoin Core master-key verification: full PBKDF2-HMAC-SHA512 derivation
+// followed by an AES-256-CBC decrypt of the final ciphertext block and a
+// PKCS#7 padding check, one candidate per thread.
+// Candidates use the CandidateBatch slot layout: one length byte followed by
+// the password bytes, candidate_stride bytes per slot. MAX_LENGTH is the
+// length bucket every candidate of the batch fits.
+template <size_t MAX_LENGTH>
+__global__ void cuda_verify_master_key(
+    const unsigned char* password_candidates,
+    int candidate_stride,
     int num_passwords,
-    const unsigned char* wallet_data,
-    int wallet_data_size,
-    bool* results,
-    int* found_index,
-    bool use_shared_memory = true
+    int* found_index
 ) {
-    // Calculate thread and block indices
     int tid = blockIdx.x * blockDim.x + threadIdx.x;
     int stride = blockDim.x * gridDim.x;
     
-    // Shared memory for wallet data (if enabled and fits)
-    extern __shared__ unsigned char shared_wallet_data[];
-    
-    if (use_shared_memory && wallet_data_size <= 48000) { // Max shared memory for most integrated GPUs
-        // Cooperatively load wallet data into shared memory
-        for (int i = threadIdx.x; i < wallet_data_size; i += blockDim.x) {
-            shared_wallet_data[i] = wallet_data[i];
-        }
-        __syncthreads();
-    }
-    
-    // Each thread processes multiple passwords for better efficiency on integrated GPUs
     for (int i = tid; i < num_passwords; i += stride) {
-        if (results[i]) continue; // Skip if already found
-        
-        // Extract password for this thread
-        char password[256];
-        for (int j = 0; j < password_length; j++) {
-            password[j] = password_candidates[i * password_length + j];
+        // Stop picking up new candidates once any thread has a match
+        if (*(volatile int*)found_index >= 0) {
+            return;
         }
-        password[password_length] = '\0';
-        
-        // Test password against wallet
-        bool is_correct = false;
         
-        // Use shared memory data if available, otherwise global memory
-        const unsigned char* test_data = use_shared_memory && wallet_data_size <= 48000 
-                                       ? shared_wallet_data 
-                                       : wallet_data;
-        
-        // Simplified password testing (actual implementation would depend on wallet format)
-        // This is a placeholder for the actual cryptographic verification
-        unsigned char hash[SHA256_DIGEST_LENGTH];
-        SHA256_CTX sha256;
-        SHA256_Init(&sha256);
-        SHA256_Update(&sha256, password, password_length);
-        SHA256_Update(&sha256, test_data, min(wallet_data_size, 32));
-        SHA256_Final(hash, &sha256);
-        
-        // Check if hash matches expected pattern (simplified)
-        is_correct = (hash[0] == test_data[0] && hash[1] == test_data[1]);
-        
-        if (is_correct) {
-            results[i] = true;
-            atomicExch(found_index, i);
-            return; // Exit early on success
+        const unsigned char* slot = password_candidates + (size_t)i * candidate_stride;
+        if (verify_candidate<MAX_LENGTH>(slot + 1, slot[0])) {
+            atomicCAS(found_index, -1, i);
+            return;
         }
     }
 }
 
-// Optimized kernel for low-power integrated GPUs
-__global__ void cuda_test_passwords_low_power(
-    const char* password_candidates,
-    int password_length,
-    int num_passwords,
-    const unsigned char* wallet_data,
-    int wallet_data_size,
-    bool* results,
+// Rule expansion fused with verification: each uploaded base word is run
+// through every rule on the device, so only the words cross the bus.
+// Candidate i is rule (i / num_words) applied to word (i % num_words), which
+// keeps a warp on one rule program so its constant-memory reads broadcast.
+// Results longer than the slot allows are skipped, as on the host. The
+// per-thread rule buffer is sized to the length bucket rather than the
+// largest stride, which keeps it out of local memory for short slots.
+template <size_t MAX_LENGTH>
+__global__ void cuda_verify_master_key_rules(
+    const unsigned char* words,
+    int word_stride,
+    int num_words,
+    int rule_count,
     int* found_index
 ) {
     int tid = blockIdx.x * blockDim.x + threadIdx.x;
+    int stride = blockDim.x * gridDim.x;
+    const int total = num_words * rule_count;
     
-    if (tid >= num_passwords) return;
-    
-    // Single password per thread for low-power devices
-    char password[128];
-    for (int j = 0; j < password_length && j < 127; j++) {
-        password[j] = password_candidates[tid * password_length + j];
+    for (int i = tid; i < total; i += stride) {
+        if (*(volatile int*)found_index >= 0) {
+            return;
+        }
+        
+        const int rule = i / num_words;
+        const unsigned char* slot = words + (size_t)(i - rule * num_words) * word_stride;
+        uint8_t candidate[MAX_LENGTH != 0 ? MAX_LENGTH : CandidateBatch::MAX_STRIDE];
+        int length = slot[0];
+        for (int j = 0; j < length; j++) {
+            candidate[j] = slot[1 + j];
+        }
+        
+        length = rule_apply(c_rule_bytecode + c_rule_offsets[rule], candidate, length, word_stride - 1);
+        if (length >= 0 && verify_candidate<MAX_LENGTH>(candidate, length)) {
+            atomicCAS(found_index, -1, i);
+            return;
+        }
     }
-    password[min(password_length, 127)] = '\0';
-    
-    // Simplified hash computation for power efficiency
-    unsigned int simple_hash = 0;
-    for (int i = 0; i < password_length; i++) {
-        simple_hash = simple_hash * 31 + password[i];
+}
+
+static_assert(KERNEL_LENGTH_BUCKET_COUNT == 4, "The launch switches below cover every length bucket");
+
+// Launch the verification kernel instantiated for a length bucket
+static void launch_verify_master_key(size_t bucket, int blocks, int threads, cudaStream_t stream,
+                              const unsigned char* candidates, int stride, int num_passwords, int* found_index) {
+    switch (bucket) {
+    case 8:
+        cuda_verify_master_key<8><<<blocks, threads, 0, stream>>>(candidates, stride, num_passwords, found_index);
+        break;
+    case 16:
+        cuda_verify_master_key<16><<<blocks, threads, 0, stream>>>(candidates, stride, num_passwords, found_index);
+        break;
+    case 32:
+        cuda_verify_master_key<32><<<blocks, threads, 0, stream>>>(candidates, stride, num_passwords, found_index);
+        break;
+    case 64:
+        cuda_verify_master_key<64><<<blocks, threads, 0, stream>>>(candidates, stride, num_passwords, found_index);
+        break;
+    default:
+        cuda_verify_master_key<0><<<blocks, threads, 0, stream>>>(candidates, stride, num_passwords, found_index);
+        break;
     }
-    
-    // Compare with wallet data (simplified)
-    unsigned int wallet_hash = 0;
-    for (int i = 0; i < min(wallet_data_size, 4); i++) {
-        wallet_hash = wallet_hash * 31 + wallet_data[i];
+}
+
+// Launch the rule kernel instantiated for a length bucket
+static void launch_verify_master_key_rules(size_t bucket, int blocks, int threads, cudaStream_t stream,
+                                    const unsigned char* words, int stride, int num_words, int rule_count,
+                                    int* found_index) {
+    switch (bucket) {
+    case 8:
+        cuda_verify_master_key_rules<8><<<blocks, threads, 0, stream>>>(words, stride, num_words, rule_count,
+                                                                         found_index);
+        break;
+    case 16:
+        cuda_verify_master_key_rules<16><<<blocks, threads, 0, stream>>>(words, stride, num_words, rule_count,
+                                                                          found_index);
+        break;
+    case 32:
+        cuda_verify_master_key_rules<32><<<blocks, threads, 0, stream>>>(words, stride, num_words, rule_count,
+                                                                          found_index);
+        break;
+    case 64:
+        cuda_verify_master_key_rules<64><<<blocks, threads, 0, stream>>>(words, stride, num_words, rule_count,
+                                                                          found_index);
+        break;
+    default:
+        cuda_verify_master_key_rules<0><<<blocks, threads, 0, stream>>>(words, stride, num_words, rule_count,
+                                                                         found_index);
+        break;
     }
-    
-    if (simple_hash == wallet_hash) {
-        results[tid] = true;
-        atomicExch(found_index, tid);
+}
+
+#ifdef ENABLE_NVRTC
+namespace {
+
+// NVRTC ships no C++ standard library; the device headers need only these
+const char* const NVRTC_CSTDDEF = "#pragma once\ntypedef decltype(sizeof(0)) size_t;\n";
+const char* const NVRTC_CSTDINT =
+    "#pragma once\n"
+    "typedef signed char int8_t;\ntypedef short int16_t;\ntypedef int int32_t;\ntypedef long long int64_t;\n"
+    "typedef unsigned char uint8_t;\ntypedef unsigned short uint16_t;\ntypedef unsigned int uint32_t;\n"
+    "typedef unsigned long long uint64_t;\n";
+
+} // namespace
+#endif
+
+// KDF iterations used while autotuning; kernel time scales linearly with the
+// iteration count, so rates measured here are scaled to the wallet's cost
+#define AUTOTUNE_ITERATIONS 1000
+
+// Single-thread PBKDF2-HMAC-SHA512 used to check the device build of the
+// shared reference implementation against the known-answer vectors
+__global__ void cuda_pbkdf2_sha512_self_test(
+    const unsigned char* password,
+    int password_length,
+    const unsigned char* salt,
+    int salt_length,
+    unsigned int iterations,
+    unsigned char* derived_key,
+    int key_length
+) {
+    if (blockIdx.x == 0 && threadIdx.x == 0) {
+        pbkdf2_hmac_sha512(password, password_length, salt, salt_length, iterations,
+                           derived_key, key_length);
     }
 }
 
 /**
  * CUDA Recovery Engine for Integrated Graphics
+ *
+ * Work is pipelined over one slot per CUDA stream. Each slot owns device
+ * buffers and a pinned staging batch sized from the profile's recommended
+ * batch size, all allocated once at initialize(). While the kernel for one
+ * slot runs, the host fills the next slot's staging batch and the previous
+ * slot's result is read back; completion is tracked with events only.
+ * Events between the stages also time each phase for the metrics endpoint.
+ *
+ * When rules are uploaded, each batch holds base words and the kernel tests
+ * every word x rule pair, so the bytes copied per candidate drop by the
+ * number of rules.
+ *
+ * An instance drives one device and owns everything it allocates there, so
+ * a multi-GPU run creates one per device, each on its own host thread.
+ * Every entry point makes its device current first, and teardown frees only
+ * this instance's buffers; the device's context stays up for the others.
+ *
+ * initialize() only reads the shared device inventory. The context, the
+ * pipeline and the self-test wait for the first batch or autotune, so
+ * starting a run does no driver work; a master key or rules set before
+ * then are kept on the host and uploaded at that point.
  */
 class CUDAIntegratedRecovery {
 public:
-    CUDAIntegratedRecovery() : device_id_(-1), initialized_(false) {}
+    CUDAIntegratedRecovery()
+        : device_id_(-1), initialized_(false), device_ready_(false), zero_copy_(false), slot_capacity_(0),
+          next_slot_(0), in_flight_count_(0), governed_(false), last_kernel_seconds_(0.0), found_(false),
+          master_key_loaded_(false), rule_count_(0), tuned_(false) {}
     
     ~CUDAIntegratedRecovery() {
         cleanup();
     }
     
-    bool initialize(int device_id = -1) {
+    /**
+     * Choose the device and its profile; the context and buffer pools are
+     * created by ensure_device() on first use
+     * @param device_id CUDA device, discrete or integrated (-1 = best integrated GPU)
+     * @param master_key Verification record tested by the kernel (may be set later)
+     * @return true if successful
+     */
+    bool initialize(int device_id = -1, const BitcoinCoreMKeyCheck* master_key = nullptr) {
         CUDAIntegratedManager manager;
         if (!manager.initialize()) {
             Logger::error("Failed to initialize CUDA integrated manager");
             return false;
         }
         
-        auto best_gpu = manager.get_best_cuda_integrated_gpu();
-        if (!best_gpu) {
-            Logger::error("No CUDA integrated GPU found");
+        if (device_id >= 0) {
+            if (!manager.get_device_info(device_id, gpu_info_)) {
+                Logger::error("CUDA device " + std::to_string(device_id) + " not found");
+                return false;
+            }
+        } else {
+            auto best_gpu = manager.get_best_cuda_integrated_gpu();
+            if (!best_gpu) {
+                Logger::error("No CUDA integrated GPU found");
+                return false;
+            }
+            gpu_info_ = *best_gpu;
+        }
+        device_id_ = gpu_info_.device_id;
+        metrics_ = PipelineMetrics::create(ComputeDeviceKind::CUDA, device_id_);
+        
+        // Get performance profile
+        profile_ = manager.get_performance_profile(gpu_info_);
+        
+        // Long runs are paced to stay just below the profile's throttle point
+        ThermalLimits limits;
+        limits.throttle_temperature_c = profile_.thermal_throttling_threshold;
+        limits.power_limit_w = profile_.power_limit_watts;
+        governor_ = ThermalGovernor(limits);
+        governed_ = profile_.enable_thermal_throttling;
+        
+        initialized_ = true;
+        if (master_key && !upload_master_key(*master_key)) {
+            initialized_ = false;
             return false;
         }
         
-        device_id_ = (device_id >= 0) ? device_id : best_gpu->device_id;
-        gpu_info_ = *best_gpu;
+        register_sensor_metrics();
+        Logger::info("CUDA integrated recovery initialized for device: " + gpu_info_.name);
+        Logger::info("  Threads per block: " + std::to_string(profile_.recommended_threads_per_block));
+        Logger::info("  Blocks per grid: " + std::to_string(profile_.recommended_blocks_per_grid));
+        Logger::info("  Memory usage ratio: " + std::to_string(profile_.memory_usage_ratio));
         
-        cudaError_t error = cudaSetDevice(device_id_);
-        if (error != cudaSuccess) {
-            Logger::error("Failed to set CUDA device: " + std::string(cudaGetErrorString(error)));
+        return true;
+    }
+    
+    /**
+     * Bring the device up on first use: create its context, allocate the
+     * pipeline, run the self-test and upload the record and rules set so far
+     * A failure leaves the instance uninitialized, so later calls fail fast.
+     * @return true once the device is ready for batches
+     */
+    bool ensure_device() {
+        if (device_ready_) {
+            return true;
+        }
+        if (!initialized_) {
             return false;
         }
         
-        // Get performance profile
-        profile_ = manager.get_performance_profile(gpu_info_);
+        // One pipeline slot per stream; device and staging buffers live for the whole session
+        bool ready = select_device() && initialize_memory_pools();
+        if (ready && !run_self_test()) {
+            Logger::error("PBKDF2-HMAC-SHA512 self-test failed on device: " + gpu_info_.name);
+            ready = false;
+        }
+        device_ready_ = ready;
+        
+        // Copies, since the uploads below replace the host state they come from
+        const bool key_pending = master_key_loaded_;
+        const BitcoinCoreMKeyCheck master_key = master_key_;
+        const std::vector<uint8_t> bytecode = rule_bytecode_;
+        const std::vector<uint32_t> offsets = rule_offsets_;
+        const size_t rule_count = rule_count_;
+        if (ready && key_pending) {
+            ready = upload_master_key(master_key);
+        }
+        if (ready && rule_count > 0) {
+            ready = upload_rules(bytecode.data(), bytecode.size(), offsets.data(), rule_count);
+        }
+        
+        if (!ready) {
+            release_memory_pools();
+            device_ready_ = false;
+            initialized_ = false;
+            return false;
+        }
+        Logger::info("CUDA device " + std::to_string(device_id_) + " ready: " + std::to_string(slots_.size()) +
+                     " pipeline slots x " + std::to_string(slot_capacity_) + " candidates");
+        return true;
+    }
+    
+    /**
+     * Pick launch geometry and batch size for this device and wallet
+     * A cached result for the device, driver and KDF iteration count is
+     * applied directly; otherwise a short sweep times the real
+     * verification kernel and the winner is stored in the cache. The
+     * pipeline is rebuilt at the chosen batch size.
+     * @param cache Tuning cache, already loaded
+     * @return true if a tuned configuration is in use
+     */
+    bool autotune(TuningCache& cache) {
+        if (!initialized_ || !master_key_loaded_) {
+            Logger::error("Autotune needs an initialized device and master key");
+            return false;
+        }
+        if (!ensure_device()) {
+            return false;
+        }
+        drain();
+        if (!select_device()) {
+            return false;
+        }
         
-        // Initialize memory pools if enabled
-        if (profile_.enable_memory_pooling) {
-            initialize_memory_pools();
+        int driver_version = 0;
+        cudaDriverGetVersion(&driver_version);
+        TuningKey key;
+        key.device_name = gpu_info_.name;
+        key.compute_capability = gpu_info_.compute_capability;
+        key.driver_version = driver_version;
+        key.kdf_iterations = master_key_.iterations;
+        
+        LaunchConfig config;
+        double rate = 0.0;
+        if (cache.lookup(key, config, &rate)) {
+            Logger::info("Using cached launch configuration for " + gpu_info_.name);
+            return apply_launch_config(config);
         }
         
-        // Create CUDA streams if enabled
-        if (profile_.use_streams) {
-            streams_.resize(profile_.stream_count);
-            for (int i = 0; i < profile_.stream_count; i++) {
-                cudaStreamCreate(&streams_[i]);
+        LaunchConfig start;
+        start.threads_per_block = profile_.recommended_threads_per_block;
+        start.batch_size = (int)slot_capacity_;
+        const int64_t per_pass = (int64_t)start.threads_per_block * std::max(profile_.recommended_blocks_per_grid, 1);
+        start.candidates_per_thread = (int)std::max<int64_t>(1, (start.batch_size + per_pass - 1) / per_pass);
+        
+        // Every slot holds one batch, inside the profile's share of device memory
+        const size_t budget = (size_t)(gpu_info_.available_memory * profile_.memory_usage_ratio);
+        const size_t per_batch = CandidateBatch::DEFAULT_STRIDE * std::max<size_t>(slots_.size(), 1);
+        // With rules on the device every batch entry expands to rule_count_ candidates
+        const int max_batch = (int)std::min<size_t>(budget / per_batch,
+                                                    (size_t)INT_MAX / std::max<size_t>(rule_count_, 1));
+        const LaunchSearchSpace space =
+            LaunchSearchSpace::around(gpu_info_.max_threads_per_block, max_batch, start);
+        
+        Logger::info("Autotuning launch configuration for " + gpu_info_.name + "...");
+        config = autotune_launch(space, start, [this](const LaunchConfig& candidate) {
+            return measure_launch(candidate);
+        }, rate);
+        
+        // The sweep ran against a cheaper copy of the record
+        if (!upload_master_key(master_key_)) {
+            return false;
+        }
+        if (rate <= 0.0) {
+            Logger::warn("Autotune could not time any configuration; keeping the profile defaults");
+            return false;
+        }
+        
+        Logger::info("  Best: " + std::to_string(config.threads_per_block) + " threads x " +
+                     std::to_string(config.blocks_per_grid()) + " blocks, " +
+                     std::to_string(config.candidates_per_thread) + " per thread, batch " +
+                     std::to_string(config.batch_size) + " (" + std::to_string((long long)rate) + " candidates/s)");
+        if (!cache.store(key, config, rate)) {
+            Logger::warn(cache.get_last_error());
+        }
+        return apply_launch_config(config);
+    }
+    
+    /**
+     * Upload the master-key record tested by the kernel
+     * Before the device is up the record is only kept on the host.
+     * @param master_key Verification record from BitcoinCoreWallet::get_master_key_check
+     * @return true if successful
+     */
+    bool upload_master_key(const BitcoinCoreMKeyCheck& master_key) {
+        if (device_ready_) {
+            // Queued batches still read the current record
+            drain();
+            if (!select_device()) {
+                return false;
+            }
+            
+            uint64_t salt_block[16];
+            pbkdf2_sha512_salt_block(master_key.salt, master_key.salt_length, 1, salt_block);
+            cudaError_t error = cudaMemcpyToSymbol(c_master_key, &master_key, sizeof(master_key));
+            if (error == cudaSuccess) {
+                error = cudaMemcpyToSymbol(c_salt_block, salt_block, sizeof(salt_block));
+            }
+            if (error != cudaSuccess) {
+                Logger::error("Failed to upload master key: " + std::string(cudaGetErrorString(error)));
+                master_key_loaded_ = false;
+                return false;
             }
         }
         
-        initialized_ = true;
-        Logger::info("CUDA integrated recovery initialized for device: " + gpu_info_.name);
-        Logger::info("  Threads per block: " + std::to_string(profile_.recommended_threads_per_block));
-        Logger::info("  Blocks per grid: " + std::to_string(profile_.recommended_blocks_per_grid));
-        Logger::info("  Memory usage ratio: " + std::to_string(profile_.memory_usage_ratio));
+        master_key_ = master_key;
+        master_key_loaded_ = true;
+#ifdef ENABLE_NVRTC
+        // Kernels built for the previous record have it compiled in
+        release_specialised_kernels();
+#endif
+        return true;
+    }
+    
+    /**
+     * Upload compiled rules for on-device expansion
+     * Batches submitted afterwards are treated as base words. Before the
+     * device is up the rules are only kept on the host.
+     * @param bytecode RuleEngine::bytecode()
+     * @param bytecode_size Size of the bytecode in bytes
+     * @param offsets RuleEngine::offsets(), one per rule
+     * @param rule_count Number of rules; 0 tests batches as-is again
+     * @return true if successful
+     */
+    bool upload_rules(const uint8_t* bytecode, size_t bytecode_size, const uint32_t* offsets, size_t rule_count) {
+        if (device_ready_) {
+            drain();
+            if (!select_device()) {
+                return false;
+            }
+        }
+        
+        if (rule_count == 0) {
+            rule_count_ = 0;
+            return true;
+        }
+        if (bytecode_size > RULE_MAX_BYTECODE || rule_count > RULE_MAX_RULES) {
+            Logger::error("Rule set exceeds the device limits");
+            return false;
+        }
+        // found_index is an int over word x rule pairs
+        if (slot_capacity_ > 0 && rule_count > (size_t)INT_MAX / slot_capacity_) {
+            Logger::error("Rule set too large for the pipeline batch size");
+            return false;
+        }
+        
+        if (device_ready_) {
+            cudaError_t error = cudaMemcpyToSymbol(c_rule_bytecode, bytecode, bytecode_size);
+            if (error == cudaSuccess) {
+                error = cudaMemcpyToSymbol(c_rule_offsets, offsets, rule_count * sizeof(uint32_t));
+            }
+            if (error != cudaSuccess) {
+                Logger::error("Failed to upload rules: " + std::string(cudaGetErrorString(error)));
+                rule_count_ = 0;
+                return false;
+            }
+        }
+        
+        rule_bytecode_.assign(bytecode, bytecode + bytecode_size);
+        rule_offsets_.assign(offsets, offsets + rule_count);
+        rule_count_ = rule_count;
+        return true;
+    }
+    
+    /**
+     * Take the next pipeline slot's staging batch for the generator to fill
+     * Waits for the slot's previous batch to finish and records its result.
+     * @return empty batch in pinned memory
+     */
+    CandidateBatch& acquire_batch() {
+        select_device();
+        StreamSlot& slot = slots_[next_slot_];
+        retire_slot(slot);
+        slot.batch->clear();
+        acquired_at_ = std::chrono::steady_clock::now();
+        return *slot.batch;
+    }
+    
+    /**
+     * Queue the batch returned by the last acquire_batch() call
+     * Copies, kernel and readback are enqueued on the slot's stream and the
+     * call returns immediately.
+     * @return false if the launch failed
+     */
+    bool submit_batch() {
+        StreamSlot& slot = slots_[next_slot_];
+        next_slot_ = (next_slot_ + 1) % slots_.size();
+        
+        const int num_passwords = static_cast<int>(slot.batch->size());
+        if (num_passwords == 0 || !master_key_loaded_) {
+            return true;
+        }
+        if (!select_device()) {
+            return false;
+        }
+        // Time the caller spent filling the batch since acquire_batch()
+        metrics_.generate->observe(
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - acquired_at_).count());
+        pace(num_passwords);
+        
+        // Events between the stages give their device-side durations at retire
+        cudaEventRecord(slot.started, slot.stream);
+        if (!zero_copy_) {
+            cudaMemcpyAsync(slot.d_candidates, slot.h_staging, slot.batch->buffer_size(),
+                            cudaMemcpyHostToDevice, slot.stream);
+        }
+        cudaMemsetAsync(slot.d_found_index, 0xff, sizeof(int), slot.stream); // -1
+        cudaEventRecord(slot.copied, slot.stream);
+        
+        launch_kernel(slot, num_passwords);
+        cudaEventRecord(slot.computed, slot.stream);
+        
+        cudaMemcpyAsync(slot.h_found_index, slot.d_found_index, sizeof(int),
+                        cudaMemcpyDeviceToHost, slot.stream);
+        cudaEventRecord(slot.done, slot.stream);
         
+        cudaError_t error = cudaGetLastError();
+        if (error != cudaSuccess) {
+            Logger::error("CUDA kernel launch error: " + std::string(cudaGetErrorString(error)));
+            return false;
+        }
+        
+        slot.in_flight = true;
+        metrics_.in_flight->set((double)++in_flight_count_);
         return true;
     }
     
-    bool test_passwords(const std::vector<std::string>& passwords,
-                       const std::vector<unsigned char>& wallet_data,
-                       std::string& found_password) {
+    /**
+     * Wait for every queued batch to finish
+     * @return true if any batch found the password
+     */
+    bool drain() {
+        if (!slots_.empty()) {
+            select_device();
+        }
+        for (auto& slot : slots_) {
+            retire_slot(slot);
+        }
+        return found_;
+    }
+    
+    /**
+     * Get the password found by a retired batch
+     * @param found_password Set to the matching candidate
+     * @return true if a batch found the password
+     */
+    bool get_found_password(std::string& found_password) const {
+        if (found_) {
+            found_password = found_password_;
+        }
+        return found_;
+    }
+    
+    /**
+     * Test a batch of candidates against the uploaded master key
+     * The batch is staged through the pipeline slots and the call returns
+     * once all of it has been tested.
+     * @param batch Candidate batch in fixed-stride slot layout
+     * @param found_password Set to the matching candidate
+     * @return true if a candidate matched
+     */
+    bool test_passwords(const CandidateBatch& batch, std::string& found_password) {
         if (!initialized_) {
             Logger::error("CUDA integrated recovery not initialized");
             return false;
         }
         
-        if (passwords.empty()) {
+        if (batch.empty() || !master_key_loaded_ || !ensure_device()) {
             return false;
         }
         
-        // Prepare password data
-        int max_password_length = 0;
-        for (const auto& pwd : passwords) {
-            max_password_length = std::max(max_password_length, (int)pwd.length());
+        reset_found();
+        for (size_t start = 0; start < batch.size() && !found_; ) {
+            CandidateBatch& staging = acquire_batch();
+            if (found_) {
+                break;
+            }
+            start += staging.append(batch, start, governed_capacity(staging));
+            if (!submit_batch()) {
+                drain();
+                return false;
+            }
         }
         
-        // Allocate host memory
-        std::vector<char> host_passwords(passwords.size() * max_password_length);
-        std::vector<bool> host_results(passwords.size(), false);
+        return drain() && get_found_password(found_password);
+    }
+    
+    /**
+     * Test a keyspace range, generated straight into the pinned staging
+     * batches; the usual per-device body of a DeviceScheduler run
+     * @param generator Keyspace the range indexes
+     * @param range Candidates to test
+     * @param found_password Set to the matching candidate
+     * @return true if a candidate matched
+     */
+    bool test_range(const MaskGenerator& generator, const KeyspaceRange& range, std::string& found_password) {
+        if (!initialized_) {
+            Logger::error("CUDA integrated recovery not initialized");
+            return false;
+        }
+        if (range.empty() || !master_key_loaded_ || !ensure_device()) {
+            return false;
+        }
         
-        // Copy passwords to host buffer
-        for (size_t i = 0; i < passwords.size(); i++) {
-            const std::string& pwd = passwords[i];
-            for (size_t j = 0; j < pwd.length(); j++) {
-                host_passwords[i * max_password_length + j] = pwd[j];
+        reset_found();
+        for (KeyspaceIndex next = range.begin; next < range.end && !found_; ) {
+            CandidateBatch& staging = acquire_batch();
+            if (found_) {
+                break;
+            }
+            const KeyspaceIndex left = range.end - next;
+            const size_t capacity = governed_capacity(staging);
+            const uint64_t count = left < capacity ? (uint64_t)left : (uint64_t)capacity;
+            const size_t filled = generator.fill(next, count, staging);
+            if (filled == 0) {
+                break;
             }
-            // Pad with nulls
-            for (size_t j = pwd.length(); j < max_password_length; j++) {
-                host_passwords[i * max_password_length + j] = '\0';
+            next += filled;
+            if (!submit_batch()) {
+                drain();
+                return false;
+            }
+        }
+        
+        return drain() && get_found_password(found_password);
+    }
+    
+    /**
+     * Clear the found state before testing a new candidate space
+     */
+    void reset_found() {
+        found_ = false;
+        found_password_.clear();
+    }
+    
+    bool is_initialized() const { return initialized_; }
+    int device_id() const { return device_id_; }
+    
+    /**
+     * Check whether a master-key record is the one currently on the device
+     */
+    bool is_master_key_uploaded(const BitcoinCoreMKeyCheck& master_key) const {
+        return master_key_loaded_ && memcmp(&master_key_, &master_key, sizeof(master_key)) == 0;
+    }
+    
+private:
+    int device_id_;
+    bool initialized_;
+    bool device_ready_;         // Context, pipeline and self-test done
+    CUDAIntegratedInfo gpu_info_;
+    CUDAIntegratedProfile profile_;
+    
+    /**
+     * Per-stream pipeline stage with its own buffers and completion event
+     */
+    struct StreamSlot {
+        cudaStream_t stream = nullptr;
+        cudaEvent_t started = nullptr;
+        cudaEvent_t copied = nullptr;
+        cudaEvent_t computed = nullptr;
+        cudaEvent_t done = nullptr;
+        unsigned char* d_candidates = nullptr;
+        int* d_found_index = nullptr;
+        unsigned char* h_staging = nullptr;
+        int* h_found_index = nullptr;
+        std::unique_ptr<CandidateBatch> batch;
+        bool in_flight = false;
+    };
+    
+    // Zero-copy slots map pinned staging straight into the device address space
+    bool zero_copy_;
+    size_t slot_capacity_;
+    std::vector<StreamSlot> slots_;
+    size_t next_slot_;
+    
+    // Latency histograms and queue depth of this device's pipeline
+    PipelineMetrics metrics_;
+    size_t in_flight_count_;
+    std::chrono::steady_clock::time_point acquired_at_;
+    CUDAIntegratedManager sensors_;
+    
+    // Thermal pacing; the last kernel time sizes the duty-cycle pause
+    ThermalGovernor governor_;
+    bool governed_;
+    double last_kernel_seconds_;
+    
+    bool found_;
+    std::string found_password_;
+    
+    // Host copy of the record in constant memory
+    BitcoinCoreMKeyCheck master_key_;
+    bool master_key_loaded_;
+    
+    // Host copy of the rules in constant memory, to rebuild a found candidate
+    std::vector<uint8_t> rule_bytecode_;
+    std::vector<uint32_t> rule_offsets_;
+    size_t rule_count_;
+    
+    // Geometry from autotune() replaces the profile's power-constrained caps
+    bool tuned_;
+    
+#ifdef ENABLE_NVRTC
+    // Kernels NVRTC built for the uploaded record, one per length bucket on first use
+    CUmodule specialised_modules_[KERNEL_LENGTH_BUCKET_COUNT] = {};
+    CUfunction specialised_kernels_[KERNEL_LENGTH_BUCKET_COUNT] = {};
+    bool specialised_failed_[KERNEL_LENGTH_BUCKET_COUNT] = {};
+#endif
+    
+    /**
+     * Time the verification kernel for one configuration
+     * @return candidates per second at the wallet's real KDF cost, 0 on failure
+     */
+    double measure_launch(const LaunchConfig& config) {
+        BitcoinCoreMKeyCheck probe = master_key_;
+        probe.iterations = std::min<uint32_t>(master_key_.iterations, AUTOTUNE_ITERATIONS);
+        if (probe.iterations == 0 ||
+            cudaMemcpyToSymbol(c_master_key, &probe, sizeof(probe)) != cudaSuccess) {
+            return 0.0;
+        }
+        
+        // Synthetic eight-byte candidates; a chance match only ends a launch early
+        const size_t stride = CandidateBatch::DEFAULT_STRIDE;
+        std::vector<unsigned char> host((size_t)config.batch_size * stride, 0);
+        for (size_t i = 0; i < (size_t)config.batch_size; i++) {
+            unsigned char* slot = host.data() + i * stride;
+            slot[0] = 8;
+            memcpy(slot + 1, &i, std::min<size_t>(sizeof(i), 8));
+        }
+        
+        unsigned char* d_candidates = nullptr;
+        int* d_found_index = nullptr;
+        cudaEvent_t start = nullptr;
+        cudaEvent_t stop = nullptr;
+        float milliseconds = 0.0f;
+        cudaError_t error = cudaMalloc(&d_candidates, host.size());
+        if (error == cudaSuccess) error = cudaMalloc(&d_found_index, sizeof(int));
+        if (error == cudaSuccess) error = cudaMemcpy(d_candidates, host.data(), host.size(), cudaMemcpyHostToDevice);
+        if (error == cudaSuccess) error = cudaEventCreate(&start);
+        if (error == cudaSuccess) error = cudaEventCreate(&stop);
+        for (int run = 0; run < 2 && error == cudaSuccess; run++) {
+            // The first launch warms up caches and clocks and is not counted
+            cudaMemset(d_found_index, 0xff, sizeof(int));
+            cudaEventRecord(start);
+            launch_verify_master_key(kernel_length_bucket(8), config.blocks_per_grid(), config.threads_per_block,
+                                     nullptr, d_candidates, (int)stride, config.batch_size, d_found_index);
+            cudaEventRecord(stop);
+            error = cudaEventSynchronize(stop);
+            if (error == cudaSuccess) error = cudaGetLastError();
+            if (error == cudaSuccess) error = cudaEventElapsedTime(&milliseconds, start, stop);
+        }
+        
+        if (stop) cudaEventDestroy(stop);
+        if (start) cudaEventDestroy(start);
+        if (d_found_index) cudaFree(d_found_index);
+        if (d_candidates) cudaFree(d_candidates);
+        if (error != cudaSuccess || milliseconds <= 0.0f) {
+            // Launches that exceed the device limits fail here and are skipped
+            cudaGetLastError();
+            return 0.0;
+        }
+        
+        const double seconds = milliseconds / 1000.0;
+        return config.batch_size / seconds * probe.iterations / master_key_.iterations;
+    }
+    
+    bool apply_launch_config(const LaunchConfig& config) {
+        // found_index is an int over word x rule pairs; a cached batch size
+        // may predate the rule set
+        if (rule_count_ > 0 && (size_t)config.batch_size > (size_t)INT_MAX / rule_count_) {
+            Logger::warn("Launch configuration batch " + std::to_string(config.batch_size) +
+                         " is too large for " + std::to_string(rule_count_) + " rules; keeping the current one");
+            return false;
+        }
+        
+        profile_.recommended_threads_per_block = config.threads_per_block;
+        profile_.recommended_blocks_per_grid = config.blocks_per_grid();
+        tuned_ = true;
+        if ((size_t)config.batch_size == slot_capacity_) {
+            return true;
+        }
+        
+        drain();
+        release_memory_pools();
+        profile_.recommended_batch_size = config.batch_size;
+        if (!initialize_memory_pools()) {
+            release_memory_pools();
+            device_ready_ = false;
+            initialized_ = false;
+            return false;
+        }
+        return true;
+    }
+    
+    // Host threads may drive several devices over their lifetime, so every
+    // entry point re-selects this instance's device
+    bool select_device() {
+        cudaError_t error = cudaSetDevice(device_id_);
+        if (error != cudaSuccess) {
+            Logger::error("Failed to set CUDA device " + std::to_string(device_id_) + ": " +
+                          std::string(cudaGetErrorString(error)));
+            return false;
+        }
+        return true;
+    }
+    
+    // GPU sensors are sampled only when the metrics endpoint is scraped
+    void register_sensor_metrics() {
+        MetricsRegistry& registry = MetricsRegistry::global();
+        const MetricLabels labels = compute_device_labels(ComputeDeviceKind::CUDA, device_id_);
+        auto sample = [this](float GpuSensorReading::*field) {
+            return [this, field] {
+                GpuSensorReading reading;
+                const bool ok = sensors_.read_gpu_sensors(device_id_, reading) && reading.*field >= 0.0f;
+                return ok ? (double)(reading.*field) : NAN;
+            };
+        };
+        auto clock = [this](int GpuSensorReading::*field) {
+            return [this, field] {
+                GpuSensorReading reading;
+                const bool ok = sensors_.read_gpu_sensors(device_id_, reading) && reading.*field >= 0;
+                return ok ? (double)(reading.*field) : NAN;
+            };
+        };
+        MetricLabels graphics = labels;
+        graphics.emplace_back("clock", "graphics");
+        MetricLabels memory = labels;
+        memory.emplace_back("clock", "memory");
+        
+        registry.add_callback(this, "btc_recovery_gpu_temperature_celsius", "GPU temperature", labels,
+                              sample(&GpuSensorReading::temperature_c));
+        registry.add_callback(this, "btc_recovery_gpu_power_watts", "GPU board power draw", labels,
+                              sample(&GpuSensorReading::power_w));
+        registry.add_callback(this, "btc_recovery_gpu_clock_mhz", "Current GPU clocks", graphics,
+                              clock(&GpuSensorReading::graphics_clock_mhz));
+        registry.add_callback(this, "btc_recovery_gpu_clock_mhz", "Current GPU clocks", memory,
+                              clock(&GpuSensorReading::memory_clock_mhz));
+    }
+    
+    /**
+     * Candidates to put in the next batch under the governor's setting
+     */
+    size_t governed_capacity(const CandidateBatch& staging) const {
+        if (!governed_) {
+            return staging.capacity();
+        }
+        const size_t capacity = (size_t)(staging.capacity() * governor_.setting().batch_fraction);
+        return std::max<size_t>(capacity, 1);
+    }
+    
+    /**
+     * Run a governor step when one is due, then hold the next batch back
+     * long enough to keep the device at the governed duty cycle
+     */
+    void pace(int num_passwords) {
+        if (!governed_) {
+            return;
+        }
+        governor_.record((uint64_t)num_passwords);
+        const double now =
+            std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        if (governor_.due(now)) {
+            GpuSensorReading reading;
+            sensors_.read_gpu_sensors(device_id_, reading);
+            if (governor_.update(reading, now)) {
+                const ThermalSetting& setting = governor_.setting();
+                metrics_.governor_level->set(governor_.level());
+                Logger::debug("Thermal governor on " + gpu_info_.name + ": level " +
+                              std::to_string(governor_.level()) + " at " + std::to_string(reading.temperature_c) +
+                              " C, occupancy " + std::to_string(setting.occupancy) + ", duty cycle " +
+                              std::to_string(setting.duty_cycle));
             }
         }
         
-        // Allocate device memory
-        char* d_passwords;
-        unsigned char* d_wallet_data;
-        bool* d_results;
-        int* d_found_index;
+        // Slots still queued keep the device busy, so the pause throttles the
+        // rate work is handed out rather than idling the device outright
+        const double idle = governor_.setting().idle_after(last_kernel_seconds_);
+        if (idle > 0.0) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(idle));
+        }
+    }
+    
+    void retire_slot(StreamSlot& slot) {
+        if (!slot.in_flight) {
+            return;
+        }
+        slot.in_flight = false;
+        metrics_.in_flight->set((double)--in_flight_count_);
         
-        size_t password_size = passwords.size() * max_password_length;
-        size_t wallet_size = wallet_data.size();
+        cudaError_t error = cudaEventSynchronize(slot.done);
+        if (error != cudaSuccess) {
+            Logger::error("CUDA kernel error: " + std::string(cudaGetErrorString(error)));
+            return;
+        }
         
-        // Use unified memory if supported and recommended
-        if (gpu_info_.unified_memory_support && profile_.enable_unified_memory) {
-            cudaMallocManaged(&d_passwords, password_size);
-            cudaMallocManaged(&d_wallet_data, wallet_size);
-            cudaMallocManaged(&d_results, passwords.size() * sizeof(bool));
-            cudaMallocManaged(&d_found_index, sizeof(int));
-        } else {
-            cudaMalloc(&d_passwords, password_size);
-            cudaMalloc(&d_wallet_data, wallet_size);
-            cudaMalloc(&d_results, passwords.size() * sizeof(bool));
-            cudaMalloc(&d_found_index, sizeof(int));
+        float milliseconds = 0.0f;
+        if (!zero_copy_ && cudaEventElapsedTime(&milliseconds, slot.started, slot.copied) == cudaSuccess) {
+            metrics_.host_to_device->observe(milliseconds / 1000.0);
+        }
+        if (cudaEventElapsedTime(&milliseconds, slot.copied, slot.computed) == cudaSuccess) {
+            last_kernel_seconds_ = milliseconds / 1000.0;
+            metrics_.kernel->observe(last_kernel_seconds_);
+        }
+        if (cudaEventElapsedTime(&milliseconds, slot.computed, slot.done) == cudaSuccess) {
+            metrics_.device_to_host->observe(milliseconds / 1000.0);
         }
         
-        // Copy data to device
-        cudaMemcpy(d_passwords, host_passwords.data(), password_size, cudaMemcpyHostToDevice);
-        cudaMemcpy(d_wallet_data, wallet_data.data(), wallet_size, cudaMemcpyHostToDevice);
-        cudaMemcpy(d_results, host_results.data(), passwords.size() * sizeof(bool), cudaMemcpyHostToDevice);
+        const auto verify_start = std::chrono::steady_clock::now();
+        check_result(slot);
+        metrics_.verify->observe(
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - verify_start).count());
+    }
+    
+    // Record a match reported by a retired slot, rebuilding rule candidates
+    void check_result(const StreamSlot& slot) {
+        const int found_index = *slot.h_found_index;
+        const int num_words = (int)slot.batch->size();
+        if (found_ || found_index < 0 || found_index >= num_words * (int)std::max<size_t>(rule_count_, 1)) {
+            return;
+        }
         
-        int found_index = -1;
-        cudaMemcpy(d_found_index, &found_index, sizeof(int), cudaMemcpyHostToDevice);
+        if (rule_count_ == 0) {
+            found_password_ = slot.batch->to_string(found_index);
+            found_ = true;
+            return;
+        }
         
+        // Re-run the matching rule on its word, exactly as the kernel did
+        const size_t word = found_index % num_words;
+        const size_t rule = found_index / num_words;
+        uint8_t candidate[CandidateBatch::MAX_STRIDE];
+        int length = (int)slot.batch->length(word);
+        memcpy(candidate, slot.batch->data(word), length);
+        length = rule_apply(rule_bytecode_.data() + rule_offsets_[rule], candidate, length,
+                            (int)slot.batch->max_length());
+        if (length >= 0) {
+            found_password_.assign(reinterpret_cast<const char*>(candidate), length);
+            found_ = true;
+        }
+    }
+    
+    void launch_kernel(StreamSlot& slot, int num_passwords) {
+        const size_t stride = slot.batch->stride();
+        cudaStream_t stream = slot.stream;
+        const int num_candidates = num_passwords * (int)std::max<size_t>(rule_count_, 1);
         // Configure kernel launch parameters
         int threads_per_block = profile_.recommended_threads_per_block;
         int blocks_per_grid = std::min(profile_.recommended_blocks_per_grid,
-                                     (int)(passwords.size() + threads_per_block - 1) / threads_per_block);
+                                     (num_candidates + threads_per_block - 1) / threads_per_block);
         
-        // Adjust for power-constrained devices
-        if (gpu_info_.is_power_constrained) {
+        // Adjust for power-constrained devices, unless the geometry was measured
+        if (gpu_info_.is_power_constrained && !tuned_) {
             threads_per_block = std::min(threads_per_block, 128);
             blocks_per_grid = std::min(blocks_per_grid, 32);
         }
+        if (governed_) {
+            blocks_per_grid = std::max(1, (int)(blocks_per_grid * governor_.setting().occupancy));
+        }
         
-        // Launch appropriate kernel based on GPU capabilities
-        if (gpu_info_.type == NVIDIAIntegratedType::TEGRA_X1 || 
-            gpu_info_.type == NVIDIAIntegratedType::ARM_INTEGRATED) {
-            // Use low-power kernel for very constrained devices
-            cuda_test_passwords_low_power<<<blocks_per_grid, threads_per_block>>>(
-                d_passwords, max_password_length, passwords.size(),
-                d_wallet_data, wallet_size, d_results, d_found_index
-            );
-        } else {
-            // Use optimized kernel with shared memory
-            size_t shared_mem_size = std::min((size_t)profile_.recommended_shared_memory_size, wallet_size);
-            cuda_test_passwords_integrated<<<blocks_per_grid, threads_per_block, shared_mem_size>>>(
-                d_passwords, max_password_length, passwords.size(),
-                d_wallet_data, wallet_size, d_results, d_found_index, true
-            );
+        // Rule results may grow to the full slot, so the rule kernel is
+        // bucketed by the stride and the plain kernel by the longest candidate
+        if (rule_count_ > 0) {
+            launch_verify_master_key_rules(kernel_length_bucket(slot.batch->max_length()), blocks_per_grid,
+                                           threads_per_block, stream, slot.d_candidates, (int)stride,
+                                           num_passwords, (int)rule_count_, slot.d_found_index);
+            return;
         }
         
-        // Wait for kernel completion
-        cudaDeviceSynchronize();
+        const size_t bucket = kernel_length_bucket(slot.batch->longest());
+#ifdef ENABLE_NVRTC
+        if (launch_specialised_kernel(bucket, blocks_per_grid, threads_per_block, slot, num_passwords)) {
+            return;
+        }
+#endif
+        launch_verify_master_key(bucket, blocks_per_grid, threads_per_block, stream,
+                                 slot.d_candidates, (int)stride, num_passwords, slot.d_found_index);
+    }
+    
+#ifdef ENABLE_NVRTC
+    /**
+     * Launch the kernel NVRTC built for this wallet and bucket, building it
+     * on first use
+     * @return false if no specialised kernel can run; the caller falls back
+     *         to the build-time variant
+     */
+    bool launch_specialised_kernel(size_t bucket, int blocks_per_grid, int threads_per_block,
+                                   StreamSlot& slot, int num_passwords) {
+        const int index = kernel_length_bucket_index(bucket);
+        if (index < 0 || specialised_failed_[index]) {
+            return false;
+        }
+        if (!specialised_kernels_[index] &&
+            !build_specialised_kernel(bucket, specialised_modules_[index], specialised_kernels_[index])) {
+            specialised_failed_[index] = true;
+            return false;
+        }
         
-        // Check for errors
-        cudaError_t error = cudaGetLastError();
-        if (error != cudaSuccess) {
-            Logger::error("CUDA kernel error: " + std::string(cudaGetErrorString(error)));
-            cleanup_device_memory(d_passwords, d_wallet_data, d_results, d_found_index);
+        int stride = (int)slot.batch->stride();
+        void* args[] = {&slot.d_candidates, &stride, &num_passwords, &slot.d_found_index};
+        const CUresult result = cuLaunchKernel(specialised_kernels_[index], blocks_per_grid, 1, 1,
+                                               threads_per_block, 1, 1, 0, (CUstream)slot.stream, args, nullptr);
+        if (result != CUDA_SUCCESS) {
+            const char* message = nullptr;
+            cuGetErrorString(result, &message);
+            Logger::warn("Specialised kernel launch failed, using the generic build: " +
+                         std::string(message ? message : "unknown error"));
+            specialised_failed_[index] = true;
             return false;
         }
+        return true;
+    }
+    
+    /**
+     * Compile and load the kernel with this wallet's record, salt block and
+     * iteration count as constants. The module is not cached on disk, since
+     * it would hold the wallet's verification record.
+     */
+    bool build_specialised_kernel(size_t bucket, CUmodule& module, CUfunction& function) {
+        const auto started = std::chrono::steady_clock::now();
+        const std::string source = nvrtc_mkey_kernel_source(master_key_, bucket);
+        std::string arch = "--gpu-architecture=sm_";
+        for (char c : gpu_info_.compute_capability) {
+            if (c != '.') {
+                arch += c;
+            }
+        }
         
-        // Copy results back
-        cudaMemcpy(host_results.data(), d_results, passwords.size() * sizeof(bool), cudaMemcpyDeviceToHost);
-        cudaMemcpy(&found_index, d_found_index, sizeof(int), cudaMemcpyDeviceToHost);
+        std::vector<const char*> header_names;
+        std::vector<const char*> header_sources;
+        for (const NvrtcHeader& header : NVRTC_HEADERS) {
+            header_names.push_back(header.name);
+            header_sources.push_back(header.source);
+        }
+        header_names.push_back("cstddef");
+        header_sources.push_back(NVRTC_CSTDDEF);
+        header_names.push_back("cstdint");
+        header_sources.push_back(NVRTC_CSTDINT);
         
-        // Check for found password
-        bool password_found = false;
-        if (found_index >= 0 && found_index < (int)passwords.size()) {
-            found_password = passwords[found_index];
-            password_found = true;
+        nvrtcProgram program;
+        nvrtcResult compiled = nvrtcCreateProgram(&program, source.c_str(), "mkey_specialised.cu",
+                                                  (int)header_names.size(), header_sources.data(),
+                                                  header_names.data());
+        if (compiled != NVRTC_SUCCESS) {
+            Logger::warn("NVRTC unavailable: " + std::string(nvrtcGetErrorString(compiled)));
+            return false;
+        }
+        const char* options[] = {arch.c_str()};
+        compiled = nvrtcCompileProgram(program, 1, options);
+        std::vector<char> cubin;
+        if (compiled == NVRTC_SUCCESS) {
+            size_t size = 0;
+            nvrtcGetCUBINSize(program, &size);
+            cubin.resize(size);
+            nvrtcGetCUBIN(program, cubin.data());
         } else {
-            // Check results array as fallback
-            for (size_t i = 0; i < passwords.size(); i++) {
-                if (host_results[i]) {
-                    found_password = passwords[i];
-                    password_found = true;
-                    break;
-                }
-            }
+            size_t log_size = 0;
+            nvrtcGetProgramLogSize(program, &log_size);
+            std::string log(log_size, '\0');
+            nvrtcGetProgramLog(program, &log[0]);
+            Logger::warn("NVRTC could not build the specialised kernel for " + gpu_info_.name + ": " +
+                         std::string(nvrtcGetErrorString(compiled)));
+            Logger::debug(log);
+        }
+        nvrtcDestroyProgram(&program);
+        if (compiled != NVRTC_SUCCESS) {
+            return false;
         }
         
-        // Cleanup
-        cleanup_device_memory(d_passwords, d_wallet_data, d_results, d_found_index);
+        CUresult result = cuModuleLoadData(&module, cubin.data());
+        if (result == CUDA_SUCCESS) {
+            result = cuModuleGetFunction(&function, module, NVRTC_MKEY_KERNEL_NAME);
+        }
+        if (result != CUDA_SUCCESS) {
+            const char* message = nullptr;
+            cuGetErrorString(result, &message);
+            Logger::warn("Failed to load the specialised kernel: " + std::string(message ? message : "unknown error"));
+            if (module) {
+                cuModuleUnload(module);
+            }
+            module = nullptr;
+            function = nullptr;
+            return false;
+        }
         
-        return password_found;
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        Logger::info("Built " + std::to_string(bucket) + "-byte kernel for " +
+                     std::to_string(master_key_.iterations) + " iterations on " + gpu_info_.name + " in " +
+                     std::to_string(seconds) + " s");
+        return true;
     }
     
-private:
-    int device_id_;
-    bool initialized_;
-    CUDAIntegratedInfo gpu_info_;
-    CUDAIntegratedProfile profile_;
-    std::vector<cudaStream_t> streams_;
+    void release_specialised_kernels() {
+        for (size_t i = 0; i < KERNEL_LENGTH_BUCKET_COUNT; i++) {
+            if (specialised_modules_[i]) {
+                cuModuleUnload(specialised_modules_[i]);
+            }
+            specialised_modules_[i] = nullptr;
+            specialised_kernels_[i] = nullptr;
+            specialised_failed_[i] = false;
+        }
+    }
+#endif
     
-    void initialize_memory_pools() {
-        // Initialize memory pools for better performance
-        // This is a simplified implementation
-        Logger::debug("Initializing CUDA memory pools for integrated GPU");
+    bool run_self_test() {
+        unsigned char* d_buffer = nullptr;
+        if (cudaMalloc(&d_buffer, 512) != cudaSuccess) {
+            return false;
+        }
+        
+        bool passed = true;
+        for (size_t i = 0; i < PBKDF2_SHA512_TEST_VECTOR_COUNT && passed; i++) {
+            const auto& vector = PBKDF2_SHA512_TEST_VECTORS[i];
+            const int password_length = strlen(vector.password);
+            const int salt_length = strlen(vector.salt);
+            
+            unsigned char* d_password = d_buffer;
+            unsigned char* d_salt = d_buffer + 128;
+            unsigned char* d_key = d_buffer + 256;
+            cudaMemcpy(d_password, vector.password, password_length, cudaMemcpyHostToDevice);
+            cudaMemcpy(d_salt, vector.salt, salt_length, cudaMemcpyHostToDevice);
+            
+            cuda_pbkdf2_sha512_self_test<<<1, 1>>>(d_password, password_length, d_salt, salt_length,
+                                                   vector.iterations, d_key, vector.key_length);
+            
+            unsigned char key[64];
+            if (cudaMemcpy(key, d_key, vector.key_length, cudaMemcpyDeviceToHost) != cudaSuccess) {
+                passed = false;
+                break;
+            }
+            
+            static const char* digits = "0123456789abcdef";
+            std::string hex;
+            for (size_t j = 0; j < vector.key_length; j++) {
+                hex += digits[key[j] >> 4];
+                hex += digits[key[j] & 0x0f];
+            }
+            passed = (hex == vector.expected_hex);
+        }
+        
+        cudaFree(d_buffer);
+        return passed;
     }
     
-    void cleanup_device_memory(char* d_passwords, unsigned char* d_wallet_data, 
-                              bool* d_results, int* d_found_index) {
-        if (d_passwords) cudaFree(d_passwords);
-        if (d_wallet_data) cudaFree(d_wallet_data);
-        if (d_results) cudaFree(d_results);
-        if (d_found_index) cudaFree(d_found_index);
+    bool initialize_memory_pools() {
+        slot_capacity_ = profile_.recommended_batch_size > 0 ? profile_.recommended_batch_size : 10000;
+        const size_t pool_bytes = slot_capacity_ * CandidateBatch::DEFAULT_STRIDE;
+        const int slot_count = profile_.use_streams ? std::max(1, profile_.stream_count) : 1;
+        
+        // Integrated GPUs share physical memory with the host, so their
+        // staging buffers are mapped into the device instead of copied
+        zero_copy_ = gpu_info_.unified_memory_support && profile_.enable_unified_memory;
+        const unsigned int host_flags = zero_copy_ ? cudaHostAllocMapped : cudaHostAllocWriteCombined;
+        
+        slots_.resize(slot_count);
+        cudaError_t error = cudaSuccess;
+        for (auto& slot : slots_) {
+            if (error == cudaSuccess) error = cudaStreamCreateWithFlags(&slot.stream, cudaStreamNonBlocking);
+            if (error == cudaSuccess) error = cudaEventCreate(&slot.started);
+            if (error == cudaSuccess) error = cudaEventCreate(&slot.copied);
+            if (error == cudaSuccess) error = cudaEventCreate(&slot.computed);
+            if (error == cudaSuccess) error = cudaEventCreate(&slot.done);
+            if (error == cudaSuccess) error = cudaHostAlloc(&slot.h_staging, pool_bytes, host_flags);
+            if (error == cudaSuccess) error = cudaHostAlloc(&slot.h_found_index, sizeof(int), cudaHostAllocDefault);
+            if (error == cudaSuccess) {
+                error = zero_copy_ ? cudaHostGetDevicePointer(&slot.d_candidates, slot.h_staging, 0)
+                                   : cudaMalloc(&slot.d_candidates, pool_bytes);
+            }
+            if (error == cudaSuccess) error = cudaMalloc(&slot.d_found_index, sizeof(int));
+            if (error == cudaSuccess) {
+                slot.batch = std::make_unique<CandidateBatch>(slot.h_staging, slot_capacity_);
+            }
+        }
+        
+        if (error != cudaSuccess) {
+            Logger::error("Failed to allocate CUDA memory pools: " + std::string(cudaGetErrorString(error)));
+            return false;
+        }
+        
+        LOG_DEBUG("Allocated " + std::to_string(slot_count) + " CUDA pipeline slots for " +
+                      std::to_string(slot_capacity_) + " candidates each");
+        return true;
     }
     
+    void release_memory_pools() {
+        for (auto& slot : slots_) {
+            if (slot.in_flight) cudaEventSynchronize(slot.done);
+            if (slot.d_candidates && !zero_copy_) cudaFree(slot.d_candidates);
+            if (slot.d_found_index) cudaFree(slot.d_found_index);
+            if (slot.h_staging) cudaFreeHost(slot.h_staging);
+            if (slot.h_found_index) cudaFreeHost(slot.h_found_index);
+            if (slot.started) cudaEventDestroy(slot.started);
+            if (slot.copied) cudaEventDestroy(slot.copied);
+            if (slot.computed) cudaEventDestroy(slot.computed);
+            if (slot.done) cudaEventDestroy(slot.done);
+            if (slot.stream) cudaStreamDestroy(slot.stream);
+        }
+        slots_.clear();
+        next_slot_ = 0;
+        slot_capacity_ = 0;
+        in_flight_count_ = 0;
+        if (metrics_.in_flight) {
+            metrics_.in_flight->set(0.0);
+        }
+    }
+    
+    // Frees only this instance's streams and buffers; resetting the device
+    // would tear down the context under other instances sharing it
     void cleanup() {
-        if (initialized_) {
-            for (auto& stream : streams_) {
-                cudaStreamDestroy(stream);
-            }
-            streams_.clear();
-            
-            cudaDeviceReset();
-            initialized_ = false;
+        MetricsRegistry::global().remove_callbacks(this);
+        if (initialized_ && device_ready_) {
+            select_device();
+            release_memory_pools();
+#ifdef ENABLE_NVRTC
+            release_specialised_kernels();
+#endif
         }
+        device_ready_ = false;
+        initialized_ = false;
     }
 };
 
@@ -346,10 +1276,50 @@ extern "C" {
         delete static_cast<CUDAIntegratedRecovery*>(recovery);
     }
     
+    // Every CUDA device, discrete or integrated; create one recovery per device
+    int cuda_integrated_recovery_device_count() {
+        return (int)device_inventory().backend_devices(InventoryBackend::CUDA).size();
+    }
+    
     int cuda_integrated_recovery_initialize(void* recovery, int device_id) {
         return static_cast<CUDAIntegratedRecovery*>(recovery)->initialize(device_id) ? 1 : 0;
     }
     
+    // wallet_data is a BitcoinCoreMKeyCheck record from BitcoinCoreWallet::get_master_key_check
+    int cuda_integrated_recovery_initialize_with_wallet(void* recovery, int device_id,
+                                                       const unsigned char* wallet_data,
+                                                       int wallet_data_size) {
+        if (!wallet_data || wallet_data_size != (int)sizeof(BitcoinCoreMKeyCheck)) {
+            Logger::error("Wallet data is not a master-key verification record");
+            return 0;
+        }
+        BitcoinCoreMKeyCheck master_key;
+        memcpy(&master_key, wallet_data, sizeof(master_key));
+        return static_cast<CUDAIntegratedRecovery*>(recovery)->initialize(device_id, &master_key) ? 1 : 0;
+    }
+    
+    // Call after the master key is uploaded; cache_path NULL or "" uses the default cache
+    int cuda_integrated_recovery_autotune(void* recovery, const char* cache_path) {
+        TuningCache cache(cache_path ? cache_path : "");
+        if (!cache.load()) {
+            Logger::warn(cache.get_last_error() + "; retuning");
+        }
+        return static_cast<CUDAIntegratedRecovery*>(recovery)->autotune(cache) ? 1 : 0;
+    }
+    
+    // bytecode and offsets come from RuleEngine; rule_count 0 disables expansion
+    int cuda_integrated_recovery_upload_rules(void* recovery,
+                                              const unsigned char* bytecode,
+                                              int bytecode_size,
+                                              const unsigned int* offsets,
+                                              int rule_count) {
+        if (bytecode_size < 0 || rule_count < 0) {
+            return 0;
+        }
+        return static_cast<CUDAIntegratedRecovery*>(recovery)->upload_rules(
+            bytecode, bytecode_size, offsets, rule_count) ? 1 : 0;
+    }
+    
     int cuda_integrated_recovery_test_passwords(void* recovery, 
                                                const char** passwords, 
                                                int num_passwords,
@@ -358,16 +1328,46 @@ extern "C" {
                                                char* found_password,
                                                int max_password_length) {
         auto* cuda_recovery = static_cast<CUDAIntegratedRecovery*>(recovery);
+        if (!cuda_recovery->is_initialized()) {
+            Logger::error("CUDA integrated recovery not initialized");
+            return 0;
+        }
+        
+        // The master-key record is uploaded once and reused while it stays the same
+        if (!wallet_data || wallet_data_size != (int)sizeof(BitcoinCoreMKeyCheck)) {
+            Logger::error("Wallet data is not a master-key verification record");
+            return 0;
+        }
+        BitcoinCoreMKeyCheck master_key;
+        memcpy(&master_key, wallet_data, sizeof(master_key));
+        if (!cuda_recovery->is_master_key_uploaded(master_key) &&
+            !cuda_recovery->upload_master_key(master_key)) {
+            return 0;
+        }
+        if (!cuda_recovery->ensure_device()) {
+            return 0;
+        }
         
-        std::vector<std::string> pwd_vector;
+        // Candidates are written straight into the pipeline's pinned staging
+        // batches, so filling one slot overlaps the kernels of the others
+        cuda_recovery->reset_found();
+        CandidateBatch* batch = &cuda_recovery->acquire_batch();
         for (int i = 0; i < num_passwords; i++) {
-            pwd_vector.emplace_back(passwords[i]);
+            if (batch->full()) {
+                if (!cuda_recovery->submit_batch()) {
+                    cuda_recovery->drain();
+                    return 0;
+                }
+                batch = &cuda_recovery->acquire_batch();
+            }
+            if (!batch->push(passwords[i], strlen(passwords[i]))) {
+                LOG_DEBUG("Skipping candidate longer than " + std::to_string(batch->max_length()) + " bytes");
+            }
         }
         
-        std::vector<unsigned char> wallet_vector(wallet_data, wallet_data + wallet_data_size);
         std::string found;
-        
-        bool success = cuda_recovery->test_passwords(pwd_vector, wallet_vector, found);
+        bool success = cuda_recovery->submit_batch() && cuda_recovery->drain() &&
+                       cuda_recovery->get_found_password(found);
         
         if (success && !found.empty()) {
             strncpy(found_password, found.c_str(), max_password_length - 1);
@@ -377,6 +1377,24 @@ extern "C" {
         
         return 0;
     }
+    
+    // range is this device's chunk of the keyspace generator indexes
+    int cuda_integrated_recovery_test_range(void* recovery,
+                                            const MaskGenerator* generator,
+                                            const KeyspaceRange* range,
+                                            char* found_password,
+                                            int max_password_length) {
+        if (!generator || !range || max_password_length <= 0) {
+            return 0;
+        }
+        std::string found;
+        if (!static_cast<CUDAIntegratedRecovery*>(recovery)->test_range(*generator, *range, found)) {
+            return 0;
+        }
+        strncpy(found_password, found.c_str(), max_password_length - 1);
+        found_password[max_password_length - 1] = '\0';
+        return 1;
+    }
 }
 
 #endif // ENABLE_CUDA
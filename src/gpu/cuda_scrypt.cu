@@ -0,0 +1,282 @@
+#ifdef ENABLE_CUDA
+
+#include <cuda_runtime.h>
+#include <device_launch_parameters.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "utils/logger.h"
+#include "utils/scrypt.h"
+#include "utils/scrypt_engine.h"
+
+namespace {
+
+// Resident lanes per SM needed to hide global-memory latency; the TMTO
+// plan trades recomputation for lanes until this many fit
+const size_t LANES_PER_MULTIPROCESSOR = 256;
+
+// Share of free device memory given to the V tables
+const double MEMORY_BUDGET_RATIO = 0.85;
+
+const int THREADS_PER_BLOCK = 64;
+
+// RFC 7914 vector 1, small enough to run on every device at startup
+const char* const SELF_TEST_EXPECTED =
+    "77d6576238657b203b19ca42c18a0497f16b4844e3074ae8dfdffa3fede21442"
+    "fcd0069ded0948f8326a753a0fc81f17e8d3e0fb2e0d3628cf35e20c38d18906";
+
+} // namespace
+
+// ROMix, one lane per thread. blocks holds the expanded lanes as
+// little-endian words; each lane's V table and working blocks start at
+// scratch + lane * scratch_words
+__global__ void cuda_scrypt_romix(uint32_t* blocks, uint32_t* scratch, uint32_t lane_count,
+                                  uint32_t N, uint32_t r, uint32_t lookup_gap, size_t scratch_words) {
+    const uint32_t lane = blockIdx.x * blockDim.x + threadIdx.x;
+    if (lane >= lane_count) {
+        return;
+    }
+    scrypt_romix(blocks + lane * scrypt_block_words(r), scratch + lane * scratch_words, N, r, lookup_gap);
+}
+
+/**
+ * scrypt on one CUDA device
+ *
+ * The password expansion and final PBKDF2-HMAC-SHA256 are cheap and run
+ * on the host; the device runs ROMix for as many lanes as the TMTO plan
+ * fits into free memory. The lookup gap is chosen once per device and
+ * parameter set, so an 8 GB card keeps thousands of BIP38 lanes resident
+ * instead of the few hundred full 16 MB tables would allow.
+ */
+class CUDAScryptEngine {
+public:
+    CUDAScryptEngine()
+        : device_id_(-1), params_(), scratch_words_(0), d_blocks_(nullptr), d_scratch_(nullptr),
+          initialized_(false) {}
+
+    ~CUDAScryptEngine() {
+        cleanup();
+    }
+
+    CUDAScryptEngine(const CUDAScryptEngine&) = delete;
+    CUDAScryptEngine& operator=(const CUDAScryptEngine&) = delete;
+
+    /**
+     * Plan the lookup gap for this device and allocate the lane buffers
+     * @param device_id CUDA device
+     * @param params scrypt parameters
+     * @return true if successful
+     */
+    bool initialize(int device_id, const ScryptParams& params) {
+        cleanup();
+        if (!scrypt_params_valid(params)) {
+            Logger::error("Invalid scrypt parameters");
+            return false;
+        }
+        device_id_ = device_id;
+        params_ = params;
+
+        cudaDeviceProp props;
+        cudaError_t error = cudaSetDevice(device_id_);
+        if (error == cudaSuccess) error = cudaGetDeviceProperties(&props, device_id_);
+        size_t free_bytes = 0;
+        size_t total_bytes = 0;
+        if (error == cudaSuccess) error = cudaMemGetInfo(&free_bytes, &total_bytes);
+        if (error != cudaSuccess) {
+            Logger::error("Failed to query CUDA device " + std::to_string(device_id_) + ": " +
+                          std::string(cudaGetErrorString(error)));
+            return false;
+        }
+
+        // Each lane also needs its expanded block and two working blocks
+        const size_t budget = static_cast<size_t>(free_bytes * MEMORY_BUDGET_RATIO);
+        const size_t block_bytes = scrypt_block_words(params_.r) * sizeof(uint32_t);
+        const size_t target = static_cast<size_t>(props.multiProcessorCount) * LANES_PER_MULTIPROCESSOR;
+        plan_ = scrypt_plan_tmto(params_, budget, target);
+        if (plan_.lanes > 0) {
+            plan_.lanes = std::min(plan_.lanes, budget / (plan_.bytes_per_lane + 3 * block_bytes));
+        }
+        if (plan_.lanes == 0) {
+            Logger::error("Not enough memory on " + std::string(props.name) + " for one scrypt lane");
+            return false;
+        }
+
+        scratch_words_ = scrypt_scratch_words(params_, plan_.lookup_gap);
+        error = cudaMalloc(&d_blocks_, plan_.lanes * block_bytes);
+        if (error == cudaSuccess) error = cudaMalloc(&d_scratch_, plan_.lanes * scratch_words_ * sizeof(uint32_t));
+        if (error != cudaSuccess) {
+            Logger::error("Failed to allocate scrypt lanes: " + std::string(cudaGetErrorString(error)));
+            cleanup();
+            return false;
+        }
+
+        initialized_ = true;
+        if (!run_self_test()) {
+            Logger::error("scrypt self-test failed on device: " + std::string(props.name));
+            cleanup();
+            return false;
+        }
+
+        Logger::info("CUDA scrypt initialized for device: " + std::string(props.name));
+        Logger::info("  Lookup gap: " + std::to_string(plan_.lookup_gap) + ", " + std::to_string(plan_.lanes) +
+                     " lanes of " + std::to_string(plan_.bytes_per_lane >> 10) + " KB");
+        return true;
+    }
+
+    /**
+     * Derive keys for a batch of passwords
+     * @param passwords Array of password pointers
+     * @param lengths Array of password lengths
+     * @param count Number of passwords
+     * @param salt Salt bytes
+     * @param salt_length Salt length
+     * @param derived_keys Output buffer of count * key_length bytes
+     * @param key_length Derived key length per password
+     * @return true if successful
+     */
+    bool derive(const uint8_t* const* passwords, const size_t* lengths, size_t count,
+                const uint8_t* salt, size_t salt_length, uint8_t* derived_keys, size_t key_length) {
+        return derive_with(params_, plan_.lookup_gap, passwords, lengths, count, salt, salt_length,
+                           derived_keys, key_length);
+    }
+
+    bool is_initialized() const { return initialized_; }
+    const ScryptTmtoPlan& get_plan() const { return plan_; }
+
+private:
+    int device_id_;
+    ScryptParams params_;
+    ScryptTmtoPlan plan_;
+    size_t scratch_words_;
+    uint32_t* d_blocks_;
+    uint32_t* d_scratch_;
+    std::vector<uint8_t> expanded_;
+    std::vector<uint32_t> words_;
+    bool initialized_;
+
+    // params may be smaller than the ones the buffers were sized for
+    bool derive_with(const ScryptParams& params, uint32_t lookup_gap,
+                     const uint8_t* const* passwords, const size_t* lengths, size_t count,
+                     const uint8_t* salt, size_t salt_length, uint8_t* derived_keys, size_t key_length) {
+        if (!initialized_) {
+            Logger::error("CUDA scrypt not initialized");
+            return false;
+        }
+        cudaError_t error = cudaSetDevice(device_id_);
+        if (error != cudaSuccess) {
+            Logger::error("Failed to set CUDA device " + std::to_string(device_id_) + ": " +
+                          std::string(cudaGetErrorString(error)));
+            return false;
+        }
+
+        const size_t block_words = scrypt_block_words(params.r);
+        const size_t lane_bytes = block_words * sizeof(uint32_t);
+        const size_t candidate_bytes = params.p * lane_bytes;
+        const size_t total_lanes = count * params.p;
+        expanded_.resize(count * candidate_bytes);
+        for (size_t i = 0; i < count; i++) {
+            pbkdf2_hmac_sha256(passwords[i], lengths[i], salt, salt_length, 1,
+                               expanded_.data() + i * candidate_bytes, candidate_bytes);
+        }
+
+        const size_t scratch_words = scrypt_scratch_words(params, lookup_gap);
+        words_.resize(std::min(total_lanes, plan_.lanes) * block_words);
+        for (size_t first = 0; first < total_lanes && error == cudaSuccess; first += plan_.lanes) {
+            const size_t lanes = std::min(plan_.lanes, total_lanes - first);
+            scrypt_bytes_to_words(expanded_.data() + first * lane_bytes, words_.data(), lanes * block_words);
+            error = cudaMemcpy(d_blocks_, words_.data(), lanes * lane_bytes, cudaMemcpyHostToDevice);
+            if (error == cudaSuccess) {
+                const unsigned int grid = static_cast<unsigned int>((lanes + THREADS_PER_BLOCK - 1) / THREADS_PER_BLOCK);
+                cuda_scrypt_romix<<<grid, THREADS_PER_BLOCK>>>(d_blocks_, d_scratch_, static_cast<uint32_t>(lanes),
+                                                               params.N, params.r, lookup_gap, scratch_words);
+                error = cudaGetLastError();
+            }
+            if (error == cudaSuccess) {
+                error = cudaMemcpy(words_.data(), d_blocks_, lanes * lane_bytes, cudaMemcpyDeviceToHost);
+            }
+            if (error == cudaSuccess) {
+                scrypt_words_to_bytes(words_.data(), expanded_.data() + first * lane_bytes, lanes * block_words);
+            }
+        }
+        if (error != cudaSuccess) {
+            Logger::error("CUDA scrypt failed: " + std::string(cudaGetErrorString(error)));
+            return false;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            pbkdf2_hmac_sha256(passwords[i], lengths[i], expanded_.data() + i * candidate_bytes, candidate_bytes,
+                               1, derived_keys + i * key_length, key_length);
+        }
+        return true;
+    }
+
+    bool run_self_test() {
+        const ScryptParams params = {16, 1, 1};
+        const uint32_t gap = std::min<uint32_t>(plan_.lookup_gap, params.N);
+        const uint8_t* password = reinterpret_cast<const uint8_t*>("");
+        const size_t length = 0;
+        uint8_t key[64];
+        if (!derive_with(params, gap, &password, &length, 1, password, 0, key, sizeof(key))) {
+            return false;
+        }
+
+        static const char* digits = "0123456789abcdef";
+        std::string hex;
+        for (uint8_t byte : key) {
+            hex += digits[byte >> 4];
+            hex += digits[byte & 0x0f];
+        }
+        return hex == SELF_TEST_EXPECTED;
+    }
+
+    void cleanup() {
+        if (d_scratch_) cudaFree(d_scratch_);
+        if (d_blocks_) cudaFree(d_blocks_);
+        d_scratch_ = nullptr;
+        d_blocks_ = nullptr;
+        expanded_.clear();
+        words_.clear();
+        initialized_ = false;
+    }
+};
+
+extern "C" {
+    void* cuda_scrypt_create() {
+        return new CUDAScryptEngine();
+    }
+
+    void cuda_scrypt_destroy(void* engine) {
+        delete static_cast<CUDAScryptEngine*>(engine);
+    }
+
+    int cuda_scrypt_initialize(void* engine, int device_id, unsigned int N, unsigned int r, unsigned int p) {
+        const ScryptParams params = {N, r, p};
+        return static_cast<CUDAScryptEngine*>(engine)->initialize(device_id, params) ? 1 : 0;
+    }
+
+    // Lookup gap the device runs with, 0 before initialization
+    int cuda_scrypt_lookup_gap(void* engine) {
+        auto* scrypt = static_cast<CUDAScryptEngine*>(engine);
+        return scrypt->is_initialized() ? (int)scrypt->get_plan().lookup_gap : 0;
+    }
+
+    // derived_keys receives num_passwords * key_length bytes
+    int cuda_scrypt_derive(void* engine, const char** passwords, int num_passwords,
+                           const unsigned char* salt, int salt_length,
+                           unsigned char* derived_keys, int key_length) {
+        if (num_passwords < 0 || salt_length < 0 || key_length <= 0) {
+            return 0;
+        }
+        std::vector<const uint8_t*> pointers(num_passwords);
+        std::vector<size_t> lengths(num_passwords);
+        for (int i = 0; i < num_passwords; i++) {
+            pointers[i] = reinterpret_cast<const uint8_t*>(passwords[i]);
+            lengths[i] = strlen(passwords[i]);
+        }
+        return static_cast<CUDAScryptEngine*>(engine)->derive(pointers.data(), lengths.data(), num_passwords,
+                                                              salt, salt_length, derived_keys, key_length) ? 1 : 0;
+    }
+}
+
+#endif // ENABLE_CUDA
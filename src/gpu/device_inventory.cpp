@@ -0,0 +1,429 @@
+#include "gpu/device_inventory.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#ifdef __linux__
+#include <sys/utsname.h>
+#endif
+
+#ifdef ENABLE_OPENCL
+#include "gpu/opencl_utils.h"
+#endif
+
+#ifdef ENABLE_CUDA
+#include <cuda_runtime.h>
+#endif
+
+namespace {
+
+const char* INVENTORY_HEADER = "btc_recovery_devices 1";
+const size_t INVENTORY_FIELDS = 24;
+
+uint64_t fnv1a(const std::string& text) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::string hex64(uint64_t value) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+    return text;
+}
+
+// Tabs and newlines would break the line format
+std::string one_field(std::string text) {
+    std::replace_if(text.begin(), text.end(), [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+    return text;
+}
+
+std::string read_text(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+void add_environment(std::ostringstream& out, const char* name) {
+    const char* value = std::getenv(name);
+    out << name << "=" << (value ? value : "") << "\n";
+}
+
+// Every .icd file with its contents and modification time; installing,
+// removing or upgrading an OpenCL driver touches one of them
+void add_icd_directory(std::ostringstream& out, const std::string& directory) {
+    std::error_code error;
+    std::vector<std::filesystem::path> icds;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.path().extension() == ".icd") {
+            icds.push_back(entry.path());
+        }
+    }
+    std::sort(icds.begin(), icds.end());
+    for (const auto& icd : icds) {
+        const auto modified = std::filesystem::last_write_time(icd, error).time_since_epoch().count();
+        out << "icd " << icd.string() << " " << modified << " " << read_text(icd.string()) << "\n";
+    }
+}
+
+#ifdef __linux__
+void add_driver_modules(std::ostringstream& out) {
+    for (const char* module : {"nvidia", "nvgpu", "amdgpu", "radeon", "i915", "xe"}) {
+        const std::string base = std::string("/sys/module/") + module;
+        out << "module " << module << " " << read_text(base + "/version") << " "
+            << read_text(base + "/srcversion") << "\n";
+    }
+    out << read_text("/proc/driver/nvidia/version");
+}
+
+// Display controllers (PCI class 0x03xxxx), so adding or swapping a GPU is a miss
+void add_display_adapters(std::ostringstream& out) {
+    std::error_code error;
+    std::vector<std::string> adapters;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/bus/pci/devices", error)) {
+        const std::string path = entry.path().string();
+        if (read_text(path + "/class").compare(0, 4, "0x03") != 0) {
+            continue;
+        }
+        std::string adapter = entry.path().filename().string() + " " + read_text(path + "/vendor") + " " +
+                              read_text(path + "/device");
+        std::replace(adapter.begin(), adapter.end(), '\n', ' ');
+        adapters.push_back(adapter);
+    }
+    std::sort(adapters.begin(), adapters.end());
+    for (const auto& adapter : adapters) {
+        out << "pci " << adapter << "\n";
+    }
+}
+#endif
+
+bool parse_int(const std::string& text, long long& value) {
+    char* end = nullptr;
+    value = std::strtoll(text.c_str(), &end, 10);
+    return !text.empty() && *end == '\0';
+}
+
+bool parse_device(const std::string& line, InventoryDevice& device) {
+    std::vector<std::string> fields;
+    std::stringstream in(line);
+    std::string field;
+    while (std::getline(in, field, '\t')) {
+        fields.push_back(field);
+    }
+    if (fields.size() != INVENTORY_FIELDS) {
+        return false;
+    }
+
+    if (fields[0] == "opencl") {
+        device.backend = InventoryBackend::OPENCL;
+    } else if (fields[0] == "cuda") {
+        device.backend = InventoryBackend::CUDA;
+    } else {
+        return false;
+    }
+    device.name = fields[2];
+    device.vendor = fields[3];
+    device.device_version = fields[4];
+    device.driver_version = fields[5];
+
+    // backend \t index \t name \t vendor \t device version \t driver version \t then the numbers below
+    long long values[19];
+    for (size_t i = 0; i < 19; i++) {
+        if (!parse_int(fields[i == 0 ? 1 : i + 5], values[i])) {
+            return false;
+        }
+    }
+    device.index = (int)values[0];
+    device.global_memory = (uint64_t)values[1];
+    device.compute_units = (int)values[2];
+    device.max_work_group_size = (int)values[3];
+    device.max_clock_mhz = (int)values[4];
+    device.integrated = values[5] != 0;
+    device.unified_addressing = values[6] != 0;
+    device.shared_memory_per_block = (uint64_t)values[7];
+    device.max_threads_per_multiprocessor = (int)values[8];
+    device.warp_size = (int)values[9];
+    for (int j = 0; j < 3; j++) {
+        device.max_grid_size[j] = (int)values[10 + j];
+        device.max_block_size[j] = (int)values[13 + j];
+    }
+    device.memory_bus_width = (int)values[16];
+    device.memory_clock_khz = (int)values[17];
+    device.clock_khz = (int)values[18];
+    return true;
+}
+
+void write_device(std::ostringstream& out, const InventoryDevice& device) {
+    out << (device.backend == InventoryBackend::CUDA ? "cuda" : "opencl") << "\t" << device.index << "\t"
+        << one_field(device.name) << "\t" << one_field(device.vendor) << "\t" << one_field(device.device_version)
+        << "\t" << one_field(device.driver_version) << "\t" << device.global_memory << "\t"
+        << device.compute_units << "\t" << device.max_work_group_size << "\t" << device.max_clock_mhz << "\t"
+        << (device.integrated ? 1 : 0) << "\t" << (device.unified_addressing ? 1 : 0) << "\t"
+        << device.shared_memory_per_block << "\t" << device.max_threads_per_multiprocessor << "\t"
+        << device.warp_size;
+    for (int j = 0; j < 3; j++) {
+        out << "\t" << device.max_grid_size[j];
+    }
+    for (int j = 0; j < 3; j++) {
+        out << "\t" << device.max_block_size[j];
+    }
+    out << "\t" << device.memory_bus_width << "\t" << device.memory_clock_khz << "\t" << device.clock_khz << "\n";
+}
+
+} // namespace
+
+std::vector<InventoryDevice> DeviceInventory::backend_devices(InventoryBackend backend) const {
+    std::vector<InventoryDevice> matching;
+    for (const auto& device : devices) {
+        if (device.backend == backend) {
+            matching.push_back(device);
+        }
+    }
+    std::sort(matching.begin(), matching.end(),
+              [](const InventoryDevice& a, const InventoryDevice& b) { return a.index < b.index; });
+    return matching;
+}
+
+const InventoryDevice* DeviceInventory::find(InventoryBackend backend, int index) const {
+    for (const auto& device : devices) {
+        if (device.backend == backend && device.index == index) {
+            return &device;
+        }
+    }
+    return nullptr;
+}
+
+DeviceInventoryCache::DeviceInventoryCache(const std::string& file_path)
+    : file_path_(file_path.empty() ? default_path() : file_path) {}
+
+std::string DeviceInventoryCache::default_path() {
+#ifdef _WIN32
+    const char* base = std::getenv("LOCALAPPDATA");
+    const std::string directory = base ? std::string(base) : std::string(".");
+#else
+    const char* cache = std::getenv("XDG_CACHE_HOME");
+    const char* home = std::getenv("HOME");
+    const std::string directory = (cache && *cache) ? std::string(cache)
+                                : home ? std::string(home) + "/.cache" : std::string(".");
+#endif
+    return directory + "/btc-recovery/devices.tsv";
+}
+
+bool DeviceInventoryCache::load(const std::string& fingerprint, DeviceInventory& inventory) const {
+    std::ifstream file(file_path_);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // header \n fingerprint \n count \n one line per device
+    std::string header, stored_fingerprint, count_line;
+    long long count = 0;
+    if (!std::getline(file, header) || header != INVENTORY_HEADER ||
+        !std::getline(file, stored_fingerprint) || stored_fingerprint != fingerprint ||
+        !std::getline(file, count_line) || !parse_int(count_line, count) || count < 0) {
+        return false;
+    }
+
+    std::vector<InventoryDevice> devices;
+    std::string line;
+    while (std::getline(file, line)) {
+        InventoryDevice device;
+        if (!parse_device(line, device)) {
+            return false;
+        }
+        devices.push_back(device);
+    }
+    if ((long long)devices.size() != count) {
+        return false;  // Truncated
+    }
+
+    inventory.fingerprint = fingerprint;
+    inventory.devices.swap(devices);
+    inventory.from_cache = true;
+    return true;
+}
+
+bool DeviceInventoryCache::store(const DeviceInventory& inventory) {
+    std::ostringstream out;
+    out << INVENTORY_HEADER << "\n" << one_field(inventory.fingerprint) << "\n" << inventory.devices.size() << "\n";
+    for (const auto& device : inventory.devices) {
+        write_device(out, device);
+    }
+    const std::string contents = out.str();
+
+    std::error_code error;
+    const std::filesystem::path path(file_path_);
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+
+    // Cluster workers on one host start together, so readers must only
+    // ever see a complete file
+    const std::string temp_path = file_path_ + ".tmp";
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        last_error_ = "Cannot create device inventory cache: " + temp_path;
+        return false;
+    }
+    const bool written = std::fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+    if ((std::fclose(file) != 0) || !written) {
+        std::remove(temp_path.c_str());
+        last_error_ = "Cannot write device inventory cache: " + temp_path;
+        return false;
+    }
+
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::remove(temp_path.c_str());
+        last_error_ = "Cannot replace device inventory cache: " + file_path_;
+        return false;
+    }
+    return true;
+}
+
+std::string device_fingerprint() {
+    std::ostringstream out;
+    out << "backends";
+#ifdef ENABLE_OPENCL
+    out << " opencl";
+#endif
+#ifdef ENABLE_CUDA
+    out << " cuda";
+#endif
+    out << "\n";
+
+    for (const char* name : {"CUDA_VISIBLE_DEVICES", "CUDA_DEVICE_ORDER", "OCL_ICD_VENDORS", "OCL_ICD_FILENAMES"}) {
+        add_environment(out, name);
+    }
+
+#ifdef __linux__
+    struct utsname system;
+    if (uname(&system) == 0) {
+        out << "kernel " << system.release << "\n";
+    }
+    const char* vendors = std::getenv("OCL_ICD_VENDORS");
+    add_icd_directory(out, (vendors && *vendors) ? vendors : "/etc/OpenCL/vendors");
+    add_driver_modules(out);
+    add_display_adapters(out);
+#endif
+
+#ifdef ENABLE_CUDA
+    // Neither call creates a context
+    int driver_version = 0;
+    int runtime_version = 0;
+    cudaDriverGetVersion(&driver_version);
+    cudaRuntimeGetVersion(&runtime_version);
+    out << "cuda " << driver_version << " " << runtime_version << "\n";
+#endif
+
+    return hex64(fnv1a(out.str()));
+}
+
+DeviceInventory scan_devices() {
+    DeviceInventory inventory;
+
+#ifdef ENABLE_OPENCL
+    const auto opencl_devices = opencl_integrated_devices();
+    for (size_t i = 0; i < opencl_devices.size(); i++) {
+        const cl_device_id id = opencl_devices[i].device;
+        InventoryDevice device;
+        device.backend = InventoryBackend::OPENCL;
+        device.index = (int)i;
+        device.name = opencl_devices[i].name;
+        device.vendor = opencl_devices[i].vendor;
+        device.device_version = opencl_device_string(id, CL_DEVICE_VERSION);
+        device.driver_version = opencl_device_string(id, CL_DRIVER_VERSION);
+        device.integrated = opencl_devices[i].host_unified_memory;
+
+        cl_ulong memory_size = 0;
+        cl_uint compute_units = 0;
+        size_t work_group_size = 0;
+        cl_uint clock_mhz = 0;
+        clGetDeviceInfo(id, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(memory_size), &memory_size, nullptr);
+        clGetDeviceInfo(id, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(compute_units), &compute_units, nullptr);
+        clGetDeviceInfo(id, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(work_group_size), &work_group_size, nullptr);
+        clGetDeviceInfo(id, CL_DEVICE_MAX_CLOCK_FREQUENCY, sizeof(clock_mhz), &clock_mhz, nullptr);
+        device.global_memory = memory_size;
+        device.compute_units = (int)compute_units;
+        device.max_work_group_size = (int)work_group_size;
+        device.max_clock_mhz = (int)clock_mhz;
+        inventory.devices.push_back(device);
+    }
+#endif
+
+#ifdef ENABLE_CUDA
+    // Properties come from the driver without creating a context
+    int count = 0;
+    if (cudaGetDeviceCount(&count) != cudaSuccess) {
+        count = 0;
+    }
+    int driver_version = 0;
+    cudaDriverGetVersion(&driver_version);
+    for (int id = 0; id < count; id++) {
+        cudaDeviceProp props;
+        if (cudaGetDeviceProperties(&props, id) != cudaSuccess) {
+            Logger::warn("Failed to get properties for CUDA device " + std::to_string(id));
+            continue;
+        }
+        InventoryDevice device;
+        device.backend = InventoryBackend::CUDA;
+        device.index = id;
+        device.name = props.name;
+        device.vendor = "NVIDIA";
+        device.device_version = std::to_string(props.major) + "." + std::to_string(props.minor);
+        device.driver_version = std::to_string(driver_version);
+        device.global_memory = props.totalGlobalMem;
+        device.compute_units = props.multiProcessorCount;
+        device.max_work_group_size = props.maxThreadsPerBlock;
+        device.max_clock_mhz = props.clockRate / 1000;
+        device.integrated = props.integrated != 0;
+        device.unified_addressing = props.unifiedAddressing != 0;
+        device.shared_memory_per_block = props.sharedMemPerBlock;
+        device.max_threads_per_multiprocessor = props.maxThreadsPerMultiProcessor;
+        device.warp_size = props.warpSize;
+        for (int j = 0; j < 3; j++) {
+            device.max_grid_size[j] = props.maxGridSize[j];
+            device.max_block_size[j] = props.maxThreadsDim[j];
+        }
+        device.memory_bus_width = props.memoryBusWidth;
+        device.memory_clock_khz = props.memoryClockRate;
+        device.clock_khz = props.clockRate;
+        inventory.devices.push_back(device);
+    }
+#endif
+
+    return inventory;
+}
+
+const DeviceInventory& device_inventory() {
+    static const DeviceInventory inventory = [] {
+        const auto start = std::chrono::steady_clock::now();
+        const std::string fingerprint = device_fingerprint();
+
+        DeviceInventoryCache cache;
+        DeviceInventory found;
+        if (!cache.load(fingerprint, found)) {
+            found = scan_devices();
+            found.fingerprint = fingerprint;
+            if (!cache.store(found)) {
+                Logger::warn(cache.get_last_error());
+            }
+        }
+
+        const double milliseconds =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        Logger::info("Device inventory: " + std::to_string(found.devices.size()) + " GPU(s) " +
+                     (found.from_cache ? "from cache" : "scanned") + " in " +
+                     std::to_string((long long)milliseconds) + " ms");
+        return found;
+    }();
+    return inventory;
+}
@@ -0,0 +1,217 @@
+#include "gpu/gpu_sensors.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// NVML ABI subset, declared here so no NVML headers are needed to build
+typedef struct nvmlDevice_st* nvmlDevice_t;
+typedef int nvmlReturn_t;
+const nvmlReturn_t NVML_SUCCESS = 0;
+const int NVML_TEMPERATURE_GPU = 0;
+const int NVML_CLOCK_SM = 1;
+const int NVML_CLOCK_MEM = 2;
+
+// nvmlClocksThrottleReasons bits
+const unsigned long long THROTTLE_SW_POWER_CAP = 0x4ULL;
+const unsigned long long THROTTLE_HW_SLOWDOWN = 0x8ULL;
+const unsigned long long THROTTLE_SW_THERMAL = 0x20ULL;
+const unsigned long long THROTTLE_HW_THERMAL = 0x40ULL;
+const unsigned long long THROTTLE_HW_POWER_BRAKE = 0x80ULL;
+
+std::string read_first_line(const fs::path& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+bool read_number(const fs::path& path, double& value) {
+    const std::string line = read_first_line(path);
+    if (line.empty()) {
+        return false;
+    }
+    try {
+        value = std::stod(line);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Tegra GPU devfreq nodes are named after the GPU block, e.g. 57000000.gpu,
+// 17000000.gv11b or 17000000.ga10b
+bool is_gpu_devfreq(const std::string& name) {
+    static const char* const names[] = {"gpu", "gm20b", "gp10b", "gv11b", "ga10b"};
+    const std::string lower = lowercase(name);
+    for (const char* gpu : names) {
+        if (lower.find(gpu) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+struct GpuSensors::Nvml {
+    void* library = nullptr;
+    nvmlReturn_t (*init)() = nullptr;
+    nvmlReturn_t (*shutdown)() = nullptr;
+    nvmlReturn_t (*handle_by_pci_bus_id)(const char*, nvmlDevice_t*) = nullptr;
+    nvmlReturn_t (*temperature)(nvmlDevice_t, int, unsigned int*) = nullptr;
+    nvmlReturn_t (*clock_info)(nvmlDevice_t, int, unsigned int*) = nullptr;
+    nvmlReturn_t (*power_usage)(nvmlDevice_t, unsigned int*) = nullptr;
+    nvmlReturn_t (*throttle_reasons)(nvmlDevice_t, unsigned long long*) = nullptr;
+    std::map<std::string, nvmlDevice_t> devices;
+
+    bool load() {
+#ifdef _WIN32
+        return false;
+#else
+        library = dlopen("libnvidia-ml.so.1", RTLD_NOW | RTLD_LOCAL);
+        if (!library) {
+            return false;
+        }
+        resolve(init, "nvmlInit_v2");
+        resolve(shutdown, "nvmlShutdown");
+        resolve(handle_by_pci_bus_id, "nvmlDeviceGetHandleByPciBusId_v2");
+        resolve(temperature, "nvmlDeviceGetTemperature");
+        resolve(clock_info, "nvmlDeviceGetClockInfo");
+        resolve(power_usage, "nvmlDeviceGetPowerUsage");
+        resolve(throttle_reasons, "nvmlDeviceGetCurrentClocksThrottleReasons");
+        if (!init || !shutdown || !handle_by_pci_bus_id || init() != NVML_SUCCESS) {
+            dlclose(library);
+            library = nullptr;
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    ~Nvml() {
+#ifndef _WIN32
+        if (library) {
+            shutdown();
+            dlclose(library);
+        }
+#endif
+    }
+
+#ifndef _WIN32
+    template <typename Function>
+    void resolve(Function& function, const char* name) {
+        function = reinterpret_cast<Function>(dlsym(library, name));
+    }
+#endif
+};
+
+GpuSensors::GpuSensors(const std::string& sysfs_root) : sysfs_root_(sysfs_root), nvml_(new Nvml()) {
+    if (!nvml_->load()) {
+        nvml_.reset();
+    }
+}
+
+GpuSensors::~GpuSensors() = default;
+
+GpuSensors& GpuSensors::instance() {
+    static GpuSensors sensors;
+    return sensors;
+}
+
+bool GpuSensors::has_nvml() const {
+    return nvml_ != nullptr;
+}
+
+bool GpuSensors::read(const std::string& pci_bus_id, GpuSensorReading& reading) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reading = GpuSensorReading();
+    if (!pci_bus_id.empty() && nvml_ && read_nvml(pci_bus_id, reading)) {
+        return true;
+    }
+    return read_sysfs(reading);
+}
+
+bool GpuSensors::read_nvml(const std::string& pci_bus_id, GpuSensorReading& reading) {
+    auto it = nvml_->devices.find(pci_bus_id);
+    if (it == nvml_->devices.end()) {
+        nvmlDevice_t device = nullptr;
+        if (nvml_->handle_by_pci_bus_id(pci_bus_id.c_str(), &device) != NVML_SUCCESS) {
+            return false;
+        }
+        it = nvml_->devices.emplace(pci_bus_id, device).first;
+    }
+    nvmlDevice_t device = it->second;
+
+    bool any = false;
+    unsigned int value = 0;
+    if (nvml_->temperature && nvml_->temperature(device, NVML_TEMPERATURE_GPU, &value) == NVML_SUCCESS) {
+        reading.temperature_c = static_cast<float>(value);
+        any = true;
+    }
+    if (nvml_->clock_info && nvml_->clock_info(device, NVML_CLOCK_SM, &value) == NVML_SUCCESS) {
+        reading.graphics_clock_mhz = static_cast<int>(value);
+        any = true;
+    }
+    if (nvml_->clock_info && nvml_->clock_info(device, NVML_CLOCK_MEM, &value) == NVML_SUCCESS) {
+        reading.memory_clock_mhz = static_cast<int>(value);
+    }
+    if (nvml_->power_usage && nvml_->power_usage(device, &value) == NVML_SUCCESS) {
+        reading.power_w = value / 1000.0f;
+    }
+    unsigned long long reasons = 0;
+    if (nvml_->throttle_reasons && nvml_->throttle_reasons(device, &reasons) == NVML_SUCCESS) {
+        reading.thermal_throttling = (reasons & (THROTTLE_SW_THERMAL | THROTTLE_HW_THERMAL | THROTTLE_HW_SLOWDOWN)) != 0;
+        reading.power_throttling = (reasons & (THROTTLE_SW_POWER_CAP | THROTTLE_HW_POWER_BRAKE)) != 0;
+    }
+    return any;
+}
+
+bool GpuSensors::read_sysfs(GpuSensorReading& reading) {
+    std::error_code error;
+    bool any = false;
+
+    // Thermal zones report millidegrees; Tegra names the GPU zone GPU-therm
+    // or gpu-thermal
+    for (const auto& zone : fs::directory_iterator(fs::path(sysfs_root_) / "class" / "thermal", error)) {
+        const std::string name = zone.path().filename().string();
+        if (name.compare(0, 12, "thermal_zone") != 0 ||
+            lowercase(read_first_line(zone.path() / "type")).find("gpu") == std::string::npos) {
+            continue;
+        }
+        double millidegrees = 0.0;
+        if (read_number(zone.path() / "temp", millidegrees)) {
+            reading.temperature_c = static_cast<float>(millidegrees / 1000.0);
+            any = true;
+            break;
+        }
+    }
+
+    // devfreq reports the current GPU clock in Hz
+    for (const auto& node : fs::directory_iterator(fs::path(sysfs_root_) / "class" / "devfreq", error)) {
+        if (!is_gpu_devfreq(node.path().filename().string())) {
+            continue;
+        }
+        double hertz = 0.0;
+        if (read_number(node.path() / "cur_freq", hertz)) {
+            reading.graphics_clock_mhz = static_cast<int>(hertz / 1e6 + 0.5);
+            any = true;
+            break;
+        }
+    }
+    return any;
+}
@@ -1,4 +1,5 @@
 #include "gpu/integrated_gpu.h"
+#include "gpu/device_inventory.h"
 #include "utils/logger.h"
 #include <algorithm>
 #include <fstream>
@@ -21,15 +22,18 @@
 #include <unistd.h>
 #endif
 
-#ifdef ENABLE_OPENCL
-#include <CL/cl.h>
+#ifdef ENABLE_CUDA
+#include "gpu/cuda_integrated.h"
 #endif
 
-IntegratedGPUManager::IntegratedGPUManager() {
+IntegratedGPUManager::IntegratedGPUManager() : detected_(false) {
     initialize_profiles();
 }
 
 std::vector<IntegratedGPUInfo> IntegratedGPUManager::detect_integrated_gpus() {
+    if (detected_) {
+        return gpus_;
+    }
     std::vector<IntegratedGPUInfo> gpus;
     
     Logger::info("Detecting integrated GPUs...");
@@ -54,10 +58,12 @@ std::vector<IntegratedGPUInfo> IntegratedGPUManager::detect_integrated_gpus() {
     
     for (const auto& gpu : gpus) {
         Logger::info("  - " + gpu.name + " (" + gpu.vendor + ")");
-        Logger::debug("    Memory: " + std::to_string(gpu.total_memory / (1024*1024)) + " MB");
-        Logger::debug("    Compute Units: " + std::to_string(gpu.compute_units));
+        LOG_DEBUG("    Memory: " + std::to_string(gpu.total_memory / (1024*1024)) + " MB");
+        LOG_DEBUG("    Compute Units: " + std::to_string(gpu.compute_units));
     }
     
+    gpus_ = gpus;
+    detected_ = true;
     return gpus;
 }
 
@@ -79,82 +85,11 @@ std::unique_ptr<IntegratedGPUInfo> IntegratedGPUManager::get_best_integrated_gpu
 std::vector<IntegratedGPUInfo> IntegratedGPUManager::detect_intel_gpus() {
     std::vector<IntegratedGPUInfo> gpus;
     
-#ifdef ENABLE_OPENCL
-    cl_platform_id platforms[16];
-    cl_uint num_platforms;
-    
-    if (clGetPlatformIDs(16, platforms, &num_platforms) != CL_SUCCESS) {
-        return gpus;
-    }
-    
-    for (cl_uint i = 0; i < num_platforms; i++) {
-        char vendor[256];
-        if (clGetPlatformInfo(platforms[i], CL_PLATFORM_VENDOR, sizeof(vendor), vendor, nullptr) != CL_SUCCESS) {
-            continue;
-        }
-        
-        if (std::string(vendor).find("Intel") == std::string::npos) {
-            continue;
-        }
-        
-        cl_device_id devices[16];
-        cl_uint num_devices;
-        
-        if (clGetDeviceIDs(platforms[i], CL_DEVICE_TYPE_GPU, 16, devices, &num_devices) != CL_SUCCESS) {
-            continue;
-        }
-        
-        for (cl_uint j = 0; j < num_devices; j++) {
-            IntegratedGPUInfo gpu_info;
-            
-            char device_name[256];
-            clGetDeviceInfo(devices[j], CL_DEVICE_NAME, sizeof(device_name), device_name, nullptr);
-            
-            gpu_info.name = device_name;
-            gpu_info.vendor = "Intel";
-            gpu_info.type = identify_intel_gpu(device_name);
-            
-            cl_ulong memory_size;
-            clGetDeviceInfo(devices[j], CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(memory_size), &memory_size, nullptr);
-            gpu_info.total_memory = memory_size;
-            gpu_info.available_memory = memory_size * 0.8; // Conservative estimate
-            
-            cl_uint compute_units;
-            clGetDeviceInfo(devices[j], CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(compute_units), &compute_units, nullptr);
-            gpu_info.compute_units = compute_units;
-            
-            size_t work_group_size;
-            clGetDeviceInfo(devices[j], CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(work_group_size), &work_group_size, nullptr);
-            gpu_info.max_work_group_size = work_group_size;
-            
-            cl_uint clock_freq;
-            clGetDeviceInfo(devices[j], CL_DEVICE_MAX_CLOCK_FREQUENCY, sizeof(clock_freq), &clock_freq, nullptr);
-            gpu_info.max_clock_frequency = clock_freq;
-            
-            gpu_info.supports_opencl = true;
-            gpu_info.is_power_constrained = detect_laptop_system();
-            gpu_info.shared_memory = get_system_memory() / 2; // Shared with system
-            
-            // Set TDP based on GPU type
-            switch (gpu_info.type) {
-                case IntegratedGPUType::INTEL_HD:
-                    gpu_info.thermal_design_power = 15.0f;
-                    break;
-                case IntegratedGPUType::INTEL_IRIS:
-                    gpu_info.thermal_design_power = 28.0f;
-                    break;
-                case IntegratedGPUType::INTEL_ARC:
-                    gpu_info.thermal_design_power = 35.0f;
-                    break;
-                default:
-                    gpu_info.thermal_design_power = 20.0f;
-                    break;
-            }
-            
-            gpus.push_back(gpu_info);
+    for (const auto& device : device_inventory().backend_devices(InventoryBackend::OPENCL)) {
+        if (device.vendor == "Intel") {
+            gpus.push_back(describe_opencl_device(device));
         }
     }
-#endif
     
     return gpus;
 }
@@ -162,82 +97,69 @@ std::vector<IntegratedGPUInfo> IntegratedGPUManager::detect_intel_gpus() {
 std::vector<IntegratedGPUInfo> IntegratedGPUManager::detect_amd_gpus() {
     std::vector<IntegratedGPUInfo> gpus;
     
-#ifdef ENABLE_OPENCL
-    cl_platform_id platforms[16];
-    cl_uint num_platforms;
-    
-    if (clGetPlatformIDs(16, platforms, &num_platforms) != CL_SUCCESS) {
-        return gpus;
+    for (const auto& device : device_inventory().backend_devices(InventoryBackend::OPENCL)) {
+        if (device.vendor == "AMD") {
+            gpus.push_back(describe_opencl_device(device));
+        }
     }
     
-    for (cl_uint i = 0; i < num_platforms; i++) {
-        char vendor[256];
-        if (clGetPlatformInfo(platforms[i], CL_PLATFORM_VENDOR, sizeof(vendor), vendor, nullptr) != CL_SUCCESS) {
-            continue;
-        }
-        
-        if (std::string(vendor).find("Advanced Micro Devices") == std::string::npos &&
-            std::string(vendor).find("AMD") == std::string::npos) {
-            continue;
-        }
-        
-        cl_device_id devices[16];
-        cl_uint num_devices;
-        
-        if (clGetDeviceIDs(platforms[i], CL_DEVICE_TYPE_GPU, 16, devices, &num_devices) != CL_SUCCESS) {
-            continue;
+    return gpus;
+}
+
+IntegratedGPUInfo IntegratedGPUManager::describe_opencl_device(const InventoryDevice& device) {
+    IntegratedGPUInfo gpu_info = describe_opencl_gpu(device);
+
+    // Set type and TDP by vendor and model
+    if (device.vendor == "Intel") {
+        gpu_info.type = identify_intel_gpu(device.name);
+        switch (gpu_info.type) {
+            case IntegratedGPUType::INTEL_HD:
+                gpu_info.thermal_design_power = 15.0f;
+                break;
+            case IntegratedGPUType::INTEL_IRIS:
+                gpu_info.thermal_design_power = 28.0f;
+                break;
+            case IntegratedGPUType::INTEL_ARC:
+                gpu_info.thermal_design_power = 35.0f;
+                break;
+            default:
+                gpu_info.thermal_design_power = 20.0f;
+                break;
         }
-        
-        for (cl_uint j = 0; j < num_devices; j++) {
-            IntegratedGPUInfo gpu_info;
-            
-            char device_name[256];
-            clGetDeviceInfo(devices[j], CL_DEVICE_NAME, sizeof(device_name), device_name, nullptr);
-            
-            gpu_info.name = device_name;
-            gpu_info.vendor = "AMD";
-            gpu_info.type = identify_amd_gpu(device_name);
-            
-            cl_ulong memory_size;
-            clGetDeviceInfo(devices[j], CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(memory_size), &memory_size, nullptr);
-            gpu_info.total_memory = memory_size;
-            gpu_info.available_memory = memory_size * 0.8;
-            
-            cl_uint compute_units;
-            clGetDeviceInfo(devices[j], CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(compute_units), &compute_units, nullptr);
-            gpu_info.compute_units = compute_units;
-            
-            size_t work_group_size;
-            clGetDeviceInfo(devices[j], CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(work_group_size), &work_group_size, nullptr);
-            gpu_info.max_work_group_size = work_group_size;
-            
-            cl_uint clock_freq;
-            clGetDeviceInfo(devices[j], CL_DEVICE_MAX_CLOCK_FREQUENCY, sizeof(clock_freq), &clock_freq, nullptr);
-            gpu_info.max_clock_frequency = clock_freq;
-            
-            gpu_info.supports_opencl = true;
-            gpu_info.is_power_constrained = detect_laptop_system();
-            gpu_info.shared_memory = get_system_memory() / 2;
-            
-            // Set TDP based on GPU type
-            switch (gpu_info.type) {
-                case IntegratedGPUType::AMD_VEGA:
-                    gpu_info.thermal_design_power = 25.0f;
-                    break;
-                case IntegratedGPUType::AMD_RDNA:
-                    gpu_info.thermal_design_power = 20.0f;
-                    break;
-                default:
-                    gpu_info.thermal_design_power = 22.0f;
-                    break;
-            }
-            
-            gpus.push_back(gpu_info);
+    } else if (device.vendor == "AMD") {
+        gpu_info.type = identify_amd_gpu(device.name);
+        switch (gpu_info.type) {
+            case IntegratedGPUType::AMD_VEGA:
+                gpu_info.thermal_design_power = 25.0f;
+                break;
+            case IntegratedGPUType::AMD_RDNA:
+                gpu_info.thermal_design_power = 20.0f;
+                break;
+            default:
+                gpu_info.thermal_design_power = 22.0f;
+                break;
         }
     }
-#endif
-    
-    return gpus;
+    return gpu_info;
+}
+
+IntegratedGPUInfo IntegratedGPUManager::describe_opencl_gpu(const InventoryDevice& device) {
+    IntegratedGPUInfo gpu_info;
+    gpu_info.type = IntegratedGPUType::UNKNOWN;
+    gpu_info.name = device.name;
+    gpu_info.vendor = device.vendor;
+    gpu_info.version = device.driver_version;
+    gpu_info.total_memory = device.global_memory;
+    gpu_info.available_memory = device.global_memory * 0.8; // Conservative estimate
+    gpu_info.compute_units = device.compute_units;
+    gpu_info.max_work_group_size = device.max_work_group_size;
+    gpu_info.max_clock_frequency = device.max_clock_mhz;
+    gpu_info.supports_opencl = true;
+    gpu_info.supports_vulkan = false;
+    gpu_info.is_power_constrained = detect_laptop_system();
+    gpu_info.shared_memory = get_system_memory() / 2; // Shared with system
+    gpu_info.thermal_design_power = 0.0f;
+    return gpu_info;
 }
 
 std::vector<IntegratedGPUInfo> IntegratedGPUManager::detect_apple_gpus() {
@@ -300,8 +222,7 @@ std::vector<IntegratedGPUInfo> IntegratedGPUManager::detect_nvidia_integrated_gp
     std::vector<IntegratedGPUInfo> gpus;
 
 #ifdef ENABLE_CUDA
-    #include "gpu/cuda_integrated.h"
-
+    // Reads the shared device inventory; no CUDA context is created here
     CUDAIntegratedManager cuda_manager;
     if (!cuda_manager.initialize()) {
         return gpus;
@@ -0,0 +1,75 @@
+#include "gpu/kernel_variants.h"
+#include <cstdio>
+
+namespace {
+
+std::string byte_list(const uint8_t* bytes, size_t count) {
+    std::string list;
+    char hex[8];
+    for (size_t i = 0; i < count; i++) {
+        std::snprintf(hex, sizeof(hex), "%s0x%02x", i ? ", " : "", bytes[i]);
+        list += hex;
+    }
+    return list;
+}
+
+} // namespace
+
+size_t kernel_length_bucket(size_t max_length) {
+    for (size_t bucket : KERNEL_LENGTH_BUCKETS) {
+        if (max_length <= bucket) {
+            return bucket;
+        }
+    }
+    return 0;
+}
+
+int kernel_length_bucket_index(size_t bucket) {
+    for (size_t i = 0; i < KERNEL_LENGTH_BUCKET_COUNT; i++) {
+        if (KERNEL_LENGTH_BUCKETS[i] == bucket) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+std::string nvrtc_mkey_kernel_source(const BitcoinCoreMKeyCheck& check, size_t bucket) {
+    uint64_t salt_block[16];
+    pbkdf2_sha512_salt_block(check.salt, check.salt_length, 1, salt_block);
+
+    std::string words;
+    char word[32];
+    for (int i = 0; i < 16; i++) {
+        std::snprintf(word, sizeof(word), "%s0x%016llxULL", i ? ", " : "", (unsigned long long)salt_block[i]);
+        words += word;
+    }
+
+    const std::string iterations = std::to_string(check.iterations) + "u";
+    std::string source;
+    source += "#include \"wallets/bitcoin_core_mkey.h\"\n\n";
+    source += "__constant__ BitcoinCoreMKeyCheck c_specialised_key = {\n";
+    source += "    {" + byte_list(check.salt, sizeof(check.salt)) + "},\n";
+    source += "    " + std::to_string(check.salt_length) + "u, " + iterations + ",\n";
+    source += "    {" + byte_list(check.previous_block, sizeof(check.previous_block)) + "},\n";
+    source += "    {" + byte_list(check.last_block, sizeof(check.last_block)) + "},\n";
+    source += "    " + std::to_string(check.expected_padding) + ", {0, 0, 0}\n";
+    source += "};\n\n";
+    source += "extern \"C\" __global__ void " NVRTC_MKEY_KERNEL_NAME "(\n";
+    source += "    const unsigned char* password_candidates, int candidate_stride, int num_passwords, int* found_index) {\n";
+    source += "    const uint64_t salt_block[16] = {" + words + "};\n";
+    source += "    int tid = blockIdx.x * blockDim.x + threadIdx.x;\n";
+    source += "    int stride = blockDim.x * gridDim.x;\n";
+    source += "    for (int i = tid; i < num_passwords; i += stride) {\n";
+    source += "        if (*(volatile int*)found_index >= 0) {\n";
+    source += "            return;\n";
+    source += "        }\n";
+    source += "        const unsigned char* slot = password_candidates + (size_t)i * candidate_stride;\n";
+    source += "        if (mkey_check_password_short<" + std::to_string(bucket) + ", " + iterations +
+              ">(c_specialised_key, salt_block, slot + 1, slot[0])) {\n";
+    source += "            atomicCAS(found_index, -1, i);\n";
+    source += "            return;\n";
+    source += "        }\n";
+    source += "    }\n";
+    source += "}\n";
+    return source;
+}
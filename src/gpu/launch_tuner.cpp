@@ -0,0 +1,233 @@
+#include "gpu/launch_tuner.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <tuple>
+
+namespace {
+
+const char* TUNING_HEADER = "btc_recovery_tuning 1";
+
+// A different configuration must be this much faster to replace the current
+// one, so measurement noise does not pick a new winner on every run
+const double IMPROVEMENT_MARGIN = 1.02;
+
+const int MAX_PASSES = 3;
+
+void sorted_unique(std::vector<int>& values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+}
+
+} // namespace
+
+int LaunchConfig::blocks_per_grid() const {
+    if (!valid()) {
+        return 0;
+    }
+    const int64_t per_block = static_cast<int64_t>(threads_per_block) * candidates_per_thread;
+    return static_cast<int>((batch_size + per_block - 1) / per_block);
+}
+
+LaunchSearchSpace LaunchSearchSpace::around(int max_threads_per_block, int max_batch_size, const LaunchConfig& base) {
+    LaunchSearchSpace space;
+    for (int threads = 32; threads <= std::max(max_threads_per_block, 32); threads *= 2) {
+        space.threads_per_block.push_back(threads);
+    }
+    if (base.threads_per_block > 0 && base.threads_per_block <= max_threads_per_block) {
+        space.threads_per_block.push_back(base.threads_per_block);
+    }
+
+    space.candidates_per_thread = {1, 2, 4, 8};
+
+    const int batch = std::max(base.batch_size, 1);
+    for (int64_t size : {static_cast<int64_t>(batch) / 2, static_cast<int64_t>(batch),
+                         static_cast<int64_t>(batch) * 2, static_cast<int64_t>(batch) * 4}) {
+        size = std::min<int64_t>(size, std::max(max_batch_size, 1));
+        if (size > 0) {
+            space.batch_size.push_back(static_cast<int>(size));
+        }
+    }
+
+    sorted_unique(space.threads_per_block);
+    sorted_unique(space.batch_size);
+    return space;
+}
+
+LaunchConfig autotune_launch(const LaunchSearchSpace& space, const LaunchConfig& start,
+                             const std::function<double(const LaunchConfig&)>& measure, double& best_rate) {
+    std::map<std::tuple<int, int, int>, double> measured;
+    auto rate_of = [&](const LaunchConfig& config) {
+        const auto key = std::make_tuple(config.threads_per_block, config.candidates_per_thread, config.batch_size);
+        auto it = measured.find(key);
+        if (it == measured.end()) {
+            it = measured.emplace(key, config.valid() ? measure(config) : 0.0).first;
+        }
+        return it->second;
+    };
+
+    LaunchConfig best = start;
+    best_rate = rate_of(start);
+
+    // One sweep per parameter, the others held at the current best
+    const std::vector<std::pair<const std::vector<int>*, int LaunchConfig::*>> dimensions = {
+        {&space.threads_per_block, &LaunchConfig::threads_per_block},
+        {&space.candidates_per_thread, &LaunchConfig::candidates_per_thread},
+        {&space.batch_size, &LaunchConfig::batch_size},
+    };
+
+    for (int pass = 0; pass < MAX_PASSES; pass++) {
+        bool changed = false;
+        for (const auto& dimension : dimensions) {
+            for (int value : *dimension.first) {
+                LaunchConfig candidate = best;
+                candidate.*dimension.second = value;
+                const double rate = rate_of(candidate);
+                if (rate > best_rate * IMPROVEMENT_MARGIN || (best_rate <= 0.0 && rate > 0.0)) {
+                    best = candidate;
+                    best_rate = rate;
+                    changed = true;
+                }
+            }
+        }
+        if (!changed) {
+            break;
+        }
+    }
+    return best;
+}
+
+bool TuningKey::operator<(const TuningKey& other) const {
+    return std::tie(device_name, compute_capability, driver_version, kdf_iterations) <
+           std::tie(other.device_name, other.compute_capability, other.driver_version, other.kdf_iterations);
+}
+
+TuningCache::TuningCache(const std::string& file_path)
+    : file_path_(file_path.empty() ? default_path() : file_path) {}
+
+std::string TuningCache::default_path() {
+#ifdef _WIN32
+    const char* base = std::getenv("LOCALAPPDATA");
+    const std::string directory = base ? std::string(base) : std::string(".");
+#else
+    const char* cache = std::getenv("XDG_CACHE_HOME");
+    const char* home = std::getenv("HOME");
+    const std::string directory = (cache && *cache) ? std::string(cache)
+                                : home ? std::string(home) + "/.cache" : std::string(".");
+#endif
+    return directory + "/btc-recovery/launch_tuning.tsv";
+}
+
+bool TuningCache::load() {
+    std::ifstream file(file_path_);
+    if (!file.is_open()) {
+        return true;  // Nothing tuned yet
+    }
+
+    std::string line;
+    if (!std::getline(file, line) || line != TUNING_HEADER) {
+        last_error_ = "Not a tuning cache: " + file_path_;
+        return false;
+    }
+
+    // device \t compute capability \t driver \t iterations \t threads \t per thread \t batch \t rate
+    std::map<TuningKey, Entry> entries;
+    while (std::getline(file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        std::vector<std::string> fields;
+        std::stringstream in(line);
+        std::string field;
+        while (std::getline(in, field, '\t')) {
+            fields.push_back(field);
+        }
+        if (fields.size() != 8) {
+            last_error_ = "Malformed tuning cache line in " + file_path_;
+            return false;
+        }
+
+        TuningKey key;
+        Entry entry;
+        key.device_name = fields[0];
+        key.compute_capability = fields[1];
+        char* end = nullptr;
+        key.driver_version = static_cast<int>(std::strtol(fields[2].c_str(), &end, 10));
+        key.kdf_iterations = static_cast<uint32_t>(std::strtoul(fields[3].c_str(), &end, 10));
+        entry.config.threads_per_block = std::atoi(fields[4].c_str());
+        entry.config.candidates_per_thread = std::atoi(fields[5].c_str());
+        entry.config.batch_size = std::atoi(fields[6].c_str());
+        entry.rate = std::strtod(fields[7].c_str(), &end);
+        if (!entry.config.valid()) {
+            last_error_ = "Invalid launch configuration in " + file_path_;
+            return false;
+        }
+        entries[key] = entry;
+    }
+
+    entries_.swap(entries);
+    return true;
+}
+
+bool TuningCache::lookup(const TuningKey& key, LaunchConfig& config, double* rate) const {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        return false;
+    }
+    config = it->second.config;
+    if (rate) {
+        *rate = it->second.rate;
+    }
+    return true;
+}
+
+bool TuningCache::store(const TuningKey& key, const LaunchConfig& config, double rate) {
+    entries_[key] = {config, rate};
+    return save();
+}
+
+bool TuningCache::save() {
+    std::ostringstream out;
+    out << TUNING_HEADER << "\n";
+    for (const auto& entry : entries_) {
+        // Tabs and newlines would break the line format; device names never need them
+        std::string name = entry.first.device_name;
+        std::replace_if(name.begin(), name.end(), [](char c) { return c == '\t' || c == '\n'; }, ' ');
+        out << name << "\t" << entry.first.compute_capability << "\t" << entry.first.driver_version << "\t"
+            << entry.first.kdf_iterations << "\t" << entry.second.config.threads_per_block << "\t"
+            << entry.second.config.candidates_per_thread << "\t" << entry.second.config.batch_size << "\t"
+            << entry.second.rate << "\n";
+    }
+    const std::string contents = out.str();
+
+    std::error_code error;
+    const std::filesystem::path path(file_path_);
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+
+    // A cache is disposable, so a plain write and rename is enough
+    const std::string temp_path = file_path_ + ".tmp";
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        last_error_ = "Cannot create tuning cache: " + temp_path;
+        return false;
+    }
+    const bool written = std::fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+    if ((std::fclose(file) != 0) || !written) {
+        std::remove(temp_path.c_str());
+        last_error_ = "Cannot write tuning cache: " + temp_path;
+        return false;
+    }
+
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::remove(temp_path.c_str());
+        last_error_ = "Cannot replace tuning cache: " + file_path_;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,447 @@
+#pragma once
+
+// Internal header: OpenCL C source of the Bitcoin Core master-key kernels.
+// It mirrors the shared reference code in utils/pbkdf2_sha512.h,
+// utils/aes256_block.h and wallets/bitcoin_core_mkey.h, which are C++ and
+// cannot be compiled by OpenCL C compilers. The SHA-512 round constants and
+// AES S-boxes are not repeated here: the host uploads its reference tables
+// as an OpenCLCryptoTables buffer, so the two copies cannot drift apart.
+
+#include "utils/aes256_block.h"
+#include "utils/pbkdf2_sha512.h"
+#include "wallets/bitcoin_core_mkey.h"
+#include <cstdint>
+
+/**
+ * Lookup tables read by the kernels from constant memory
+ */
+struct OpenCLCryptoTables {
+    uint64_t sha512_k[80];
+    uint8_t sbox[256];
+    uint8_t inv_sbox[256];
+};
+
+inline OpenCLCryptoTables make_opencl_crypto_tables() {
+    OpenCLCryptoTables tables;
+    for (int i = 0; i < 80; i++) {
+        tables.sha512_k[i] = SHA512_ROUND_CONSTANTS_HOST[i];
+    }
+    for (int i = 0; i < 256; i++) {
+        tables.sbox[i] = AES_SBOX_HOST[i];
+        tables.inv_sbox[i] = AES_INV_SBOX_HOST[i];
+    }
+    return tables;
+}
+
+// Layouts the kernel declares by hand
+static_assert(sizeof(BitcoinCoreMKeyCheck) == 108, "mkey_check_t layout changed");
+static_assert(BITCOIN_CORE_MKEY_MAX_SALT == 64, "mkey_check_t salt size changed");
+static_assert(sizeof(OpenCLCryptoTables) == 1152, "crypto_tables_t layout changed");
+
+static const char* OPENCL_MKEY_KERNEL_SOURCE = R"CLC(
+typedef struct {
+    uchar salt[64];
+    uint salt_length;
+    uint iterations;
+    uchar previous_block[16];
+    uchar last_block[16];
+    uchar expected_padding;
+    uchar reserved[3];
+} mkey_check_t;
+
+typedef struct {
+    ulong sha512_k[80];
+    uchar sbox[256];
+    uchar inv_sbox[256];
+} crypto_tables_t;
+
+typedef __constant const crypto_tables_t* tables_t;
+
+#define MAX_PASSWORD 255
+#define PAD_WORD 0x8000000000000000UL
+#define HMAC_DIGEST_BITS ((128 + 64) * 8)
+
+ulong rotr64(ulong x, uint n) {
+    return rotate(x, (ulong)(64 - n));
+}
+
+ulong load_be64(const uchar* p) {
+    ulong v = 0;
+    for (int i = 0; i < 8; i++) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+void store_be64(uchar* p, ulong v) {
+    for (int i = 7; i >= 0; i--) {
+        p[i] = (uchar)v;
+        v >>= 8;
+    }
+}
+
+void sha512_init(ulong state[8]) {
+    state[0] = 0x6a09e667f3bcc908UL;
+    state[1] = 0xbb67ae8584caa73bUL;
+    state[2] = 0x3c6ef372fe94f82bUL;
+    state[3] = 0xa54ff53a5f1d36f1UL;
+    state[4] = 0x510e527fade682d1UL;
+    state[5] = 0x9b05688c2b3e6c1fUL;
+    state[6] = 0x1f83d9abfb41bd6bUL;
+    state[7] = 0x5be0cd19137e2179UL;
+}
+
+void sha512_compress(tables_t tables, ulong state[8], ulong w[16]) {
+    ulong a = state[0], b = state[1], c = state[2], d = state[3];
+    ulong e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int t = 0; t < 80; t++) {
+        ulong wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            ulong w15 = w[(t - 15) & 15];
+            ulong w2 = w[(t - 2) & 15];
+            ulong s0 = rotr64(w15, 1) ^ rotr64(w15, 8) ^ (w15 >> 7);
+            ulong s1 = rotr64(w2, 19) ^ rotr64(w2, 61) ^ (w2 >> 6);
+            wt = w[t & 15] + s0 + w[(t - 7) & 15] + s1;
+            w[t & 15] = wt;
+        }
+
+        ulong big_s1 = rotr64(e, 14) ^ rotr64(e, 18) ^ rotr64(e, 41);
+        ulong ch = ((f ^ g) & e) ^ g;
+        ulong t1 = h + big_s1 + ch + tables->sha512_k[t] + wt;
+        ulong big_s0 = rotr64(a, 28) ^ rotr64(a, 34) ^ rotr64(a, 39);
+        ulong maj = (a & b) | (c & (a | b));
+        ulong t2 = big_s0 + maj;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void sha512_compress_bytes(tables_t tables, ulong state[8], const uchar* block) {
+    ulong w[16];
+    for (int i = 0; i < 16; i++) {
+        w[i] = load_be64(block + i * 8);
+    }
+    sha512_compress(tables, state, w);
+}
+
+// Plain SHA-512, only needed for HMAC keys longer than one block
+void sha512_bytes(tables_t tables, const uchar* data, uint length, ulong digest[8]) {
+    uchar block[128];
+    uint offset = 0;
+    sha512_init(digest);
+    for (; length - offset >= 128; offset += 128) {
+        sha512_compress_bytes(tables, digest, data + offset);
+    }
+
+    const uint rest = length - offset;
+    for (uint i = 0; i < 128; i++) {
+        block[i] = i < rest ? data[offset + i] : 0;
+    }
+    block[rest] = 0x80;
+    if (rest >= 112) {
+        sha512_compress_bytes(tables, digest, block);
+        for (int i = 0; i < 128; i++) {
+            block[i] = 0;
+        }
+    }
+    store_be64(block + 120, (ulong)length * 8);
+    sha512_compress_bytes(tables, digest, block);
+}
+
+void hmac_precompute(tables_t tables, const uchar* key, uint key_length, ulong inner[8], ulong outer[8]) {
+    uchar block[128];
+    for (int i = 0; i < 128; i++) {
+        block[i] = 0;
+    }
+    if (key_length > 128) {
+        ulong digest[8];
+        sha512_bytes(tables, key, key_length, digest);
+        for (int i = 0; i < 8; i++) {
+            store_be64(block + i * 8, digest[i]);
+        }
+    } else {
+        for (uint i = 0; i < key_length; i++) {
+            block[i] = key[i];
+        }
+    }
+
+    ulong w[16];
+    for (int i = 0; i < 16; i++) {
+        w[i] = load_be64(block + i * 8) ^ 0x3636363636363636UL;
+    }
+    sha512_init(inner);
+    sha512_compress(tables, inner, w);
+
+    for (int i = 0; i < 16; i++) {
+        w[i] = load_be64(block + i * 8) ^ 0x5c5c5c5c5c5c5c5cUL;
+    }
+    sha512_init(outer);
+    sha512_compress(tables, outer, w);
+}
+
+void hmac_outer(tables_t tables, const ulong outer[8], const ulong inner_digest[8], ulong mac[8]) {
+    ulong w[16];
+    for (int i = 0; i < 8; i++) {
+        w[i] = inner_digest[i];
+        mac[i] = outer[i];
+    }
+    w[8] = PAD_WORD;
+    for (int i = 9; i < 15; i++) {
+        w[i] = 0;
+    }
+    w[15] = HMAC_DIGEST_BITS;
+    sha512_compress(tables, mac, w);
+}
+
+// PBKDF2 block 1, U1 = HMAC(P, salt || INT(1)); salts of up to 64 bytes fit
+// one SHA-512 block after the ipad block
+void pbkdf2_first_block(tables_t tables, const ulong inner[8], const ulong outer[8],
+                        const uchar* salt, uint salt_length, ulong u[8]) {
+    uchar block[128];
+    for (int i = 0; i < 128; i++) {
+        block[i] = 0;
+    }
+    for (uint i = 0; i < salt_length; i++) {
+        block[i] = salt[i];
+    }
+    block[salt_length + 3] = 1;
+    block[salt_length + 4] = 0x80;
+    store_be64(block + 120, (ulong)(128 + salt_length + 4) * 8);
+
+    ulong inner_digest[8];
+    for (int i = 0; i < 8; i++) {
+        inner_digest[i] = inner[i];
+    }
+    sha512_compress_bytes(tables, inner_digest, block);
+    hmac_outer(tables, outer, inner_digest, u);
+}
+
+// First 64 bytes of PBKDF2-HMAC-SHA512 output, as words
+void pbkdf2_sha512_block(tables_t tables, const uchar* password, uint password_length,
+                         const uchar* salt, uint salt_length, uint iterations, ulong t[8]) {
+    ulong inner[8], outer[8], u[8];
+    hmac_precompute(tables, password, password_length, inner, outer);
+    pbkdf2_first_block(tables, inner, outer, salt, salt_length, u);
+    for (int i = 0; i < 8; i++) {
+        t[i] = u[i];
+    }
+
+    for (uint r = 1; r < iterations; r++) {
+        ulong w[16];
+        ulong inner_digest[8];
+        for (int i = 0; i < 8; i++) {
+            w[i] = u[i];
+            inner_digest[i] = inner[i];
+        }
+        w[8] = PAD_WORD;
+        for (int i = 9; i < 15; i++) {
+            w[i] = 0;
+        }
+        w[15] = HMAC_DIGEST_BITS;
+        sha512_compress(tables, inner_digest, w);
+
+        hmac_outer(tables, outer, inner_digest, u);
+        for (int i = 0; i < 8; i++) {
+            t[i] ^= u[i];
+        }
+    }
+}
+
+uchar aes_xtime(uchar x) {
+    return (uchar)((x << 1) ^ ((x & 0x80) ? 0x1b : 0x00));
+}
+
+void aes256_expand_key(tables_t tables, const uchar* key, uchar* round_keys) {
+    for (int i = 0; i < 32; i++) {
+        round_keys[i] = key[i];
+    }
+
+    uchar rcon = 0x01;
+    for (int i = 8; i < 60; i++) {
+        uchar temp[4];
+        for (int j = 0; j < 4; j++) {
+            temp[j] = round_keys[(i - 1) * 4 + j];
+        }
+
+        if (i % 8 == 0) {
+            uchar first = temp[0];
+            temp[0] = (uchar)(tables->sbox[temp[1]] ^ rcon);
+            temp[1] = tables->sbox[temp[2]];
+            temp[2] = tables->sbox[temp[3]];
+            temp[3] = tables->sbox[first];
+            rcon = aes_xtime(rcon);
+        } else if (i % 8 == 4) {
+            for (int j = 0; j < 4; j++) {
+                temp[j] = tables->sbox[temp[j]];
+            }
+        }
+
+        for (int j = 0; j < 4; j++) {
+            round_keys[i * 4 + j] = round_keys[(i - 8) * 4 + j] ^ temp[j];
+        }
+    }
+}
+
+void aes256_decrypt_block(tables_t tables, const uchar* round_keys, const uchar* in, uchar* out) {
+    uchar s[16];
+    for (int i = 0; i < 16; i++) {
+        s[i] = in[i] ^ round_keys[14 * 16 + i];
+    }
+
+    for (int round = 13; round >= 0; round--) {
+        uchar t[16];
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) {
+                t[r + 4 * c] = tables->inv_sbox[s[r + 4 * ((c - r + 4) & 3)]];
+            }
+        }
+
+        for (int i = 0; i < 16; i++) {
+            s[i] = t[i] ^ round_keys[round * 16 + i];
+        }
+
+        if (round == 0) {
+            break;
+        }
+
+        for (int c = 0; c < 4; c++) {
+            uchar* col = s + 4 * c;
+            uchar a0 = col[0], a1 = col[1], a2 = col[2], a3 = col[3];
+            uchar x0 = aes_xtime(a0), x1 = aes_xtime(a1), x2 = aes_xtime(a2), x3 = aes_xtime(a3);
+            uchar y0 = aes_xtime(x0), y1 = aes_xtime(x1), y2 = aes_xtime(x2), y3 = aes_xtime(x3);
+            uchar z0 = aes_xtime(y0), z1 = aes_xtime(y1), z2 = aes_xtime(y2), z3 = aes_xtime(y3);
+            col[0] = (z0 ^ y0 ^ x0) ^ (z1 ^ x1 ^ a1) ^ (z2 ^ y2 ^ a2) ^ (z3 ^ a3);
+            col[1] = (z0 ^ a0) ^ (z1 ^ y1 ^ x1) ^ (z2 ^ x2 ^ a2) ^ (z3 ^ y3 ^ a3);
+            col[2] = (z0 ^ y0 ^ a0) ^ (z1 ^ a1) ^ (z2 ^ y2 ^ x2) ^ (z3 ^ x3 ^ a3);
+            col[3] = (z0 ^ x0 ^ a0) ^ (z1 ^ y1 ^ a1) ^ (z2 ^ a2) ^ (z3 ^ y3 ^ x3);
+        }
+    }
+
+    for (int i = 0; i < 16; i++) {
+        out[i] = s[i];
+    }
+}
+
+bool mkey_check_password(tables_t tables, __constant const mkey_check_t* mkey,
+                         const uchar* password, uint password_length) {
+    uchar salt[64];
+    const uint salt_length = min(mkey->salt_length, 64u);
+    for (uint i = 0; i < salt_length; i++) {
+        salt[i] = mkey->salt[i];
+    }
+
+    ulong t[8];
+    pbkdf2_sha512_block(tables, password, password_length, salt, salt_length, mkey->iterations, t);
+    uchar key[32];
+    for (int i = 0; i < 4; i++) {
+        store_be64(key + i * 8, t[i]);
+    }
+
+    uchar round_keys[240];
+    uchar last_block[16];
+    uchar plaintext[16];
+    aes256_expand_key(tables, key, round_keys);
+    for (int i = 0; i < 16; i++) {
+        last_block[i] = mkey->last_block[i];
+    }
+    aes256_decrypt_block(tables, round_keys, last_block, plaintext);
+    for (int i = 0; i < 16; i++) {
+        plaintext[i] ^= mkey->previous_block[i];
+    }
+
+    const uchar padding = plaintext[15];
+    if (padding == 0 || padding > 16) {
+        return false;
+    }
+    if (mkey->expected_padding != 0 && padding != mkey->expected_padding) {
+        return false;
+    }
+    uchar mismatch = 0;
+    for (int i = 0; i < 16; i++) {
+        mismatch |= (uchar)((plaintext[i] ^ padding) * (uchar)(i >= 16 - padding));
+    }
+    return mismatch == 0;
+}
+
+// One candidate per work-item in CandidateBatch slot layout, grid-stride
+// over the batch; found_index keeps the first match
+__kernel void verify_master_key(__constant const mkey_check_t* mkey,
+                                __constant const crypto_tables_t* tables,
+                                __global const uchar* candidates,
+                                uint candidate_stride,
+                                uint num_passwords,
+                                __global volatile int* found_index) {
+    const uint stride = (uint)get_global_size(0);
+    for (uint i = (uint)get_global_id(0); i < num_passwords; i += stride) {
+        if (*found_index >= 0) {
+            return;
+        }
+
+        __global const uchar* slot = candidates + (size_t)i * candidate_stride;
+        uchar password[MAX_PASSWORD];
+        const uint length = min((uint)slot[0], min(candidate_stride - 1, (uint)MAX_PASSWORD));
+        for (uint j = 0; j < length; j++) {
+            password[j] = slot[1 + j];
+        }
+
+        if (mkey_check_password(tables, mkey, password, length)) {
+            atomic_cmpxchg(found_index, -1, (int)i);
+            return;
+        }
+    }
+}
+
+// Known-answer check of the device build, single work-item
+__kernel void pbkdf2_sha512_self_test(__constant const crypto_tables_t* tables,
+                                      __global const uchar* password,
+                                      uint password_length,
+                                      __global const uchar* salt,
+                                      uint salt_length,
+                                      uint iterations,
+                                      __global uchar* derived_key,
+                                      uint key_length) {
+    if (get_global_id(0) != 0) {
+        return;
+    }
+
+    uchar private_password[MAX_PASSWORD];
+    uchar private_salt[64];
+    password_length = min(password_length, (uint)MAX_PASSWORD);
+    salt_length = min(salt_length, 64u);
+    for (uint i = 0; i < password_length; i++) {
+        private_password[i] = password[i];
+    }
+    for (uint i = 0; i < salt_length; i++) {
+        private_salt[i] = salt[i];
+    }
+
+    ulong t[8];
+    uchar digest[64];
+    pbkdf2_sha512_block(tables, private_password, password_length, private_salt, salt_length, iterations, t);
+    for (int i = 0; i < 8; i++) {
+        store_be64(digest + i * 8, t[i]);
+    }
+    for (uint i = 0; i < min(key_length, 64u); i++) {
+        derived_key[i] = digest[i];
+    }
+}
+)CLC";
@@ -0,0 +1,130 @@
+#include "gpu/opencl_program_cache.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+const char* BINARY_HEADER = "btc_recovery_clbin 1";
+
+uint64_t fnv1a(const std::string& text) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::string hex64(uint64_t value) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+    return text;
+}
+
+// Keep every field on the identity line
+std::string one_line(std::string text) {
+    for (char& c : text) {
+        if (c == '\n' || c == '\r' || c == '\t') {
+            c = ' ';
+        }
+    }
+    return text;
+}
+
+} // namespace
+
+std::string ProgramCacheKey::identity() const {
+    return one_line(device_name) + "\t" + one_line(device_version) + "\t" + one_line(driver_version) + "\t" +
+           one_line(platform_version) + "\t" + one_line(build_options) + "\t" + hex64(fnv1a(source)) + "\t" +
+           std::to_string(source.size());
+}
+
+ProgramBinaryCache::ProgramBinaryCache(const std::string& directory)
+    : directory_(directory.empty() ? default_directory() : directory) {}
+
+std::string ProgramBinaryCache::default_directory() {
+#ifdef _WIN32
+    const char* base = std::getenv("LOCALAPPDATA");
+    const std::string directory = base ? std::string(base) : std::string(".");
+#else
+    const char* cache = std::getenv("XDG_CACHE_HOME");
+    const char* home = std::getenv("HOME");
+    const std::string directory = (cache && *cache) ? std::string(cache)
+                                : home ? std::string(home) + "/.cache" : std::string(".");
+#endif
+    return directory + "/btc-recovery/opencl";
+}
+
+std::string ProgramBinaryCache::path_for(const ProgramCacheKey& key) const {
+    return directory_ + "/" + hex64(fnv1a(key.identity())) + ".clbin";
+}
+
+bool ProgramBinaryCache::load(const ProgramCacheKey& key, std::vector<unsigned char>& binary) const {
+    std::ifstream file(path_for(key), std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // header \n identity \n size \n binary
+    std::string header, identity, size_line;
+    if (!std::getline(file, header) || header != BINARY_HEADER ||
+        !std::getline(file, identity) || identity != key.identity() ||
+        !std::getline(file, size_line)) {
+        return false;
+    }
+    char* end = nullptr;
+    const unsigned long long size = std::strtoull(size_line.c_str(), &end, 10);
+    if (size_line.empty() || *end != '\0' || size == 0) {
+        return false;
+    }
+
+    std::vector<unsigned char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (contents.size() != size) {
+        return false;  // Truncated or trailing garbage
+    }
+    binary.swap(contents);
+    return true;
+}
+
+bool ProgramBinaryCache::store(const ProgramCacheKey& key, const std::vector<unsigned char>& binary) {
+    if (binary.empty()) {
+        last_error_ = "Empty program binary";
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+
+    const std::string path = path_for(key);
+    const std::string temp_path = path + ".tmp";
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        last_error_ = "Cannot create program cache entry: " + temp_path;
+        return false;
+    }
+    const std::string preamble = std::string(BINARY_HEADER) + "\n" + key.identity() + "\n" +
+                                 std::to_string(binary.size()) + "\n";
+    bool written = std::fwrite(preamble.data(), 1, preamble.size(), file) == preamble.size();
+    written = written && std::fwrite(binary.data(), 1, binary.size(), file) == binary.size();
+    if ((std::fclose(file) != 0) || !written) {
+        std::remove(temp_path.c_str());
+        last_error_ = "Cannot write program cache entry: " + temp_path;
+        return false;
+    }
+
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        std::remove(temp_path.c_str());
+        last_error_ = "Cannot replace program cache entry: " + path;
+        return false;
+    }
+    return true;
+}
+
+void ProgramBinaryCache::remove(const ProgramCacheKey& key) {
+    std::remove(path_for(key).c_str());
+}
@@ -0,0 +1,828 @@
+#ifdef ENABLE_OPENCL
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "core/candidate_batch.h"
+#include "core/mask_generator.h"
+#include "gpu/device_inventory.h"
+#include "gpu/integrated_gpu.h"
+#include "gpu/opencl_program_cache.h"
+#include "gpu/opencl_utils.h"
+#include "gpu/pipeline_metrics.h"
+#include "opencl_mkey_kernel.h"
+#include "utils/logger.h"
+#include "utils/pbkdf2_sha512_test_vectors.h"
+#include "wallets/bitcoin_core_mkey.h"
+
+namespace {
+
+// Intel and AMD drivers only skip the copy for page-aligned host pointers
+// whose size is a multiple of the cache line
+const size_t ZERO_COPY_ALIGNMENT = 4096;
+
+const cl_int NOT_FOUND = -1;
+
+// Duration of a command on a profiling queue, -1 if the driver cannot tell
+double command_seconds(cl_event event) {
+    cl_ulong start = 0;
+    cl_ulong end = 0;
+    if (!event ||
+        clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(start), &start, nullptr) != CL_SUCCESS ||
+        clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END, sizeof(end), &end, nullptr) != CL_SUCCESS ||
+        end < start) {
+        return -1.0;
+    }
+    return (end - start) / 1e9;
+}
+
+void observe_command(LatencyHistogram* histogram, cl_event event) {
+    const double seconds = command_seconds(event);
+    if (seconds >= 0.0) {
+        histogram->observe(seconds);
+    }
+}
+
+unsigned char* allocate_aligned(size_t bytes) {
+    const size_t size = (bytes + ZERO_COPY_ALIGNMENT - 1) / ZERO_COPY_ALIGNMENT * ZERO_COPY_ALIGNMENT;
+#ifdef _WIN32
+    return static_cast<unsigned char*>(_aligned_malloc(size, ZERO_COPY_ALIGNMENT));
+#else
+    return static_cast<unsigned char*>(std::aligned_alloc(ZERO_COPY_ALIGNMENT, size));
+#endif
+}
+
+void free_aligned(unsigned char* pointer) {
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+} // namespace
+
+/**
+ * OpenCL Recovery Engine for Intel and AMD integrated graphics
+ *
+ * Runs the same PBKDF2-HMAC-SHA512 + AES-256 master-key check as the CUDA
+ * backend. Work is pipelined over a few slots on one in-order queue: while
+ * the device runs one slot's batch, the host fills the next.
+ *
+ * On devices that share physical memory with the host, each slot's buffer
+ * is created with CL_MEM_USE_HOST_PTR over page-aligned host memory and is
+ * mapped while the generator fills it, so batches are never copied. Other
+ * devices get a plain device buffer and a non-blocking write.
+ *
+ * The program is built once per device, driver and build options; the
+ * binary is kept in a ProgramBinaryCache so later runs skip the compiler.
+ *
+ * The queue has profiling enabled, so the upload, kernel and readback
+ * events of each batch give its phase timings for the metrics endpoint.
+ */
+class OpenCLRecovery {
+public:
+    OpenCLRecovery()
+        : device_index_(-1), initialized_(false), gpu_info_(), context_(nullptr), queue_(nullptr),
+          program_(nullptr), verify_kernel_(nullptr), self_test_kernel_(nullptr), tables_(nullptr),
+          master_key_buffer_(nullptr), work_group_size_(64), zero_copy_(false), slot_capacity_(0),
+          next_slot_(0), in_flight_count_(0), found_(false), master_key_loaded_(false) {}
+
+    ~OpenCLRecovery() {
+        cleanup();
+    }
+
+    OpenCLRecovery(const OpenCLRecovery&) = delete;
+    OpenCLRecovery& operator=(const OpenCLRecovery&) = delete;
+
+    /**
+     * Build the program, allocate the pipeline and upload the master key
+     * @param device_index Index into opencl_integrated_devices() (-1 = first)
+     * @param master_key Verification record tested by the kernel (may be set later)
+     * @param cache_directory Program binary cache; empty uses the default
+     * @return true if successful
+     */
+    bool initialize(int device_index = -1, const BitcoinCoreMKeyCheck* master_key = nullptr,
+                    const std::string& cache_directory = "") {
+        cleanup();
+
+        const auto devices = opencl_integrated_devices();
+        device_index_ = device_index < 0 ? 0 : device_index;
+        if (device_index_ >= (int)devices.size()) {
+            Logger::error("OpenCL device " + std::to_string(device_index_) + " not found");
+            return false;
+        }
+        device_ = devices[device_index_];
+        metrics_ = PipelineMetrics::create(ComputeDeviceKind::OPENCL, device_index_);
+
+        // The inventory indexes OpenCL devices by their position in
+        // opencl_integrated_devices(), so this entry describes device_
+        IntegratedGPUManager manager;
+        const InventoryDevice* inventory_device = device_inventory().find(InventoryBackend::OPENCL, device_index_);
+        if (inventory_device) {
+            gpu_info_ = manager.describe_opencl_device(*inventory_device);
+        } else {
+            gpu_info_.type = IntegratedGPUType::UNKNOWN;
+            gpu_info_.name = device_.name;
+        }
+        profile_ = manager.get_performance_profile(gpu_info_.type);
+
+        if (!create_context() || !build_program(cache_directory) || !initialize_memory_pools()) {
+            cleanup();
+            return false;
+        }
+
+        if (!run_self_test()) {
+            Logger::error("PBKDF2-HMAC-SHA512 self-test failed on device: " + device_.name);
+            cleanup();
+            return false;
+        }
+
+        initialized_ = true;
+        if (master_key && !upload_master_key(*master_key)) {
+            cleanup();
+            return false;
+        }
+
+        Logger::info("OpenCL recovery initialized for device: " + device_.name);
+        Logger::info("  Work group size: " + std::to_string(work_group_size_));
+        Logger::info("  Zero-copy buffers: " + std::string(zero_copy_ ? "yes" : "no"));
+        Logger::info("  Pipeline slots: " + std::to_string(slots_.size()) + " x " +
+                     std::to_string(slot_capacity_) + " candidates");
+        return true;
+    }
+
+    /**
+     * Upload the master-key record tested by the kernel
+     * @param master_key Verification record from BitcoinCoreWallet::get_master_key_check
+     * @return true if successful
+     */
+    bool upload_master_key(const BitcoinCoreMKeyCheck& master_key) {
+        // Queued batches still read the current record
+        drain();
+
+        cl_int error = clEnqueueWriteBuffer(queue_, master_key_buffer_, CL_TRUE, 0, sizeof(master_key),
+                                            &master_key, 0, nullptr, nullptr);
+        if (error != CL_SUCCESS) {
+            Logger::error("Failed to upload master key: " + std::string(opencl_error_string(error)));
+            master_key_loaded_ = false;
+            return false;
+        }
+
+        master_key_ = master_key;
+        master_key_loaded_ = true;
+        return true;
+    }
+
+    /**
+     * Take the next pipeline slot's staging batch for the generator to fill
+     * Waits for the slot's previous batch to finish and records its result.
+     * @return empty batch in host-visible memory
+     */
+    CandidateBatch& acquire_batch() {
+        PipelineSlot& slot = slots_[next_slot_];
+        retire_slot(slot);
+        if (zero_copy_ && !slot.mapped) {
+            map_slot(slot);
+        }
+        slot.batch->clear();
+        acquired_at_ = std::chrono::steady_clock::now();
+        return *slot.batch;
+    }
+
+    /**
+     * Queue the batch returned by the last acquire_batch() call
+     * The upload (or unmap), kernel and readback are enqueued and the call
+     * returns immediately.
+     * @return false if the launch failed
+     */
+    bool submit_batch() {
+        PipelineSlot& slot = slots_[next_slot_];
+        next_slot_ = (next_slot_ + 1) % slots_.size();
+
+        const cl_uint num_passwords = static_cast<cl_uint>(slot.batch->size());
+        if (num_passwords == 0 || !master_key_loaded_) {
+            return true;
+        }
+        // Time the caller spent filling the batch since acquire_batch()
+        metrics_.generate->observe(
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - acquired_at_).count());
+
+        cl_int error = CL_SUCCESS;
+        if (zero_copy_) {
+            if (!slot.mapped) {
+                Logger::error("OpenCL staging buffer is not mapped");
+                return false;
+            }
+            error = clEnqueueUnmapMemObject(queue_, slot.candidates, slot.mapped, 0, nullptr, &slot.uploaded);
+            slot.mapped = nullptr;
+        } else {
+            error = clEnqueueWriteBuffer(queue_, slot.candidates, CL_FALSE, 0, slot.batch->buffer_size(),
+                                         slot.host, 0, nullptr, &slot.uploaded);
+        }
+        if (error == CL_SUCCESS) {
+            error = clEnqueueWriteBuffer(queue_, slot.found_index, CL_FALSE, 0, sizeof(cl_int), &NOT_FOUND,
+                                         0, nullptr, nullptr);
+        }
+        if (error == CL_SUCCESS) {
+            error = launch_kernel(slot, num_passwords);
+        }
+        if (error == CL_SUCCESS) {
+            error = clEnqueueReadBuffer(queue_, slot.found_index, CL_FALSE, 0, sizeof(cl_int),
+                                        &slot.host_found_index, 0, nullptr, &slot.done);
+        }
+        if (error == CL_SUCCESS) {
+            error = clFlush(queue_);
+        }
+
+        if (error != CL_SUCCESS) {
+            Logger::error("OpenCL kernel launch error: " + std::string(opencl_error_string(error)));
+            release_events(slot);
+            return false;
+        }
+
+        slot.in_flight = true;
+        metrics_.in_flight->set((double)++in_flight_count_);
+        return true;
+    }
+
+    /**
+     * Wait for every queued batch to finish
+     * @return true if any batch found the password
+     */
+    bool drain() {
+        for (auto& slot : slots_) {
+            retire_slot(slot);
+        }
+        return found_;
+    }
+
+    /**
+     * Get the password found by a retired batch
+     * @param found_password Set to the matching candidate
+     * @return true if a batch found the password
+     */
+    bool get_found_password(std::string& found_password) const {
+        if (found_) {
+            found_password = found_password_;
+        }
+        return found_;
+    }
+
+    /**
+     * Test a batch of candidates against the uploaded master key
+     * @param batch Candidate batch in fixed-stride slot layout
+     * @param found_password Set to the matching candidate
+     * @return true if a candidate matched
+     */
+    bool test_passwords(const CandidateBatch& batch, std::string& found_password) {
+        if (!initialized_) {
+            Logger::error("OpenCL recovery not initialized");
+            return false;
+        }
+        if (batch.empty() || !master_key_loaded_) {
+            return false;
+        }
+
+        reset_found();
+        for (size_t start = 0; start < batch.size() && !found_; ) {
+            CandidateBatch& staging = acquire_batch();
+            if (found_) {
+                break;
+            }
+            start += staging.append(batch, start, staging.capacity());
+            if (!submit_batch()) {
+                drain();
+                return false;
+            }
+        }
+
+        return drain() && get_found_password(found_password);
+    }
+
+    /**
+     * Test a keyspace range, generated straight into the staging batches;
+     * the usual per-device body of a DeviceScheduler run
+     * @param generator Keyspace the range indexes
+     * @param range Candidates to test
+     * @param found_password Set to the matching candidate
+     * @return true if a candidate matched
+     */
+    bool test_range(const MaskGenerator& generator, const KeyspaceRange& range, std::string& found_password) {
+        if (!initialized_) {
+            Logger::error("OpenCL recovery not initialized");
+            return false;
+        }
+        if (range.empty() || !master_key_loaded_) {
+            return false;
+        }
+
+        reset_found();
+        for (KeyspaceIndex next = range.begin; next < range.end && !found_; ) {
+            CandidateBatch& staging = acquire_batch();
+            if (found_) {
+                break;
+            }
+            const KeyspaceIndex left = range.end - next;
+            const uint64_t count = left < staging.capacity() ? (uint64_t)left : (uint64_t)staging.capacity();
+            const size_t filled = generator.fill(next, count, staging);
+            if (filled == 0) {
+                break;
+            }
+            next += filled;
+            if (!submit_batch()) {
+                drain();
+                return false;
+            }
+        }
+
+        return drain() && get_found_password(found_password);
+    }
+
+    /**
+     * Clear the found state before testing a new candidate space
+     */
+    void reset_found() {
+        found_ = false;
+        found_password_.clear();
+    }
+
+    bool is_initialized() const { return initialized_; }
+    int device_index() const { return device_index_; }
+
+    /**
+     * Check whether a master-key record is the one currently on the device
+     */
+    bool is_master_key_uploaded(const BitcoinCoreMKeyCheck& master_key) const {
+        return master_key_loaded_ && memcmp(&master_key_, &master_key, sizeof(master_key)) == 0;
+    }
+
+private:
+    int device_index_;
+    bool initialized_;
+    OpenCLDevice device_;
+    IntegratedGPUInfo gpu_info_;
+    IntegratedGPUProfile profile_;
+
+    cl_context context_;
+    cl_command_queue queue_;
+    cl_program program_;
+    cl_kernel verify_kernel_;
+    cl_kernel self_test_kernel_;
+    cl_mem tables_;
+    cl_mem master_key_buffer_;
+    size_t work_group_size_;
+
+    /**
+     * Pipeline stage with its own buffers and completion event
+     */
+    struct PipelineSlot {
+        cl_mem candidates = nullptr;
+        cl_mem found_index = nullptr;
+        unsigned char* host = nullptr;    // Staging memory, or the zero-copy buffer's backing store
+        unsigned char* mapped = nullptr;  // Host view of a zero-copy buffer while it is being filled
+        cl_int host_found_index = NOT_FOUND;
+        cl_event uploaded = nullptr;      // Write or unmap of the batch
+        cl_event computed = nullptr;      // Verification kernel
+        cl_event done = nullptr;          // Readback of the result
+        std::unique_ptr<CandidateBatch> batch;
+        bool in_flight = false;
+    };
+
+    bool zero_copy_;
+    size_t slot_capacity_;
+    std::vector<PipelineSlot> slots_;
+    size_t next_slot_;
+
+    // Latency histograms and queue depth of this device's pipeline
+    PipelineMetrics metrics_;
+    size_t in_flight_count_;
+    std::chrono::steady_clock::time_point acquired_at_;
+
+    bool found_;
+    std::string found_password_;
+
+    // Host copy of the record in master_key_buffer_
+    BitcoinCoreMKeyCheck master_key_;
+    bool master_key_loaded_;
+
+    bool create_context() {
+        cl_int error = CL_SUCCESS;
+        const cl_context_properties properties[] = {
+            CL_CONTEXT_PLATFORM, reinterpret_cast<cl_context_properties>(device_.platform), 0
+        };
+        context_ = clCreateContext(properties, 1, &device_.device, nullptr, nullptr, &error);
+        if (error == CL_SUCCESS) {
+            queue_ = clCreateCommandQueue(context_, device_.device, CL_QUEUE_PROFILING_ENABLE, &error);
+        }
+        if (error != CL_SUCCESS) {
+            Logger::error("Failed to create OpenCL context for " + device_.name + ": " +
+                          std::string(opencl_error_string(error)));
+            return false;
+        }
+        return true;
+    }
+
+    bool build_program(const std::string& cache_directory) {
+        std::string options;
+        for (const auto& option : profile_.compiler_options) {
+            options += (options.empty() ? "" : " ") + option.first;
+            if (!option.second.empty()) {
+                options += "=" + option.second;
+            }
+        }
+
+        ProgramBinaryCache cache(cache_directory);
+        bool from_cache = false;
+        program_ = opencl_build_program(context_, device_, OPENCL_MKEY_KERNEL_SOURCE, options, &cache, &from_cache);
+        if (!program_) {
+            return false;
+        }
+        Logger::info(std::string(from_cache ? "Loaded cached" : "Compiled") + " OpenCL program for " + device_.name);
+
+        cl_int error = CL_SUCCESS;
+        verify_kernel_ = clCreateKernel(program_, "verify_master_key", &error);
+        if (error == CL_SUCCESS) {
+            self_test_kernel_ = clCreateKernel(program_, "pbkdf2_sha512_self_test", &error);
+        }
+
+        // Round constants and S-boxes come from the host reference tables
+        const OpenCLCryptoTables tables = make_opencl_crypto_tables();
+        if (error == CL_SUCCESS) {
+            tables_ = clCreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(tables),
+                                     const_cast<OpenCLCryptoTables*>(&tables), &error);
+        }
+        if (error == CL_SUCCESS) {
+            master_key_buffer_ = clCreateBuffer(context_, CL_MEM_READ_ONLY, sizeof(BitcoinCoreMKeyCheck),
+                                                nullptr, &error);
+        }
+        if (error == CL_SUCCESS) error = clSetKernelArg(verify_kernel_, 0, sizeof(cl_mem), &master_key_buffer_);
+        if (error == CL_SUCCESS) error = clSetKernelArg(verify_kernel_, 1, sizeof(cl_mem), &tables_);
+        if (error == CL_SUCCESS) error = clSetKernelArg(self_test_kernel_, 0, sizeof(cl_mem), &tables_);
+        if (error != CL_SUCCESS) {
+            Logger::error("Failed to set up OpenCL kernels: " + std::string(opencl_error_string(error)));
+            return false;
+        }
+
+        // Profile work group size, within what the compiled kernel allows
+        size_t kernel_limit = 0;
+        if (clGetKernelWorkGroupInfo(verify_kernel_, device_.device, CL_KERNEL_WORK_GROUP_SIZE,
+                                     sizeof(kernel_limit), &kernel_limit, nullptr) != CL_SUCCESS) {
+            kernel_limit = 64;
+        }
+        const size_t wanted = profile_.recommended_work_group_size > 0 ? profile_.recommended_work_group_size : 64;
+        work_group_size_ = std::max<size_t>(1, std::min(wanted, kernel_limit));
+        return true;
+    }
+
+    void map_slot(PipelineSlot& slot) {
+        cl_int error = CL_SUCCESS;
+        void* mapped = clEnqueueMapBuffer(queue_, slot.candidates, CL_TRUE, CL_MAP_WRITE, 0,
+                                          slot_capacity_ * CandidateBatch::DEFAULT_STRIDE, 0, nullptr, nullptr, &error);
+        if (error != CL_SUCCESS) {
+            Logger::error("Failed to map OpenCL staging buffer: " + std::string(opencl_error_string(error)));
+            return;
+        }
+        slot.mapped = static_cast<unsigned char*>(mapped);
+        // Drivers return the host pointer the buffer was created over, but
+        // the mapping is the address the spec guarantees
+        if (slot.batch->buffer() != slot.mapped) {
+            slot.batch = std::make_unique<CandidateBatch>(slot.mapped, slot_capacity_);
+        }
+    }
+
+    void retire_slot(PipelineSlot& slot) {
+        if (!slot.in_flight) {
+            return;
+        }
+        slot.in_flight = false;
+        metrics_.in_flight->set((double)--in_flight_count_);
+
+        cl_int error = clWaitForEvents(1, &slot.done);
+        if (error == CL_SUCCESS) {
+            observe_command(metrics_.host_to_device, slot.uploaded);
+            observe_command(metrics_.kernel, slot.computed);
+            observe_command(metrics_.device_to_host, slot.done);
+        }
+        release_events(slot);
+        if (error != CL_SUCCESS) {
+            Logger::error("OpenCL kernel error: " + std::string(opencl_error_string(error)));
+            return;
+        }
+
+        const auto verify_start = std::chrono::steady_clock::now();
+        check_result(slot);
+        metrics_.verify->observe(
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - verify_start).count());
+    }
+
+    void release_events(PipelineSlot& slot) {
+        for (cl_event* event : {&slot.uploaded, &slot.computed, &slot.done}) {
+            if (*event) {
+                clReleaseEvent(*event);
+                *event = nullptr;
+            }
+        }
+    }
+
+    // Record a match reported by a retired slot
+    void check_result(PipelineSlot& slot) {
+        const int found_index = slot.host_found_index;
+        if (found_ || found_index < 0 || found_index >= (int)slot.batch->size()) {
+            return;
+        }
+        // The host may only read a zero-copy buffer while it is mapped
+        if (zero_copy_) {
+            map_slot(slot);
+            if (!slot.mapped) {
+                return;
+            }
+        }
+        found_password_ = slot.batch->to_string(found_index);
+        found_ = true;
+    }
+
+    cl_int launch_kernel(PipelineSlot& slot, cl_uint num_passwords) {
+        const cl_uint stride = static_cast<cl_uint>(slot.batch->stride());
+        size_t local = work_group_size_;
+        size_t global = (num_passwords + local - 1) / local * local;
+
+        // Laptops keep the GPU's share of the package power down by running
+        // fewer work-items; the kernel's stride loop covers the rest
+        if (gpu_info_.is_power_constrained && profile_.enable_thermal_throttling && gpu_info_.compute_units > 0) {
+            const size_t cap = (size_t)gpu_info_.compute_units * std::max(profile_.thread_count_multiplier, 1) * local;
+            global = std::min(global, cap);
+        }
+
+        cl_int error = clSetKernelArg(verify_kernel_, 2, sizeof(cl_mem), &slot.candidates);
+        if (error == CL_SUCCESS) error = clSetKernelArg(verify_kernel_, 3, sizeof(cl_uint), &stride);
+        if (error == CL_SUCCESS) error = clSetKernelArg(verify_kernel_, 4, sizeof(cl_uint), &num_passwords);
+        if (error == CL_SUCCESS) error = clSetKernelArg(verify_kernel_, 5, sizeof(cl_mem), &slot.found_index);
+        if (error == CL_SUCCESS) {
+            error = clEnqueueNDRangeKernel(queue_, verify_kernel_, 1, nullptr, &global, &local,
+                                           0, nullptr, &slot.computed);
+        }
+        return error;
+    }
+
+    bool run_self_test() {
+        cl_int error = CL_SUCCESS;
+        cl_mem password_buffer = clCreateBuffer(context_, CL_MEM_READ_ONLY, 128, nullptr, &error);
+        cl_mem salt_buffer = nullptr;
+        cl_mem key_buffer = nullptr;
+        if (error == CL_SUCCESS) {
+            salt_buffer = clCreateBuffer(context_, CL_MEM_READ_ONLY, 128, nullptr, &error);
+        }
+        if (error == CL_SUCCESS) {
+            key_buffer = clCreateBuffer(context_, CL_MEM_WRITE_ONLY, 64, nullptr, &error);
+        }
+
+        bool passed = error == CL_SUCCESS;
+        for (size_t i = 0; i < PBKDF2_SHA512_TEST_VECTOR_COUNT && passed; i++) {
+            const auto& vector = PBKDF2_SHA512_TEST_VECTORS[i];
+            const cl_uint password_length = (cl_uint)strlen(vector.password);
+            const cl_uint salt_length = (cl_uint)strlen(vector.salt);
+            const cl_uint iterations = vector.iterations;
+            const cl_uint key_length = (cl_uint)vector.key_length;
+            const size_t one = 1;
+
+            error = clEnqueueWriteBuffer(queue_, password_buffer, CL_TRUE, 0, password_length, vector.password,
+                                         0, nullptr, nullptr);
+            if (error == CL_SUCCESS) {
+                error = clEnqueueWriteBuffer(queue_, salt_buffer, CL_TRUE, 0, salt_length, vector.salt,
+                                             0, nullptr, nullptr);
+            }
+            if (error == CL_SUCCESS) error = clSetKernelArg(self_test_kernel_, 1, sizeof(cl_mem), &password_buffer);
+            if (error == CL_SUCCESS) error = clSetKernelArg(self_test_kernel_, 2, sizeof(cl_uint), &password_length);
+            if (error == CL_SUCCESS) error = clSetKernelArg(self_test_kernel_, 3, sizeof(cl_mem), &salt_buffer);
+            if (error == CL_SUCCESS) error = clSetKernelArg(self_test_kernel_, 4, sizeof(cl_uint), &salt_length);
+            if (error == CL_SUCCESS) error = clSetKernelArg(self_test_kernel_, 5, sizeof(cl_uint), &iterations);
+            if (error == CL_SUCCESS) error = clSetKernelArg(self_test_kernel_, 6, sizeof(cl_mem), &key_buffer);
+            if (error == CL_SUCCESS) error = clSetKernelArg(self_test_kernel_, 7, sizeof(cl_uint), &key_length);
+            if (error == CL_SUCCESS) {
+                error = clEnqueueNDRangeKernel(queue_, self_test_kernel_, 1, nullptr, &one, &one, 0, nullptr, nullptr);
+            }
+
+            unsigned char key[64];
+            if (error == CL_SUCCESS) {
+                error = clEnqueueReadBuffer(queue_, key_buffer, CL_TRUE, 0, key_length, key, 0, nullptr, nullptr);
+            }
+            if (error != CL_SUCCESS) {
+                passed = false;
+                break;
+            }
+
+            static const char* digits = "0123456789abcdef";
+            std::string hex;
+            for (size_t j = 0; j < vector.key_length; j++) {
+                hex += digits[key[j] >> 4];
+                hex += digits[key[j] & 0x0f];
+            }
+            passed = (hex == vector.expected_hex);
+        }
+
+        if (key_buffer) clReleaseMemObject(key_buffer);
+        if (salt_buffer) clReleaseMemObject(salt_buffer);
+        if (password_buffer) clReleaseMemObject(password_buffer);
+        return passed;
+    }
+
+    bool initialize_memory_pools() {
+        slot_capacity_ = profile_.recommended_batch_size > 0 ? profile_.recommended_batch_size : 1000;
+        const size_t pool_bytes = slot_capacity_ * CandidateBatch::DEFAULT_STRIDE;
+        const int slot_count = profile_.enable_memory_pooling ? 3 : 1;
+
+        // Shared-memory GPUs read the staging buffers in place
+        zero_copy_ = device_.host_unified_memory;
+
+        slots_.resize(slot_count);
+        cl_int error = CL_SUCCESS;
+        for (auto& slot : slots_) {
+            slot.host = allocate_aligned(pool_bytes);
+            if (!slot.host) {
+                error = CL_OUT_OF_HOST_MEMORY;
+                break;
+            }
+            const cl_mem_flags flags = CL_MEM_READ_ONLY | (zero_copy_ ? CL_MEM_USE_HOST_PTR : 0);
+            slot.candidates = clCreateBuffer(context_, flags, pool_bytes, zero_copy_ ? slot.host : nullptr, &error);
+            if (error == CL_SUCCESS) {
+                slot.found_index = clCreateBuffer(context_, CL_MEM_READ_WRITE, sizeof(cl_int), nullptr, &error);
+            }
+            if (error != CL_SUCCESS) {
+                break;
+            }
+            slot.batch = std::make_unique<CandidateBatch>(slot.host, slot_capacity_);
+        }
+
+        if (error != CL_SUCCESS) {
+            Logger::error("Failed to allocate OpenCL memory pools: " + std::string(opencl_error_string(error)));
+            return false;
+        }
+
+        LOG_DEBUG("Allocated " + std::to_string(slot_count) + " OpenCL pipeline slots for " +
+                      std::to_string(slot_capacity_) + " candidates each");
+        return true;
+    }
+
+    void release_memory_pools() {
+        for (auto& slot : slots_) {
+            if (slot.done) {
+                clWaitForEvents(1, &slot.done);
+            }
+            release_events(slot);
+            if (slot.mapped) {
+                clEnqueueUnmapMemObject(queue_, slot.candidates, slot.mapped, 0, nullptr, nullptr);
+            }
+        }
+        // Unmaps must complete before the backing store is freed
+        if (queue_) {
+            clFinish(queue_);
+        }
+        for (auto& slot : slots_) {
+            if (slot.candidates) clReleaseMemObject(slot.candidates);
+            if (slot.found_index) clReleaseMemObject(slot.found_index);
+            if (slot.host) free_aligned(slot.host);
+        }
+        slots_.clear();
+        next_slot_ = 0;
+        slot_capacity_ = 0;
+        in_flight_count_ = 0;
+        if (metrics_.in_flight) {
+            metrics_.in_flight->set(0.0);
+        }
+    }
+
+    void cleanup() {
+        release_memory_pools();
+        if (master_key_buffer_) clReleaseMemObject(master_key_buffer_);
+        if (tables_) clReleaseMemObject(tables_);
+        if (self_test_kernel_) clReleaseKernel(self_test_kernel_);
+        if (verify_kernel_) clReleaseKernel(verify_kernel_);
+        if (program_) clReleaseProgram(program_);
+        if (queue_) clReleaseCommandQueue(queue_);
+        if (context_) clReleaseContext(context_);
+        master_key_buffer_ = nullptr;
+        tables_ = nullptr;
+        self_test_kernel_ = nullptr;
+        verify_kernel_ = nullptr;
+        program_ = nullptr;
+        queue_ = nullptr;
+        context_ = nullptr;
+        master_key_loaded_ = false;
+        initialized_ = false;
+    }
+};
+
+// C interface for integration with the main recovery engine
+extern "C" {
+    void* opencl_recovery_create() {
+        return new OpenCLRecovery();
+    }
+
+    void opencl_recovery_destroy(void* recovery) {
+        delete static_cast<OpenCLRecovery*>(recovery);
+    }
+
+    // Intel and AMD OpenCL GPUs; create one recovery per device
+    int opencl_recovery_device_count() {
+        return (int)opencl_integrated_devices().size();
+    }
+
+    // cache_directory NULL or "" uses the default program binary cache
+    int opencl_recovery_initialize(void* recovery, int device_index, const char* cache_directory) {
+        return static_cast<OpenCLRecovery*>(recovery)->initialize(
+            device_index, nullptr, cache_directory ? cache_directory : "") ? 1 : 0;
+    }
+
+    // wallet_data is a BitcoinCoreMKeyCheck record from BitcoinCoreWallet::get_master_key_check
+    int opencl_recovery_initialize_with_wallet(void* recovery, int device_index, const char* cache_directory,
+                                               const unsigned char* wallet_data, int wallet_data_size) {
+        if (!wallet_data || wallet_data_size != (int)sizeof(BitcoinCoreMKeyCheck)) {
+            Logger::error("Wallet data is not a master-key verification record");
+            return 0;
+        }
+        BitcoinCoreMKeyCheck master_key;
+        memcpy(&master_key, wallet_data, sizeof(master_key));
+        return static_cast<OpenCLRecovery*>(recovery)->initialize(
+            device_index, &master_key, cache_directory ? cache_directory : "") ? 1 : 0;
+    }
+
+    int opencl_recovery_test_passwords(void* recovery,
+                                       const char** passwords,
+                                       int num_passwords,
+                                       const unsigned char* wallet_data,
+                                       int wallet_data_size,
+                                       char* found_password,
+                                       int max_password_length) {
+        auto* opencl_recovery = static_cast<OpenCLRecovery*>(recovery);
+        if (!opencl_recovery->is_initialized()) {
+            Logger::error("OpenCL recovery not initialized");
+            return 0;
+        }
+
+        // The master-key record is uploaded once and reused while it stays the same
+        if (!wallet_data || wallet_data_size != (int)sizeof(BitcoinCoreMKeyCheck)) {
+            Logger::error("Wallet data is not a master-key verification record");
+            return 0;
+        }
+        BitcoinCoreMKeyCheck master_key;
+        memcpy(&master_key, wallet_data, sizeof(master_key));
+        if (!opencl_recovery->is_master_key_uploaded(master_key) &&
+            !opencl_recovery->upload_master_key(master_key)) {
+            return 0;
+        }
+
+        // Candidates are written straight into the staging batches, so
+        // filling one slot overlaps the kernels of the others
+        opencl_recovery->reset_found();
+        CandidateBatch* batch = &opencl_recovery->acquire_batch();
+        for (int i = 0; i < num_passwords; i++) {
+            if (batch->full()) {
+                if (!opencl_recovery->submit_batch()) {
+                    opencl_recovery->drain();
+                    return 0;
+                }
+                batch = &opencl_recovery->acquire_batch();
+            }
+            if (!batch->push(passwords[i], strlen(passwords[i]))) {
+                LOG_DEBUG("Skipping candidate longer than " + std::to_string(batch->max_length()) + " bytes");
+            }
+        }
+
+        std::string found;
+        bool success = opencl_recovery->submit_batch() && opencl_recovery->drain() &&
+                       opencl_recovery->get_found_password(found);
+
+        if (success && !found.empty() && max_password_length > 0) {
+            strncpy(found_password, found.c_str(), max_password_length - 1);
+            found_password[max_password_length - 1] = '\0';
+            return 1;
+        }
+
+        return 0;
+    }
+
+    // range is this device's chunk of the keyspace generator indexes
+    int opencl_recovery_test_range(void* recovery,
+                                   const MaskGenerator* generator,
+                                   const KeyspaceRange* range,
+                                   char* found_password,
+                                   int max_password_length) {
+        if (!generator || !range || max_password_length <= 0) {
+            return 0;
+        }
+        std::string found;
+        if (!static_cast<OpenCLRecovery*>(recovery)->test_range(*generator, *range, found)) {
+            return 0;
+        }
+        strncpy(found_password, found.c_str(), max_password_length - 1);
+        found_password[max_password_length - 1] = '\0';
+        return 1;
+    }
+}
+
+#endif // ENABLE_OPENCL
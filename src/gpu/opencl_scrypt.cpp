@@ -0,0 +1,358 @@
+#ifdef ENABLE_OPENCL
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "gpu/opencl_program_cache.h"
+#include "gpu/opencl_utils.h"
+#include "opencl_scrypt_kernel.h"
+#include "utils/logger.h"
+#include "utils/scrypt.h"
+#include "utils/scrypt_engine.h"
+
+namespace {
+
+// Resident lanes per compute unit; fewer than the CUDA backend because
+// integrated GPUs have narrower memory paths to keep busy
+const size_t LANES_PER_COMPUTE_UNIT = 64;
+
+// Share of device memory given to the V tables. Integrated GPUs take it
+// from system memory, so they leave more for the host
+const double MEMORY_BUDGET_RATIO = 0.85;
+const double UNIFIED_MEMORY_BUDGET_RATIO = 0.5;
+
+const size_t WORK_GROUP_SIZE = 64;
+
+// RFC 7914 vector 1, small enough to run on every device at startup
+const char* const SELF_TEST_EXPECTED =
+    "77d6576238657b203b19ca42c18a0497f16b4844e3074ae8dfdffa3fede21442"
+    "fcd0069ded0948f8326a753a0fc81f17e8d3e0fb2e0d3628cf35e20c38d18906";
+
+} // namespace
+
+/**
+ * scrypt on one Intel or AMD OpenCL GPU
+ *
+ * Same split as the CUDA backend: PBKDF2 on the host, ROMix on the device
+ * with the lookup gap planned for the device's memory. The scratch buffer
+ * is a single allocation, so the budget is also capped by
+ * CL_DEVICE_MAX_MEM_ALLOC_SIZE.
+ */
+class OpenCLScryptEngine {
+public:
+    OpenCLScryptEngine()
+        : params_(), scratch_words_(0), context_(nullptr), queue_(nullptr), program_(nullptr),
+          kernel_(nullptr), blocks_(nullptr), scratch_(nullptr), initialized_(false) {}
+
+    ~OpenCLScryptEngine() {
+        cleanup();
+    }
+
+    OpenCLScryptEngine(const OpenCLScryptEngine&) = delete;
+    OpenCLScryptEngine& operator=(const OpenCLScryptEngine&) = delete;
+
+    /**
+     * Build the kernel, plan the lookup gap and allocate the lane buffers
+     * @param device_index Index into opencl_integrated_devices() (-1 = first)
+     * @param params scrypt parameters
+     * @param cache_directory Program binary cache; empty uses the default
+     * @return true if successful
+     */
+    bool initialize(int device_index, const ScryptParams& params, const std::string& cache_directory = "") {
+        cleanup();
+        if (!scrypt_params_valid(params)) {
+            Logger::error("Invalid scrypt parameters");
+            return false;
+        }
+        params_ = params;
+
+        const auto devices = opencl_integrated_devices();
+        const int index = device_index < 0 ? 0 : device_index;
+        if (index >= (int)devices.size()) {
+            Logger::error("OpenCL device " + std::to_string(index) + " not found");
+            return false;
+        }
+        device_ = devices[index];
+
+        if (!create_context() || !build_program(cache_directory) || !allocate_lanes()) {
+            cleanup();
+            return false;
+        }
+
+        initialized_ = true;
+        if (!run_self_test()) {
+            Logger::error("scrypt self-test failed on device: " + device_.name);
+            cleanup();
+            return false;
+        }
+
+        Logger::info("OpenCL scrypt initialized for device: " + device_.name);
+        Logger::info("  Lookup gap: " + std::to_string(plan_.lookup_gap) + ", " + std::to_string(plan_.lanes) +
+                     " lanes of " + std::to_string(plan_.bytes_per_lane >> 10) + " KB");
+        return true;
+    }
+
+    /**
+     * Derive keys for a batch of passwords
+     * @param passwords Array of password pointers
+     * @param lengths Array of password lengths
+     * @param count Number of passwords
+     * @param salt Salt bytes
+     * @param salt_length Salt length
+     * @param derived_keys Output buffer of count * key_length bytes
+     * @param key_length Derived key length per password
+     * @return true if successful
+     */
+    bool derive(const uint8_t* const* passwords, const size_t* lengths, size_t count,
+                const uint8_t* salt, size_t salt_length, uint8_t* derived_keys, size_t key_length) {
+        return derive_with(params_, plan_.lookup_gap, passwords, lengths, count, salt, salt_length,
+                           derived_keys, key_length);
+    }
+
+    bool is_initialized() const { return initialized_; }
+    const ScryptTmtoPlan& get_plan() const { return plan_; }
+
+private:
+    OpenCLDevice device_;
+    ScryptParams params_;
+    ScryptTmtoPlan plan_;
+    size_t scratch_words_;
+    cl_context context_;
+    cl_command_queue queue_;
+    cl_program program_;
+    cl_kernel kernel_;
+    cl_mem blocks_;
+    cl_mem scratch_;
+    std::vector<uint8_t> expanded_;
+    std::vector<uint32_t> words_;
+    bool initialized_;
+
+    bool create_context() {
+        cl_int error = CL_SUCCESS;
+        const cl_context_properties properties[] = {
+            CL_CONTEXT_PLATFORM, reinterpret_cast<cl_context_properties>(device_.platform), 0
+        };
+        context_ = clCreateContext(properties, 1, &device_.device, nullptr, nullptr, &error);
+        if (error == CL_SUCCESS) {
+            queue_ = clCreateCommandQueue(context_, device_.device, 0, &error);
+        }
+        if (error != CL_SUCCESS) {
+            Logger::error("Failed to create OpenCL context for " + device_.name + ": " +
+                          std::string(opencl_error_string(error)));
+            return false;
+        }
+        return true;
+    }
+
+    bool build_program(const std::string& cache_directory) {
+        ProgramBinaryCache cache(cache_directory);
+        bool from_cache = false;
+        program_ = opencl_build_program(context_, device_, OPENCL_SCRYPT_KERNEL_SOURCE, "", &cache, &from_cache);
+        if (!program_) {
+            return false;
+        }
+        Logger::info(std::string(from_cache ? "Loaded cached" : "Compiled") + " OpenCL scrypt program for " +
+                     device_.name);
+
+        cl_int error = CL_SUCCESS;
+        kernel_ = clCreateKernel(program_, "scrypt_romix", &error);
+        if (error != CL_SUCCESS) {
+            Logger::error("Failed to create scrypt kernel: " + std::string(opencl_error_string(error)));
+            return false;
+        }
+        return true;
+    }
+
+    bool allocate_lanes() {
+        cl_ulong global_bytes = 0;
+        cl_ulong max_alloc_bytes = 0;
+        cl_uint compute_units = 1;
+        cl_int error = clGetDeviceInfo(device_.device, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(global_bytes),
+                                       &global_bytes, nullptr);
+        if (error == CL_SUCCESS) {
+            error = clGetDeviceInfo(device_.device, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(max_alloc_bytes),
+                                    &max_alloc_bytes, nullptr);
+        }
+        if (error == CL_SUCCESS) {
+            error = clGetDeviceInfo(device_.device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(compute_units),
+                                    &compute_units, nullptr);
+        }
+        if (error != CL_SUCCESS) {
+            Logger::error("Failed to query " + device_.name + ": " + std::string(opencl_error_string(error)));
+            return false;
+        }
+
+        const double ratio = device_.host_unified_memory ? UNIFIED_MEMORY_BUDGET_RATIO : MEMORY_BUDGET_RATIO;
+        const size_t budget = static_cast<size_t>(
+            std::min<double>(global_bytes * ratio, static_cast<double>(max_alloc_bytes)));
+        const size_t block_bytes = scrypt_block_words(params_.r) * sizeof(uint32_t);
+        plan_ = scrypt_plan_tmto(params_, budget, static_cast<size_t>(compute_units) * LANES_PER_COMPUTE_UNIT);
+        if (plan_.lanes > 0) {
+            plan_.lanes = std::min(plan_.lanes, budget / (plan_.bytes_per_lane + 3 * block_bytes));
+        }
+        if (plan_.lanes == 0) {
+            Logger::error("Not enough memory on " + device_.name + " for one scrypt lane");
+            return false;
+        }
+
+        scratch_words_ = scrypt_scratch_words(params_, plan_.lookup_gap);
+        blocks_ = clCreateBuffer(context_, CL_MEM_READ_WRITE, plan_.lanes * block_bytes, nullptr, &error);
+        if (error == CL_SUCCESS) {
+            scratch_ = clCreateBuffer(context_, CL_MEM_READ_WRITE, plan_.lanes * scratch_words_ * sizeof(uint32_t),
+                                      nullptr, &error);
+        }
+        if (error != CL_SUCCESS) {
+            Logger::error("Failed to allocate scrypt lanes: " + std::string(opencl_error_string(error)));
+            return false;
+        }
+        return true;
+    }
+
+    cl_int run_lanes(const ScryptParams& params, uint32_t lookup_gap, size_t lanes) {
+        const size_t block_bytes = scrypt_block_words(params.r) * sizeof(uint32_t);
+        const cl_uint lane_count = static_cast<cl_uint>(lanes);
+        const cl_ulong scratch_words = scrypt_scratch_words(params, lookup_gap);
+        const size_t global = (lanes + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE * WORK_GROUP_SIZE;
+        const size_t local = WORK_GROUP_SIZE;
+
+        cl_int error = clEnqueueWriteBuffer(queue_, blocks_, CL_TRUE, 0, lanes * block_bytes, words_.data(),
+                                            0, nullptr, nullptr);
+        if (error == CL_SUCCESS) error = clSetKernelArg(kernel_, 0, sizeof(cl_mem), &blocks_);
+        if (error == CL_SUCCESS) error = clSetKernelArg(kernel_, 1, sizeof(cl_mem), &scratch_);
+        if (error == CL_SUCCESS) error = clSetKernelArg(kernel_, 2, sizeof(cl_uint), &lane_count);
+        if (error == CL_SUCCESS) error = clSetKernelArg(kernel_, 3, sizeof(cl_uint), &params.N);
+        if (error == CL_SUCCESS) error = clSetKernelArg(kernel_, 4, sizeof(cl_uint), &params.r);
+        if (error == CL_SUCCESS) error = clSetKernelArg(kernel_, 5, sizeof(cl_uint), &lookup_gap);
+        if (error == CL_SUCCESS) error = clSetKernelArg(kernel_, 6, sizeof(cl_ulong), &scratch_words);
+        if (error == CL_SUCCESS) {
+            error = clEnqueueNDRangeKernel(queue_, kernel_, 1, nullptr, &global, &local, 0, nullptr, nullptr);
+        }
+        if (error == CL_SUCCESS) {
+            error = clEnqueueReadBuffer(queue_, blocks_, CL_TRUE, 0, lanes * block_bytes, words_.data(),
+                                        0, nullptr, nullptr);
+        }
+        return error;
+    }
+
+    // params may be smaller than the ones the buffers were sized for
+    bool derive_with(const ScryptParams& params, uint32_t lookup_gap,
+                     const uint8_t* const* passwords, const size_t* lengths, size_t count,
+                     const uint8_t* salt, size_t salt_length, uint8_t* derived_keys, size_t key_length) {
+        if (!initialized_) {
+            Logger::error("OpenCL scrypt not initialized");
+            return false;
+        }
+
+        const size_t block_words = scrypt_block_words(params.r);
+        const size_t lane_bytes = block_words * sizeof(uint32_t);
+        const size_t candidate_bytes = params.p * lane_bytes;
+        const size_t total_lanes = count * params.p;
+        expanded_.resize(count * candidate_bytes);
+        for (size_t i = 0; i < count; i++) {
+            pbkdf2_hmac_sha256(passwords[i], lengths[i], salt, salt_length, 1,
+                               expanded_.data() + i * candidate_bytes, candidate_bytes);
+        }
+
+        cl_int error = CL_SUCCESS;
+        words_.resize(std::min(total_lanes, plan_.lanes) * block_words);
+        for (size_t first = 0; first < total_lanes && error == CL_SUCCESS; first += plan_.lanes) {
+            const size_t lanes = std::min(plan_.lanes, total_lanes - first);
+            scrypt_bytes_to_words(expanded_.data() + first * lane_bytes, words_.data(), lanes * block_words);
+            error = run_lanes(params, lookup_gap, lanes);
+            if (error == CL_SUCCESS) {
+                scrypt_words_to_bytes(words_.data(), expanded_.data() + first * lane_bytes, lanes * block_words);
+            }
+        }
+        if (error != CL_SUCCESS) {
+            Logger::error("OpenCL scrypt failed: " + std::string(opencl_error_string(error)));
+            return false;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            pbkdf2_hmac_sha256(passwords[i], lengths[i], expanded_.data() + i * candidate_bytes, candidate_bytes,
+                               1, derived_keys + i * key_length, key_length);
+        }
+        return true;
+    }
+
+    bool run_self_test() {
+        const ScryptParams params = {16, 1, 1};
+        const uint32_t gap = std::min<uint32_t>(plan_.lookup_gap, params.N);
+        const uint8_t* password = reinterpret_cast<const uint8_t*>("");
+        const size_t length = 0;
+        uint8_t key[64];
+        if (!derive_with(params, gap, &password, &length, 1, password, 0, key, sizeof(key))) {
+            return false;
+        }
+
+        static const char* digits = "0123456789abcdef";
+        std::string hex;
+        for (uint8_t byte : key) {
+            hex += digits[byte >> 4];
+            hex += digits[byte & 0x0f];
+        }
+        return hex == SELF_TEST_EXPECTED;
+    }
+
+    void cleanup() {
+        if (scratch_) clReleaseMemObject(scratch_);
+        if (blocks_) clReleaseMemObject(blocks_);
+        if (kernel_) clReleaseKernel(kernel_);
+        if (program_) clReleaseProgram(program_);
+        if (queue_) clReleaseCommandQueue(queue_);
+        if (context_) clReleaseContext(context_);
+        scratch_ = nullptr;
+        blocks_ = nullptr;
+        kernel_ = nullptr;
+        program_ = nullptr;
+        queue_ = nullptr;
+        context_ = nullptr;
+        expanded_.clear();
+        words_.clear();
+        initialized_ = false;
+    }
+};
+
+extern "C" {
+    void* opencl_scrypt_create() {
+        return new OpenCLScryptEngine();
+    }
+
+    void opencl_scrypt_destroy(void* engine) {
+        delete static_cast<OpenCLScryptEngine*>(engine);
+    }
+
+    // cache_directory NULL or "" uses the default program binary cache
+    int opencl_scrypt_initialize(void* engine, int device_index, const char* cache_directory,
+                                 unsigned int N, unsigned int r, unsigned int p) {
+        const ScryptParams params = {N, r, p};
+        return static_cast<OpenCLScryptEngine*>(engine)->initialize(
+            device_index, params, cache_directory ? cache_directory : "") ? 1 : 0;
+    }
+
+    // Lookup gap the device runs with, 0 before initialization
+    int opencl_scrypt_lookup_gap(void* engine) {
+        auto* scrypt = static_cast<OpenCLScryptEngine*>(engine);
+        return scrypt->is_initialized() ? (int)scrypt->get_plan().lookup_gap : 0;
+    }
+
+    // derived_keys receives num_passwords * key_length bytes
+    int opencl_scrypt_derive(void* engine, const char** passwords, int num_passwords,
+                             const unsigned char* salt, int salt_length,
+                             unsigned char* derived_keys, int key_length) {
+        if (num_passwords < 0 || salt_length < 0 || key_length <= 0) {
+            return 0;
+        }
+        std::vector<const uint8_t*> pointers(num_passwords);
+        std::vector<size_t> lengths(num_passwords);
+        for (int i = 0; i < num_passwords; i++) {
+            pointers[i] = reinterpret_cast<const uint8_t*>(passwords[i]);
+            lengths[i] = strlen(passwords[i]);
+        }
+        return static_cast<OpenCLScryptEngine*>(engine)->derive(pointers.data(), lengths.data(), num_passwords,
+                                                                salt, salt_length, derived_keys, key_length) ? 1 : 0;
+    }
+}
+
+#endif // ENABLE_OPENCL
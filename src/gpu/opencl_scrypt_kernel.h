@@ -0,0 +1,107 @@
+#pragma once
+
+// Internal header: OpenCL C source of the scrypt ROMix kernel. It mirrors
+// scrypt_salsa20_8, scrypt_block_mix and scrypt_romix in utils/scrypt.h,
+// which are C++ and cannot be compiled by OpenCL C compilers. The PBKDF2
+// steps around ROMix run on the host.
+
+static const char* OPENCL_SCRYPT_KERNEL_SOURCE = R"CLC(
+#define ROTL(x, n) rotate((uint)(x), (uint)(n))
+
+void salsa20_8(uint b[16]) {
+    uint x[16];
+    for (int i = 0; i < 16; i++) {
+        x[i] = b[i];
+    }
+    for (int round = 0; round < 8; round += 2) {
+        x[4] ^= ROTL(x[0] + x[12], 7);   x[8] ^= ROTL(x[4] + x[0], 9);
+        x[12] ^= ROTL(x[8] + x[4], 13);  x[0] ^= ROTL(x[12] + x[8], 18);
+        x[9] ^= ROTL(x[5] + x[1], 7);    x[13] ^= ROTL(x[9] + x[5], 9);
+        x[1] ^= ROTL(x[13] + x[9], 13);  x[5] ^= ROTL(x[1] + x[13], 18);
+        x[14] ^= ROTL(x[10] + x[6], 7);  x[2] ^= ROTL(x[14] + x[10], 9);
+        x[6] ^= ROTL(x[2] + x[14], 13);  x[10] ^= ROTL(x[6] + x[2], 18);
+        x[3] ^= ROTL(x[15] + x[11], 7);  x[7] ^= ROTL(x[3] + x[15], 9);
+        x[11] ^= ROTL(x[7] + x[3], 13);  x[15] ^= ROTL(x[11] + x[7], 18);
+
+        x[1] ^= ROTL(x[0] + x[3], 7);    x[2] ^= ROTL(x[1] + x[0], 9);
+        x[3] ^= ROTL(x[2] + x[1], 13);   x[0] ^= ROTL(x[3] + x[2], 18);
+        x[6] ^= ROTL(x[5] + x[4], 7);    x[7] ^= ROTL(x[6] + x[5], 9);
+        x[4] ^= ROTL(x[7] + x[6], 13);   x[5] ^= ROTL(x[4] + x[7], 18);
+        x[11] ^= ROTL(x[10] + x[9], 7);  x[8] ^= ROTL(x[11] + x[10], 9);
+        x[9] ^= ROTL(x[8] + x[11], 13);  x[10] ^= ROTL(x[9] + x[8], 18);
+        x[12] ^= ROTL(x[15] + x[14], 7); x[13] ^= ROTL(x[12] + x[15], 9);
+        x[14] ^= ROTL(x[13] + x[12], 13); x[15] ^= ROTL(x[14] + x[13], 18);
+    }
+    for (int i = 0; i < 16; i++) {
+        b[i] += x[i];
+    }
+}
+
+void block_mix(__global const uint* in, __global uint* out, uint r) {
+    uint x[16];
+    __global const uint* last = in + (2 * r - 1) * 16;
+    for (int i = 0; i < 16; i++) {
+        x[i] = last[i];
+    }
+    for (uint i = 0; i < 2 * r; i++) {
+        __global const uint* block = in + i * 16;
+        for (int k = 0; k < 16; k++) {
+            x[k] ^= block[k];
+        }
+        salsa20_8(x);
+        __global uint* target = out + ((i >> 1) + (i & 1) * r) * 16;
+        for (int k = 0; k < 16; k++) {
+            target[k] = x[k];
+        }
+    }
+}
+
+void copy_block(__global uint* dst, __global const uint* src, uint words) {
+    for (uint k = 0; k < words; k++) {
+        dst[k] = src[k];
+    }
+}
+
+// One lane per work item. blocks holds the expanded lanes as little-endian
+// words; each lane's V table and two working blocks start at
+// scratch + lane * scratch_words
+__kernel void scrypt_romix(__global uint* blocks, __global uint* scratch, uint lane_count,
+                           uint N, uint r, uint lookup_gap, ulong scratch_words) {
+    const uint lane = get_global_id(0);
+    if (lane >= lane_count) {
+        return;
+    }
+    const uint words = 32 * r;
+    __global uint* x = blocks + (ulong)lane * words;
+    __global uint* v = scratch + (ulong)lane * scratch_words;
+    __global uint* t = v + (ulong)((N + lookup_gap - 1) / lookup_gap) * words;
+    __global uint* u = t + words;
+
+    for (uint i = 0; i < N; i++) {
+        if (i % lookup_gap == 0) {
+            copy_block(v + (ulong)(i / lookup_gap) * words, x, words);
+        }
+        block_mix(x, t, r);
+        copy_block(x, t, words);
+    }
+
+    for (uint i = 0; i < N; i++) {
+        const uint j = x[(2 * r - 1) * 16] & (N - 1);
+        __global const uint* entry = v + (ulong)(j / lookup_gap) * words;
+        const uint steps = j % lookup_gap;
+        if (steps > 0) {
+            copy_block(t, entry, words);
+            for (uint s = 0; s < steps; s++) {
+                block_mix(t, u, r);
+                copy_block(t, u, words);
+            }
+            entry = t;
+        }
+        for (uint k = 0; k < words; k++) {
+            x[k] ^= entry[k];
+        }
+        block_mix(x, u, r);
+        copy_block(x, u, words);
+    }
+}
+)CLC";
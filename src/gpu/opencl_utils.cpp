@@ -0,0 +1,212 @@
+#ifdef ENABLE_OPENCL
+
+#include "gpu/opencl_utils.h"
+#include "utils/logger.h"
+#include <cstring>
+
+namespace {
+
+bool platform_matches(const std::string& vendor, bool intel) {
+    if (intel) {
+        return vendor.find("Intel") != std::string::npos;
+    }
+    return vendor.find("Advanced Micro Devices") != std::string::npos ||
+           vendor.find("AMD") != std::string::npos;
+}
+
+ProgramCacheKey cache_key(const OpenCLDevice& device, const char* source, const std::string& options) {
+    ProgramCacheKey key;
+    key.device_name = device.name;
+    key.device_version = opencl_device_string(device.device, CL_DEVICE_VERSION);
+    key.driver_version = opencl_device_string(device.device, CL_DRIVER_VERSION);
+    key.platform_version = opencl_platform_string(device.platform, CL_PLATFORM_VERSION);
+    key.build_options = options;
+    key.source = source;
+    return key;
+}
+
+bool program_binary(cl_program program, std::vector<unsigned char>& binary) {
+    size_t size = 0;
+    if (clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size), &size, nullptr) != CL_SUCCESS ||
+        size == 0) {
+        return false;
+    }
+    binary.resize(size);
+    unsigned char* data = binary.data();
+    return clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(data), &data, nullptr) == CL_SUCCESS;
+}
+
+std::string build_log(cl_program program, cl_device_id device) {
+    size_t size = 0;
+    if (clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0, nullptr, &size) != CL_SUCCESS || size == 0) {
+        return "";
+    }
+    std::string log(size, '\0');
+    clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, size, &log[0], nullptr);
+    log.resize(std::strlen(log.c_str()));
+    return log;
+}
+
+std::vector<OpenCLDevice> enumerate_integrated_devices() {
+    std::vector<OpenCLDevice> devices;
+
+    cl_platform_id platforms[16];
+    cl_uint num_platforms = 0;
+    if (clGetPlatformIDs(16, platforms, &num_platforms) != CL_SUCCESS) {
+        return devices;
+    }
+    if (num_platforms > 16) {
+        num_platforms = 16;
+    }
+
+    // Intel first, then AMD; the device inventory keeps this order
+    for (bool intel : {true, false}) {
+        for (cl_uint i = 0; i < num_platforms; i++) {
+            if (!platform_matches(opencl_platform_string(platforms[i], CL_PLATFORM_VENDOR), intel)) {
+                continue;
+            }
+
+            cl_device_id ids[16];
+            cl_uint num_devices = 0;
+            if (clGetDeviceIDs(platforms[i], CL_DEVICE_TYPE_GPU, 16, ids, &num_devices) != CL_SUCCESS) {
+                continue;
+            }
+            if (num_devices > 16) {
+                num_devices = 16;
+            }
+
+            for (cl_uint j = 0; j < num_devices; j++) {
+                OpenCLDevice device;
+                device.platform = platforms[i];
+                device.device = ids[j];
+                device.name = opencl_device_string(ids[j], CL_DEVICE_NAME);
+                device.vendor = intel ? "Intel" : "AMD";
+                cl_bool unified = CL_FALSE;
+                clGetDeviceInfo(ids[j], CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(unified), &unified, nullptr);
+                device.host_unified_memory = unified == CL_TRUE;
+                devices.push_back(device);
+            }
+        }
+    }
+    return devices;
+}
+
+} // namespace
+
+const char* opencl_error_string(cl_int error) {
+    switch (error) {
+        case CL_SUCCESS: return "CL_SUCCESS";
+        case CL_DEVICE_NOT_FOUND: return "CL_DEVICE_NOT_FOUND";
+        case CL_DEVICE_NOT_AVAILABLE: return "CL_DEVICE_NOT_AVAILABLE";
+        case CL_COMPILER_NOT_AVAILABLE: return "CL_COMPILER_NOT_AVAILABLE";
+        case CL_MEM_OBJECT_ALLOCATION_FAILURE: return "CL_MEM_OBJECT_ALLOCATION_FAILURE";
+        case CL_OUT_OF_RESOURCES: return "CL_OUT_OF_RESOURCES";
+        case CL_OUT_OF_HOST_MEMORY: return "CL_OUT_OF_HOST_MEMORY";
+        case CL_MEM_COPY_OVERLAP: return "CL_MEM_COPY_OVERLAP";
+        case CL_BUILD_PROGRAM_FAILURE: return "CL_BUILD_PROGRAM_FAILURE";
+        case CL_MAP_FAILURE: return "CL_MAP_FAILURE";
+        case CL_INVALID_VALUE: return "CL_INVALID_VALUE";
+        case CL_INVALID_DEVICE: return "CL_INVALID_DEVICE";
+        case CL_INVALID_CONTEXT: return "CL_INVALID_CONTEXT";
+        case CL_INVALID_COMMAND_QUEUE: return "CL_INVALID_COMMAND_QUEUE";
+        case CL_INVALID_HOST_PTR: return "CL_INVALID_HOST_PTR";
+        case CL_INVALID_MEM_OBJECT: return "CL_INVALID_MEM_OBJECT";
+        case CL_INVALID_BINARY: return "CL_INVALID_BINARY";
+        case CL_INVALID_BUILD_OPTIONS: return "CL_INVALID_BUILD_OPTIONS";
+        case CL_INVALID_PROGRAM: return "CL_INVALID_PROGRAM";
+        case CL_INVALID_PROGRAM_EXECUTABLE: return "CL_INVALID_PROGRAM_EXECUTABLE";
+        case CL_INVALID_KERNEL_NAME: return "CL_INVALID_KERNEL_NAME";
+        case CL_INVALID_KERNEL: return "CL_INVALID_KERNEL";
+        case CL_INVALID_ARG_INDEX: return "CL_INVALID_ARG_INDEX";
+        case CL_INVALID_ARG_VALUE: return "CL_INVALID_ARG_VALUE";
+        case CL_INVALID_ARG_SIZE: return "CL_INVALID_ARG_SIZE";
+        case CL_INVALID_KERNEL_ARGS: return "CL_INVALID_KERNEL_ARGS";
+        case CL_INVALID_WORK_GROUP_SIZE: return "CL_INVALID_WORK_GROUP_SIZE";
+        case CL_INVALID_GLOBAL_WORK_SIZE: return "CL_INVALID_GLOBAL_WORK_SIZE";
+        case CL_INVALID_EVENT: return "CL_INVALID_EVENT";
+        case CL_INVALID_BUFFER_SIZE: return "CL_INVALID_BUFFER_SIZE";
+        default: return "unknown OpenCL error";
+    }
+}
+
+std::string opencl_device_string(cl_device_id device, cl_device_info param) {
+    char value[1024] = {0};
+    if (clGetDeviceInfo(device, param, sizeof(value) - 1, value, nullptr) != CL_SUCCESS) {
+        return "";
+    }
+    return value;
+}
+
+std::string opencl_platform_string(cl_platform_id platform, cl_platform_info param) {
+    char value[1024] = {0};
+    if (clGetPlatformInfo(platform, param, sizeof(value) - 1, value, nullptr) != CL_SUCCESS) {
+        return "";
+    }
+    return value;
+}
+
+std::vector<OpenCLDevice> opencl_integrated_devices() {
+    // Platform and device handles stay valid for the life of the process,
+    // so the platforms are only walked once
+    static const std::vector<OpenCLDevice> devices = enumerate_integrated_devices();
+    return devices;
+}
+
+cl_program opencl_build_program(cl_context context, const OpenCLDevice& device, const char* source,
+                                const std::string& options, ProgramBinaryCache* cache, bool* from_cache) {
+    if (from_cache) {
+        *from_cache = false;
+    }
+    const ProgramCacheKey key = cache_key(device, source, options);
+
+    // A cached binary still goes through clBuildProgram, which only links it
+    std::vector<unsigned char> binary;
+    if (cache && cache->load(key, binary)) {
+        const unsigned char* data = binary.data();
+        const size_t size = binary.size();
+        cl_int binary_status = CL_SUCCESS;
+        cl_int error = CL_SUCCESS;
+        cl_program program = clCreateProgramWithBinary(context, 1, &device.device, &size, &data,
+                                                       &binary_status, &error);
+        if (error == CL_SUCCESS && binary_status == CL_SUCCESS) {
+            error = clBuildProgram(program, 1, &device.device, options.c_str(), nullptr, nullptr);
+            if (error == CL_SUCCESS) {
+                LOG_DEBUG("Loaded cached OpenCL program for " + device.name);
+                if (from_cache) {
+                    *from_cache = true;
+                }
+                return program;
+            }
+        }
+        if (program) {
+            clReleaseProgram(program);
+        }
+        Logger::warn("Cached OpenCL program rejected by the driver, rebuilding: " + cache->path_for(key));
+        cache->remove(key);
+    }
+
+    cl_int error = CL_SUCCESS;
+    cl_program program = clCreateProgramWithSource(context, 1, &source, nullptr, &error);
+    if (error != CL_SUCCESS) {
+        Logger::error("Failed to create OpenCL program: " + std::string(opencl_error_string(error)));
+        return nullptr;
+    }
+    error = clBuildProgram(program, 1, &device.device, options.c_str(), nullptr, nullptr);
+    if (error != CL_SUCCESS) {
+        Logger::error("OpenCL program build failed for " + device.name + ": " +
+                      std::string(opencl_error_string(error)) + "\n" + build_log(program, device.device));
+        clReleaseProgram(program);
+        return nullptr;
+    }
+
+    if (cache) {
+        if (program_binary(program, binary) && cache->store(key, binary)) {
+            LOG_DEBUG("Cached OpenCL program binary: " + cache->path_for(key));
+        } else if (!cache->get_last_error().empty()) {
+            Logger::warn(cache->get_last_error());
+        }
+    }
+    return program;
+}
+
+#endif // ENABLE_OPENCL
@@ -0,0 +1,84 @@
+#include "gpu/thermal_governor.h"
+#include <algorithm>
+
+namespace {
+
+// Weight of the newest control step in the sustained rate
+constexpr double RATE_SMOOTHING = 0.25;
+
+// Power draw below this share of the limit counts as headroom
+constexpr float POWER_HEADROOM = 0.95f;
+
+} // namespace
+
+double ThermalSetting::idle_after(double busy_seconds) const {
+    if (duty_cycle >= 1.0 || busy_seconds <= 0.0) {
+        return 0.0;
+    }
+    return busy_seconds * (1.0 - duty_cycle) / duty_cycle;
+}
+
+ThermalGovernor::ThermalGovernor(const ThermalLimits& limits)
+    : target_c_((limits.throttle_temperature_c > 0.0f ? limits.throttle_temperature_c : DEFAULT_THROTTLE_C) -
+                limits.margin_c),
+      power_limit_w_(limits.power_limit_w) {}
+
+void ThermalGovernor::record(uint64_t candidates) {
+    candidates_ += candidates;
+}
+
+bool ThermalGovernor::due(double now) const {
+    return !started_ || now - last_step_ >= SAMPLE_INTERVAL;
+}
+
+ThermalSetting ThermalGovernor::setting_for(double level) {
+    level = std::min(1.0, std::max(MIN_LEVEL, level));
+    ThermalSetting setting;
+    if (level >= OCCUPANCY_FLOOR) {
+        setting.occupancy = level;
+        return setting;
+    }
+    // Below the floor the device idles between batches instead, so the
+    // delivered work stays proportional to the level
+    setting.occupancy = OCCUPANCY_FLOOR;
+    setting.duty_cycle = level / OCCUPANCY_FLOOR;
+    setting.batch_fraction = setting.duty_cycle;
+    return setting;
+}
+
+bool ThermalGovernor::update(const GpuSensorReading& reading, double now) {
+    if (started_ && now > last_step_) {
+        const double rate = candidates_ / (now - last_step_);
+        sustained_rate_ = sustained_rate_ > 0.0 ? sustained_rate_ + RATE_SMOOTHING * (rate - sustained_rate_) : rate;
+    }
+    started_ = true;
+    last_step_ = now;
+    candidates_ = 0;
+
+    const bool has_temperature = reading.temperature_c >= 0.0f;
+    const bool has_power = reading.power_w >= 0.0f && power_limit_w_ > 0.0f;
+    if (!has_temperature && !has_power) {
+        limiting_ = false;
+        return false;
+    }
+
+    const bool hot = reading.thermal_throttling || reading.power_throttling ||
+                     (has_temperature && reading.temperature_c > target_c_) ||
+                     (has_power && reading.power_w > power_limit_w_);
+    const bool cool = !hot && (!has_temperature || reading.temperature_c < target_c_ - HEADROOM_C) &&
+                      (!has_power || reading.power_w < power_limit_w_ * POWER_HEADROOM);
+    limiting_ = hot;
+
+    double level = level_;
+    if (hot) {
+        level = std::max(MIN_LEVEL, level_ * DECREASE);
+    } else if (cool) {
+        level = std::min(1.0, level_ + INCREASE);
+    }
+    if (level == level_) {
+        return false;
+    }
+    level_ = level;
+    setting_ = setting_for(level_);
+    return true;
+}
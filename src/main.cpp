@@ -3,12 +3,23 @@
 #include <vector>
 #include <memory>
 #include <chrono>
+#include <set>
 #include <getopt.h>
 
+#include "core/benchmark.h"
+#include "core/checkpoint.h"
+#include "core/mask_generator.h"
+#include "core/tested_candidates.h"
 #include "core/recovery_engine.h"
 #include "core/config_manager.h"
 #include "utils/logger.h"
 
+#ifdef ENABLE_CLUSTER
+#include "cluster/cluster_coordinator.h"
+#include "cluster/cluster_settings.h"
+#include "cluster/metrics_server.h"
+#endif
+
 void print_usage(const char* program_name) {
     std::cout << "Bitcoin Wallet Password Recovery System\n\n";
     std::cout << "Usage: " << program_name << " [OPTIONS]\n\n";
@@ -21,7 +32,9 @@ void print_usage(const char* program_name) {
     std::cout << "  -m, --min-length N        Minimum password length (default: 1)\n";
     std::cout << "  -M, --max-length N        Maximum password length (default: 12)\n";
     std::cout << "  -p, --prefix STRING       Password prefix\n";
-    std::cout << "  -s, --suffix STRING       Password suffix\n\n";
+    std::cout << "  -s, --suffix STRING       Password suffix\n";
+    std::cout << "      --markov FILE         Brute-force most probable candidates first, using per-position\n";
+    std::cout << "                            Markov chains trained on FILE (a wordlist or known fragments)\n\n";
     std::cout << "Performance Options:\n";
     std::cout << "  -t, --threads N           Number of CPU threads (default: auto)\n";
     std::cout << "  -g, --gpu                 Enable GPU acceleration\n";
@@ -30,7 +43,25 @@ void print_usage(const char* program_name) {
     std::cout << "Output Options:\n";
     std::cout << "  -o, --output FILE         Output file for results\n";
     std::cout << "  -l, --log-level LEVEL     Log level (debug, info, warn, error)\n";
-    std::cout << "  -q, --quiet               Suppress progress output\n\n";
+    std::cout << "  -q, --quiet               Suppress progress output\n";
+    std::cout << "  -P, --metrics-port N      Serve Prometheus metrics at http://HOST:N/metrics\n\n";
+    std::cout << "Tested Candidates:\n";
+    std::cout << "  -T, --tested-dir DIR      Skip candidates earlier runs tested on this wallet; one index\n";
+    std::cout << "                            per wallet salt and iterations (default: ~/.local/share/btc-recovery/tested)\n";
+    std::cout << "      --retest              Test every candidate without reading or updating the index\n\n";
+    std::cout << "Cluster Options:\n";
+    std::cout << "  -X, --cluster FILE        Join the cluster described by FILE (config/cluster.yaml)\n";
+    std::cout << "  -O, --coordinator         Lease the keyspace to cluster nodes instead of searching it\n";
+    std::cout << "  -n, --node-id N           Node id, overriding the cluster file\n";
+    std::cout << "  -K, --checkpoint FILE     Coordinator checkpoint, saved every progress_sync_interval\n";
+    std::cout << "                            (default: WALLET.checkpoint)\n";
+    std::cout << "  -R, --resume              Coordinator only: continue from the checkpoint file\n\n";
+    std::cout << "Benchmark:\n";
+    std::cout << "  -B, --benchmark           Measure candidates/s per backend on synthetic wallets, no -w needed;\n";
+    std::cout << "                            uses -t, -b and -o (JSON report, default: standard output)\n";
+    std::cout << "      --iterations LIST     PBKDF2 iteration counts to benchmark (default: 25000,100000)\n";
+    std::cout << "      --backend LIST        cpu-scalar, cpu-avx2, cpu-avx512, cuda, opencl, cpu-scrypt,\n";
+    std::cout << "                            cpu-scrypt-tmto (default: all available)\n\n";
     std::cout << "Configuration:\n";
     std::cout << "  -C, --config FILE         Configuration file\n";
     std::cout << "  -h, --help                Show this help message\n";
@@ -39,7 +70,68 @@ void print_usage(const char* program_name) {
     std::cout << "  " << program_name << " -w wallet.dat -c lowercase -m 6 -M 10\n";
     std::cout << "  " << program_name << " -w wallet.dat -d passwords.txt -r common.rules\n";
     std::cout << "  " << program_name << " -w wallet.dat -c mixed -g -t 8 -G 2048\n";
+    std::cout << "  " << program_name << " -w wallet.dat -c lowercase -M 8 -X cluster.yaml -O\n";
+    std::cout << "  " << program_name << " -B --iterations 25000,100000 -o bench.json\n";
+}
+
+// Keyspace settings after the command line is merged over the configuration
+// file; cluster workers fingerprint the same fields through the engine
+BruteForceSearch brute_force_search(const ConfigManager& config) {
+    BruteForceSearch search;
+    search.charset = config.get_charset();
+    search.custom_charset = config.get_custom_charset();
+    search.min_length = config.get_min_length();
+    search.max_length = config.get_max_length();
+    search.prefix = config.get_prefix();
+    search.suffix = config.get_suffix();
+    search.markov_file = config.get_markov_file();
+    return search;
+}
+
+#ifdef ENABLE_CLUSTER
+int run_coordinator(const ClusterSettings& settings, const std::string& wallet_file,
+                    const BruteForceSearch& search, const std::string& checkpoint_file, bool resume) {
+    MaskGenerator keyspace;
+    if (!keyspace.add_charset_range(search.charset, search.custom_charset, search.min_length, search.max_length,
+                                    search.prefix, search.suffix)) {
+        Logger::error("Cannot build the cluster keyspace: " + keyspace.get_last_error());
+        return 1;
+    }
+    // The order does not change the keyspace size, only which leases hold which
+    // candidates, so the model only goes into the fingerprint
+    std::string error;
+    const std::string fingerprint = Checkpoint::fingerprint(wallet_file, search, error);
+    if (fingerprint.empty()) {
+        Logger::error(error);
+        return 1;
+    }
+
+    Checkpoint checkpoint(checkpoint_file, settings.progress_sync_interval);
+    CheckpointState state;
+    if (resume) {
+        if (!checkpoint.load(state)) {
+            Logger::error(checkpoint.get_last_error());
+            return 1;
+        }
+        if (state.fingerprint != fingerprint) {
+            Logger::error("Checkpoint " + checkpoint_file + " belongs to a different wallet or search");
+            return 1;
+        }
+    }
+
+    ClusterCoordinator coordinator(settings);
+    if (!coordinator.start({0, keyspace.size()}, fingerprint, state.completed)) {
+        return 1;
+    }
+    if (coordinator.run(&checkpoint)) {
+        Logger::info("Password found: " + coordinator.get_found_password());
+        checkpoint.remove();
+        return 0;
+    }
+    Logger::info("Cluster search completed without finding the password");
+    return 2;
 }
+#endif
 
 void print_version() {
     std::cout << "Bitcoin Wallet Password Recovery System v1.0.0\n";
@@ -56,6 +148,14 @@ void print_version() {
 #endif
 }
 
+// Options without a short form
+enum LongOnlyOption {
+    OPTION_ITERATIONS = 1000,
+    OPTION_BACKEND,
+    OPTION_RETEST,
+    OPTION_MARKOV
+};
+
 int main(int argc, char* argv[]) {
     // Command line options
     struct option long_options[] = {
@@ -67,6 +167,7 @@ int main(int argc, char* argv[]) {
         {"max-length", required_argument, 0, 'M'},
         {"prefix", required_argument, 0, 'p'},
         {"suffix", required_argument, 0, 's'},
+        {"markov", required_argument, 0, OPTION_MARKOV},
         {"threads", required_argument, 0, 't'},
         {"gpu", no_argument, 0, 'g'},
         {"gpu-threads", required_argument, 0, 'G'},
@@ -74,6 +175,17 @@ int main(int argc, char* argv[]) {
         {"output", required_argument, 0, 'o'},
         {"log-level", required_argument, 0, 'l'},
         {"quiet", no_argument, 0, 'q'},
+        {"metrics-port", required_argument, 0, 'P'},
+        {"checkpoint", required_argument, 0, 'K'},
+        {"resume", no_argument, 0, 'R'},
+        {"tested-dir", required_argument, 0, 'T'},
+        {"retest", no_argument, 0, OPTION_RETEST},
+        {"cluster", required_argument, 0, 'X'},
+        {"coordinator", no_argument, 0, 'O'},
+        {"node-id", required_argument, 0, 'n'},
+        {"benchmark", no_argument, 0, 'B'},
+        {"iterations", required_argument, 0, OPTION_ITERATIONS},
+        {"backend", required_argument, 0, OPTION_BACKEND},
         {"config", required_argument, 0, 'C'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},
@@ -91,6 +203,7 @@ int main(int argc, char* argv[]) {
     int max_length = 12;
     std::string prefix;
     std::string suffix;
+    std::string markov_file;
     int threads = 0; // 0 = auto-detect
     bool use_gpu = false;
     int gpu_threads = 1024;
@@ -98,13 +211,29 @@ int main(int argc, char* argv[]) {
     std::string output_file;
     std::string log_level = "info";
     bool quiet = false;
+    int metrics_port = -1; // -1 = from the cluster file, if any
+    std::string checkpoint_file;
+    bool resume = false;
+    std::string tested_directory;
+    bool retest = false;
+    std::string cluster_file;
+    bool coordinator = false;
+    int node_id = -1;
+    bool benchmark = false;
+    bool batch_size_set = false;
+    std::string benchmark_iterations;
+    std::string benchmark_backends;
     std::string config_file;
 
+    // Options given on the command line override the configuration file
+    std::set<int> options_given;
+
     int option_index = 0;
     int c;
     
-    while ((c = getopt_long(argc, argv, "w:c:d:r:m:M:p:s:t:gG:b:o:l:qC:hv", 
+    while ((c = getopt_long(argc, argv, "w:c:d:r:m:M:p:s:t:gG:b:o:l:qP:K:RT:X:On:BC:hv", 
                            long_options, &option_index)) != -1) {
+        options_given.insert(c);
         switch (c) {
             case 'w': wallet_file = optarg; break;
             case 'c': charset = optarg; break;
@@ -114,13 +243,25 @@ int main(int argc, char* argv[]) {
             case 'M': max_length = std::stoi(optarg); break;
             case 'p': prefix = optarg; break;
             case 's': suffix = optarg; break;
+            case OPTION_MARKOV: markov_file = optarg; break;
             case 't': threads = std::stoi(optarg); break;
             case 'g': use_gpu = true; break;
             case 'G': gpu_threads = std::stoi(optarg); break;
-            case 'b': batch_size = std::stoi(optarg); break;
+            case 'b': batch_size = std::stoi(optarg); batch_size_set = true; break;
             case 'o': output_file = optarg; break;
             case 'l': log_level = optarg; break;
             case 'q': quiet = true; break;
+            case 'P': metrics_port = std::stoi(optarg); break;
+            case 'K': checkpoint_file = optarg; break;
+            case 'R': resume = true; break;
+            case 'T': tested_directory = optarg; break;
+            case OPTION_RETEST: retest = true; break;
+            case 'X': cluster_file = optarg; break;
+            case 'O': coordinator = true; break;
+            case 'n': node_id = std::stoi(optarg); break;
+            case 'B': benchmark = true; break;
+            case OPTION_ITERATIONS: benchmark_iterations = optarg; break;
+            case OPTION_BACKEND: benchmark_backends = optarg; break;
             case 'C': config_file = optarg; break;
             case 'h': print_usage(argv[0]); return 0;
             case 'v': print_version(); return 0;
@@ -129,38 +270,136 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    // The benchmark brings its own synthetic wallets
+    if (benchmark) {
+        BenchmarkOptions options;
+        options.threads = threads;
+        std::string error;
+        if (!parse_benchmark_lists(benchmark_iterations, batch_size_set ? std::to_string(batch_size) : "",
+                                   benchmark_backends, options, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+        // Without a report file stdout carries only the JSON
+        Logger::initialize(log_level, !quiet && !output_file.empty(), "");
+        return run_benchmark_mode(options, output_file);
+    }
+
+    // Load configuration file if specified; the coordinator and the engine
+    // both work from the merged settings, so cluster nodes given the same
+    // file agree on the search
+    if (!config_file.empty() && !config->load_config(config_file)) {
+        std::cerr << "Error: Cannot load configuration file " << config_file << "\n";
+        return 1;
+    }
+    auto given = [&](int option) { return options_given.count(option) > 0; };
+    if (given('w')) config->set_wallet_file(wallet_file);
+    if (given('c')) config->set_charset(charset);
+    if (given('d')) config->set_dictionary_file(dictionary_file);
+    if (given('r')) config->set_rules_file(rules_file);
+    if (given('m')) config->set_min_length(min_length);
+    if (given('M')) config->set_max_length(max_length);
+    if (given('p')) config->set_prefix(prefix);
+    if (given('s')) config->set_suffix(suffix);
+    if (given(OPTION_MARKOV)) config->set_markov_file(markov_file);
+    if (given('t')) config->set_threads(threads);
+    if (given('g')) config->set_use_gpu(use_gpu);
+    if (given('G')) config->set_gpu_threads(gpu_threads);
+    if (given('b')) config->set_batch_size(batch_size);
+    if (given('o')) config->set_output_file(output_file);
+    if (given('K')) config->set_checkpoint_file(checkpoint_file);
+    if (given('R')) config->set_resume(resume);
+
     // Validate required arguments
+    wallet_file = config->get_wallet_file();
     if (wallet_file.empty()) {
-        std::cerr << "Error: Wallet file is required\n";
+        std::cerr << "Error: Wallet file is required (-w or wallet_file in the configuration file)\n";
         print_usage(argv[0]);
         return 1;
     }
 
-    // Initialize logger
-    Logger::initialize(log_level, !quiet);
+    checkpoint_file = config->get_checkpoint_file();
+    if (checkpoint_file.empty()) {
+        checkpoint_file = wallet_file + ".checkpoint";
+        config->set_checkpoint_file(checkpoint_file);
+    }
+    resume = config->get_resume();
+
+    if ((coordinator || node_id >= 0) && cluster_file.empty()) {
+        std::cerr << "Error: --coordinator and --node-id need a cluster file (--cluster)\n";
+        return 1;
+    }
+
+    // Only the coordinator saves checkpoints, so a single-node search has
+    // nothing to continue from
+    if (!coordinator && (resume || given('K'))) {
+        std::cerr << "Error: --checkpoint and --resume need --coordinator; single-node runs are not checkpointed\n";
+        return 1;
+    }
+
+    // Initialize logger; workers only queue records, pending ones are
+    // written when the logger is destroyed at exit
+    Logger::initialize(log_level, !quiet, "", true);
     Logger::info("Bitcoin Wallet Password Recovery System v1.0.0");
     Logger::info("Starting recovery process...");
 
     try {
-        // Load configuration file if specified
-        if (!config_file.empty()) {
-            config->load_config(config_file);
+#ifdef ENABLE_CLUSTER
+        ClusterSettings cluster;
+        MetricsServer metrics_server;
+#endif
+        if (!cluster_file.empty()) {
+#ifdef ENABLE_CLUSTER
+            if (!cluster.load_file(cluster_file)) {
+                return 1;
+            }
+            if (node_id >= 0) {
+                cluster.node_id = node_id;
+            }
+            if (metrics_port < 0 && cluster.monitoring_enabled) {
+                metrics_port = cluster.metrics_port;
+            }
+#else
+            Logger::error("Cluster mode is not supported on this platform");
+            return 1;
+#endif
+        }
+
+        // A metrics endpoint that cannot bind is not worth failing the run for
+        if (metrics_port >= 0) {
+#ifdef ENABLE_CLUSTER
+            if (metrics_port > 65535 || !metrics_server.start(static_cast<uint16_t>(metrics_port))) {
+                Logger::warn(metrics_port > 65535 ? "Invalid metrics port" : metrics_server.get_last_error());
+            }
+#else
+            Logger::warn("The metrics endpoint is not supported on this platform");
+#endif
         }
 
-        // Set configuration parameters
-        config->set_wallet_file(wallet_file);
-        config->set_charset(charset);
-        config->set_dictionary_file(dictionary_file);
-        config->set_rules_file(rules_file);
-        config->set_min_length(min_length);
-        config->set_max_length(max_length);
-        config->set_prefix(prefix);
-        config->set_suffix(suffix);
-        config->set_threads(threads);
-        config->set_use_gpu(use_gpu);
-        config->set_gpu_threads(gpu_threads);
-        config->set_batch_size(batch_size);
-        config->set_output_file(output_file);
+#ifdef ENABLE_CLUSTER
+        if (coordinator) {
+            if (!config->get_dictionary_file().empty()) {
+                Logger::error("The cluster coordinator only distributes brute-force keyspaces");
+                return 1;
+            }
+            return run_coordinator(cluster, wallet_file, brute_force_search(*config), checkpoint_file, resume);
+        }
+#endif
+
+        // The engine opens the index once it has read the wallet's salt and iterations
+        config->set_skip_tested(!retest);
+        config->set_tested_directory(tested_directory.empty() ? TestedCandidateIndex::default_directory()
+                                                              : tested_directory);
+#ifdef ENABLE_CLUSTER
+        if (!cluster_file.empty()) {
+            // The engine leases its keyspace from the coordinator instead
+            // of searching it all
+            config->set_cluster_mode(true);
+            config->set_cluster_node_id(cluster.node_id);
+            config->set_cluster_total_nodes(cluster.total_nodes);
+            config->set_cluster_config_file(cluster_file);
+        }
+#endif
 
         // Create and run recovery engine
         RecoveryEngine engine(config);
@@ -0,0 +1,56 @@
+// AES-NI single-block AES-256 decryption.
+// This file is compiled with -maes and only entered after a runtime check.
+
+#include <cstdint>
+#include <wmmintrin.h>
+
+namespace {
+
+inline __m128i expand_even(__m128i key, __m128i assist) {
+    assist = _mm_shuffle_epi32(assist, 0xff);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+}
+
+inline __m128i expand_odd(__m128i key, __m128i assist) {
+    assist = _mm_shuffle_epi32(assist, 0xaa);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+}
+
+} // namespace
+
+void aes256_decrypt_last_block_aesni(const uint8_t* key, const uint8_t* previous_block,
+                                     const uint8_t* last_block, uint8_t* plaintext) {
+    __m128i rk[15];
+    rk[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+    rk[1] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + 16));
+
+    // The round constant must be an immediate, hence the unrolled schedule
+#define AES256_EXPAND(i, rcon) \
+    rk[i] = expand_even(rk[i - 2], _mm_aeskeygenassist_si128(rk[i - 1], rcon)); \
+    rk[i + 1] = expand_odd(rk[i - 1], _mm_aeskeygenassist_si128(rk[i], 0x00));
+    AES256_EXPAND(2, 0x01)
+    AES256_EXPAND(4, 0x02)
+    AES256_EXPAND(6, 0x04)
+    AES256_EXPAND(8, 0x08)
+    AES256_EXPAND(10, 0x10)
+    AES256_EXPAND(12, 0x20)
+    rk[14] = expand_even(rk[12], _mm_aeskeygenassist_si128(rk[13], 0x40));
+#undef AES256_EXPAND
+
+    // Equivalent inverse cipher: middle round keys go through InvMixColumns
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(last_block));
+    block = _mm_xor_si128(block, rk[14]);
+    for (int round = 13; round >= 1; round--) {
+        block = _mm_aesdec_si128(block, _mm_aesimc_si128(rk[round]));
+    }
+    block = _mm_aesdeclast_si128(block, rk[0]);
+
+    block = _mm_xor_si128(block, _mm_loadu_si128(reinterpret_cast<const __m128i*>(previous_block)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(plaintext), block);
+}
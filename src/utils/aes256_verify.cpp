@@ -0,0 +1,38 @@
+#include "utils/aes256_verify.h"
+#include "utils/aes256_block.h"
+
+#ifdef ENABLE_AES_NI
+// Provided by aes256_aesni.cpp
+void aes256_decrypt_last_block_aesni(const uint8_t* key, const uint8_t* previous_block,
+                                     const uint8_t* last_block, uint8_t* plaintext);
+#endif
+
+bool AES256Verifier::has_aes_ni() {
+#if defined(ENABLE_AES_NI) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    static const bool supported = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("aes") != 0;
+    }();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+void AES256Verifier::decrypt_last_block(const uint8_t* key, const uint8_t* previous_block,
+                                        const uint8_t* last_block, uint8_t* plaintext) {
+#ifdef ENABLE_AES_NI
+    if (has_aes_ni()) {
+        aes256_decrypt_last_block_aesni(key, previous_block, last_block, plaintext);
+        return;
+    }
+#endif
+    aes256_cbc_decrypt_last_block(key, previous_block, last_block, plaintext);
+}
+
+bool AES256Verifier::check_last_block(const uint8_t* key, const uint8_t* previous_block,
+                                      const uint8_t* last_block, uint8_t expected_padding) {
+    uint8_t plaintext[16];
+    decrypt_last_block(key, previous_block, last_block, plaintext);
+    return pkcs7_padding_valid(plaintext, expected_padding);
+}
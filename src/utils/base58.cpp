@@ -0,0 +1,83 @@
+#include "utils/base58.h"
+#include <cstring>
+#include <vector>
+#include <openssl/sha.h>
+
+namespace {
+
+const char* BASE58_ALPHABET = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+// Work in base 58^5 limbs and feed four input bytes per step, which cuts the
+// inner loop by roughly 20x against one-byte, one-digit long division
+constexpr uint32_t LIMB_BASE = 58u * 58u * 58u * 58u * 58u;
+constexpr int LIMB_DIGITS = 5;
+
+} // namespace
+
+std::string Base58::encode(const uint8_t* data, size_t length) {
+    size_t leading_zeros = 0;
+    while (leading_zeros < length && data[leading_zeros] == 0) {
+        leading_zeros++;
+    }
+
+    // log(256)/log(58^5) ~ 0.273 limbs per byte
+    std::vector<uint32_t> limbs;
+    limbs.reserve((length - leading_zeros) * 28 / 100 + 2);
+
+    size_t i = leading_zeros;
+    while (i < length) {
+        // Leading chunk takes the remainder so later chunks are exactly four bytes
+        size_t chunk = (length - i) % 4;
+        if (chunk == 0) chunk = 4;
+        uint64_t carry = 0;
+        for (size_t b = 0; b < chunk; b++) {
+            carry = (carry << 8) | data[i + b];
+        }
+        const uint64_t shift = uint64_t(1) << (8 * chunk);
+        i += chunk;
+
+        for (uint32_t& limb : limbs) {
+            carry += uint64_t(limb) * shift;
+            limb = static_cast<uint32_t>(carry % LIMB_BASE);
+            carry /= LIMB_BASE;
+        }
+        while (carry > 0) {
+            limbs.push_back(static_cast<uint32_t>(carry % LIMB_BASE));
+            carry /= LIMB_BASE;
+        }
+    }
+
+    // Expand limbs to digits, least significant first
+    std::vector<char> digits;
+    digits.reserve(limbs.size() * LIMB_DIGITS);
+    for (uint32_t limb : limbs) {
+        for (int d = 0; d < LIMB_DIGITS; d++) {
+            digits.push_back(static_cast<char>(limb % 58));
+            limb /= 58;
+        }
+    }
+    while (!digits.empty() && digits.back() == 0) {
+        digits.pop_back();
+    }
+
+    std::string result(leading_zeros, '1');
+    result.reserve(leading_zeros + digits.size());
+    for (auto it = digits.rbegin(); it != digits.rend(); ++it) {
+        result += BASE58_ALPHABET[static_cast<int>(*it)];
+    }
+    return result;
+}
+
+std::string Base58::encode_check(const uint8_t* payload, size_t length) {
+    if (length > MAX_CHECK_PAYLOAD) {
+        return "";
+    }
+
+    uint8_t buffer[MAX_CHECK_PAYLOAD + 4];
+    uint8_t hash[SHA256_DIGEST_LENGTH];
+    std::memcpy(buffer, payload, length);
+    SHA256(payload, length, hash);
+    SHA256(hash, SHA256_DIGEST_LENGTH, hash);
+    std::memcpy(buffer + length, hash, 4);
+    return encode(buffer, length + 4);
+}
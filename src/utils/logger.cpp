@@ -1,75 +1,301 @@
 #include "utils/logger.h"
+#include <algorithm>
+#include <condition_variable>
+#include <ctime>
 #include <iostream>
-#include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <thread>
+
+namespace {
+
+// Records one thread can queue before it has to wait for the writer
+const size_t RING_CAPACITY = 1024;
+
+// Longest a record waits in its ring when nobody asks for a flush
+const std::chrono::milliseconds WRITE_INTERVAL(50);
+
+/**
+ * Bounded single-producer, single-consumer queue
+ *
+ * The producer only writes head_ and the consumer only writes tail_, so
+ * neither side ever takes a lock.
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+public:
+    SpscRing() : slots_(new T[Capacity]) {}
+
+    /**
+     * @return false if the ring is full; value is left untouched then
+     */
+    bool try_push(T&& value) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        slots_[head % Capacity] = std::move(value);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Move everything queued so far to the back of out
+     */
+    template <typename Container>
+    void drain(Container& out) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        for (; tail != head; tail++) {
+            out.push_back(std::move(slots_[tail % Capacity]));
+        }
+        tail_.store(tail, std::memory_order_release);
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    // Set by the producer thread when it exits
+    std::atomic<bool> closed{false};
+
+private:
+    std::unique_ptr<T[]> slots_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+std::atomic<uint64_t> next_sink_id{1};
+
+} // namespace
+
+/**
+ * Background writer behind Logger's asynchronous mode
+ *
+ * Every logging thread gets its own ring on first use. The writer wakes
+ * every WRITE_INTERVAL, or when a flush is requested or a ring fills up,
+ * drains all rings, restores the time order across threads and hands the
+ * batch to Logger::write_records.
+ */
+class AsyncLogSink {
+public:
+    explicit AsyncLogSink(Logger& owner)
+        : owner_(owner), id_(next_sink_id.fetch_add(1)), flush_requested_(0), flushed_(0), stop_(false),
+          ring_full_(false), writer_(&AsyncLogSink::run, this) {}
+
+    ~AsyncLogSink() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        writer_.join();
+
+        // Whatever was queued while the writer stopped
+        std::vector<Logger::Record> records;
+        for (auto& ring : rings_) {
+            ring->drain(records);
+        }
+        write(records);
+    }
+
+    AsyncLogSink(const AsyncLogSink&) = delete;
+    AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+    void push(Logger::Record&& record) {
+        Ring& ring = thread_ring();
+        while (!ring.try_push(std::move(record))) {
+            // Full: wake the writer and wait for it rather than drop diagnostics
+            ring_full_.store(true, std::memory_order_release);
+            wake_.notify_one();
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * Wait until every record pushed before the call is written
+     */
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (stop_) {
+            return;
+        }
+        const uint64_t target = ++flush_requested_;
+        wake_.notify_one();
+        written_.wait(lock, [&] { return flushed_ >= target || stop_; });
+    }
+
+private:
+    using Ring = SpscRing<Logger::Record, RING_CAPACITY>;
+
+    // Ring of the calling thread; marked closed when the thread exits
+    struct ThreadRing {
+        uint64_t sink_id = 0;
+        std::shared_ptr<Ring> ring;
+
+        ~ThreadRing() {
+            if (ring) {
+                ring->closed.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    Logger& owner_;
+    const uint64_t id_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable written_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+    uint64_t flush_requested_;
+    uint64_t flushed_;
+    bool stop_;
+    std::atomic<bool> ring_full_;   // Set by a producer waiting on a full ring
+    std::thread writer_;
+
+    Ring& thread_ring() {
+        thread_local ThreadRing local;
+        if (!local.ring || local.sink_id != id_) {
+            // First record from this thread, or the logger was re-initialized
+            if (local.ring) {
+                local.ring->closed.store(true, std::memory_order_release);
+            }
+            local.ring = std::make_shared<Ring>();
+            local.sink_id = id_;
+            std::lock_guard<std::mutex> lock(mutex_);
+            rings_.push_back(local.ring);
+        }
+        return *local.ring;
+    }
+
+    void write(std::vector<Logger::Record>& records) {
+        if (records.empty()) {
+            return;
+        }
+        // Rings are drained one after another; put the threads back in time order
+        std::stable_sort(records.begin(), records.end(),
+                         [](const Logger::Record& a, const Logger::Record& b) { return a.time < b.time; });
+        owner_.write_records(records);
+        records.clear();
+    }
+
+    void run() {
+        std::vector<Logger::Record> records;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait_for(lock, WRITE_INTERVAL, [this] {
+                return stop_ || flush_requested_ > flushed_ || ring_full_.load(std::memory_order_acquire);
+            });
+            // Cleared before draining, so a ring that fills again meanwhile wakes the next round
+            ring_full_.store(false, std::memory_order_relaxed);
+            const uint64_t target = flush_requested_;
+            const bool stopping = stop_;
+            const std::vector<std::shared_ptr<Ring>> rings = rings_;
+            lock.unlock();
+
+            for (const auto& ring : rings) {
+                ring->drain(records);
+            }
+            write(records);
+
+            lock.lock();
+            // Rings of exited threads are dropped once empty; closed is
+            // read first so a final record is never missed
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::shared_ptr<Ring>& ring) {
+                             return ring->closed.load(std::memory_order_acquire) && ring->empty();
+                         }), rings_.end());
+            flushed_ = target;
+            written_.notify_all();
+            if (stopping) {
+                break;
+            }
+        }
+    }
+};
 
 std::unique_ptr<Logger> Logger::instance_ = nullptr;
+std::atomic<Logger*> Logger::current_{nullptr};
+std::atomic<LogLevel> Logger::level_{LogLevel::INFO};
 std::mutex Logger::mutex_;
 
-Logger::Logger() : current_level_(LogLevel::INFO), console_output_(true) {}
+Logger::Logger() : console_output_(true) {}
 
 Logger::~Logger() {
+    // The writer still uses the streams until it has drained
+    async_sink_.reset();
     if (log_file_.is_open()) {
         log_file_.close();
     }
 }
 
 Logger& Logger::get_instance() {
+    Logger* logger = current_.load(std::memory_order_acquire);
+    if (logger) {
+        return *logger;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     if (!instance_) {
         instance_ = std::unique_ptr<Logger>(new Logger());
+        current_.store(instance_.get(), std::memory_order_release);
     }
     return *instance_;
 }
 
-void Logger::initialize(const std::string& level, bool console_output, const std::string& log_file) {
+void Logger::initialize(const std::string& level, bool console_output, const std::string& log_file, bool async) {
     auto& logger = get_instance();
-    std::lock_guard<std::mutex> lock(logger.log_mutex_);
-    
-    logger.set_level(level);
-    logger.console_output_ = console_output;
-    
-    if (!log_file.empty()) {
-        logger.log_file_path_ = log_file;
-        logger.log_file_.open(log_file, std::ios::app);
-        if (!logger.log_file_.is_open()) {
-            std::cerr << "Warning: Could not open log file: " << log_file << std::endl;
+
+    // Outside log_mutex_: the writer takes it for every batch
+    if (!async) {
+        logger.async_sink_.reset();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(logger.log_mutex_);
+        level_.store(logger.string_to_level(level), std::memory_order_relaxed);
+        logger.console_output_ = console_output;
+
+        if (!log_file.empty()) {
+            logger.log_file_path_ = log_file;
+            logger.log_file_.open(log_file, std::ios::app);
+            if (!logger.log_file_.is_open()) {
+                std::cerr << "Warning: Could not open log file: " << log_file << std::endl;
+            }
         }
     }
+
+    if (async && !logger.async_sink_) {
+        logger.async_sink_.reset(new AsyncLogSink(logger));
+    }
 }
 
-void Logger::debug(const std::string& message) {
-    log(LogLevel::DEBUG, message);
+void Logger::debug(std::string message) {
+    log(LogLevel::DEBUG, std::move(message));
 }
 
-void Logger::info(const std::string& message) {
-    log(LogLevel::INFO, message);
+void Logger::info(std::string message) {
+    log(LogLevel::INFO, std::move(message));
 }
 
-void Logger::warn(const std::string& message) {
-    log(LogLevel::WARN, message);
+void Logger::warn(std::string message) {
+    log(LogLevel::WARN, std::move(message));
 }
 
-void Logger::error(const std::string& message) {
-    log(LogLevel::ERROR, message);
+void Logger::error(std::string message) {
+    log(LogLevel::ERROR, std::move(message));
 }
 
-void Logger::log(LogLevel level, const std::string& message) {
-    auto& logger = get_instance();
-    logger.write_log(level, message);
+void Logger::log(LogLevel level, std::string message) {
+    if (!enabled(level)) {
+        return;
+    }
+    get_instance().write_log(level, std::move(message));
 }
 
 void Logger::set_level(LogLevel level) {
-    auto& logger = get_instance();
-    std::lock_guard<std::mutex> lock(logger.log_mutex_);
-    logger.current_level_ = level;
+    level_.store(level, std::memory_order_relaxed);
 }
 
 void Logger::set_level(const std::string& level) {
-    auto& logger = get_instance();
-    std::lock_guard<std::mutex> lock(logger.log_mutex_);
-    logger.current_level_ = logger.string_to_level(level);
+    level_.store(get_instance().string_to_level(level), std::memory_order_relaxed);
 }
 
 void Logger::set_console_output(bool enabled) {
@@ -81,11 +307,11 @@ void Logger::set_console_output(bool enabled) {
 void Logger::set_log_file(const std::string& file_path) {
     auto& logger = get_instance();
     std::lock_guard<std::mutex> lock(logger.log_mutex_);
-    
+
     if (logger.log_file_.is_open()) {
         logger.log_file_.close();
     }
-    
+
     logger.log_file_path_ = file_path;
     if (!file_path.empty()) {
         logger.log_file_.open(file_path, std::ios::app);
@@ -97,13 +323,17 @@ void Logger::set_log_file(const std::string& file_path) {
 
 void Logger::flush() {
     auto& logger = get_instance();
+    if (logger.async_sink_) {
+        logger.async_sink_->flush();
+    }
+
     std::lock_guard<std::mutex> lock(logger.log_mutex_);
-    
+
     if (logger.console_output_) {
         std::cout.flush();
         std::cerr.flush();
     }
-    
+
     if (logger.log_file_.is_open()) {
         logger.log_file_.flush();
     }
@@ -112,25 +342,33 @@ void Logger::flush() {
 void Logger::shutdown() {
     std::lock_guard<std::mutex> lock(mutex_);
     if (instance_) {
-        std::lock_guard<std::mutex> log_lock(instance_->log_mutex_);
-        if (instance_->log_file_.is_open()) {
-            instance_->log_file_.close();
+        current_.store(nullptr, std::memory_order_release);
+        instance_->async_sink_.reset();
+        {
+            std::lock_guard<std::mutex> log_lock(instance_->log_mutex_);
+            if (instance_->log_file_.is_open()) {
+                instance_->log_file_.close();
+            }
         }
         instance_.reset();
     }
 }
 
-void Logger::write_log(LogLevel level, const std::string& message) {
-    std::lock_guard<std::mutex> lock(log_mutex_);
-    
-    if (level < current_level_) {
+void Logger::write_log(LogLevel level, std::string message) {
+    Record record{level, std::chrono::system_clock::now(), std::move(message)};
+
+    if (async_sink_) {
+        async_sink_->push(std::move(record));
+        // An error is often the last thing logged before the process exits
+        if (level >= LogLevel::ERROR) {
+            async_sink_->flush();
+        }
         return;
     }
-    
-    std::string timestamp = get_timestamp();
-    std::string level_str = level_to_string(level);
-    std::string formatted_message = "[" + timestamp + "] [" + level_str + "] " + message;
-    
+
+    const std::string formatted_message = format_record(record);
+    std::lock_guard<std::mutex> lock(log_mutex_);
+
     if (console_output_) {
         if (level >= LogLevel::ERROR) {
             std::cerr << formatted_message << std::endl;
@@ -138,22 +376,56 @@ void Logger::write_log(LogLevel level, const std::string& message) {
             std::cout << formatted_message << std::endl;
         }
     }
-    
+
     if (log_file_.is_open()) {
         log_file_ << formatted_message << std::endl;
     }
 }
 
-std::string Logger::get_timestamp() const {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
+void Logger::write_records(const std::vector<Record>& records) {
+    // One write per stream for the whole batch
+    std::string all, out, err;
+    for (const auto& record : records) {
+        std::string line = format_record(record);
+        line += '\n';
+        (record.level >= LogLevel::ERROR ? err : out) += line;
+        all += line;
+    }
+
+    std::lock_guard<std::mutex> lock(log_mutex_);
+    if (console_output_) {
+        if (!out.empty()) {
+            std::cout << out << std::flush;
+        }
+        if (!err.empty()) {
+            std::cerr << err << std::flush;
+        }
+    }
+    if (log_file_.is_open()) {
+        log_file_ << all << std::flush;
+    }
+}
+
+std::string Logger::format_record(const Record& record) const {
+    return "[" + get_timestamp(record.time) + "] [" + level_to_string(record.level) + "] " + record.message;
+}
+
+std::string Logger::get_timestamp(std::chrono::system_clock::time_point time) const {
+    auto time_t = std::chrono::system_clock::to_time_t(time);
     auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-    
+        time.time_since_epoch()) % 1000;
+
+    std::tm local_time;
+#ifdef _WIN32
+    localtime_s(&local_time, &time_t);
+#else
+    localtime_r(&time_t, &local_time);
+#endif
+
     std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
+    ss << std::put_time(&local_time, "%Y-%m-%d %H:%M:%S");
     ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
-    
+
     return ss.str();
 }
 
@@ -170,11 +442,11 @@ std::string Logger::level_to_string(LogLevel level) const {
 LogLevel Logger::string_to_level(const std::string& level) const {
     std::string lower_level = level;
     std::transform(lower_level.begin(), lower_level.end(), lower_level.begin(), ::tolower);
-    
+
     if (lower_level == "debug") return LogLevel::DEBUG;
     if (lower_level == "info") return LogLevel::INFO;
     if (lower_level == "warn" || lower_level == "warning") return LogLevel::WARN;
     if (lower_level == "error") return LogLevel::ERROR;
-    
+
     return LogLevel::INFO; // default
 }
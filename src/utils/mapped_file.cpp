@@ -0,0 +1,135 @@
+#include "utils/mapped_file.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = other.data_;
+        size_ = other.size_;
+        opened_ = other.opened_;
+        fallback_ = std::move(other.fallback_);
+        if (!fallback_.empty()) {
+            data_ = fallback_.data();
+        }
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.opened_ = false;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& file_path) {
+    close();
+
+#ifndef _WIN32
+    int fd = ::open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        Logger::error("Cannot open file for mapping: " + file_path);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        Logger::error("Cannot stat file: " + file_path);
+        return false;
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            size_ = 0;
+            Logger::error("Cannot map file: " + file_path);
+            return false;
+        }
+        data_ = static_cast<const uint8_t*>(mapping);
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+#else
+    std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        Logger::error("Cannot open file: " + file_path);
+        return false;
+    }
+    size_ = static_cast<size_t>(file.tellg());
+    fallback_.resize(size_);
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(fallback_.data()), size_);
+    data_ = fallback_.empty() ? nullptr : fallback_.data();
+#endif
+
+    opened_ = true;
+    return true;
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (data_ && fallback_.empty()) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+#endif
+    fallback_.clear();
+    data_ = nullptr;
+    size_ = 0;
+    opened_ = false;
+}
+
+void MappedFile::prefetch(size_t offset, size_t length) const {
+#ifndef _WIN32
+    if (data_ && fallback_.empty() && offset < size_) {
+        // madvise needs a page-aligned start
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t start = offset & ~(page - 1);
+        const size_t end = std::min(size_, offset + length);
+        madvise(const_cast<uint8_t*>(data_) + start, end - start, MADV_WILLNEED);
+    }
+#else
+    (void)offset;
+    (void)length;
+#endif
+}
+
+void MappedFile::advise_sequential() const {
+#ifndef _WIN32
+    if (data_ && fallback_.empty()) {
+        madvise(const_cast<uint8_t*>(data_), size_, MADV_SEQUENTIAL);
+    }
+#endif
+}
+
+void MappedFile::release(size_t offset, size_t length) const {
+#ifndef _WIN32
+    if (data_ && fallback_.empty() && offset < size_) {
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t start = (offset + page - 1) & ~(page - 1);
+        const size_t end = std::min(size_, offset + length) & ~(page - 1);
+        if (end > start) {
+            madvise(const_cast<uint8_t*>(data_) + start, end - start, MADV_DONTNEED);
+        }
+    }
+#else
+    (void)offset;
+    (void)length;
+#endif
+}
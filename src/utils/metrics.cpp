@@ -0,0 +1,202 @@
+#include "utils/metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+const double LatencyHistogram::BUCKET_BOUNDS[LatencyHistogram::BUCKET_COUNT] = {
+    0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05,
+    0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0, 60.0
+};
+
+namespace {
+
+std::string format_value(double value) {
+    if (std::isnan(value)) {
+        return "NaN";
+    }
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    std::ostringstream out;
+    out << std::setprecision(15) << value;
+    return out.str();
+}
+
+std::string escape(const std::string& text, bool quotes) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        if (c == '\\') {
+            escaped += "\\\\";
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else if (c == '"' && quotes) {
+            escaped += "\\\"";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string render_labels(const MetricLabels& labels) {
+    std::string rendered;
+    for (const auto& label : labels) {
+        if (!rendered.empty()) {
+            rendered += ',';
+        }
+        rendered += label.first + "=\"" + escape(label.second, true) + "\"";
+    }
+    return rendered;
+}
+
+// name{labels,extra} value
+void write_sample(std::ostringstream& out, const std::string& name, const std::string& labels,
+                  const std::string& extra, const std::string& value) {
+    out << name;
+    if (!labels.empty() || !extra.empty()) {
+        out << '{' << labels << (!labels.empty() && !extra.empty() ? "," : "") << extra << '}';
+    }
+    out << ' ' << value << '\n';
+}
+
+} // namespace
+
+void LatencyHistogram::observe(double seconds) {
+    if (!(seconds > 0.0)) {
+        seconds = 0.0;
+    }
+    const size_t index = std::lower_bound(BUCKET_BOUNDS, BUCKET_BOUNDS + BUCKET_COUNT, seconds) - BUCKET_BOUNDS;
+    buckets_[index].fetch_add(1, std::memory_order_relaxed);
+    sum_nanoseconds_.fetch_add(static_cast<uint64_t>(seconds * 1e9), std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const {
+    uint64_t total = 0;
+    for (size_t i = 0; i <= BUCKET_COUNT; i++) {
+        total += bucket(i);
+    }
+    return total;
+}
+
+MetricsRegistry& MetricsRegistry::global() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Series& MetricsRegistry::find_or_add(const std::string& name, const std::string& help,
+                                                      MetricType type, const MetricLabels& labels) {
+    auto inserted = families_.emplace(name, Family{type, help, {}});
+    Family& family = inserted.first->second;
+    if (family.type != type) {
+        throw std::logic_error("Metric " + name + " is already registered with another type");
+    }
+
+    const std::string rendered = render_labels(labels);
+    for (auto& series : family.series) {
+        if (series.labels == rendered) {
+            return series;
+        }
+    }
+    family.series.emplace_back();
+    family.series.back().labels = rendered;
+    return family.series.back();
+}
+
+MetricCounter& MetricsRegistry::counter(const std::string& name, const std::string& help,
+                                        const MetricLabels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series& series = find_or_add(name, help, MetricType::COUNTER, labels);
+    if (!series.counter) {
+        series.counter.reset(new MetricCounter());
+    }
+    return *series.counter;
+}
+
+MetricGauge& MetricsRegistry::gauge(const std::string& name, const std::string& help, const MetricLabels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series& series = find_or_add(name, help, MetricType::GAUGE, labels);
+    if (!series.gauge && !series.sample) {
+        series.gauge.reset(new MetricGauge());
+    }
+    if (!series.gauge) {
+        throw std::logic_error("Metric " + name + " is sampled by a callback");
+    }
+    return *series.gauge;
+}
+
+LatencyHistogram& MetricsRegistry::histogram(const std::string& name, const std::string& help,
+                                             const MetricLabels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series& series = find_or_add(name, help, MetricType::HISTOGRAM, labels);
+    if (!series.histogram) {
+        series.histogram.reset(new LatencyHistogram());
+    }
+    return *series.histogram;
+}
+
+void MetricsRegistry::add_callback(const void* owner, const std::string& name, const std::string& help,
+                                   const MetricLabels& labels, std::function<double()> sample) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series& series = find_or_add(name, help, MetricType::GAUGE, labels);
+    if (series.gauge) {
+        throw std::logic_error("Metric " + name + " is already a stored gauge");
+    }
+    // A later owner of the same series, e.g. the next scheduler, takes over
+    series.owner = owner;
+    series.sample = std::move(sample);
+}
+
+void MetricsRegistry::remove_callbacks(const void* owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = families_.begin(); it != families_.end(); ) {
+        auto& series = it->second.series;
+        series.erase(std::remove_if(series.begin(), series.end(), [owner](const Series& entry) {
+                         return entry.sample && entry.owner == owner;
+                     }), series.end());
+        it = series.empty() ? families_.erase(it) : std::next(it);
+    }
+}
+
+std::string MetricsRegistry::render() const {
+    std::ostringstream out;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (const auto& entry : families_) {
+        const std::string& name = entry.first;
+        const Family& family = entry.second;
+        const char* type = family.type == MetricType::COUNTER ? "counter" :
+                           family.type == MetricType::GAUGE ? "gauge" : "histogram";
+        out << "# HELP " << name << ' ' << escape(family.help, false) << '\n';
+        out << "# TYPE " << name << ' ' << type << '\n';
+
+        for (const auto& series : family.series) {
+            if (series.counter) {
+                write_sample(out, name, series.labels, "", std::to_string(series.counter->value()));
+            } else if (series.gauge) {
+                write_sample(out, name, series.labels, "", format_value(series.gauge->value()));
+            } else if (series.sample) {
+                const double value = series.sample();
+                if (!std::isnan(value)) {
+                    write_sample(out, name, series.labels, "", format_value(value));
+                }
+            } else if (series.histogram) {
+                // Buckets are read one by one while writers keep going; the
+                // count is taken from the same reads so _count matches +Inf
+                uint64_t cumulative = 0;
+                for (size_t i = 0; i <= LatencyHistogram::BUCKET_COUNT; i++) {
+                    cumulative += series.histogram->bucket(i);
+                    const std::string le = i < LatencyHistogram::BUCKET_COUNT
+                        ? format_value(LatencyHistogram::BUCKET_BOUNDS[i]) : "+Inf";
+                    write_sample(out, name + "_bucket", series.labels, "le=\"" + le + "\"",
+                                 std::to_string(cumulative));
+                }
+                write_sample(out, name + "_sum", series.labels, "", format_value(series.histogram->sum()));
+                write_sample(out, name + "_count", series.labels, "", std::to_string(cumulative));
+            }
+        }
+    }
+    return out.str();
+}
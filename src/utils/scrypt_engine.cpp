@@ -0,0 +1,266 @@
+#include "utils/scrypt_engine.h"
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SCRYPT_HAVE_SSE2 1
+#endif
+
+namespace {
+
+// Blocks after the V table: two working blocks for either mix, plus the
+// lane being mixed for scrypt_romix
+const size_t ARENA_EXTRA_BLOCKS = 3;
+
+size_t arena_words(const ScryptParams& params) {
+    return (static_cast<size_t>(params.N) + ARENA_EXTRA_BLOCKS) * scrypt_block_words(params.r);
+}
+
+/**
+ * Run fn(thread, item) for every item on up to thread_count threads
+ */
+template <typename Function>
+void parallel_for(size_t items, size_t thread_count, Function fn) {
+    std::atomic<size_t> next(0);
+    auto worker = [&](size_t thread) {
+        for (size_t item = next.fetch_add(1); item < items; item = next.fetch_add(1)) {
+            fn(thread, item);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    const size_t count = std::min(thread_count, items);
+    for (size_t t = 1; t < count; t++) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+#ifdef SCRYPT_HAVE_SSE2
+
+#define SCRYPT_ROTL_SSE2(x, n) _mm_or_si128(_mm_slli_epi32((x), (n)), _mm_srli_epi32((x), 32 - (n)))
+
+// Salsa20/8 on a block stored in diagonal order (word i of the block at
+// position i * 5 mod 16), so each register holds one diagonal and the
+// column and row rounds differ only by a lane rotation in between
+inline void salsa20_8_sse2(__m128i b[4]) {
+    __m128i x0 = b[0], x1 = b[1], x2 = b[2], x3 = b[3];
+    for (int round = 0; round < 8; round += 2) {
+        __m128i t = _mm_add_epi32(x0, x3);
+        x1 = _mm_xor_si128(x1, SCRYPT_ROTL_SSE2(t, 7));
+        t = _mm_add_epi32(x1, x0);
+        x2 = _mm_xor_si128(x2, SCRYPT_ROTL_SSE2(t, 9));
+        t = _mm_add_epi32(x2, x1);
+        x3 = _mm_xor_si128(x3, SCRYPT_ROTL_SSE2(t, 13));
+        t = _mm_add_epi32(x3, x2);
+        x0 = _mm_xor_si128(x0, SCRYPT_ROTL_SSE2(t, 18));
+
+        x1 = _mm_shuffle_epi32(x1, 0x93);
+        x2 = _mm_shuffle_epi32(x2, 0x4e);
+        x3 = _mm_shuffle_epi32(x3, 0x39);
+
+        t = _mm_add_epi32(x0, x1);
+        x3 = _mm_xor_si128(x3, SCRYPT_ROTL_SSE2(t, 7));
+        t = _mm_add_epi32(x3, x0);
+        x2 = _mm_xor_si128(x2, SCRYPT_ROTL_SSE2(t, 9));
+        t = _mm_add_epi32(x2, x3);
+        x1 = _mm_xor_si128(x1, SCRYPT_ROTL_SSE2(t, 13));
+        t = _mm_add_epi32(x1, x2);
+        x0 = _mm_xor_si128(x0, SCRYPT_ROTL_SSE2(t, 18));
+
+        x1 = _mm_shuffle_epi32(x1, 0x39);
+        x2 = _mm_shuffle_epi32(x2, 0x4e);
+        x3 = _mm_shuffle_epi32(x3, 0x93);
+    }
+    b[0] = _mm_add_epi32(b[0], x0);
+    b[1] = _mm_add_epi32(b[1], x1);
+    b[2] = _mm_add_epi32(b[2], x2);
+    b[3] = _mm_add_epi32(b[3], x3);
+}
+
+inline void block_mix_sse2(const __m128i* in, __m128i* out, uint32_t r) {
+    __m128i x[4];
+    for (int k = 0; k < 4; k++) {
+        x[k] = in[(2 * r - 1) * 4 + k];
+    }
+    for (uint32_t i = 0; i < r; i++) {
+        for (int k = 0; k < 4; k++) {
+            x[k] = _mm_xor_si128(x[k], in[8 * i + k]);
+        }
+        salsa20_8_sse2(x);
+        for (int k = 0; k < 4; k++) {
+            out[4 * i + k] = x[k];
+        }
+        for (int k = 0; k < 4; k++) {
+            x[k] = _mm_xor_si128(x[k], in[8 * i + 4 + k]);
+        }
+        salsa20_8_sse2(x);
+        for (int k = 0; k < 4; k++) {
+            out[4 * (r + i) + k] = x[k];
+        }
+    }
+}
+
+inline uint32_t integerify_sse2(const __m128i* x, uint32_t r, uint32_t N) {
+    // Word 0 of the last block stays at position 0 in diagonal order
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(x[(2 * r - 1) * 4])) & (N - 1);
+}
+
+void romix_sse2(uint8_t* lane, uint32_t* arena, uint32_t N, uint32_t r) {
+    const size_t vectors = 8 * static_cast<size_t>(r);
+    __m128i* v = reinterpret_cast<__m128i*>(arena);
+    __m128i* x = v + N * vectors;
+    __m128i* y = x + vectors;
+    uint32_t* x_words = reinterpret_cast<uint32_t*>(x);
+
+    for (uint32_t k = 0; k < 2 * r; k++) {
+        for (int i = 0; i < 16; i++) {
+            x_words[k * 16 + i] = scrypt_load_le32(lane + k * 64 + ((i * 5) & 15) * 4);
+        }
+    }
+
+    for (uint32_t i = 0; i < N; i += 2) {
+        std::copy(x, x + vectors, v + i * vectors);
+        block_mix_sse2(x, y, r);
+        std::copy(y, y + vectors, v + (i + 1) * vectors);
+        block_mix_sse2(y, x, r);
+    }
+
+    for (uint32_t i = 0; i < N; i += 2) {
+        const __m128i* entry = v + integerify_sse2(x, r, N) * vectors;
+        for (size_t k = 0; k < vectors; k++) {
+            x[k] = _mm_xor_si128(x[k], entry[k]);
+        }
+        block_mix_sse2(x, y, r);
+        entry = v + integerify_sse2(y, r, N) * vectors;
+        for (size_t k = 0; k < vectors; k++) {
+            y[k] = _mm_xor_si128(y[k], entry[k]);
+        }
+        block_mix_sse2(y, x, r);
+    }
+
+    for (uint32_t k = 0; k < 2 * r; k++) {
+        for (int i = 0; i < 16; i++) {
+            scrypt_store_le32(lane + k * 64 + ((i * 5) & 15) * 4, x_words[k * 16 + i]);
+        }
+    }
+}
+
+#endif // SCRYPT_HAVE_SSE2
+
+} // namespace
+
+ScryptTmtoPlan scrypt_plan_tmto(const ScryptParams& params, size_t memory_budget, size_t target_lanes,
+                                uint32_t max_gap) {
+    ScryptTmtoPlan best;
+    double best_rate = 0.0;
+    const size_t block_bytes = scrypt_block_words(params.r) * sizeof(uint32_t);
+    const uint32_t last_gap = std::max(1u, std::min(max_gap, params.N));
+
+    for (uint32_t gap = 1; gap <= last_gap; gap++) {
+        const size_t bytes_per_lane = scrypt_table_entries(params.N, gap) * block_bytes;
+        const size_t lanes = std::min(target_lanes, memory_budget / bytes_per_lane);
+        if (lanes == 0) {
+            continue;
+        }
+        // N BlockMix calls to fill V, N to read it, N * (gap - 1) / 2 to rebuild
+        const double cost = 2.0 + (gap - 1) / 2.0;
+        const double rate = lanes / cost;
+        if (rate > best_rate) {
+            best_rate = rate;
+            best.lookup_gap = gap;
+            best.lanes = lanes;
+            best.bytes_per_lane = bytes_per_lane;
+        }
+    }
+    return best;
+}
+
+void ScryptEngine::ArenaDeleter::operator()(uint32_t* arena) const {
+    ::operator delete(arena, std::align_val_t(64));
+}
+
+ScryptEngine::ScryptEngine(const ScryptParams& params, size_t threads, bool use_simd)
+    : params_(params),
+      thread_count_(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())),
+      use_simd_(use_simd && has_simd()) {}
+
+ScryptEngine::~ScryptEngine() = default;
+
+bool ScryptEngine::has_simd() {
+#ifdef SCRYPT_HAVE_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool ScryptEngine::allocate_arenas() {
+    if (arenas_.size() == thread_count_) {
+        return true;
+    }
+    const size_t bytes = arena_words(params_) * sizeof(uint32_t);
+    while (arenas_.size() < thread_count_) {
+        void* memory = ::operator new(bytes, std::align_val_t(64), std::nothrow);
+        if (!memory) {
+            last_error_ = "Cannot allocate " + std::to_string(bytes >> 20) + " MB scrypt scratchpad";
+            return false;
+        }
+        arenas_.emplace_back(static_cast<uint32_t*>(memory));
+    }
+    return true;
+}
+
+void ScryptEngine::mix_lane(uint8_t* lane, uint32_t* arena) const {
+#ifdef SCRYPT_HAVE_SSE2
+    if (use_simd_) {
+        romix_sse2(lane, arena, params_.N, params_.r);
+        return;
+    }
+#endif
+    const size_t words = scrypt_block_words(params_.r);
+    uint32_t* x = arena + scrypt_scratch_words(params_, 1);
+    scrypt_bytes_to_words(lane, x, words);
+    scrypt_romix(x, arena, params_.N, params_.r, 1);
+    scrypt_words_to_bytes(x, lane, words);
+}
+
+bool ScryptEngine::derive(const uint8_t* const* passwords, const size_t* lengths, size_t count,
+                          const uint8_t* salt, size_t salt_length, uint8_t* derived_keys, size_t key_length) {
+    if (!scrypt_params_valid(params_)) {
+        last_error_ = "Invalid scrypt parameters";
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+    if (!allocate_arenas()) {
+        return false;
+    }
+
+    const size_t lane_bytes = scrypt_block_words(params_.r) * sizeof(uint32_t);
+    const size_t candidate_bytes = params_.p * lane_bytes;
+    blocks_.resize(count * candidate_bytes);
+
+    parallel_for(count, thread_count_, [&](size_t, size_t candidate) {
+        pbkdf2_hmac_sha256(passwords[candidate], lengths[candidate], salt, salt_length, 1,
+                           blocks_.data() + candidate * candidate_bytes, candidate_bytes);
+    });
+
+    // One lane per work item, so few candidates with a large p still fill every thread
+    parallel_for(count * params_.p, thread_count_, [&](size_t thread, size_t lane) {
+        mix_lane(blocks_.data() + lane * lane_bytes, arenas_[thread].get());
+    });
+
+    parallel_for(count, thread_count_, [&](size_t, size_t candidate) {
+        pbkdf2_hmac_sha256(passwords[candidate], lengths[candidate], blocks_.data() + candidate * candidate_bytes,
+                           candidate_bytes, 1, derived_keys + candidate * key_length, key_length);
+    });
+    return true;
+}
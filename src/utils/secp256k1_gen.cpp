@@ -0,0 +1,339 @@
+#include "utils/secp256k1_gen.h"
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+typedef unsigned __int128 uint128_t;
+
+// Field elements are four little-endian 64-bit limbs, kept fully reduced mod p
+struct FieldElement {
+    uint64_t v[4];
+};
+
+struct AffinePoint {
+    FieldElement x, y;
+};
+
+struct JacobianPoint {
+    FieldElement x, y, z;
+    bool infinity;
+};
+
+// p = 2^256 - 2^32 - 977, so 2^256 = 0x1000003D1 (mod p)
+const uint64_t FIELD_P[4] = {0xFFFFFFFEFFFFFC2FULL, 0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL};
+const uint64_t FIELD_C = 0x1000003D1ULL;
+
+// Group order n, big-endian
+const uint8_t GROUP_ORDER[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
+    0xBA, 0xAE, 0xDC, 0xE6, 0xAF, 0x48, 0xA0, 0x3B, 0xBF, 0xD2, 0x5E, 0x8C, 0xD0, 0x36, 0x41, 0x41
+};
+
+const AffinePoint GENERATOR = {
+    {{0x59F2815B16F81798ULL, 0x029BFCDB2DCE28D9ULL, 0x55A06295CE870B07ULL, 0x79BE667EF9DCBBACULL}},
+    {{0x9C47D08FFB10D4B8ULL, 0xFD17B448A6855419ULL, 0x5DA4FBFC0E1108A8ULL, 0x483ADA7726A3C465ULL}}
+};
+
+constexpr int WINDOW_BITS = 4;
+constexpr int WINDOW_COUNT = 256 / WINDOW_BITS;
+constexpr int WINDOW_SIZE = 1 << WINDOW_BITS;
+
+// table[w * WINDOW_SIZE + i] = i * 16^w * G; entry 0 of each window is unused
+std::vector<AffinePoint> g_table;
+std::once_flag g_table_once;
+
+bool fe_is_zero(const FieldElement& a) {
+    return (a.v[0] | a.v[1] | a.v[2] | a.v[3]) == 0;
+}
+
+bool fe_geq_p(const uint64_t* a) {
+    for (int i = 3; i >= 0; i--) {
+        if (a[i] != FIELD_P[i]) return a[i] > FIELD_P[i];
+    }
+    return true;
+}
+
+void fe_sub_p(uint64_t* a) {
+    uint128_t borrow = 0;
+    for (int i = 0; i < 4; i++) {
+        uint128_t d = (uint128_t)a[i] - FIELD_P[i] - borrow;
+        a[i] = (uint64_t)d;
+        borrow = (d >> 64) & 1;
+    }
+}
+
+void fe_add(FieldElement& r, const FieldElement& a, const FieldElement& b) {
+    uint128_t carry = 0;
+    for (int i = 0; i < 4; i++) {
+        carry += (uint128_t)a.v[i] + b.v[i];
+        r.v[i] = (uint64_t)carry;
+        carry >>= 64;
+    }
+    if (carry) {
+        // a + b - 2^256 < p, so adding 2^256 mod p cannot overflow again
+        uint128_t c = FIELD_C;
+        for (int i = 0; i < 4; i++) {
+            c += r.v[i];
+            r.v[i] = (uint64_t)c;
+            c >>= 64;
+        }
+    }
+    if (fe_geq_p(r.v)) fe_sub_p(r.v);
+}
+
+void fe_sub(FieldElement& r, const FieldElement& a, const FieldElement& b) {
+    uint128_t borrow = 0;
+    for (int i = 0; i < 4; i++) {
+        uint128_t d = (uint128_t)a.v[i] - b.v[i] - borrow;
+        r.v[i] = (uint64_t)d;
+        borrow = (d >> 64) & 1;
+    }
+    if (borrow) {
+        uint128_t carry = 0;
+        for (int i = 0; i < 4; i++) {
+            carry += (uint128_t)r.v[i] + FIELD_P[i];
+            r.v[i] = (uint64_t)carry;
+            carry >>= 64;
+        }
+    }
+}
+
+void fe_mul(FieldElement& r, const FieldElement& a, const FieldElement& b) {
+    uint64_t t[8] = {0};
+    for (int i = 0; i < 4; i++) {
+        uint128_t carry = 0;
+        for (int j = 0; j < 4; j++) {
+            carry += (uint128_t)a.v[i] * b.v[j] + t[i + j];
+            t[i + j] = (uint64_t)carry;
+            carry >>= 64;
+        }
+        t[i + 4] = (uint64_t)carry;
+    }
+
+    // Fold the high half down twice using 2^256 = C (mod p)
+    uint64_t m[5];
+    uint128_t acc = 0;
+    for (int i = 0; i < 4; i++) {
+        acc += (uint128_t)t[i] + (uint128_t)t[i + 4] * FIELD_C;
+        m[i] = (uint64_t)acc;
+        acc >>= 64;
+    }
+    m[4] = (uint64_t)acc;
+
+    acc = (uint128_t)m[0] + (uint128_t)m[4] * FIELD_C;
+    r.v[0] = (uint64_t)acc;
+    acc >>= 64;
+    for (int i = 1; i < 4; i++) {
+        acc += m[i];
+        r.v[i] = (uint64_t)acc;
+        acc >>= 64;
+    }
+    if (acc) {
+        uint128_t c = FIELD_C;
+        for (int i = 0; i < 4; i++) {
+            c += r.v[i];
+            r.v[i] = (uint64_t)c;
+            c >>= 64;
+        }
+    }
+    if (fe_geq_p(r.v)) fe_sub_p(r.v);
+}
+
+void fe_sqr(FieldElement& r, const FieldElement& a) {
+    fe_mul(r, a, a);
+}
+
+// a^(p-2) by left-to-right square-and-multiply
+void fe_inv(FieldElement& r, const FieldElement& a) {
+    const uint64_t exponent[4] = {FIELD_P[0] - 2, FIELD_P[1], FIELD_P[2], FIELD_P[3]};
+    FieldElement result = {{1, 0, 0, 0}};
+    for (int i = 255; i >= 0; i--) {
+        fe_sqr(result, result);
+        if ((exponent[i / 64] >> (i % 64)) & 1) {
+            fe_mul(result, result, a);
+        }
+    }
+    r = result;
+}
+
+void fe_to_bytes(uint8_t* bytes, const FieldElement& a) {
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 8; j++) {
+            bytes[(3 - i) * 8 + j] = (uint8_t)(a.v[i] >> (56 - 8 * j));
+        }
+    }
+}
+
+// dbl-2009-l for a = 0
+void point_double(JacobianPoint& r, const JacobianPoint& p) {
+    if (p.infinity || fe_is_zero(p.y)) {
+        r.infinity = true;
+        return;
+    }
+    FieldElement a, b, c, d, e, f, t;
+    fe_sqr(a, p.x);
+    fe_sqr(b, p.y);
+    fe_sqr(c, b);
+    fe_add(t, p.x, b);
+    fe_sqr(t, t);
+    fe_sub(t, t, a);
+    fe_sub(t, t, c);
+    fe_add(d, t, t);
+    fe_add(e, a, a);
+    fe_add(e, e, a);
+    fe_sqr(f, e);
+
+    FieldElement z3;
+    fe_mul(z3, p.y, p.z);
+    fe_add(r.z, z3, z3);
+
+    fe_sub(r.x, f, d);
+    fe_sub(r.x, r.x, d);
+
+    fe_sub(t, d, r.x);
+    fe_mul(t, e, t);
+    fe_add(c, c, c);
+    fe_add(c, c, c);
+    fe_add(c, c, c);
+    fe_sub(r.y, t, c);
+    r.infinity = false;
+}
+
+// madd-2007-bl: r = p + q with q affine
+void point_add_affine(JacobianPoint& r, const JacobianPoint& p, const AffinePoint& q) {
+    if (p.infinity) {
+        r.x = q.x;
+        r.y = q.y;
+        r.z = FieldElement{{1, 0, 0, 0}};
+        r.infinity = false;
+        return;
+    }
+
+    FieldElement z1z1, u2, s2, h, hh, i, j, rr, v, t;
+    fe_sqr(z1z1, p.z);
+    fe_mul(u2, q.x, z1z1);
+    fe_mul(s2, q.y, p.z);
+    fe_mul(s2, s2, z1z1);
+    fe_sub(h, u2, p.x);
+    fe_sub(rr, s2, p.y);
+
+    if (fe_is_zero(h)) {
+        if (fe_is_zero(rr)) {
+            point_double(r, p);
+        } else {
+            r.infinity = true;
+        }
+        return;
+    }
+
+    fe_sqr(hh, h);
+    fe_add(i, hh, hh);
+    fe_add(i, i, i);
+    fe_mul(j, h, i);
+    fe_add(rr, rr, rr);
+    fe_mul(v, p.x, i);
+
+    JacobianPoint out;
+    fe_sqr(out.x, rr);
+    fe_sub(out.x, out.x, j);
+    fe_sub(out.x, out.x, v);
+    fe_sub(out.x, out.x, v);
+
+    fe_sub(t, v, out.x);
+    fe_mul(t, rr, t);
+    FieldElement y1j;
+    fe_mul(y1j, p.y, j);
+    fe_add(y1j, y1j, y1j);
+    fe_sub(out.y, t, y1j);
+
+    fe_add(out.z, p.z, h);
+    fe_sqr(out.z, out.z);
+    fe_sub(out.z, out.z, z1z1);
+    fe_sub(out.z, out.z, hh);
+    out.infinity = false;
+    r = out;
+}
+
+void to_affine(AffinePoint& r, const JacobianPoint& p) {
+    FieldElement zinv, zinv2, zinv3;
+    fe_inv(zinv, p.z);
+    fe_sqr(zinv2, zinv);
+    fe_mul(zinv3, zinv2, zinv);
+    fe_mul(r.x, p.x, zinv2);
+    fe_mul(r.y, p.y, zinv3);
+}
+
+void build_table() {
+    g_table.resize(WINDOW_COUNT * WINDOW_SIZE);
+
+    AffinePoint base = GENERATOR;
+    for (int w = 0; w < WINDOW_COUNT; w++) {
+        AffinePoint* window = &g_table[w * WINDOW_SIZE];
+        window[1] = base;
+
+        JacobianPoint acc = {base.x, base.y, {{1, 0, 0, 0}}, false};
+        for (int i = 2; i < WINDOW_SIZE; i++) {
+            point_add_affine(acc, acc, base);
+            to_affine(window[i], acc);
+        }
+
+        // Next window's base is 16 times this one's
+        JacobianPoint next = {base.x, base.y, {{1, 0, 0, 0}}, false};
+        for (int d = 0; d < WINDOW_BITS; d++) {
+            point_double(next, next);
+        }
+        to_affine(base, next);
+    }
+}
+
+bool scalar_in_range(const uint8_t* k) {
+    bool nonzero = false;
+    for (int i = 0; i < 32; i++) {
+        nonzero |= k[i] != 0;
+    }
+    if (!nonzero) return false;
+
+    for (int i = 0; i < 32; i++) {
+        if (k[i] != GROUP_ORDER[i]) return k[i] < GROUP_ORDER[i];
+    }
+    return false;
+}
+
+} // namespace
+
+void Secp256k1Gen::precompute() {
+    std::call_once(g_table_once, build_table);
+}
+
+bool Secp256k1Gen::derive_public_key(const uint8_t* private_key, uint8_t* public_key) {
+    if (!scalar_in_range(private_key)) {
+        return false;
+    }
+    precompute();
+
+    // k < n keeps every partial sum distinct from the next window's point, so
+    // the exceptional cases of the addition formula never arise
+    JacobianPoint acc;
+    acc.infinity = true;
+    for (int w = 0; w < WINDOW_COUNT; w++) {
+        const uint8_t byte = private_key[31 - w / 2];
+        const int digit = (w & 1) ? (byte >> 4) : (byte & 0x0f);
+        if (digit != 0) {
+            point_add_affine(acc, acc, g_table[w * WINDOW_SIZE + digit]);
+        }
+    }
+
+    AffinePoint result;
+    to_affine(result, acc);
+    public_key[0] = 0x04;
+    fe_to_bytes(public_key + 1, result.x);
+    fe_to_bytes(public_key + 33, result.y);
+    return true;
+}
+
+void Secp256k1Gen::compress(const uint8_t* uncompressed, uint8_t* compressed) {
+    compressed[0] = (uncompressed[64] & 1) ? 0x03 : 0x02;
+    std::memcpy(compressed + 1, uncompressed + 1, 32);
+}
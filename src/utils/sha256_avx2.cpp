@@ -0,0 +1,40 @@
+// AVX2 multi-buffer SHA-256d: eight candidates per call, one per 32-bit lane.
+// This file is compiled with -mavx2 and only entered after a runtime check.
+
+#include "sha256_lanes.h"
+#include <immintrin.h>
+
+namespace {
+
+struct AVX2Lanes {
+    using vec = __m256i;
+    static constexpr size_t LANES = 8;
+
+    static vec load(const uint32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(uint32_t* p, vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static vec set1(uint32_t x) { return _mm256_set1_epi32(static_cast<int>(x)); }
+    static vec add(vec a, vec b) { return _mm256_add_epi32(a, b); }
+    static vec xor3(vec a, vec b, vec c) { return _mm256_xor_si256(_mm256_xor_si256(a, b), c); }
+
+    // Ch(e, f, g) = (e & f) ^ (~e & g) = ((f ^ g) & e) ^ g
+    static vec ch(vec e, vec f, vec g) {
+        return _mm256_xor_si256(_mm256_and_si256(_mm256_xor_si256(f, g), e), g);
+    }
+
+    // Maj(a, b, c) = (a & b) | (c & (a | b))
+    static vec maj(vec a, vec b, vec c) {
+        return _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+    }
+
+    template <int N>
+    static vec rotr(vec x) { return _mm256_or_si256(_mm256_srli_epi32(x, N), _mm256_slli_epi32(x, 32 - N)); }
+
+    template <int N>
+    static vec shr(vec x) { return _mm256_srli_epi32(x, N); }
+};
+
+} // namespace
+
+void sha256d_short_avx2(const uint32_t* blocks, uint32_t* digests) {
+    sha256d_short_lanes<AVX2Lanes>(blocks, digests);
+}
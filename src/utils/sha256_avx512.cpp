@@ -0,0 +1,46 @@
+// AVX-512 multi-buffer SHA-256d: sixteen candidates per call, one per 32-bit lane.
+// This file is compiled with -mavx512f and only entered after a runtime check.
+
+#include "sha256_lanes.h"
+
+// Same GCC 12 false positive as in sha512_avx512.cpp; the 32-bit rotates
+// also trip plain -Wuninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+
+namespace {
+
+struct AVX512Lanes {
+    using vec = __m512i;
+    static constexpr size_t LANES = 16;
+
+    static vec load(const uint32_t* p) { return _mm512_loadu_si512(p); }
+    static void store(uint32_t* p, vec v) { _mm512_storeu_si512(p, v); }
+    static vec set1(uint32_t x) { return _mm512_set1_epi32(static_cast<int>(x)); }
+    static vec add(vec a, vec b) { return _mm512_add_epi32(a, b); }
+
+    // Three-input boolean functions map onto a single vpternlogd each
+    static vec xor3(vec a, vec b, vec c) { return _mm512_ternarylogic_epi32(a, b, c, 0x96); }
+    static vec ch(vec e, vec f, vec g) { return _mm512_ternarylogic_epi32(e, f, g, 0xCA); }
+    static vec maj(vec a, vec b, vec c) { return _mm512_ternarylogic_epi32(a, b, c, 0xE8); }
+
+    template <int N>
+    static vec rotr(vec x) { return _mm512_ror_epi32(x, N); }
+
+    template <int N>
+    static vec shr(vec x) { return _mm512_srli_epi32(x, N); }
+};
+
+} // namespace
+
+void sha256d_short_avx512(const uint32_t* blocks, uint32_t* digests) {
+    sha256d_short_lanes<AVX512Lanes>(blocks, digests);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
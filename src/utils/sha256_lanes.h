@@ -0,0 +1,113 @@
+#pragma once
+
+// Internal header shared by the AVX2 and AVX-512 SHA-256 translation units.
+// Everything here has internal linkage so that each unit keeps its own copy
+// compiled for its own instruction set. Only constants are taken from
+// sha256d.h, for the same reason as in sha512_lanes.h.
+
+#include "utils/sha256d.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+/**
+ * One SHA-256 compression across all lanes of V
+ * @param state Per-lane chaining state, updated in place
+ * @param w Per-lane message words (overwritten by the schedule)
+ */
+template <typename V>
+inline void sha256_compress_lanes(typename V::vec state[8], typename V::vec w[16]) {
+    using vec = typename V::vec;
+
+    vec a = state[0], b = state[1], c = state[2], d = state[3];
+    vec e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int t = 0; t < 64; t++) {
+        vec wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            vec w15 = w[(t - 15) & 15];
+            vec w2 = w[(t - 2) & 15];
+            vec s0 = V::xor3(V::template rotr<7>(w15), V::template rotr<18>(w15), V::template shr<3>(w15));
+            vec s1 = V::xor3(V::template rotr<17>(w2), V::template rotr<19>(w2), V::template shr<10>(w2));
+            wt = V::add(V::add(w[t & 15], s0), V::add(w[(t - 7) & 15], s1));
+            w[t & 15] = wt;
+        }
+
+        vec big_s1 = V::xor3(V::template rotr<6>(e), V::template rotr<11>(e), V::template rotr<25>(e));
+        vec t1 = V::add(V::add(h, big_s1), V::add(V::ch(e, f, g),
+                        V::add(V::set1(SHA256_ROUND_CONSTANTS_HOST[t]), wt)));
+        vec big_s0 = V::xor3(V::template rotr<2>(a), V::template rotr<13>(a), V::template rotr<22>(a));
+        vec t2 = V::add(big_s0, V::maj(a, b, c));
+
+        h = g;
+        g = f;
+        f = e;
+        e = V::add(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = V::add(t1, t2);
+    }
+
+    state[0] = V::add(state[0], a);
+    state[1] = V::add(state[1], b);
+    state[2] = V::add(state[2], c);
+    state[3] = V::add(state[3], d);
+    state[4] = V::add(state[4], e);
+    state[5] = V::add(state[5], f);
+    state[6] = V::add(state[6], g);
+    state[7] = V::add(state[7], h);
+}
+
+template <typename V>
+inline void sha256_initial_lanes(typename V::vec state[8]) {
+    state[0] = V::set1(0x6a09e667); state[1] = V::set1(0xbb67ae85);
+    state[2] = V::set1(0x3c6ef372); state[3] = V::set1(0xa54ff53a);
+    state[4] = V::set1(0x510e527f); state[5] = V::set1(0x9b05688c);
+    state[6] = V::set1(0x1f83d9ab); state[7] = V::set1(0x5be0cd19);
+}
+
+/**
+ * Double SHA-256 of V::LANES single-block messages
+ *
+ * Arrays are word-major: element [word * V::LANES + lane].
+ * @param blocks Padded message blocks, 16 words per lane
+ * @param digests Output state words of the second hash, 8 per lane
+ */
+template <typename V>
+inline void sha256d_short_lanes(const uint32_t* blocks, uint32_t* digests) {
+    using vec = typename V::vec;
+
+    vec w[16];
+    vec s[8];
+    for (int i = 0; i < 16; i++) {
+        w[i] = V::load(blocks + i * V::LANES);
+    }
+    sha256_initial_lanes<V>(s);
+    sha256_compress_lanes<V>(s, w);
+
+    // Second hash: the 32-byte digest padded into a block of its own
+    for (int i = 0; i < 8; i++) {
+        w[i] = s[i];
+    }
+    w[8] = V::set1(SHA256D_DIGEST_PAD_WORD);
+    for (int i = 9; i < 15; i++) {
+        w[i] = V::set1(0);
+    }
+    w[15] = V::set1(SHA256D_DIGEST_BITS);
+    sha256_initial_lanes<V>(s);
+    sha256_compress_lanes<V>(s, w);
+
+    for (int i = 0; i < 8; i++) {
+        V::store(digests + i * V::LANES, s[i]);
+    }
+}
+
+} // namespace
+
+// Lane kernels provided by the instruction-set specific translation units
+void sha256d_short_avx2(const uint32_t* blocks, uint32_t* digests);
+void sha256d_short_avx512(const uint32_t* blocks, uint32_t* digests);
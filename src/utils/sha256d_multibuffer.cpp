@@ -0,0 +1,86 @@
+#include "utils/sha256d_multibuffer.h"
+#include "utils/sha256d.h"
+#include "sha256_lanes.h"
+#include <algorithm>
+
+namespace {
+
+using ShortFunction = void (*)(const uint32_t*, uint32_t*);
+
+ShortFunction get_short_function(SIMDLevel level) {
+    switch (level) {
+#ifdef ENABLE_SHA256_AVX512
+        case SIMDLevel::AVX512:
+            return sha256d_short_avx512;
+#endif
+#ifdef ENABLE_SHA256_AVX2
+        case SIMDLevel::AVX2:
+            return sha256d_short_avx2;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+} // namespace
+
+size_t SHA256dMultiBuffer::get_lane_count(SIMDLevel level) {
+    switch (level) {
+        case SIMDLevel::AVX512: return 16;
+        case SIMDLevel::AVX2:   return 8;
+        default:                return 1;
+    }
+}
+
+void SHA256dMultiBuffer::sha256d(const uint8_t* const* messages, const size_t* lengths, size_t count,
+                                 uint8_t* digests, SIMDLevel level) {
+    // Fall back to the scalar path when this build lacks the requested level
+    ShortFunction hash_lanes = get_short_function(level);
+    if (!hash_lanes) {
+        for (size_t i = 0; i < count; i++) {
+            ::sha256d(messages[i], lengths[i], digests + i * 32);
+        }
+        return;
+    }
+    const size_t lanes = get_lane_count(level);
+
+    // Word-major lane buffers: element [word * lanes + lane]
+    uint32_t blocks[16 * MAX_LANES];
+    uint32_t states[8 * MAX_LANES];
+    size_t indices[MAX_LANES];
+    size_t active = 0;
+
+    auto flush = [&]() {
+        // Idle lanes hash whatever the last group left behind; their output is ignored
+        hash_lanes(blocks, states);
+        for (size_t lane = 0; lane < active; lane++) {
+            uint32_t state[8];
+            for (int word = 0; word < 8; word++) {
+                state[word] = states[word * lanes + lane];
+            }
+            sha256_store_digest(state, digests + indices[lane] * 32);
+        }
+        active = 0;
+    };
+
+    std::fill(blocks, blocks + 16 * lanes, 0u);
+    for (size_t i = 0; i < count; i++) {
+        if (lengths[i] > SHA256D_SHORT_MAX) {
+            ::sha256d(messages[i], lengths[i], digests + i * 32);
+            continue;
+        }
+
+        uint32_t w[16];
+        sha256_pad_short(messages[i], lengths[i], w);
+        for (int word = 0; word < 16; word++) {
+            blocks[word * lanes + active] = w[word];
+        }
+        indices[active++] = i;
+        if (active == lanes) {
+            flush();
+        }
+    }
+    if (active > 0) {
+        flush();
+    }
+}
@@ -0,0 +1,42 @@
+// AVX2 multi-buffer SHA-512: four candidates per call, one per 64-bit lane.
+// This file is compiled with -mavx2 and only entered after a runtime check.
+
+#include "sha512_lanes.h"
+#include <immintrin.h>
+
+namespace {
+
+struct AVX2Lanes {
+    using vec = __m256i;
+    static constexpr size_t LANES = 4;
+
+    static vec load(const uint64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(uint64_t* p, vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static vec set1(uint64_t x) { return _mm256_set1_epi64x(static_cast<long long>(x)); }
+    static vec add(vec a, vec b) { return _mm256_add_epi64(a, b); }
+    static vec xor_(vec a, vec b) { return _mm256_xor_si256(a, b); }
+    static vec xor3(vec a, vec b, vec c) { return _mm256_xor_si256(_mm256_xor_si256(a, b), c); }
+
+    // Ch(e, f, g) = (e & f) ^ (~e & g) = ((f ^ g) & e) ^ g
+    static vec ch(vec e, vec f, vec g) {
+        return _mm256_xor_si256(_mm256_and_si256(_mm256_xor_si256(f, g), e), g);
+    }
+
+    // Maj(a, b, c) = (a & b) | (c & (a | b))
+    static vec maj(vec a, vec b, vec c) {
+        return _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+    }
+
+    template <int N>
+    static vec rotr(vec x) { return _mm256_or_si256(_mm256_srli_epi64(x, N), _mm256_slli_epi64(x, 64 - N)); }
+
+    template <int N>
+    static vec shr(vec x) { return _mm256_srli_epi64(x, N); }
+};
+
+} // namespace
+
+void sha512_pbkdf2_iterate_avx2(const uint64_t* inner_state, const uint64_t* outer_state,
+                                uint64_t* u, uint64_t* t, uint32_t rounds) {
+    sha512_pbkdf2_iterate_lanes<AVX2Lanes>(inner_state, outer_state, u, t, rounds);
+}
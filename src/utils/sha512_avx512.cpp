@@ -0,0 +1,48 @@
+// AVX-512 multi-buffer SHA-512: eight candidates per call, one per 64-bit lane.
+// This file is compiled with -mavx512f and only entered after a runtime check.
+
+#include "sha512_lanes.h"
+
+// GCC 12 reports the _mm512_undefined_* self-initialisation inside
+// avx512fintrin.h as -Wmaybe-uninitialized once the lanes are inlined; the
+// warning is attributed to the header, so it is silenced for the whole file
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+
+namespace {
+
+struct AVX512Lanes {
+    using vec = __m512i;
+    static constexpr size_t LANES = 8;
+
+    static vec load(const uint64_t* p) { return _mm512_loadu_si512(p); }
+    static void store(uint64_t* p, vec v) { _mm512_storeu_si512(p, v); }
+    static vec set1(uint64_t x) { return _mm512_set1_epi64(static_cast<long long>(x)); }
+    static vec add(vec a, vec b) { return _mm512_add_epi64(a, b); }
+    static vec xor_(vec a, vec b) { return _mm512_xor_si512(a, b); }
+
+    // Three-input boolean functions map onto a single vpternlogq each
+    static vec xor3(vec a, vec b, vec c) { return _mm512_ternarylogic_epi64(a, b, c, 0x96); }
+    static vec ch(vec e, vec f, vec g) { return _mm512_ternarylogic_epi64(e, f, g, 0xCA); }
+    static vec maj(vec a, vec b, vec c) { return _mm512_ternarylogic_epi64(a, b, c, 0xE8); }
+
+    template <int N>
+    static vec rotr(vec x) { return _mm512_ror_epi64(x, N); }
+
+    template <int N>
+    static vec shr(vec x) { return _mm512_srli_epi64(x, N); }
+};
+
+} // namespace
+
+void sha512_pbkdf2_iterate_avx512(const uint64_t* inner_state, const uint64_t* outer_state,
+                                  uint64_t* u, uint64_t* t, uint32_t rounds) {
+    sha512_pbkdf2_iterate_lanes<AVX512Lanes>(inner_state, outer_state, u, t, rounds);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
@@ -0,0 +1,139 @@
+#pragma once
+
+// Internal header shared by the AVX2 and AVX-512 translation units.
+// Everything here has internal linkage so that each unit keeps its own copy
+// compiled for its own instruction set. Only constants are taken from
+// pbkdf2_sha512.h: calling its inline functions from an ISA-specific unit
+// could let the linker keep the AVX copy for every caller.
+
+#include "utils/pbkdf2_sha512.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+/**
+ * One SHA-512 compression across all lanes of V
+ * @param state Per-lane chaining state, updated in place
+ * @param w Per-lane message words (overwritten by the schedule)
+ */
+template <typename V>
+inline void sha512_compress_lanes(typename V::vec state[8], typename V::vec w[16]) {
+    using vec = typename V::vec;
+
+    vec a = state[0], b = state[1], c = state[2], d = state[3];
+    vec e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int t = 0; t < 80; t++) {
+        vec wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            vec w15 = w[(t - 15) & 15];
+            vec w2 = w[(t - 2) & 15];
+            vec s0 = V::xor3(V::template rotr<1>(w15), V::template rotr<8>(w15), V::template shr<7>(w15));
+            vec s1 = V::xor3(V::template rotr<19>(w2), V::template rotr<61>(w2), V::template shr<6>(w2));
+            wt = V::add(V::add(w[t & 15], s0), V::add(w[(t - 7) & 15], s1));
+            w[t & 15] = wt;
+        }
+
+        vec big_s1 = V::xor3(V::template rotr<14>(e), V::template rotr<18>(e), V::template rotr<41>(e));
+        vec t1 = V::add(V::add(h, big_s1), V::add(V::ch(e, f, g),
+                        V::add(V::set1(SHA512_ROUND_CONSTANTS_HOST[t]), wt)));
+        vec big_s0 = V::xor3(V::template rotr<28>(a), V::template rotr<34>(a), V::template rotr<39>(a));
+        vec t2 = V::add(big_s0, V::maj(a, b, c));
+
+        h = g;
+        g = f;
+        f = e;
+        e = V::add(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = V::add(t1, t2);
+    }
+
+    state[0] = V::add(state[0], a);
+    state[1] = V::add(state[1], b);
+    state[2] = V::add(state[2], c);
+    state[3] = V::add(state[3], d);
+    state[4] = V::add(state[4], e);
+    state[5] = V::add(state[5], f);
+    state[6] = V::add(state[6], g);
+    state[7] = V::add(state[7], h);
+}
+
+/**
+ * Run PBKDF2-HMAC-SHA512 iterations 2..N for V::LANES candidates
+ *
+ * All arrays are word-major: element [word * V::LANES + lane].
+ * @param inner_state HMAC inner pad midstates
+ * @param outer_state HMAC outer pad midstates
+ * @param u Previous U block, updated to the last one computed
+ * @param t Running XOR of all U blocks
+ * @param rounds Number of additional iterations to run
+ */
+template <typename V>
+inline void sha512_pbkdf2_iterate_lanes(const uint64_t* inner_state, const uint64_t* outer_state,
+                                        uint64_t* u, uint64_t* t, uint32_t rounds) {
+    using vec = typename V::vec;
+
+    vec inner[8], outer[8], uv[8], tv[8];
+    for (int i = 0; i < 8; i++) {
+        inner[i] = V::load(inner_state + i * V::LANES);
+        outer[i] = V::load(outer_state + i * V::LANES);
+        uv[i] = V::load(u + i * V::LANES);
+        tv[i] = V::load(t + i * V::LANES);
+    }
+
+    const vec zero = V::set1(0);
+    const vec pad = V::set1(SHA512_PAD_WORD);
+    const vec length = V::set1(SHA512_HMAC_DIGEST_BITS);
+
+    for (uint32_t r = 0; r < rounds; r++) {
+        vec w[16];
+        vec s[8];
+
+        // Inner hash: H(ipad || U)
+        for (int i = 0; i < 8; i++) {
+            w[i] = uv[i];
+            s[i] = inner[i];
+        }
+        w[8] = pad;
+        for (int i = 9; i < 15; i++) {
+            w[i] = zero;
+        }
+        w[15] = length;
+        sha512_compress_lanes<V>(s, w);
+
+        // Outer hash: H(opad || inner digest)
+        for (int i = 0; i < 8; i++) {
+            w[i] = s[i];
+            s[i] = outer[i];
+        }
+        w[8] = pad;
+        for (int i = 9; i < 15; i++) {
+            w[i] = zero;
+        }
+        w[15] = length;
+        sha512_compress_lanes<V>(s, w);
+
+        for (int i = 0; i < 8; i++) {
+            uv[i] = s[i];
+            tv[i] = V::xor_(tv[i], s[i]);
+        }
+    }
+
+    for (int i = 0; i < 8; i++) {
+        V::store(u + i * V::LANES, uv[i]);
+        V::store(t + i * V::LANES, tv[i]);
+    }
+}
+
+} // namespace
+
+// Lane kernels provided by the instruction-set specific translation units
+void sha512_pbkdf2_iterate_avx2(const uint64_t* inner_state, const uint64_t* outer_state,
+                                uint64_t* u, uint64_t* t, uint32_t rounds);
+void sha512_pbkdf2_iterate_avx512(const uint64_t* inner_state, const uint64_t* outer_state,
+                                  uint64_t* u, uint64_t* t, uint32_t rounds);
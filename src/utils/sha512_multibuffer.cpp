@@ -0,0 +1,137 @@
+#include "utils/sha512_multibuffer.h"
+#include "utils/pbkdf2_sha512.h"
+#include "sha512_lanes.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Single-lane fallback runs the shared reference implementation
+void iterate_scalar(const uint64_t* inner_state, const uint64_t* outer_state,
+                    uint64_t* u, uint64_t* t, uint32_t rounds) {
+    HMACSHA512State pads;
+    for (int i = 0; i < 8; i++) {
+        pads.inner[i] = inner_state[i];
+        pads.outer[i] = outer_state[i];
+    }
+    pbkdf2_sha512_iterate(pads, u, t, rounds);
+}
+
+using IterateFunction = void (*)(const uint64_t*, const uint64_t*, uint64_t*, uint64_t*, uint32_t);
+
+IterateFunction get_iterate_function(SIMDLevel level) {
+    switch (level) {
+#ifdef ENABLE_SHA512_AVX512
+        case SIMDLevel::AVX512:
+            return sha512_pbkdf2_iterate_avx512;
+#endif
+#ifdef ENABLE_SHA512_AVX2
+        case SIMDLevel::AVX2:
+            return sha512_pbkdf2_iterate_avx2;
+#endif
+        default:
+            return iterate_scalar;
+    }
+}
+
+} // namespace
+
+SIMDLevel SHA512MultiBuffer::detect_simd_level() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+#ifdef ENABLE_SHA512_AVX512
+    if (__builtin_cpu_supports("avx512f")) {
+        return SIMDLevel::AVX512;
+    }
+#endif
+#ifdef ENABLE_SHA512_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMDLevel::AVX2;
+    }
+#endif
+#endif
+    return SIMDLevel::SCALAR;
+}
+
+SIMDLevel SHA512MultiBuffer::get_active_level() {
+    static const SIMDLevel level = detect_simd_level();
+    return level;
+}
+
+size_t SHA512MultiBuffer::get_lane_count(SIMDLevel level) {
+    switch (level) {
+        case SIMDLevel::AVX512: return 8;
+        case SIMDLevel::AVX2:   return 4;
+        default:                return 1;
+    }
+}
+
+std::string SHA512MultiBuffer::simd_level_to_string(SIMDLevel level) {
+    switch (level) {
+        case SIMDLevel::AVX512: return "AVX-512";
+        case SIMDLevel::AVX2:   return "AVX2";
+        default:                return "scalar";
+    }
+}
+
+void SHA512MultiBuffer::pbkdf2_hmac_sha512(const uint8_t* const* passwords, const size_t* lengths, size_t count,
+                                           const uint8_t* salt, size_t salt_length, uint32_t iterations,
+                                           uint8_t* derived_keys, size_t key_length, SIMDLevel level) {
+    if (count == 0 || key_length == 0 || iterations == 0) {
+        return;
+    }
+
+    // Fall back to a level this build actually provides
+    IterateFunction iterate = get_iterate_function(level);
+    if (iterate == iterate_scalar) {
+        level = SIMDLevel::SCALAR;
+    }
+    const size_t lanes = get_lane_count(level);
+    const uint32_t block_count = static_cast<uint32_t>((key_length + 63) / 64);
+
+    // Word-major lane buffers: element [word * lanes + lane]
+    HMACSHA512State pads[MAX_LANES];
+    uint64_t inner[8 * MAX_LANES];
+    uint64_t outer[8 * MAX_LANES];
+    uint64_t u[8 * MAX_LANES];
+    uint64_t t[8 * MAX_LANES];
+
+    for (size_t start = 0; start < count; start += lanes) {
+        const size_t active = std::min(lanes, count - start);
+
+        // Idle lanes repeat the last candidate so every lane has valid input
+        for (size_t lane = 0; lane < lanes; lane++) {
+            const size_t index = start + std::min(lane, active - 1);
+            hmac_sha512_precompute(passwords[index], lengths[index], pads[lane]);
+            for (int word = 0; word < 8; word++) {
+                inner[word * lanes + lane] = pads[lane].inner[word];
+                outer[word * lanes + lane] = pads[lane].outer[word];
+            }
+        }
+
+        for (uint32_t block = 1; block <= block_count; block++) {
+            for (size_t lane = 0; lane < lanes; lane++) {
+                uint64_t lane_u[8];
+                pbkdf2_sha512_first_block(pads[lane], salt, salt_length, block, lane_u);
+                for (int word = 0; word < 8; word++) {
+                    u[word * lanes + lane] = lane_u[word];
+                    t[word * lanes + lane] = lane_u[word];
+                }
+            }
+
+            if (iterations > 1) {
+                iterate(inner, outer, u, t, iterations - 1);
+            }
+
+            const size_t offset = (block - 1) * 64;
+            const size_t block_bytes = std::min<size_t>(64, key_length - offset);
+            for (size_t lane = 0; lane < active; lane++) {
+                uint8_t digest[64];
+                for (int word = 0; word < 8; word++) {
+                    sha512_store_be64(digest + word * 8, t[word * lanes + lane]);
+                }
+                std::memcpy(derived_keys + (start + lane) * key_length + offset, digest, block_bytes);
+            }
+        }
+    }
+}
@@ -0,0 +1,449 @@
+#include "wallets/balance_checker.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <curl/curl.h>
+#include <json/json.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Requests beyond this many providers would not fit the per-address tried mask
+constexpr size_t MAX_PROVIDERS = 32;
+
+// Upper bound on one curl_multi_poll wait so token refills are noticed promptly
+constexpr int MAX_POLL_MS = 100;
+
+// Rate-limit responses an address may collect before it is given up
+constexpr uint8_t MAX_RATE_LIMITED = 4;
+
+size_t write_callback(void* contents, size_t size, size_t nmemb, void* user) {
+    size_t total_size = size * nmemb;
+    static_cast<std::string*>(user)->append(static_cast<const char*>(contents), total_size);
+    return total_size;
+}
+
+std::string join(const std::vector<std::string>& addresses, const std::vector<size_t>& indices, char separator) {
+    std::string joined;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        if (i > 0) joined += separator;
+        joined += addresses[indices[i]];
+    }
+    return joined;
+}
+
+} // namespace
+
+/**
+ * Token bucket: `rate` tokens per second up to `capacity`, one token per request
+ */
+struct TokenBucket {
+    double tokens = 0.0;
+    double rate = 1.0;
+    double capacity = 1.0;
+    Clock::time_point last_refill = Clock::now();
+    Clock::time_point blocked_until = Clock::time_point::min();
+
+    void refill(Clock::time_point now) {
+        double elapsed = std::chrono::duration<double>(now - last_refill).count();
+        tokens = std::min(capacity, tokens + elapsed * rate);
+        last_refill = now;
+    }
+
+    bool try_take(Clock::time_point now) {
+        refill(now);
+        if (now < blocked_until || tokens < 1.0) {
+            return false;
+        }
+        tokens -= 1.0;
+        return true;
+    }
+
+    void refund() { tokens = std::min(capacity, tokens + 1.0); }
+
+    // Provider told us to slow down: empty the bucket and stay quiet for a while
+    void back_off(Clock::time_point now, std::chrono::milliseconds delay) {
+        tokens = 0.0;
+        blocked_until = std::max(blocked_until, now + delay);
+    }
+
+    std::chrono::milliseconds time_until_token(Clock::time_point now) const {
+        if (now < blocked_until) {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(blocked_until - now);
+        }
+        if (tokens >= 1.0) {
+            return std::chrono::milliseconds(0);
+        }
+        return std::chrono::milliseconds(static_cast<long>((1.0 - tokens) / rate * 1000.0) + 1);
+    }
+};
+
+struct BalanceChecker::ProviderState {
+    BalanceProvider config;
+    TokenBucket bucket;
+    long active = 0;
+};
+
+struct BalanceChecker::Request {
+    size_t provider_index;
+    std::vector<size_t> address_indices;
+    std::string url;
+    std::string body;
+    CURL* handle;
+};
+
+BalanceChecker::BalanceChecker() : timeout_(30), multi_(nullptr) {
+    static std::once_flag curl_init;
+    std::call_once(curl_init, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+    CURLM* multi = curl_multi_init();
+    if (multi) {
+        // HTTP/2 providers multiplex a batch of requests over one connection
+        curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    }
+    multi_ = multi;
+}
+
+BalanceChecker::~BalanceChecker() {
+    for (void* handle : idle_handles_) {
+        curl_easy_cleanup(static_cast<CURL*>(handle));
+    }
+    if (multi_) {
+        curl_multi_cleanup(static_cast<CURLM*>(multi_));
+    }
+}
+
+void BalanceChecker::add_provider(const BalanceProvider& provider) {
+    if (providers_.size() >= MAX_PROVIDERS || provider.endpoint.empty()) {
+        return;
+    }
+
+    ProviderState state;
+    state.config = provider;
+    state.config.requests_per_second = std::max(provider.requests_per_second, 0.01);
+    state.config.burst = std::max(provider.burst, 1.0);
+    state.config.batch_size = std::max<size_t>(provider.batch_size, 1);
+    state.config.max_connections = std::max(provider.max_connections, 1L);
+    state.bucket.rate = state.config.requests_per_second;
+    state.bucket.capacity = state.config.burst;
+    state.bucket.tokens = state.config.burst;
+    providers_.push_back(state);
+
+    // Keep enough idle connections cached that every provider finds its own warm
+    long cached = 0;
+    for (const ProviderState& p : providers_) {
+        cached += p.config.max_connections;
+    }
+    if (multi_) {
+        curl_multi_setopt(static_cast<CURLM*>(multi_), CURLMOPT_MAXCONNECTS, cached);
+    }
+}
+
+BalanceProvider BalanceChecker::default_provider(BalanceProviderType type, const std::string& name,
+                                                 const std::string& endpoint, const std::string& api_key) {
+    BalanceProvider provider;
+    provider.type = type;
+    provider.name = name;
+    provider.endpoint = endpoint;
+    provider.api_key = api_key;
+
+    switch (type) {
+        case BalanceProviderType::BLOCKSTREAM:
+            provider.requests_per_second = 8.0;
+            provider.burst = 16.0;
+            provider.batch_size = 1;
+            provider.max_connections = 4;
+            break;
+        case BalanceProviderType::BLOCKCHAIR:
+            // Free tier allows 30 requests per minute; a key lifts that considerably
+            provider.requests_per_second = api_key.empty() ? 0.5 : 5.0;
+            provider.burst = api_key.empty() ? 3.0 : 10.0;
+            provider.batch_size = 100;
+            provider.max_connections = 2;
+            break;
+        case BalanceProviderType::BLOCKCYPHER:
+            // Free tier: 3 requests per second, batches of at most 3 addresses
+            provider.requests_per_second = api_key.empty() ? 2.5 : 10.0;
+            provider.burst = api_key.empty() ? 3.0 : 10.0;
+            provider.batch_size = api_key.empty() ? 3 : 100;
+            provider.max_connections = 2;
+            break;
+    }
+
+    return provider;
+}
+
+void* BalanceChecker::acquire_handle() {
+    if (!idle_handles_.empty()) {
+        CURL* handle = static_cast<CURL*>(idle_handles_.back());
+        idle_handles_.pop_back();
+        curl_easy_reset(handle);
+        return handle;
+    }
+    return curl_easy_init();
+}
+
+void BalanceChecker::release_handle(void* handle) {
+    idle_handles_.push_back(handle);
+}
+
+bool BalanceChecker::start_request(size_t provider_index, std::vector<size_t> address_indices,
+                                   const std::vector<std::string>& addresses, std::vector<Request*>& in_flight) {
+    ProviderState& provider = providers_[provider_index];
+    CURL* handle = static_cast<CURL*>(acquire_handle());
+    if (!handle) {
+        return false;
+    }
+
+    Request* request = new Request{provider_index, std::move(address_indices), "", "", handle};
+    const std::string& endpoint = provider.config.endpoint;
+    const std::string& api_key = provider.config.api_key;
+
+    switch (provider.config.type) {
+        case BalanceProviderType::BLOCKSTREAM:
+            request->url = endpoint + "/address/" + addresses[request->address_indices.front()];
+            break;
+        case BalanceProviderType::BLOCKCHAIR:
+            request->url = endpoint + "/dashboards/addresses/" + join(addresses, request->address_indices, ',');
+            if (!api_key.empty()) request->url += "?key=" + api_key;
+            break;
+        case BalanceProviderType::BLOCKCYPHER:
+            request->url = endpoint + "/addrs/" + join(addresses, request->address_indices, ';') + "/balance";
+            if (!api_key.empty()) request->url += "?token=" + api_key;
+            break;
+    }
+
+    curl_easy_setopt(handle, CURLOPT_URL, request->url.c_str());
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &request->body);
+    curl_easy_setopt(handle, CURLOPT_PRIVATE, request);
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT, static_cast<long>(timeout_.count()));
+    curl_easy_setopt(handle, CURLOPT_USERAGENT, "btc-recovery/1.0");
+    curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "");
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+
+    if (curl_multi_add_handle(static_cast<CURLM*>(multi_), handle) != CURLM_OK) {
+        release_handle(handle);
+        delete request;
+        return false;
+    }
+
+    provider.active++;
+    in_flight.push_back(request);
+    return true;
+}
+
+bool BalanceChecker::parse_response(const ProviderState& provider, const std::string& body,
+                                    const std::vector<std::string>& addresses,
+                                    const std::vector<size_t>& address_indices,
+                                    std::vector<BalanceResult>& results) {
+    Json::Value root;
+    Json::Reader reader;
+    if (!reader.parse(body, root)) {
+        return false;
+    }
+
+    auto store = [&](size_t index, uint64_t balance, int tx_count) {
+        results[index].success = true;
+        results[index].balance_satoshis = balance;
+        results[index].transaction_count = tx_count;
+        results[index].provider = provider.config.name;
+    };
+
+    switch (provider.config.type) {
+        case BalanceProviderType::BLOCKSTREAM: {
+            if (!root.isMember("chain_stats")) {
+                return false;
+            }
+            // Esplora reports totals; the balance is what was received minus what was spent
+            const Json::Value& stats = root["chain_stats"];
+            uint64_t funded = stats.get("funded_txo_sum", 0).asUInt64();
+            uint64_t spent = stats.get("spent_txo_sum", 0).asUInt64();
+            store(address_indices.front(), funded >= spent ? funded - spent : 0, stats.get("tx_count", 0).asInt());
+            return true;
+        }
+
+        case BalanceProviderType::BLOCKCHAIR: {
+            const Json::Value& entries = root["data"]["addresses"];
+            if (!entries.isObject()) {
+                return false;
+            }
+            for (size_t index : address_indices) {
+                const Json::Value& entry = entries[addresses[index]];
+                if (entry.isObject()) {
+                    int tx_count = entry.isMember("transaction_count") ? entry["transaction_count"].asInt()
+                                                                      : entry.get("output_count", 0).asInt();
+                    store(index, entry.get("balance", 0).asUInt64(), tx_count);
+                }
+            }
+            return true;
+        }
+
+        case BalanceProviderType::BLOCKCYPHER: {
+            // A single address comes back as an object, a batch as an array
+            Json::Value entries = root.isArray() ? root : Json::Value(Json::arrayValue);
+            if (root.isObject()) {
+                entries.append(root);
+            }
+            for (const Json::Value& entry : entries) {
+                if (!entry.isMember("address") || entry.isMember("error")) {
+                    continue;
+                }
+                const std::string address = entry["address"].asString();
+                for (size_t index : address_indices) {
+                    if (addresses[index] == address) {
+                        store(index, entry.get("balance", 0).asUInt64(), entry.get("n_tx", 0).asInt());
+                        break;
+                    }
+                }
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t BalanceChecker::check(const std::vector<std::string>& addresses, std::vector<BalanceResult>& results) {
+    results.assign(addresses.size(), BalanceResult());
+    if (addresses.empty() || providers_.empty() || !multi_) {
+        return 0;
+    }
+
+    CURLM* multi = static_cast<CURLM*>(multi_);
+    const uint32_t all_tried = providers_.size() == 32 ? ~0u : (1u << providers_.size()) - 1;
+    std::vector<uint32_t> tried(addresses.size(), 0);
+    std::vector<uint8_t> rate_limited(addresses.size(), 0);
+    std::deque<size_t> pending;
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        pending.push_back(i);
+    }
+
+    std::vector<Request*> in_flight;
+    size_t completed_requests = 0;
+    size_t failed_requests = 0;
+
+    while (!pending.empty() || !in_flight.empty()) {
+        Clock::time_point now = Clock::now();
+
+        // Hand queued addresses to every provider that has a free connection and a token
+        for (size_t p = 0; p < providers_.size() && !pending.empty(); ++p) {
+            ProviderState& provider = providers_[p];
+            const uint32_t bit = 1u << p;
+
+            while (provider.active < provider.config.max_connections && !pending.empty() &&
+                   provider.bucket.try_take(now)) {
+                std::vector<size_t> batch;
+                for (auto it = pending.begin(); it != pending.end() && batch.size() < provider.config.batch_size;) {
+                    if ((tried[*it] & bit) == 0) {
+                        batch.push_back(*it);
+                        it = pending.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+
+                if (batch.empty()) {
+                    provider.bucket.refund();
+                    break;
+                }
+
+                for (size_t index : batch) {
+                    tried[index] |= bit;
+                }
+                std::vector<size_t> retry = batch;
+                if (!start_request(p, std::move(batch), addresses, in_flight)) {
+                    pending.insert(pending.begin(), retry.begin(), retry.end());
+                    break;
+                }
+            }
+        }
+
+        // Addresses every provider has already failed on are given up
+        pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                     [&](size_t index) { return tried[index] == all_tried; }),
+                      pending.end());
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg* message = nullptr;
+        int remaining = 0;
+        while ((message = curl_multi_info_read(multi, &remaining)) != nullptr) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+
+            CURL* handle = message->easy_handle;
+            Request* request = nullptr;
+            curl_easy_getinfo(handle, CURLINFO_PRIVATE, &request);
+            long response_code = 0;
+            curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &response_code);
+
+            ProviderState& provider = providers_[request->provider_index];
+            bool parsed = message->data.result == CURLE_OK && response_code == 200 &&
+                          parse_response(provider, request->body, addresses, request->address_indices, results);
+
+            if (response_code == 429 || response_code == 503) {
+                curl_off_t retry_after = 0;
+                curl_easy_getinfo(handle, CURLINFO_RETRY_AFTER, &retry_after);
+                std::chrono::milliseconds delay(retry_after > 0 ? retry_after * 1000 : 5000);
+                provider.bucket.back_off(Clock::now(), delay);
+                Logger::warn("Rate limited by " + provider.config.name + ", backing off " +
+                             std::to_string(delay.count()) + " ms");
+
+                // The provider never looked at these addresses, so it may be asked
+                // again once it lets up, unless it keeps refusing them
+                const uint32_t bit = 1u << request->provider_index;
+                for (size_t index : request->address_indices) {
+                    if (++rate_limited[index] < MAX_RATE_LIMITED) {
+                        tried[index] &= ~bit;
+                    }
+                }
+            } else if (!parsed) {
+                LOG_DEBUG("Balance query failed on " + provider.config.name + " (HTTP " +
+                              std::to_string(response_code) + "): " + request->url);
+            }
+            parsed ? completed_requests++ : failed_requests++;
+
+            // Anything this provider did not answer goes back for the next one
+            for (size_t index : request->address_indices) {
+                if (!results[index].success) {
+                    pending.push_front(index);
+                }
+            }
+
+            curl_multi_remove_handle(multi, handle);
+            release_handle(handle);
+            provider.active--;
+            in_flight.erase(std::find(in_flight.begin(), in_flight.end(), request));
+            delete request;
+        }
+
+        if (pending.empty() && in_flight.empty()) {
+            break;
+        }
+
+        // Sleep until a transfer needs attention or the next token becomes available
+        int wait_ms = MAX_POLL_MS;
+        if (!pending.empty()) {
+            now = Clock::now();
+            for (const ProviderState& provider : providers_) {
+                if (provider.active < provider.config.max_connections) {
+                    wait_ms = std::min<int>(wait_ms, static_cast<int>(provider.bucket.time_until_token(now).count()));
+                }
+            }
+        }
+        curl_multi_poll(multi, nullptr, 0, std::max(wait_ms, 1), nullptr);
+    }
+
+    size_t answered = static_cast<size_t>(std::count_if(results.begin(), results.end(),
+                                                        [](const BalanceResult& r) { return r.success; }));
+    LOG_DEBUG("Balance checker: " + std::to_string(completed_requests) + " requests succeeded, " +
+                  std::to_string(failed_requests) + " failed");
+    return answered;
+}
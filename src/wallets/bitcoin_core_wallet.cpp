@@ -1,18 +1,125 @@
 #include "wallets/bitcoin_core_wallet.h"
+#include "wallets/balance_checker.h"
 #include "utils/logger.h"
+#include "utils/aes256_verify.h"
+#include "utils/base58.h"
+#include "utils/pbkdf2_sha512.h"
+#include "utils/sha512_multibuffer.h"
+#include "utils/secp256k1_gen.h"
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <thread>
 #include <openssl/sha.h>
 #include <openssl/ripemd.h>
-#include <openssl/ec.h>
-#include <openssl/ecdsa.h>
-#include <openssl/obj_mac.h>
-#include <curl/curl.h>
 #include <json/json.h>
 
+// Berkeley DB on-disk layout (db_page.h); offsets are from the start of a page
+static constexpr uint32_t BDB_BTREE_MAGIC = 0x00053162;
+static constexpr size_t BDB_MIN_PAGE_SIZE = 512;
+static constexpr size_t BDB_MAX_PAGE_SIZE = 65536;
+static constexpr size_t BDB_META_MAGIC = 12;
+static constexpr size_t BDB_META_PAGE_SIZE = 20;
+static constexpr size_t BDB_META_LAST_PAGE = 32;
+static constexpr size_t BDB_BTMETA_ROOT = 88;
+static constexpr size_t BDB_PAGE_NEXT = 16;
+static constexpr size_t BDB_PAGE_ENTRIES = 20;
+static constexpr size_t BDB_PAGE_TYPE = 25;
+static constexpr size_t BDB_PAGE_INDEX = 26;
+static constexpr size_t BDB_BINTERNAL_PGNO = 4;
+static constexpr size_t BDB_BINTERNAL_SIZE = 12;
+static constexpr size_t BDB_BKEYDATA_HEADER = 3;
+static constexpr uint8_t BDB_P_IBTREE = 3;
+static constexpr uint8_t BDB_P_LBTREE = 5;
+static constexpr uint8_t BDB_P_BTREEMETA = 9;
+static constexpr uint8_t BDB_B_KEYDATA = 1;
+static constexpr uint8_t BDB_B_DELETE = 0x80;
+static constexpr int BDB_MAX_DEPTH = 32;
+
+static uint16_t bdb_read_u16(const uint8_t* p, bool swapped) {
+    return swapped ? static_cast<uint16_t>((p[0] << 8) | p[1])
+                   : static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t bdb_read_u32(const uint8_t* p, bool swapped) {
+    return swapped ? (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3]
+                   : uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static std::string to_hex(const uint8_t* data, size_t length) {
+    static const char* digits = "0123456789abcdef";
+    std::string hex(length * 2, '0');
+    for (size_t i = 0; i < length; i++) {
+        hex[2 * i] = digits[data[i] >> 4];
+        hex[2 * i + 1] = digits[data[i] & 0x0f];
+    }
+    return hex;
+}
+
+// Resolve leaf entry `index` to its inline bytes; false for deleted or overflow items
+static bool bdb_leaf_item(const uint8_t* page, size_t page_size, uint16_t index, bool swapped, ByteSpan& item) {
+    const size_t offset = bdb_read_u16(page + BDB_PAGE_INDEX + index * sizeof(uint16_t), swapped);
+    if (offset < BDB_PAGE_INDEX || offset + BDB_BKEYDATA_HEADER > page_size) {
+        return false;
+    }
+
+    const uint8_t type = page[offset + 2];
+    if ((type & BDB_B_DELETE) != 0 || type != BDB_B_KEYDATA) {
+        return false;
+    }
+
+    const size_t length = bdb_read_u16(page + offset, swapped);
+    if (offset + BDB_BKEYDATA_HEADER + length > page_size) {
+        return false;
+    }
+
+    item = ByteSpan(page + offset + BDB_BKEYDATA_HEADER, length);
+    return true;
+}
+
+// Bitcoin's own serialization inside record keys and values: little-endian, CompactSize prefixes
+struct WalletRecordReader {
+    ByteSpan data;
+    size_t position = 0;
+
+    explicit WalletRecordReader(ByteSpan span) : data(span) {}
+
+    bool read_compact_size(uint64_t& value) {
+        if (position >= data.size()) return false;
+        const uint8_t prefix = data[position++];
+        size_t width = prefix == 0xfd ? 2 : prefix == 0xfe ? 4 : prefix == 0xff ? 8 : 0;
+        if (width == 0) {
+            value = prefix;
+            return true;
+        }
+        if (data.size() - position < width) return false;
+        value = 0;
+        for (size_t i = 0; i < width; ++i) {
+            value |= uint64_t(data[position + i]) << (8 * i);
+        }
+        position += width;
+        return true;
+    }
+
+    bool read_vector(ByteSpan& out) {
+        uint64_t length = 0;
+        if (!read_compact_size(length) || length > data.size() - position) return false;
+        out = data.subspan(position, static_cast<size_t>(length));
+        position += static_cast<size_t>(length);
+        return true;
+    }
+
+    bool read_u32(uint32_t& value) {
+        if (data.size() - position < 4) return false;
+        value = bdb_read_u32(data.data() + position, false);
+        position += 4;
+        return true;
+    }
+};
+
 BitcoinCoreWallet::BitcoinCoreWallet(const std::string& wallet_file) 
     : WalletBase(wallet_file), testnet_mode_(false), loaded_(false) {
     
@@ -38,12 +145,14 @@ bool BitcoinCoreWallet::load() {
         return false;
     }
 
-    // Read wallet file
-    wallet_data_ = read_file(wallet_file_);
-    if (wallet_data_.empty()) {
+    // Map the wallet file; records are referenced in place rather than copied
+    if (!wallet_file_map_.open(wallet_file_) || wallet_file_map_.size() == 0) {
         set_error("Failed to read wallet file or file is empty");
         return false;
     }
+    master_keys_.clear();
+    crypted_keys_.clear();
+    key_labels_.clear();
 
     // Parse Berkeley DB format
     if (!parse_bdb_file()) {
@@ -73,7 +182,7 @@ bool BitcoinCoreWallet::test_password(const std::string& password) {
         std::vector<uint8_t> decrypted_key;
         
         if (decrypt_master_key(password, master_key, decrypted_key)) {
-            Logger::debug("Password verification successful");
+            LOG_DEBUG("Password verification successful");
             return true;
         }
     }
@@ -81,6 +190,124 @@ bool BitcoinCoreWallet::test_password(const std::string& password) {
     return false;
 }
 
+int BitcoinCoreWallet::test_passwords(const std::string* passwords, size_t count) {
+    if (!loaded_ && !load()) {
+        return -1;
+    }
+
+    if (master_keys_.empty()) {
+        set_error("No master keys found in wallet");
+        return -1;
+    }
+
+    const uint8_t* password_ptrs[DERIVATION_GROUP_SIZE];
+    size_t password_lengths[DERIVATION_GROUP_SIZE];
+
+    for (size_t start = 0; start < count; start += DERIVATION_GROUP_SIZE) {
+        const size_t group_count = std::min(DERIVATION_GROUP_SIZE, count - start);
+        for (size_t i = 0; i < group_count; i++) {
+            password_ptrs[i] = reinterpret_cast<const uint8_t*>(passwords[start + i].data());
+            password_lengths[i] = passwords[start + i].size();
+        }
+
+        int match = test_derivation_group(password_ptrs, password_lengths, group_count);
+        if (match >= 0) {
+            return static_cast<int>(start) + match;
+        }
+    }
+
+    return -1;
+}
+
+int BitcoinCoreWallet::test_passwords(const CandidateBatch& batch) {
+    if (!loaded_ && !load()) {
+        return -1;
+    }
+
+    if (master_keys_.empty()) {
+        set_error("No master keys found in wallet");
+        return -1;
+    }
+
+    // Candidates are read in place from the batch slots
+    const uint8_t* password_ptrs[DERIVATION_GROUP_SIZE];
+    size_t password_lengths[DERIVATION_GROUP_SIZE];
+    const size_t count = batch.size();
+
+    for (size_t start = 0; start < count; start += DERIVATION_GROUP_SIZE) {
+        const size_t group_count = std::min(DERIVATION_GROUP_SIZE, count - start);
+        for (size_t i = 0; i < group_count; i++) {
+            password_ptrs[i] = batch.data(start + i);
+            password_lengths[i] = batch.length(start + i);
+        }
+
+        int match = test_derivation_group(password_ptrs, password_lengths, group_count);
+        if (match >= 0) {
+            return static_cast<int>(start) + match;
+        }
+    }
+
+    return -1;
+}
+
+int BitcoinCoreWallet::test_derivation_group(const uint8_t* const* passwords, const size_t* lengths,
+                                             size_t count) {
+    uint8_t derived_keys[DERIVATION_GROUP_SIZE * 32];
+    std::vector<uint8_t>& decrypted_key = scratch_decrypted_key_;
+
+    for (const auto& mk_pair : master_keys_) {
+        const MasterKey& master_key = mk_pair.second;
+
+        SHA512MultiBuffer::pbkdf2_hmac_sha512(passwords, lengths, count,
+                                              master_key.salt.data(), master_key.salt.size(),
+                                              master_key.derive_iterations, derived_keys, 32);
+
+        for (size_t i = 0; i < count; i++) {
+            if (decrypt_master_key_with_derived(derived_keys + i * 32, master_key, decrypted_key)) {
+                LOG_DEBUG("Password verification successful");
+                return static_cast<int>(i);
+            }
+        }
+    }
+
+    return -1;
+}
+
+bool BitcoinCoreWallet::get_master_key_check(BitcoinCoreMKeyCheck& check) {
+    if (!loaded_ && !load()) {
+        return false;
+    }
+
+    if (master_keys_.empty()) {
+        set_error("No master keys found in wallet");
+        return false;
+    }
+
+    // Layout matches decrypt_master_key_with_derived: 16-byte IV, then the ciphertext
+    const MasterKey& master_key = master_keys_.begin()->second;
+    const ByteSpan& encrypted = master_key.encrypted_key;
+    if (encrypted.size() < 32 || encrypted.size() % 16 != 0 ||
+        master_key.salt.size() > BITCOIN_CORE_MKEY_MAX_SALT) {
+        set_error("Master key does not fit the verification record");
+        return false;
+    }
+
+    std::memset(&check, 0, sizeof(check));
+    std::memcpy(check.salt, master_key.salt.data(), master_key.salt.size());
+    check.salt_length = static_cast<uint32_t>(master_key.salt.size());
+    check.iterations = master_key.derive_iterations;
+    std::memcpy(check.previous_block, encrypted.data() + encrypted.size() - 32, 16);
+    std::memcpy(check.last_block, encrypted.data() + encrypted.size() - 16, 16);
+
+    // A 32-byte master key fixes the pad length, which makes false accepts negligible
+    const size_t ciphertext_length = encrypted.size() - 16;
+    if (ciphertext_length > 32 && ciphertext_length - 32 <= 16) {
+        check.expected_padding = static_cast<uint8_t>(ciphertext_length - 32);
+    }
+
+    return true;
+}
+
 WalletRecoveryResult BitcoinCoreWallet::recover_wallet(const std::string& password) {
     WalletRecoveryResult result;
     result.success = false;
@@ -157,67 +384,37 @@ std::vector<PrivateKeyInfo> BitcoinCoreWallet::extract_private_keys(const std::s
 
     Logger::info("Master key decrypted, processing " + std::to_string(crypted_keys_.size()) + " encrypted keys...");
 
-    // Decrypt all private keys
-    for (const auto& ck_pair : crypted_keys_) {
-        const CryptedKey& crypted_key = ck_pair.second;
-        std::vector<uint8_t> private_key_bytes;
-
-        if (decrypt_private_key(master_key, crypted_key, private_key_bytes)) {
-            PrivateKeyInfo key_info;
-            
-            // Convert private key to different formats
-            key_info.private_key_hex = "";
-            for (uint8_t byte : private_key_bytes) {
-                std::stringstream ss;
-                ss << std::hex << std::setw(2) << std::setfill('0') << (int)byte;
-                key_info.private_key_hex += ss.str();
-            }
-
-            // Generate public key and address
-            std::vector<uint8_t> public_key = private_key_to_public_key(private_key_bytes);
-            key_info.public_key_hex = "";
-            for (uint8_t byte : public_key) {
-                std::stringstream ss;
-                ss << std::hex << std::setw(2) << std::setfill('0') << (int)byte;
-                key_info.public_key_hex += ss.str();
-            }
+    // Keys are independent, so split them across threads; each worker keeps its
+    // own cipher context and writes only its own result slots
+    std::vector<std::vector<PrivateKeyInfo>> per_key(crypted_keys_.size());
+    std::atomic<size_t> next_key(0);
+    Secp256k1Gen::precompute();
 
-            // Try both compressed and uncompressed formats
-            std::string compressed_addr = public_key_to_address(public_key, true);
-            std::string uncompressed_addr = public_key_to_address(public_key, false);
-
-            // Use compressed format by default (more common in modern wallets)
-            key_info.address = compressed_addr;
-            key_info.compressed = true;
-            key_info.private_key_wif = private_key_to_wif(private_key_bytes, true);
+    auto worker = [&]() {
+        EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+        if (!ctx) {
+            return;
+        }
+        for (size_t index = next_key.fetch_add(1); index < crypted_keys_.size(); index = next_key.fetch_add(1)) {
+            derive_key_info(ctx, master_key, crypted_keys_[index], per_key[index]);
+        }
+        EVP_CIPHER_CTX_free(ctx);
+    };
 
-            // Check if we have a label for this key
-            auto label_it = key_labels_.find(key_info.address);
-            if (label_it != key_labels_.end()) {
-                key_info.label = label_it->second;
-            }
+    const size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                                 (crypted_keys_.size() + KEYS_PER_THREAD - 1) / KEYS_PER_THREAD);
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < thread_count; t++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
 
-            // Initialize balance fields
-            key_info.balance_satoshis = 0;
-            key_info.transaction_count = 0;
-            key_info.has_balance = false;
-
-            private_keys.push_back(key_info);
-
-            // Also add uncompressed version if different
-            if (compressed_addr != uncompressed_addr) {
-                PrivateKeyInfo uncompressed_key_info = key_info;
-                uncompressed_key_info.address = uncompressed_addr;
-                uncompressed_key_info.compressed = false;
-                uncompressed_key_info.private_key_wif = private_key_to_wif(private_key_bytes, false);
-                
-                auto uncompressed_label_it = key_labels_.find(uncompressed_addr);
-                if (uncompressed_label_it != key_labels_.end()) {
-                    uncompressed_key_info.label = uncompressed_label_it->second;
-                }
-                
-                private_keys.push_back(uncompressed_key_info);
-            }
+    for (auto& infos : per_key) {
+        for (auto& info : infos) {
+            private_keys.push_back(std::move(info));
         }
     }
 
@@ -225,6 +422,61 @@ std::vector<PrivateKeyInfo> BitcoinCoreWallet::extract_private_keys(const std::s
     return private_keys;
 }
 
+void BitcoinCoreWallet::derive_key_info(EVP_CIPHER_CTX* ctx, const std::vector<uint8_t>& master_key,
+                                         const CryptedKey& crypted_key, std::vector<PrivateKeyInfo>& out) const {
+    std::vector<uint8_t> private_key_bytes;
+    if (!decrypt_private_key(ctx, master_key, crypted_key, private_key_bytes)) {
+        return;
+    }
+
+    std::vector<uint8_t> public_key = private_key_to_public_key(private_key_bytes);
+    if (public_key.empty()) {
+        return;
+    }
+
+    PrivateKeyInfo key_info;
+    key_info.private_key_hex = to_hex(private_key_bytes.data(), private_key_bytes.size());
+    key_info.public_key_hex = to_hex(public_key.data(), public_key.size());
+
+    // Try both compressed and uncompressed formats
+    std::string compressed_addr = public_key_to_address(public_key, true);
+    std::string uncompressed_addr = public_key_to_address(public_key, false);
+
+    // Use compressed format by default (more common in modern wallets)
+    key_info.address = compressed_addr;
+    key_info.compressed = true;
+    key_info.private_key_wif = private_key_to_wif(private_key_bytes, true);
+
+    // Check if we have a label for this key
+    auto label_it = key_labels_.find(key_info.address);
+    if (label_it != key_labels_.end()) {
+        key_info.label = label_it->second;
+    }
+
+    // Initialize balance fields
+    key_info.balance_satoshis = 0;
+    key_info.transaction_count = 0;
+    key_info.has_balance = false;
+
+    out.push_back(key_info);
+
+    // Also add uncompressed version if different
+    if (compressed_addr != uncompressed_addr) {
+        PrivateKeyInfo uncompressed_key_info = key_info;
+        uncompressed_key_info.address = uncompressed_addr;
+        uncompressed_key_info.compressed = false;
+        uncompressed_key_info.private_key_wif = private_key_to_wif(private_key_bytes, false);
+        uncompressed_key_info.label.clear();
+
+        auto uncompressed_label_it = key_labels_.find(uncompressed_addr);
+        if (uncompressed_label_it != key_labels_.end()) {
+            uncompressed_key_info.label = uncompressed_label_it->second;
+        }
+
+        out.push_back(uncompressed_key_info);
+    }
+}
+
 bool BitcoinCoreWallet::check_balances(std::vector<PrivateKeyInfo>& private_keys) {
     if (private_keys.empty()) {
         return false;
@@ -232,30 +484,49 @@ bool BitcoinCoreWallet::check_balances(std::vector<PrivateKeyInfo>& private_keys
 
     Logger::info("Checking balances for " + std::to_string(private_keys.size()) + " addresses...");
 
-    int successful_queries = 0;
-    int failed_queries = 0;
-
-    for (auto& key_info : private_keys) {
-        uint64_t balance = 0;
-        int tx_count = 0;
+    // Providers in order of preference; blockchair has no testnet endpoint
+    BalanceChecker checker;
+    auto endpoint = [this](const std::string& service) {
+        auto it = api_endpoints_.find(testnet_mode_ ? service + "_testnet" : service);
+        return it != api_endpoints_.end() ? it->second : std::string();
+    };
+    auto api_key = [this](const std::string& service) {
+        auto it = api_keys_.find(service);
+        return it != api_keys_.end() ? it->second : std::string();
+    };
+    checker.add_provider(BalanceChecker::default_provider(BalanceProviderType::BLOCKSTREAM, "blockstream",
+                                                          endpoint("blockstream"), api_key("blockstream")));
+    checker.add_provider(BalanceChecker::default_provider(BalanceProviderType::BLOCKCHAIR, "blockchair",
+                                                          endpoint("blockchair"), api_key("blockchair")));
+    checker.add_provider(BalanceChecker::default_provider(BalanceProviderType::BLOCKCYPHER, "blockcypher",
+                                                          endpoint("blockcypher"), api_key("blockcypher")));
+
+    std::vector<std::string> addresses;
+    addresses.reserve(private_keys.size());
+    for (const auto& key_info : private_keys) {
+        addresses.push_back(key_info.address);
+    }
+
+    std::vector<BalanceResult> results;
+    const size_t successful_queries = checker.check(addresses, results);
+    const size_t failed_queries = private_keys.size() - successful_queries;
+
+    for (size_t i = 0; i < private_keys.size(); ++i) {
+        PrivateKeyInfo& key_info = private_keys[i];
+        if (!results[i].success) {
+            LOG_DEBUG("Failed to query balance for: " + key_info.address);
+            continue;
+        }
 
-        if (query_address_balance(key_info.address, balance, tx_count)) {
-            key_info.balance_satoshis = balance;
-            key_info.transaction_count = tx_count;
-            key_info.has_balance = (balance > 0);
-            successful_queries++;
+        key_info.balance_satoshis = results[i].balance_satoshis;
+        key_info.transaction_count = results[i].transaction_count;
+        key_info.has_balance = results[i].balance_satoshis > 0;
 
-            if (balance > 0) {
-                Logger::info("Found balance: " + key_info.address + " = " + 
-                           format_balance(balance) + " BTC (" + std::to_string(tx_count) + " txs)");
-            }
-        } else {
-            failed_queries++;
-            Logger::debug("Failed to query balance for: " + key_info.address);
+        if (key_info.has_balance) {
+            Logger::info("Found balance: " + key_info.address + " = " + 
+                       format_balance(key_info.balance_satoshis) + " BTC (" +
+                       std::to_string(key_info.transaction_count) + " txs, via " + results[i].provider + ")");
         }
-
-        // Add small delay to avoid rate limiting
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
     Logger::info("Balance check completed: " + std::to_string(successful_queries) + 
@@ -265,26 +536,49 @@ bool BitcoinCoreWallet::check_balances(std::vector<PrivateKeyInfo>& private_keys
 }
 
 bool BitcoinCoreWallet::parse_bdb_file() {
-    if (wallet_data_.size() < sizeof(BDBHeader)) {
+    const uint8_t* meta = wallet_file_map_.data();
+    if (wallet_file_map_.size() < BDB_MIN_PAGE_SIZE) {
         set_error("Wallet file too small to contain valid Berkeley DB header");
         return false;
     }
 
-    // Check Berkeley DB magic number
-    uint32_t magic = *reinterpret_cast<const uint32_t*>(wallet_data_.data());
-    if (magic != 0x00061561 && magic != 0x61150600) { // Little and big endian
+    // Page 0 is the btree metadata page; its magic also tells us the byte order
+    const uint32_t magic = bdb_read_u32(meta + BDB_META_MAGIC, false);
+    if (magic == BDB_BTREE_MAGIC) {
+        bdb_swapped_ = false;
+    } else if (bdb_read_u32(meta + BDB_META_MAGIC, true) == BDB_BTREE_MAGIC) {
+        bdb_swapped_ = true;
+    } else {
         set_error("Invalid Berkeley DB magic number");
         return false;
     }
 
-    Logger::debug("Valid Berkeley DB format detected");
+    bdb_page_size_ = bdb_read_u32(meta + BDB_META_PAGE_SIZE, bdb_swapped_);
+    if (bdb_page_size_ < BDB_MIN_PAGE_SIZE || bdb_page_size_ > BDB_MAX_PAGE_SIZE ||
+        (bdb_page_size_ & (bdb_page_size_ - 1)) != 0) {
+        set_error("Invalid Berkeley DB page size: " + std::to_string(bdb_page_size_));
+        return false;
+    }
 
-    // Parse the database pages to extract key-value pairs
-    size_t offset = 0;
-    while (offset < wallet_data_.size()) {
-        if (!parse_bdb_page(wallet_data_, offset)) {
-            break; // Continue parsing even if some pages fail
-        }
+    // Never trust last_pgno beyond what the file actually holds
+    const size_t pages_in_file = wallet_file_map_.size() / bdb_page_size_;
+    bdb_last_page_ = bdb_read_u32(meta + BDB_META_LAST_PAGE, bdb_swapped_);
+    if (pages_in_file == 0) {
+        set_error("Wallet file is shorter than one Berkeley DB page");
+        return false;
+    }
+    if (bdb_last_page_ >= pages_in_file) {
+        bdb_last_page_ = static_cast<uint32_t>(pages_in_file - 1);
+    }
+
+    LOG_DEBUG("Valid Berkeley DB format detected (page size " + std::to_string(bdb_page_size_) +
+                  ", " + std::to_string(bdb_last_page_ + 1) + " pages)");
+
+    // The master database either holds the records itself or names the "main" subdatabase
+    const uint32_t root = bdb_read_u32(meta + BDB_BTMETA_ROOT, bdb_swapped_);
+    if (!walk_bdb_btree(root, true)) {
+        set_error("Failed to walk Berkeley DB btree");
+        return false;
     }
 
     Logger::info("Parsed wallet.dat: found " + std::to_string(master_keys_.size()) + 
@@ -293,6 +587,133 @@ bool BitcoinCoreWallet::parse_bdb_file() {
     return !master_keys_.empty() && !crypted_keys_.empty();
 }
 
+const uint8_t* BitcoinCoreWallet::bdb_page(uint32_t page_number) const {
+    if (page_number > bdb_last_page_) {
+        return nullptr;
+    }
+    return wallet_file_map_.data() + static_cast<size_t>(page_number) * bdb_page_size_;
+}
+
+bool BitcoinCoreWallet::walk_bdb_btree(uint32_t root_page, bool master_database) {
+    // Descend along the leftmost edge to the first leaf
+    const uint8_t* page = bdb_page(root_page);
+    for (int depth = 0; page && page[BDB_PAGE_TYPE] == BDB_P_IBTREE; ++depth) {
+        const uint16_t entries = bdb_read_u16(page + BDB_PAGE_ENTRIES, bdb_swapped_);
+        const uint16_t item = bdb_read_u16(page + BDB_PAGE_INDEX, bdb_swapped_);
+        if (depth >= BDB_MAX_DEPTH || entries == 0 || item + BDB_BINTERNAL_SIZE > bdb_page_size_) {
+            return false;
+        }
+        page = bdb_page(bdb_read_u32(page + item + BDB_BINTERNAL_PGNO, bdb_swapped_));
+    }
+
+    if (!page || page[BDB_PAGE_TYPE] != BDB_P_LBTREE) {
+        return false;
+    }
+
+    // Leaves are chained left to right, so internal pages beyond the first path are never read.
+    // Pages holding no mkey or ckey record are handed back once parsed; the rest stay resident
+    // because the stored spans point into them.
+    for (uint32_t visited = 0; page && visited <= bdb_last_page_; ++visited) {
+        if (page[BDB_PAGE_TYPE] != BDB_P_LBTREE) {
+            return false;
+        }
+        const bool referenced = parse_bdb_page(page, master_database);
+
+        const size_t offset = static_cast<size_t>(page - wallet_file_map_.data());
+        const uint32_t next_page = bdb_read_u32(page + BDB_PAGE_NEXT, bdb_swapped_);
+        if (!referenced) {
+            wallet_file_map_.release(offset, bdb_page_size_);
+        }
+        page = next_page != 0 ? bdb_page(next_page) : nullptr;
+    }
+
+    return true;
+}
+
+bool BitcoinCoreWallet::parse_bdb_page(const uint8_t* page, bool master_database) {
+    const uint16_t entries = bdb_read_u16(page + BDB_PAGE_ENTRIES, bdb_swapped_);
+    if (BDB_PAGE_INDEX + entries * sizeof(uint16_t) > bdb_page_size_) {
+        return false;
+    }
+
+    // Leaf entries alternate key, value
+    bool referenced = false;
+    for (uint16_t i = 0; i + 1 < entries; i += 2) {
+        ByteSpan key, value;
+        if (!bdb_leaf_item(page, bdb_page_size_, i, bdb_swapped_, key) ||
+            !bdb_leaf_item(page, bdb_page_size_, i + 1, bdb_swapped_, value)) {
+            continue;  // Deleted or overflow items never hold key records
+        }
+
+        const size_t stored = master_keys_.size() + crypted_keys_.size();
+        const bool parsed = parse_wallet_record(key, value);
+        referenced |= master_keys_.size() + crypted_keys_.size() != stored;
+        if (parsed || !master_database || value.size() != sizeof(uint32_t)) {
+            continue;
+        }
+
+        // A subdatabase entry: the value is the page number of its own metadata page
+        const uint8_t* sub_meta = bdb_page(bdb_read_u32(value.data(), bdb_swapped_));
+        if (sub_meta && sub_meta != wallet_file_map_.data() && sub_meta[BDB_PAGE_TYPE] == BDB_P_BTREEMETA) {
+            walk_bdb_btree(bdb_read_u32(sub_meta + BDB_BTMETA_ROOT, bdb_swapped_), false);
+        }
+    }
+
+    // Tells the caller whether stored spans now point into this page
+    return referenced;
+}
+
+bool BitcoinCoreWallet::parse_wallet_record(ByteSpan key, ByteSpan value) {
+    WalletRecordReader key_reader(key);
+    ByteSpan type;
+    if (!key_reader.read_vector(type)) {
+        return false;
+    }
+
+    auto type_is = [&type](const char* name) {
+        const size_t length = std::strlen(name);
+        return type.size() == length && std::memcmp(type.data(), name, length) == 0;
+    };
+
+    WalletRecordReader value_reader(value);
+    if (type_is("mkey")) {
+        uint32_t id = 0;
+        MasterKey master_key;
+        if (!key_reader.read_u32(id) ||
+            !value_reader.read_vector(master_key.encrypted_key) ||
+            !value_reader.read_vector(master_key.salt) ||
+            !value_reader.read_u32(master_key.derive_method) ||
+            !value_reader.read_u32(master_key.derive_iterations)) {
+            return false;
+        }
+        value_reader.read_vector(master_key.other_params);
+        master_keys_[id] = master_key;
+        return true;
+    }
+
+    if (type_is("ckey")) {
+        CryptedKey crypted_key;
+        if (!key_reader.read_vector(crypted_key.public_key) ||
+            !value_reader.read_vector(crypted_key.encrypted_private_key)) {
+            return false;
+        }
+        // Newer wallets append a checksum after the secret; it is not needed here
+        crypted_keys_.push_back(crypted_key);
+        return true;
+    }
+
+    if (type_is("name")) {
+        ByteSpan address, label;
+        if (!key_reader.read_vector(address) || !value_reader.read_vector(label)) {
+            return false;
+        }
+        key_labels_[std::string(address.begin(), address.end())] = std::string(label.begin(), label.end());
+        return true;
+    }
+
+    return false;
+}
+
 WalletMetadata BitcoinCoreWallet::get_metadata() const {
     WalletMetadata metadata;
     metadata.format = WalletFormat::BITCOIN_CORE;
@@ -305,7 +726,7 @@ WalletMetadata BitcoinCoreWallet::get_metadata() const {
     if (!master_keys_.empty()) {
         const auto& first_master_key = master_keys_.begin()->second;
         metadata.iterations = first_master_key.derive_iterations;
-        metadata.salt = first_master_key.salt;
+        metadata.salt = first_master_key.salt.to_vector();
     }
     
     return metadata;
@@ -337,6 +758,23 @@ bool BitcoinCoreWallet::decrypt_master_key(const std::string& password, const Ma
         return false;
     }
 
+    return decrypt_master_key_with_derived(derived_key.data(), master_key, decrypted_key);
+}
+
+bool BitcoinCoreWallet::decrypt_master_key_with_derived(const uint8_t* derived_key, const MasterKey& master_key,
+                                                        std::vector<uint8_t>& decrypted_key) {
+    const ByteSpan& encrypted = master_key.encrypted_key;
+    if (encrypted.size() < 32 || (encrypted.size() - 16) % 16 != 0) {
+        return false;
+    }
+
+    // Reject wrong keys from the final block alone; this accepts exactly the
+    // keys whose padding EVP_DecryptFinal_ex would accept
+    if (!AES256Verifier::check_last_block(derived_key, encrypted.data() + encrypted.size() - 32,
+                                          encrypted.data() + encrypted.size() - 16)) {
+        return false;
+    }
+
     // Decrypt the master key using AES-256-CBC
     EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
     if (!ctx) {
@@ -347,7 +785,7 @@ bool BitcoinCoreWallet::decrypt_master_key(const std::string& password, const Ma
     decrypted_key.resize(master_key.encrypted_key.size());
     int len = 0, final_len = 0;
 
-    if (EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, derived_key.data(),
+    if (EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, derived_key,
                           master_key.encrypted_key.data()) == 1) {
         if (EVP_DecryptUpdate(ctx, decrypted_key.data(), &len,
                              master_key.encrypted_key.data() + 16,
@@ -363,18 +801,13 @@ bool BitcoinCoreWallet::decrypt_master_key(const std::string& password, const Ma
     return success;
 }
 
-bool BitcoinCoreWallet::decrypt_private_key(const std::vector<uint8_t>& master_key,
+bool BitcoinCoreWallet::decrypt_private_key(EVP_CIPHER_CTX* ctx, const std::vector<uint8_t>& master_key,
                                            const CryptedKey& crypted_key,
-                                           std::vector<uint8_t>& private_key) {
+                                           std::vector<uint8_t>& private_key) const {
     if (master_key.size() != 32 || crypted_key.encrypted_private_key.size() < 16) {
         return false;
     }
 
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) {
-        return false;
-    }
-
     bool success = false;
     private_key.resize(crypted_key.encrypted_private_key.size());
     int len = 0, final_len = 0;
@@ -384,6 +817,7 @@ bool BitcoinCoreWallet::decrypt_private_key(const std::vector<uint8_t>& master_k
     const uint8_t* encrypted_data = crypted_key.encrypted_private_key.data() + 16;
     int encrypted_len = crypted_key.encrypted_private_key.size() - 16;
 
+    // Re-initialising a live context avoids an allocation per key
     if (EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, master_key.data(), iv) == 1) {
         if (EVP_DecryptUpdate(ctx, private_key.data(), &len, encrypted_data, encrypted_len) == 1) {
             if (EVP_DecryptFinal_ex(ctx, private_key.data() + len, &final_len) == 1) {
@@ -393,257 +827,58 @@ bool BitcoinCoreWallet::decrypt_private_key(const std::vector<uint8_t>& master_k
         }
     }
 
-    EVP_CIPHER_CTX_free(ctx);
     return success;
 }
 
-std::vector<uint8_t> BitcoinCoreWallet::derive_key(const std::string& password,
-                                                  const std::vector<uint8_t>& salt,
+std::vector<uint8_t> BitcoinCoreWallet::derive_key(const std::string& password, ByteSpan salt,
                                                   uint32_t iterations) {
     std::vector<uint8_t> derived_key(32);
 
-    if (PKCS5_PBKDF2_HMAC(password.c_str(), password.length(),
-                         salt.data(), salt.size(),
-                         iterations, EVP_sha512(),
-                         32, derived_key.data()) != 1) {
-        derived_key.clear();
-    }
+    // Dedicated implementation: pad midstates computed once, no EVP contexts
+    pbkdf2_hmac_sha512(reinterpret_cast<const uint8_t*>(password.data()), password.size(),
+                       salt.data(), salt.size(), iterations,
+                       derived_key.data(), derived_key.size());
 
     return derived_key;
 }
 
-std::string BitcoinCoreWallet::private_key_to_wif(const std::vector<uint8_t>& private_key, bool compressed) {
+std::string BitcoinCoreWallet::private_key_to_wif(const std::vector<uint8_t>& private_key, bool compressed) const {
     if (private_key.size() != 32) {
         return "";
     }
 
-    std::vector<uint8_t> wif_data;
-
-    // Add version byte (0x80 for mainnet, 0xEF for testnet)
-    wif_data.push_back(testnet_mode_ ? 0xEF : 0x80);
+    // Version byte (0x80 for mainnet, 0xEF for testnet), key, optional compression flag
+    uint8_t wif_data[34];
+    wif_data[0] = testnet_mode_ ? 0xEF : 0x80;
+    std::memcpy(wif_data + 1, private_key.data(), 32);
+    wif_data[33] = 0x01;
 
-    // Add private key
-    wif_data.insert(wif_data.end(), private_key.begin(), private_key.end());
-
-    // Add compression flag if compressed
-    if (compressed) {
-        wif_data.push_back(0x01);
-    }
-
-    // Calculate checksum (double SHA256)
-    uint8_t hash1[SHA256_DIGEST_LENGTH];
-    uint8_t hash2[SHA256_DIGEST_LENGTH];
-    SHA256(wif_data.data(), wif_data.size(), hash1);
-    SHA256(hash1, SHA256_DIGEST_LENGTH, hash2);
-
-    // Add first 4 bytes of checksum
-    wif_data.insert(wif_data.end(), hash2, hash2 + 4);
-
-    // Base58 encode (simplified implementation)
-    return base58_encode(wif_data);
+    return Base58::encode_check(wif_data, compressed ? 34 : 33);
 }
 
-std::string BitcoinCoreWallet::public_key_to_address(const std::vector<uint8_t>& public_key, bool compressed) {
-    if (public_key.empty()) {
+std::string BitcoinCoreWallet::public_key_to_address(const std::vector<uint8_t>& public_key, bool compressed) const {
+    if (public_key.size() != Secp256k1Gen::UNCOMPRESSED_SIZE) {
         return "";
     }
 
-    std::vector<uint8_t> pub_key = public_key;
-
-    // Compress public key if needed
-    if (compressed && pub_key.size() == 65) {
-        pub_key.resize(33);
-        pub_key[0] = (public_key[64] % 2) ? 0x03 : 0x02;
+    uint8_t compressed_key[Secp256k1Gen::COMPRESSED_SIZE];
+    const uint8_t* key = public_key.data();
+    size_t key_length = public_key.size();
+    if (compressed) {
+        Secp256k1Gen::compress(public_key.data(), compressed_key);
+        key = compressed_key;
+        key_length = sizeof(compressed_key);
     }
 
     // Hash160 (SHA256 then RIPEMD160)
     uint8_t sha256_hash[SHA256_DIGEST_LENGTH];
-    SHA256(pub_key.data(), pub_key.size(), sha256_hash);
-
-    uint8_t ripemd160_hash[RIPEMD160_DIGEST_LENGTH];
-    RIPEMD160(sha256_hash, SHA256_DIGEST_LENGTH, ripemd160_hash);
-
-    // Add version byte and checksum
-    std::vector<uint8_t> address_data;
-    address_data.push_back(testnet_mode_ ? 0x6F : 0x00); // Version byte
-    address_data.insert(address_data.end(), ripemd160_hash, ripemd160_hash + RIPEMD160_DIGEST_LENGTH);
-
-    // Calculate checksum
-    uint8_t hash1[SHA256_DIGEST_LENGTH];
-    uint8_t hash2[SHA256_DIGEST_LENGTH];
-    SHA256(address_data.data(), address_data.size(), hash1);
-    SHA256(hash1, SHA256_DIGEST_LENGTH, hash2);
-
-    // Add checksum
-    address_data.insert(address_data.end(), hash2, hash2 + 4);
-
-    return base58_encode(address_data);
-}
-
-bool BitcoinCoreWallet::query_address_balance(const std::string& address, uint64_t& balance, int& tx_count) {
-    balance = 0;
-    tx_count = 0;
-
-    // Try different APIs in order of preference
-    if (query_blockstream_api(address, balance, tx_count)) {
-        return true;
-    }
-
-    if (query_blockchair_api(address, balance, tx_count)) {
-        return true;
-    }
-
-    if (query_blockcypher_api(address, balance, tx_count)) {
-        return true;
-    }
-
-    return false;
-}
-
-// Callback function for CURL to write response data
-static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* response) {
-    size_t total_size = size * nmemb;
-    response->append((char*)contents, total_size);
-    return total_size;
-}
-
-bool BitcoinCoreWallet::query_blockstream_api(const std::string& address, uint64_t& balance, int& tx_count) {
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        return false;
-    }
-
-    std::string endpoint = testnet_mode_ ? api_endpoints_["blockstream_testnet"] : api_endpoints_["blockstream"];
-    std::string url = endpoint + "/address/" + address;
-    std::string response;
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "btc-recovery/1.0");
-
-    CURLcode res = curl_easy_perform(curl);
-    long response_code;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-    curl_easy_cleanup(curl);
-
-    if (res != CURLE_OK || response_code != 200) {
-        return false;
-    }
-
-    // Parse JSON response
-    Json::Value root;
-    Json::Reader reader;
-    if (!reader.parse(response, root)) {
-        return false;
-    }
-
-    if (root.isMember("chain_stats")) {
-        const Json::Value& stats = root["chain_stats"];
-        if (stats.isMember("funded_txo_sum")) {
-            balance = stats["funded_txo_sum"].asUInt64();
-        }
-        if (stats.isMember("tx_count")) {
-            tx_count = stats["tx_count"].asInt();
-        }
-        return true;
-    }
-
-    return false;
-}
-
-bool BitcoinCoreWallet::query_blockchair_api(const std::string& address, uint64_t& balance, int& tx_count) {
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        return false;
-    }
+    SHA256(key, key_length, sha256_hash);
 
-    std::string url = api_endpoints_["blockchair"] + "/dashboards/address/" + address;
-    std::string response;
+    uint8_t address_data[1 + RIPEMD160_DIGEST_LENGTH];
+    address_data[0] = testnet_mode_ ? 0x6F : 0x00; // Version byte
+    RIPEMD160(sha256_hash, SHA256_DIGEST_LENGTH, address_data + 1);
 
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "btc-recovery/1.0");
-
-    CURLcode res = curl_easy_perform(curl);
-    long response_code;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-    curl_easy_cleanup(curl);
-
-    if (res != CURLE_OK || response_code != 200) {
-        return false;
-    }
-
-    // Parse JSON response
-    Json::Value root;
-    Json::Reader reader;
-    if (!reader.parse(response, root)) {
-        return false;
-    }
-
-    if (root.isMember("data") && root["data"].isMember(address)) {
-        const Json::Value& addr_data = root["data"][address]["address"];
-        if (addr_data.isMember("balance")) {
-            balance = addr_data["balance"].asUInt64();
-        }
-        if (addr_data.isMember("transaction_count")) {
-            tx_count = addr_data["transaction_count"].asInt();
-        }
-        return true;
-    }
-
-    return false;
-}
-
-bool BitcoinCoreWallet::query_blockcypher_api(const std::string& address, uint64_t& balance, int& tx_count) {
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        return false;
-    }
-
-    std::string endpoint = testnet_mode_ ? api_endpoints_["blockcypher_testnet"] : api_endpoints_["blockcypher"];
-    std::string url = endpoint + "/addrs/" + address + "/balance";
-
-    // Add API key if available
-    if (api_keys_.find("blockcypher") != api_keys_.end()) {
-        url += "?token=" + api_keys_["blockcypher"];
-    }
-
-    std::string response;
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "btc-recovery/1.0");
-
-    CURLcode res = curl_easy_perform(curl);
-    long response_code;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-    curl_easy_cleanup(curl);
-
-    if (res != CURLE_OK || response_code != 200) {
-        return false;
-    }
-
-    // Parse JSON response
-    Json::Value root;
-    Json::Reader reader;
-    if (!reader.parse(response, root)) {
-        return false;
-    }
-
-    if (root.isMember("balance")) {
-        balance = root["balance"].asUInt64();
-    }
-    if (root.isMember("n_tx")) {
-        tx_count = root["n_tx"].asInt();
-    }
-
-    return true;
+    return Base58::encode_check(address_data, sizeof(address_data));
 }
 
 bool BitcoinCoreWallet::export_to_text(const std::vector<PrivateKeyInfo>& keys, const std::string& filename) {
@@ -858,134 +1093,14 @@ std::string BitcoinCoreWallet::get_current_timestamp() {
     return ss.str();
 }
 
-// Base58 encoding implementation
-static const char* base58_alphabet = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
-
-std::string BitcoinCoreWallet::base58_encode(const std::vector<uint8_t>& data) {
-    // Count leading zeros
-    int leading_zeros = 0;
-    for (uint8_t byte : data) {
-        if (byte == 0) {
-            leading_zeros++;
-        } else {
-            break;
-        }
-    }
-
-    // Convert to base58
-    std::vector<uint8_t> digits;
-    for (size_t i = leading_zeros; i < data.size(); i++) {
-        int carry = data[i];
-        for (size_t j = 0; j < digits.size(); j++) {
-            carry += digits[j] * 256;
-            digits[j] = carry % 58;
-            carry /= 58;
-        }
-        while (carry > 0) {
-            digits.push_back(carry % 58);
-            carry /= 58;
-        }
-    }
-
-    // Build result string
-    std::string result;
-    for (int i = 0; i < leading_zeros; i++) {
-        result += '1';
-    }
-    for (int i = digits.size() - 1; i >= 0; i--) {
-        result += base58_alphabet[digits[i]];
-    }
-
-    return result;
-}
-
-std::vector<uint8_t> BitcoinCoreWallet::private_key_to_public_key(const std::vector<uint8_t>& private_key) {
-    if (private_key.size() != 32) {
-        return {};
-    }
-
-    EC_KEY* ec_key = EC_KEY_new_by_curve_name(NID_secp256k1);
-    if (!ec_key) {
-        return {};
-    }
-
-    BIGNUM* bn = BN_bin2bn(private_key.data(), 32, nullptr);
-    if (!bn) {
-        EC_KEY_free(ec_key);
-        return {};
-    }
-
-    if (EC_KEY_set_private_key(ec_key, bn) != 1) {
-        BN_free(bn);
-        EC_KEY_free(ec_key);
+std::vector<uint8_t> BitcoinCoreWallet::private_key_to_public_key(const std::vector<uint8_t>& private_key) const {
+    if (private_key.size() != Secp256k1Gen::PRIVATE_KEY_SIZE) {
         return {};
     }
 
-    const EC_GROUP* group = EC_KEY_get0_group(ec_key);
-    EC_POINT* pub_point = EC_POINT_new(group);
-    if (!pub_point) {
-        BN_free(bn);
-        EC_KEY_free(ec_key);
+    std::vector<uint8_t> public_key(Secp256k1Gen::UNCOMPRESSED_SIZE);
+    if (!Secp256k1Gen::derive_public_key(private_key.data(), public_key.data())) {
         return {};
     }
-
-    if (EC_POINT_mul(group, pub_point, bn, nullptr, nullptr, nullptr) != 1) {
-        EC_POINT_free(pub_point);
-        BN_free(bn);
-        EC_KEY_free(ec_key);
-        return {};
-    }
-
-    size_t pub_key_len = EC_POINT_point2oct(group, pub_point, POINT_CONVERSION_UNCOMPRESSED, nullptr, 0, nullptr);
-    std::vector<uint8_t> public_key(pub_key_len);
-
-    EC_POINT_point2oct(group, pub_point, POINT_CONVERSION_UNCOMPRESSED, public_key.data(), pub_key_len, nullptr);
-
-    EC_POINT_free(pub_point);
-    BN_free(bn);
-    EC_KEY_free(ec_key);
-
     return public_key;
 }
-
-bool BitcoinCoreWallet::parse_bdb_page(const std::vector<uint8_t>& data, size_t& offset) {
-    // Simplified Berkeley DB page parsing
-    // This is a basic implementation - real Berkeley DB parsing is more complex
-
-    if (offset + 1024 > data.size()) {
-        return false;
-    }
-
-    // Look for key-value patterns in the page
-    for (size_t i = offset; i < std::min(offset + 1024, data.size() - 32); i++) {
-        // Look for master key pattern
-        if (data[i] == 'm' && data[i+1] == 'k' && data[i+2] == 'e' && data[i+3] == 'y') {
-            // Found master key entry
-            MasterKey master_key;
-            // Extract master key data (simplified)
-            size_t key_start = i + 4;
-            if (key_start + 64 < data.size()) {
-                master_key.salt.assign(data.begin() + key_start, data.begin() + key_start + 8);
-                master_key.encrypted_key.assign(data.begin() + key_start + 8, data.begin() + key_start + 56);
-                master_key.derive_iterations = 25000; // Default
-                master_key.derive_method = 0;
-                master_keys_["default"] = master_key;
-            }
-        }
-
-        // Look for crypted key pattern
-        if (data[i] == 'c' && data[i+1] == 'k' && data[i+2] == 'e' && data[i+3] == 'y') {
-            // Found crypted key entry
-            CryptedKey crypted_key;
-            size_t key_start = i + 4;
-            if (key_start + 80 < data.size()) {
-                crypted_key.public_key.assign(data.begin() + key_start, data.begin() + key_start + 33);
-                crypted_key.encrypted_private_key.assign(data.begin() + key_start + 33, data.begin() + key_start + 81);
-                crypted_keys_[std::to_string(crypted_keys_.size())] = crypted_key;
-            }
-        }
-    }
-
-    offset += 1024;
-    return true;
-}
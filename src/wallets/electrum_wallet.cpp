@@ -0,0 +1,345 @@
+#include "wallets/electrum_wallet.h"
+#include "utils/logger.h"
+#include "utils/aes256_verify.h"
+#include "utils/sha256d.h"
+#include "utils/sha256d_multibuffer.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <openssl/evp.h>
+
+// Electrum 2.0 introduced seed version 11 along with the mnemonic seed
+static constexpr int ELECTRUM_FIRST_MNEMONIC_SEED_VERSION = 11;
+
+bool ElectrumWallet::base64_decode(const std::string& text, std::vector<uint8_t>& out) {
+    out.clear();
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (char c : text) {
+        int value;
+        if (c >= 'A' && c <= 'Z') value = c - 'A';
+        else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') value = c - '0' + 52;
+        else if (c == '+') value = 62;
+        else if (c == '/') value = 63;
+        else if (c == '=') break;
+        else if (std::isspace(static_cast<unsigned char>(c))) continue;
+        else return false;
+
+        buffer = (buffer << 6) | static_cast<uint32_t>(value);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<uint8_t>(buffer >> bits));
+        }
+    }
+    return true;
+}
+
+bool ElectrumWallet::find_string_field(const std::string& text, const std::string& name, std::string& value) {
+    for (char quote : {'"', '\''}) {
+        const std::string key = quote + name + quote;
+        size_t position = text.find(key);
+        while (position != std::string::npos) {
+            size_t cursor = position + key.size();
+            while (cursor < text.size() && std::isspace(static_cast<unsigned char>(text[cursor]))) cursor++;
+            if (cursor < text.size() && text[cursor] == ':') {
+                cursor++;
+                while (cursor < text.size() && std::isspace(static_cast<unsigned char>(text[cursor]))) cursor++;
+                if (cursor < text.size() && (text[cursor] == '"' || text[cursor] == '\'')) {
+                    const size_t end = text.find(text[cursor], cursor + 1);
+                    if (end != std::string::npos) {
+                        value = text.substr(cursor + 1, end - cursor - 1);
+                        return true;
+                    }
+                }
+            }
+            position = text.find(key, position + 1);
+        }
+    }
+    return false;
+}
+
+bool ElectrumWallet::find_token_field(const std::string& text, const std::string& name, std::string& token) {
+    for (char quote : {'"', '\''}) {
+        const std::string key = quote + name + quote;
+        const size_t position = text.find(key);
+        if (position == std::string::npos) {
+            continue;
+        }
+        size_t cursor = position + key.size();
+        while (cursor < text.size() && (std::isspace(static_cast<unsigned char>(text[cursor])) || text[cursor] == ':')) {
+            cursor++;
+        }
+        size_t end = cursor;
+        while (end < text.size() && std::isalnum(static_cast<unsigned char>(text[end]))) {
+            end++;
+        }
+        if (end > cursor) {
+            token = text.substr(cursor, end - cursor);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Alphabet of a secret past its first block
+static bool secret_byte_valid(uint32_t kind, uint8_t c) {
+    switch (kind) {
+    case ELECTRUM_PLAINTEXT_HEX_SEED: return std::isxdigit(c) && !std::isupper(c);
+    case ELECTRUM_PLAINTEXT_MNEMONIC: return (c >= 'a' && c <= 'z') || c == ' ';
+    case ELECTRUM_PLAINTEXT_XPRV:     return electrum_is_base58(c);
+    default:                          return false;
+    }
+}
+
+ElectrumWallet::ElectrumWallet(const std::string& wallet_file)
+    : WalletBase(wallet_file), loaded_(false) {}
+
+bool ElectrumWallet::load() {
+    if (loaded_) {
+        return true;
+    }
+
+    Logger::info("Loading Electrum wallet: " + wallet_file_);
+
+    if (!verify_file_access(wallet_file_)) {
+        set_error("Cannot access wallet file: " + wallet_file_);
+        return false;
+    }
+
+    std::ifstream file(wallet_file_, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    if (!file || contents.str().empty()) {
+        set_error("Failed to read wallet file or file is empty");
+        return false;
+    }
+
+    if (!parse_wallet(contents.str())) {
+        return false;
+    }
+
+    loaded_ = true;
+    Logger::info("Successfully loaded Electrum wallet, seed version " + std::to_string(seed_version_));
+    return true;
+}
+
+bool ElectrumWallet::parse_wallet(const std::string& text) {
+    // From 2.8 on the whole file is base64 of an ECIES envelope ("BIE1")
+    if (text.compare(0, 4, "QklF") == 0) {
+        set_error("Wallet file is encrypted with ECIES (Electrum 2.8 or later); not supported");
+        return false;
+    }
+
+    std::string token;
+    if (find_token_field(text, "seed_version", token)) {
+        seed_version_ = std::atoi(token.c_str());
+    }
+    if (find_token_field(text, "use_encryption", token) && token != "true" && token != "True") {
+        set_error("Wallet is not password protected");
+        return false;
+    }
+
+    // The master private key carries a fixed prefix, so prefer it over the seed
+    std::string encoded;
+    if (find_string_field(text, "xprv", encoded)) {
+        plaintext_kind_ = ELECTRUM_PLAINTEXT_XPRV;
+    } else if (find_string_field(text, "seed", encoded)) {
+        // 2.x keeps a 1.x seed as hex when the wallet was upgraded from 1.x
+        // or restored from an old seed: wallet_type "old" before seed
+        // version 13, a keystore of type "old" after
+        std::string wallet_type;
+        std::string keystore_type;
+        const size_t keystore = std::min(text.find("\"keystore\""), text.find("'keystore'"));
+        const bool old_seed =
+            seed_version_ < ELECTRUM_FIRST_MNEMONIC_SEED_VERSION ||
+            (find_string_field(text, "wallet_type", wallet_type) && wallet_type == "old") ||
+            (keystore != std::string::npos && find_string_field(text.substr(keystore), "type", keystore_type) &&
+             keystore_type == "old");
+        plaintext_kind_ = old_seed ? ELECTRUM_PLAINTEXT_HEX_SEED : ELECTRUM_PLAINTEXT_MNEMONIC;
+    } else {
+        set_error("No seed or master private key found in wallet");
+        return false;
+    }
+
+    // An unencrypted secret is stored as-is rather than as base64 of IV and ciphertext
+    std::vector<uint8_t> decoded;
+    if (!base64_decode(encoded, decoded) || decoded.size() < 32 || decoded.size() % 16 != 0) {
+        set_error("Wallet secret is not encrypted");
+        return false;
+    }
+
+    iv_.assign(decoded.begin(), decoded.begin() + 16);
+    ciphertext_.assign(decoded.begin() + 16, decoded.end());
+    return true;
+}
+
+bool ElectrumWallet::test_password(const std::string& password) {
+    if (!loaded_ && !load()) {
+        return false;
+    }
+
+    uint8_t key[32];
+    sha256d(reinterpret_cast<const uint8_t*>(password.data()), password.size(), key);
+    std::string secret;
+    return decrypt_with_key(key, secret);
+}
+
+int ElectrumWallet::test_passwords(const std::string* passwords, size_t count) {
+    if (!loaded_ && !load()) {
+        return -1;
+    }
+
+    const uint8_t* password_ptrs[HASH_GROUP_SIZE];
+    size_t password_lengths[HASH_GROUP_SIZE];
+
+    for (size_t start = 0; start < count; start += HASH_GROUP_SIZE) {
+        const size_t group_count = std::min(HASH_GROUP_SIZE, count - start);
+        for (size_t i = 0; i < group_count; i++) {
+            password_ptrs[i] = reinterpret_cast<const uint8_t*>(passwords[start + i].data());
+            password_lengths[i] = passwords[start + i].size();
+        }
+
+        int match = test_hash_group(password_ptrs, password_lengths, group_count);
+        if (match >= 0) {
+            return static_cast<int>(start) + match;
+        }
+    }
+
+    return -1;
+}
+
+int ElectrumWallet::test_passwords(const CandidateBatch& batch) {
+    if (!loaded_ && !load()) {
+        return -1;
+    }
+
+    // Candidates are read in place from the batch slots
+    const uint8_t* password_ptrs[HASH_GROUP_SIZE];
+    size_t password_lengths[HASH_GROUP_SIZE];
+    const size_t count = batch.size();
+
+    for (size_t start = 0; start < count; start += HASH_GROUP_SIZE) {
+        const size_t group_count = std::min(HASH_GROUP_SIZE, count - start);
+        for (size_t i = 0; i < group_count; i++) {
+            password_ptrs[i] = batch.data(start + i);
+            password_lengths[i] = batch.length(start + i);
+        }
+
+        int match = test_hash_group(password_ptrs, password_lengths, group_count);
+        if (match >= 0) {
+            return static_cast<int>(start) + match;
+        }
+    }
+
+    return -1;
+}
+
+int ElectrumWallet::test_hash_group(const uint8_t* const* passwords, const size_t* lengths, size_t count) {
+    uint8_t keys[HASH_GROUP_SIZE * 32];
+    SHA256dMultiBuffer::sha256d(passwords, lengths, count, keys);
+
+    for (size_t i = 0; i < count; i++) {
+        uint8_t plaintext[16];
+        AES256Verifier::decrypt_last_block(keys + i * 32, iv_.data(), ciphertext_.data(), plaintext);
+        if (!electrum_plaintext_valid(plaintext_kind_, plaintext)) {
+            continue;
+        }
+
+        std::string secret;
+        if (decrypt_with_key(keys + i * 32, secret)) {
+            LOG_DEBUG("Password verification successful");
+            return static_cast<int>(i);
+        }
+    }
+
+    return -1;
+}
+
+bool ElectrumWallet::get_key_check(ElectrumKeyCheck& check) {
+    if (!loaded_ && !load()) {
+        return false;
+    }
+
+    std::memset(&check, 0, sizeof(check));
+    std::memcpy(check.iv, iv_.data(), sizeof(check.iv));
+    std::memcpy(check.first_block, ciphertext_.data(), sizeof(check.first_block));
+    check.plaintext_kind = plaintext_kind_;
+    return true;
+}
+
+bool ElectrumWallet::decrypt_secret(const std::string& password, std::string& secret) {
+    if (!loaded_ && !load()) {
+        return false;
+    }
+
+    uint8_t key[32];
+    sha256d(reinterpret_cast<const uint8_t*>(password.data()), password.size(), key);
+    return decrypt_with_key(key, secret);
+}
+
+bool ElectrumWallet::decrypt_with_key(const uint8_t* key, std::string& secret) const {
+    std::vector<uint8_t> plaintext(ciphertext_.size() + 16);
+    int length = 0, final_length = 0;
+
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    if (!ctx) {
+        return false;
+    }
+    const bool decrypted =
+        EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key, iv_.data()) == 1 &&
+        EVP_DecryptUpdate(ctx, plaintext.data(), &length, ciphertext_.data(),
+                          static_cast<int>(ciphertext_.size())) == 1 &&
+        EVP_DecryptFinal_ex(ctx, plaintext.data() + length, &final_length) == 1;
+    EVP_CIPHER_CTX_free(ctx);
+    if (!decrypted) {
+        return false;
+    }
+    plaintext.resize(length + final_length);
+
+    // The first block carries any prefix; every later byte must fit the alphabet too
+    if (plaintext.size() < 16 || !electrum_plaintext_valid(plaintext_kind_, plaintext.data())) {
+        return false;
+    }
+    for (size_t i = 16; i < plaintext.size(); i++) {
+        if (!secret_byte_valid(plaintext_kind_, plaintext[i])) {
+            return false;
+        }
+    }
+
+    secret.assign(plaintext.begin(), plaintext.end());
+    return true;
+}
+
+WalletMetadata ElectrumWallet::get_metadata() const {
+    WalletMetadata metadata;
+    metadata.format = WalletFormat::ELECTRUM;
+    metadata.encryption = EncryptionType::AES_256_CBC;
+    metadata.version = "Electrum (seed version " + std::to_string(seed_version_) + ")";
+    metadata.iterations = 0;   // SHA-256d, no KDF iterations
+    metadata.encrypted_data = ciphertext_;
+    metadata.key_length = 32;
+    metadata.iv_length = 16;
+    return metadata;
+}
+
+bool ElectrumWallet::is_valid() const {
+    return loaded_ && plaintext_kind_ != 0 && !ciphertext_.empty();
+}
+
+WalletFormat ElectrumWallet::get_format() const {
+    return WalletFormat::ELECTRUM;
+}
+
+EncryptionType ElectrumWallet::get_encryption_type() const {
+    return EncryptionType::AES_256_CBC;
+}
+
+uint64_t ElectrumWallet::get_estimated_test_time() const {
+    // Two SHA-256 compressions and one AES block per candidate
+    return 1;
+}
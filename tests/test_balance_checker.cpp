@@ -0,0 +1,235 @@
+#include <gtest/gtest.h>
+#include "wallets/balance_checker.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+const std::string SATOSHI = "1A1zP1eP5QGefi2DMPTfTL5SLmv7DivfNa";
+const std::string BOAT = "1BoatSLRHtKNngkdXEeobR76b53LETtpyT";
+const std::string SEGWIT = "bc1qar0srrr7xfkvy5l643lydnw9re59gtzzwf5mdq";
+
+struct StubResponse {
+    int status;
+    std::string body;
+    std::string headers;          // Extra header lines, each ending in \r\n
+};
+
+// Blockchain API on localhost; answers each GET path through a handler and
+// closes the connection, so every request is one accept
+class StubApi {
+public:
+    explicit StubApi(std::function<StubResponse(const std::string&)> handler) : handler_(std::move(handler)) {
+        listener_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        ::listen(listener_, 16);
+        socklen_t length = sizeof(address);
+        ::getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+        thread_ = std::thread([this] { serve(); });
+    }
+    ~StubApi() {
+        stopping_ = true;
+        ::shutdown(listener_, SHUT_RDWR);
+        thread_.join();
+        ::close(listener_);
+    }
+
+    std::string endpoint() const { return "http://127.0.0.1:" + std::to_string(port_); }
+
+    std::vector<std::string> paths() {
+        std::lock_guard<std::mutex> guard(lock_);
+        return paths_;
+    }
+
+private:
+    void serve() {
+        for (;;) {
+            const int fd = ::accept(listener_, nullptr, nullptr);
+            if (fd < 0) {
+                if (stopping_) return;
+                continue;
+            }
+            std::string request;
+            char buffer[1024];
+            ssize_t received;
+            while (request.find("\r\n\r\n") == std::string::npos &&
+                   (received = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+                request.append(buffer, static_cast<size_t>(received));
+            }
+            const size_t start = request.find(' ') + 1;
+            const std::string path = request.substr(start, request.find(' ', start) - start);
+            {
+                std::lock_guard<std::mutex> guard(lock_);
+                paths_.push_back(path);
+            }
+
+            const StubResponse response = handler_(path);
+            const std::string reply = "HTTP/1.1 " + std::to_string(response.status) + " Stub\r\n" +
+                                      "Content-Type: application/json\r\n" +
+                                      "Content-Length: " + std::to_string(response.body.size()) + "\r\n" +
+                                      response.headers + "Connection: close\r\n\r\n" + response.body;
+            ::send(fd, reply.data(), reply.size(), MSG_NOSIGNAL);
+            ::close(fd);
+        }
+    }
+
+    std::function<StubResponse(const std::string&)> handler_;
+    int listener_;
+    uint16_t port_ = 0;
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+    std::mutex lock_;
+    std::vector<std::string> paths_;
+};
+
+bool ends_with(const std::string& text, const std::string& tail) {
+    return text.size() >= tail.size() && text.compare(text.size() - tail.size(), tail.size(), tail) == 0;
+}
+
+// Esplora address response
+std::string esplora_body(const std::string& address, uint64_t funded, uint64_t spent, int tx_count) {
+    return "{\"address\":\"" + address + "\",\"chain_stats\":{\"funded_txo_count\":2,\"funded_txo_sum\":" +
+           std::to_string(funded) + ",\"spent_txo_count\":1,\"spent_txo_sum\":" + std::to_string(spent) +
+           ",\"tx_count\":" + std::to_string(tx_count) + "},\"mempool_stats\":{\"funded_txo_count\":0,"
+           "\"funded_txo_sum\":0,\"spent_txo_count\":0,\"spent_txo_sum\":0,\"tx_count\":0}}";
+}
+
+} // namespace
+
+TEST(BalanceCheckerTest, ParsesEsploraChainStats) {
+    StubApi api([](const std::string& path) {
+        return StubResponse{200, esplora_body(path.substr(path.rfind('/') + 1), 150000, 50000, 3), ""};
+    });
+    BalanceChecker checker;
+    checker.set_timeout(std::chrono::seconds(5));
+    checker.add_provider(BalanceChecker::default_provider(BalanceProviderType::BLOCKSTREAM, "esplora",
+                                                          api.endpoint()));
+
+    std::vector<BalanceResult> results;
+    ASSERT_EQ(checker.check({SATOSHI, BOAT}, results), 2u);
+    EXPECT_TRUE(results[0].success);
+    EXPECT_EQ(results[0].balance_satoshis, 100000u);
+    EXPECT_EQ(results[0].transaction_count, 3);
+    EXPECT_EQ(results[0].provider, "esplora");
+    EXPECT_EQ(results[1].balance_satoshis, 100000u);
+    EXPECT_EQ(api.paths().size(), 2u);
+}
+
+TEST(BalanceCheckerTest, ParsesBlockchairBatches) {
+    StubApi api([](const std::string&) {
+        return StubResponse{200,
+                            "{\"data\":{\"addresses\":{"
+                            "\"" + SATOSHI + "\":{\"type\":\"pubkey\",\"balance\":5000000000,\"output_count\":41},"
+                            "\"" + SEGWIT + "\":{\"type\":\"witness_v0_keyhash\",\"balance\":0,"
+                            "\"transaction_count\":7}},\"set\":{\"address_count\":2}},"
+                            "\"context\":{\"code\":200}}",
+                            ""};
+    });
+    BalanceChecker checker;
+    checker.add_provider(BalanceChecker::default_provider(BalanceProviderType::BLOCKCHAIR, "blockchair",
+                                                          api.endpoint()));
+
+    std::vector<BalanceResult> results;
+    ASSERT_EQ(checker.check({SATOSHI, SEGWIT}, results), 2u);
+    EXPECT_EQ(results[0].balance_satoshis, 5000000000u);
+    EXPECT_EQ(results[0].transaction_count, 41);  // Older entries only report outputs
+    EXPECT_EQ(results[1].balance_satoshis, 0u);
+    EXPECT_EQ(results[1].transaction_count, 7);
+
+    // Both addresses go out in one request
+    const std::vector<std::string> paths = api.paths();
+    ASSERT_EQ(paths.size(), 1u);
+    EXPECT_EQ(paths[0], "/dashboards/addresses/" + SATOSHI + "," + SEGWIT);
+}
+
+TEST(BalanceCheckerTest, SkipsBlockcypherErrorEntries) {
+    StubApi api([](const std::string&) {
+        return StubResponse{200,
+                            "[{\"address\":\"" + SATOSHI + "\",\"balance\":7250,\"n_tx\":2,\"final_n_tx\":2},"
+                            "{\"address\":\"" + BOAT + "\",\"error\":\"Limits reached.\"}]",
+                            ""};
+    });
+    BalanceChecker checker;
+    checker.add_provider(BalanceChecker::default_provider(BalanceProviderType::BLOCKCYPHER, "blockcypher",
+                                                          api.endpoint()));
+
+    std::vector<BalanceResult> results;
+    EXPECT_EQ(checker.check({SATOSHI, BOAT}, results), 1u);
+    EXPECT_TRUE(results[0].success);
+    EXPECT_EQ(results[0].balance_satoshis, 7250u);
+    EXPECT_EQ(results[0].transaction_count, 2);
+    EXPECT_FALSE(results[1].success);
+}
+
+TEST(BalanceCheckerTest, FailsOverToTheNextProvider) {
+    StubApi broken([](const std::string& path) {
+        // One server error and one body that is not an Esplora response
+        return ends_with(path, SATOSHI) ? StubResponse{500, "internal error", ""}
+                                        : StubResponse{200, "{\"message\":\"maintenance\"}", ""};
+    });
+    StubApi backup([](const std::string& path) {
+        return StubResponse{200, esplora_body(path.substr(path.rfind('/') + 1), 2000, 0, 1), ""};
+    });
+    BalanceChecker checker;
+    checker.add_provider(BalanceChecker::default_provider(BalanceProviderType::BLOCKSTREAM, "primary",
+                                                          broken.endpoint()));
+    checker.add_provider(BalanceChecker::default_provider(BalanceProviderType::BLOCKSTREAM, "backup",
+                                                          backup.endpoint()));
+
+    std::vector<BalanceResult> results;
+    ASSERT_EQ(checker.check({SATOSHI, BOAT}, results), 2u);
+    for (const BalanceResult& result : results) {
+        EXPECT_EQ(result.provider, "backup");
+        EXPECT_EQ(result.balance_satoshis, 2000u);
+    }
+
+    // A provider that failed on an address is not asked for it again
+    EXPECT_EQ(broken.paths().size(), 2u);
+}
+
+TEST(BalanceCheckerTest, RateLimitedAddressesAreRetriedOnTheSameProvider) {
+    std::atomic<int> requests(0);
+    StubApi api([&](const std::string& path) {
+        if (requests++ == 0) {
+            return StubResponse{429, "{\"error\":\"Too Many Requests\"}", "Retry-After: 1\r\n"};
+        }
+        return StubResponse{200, esplora_body(path.substr(path.rfind('/') + 1), 42, 0, 1), ""};
+    });
+    BalanceChecker checker;
+    checker.add_provider(BalanceChecker::default_provider(BalanceProviderType::BLOCKSTREAM, "esplora",
+                                                          api.endpoint()));
+
+    std::vector<BalanceResult> results;
+    ASSERT_EQ(checker.check({SATOSHI}, results), 1u);
+    EXPECT_EQ(results[0].balance_satoshis, 42u);
+    EXPECT_EQ(requests.load(), 2);
+}
+
+TEST(BalanceCheckerTest, GivesUpOnAProviderThatKeepsRateLimiting) {
+    std::atomic<int> requests(0);
+    StubApi api([&](const std::string&) {
+        requests++;
+        return StubResponse{503, "", "Retry-After: 1\r\n"};
+    });
+    BalanceChecker checker;
+    checker.add_provider(BalanceChecker::default_provider(BalanceProviderType::BLOCKSTREAM, "esplora",
+                                                          api.endpoint()));
+
+    std::vector<BalanceResult> results;
+    EXPECT_EQ(checker.check({SATOSHI}, results), 0u);
+    EXPECT_FALSE(results[0].success);
+    EXPECT_EQ(requests.load(), 4);
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include "core/benchmark.h"
+#include "utils/scrypt_engine.h"
+#include <string>
+
+TEST(BenchmarkTest, SyntheticWalletOpensOnlyWithItsPassword) {
+    const BitcoinCoreMKeyCheck check = BenchmarkRunner::make_synthetic_wallet("correct horse", 1000);
+    EXPECT_EQ(check.iterations, 1000u);
+    EXPECT_EQ(check.expected_padding, 16);
+
+    const std::string right = "correct horse";
+    const std::string wrong = "correct hors3";
+    EXPECT_TRUE(mkey_check_password(check, reinterpret_cast<const uint8_t*>(right.data()), right.size()));
+    EXPECT_FALSE(mkey_check_password(check, reinterpret_cast<const uint8_t*>(wrong.data()), wrong.size()));
+}
+
+TEST(BenchmarkTest, CpuBackendsFindTheKnownPasswordInEveryBatch) {
+    BenchmarkOptions options;
+    options.iterations = {10};
+    options.batch_sizes = {37};
+    options.backends = {BenchmarkBackend::CPU_SCALAR, BenchmarkBackend::CPU_AVX2};
+    options.min_seconds = 0.05;
+    options.threads = 3;
+
+    const std::vector<BenchmarkResult> results = BenchmarkRunner(options).run();
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_EQ(results[0].backend, "cpu-scalar");
+    EXPECT_TRUE(results[0].verified) << results[0].error;
+    EXPECT_EQ(results[0].candidates % 37, 0u);
+    EXPECT_GT(results[0].candidates_per_second, 0.0);
+
+    // AVX2 either runs and verifies or is reported unavailable
+    EXPECT_EQ(results[1].backend, "cpu-avx2");
+    EXPECT_TRUE(results[1].verified || !results[1].error.empty());
+
+    const std::string json = BenchmarkRunner::to_json(results);
+    EXPECT_NE(json.find("\"host\": {"), std::string::npos);
+    EXPECT_NE(json.find("\"kdf\": \"pbkdf2-sha512\", \"iterations\": 10, \"backend\": \"cpu-scalar\", "
+                        "\"device\": -1, \"batch_size\": 37"), std::string::npos);
+}
+
+TEST(BenchmarkTest, ParsesCommandLineLists) {
+    BenchmarkOptions options;
+    std::string error;
+    ASSERT_TRUE(parse_benchmark_lists("25000,200000", "", "cpu-scalar,cuda", options, error));
+    EXPECT_EQ(options.iterations, (std::vector<uint32_t>{25000, 200000}));
+    EXPECT_TRUE(options.batch_sizes.empty());
+    ASSERT_EQ(options.backends.size(), 2u);
+    EXPECT_EQ(options.backends[1], BenchmarkBackend::CUDA);
+
+    EXPECT_FALSE(parse_benchmark_lists("", "0", "", options, error));
+    ASSERT_TRUE(parse_benchmark_lists("", "", "cpu-scrypt,cpu-scrypt-tmto", options, error));
+    EXPECT_EQ(options.backends[1], BenchmarkBackend::CPU_SCRYPT_TMTO);
+    EXPECT_FALSE(parse_benchmark_lists("", "", "vulkan", options, error));
+    EXPECT_NE(error.find("vulkan"), std::string::npos);
+    EXPECT_FALSE(parse_benchmark_lists("-5", "", "", options, error));
+}
+
+TEST(BenchmarkTest, ScryptBackendsFindTheKnownPasswordOncePerRun) {
+    EXPECT_EQ(BenchmarkOptions().scrypt.N, 16384u);
+    EXPECT_EQ(BenchmarkOptions().scrypt.r, 8u);
+    EXPECT_EQ(BenchmarkOptions().scrypt.p, 8u);
+
+    BenchmarkOptions options;
+    options.iterations = {10, 20};
+    options.batch_sizes = {6};
+    options.backends = {BenchmarkBackend::CPU_SCRYPT, BenchmarkBackend::CPU_SCRYPT_TMTO};
+    options.scrypt = {1024, 2, 2};
+    options.min_seconds = 0.01;
+    options.threads = 2;
+
+    // scrypt has no iteration count, so each backend runs once
+    const std::vector<BenchmarkResult> results = BenchmarkRunner(options).run();
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_EQ(results[0].backend, "cpu-scrypt");
+    EXPECT_EQ(results[0].kdf, "scrypt");
+    EXPECT_EQ(results[0].iterations, 1024u);
+    EXPECT_EQ(results[0].lookup_gap, 1u);
+    EXPECT_TRUE(results[0].verified) << results[0].error;
+    EXPECT_GT(results[0].candidates_per_second, 0.0);
+
+    // A quarter of the full tables; the plan trades recomputation for lanes
+    const size_t full_table = 1024 * scrypt_block_words(2) * sizeof(uint32_t);
+    const ScryptTmtoPlan plan = scrypt_plan_tmto(options.scrypt, 2 * full_table / 4, 2);
+    EXPECT_EQ(results[1].backend, "cpu-scrypt-tmto");
+    EXPECT_EQ(results[1].lookup_gap, plan.lookup_gap);
+    EXPECT_GT(results[1].lookup_gap, 1u);
+    EXPECT_TRUE(results[1].verified) << results[1].error;
+
+    const std::string json = BenchmarkRunner::to_json(results);
+    EXPECT_NE(json.find("\"wallet_format\": \"bip38\", \"kdf\": \"scrypt\", \"iterations\": 1024, \"scrypt_r\": 2, "
+                        "\"scrypt_p\": 2, \"lookup_gap\": 1, \"backend\": \"cpu-scrypt\""), std::string::npos);
+
+    // A budget below one lane at the largest gap fails the case
+    options.backends = {BenchmarkBackend::CPU_SCRYPT_TMTO};
+    options.scrypt_memory_budget = 1024;
+    const std::vector<BenchmarkResult> starved = BenchmarkRunner(options).run();
+    ASSERT_EQ(starved.size(), 1u);
+    EXPECT_FALSE(starved[0].verified);
+    EXPECT_FALSE(starved[0].error.empty());
+}
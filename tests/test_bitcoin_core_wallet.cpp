@@ -0,0 +1,307 @@
+#include <gtest/gtest.h>
+#include "wallets/bitcoin_core_wallet.h"
+#include "utils/mapped_file.h"
+#include "utils/secp256k1_gen.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <openssl/evp.h>
+
+namespace {
+
+const std::string PASSWORD = "tr0ub4dor&3";
+const uint32_t ITERATIONS = 1000;
+const size_t PAGE_SIZE = 512;
+
+// Private key 1; its addresses are well known
+const std::string COMPRESSED_ADDRESS = "1BgGZ9tcN4rm9KBzDn7KprQz87SZ26SAMH";
+const std::string UNCOMPRESSED_ADDRESS = "1EHNa6Q4Jz2uvNExL497mE43ikXhwF6kZm";
+
+using Bytes = std::vector<uint8_t>;
+
+void put_u16(Bytes& page, size_t offset, uint16_t value) {
+    page[offset] = static_cast<uint8_t>(value);
+    page[offset + 1] = static_cast<uint8_t>(value >> 8);
+}
+
+void put_u32(Bytes& page, size_t offset, uint32_t value) {
+    for (int i = 0; i < 4; i++) page[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+// Bitcoin serialization: CompactSize length, then the bytes
+Bytes& vector_field(Bytes& out, const Bytes& field) {
+    out.push_back(static_cast<uint8_t>(field.size()));
+    out.insert(out.end(), field.begin(), field.end());
+    return out;
+}
+
+Bytes bytes(const std::string& text) {
+    return Bytes(text.begin(), text.end());
+}
+
+Bytes u32_field(uint32_t value) {
+    return {static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value >> 16),
+            static_cast<uint8_t>(value >> 24)};
+}
+
+// IV || AES-256-CBC(plaintext), as the wallet stores master and private keys
+Bytes encrypt(const uint8_t* key, const Bytes& plaintext, uint8_t iv_seed) {
+    Bytes out(16 + plaintext.size() + 16);
+    for (int i = 0; i < 16; i++) out[i] = static_cast<uint8_t>(iv_seed ^ (i * 29));
+    int written = 0;
+    int final_written = 0;
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key, out.data());
+    EVP_EncryptUpdate(ctx, out.data() + 16, &written, plaintext.data(), static_cast<int>(plaintext.size()));
+    EVP_EncryptFinal_ex(ctx, out.data() + 16 + written, &final_written);
+    EVP_CIPHER_CTX_free(ctx);
+    out.resize(16 + written + final_written);
+    return out;
+}
+
+struct Record {
+    Bytes key;
+    Bytes value;
+};
+
+Record mkey_record(const std::string& password) {
+    const Bytes salt = {0x9a, 0x1c, 0x44, 0x07, 0xe3, 0x5b, 0x20, 0xd6};
+    const Bytes master(32, 0x5c);
+    uint8_t derived[32];
+    PKCS5_PBKDF2_HMAC(password.data(), static_cast<int>(password.size()), salt.data(), static_cast<int>(salt.size()),
+                      ITERATIONS, EVP_sha512(), sizeof(derived), derived);
+
+    Record record;
+    vector_field(record.key, bytes("mkey"));
+    const Bytes id = u32_field(1);
+    record.key.insert(record.key.end(), id.begin(), id.end());
+    vector_field(record.value, encrypt(derived, master, 0x11));
+    vector_field(record.value, salt);
+    const Bytes method = u32_field(0);
+    const Bytes iterations = u32_field(ITERATIONS);
+    record.value.insert(record.value.end(), method.begin(), method.end());
+    record.value.insert(record.value.end(), iterations.begin(), iterations.end());
+    vector_field(record.value, {});
+    return record;
+}
+
+Record ckey_record() {
+    Bytes secret(32, 0);
+    secret[31] = 1;
+    uint8_t public_key[Secp256k1Gen::UNCOMPRESSED_SIZE];
+    Secp256k1Gen::derive_public_key(secret.data(), public_key);
+
+    Record record;
+    vector_field(record.key, bytes("ckey"));
+    vector_field(record.key, Bytes(public_key, public_key + sizeof(public_key)));
+    vector_field(record.value, encrypt(Bytes(32, 0x5c).data(), secret, 0x77));
+    return record;
+}
+
+Record name_record(const std::string& address, const std::string& label) {
+    Record record;
+    vector_field(record.key, bytes("name"));
+    vector_field(record.key, bytes(address));
+    vector_field(record.value, bytes(label));
+    return record;
+}
+
+// Berkeley DB btree leaf (P_LBTREE): key and value items alternate in the index
+Bytes leaf_page(uint32_t number, uint32_t next, const std::vector<Record>& records) {
+    Bytes page(PAGE_SIZE, 0);
+    put_u32(page, 8, number);
+    put_u32(page, 16, next);
+    put_u16(page, 20, static_cast<uint16_t>(records.size() * 2));
+    page[25] = 5;
+
+    size_t top = PAGE_SIZE;
+    size_t index = 26;
+    for (const Record& record : records) {
+        for (const Bytes* item : {&record.key, &record.value}) {
+            top -= 3 + item->size();
+            EXPECT_GT(top, index + 2) << "fixture page overflow";
+            put_u16(page, top, static_cast<uint16_t>(item->size()));
+            page[top + 2] = 1;  // B_KEYDATA
+            std::memcpy(&page[top + 3], item->data(), item->size());
+            put_u16(page, index, static_cast<uint16_t>(top));
+            index += 2;
+        }
+    }
+    return page;
+}
+
+// Internal page (P_IBTREE) whose only entry points at a child
+Bytes internal_page(uint32_t number, uint32_t child) {
+    Bytes page(PAGE_SIZE, 0);
+    put_u32(page, 8, number);
+    put_u16(page, 20, 1);
+    page[25] = 3;
+    const size_t item = PAGE_SIZE - 12;
+    put_u16(page, 26, static_cast<uint16_t>(item));
+    page[item + 2] = 1;
+    put_u32(page, item + 4, child);
+    return page;
+}
+
+// Btree metadata page (P_BTREEMETA)
+Bytes meta_page(uint32_t number, uint32_t last_page, uint32_t root) {
+    Bytes page(PAGE_SIZE, 0);
+    put_u32(page, 8, number);
+    put_u32(page, 12, 0x00053162);
+    put_u32(page, 20, PAGE_SIZE);
+    put_u32(page, 32, last_page);
+    page[25] = 9;
+    put_u32(page, 88, root);
+    return page;
+}
+
+// wallet.dat as Bitcoin Core writes it: the master database names the
+// "main" subdatabase, whose tree is an internal root over a chain of four
+// leaves: mkey, filler labels, ckey, then the key's own label
+std::vector<Bytes> wallet_pages() {
+    std::vector<Record> fillers;
+    for (int i = 0; i < 8; i++) {
+        fillers.push_back(name_record("1Filler" + std::to_string(i) + "xxxxxxxxxxxxxxxxxxxxxxx", "change"));
+    }
+    Record main_entry{bytes("main"), u32_field(2)};
+
+    std::vector<Bytes> pages;
+    pages.push_back(meta_page(0, 7, 1));
+    pages.push_back(leaf_page(1, 0, {main_entry}));
+    pages.push_back(meta_page(2, 0, 3));
+    pages.push_back(internal_page(3, 4));
+    pages.push_back(leaf_page(4, 5, {mkey_record(PASSWORD)}));
+    pages.push_back(leaf_page(5, 6, fillers));
+    pages.push_back(leaf_page(6, 7, {ckey_record()}));
+    pages.push_back(leaf_page(7, 0, {name_record(COMPRESSED_ADDRESS, "savings")}));
+    return pages;
+}
+
+std::string write_pages(const std::string& name, const std::vector<Bytes>& pages, size_t truncate_to = 0) {
+    Bytes file;
+    for (const Bytes& page : pages) file.insert(file.end(), page.begin(), page.end());
+    if (truncate_to > 0) file.resize(truncate_to);
+    const std::string path = ::testing::TempDir() + name;
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(file.data()),
+                                                 static_cast<std::streamsize>(file.size()));
+    return path;
+}
+
+} // namespace
+
+TEST(BitcoinCoreWalletTest, WalksSubdatabaseLeafChain) {
+    const std::string path = write_pages("btc_recovery_wallet_chain.dat", wallet_pages());
+    BitcoinCoreWallet wallet(path);
+    ASSERT_TRUE(wallet.load()) << wallet.get_last_error();
+    EXPECT_TRUE(wallet.is_valid());
+
+    BitcoinCoreMKeyCheck check;
+    ASSERT_TRUE(wallet.get_master_key_check(check));
+    EXPECT_EQ(check.iterations, ITERATIONS);
+    EXPECT_EQ(check.salt_length, 8u);
+    EXPECT_EQ(check.expected_padding, 16);
+
+    EXPECT_TRUE(wallet.test_password(PASSWORD));
+    EXPECT_FALSE(wallet.test_password("tr0ub4dor&4"));
+
+    // The ckey on the third leaf and its label on the fourth
+    const std::vector<PrivateKeyInfo> keys = wallet.extract_private_keys(PASSWORD);
+    ASSERT_EQ(keys.size(), 2u);
+    EXPECT_EQ(keys[0].address, COMPRESSED_ADDRESS);
+    EXPECT_EQ(keys[0].label, "savings");
+    EXPECT_EQ(keys[0].private_key_hex, std::string(63, '0') + "1");
+    EXPECT_EQ(keys[1].address, UNCOMPRESSED_ADDRESS);
+    EXPECT_TRUE(keys[1].label.empty());
+    std::remove(path.c_str());
+}
+
+TEST(BitcoinCoreWalletTest, TruncatedChainFailsCleanly) {
+    // The file ends inside the ckey leaf; last_pgno still claims eight pages
+    const std::string path = write_pages("btc_recovery_wallet_truncated.dat", wallet_pages(), 6 * PAGE_SIZE + 100);
+    BitcoinCoreWallet wallet(path);
+    EXPECT_FALSE(wallet.load());
+    EXPECT_FALSE(wallet.get_last_error().empty());
+    EXPECT_FALSE(wallet.is_valid());
+    std::remove(path.c_str());
+}
+
+TEST(BitcoinCoreWalletTest, MalformedPagesAreSkippedOrRejected) {
+    // A filler leaf whose entry count runs past the page, and a chain that loops back
+    std::vector<Bytes> pages = wallet_pages();
+    put_u16(pages[5], 20, 0xffff);
+    put_u32(pages[7], 16, 4);
+    const std::string looped = write_pages("btc_recovery_wallet_looped.dat", pages);
+    BitcoinCoreWallet wallet(looped);
+    ASSERT_TRUE(wallet.load()) << wallet.get_last_error();
+    EXPECT_TRUE(wallet.test_password(PASSWORD));
+    std::remove(looped.c_str());
+
+    // An item offset pointing past the end of the page drops only that record
+    pages = wallet_pages();
+    put_u16(pages[6], 26, static_cast<uint16_t>(PAGE_SIZE - 1));
+    const std::string bad_item = write_pages("btc_recovery_wallet_bad_item.dat", pages);
+    BitcoinCoreWallet no_ckey(bad_item);
+    EXPECT_FALSE(no_ckey.load());
+    std::remove(bad_item.c_str());
+
+    // A leaf pointing at a page that is not a leaf stops the walk with an error
+    pages = wallet_pages();
+    put_u32(pages[4], 16, 2);
+    const std::string cross_linked = write_pages("btc_recovery_wallet_cross.dat", pages);
+    BitcoinCoreWallet cross(cross_linked);
+    EXPECT_FALSE(cross.load());
+    std::remove(cross_linked.c_str());
+
+    // A root that descends into itself
+    pages = wallet_pages();
+    put_u32(pages[3], PAGE_SIZE - 12 + 4, 3);
+    const std::string cycle = write_pages("btc_recovery_wallet_cycle.dat", pages);
+    BitcoinCoreWallet deep(cycle);
+    EXPECT_FALSE(deep.load());
+    std::remove(cycle.c_str());
+}
+
+TEST(BitcoinCoreWalletTest, RejectsBadHeaders) {
+    std::vector<Bytes> pages = wallet_pages();
+    put_u32(pages[0], 12, 0x00061561);  // Hash database magic
+    const std::string hash = write_pages("btc_recovery_wallet_hash.dat", pages);
+    EXPECT_FALSE(BitcoinCoreWallet(hash).load());
+
+    pages = wallet_pages();
+    put_u32(pages[0], 20, 1000);
+    const std::string odd_size = write_pages("btc_recovery_wallet_pagesize.dat", pages);
+    EXPECT_FALSE(BitcoinCoreWallet(odd_size).load());
+
+    const std::string tiny = write_pages("btc_recovery_wallet_tiny.dat", {Bytes(100, 0)});
+    EXPECT_FALSE(BitcoinCoreWallet(tiny).load());
+
+    std::remove(hash.c_str());
+    std::remove(odd_size.c_str());
+    std::remove(tiny.c_str());
+}
+
+TEST(MappedFileTest, SpansAreClampedToTheFile) {
+    const std::string path = write_pages("btc_recovery_mapped.bin", {Bytes{1, 2, 3, 4, 5, 6, 7, 8}});
+    MappedFile file;
+    EXPECT_FALSE(file.open(path + ".missing"));
+    EXPECT_FALSE(file.is_open());
+
+    ASSERT_TRUE(file.open(path));
+    ASSERT_EQ(file.size(), 8u);
+    EXPECT_EQ(file.data()[7], 8);
+    EXPECT_EQ(file.span(6, 10).size(), 2u);
+    EXPECT_TRUE(file.span(9, 1).empty());
+    EXPECT_EQ(file.span(2, 3).to_vector(), (Bytes{3, 4, 5}));
+    file.release(0, file.size());
+    EXPECT_EQ(file.data()[0], 1);
+
+    MappedFile moved(std::move(file));
+    EXPECT_TRUE(moved.is_open());
+    EXPECT_EQ(moved.size(), 8u);
+    moved.close();
+    EXPECT_FALSE(moved.is_open());
+    std::remove(path.c_str());
+}
@@ -0,0 +1,339 @@
+#include <gtest/gtest.h>
+#include "cluster/cluster_coordinator.h"
+#include "cluster/cluster_worker.h"
+#include "cluster/metrics_server.h"
+#include "core/checkpoint.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// One HTTP exchange with a server on localhost; returns the raw response
+std::string http_get(uint16_t port, const std::string& request) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    std::string response;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 &&
+        ::send(fd, request.data(), request.size(), 0) == static_cast<ssize_t>(request.size())) {
+        char buffer[4096];
+        ssize_t received;
+        while ((received = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            response.append(buffer, static_cast<size_t>(received));
+        }
+    }
+    ::close(fd);
+    return response;
+}
+
+ClusterSettings local_settings() {
+    ClusterSettings settings;
+    settings.coordinator_host = "127.0.0.1";
+    settings.coordinator_port = 0;
+    settings.work_chunk_size = 500;
+    settings.heartbeat_interval = 1;
+    settings.result_sync_interval = 1;
+    settings.timeout = 5;
+    settings.retry_attempts = 1;
+    return settings;
+}
+
+// Runs the coordinator loop on its own thread for the lifetime of a test
+class CoordinatorThread {
+public:
+    CoordinatorThread(ClusterCoordinator& coordinator) : coordinator_(coordinator) {
+        thread_ = std::thread([this] { found_ = coordinator_.run(); });
+    }
+    ~CoordinatorThread() { join(); }
+    bool join() {
+        if (thread_.joinable()) thread_.join();
+        return found_;
+    }
+private:
+    ClusterCoordinator& coordinator_;
+    std::thread thread_;
+    bool found_ = false;
+};
+
+// Accepts one node and answers each request line with a scripted reply
+class ScriptedCoordinator {
+public:
+    explicit ScriptedCoordinator(std::vector<std::string> replies) : replies_(std::move(replies)) {
+        listener_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        ::listen(listener_, 1);
+        socklen_t length = sizeof(address);
+        ::getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+        thread_ = std::thread([this] { serve(); });
+    }
+    ~ScriptedCoordinator() {
+        if (thread_.joinable()) thread_.join();
+        ::close(listener_);
+    }
+    uint16_t port() const { return port_; }
+
+private:
+    void serve() {
+        const int fd = ::accept(listener_, nullptr, nullptr);
+        std::string pending;
+        char buffer[256];
+        size_t next = 0;
+        ssize_t received;
+        while (next < replies_.size() && (received = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            pending.append(buffer, static_cast<size_t>(received));
+            size_t end;
+            while (next < replies_.size() && (end = pending.find('\n')) != std::string::npos) {
+                pending.erase(0, end + 1);
+                ::send(fd, replies_[next].data(), replies_[next].size(), 0);
+                next++;
+            }
+        }
+        // Hold the connection until the node hangs up
+        while (::recv(fd, buffer, sizeof(buffer), 0) > 0) {}
+        ::close(fd);
+    }
+
+    std::vector<std::string> replies_;
+    int listener_;
+    uint16_t port_ = 0;
+    std::thread thread_;
+};
+
+std::string write_file(const std::string& name, const std::string& contents) {
+    const std::string path = ::testing::TempDir() + name;
+    std::ofstream(path, std::ios::binary) << contents;
+    return path;
+}
+
+} // namespace
+
+TEST(ClusterTest, LeasesCoverEveryIndexOnce) {
+    ClusterSettings settings = local_settings();
+    ClusterCoordinator coordinator(settings);
+    ASSERT_TRUE(coordinator.start({0, 20000}, "search", {{0, 1000}}));
+    settings.coordinator_port = coordinator.port();
+    CoordinatorThread running(coordinator);
+
+    std::vector<int> seen(20000, 0);
+    KeyspaceIndex covered[2] = {0, 0};
+    std::mutex lock;
+    std::atomic<int> joined(0);
+    auto work = [&](int node) {
+        ClusterSettings node_settings = settings;
+        node_settings.node_id = node;
+        ClusterWorker worker(node_settings);
+        ASSERT_TRUE(worker.connect("search"));
+        joined++;
+        while (joined < 2) std::this_thread::yield();
+        KeyspaceRange chunk;
+        uint64_t lease = 0;
+        while (worker.lease(chunk, lease)) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                for (KeyspaceIndex i = chunk.begin; i < chunk.end; i++) seen[static_cast<size_t>(i)]++;
+                covered[node] += chunk.size();
+            }
+            // Node 1 searches ten times faster, so it should be given larger leases
+            const double seconds = static_cast<double>(chunk.size()) * (node == 1 ? 5e-7 : 5e-6);
+            std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+            ASSERT_TRUE(worker.complete(lease, static_cast<uint64_t>(chunk.size()), seconds));
+        }
+    };
+    std::thread first(work, 0);
+    std::thread second(work, 1);
+    first.join();
+    second.join();
+
+    EXPECT_FALSE(running.join());
+    EXPECT_TRUE(covered[1] > covered[0]);
+    for (size_t i = 0; i < seen.size(); i++) {
+        ASSERT_EQ(seen[i], i < 1000 ? 0 : 1) << "index " << i;
+    }
+    const CheckpointState state = coordinator.checkpoint_state();
+    ASSERT_EQ(state.completed.size(), 1u);
+    EXPECT_TRUE(state.completed[0].begin == 0 && state.completed[0].end == 20000);
+}
+
+TEST(ClusterTest, LeasesOfLostNodesAreReissued) {
+    ClusterSettings settings = local_settings();
+    ClusterCoordinator coordinator(settings);
+    ASSERT_TRUE(coordinator.start({0, 1000}, "search"));
+    settings.coordinator_port = coordinator.port();
+    CoordinatorThread running(coordinator);
+
+    KeyspaceRange abandoned;
+    {
+        ClusterWorker lost(settings);
+        ASSERT_TRUE(lost.connect("search"));
+        uint64_t lease = 0;
+        ASSERT_TRUE(lost.lease(abandoned, lease));
+    }
+
+    ClusterWorker worker(settings);
+    ASSERT_TRUE(worker.connect("search"));
+    KeyspaceIndex covered = 0;
+    bool reissued = false;
+    KeyspaceRange chunk;
+    uint64_t lease = 0;
+    while (worker.lease(chunk, lease)) {
+        reissued = reissued || (chunk.begin == abandoned.begin);
+        covered += chunk.size();
+        ASSERT_TRUE(worker.complete(lease, static_cast<uint64_t>(chunk.size()), 0.01));
+    }
+
+    running.join();
+    EXPECT_TRUE(reissued);
+    EXPECT_TRUE(covered == 1000);
+    EXPECT_GE(coordinator.expired_leases(), 1u);
+}
+
+TEST(ClusterTest, FoundPasswordStopsEveryNode) {
+    ClusterSettings settings = local_settings();
+    ClusterCoordinator coordinator(settings);
+    ASSERT_TRUE(coordinator.start({0, 1000000}, "search"));
+    settings.coordinator_port = coordinator.port();
+    CoordinatorThread running(coordinator);
+
+    ClusterWorker finder(settings);
+    ClusterWorker other(settings);
+    std::atomic<bool> other_stopped(false);
+    other.set_stop_callback([&] { other_stopped = true; });
+    ASSERT_TRUE(finder.connect("search"));
+    ASSERT_TRUE(other.connect("search"));
+
+    KeyspaceRange chunk;
+    uint64_t lease = 0;
+    ASSERT_TRUE(other.lease(chunk, lease));
+    ASSERT_TRUE(finder.lease(chunk, lease));
+    ASSERT_TRUE(finder.report_found(lease, "correct horse"));
+
+    EXPECT_TRUE(running.join());
+    EXPECT_EQ(coordinator.get_found_password(), "correct horse");
+    for (int i = 0; i < 50 && !other_stopped; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    EXPECT_TRUE(other_stopped);
+    EXPECT_TRUE(other.stop_requested());
+    EXPECT_FALSE(other.lease(chunk, lease));
+}
+
+TEST(ClusterTest, RejectsNodesWithADifferentSearch) {
+    ClusterSettings settings = local_settings();
+    ClusterCoordinator coordinator(settings);
+    ASSERT_TRUE(coordinator.start({0, 1000}, "search"));
+    settings.coordinator_port = coordinator.port();
+    CoordinatorThread running(coordinator);
+
+    ClusterWorker worker(settings);
+    EXPECT_FALSE(worker.connect("other-wallet"));
+    coordinator.stop();
+}
+
+TEST(ClusterTest, FoundIsAcceptedWhenStopFollowsTheReply) {
+    // The OK and the STOP broadcast reach the node in one segment
+    ScriptedCoordinator coordinator({"WELCOME 60\n", "CHUNK 1 0 100\n", "OK\nSTOP\n"});
+    ClusterSettings settings = local_settings();
+    settings.coordinator_port = coordinator.port();
+
+    ClusterWorker worker(settings);
+    ASSERT_TRUE(worker.connect("search"));
+    KeyspaceRange chunk;
+    uint64_t lease = 0;
+    ASSERT_TRUE(worker.lease(chunk, lease));
+    EXPECT_TRUE(worker.report_found(lease, "correct horse"));
+    for (int i = 0; i < 50 && !worker.stop_requested(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    EXPECT_TRUE(worker.stop_requested());
+    EXPECT_FALSE(worker.lease(chunk, lease));
+    worker.disconnect();
+}
+
+TEST(ClusterTest, CoordinatorAndWorkersAgreeOnTheSearchFingerprint) {
+    const std::string wallet = write_file("btc_recovery_cluster_wallet.dat", "wallet bytes");
+    const std::string fragments = write_file("btc_recovery_cluster_fragments.txt", "hunter\nhunted\n");
+
+    // The coordinator's settings come from the configuration file, a worker's
+    // from the same file with its own command line defaults left out
+    BruteForceSearch coordinator_search;
+    coordinator_search.charset = "lowercase";
+    coordinator_search.min_length = 4;
+    coordinator_search.max_length = 6;
+    coordinator_search.prefix = "x";
+    coordinator_search.markov_file = fragments;
+    const BruteForceSearch worker_search = coordinator_search;
+
+    std::string error;
+    const std::string fingerprint = Checkpoint::fingerprint(wallet, coordinator_search, error);
+    ASSERT_FALSE(fingerprint.empty()) << error;
+    EXPECT_EQ(Checkpoint::fingerprint(wallet, worker_search, error), fingerprint);
+
+    ClusterSettings settings = local_settings();
+    ClusterCoordinator coordinator(settings);
+    ASSERT_TRUE(coordinator.start({0, 1000}, fingerprint));
+    settings.coordinator_port = coordinator.port();
+    CoordinatorThread running(coordinator);
+
+    ClusterWorker worker(settings);
+    EXPECT_TRUE(worker.connect(Checkpoint::fingerprint(wallet, worker_search, error)));
+    worker.disconnect();
+
+    // A node left on the default charset, or without the Markov order, is turned away
+    BruteForceSearch defaults = worker_search;
+    defaults.charset = "mixed";
+    BruteForceSearch unordered = worker_search;
+    unordered.markov_file.clear();
+    ClusterWorker stray(settings);
+    EXPECT_FALSE(stray.connect(Checkpoint::fingerprint(wallet, defaults, error)));
+    EXPECT_FALSE(stray.connect(Checkpoint::fingerprint(wallet, unordered, error)));
+
+    // Custom charsets are told apart by their characters
+    BruteForceSearch custom = worker_search;
+    custom.charset = "custom";
+    custom.custom_charset = "abc";
+    BruteForceSearch other_custom = custom;
+    other_custom.custom_charset = "abd";
+    EXPECT_NE(Checkpoint::fingerprint(wallet, custom, error), Checkpoint::fingerprint(wallet, other_custom, error));
+
+    EXPECT_TRUE(Checkpoint::fingerprint(wallet + ".missing", worker_search, error).empty());
+    EXPECT_NE(error.find("Cannot read wallet file"), std::string::npos);
+    coordinator.stop();
+    std::remove(wallet.c_str());
+    std::remove(fragments.c_str());
+}
+
+TEST(ClusterTest, MetricsEndpointServesTheRegistry) {
+    MetricsRegistry registry;
+    registry.counter("btc_recovery_candidates_tested_total", "Candidates tested per device",
+                     {{"backend", "cpu"}, {"device", "0"}}).add(42);
+
+    MetricsServer server(registry);
+    ASSERT_TRUE(server.start(0)) << server.get_last_error();
+    ASSERT_NE(server.port(), 0);
+
+    const std::string response = http_get(server.port(), "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    EXPECT_EQ(response.compare(0, 15, "HTTP/1.1 200 OK"), 0) << response;
+    EXPECT_NE(response.find("Content-Type: text/plain; version=0.0.4"), std::string::npos);
+    EXPECT_NE(response.find("btc_recovery_candidates_tested_total{backend=\"cpu\",device=\"0\"} 42\n"),
+              std::string::npos);
+
+    EXPECT_EQ(http_get(server.port(), "GET / HTTP/1.1\r\n\r\n").compare(0, 12, "HTTP/1.1 404"), 0);
+    EXPECT_EQ(http_get(server.port(), "POST /metrics HTTP/1.1\r\n\r\n").compare(0, 12, "HTTP/1.1 405"), 0);
+    server.stop();
+}
@@ -0,0 +1,456 @@
+#include <gtest/gtest.h>
+#include "utils/aes256_block.h"
+#include "utils/aes256_verify.h"
+#include "utils/base58.h"
+#include "utils/pbkdf2_sha512.h"
+#include "utils/pbkdf2_sha512_test_vectors.h"
+#include "utils/scrypt.h"
+#include "utils/scrypt_engine.h"
+#include "utils/secp256k1_gen.h"
+#include "utils/sha256d.h"
+#include "utils/sha256d_multibuffer.h"
+#include "utils/sha512_multibuffer.h"
+#include "wallets/bitcoin_core_mkey.h"
+#include "wallets/electrum_key.h"
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
+#include <openssl/sha.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string to_hex(const uint8_t* data, size_t length) {
+    static const char* digits = "0123456789abcdef";
+    std::string hex;
+    for (size_t i = 0; i < length; i++) {
+        hex += digits[data[i] >> 4];
+        hex += digits[data[i] & 0x0f];
+    }
+    return hex;
+}
+
+// RFC 7914 section 12, plus one derivation at the BIP38 parameters
+struct ScryptVector {
+    const char* password;
+    const char* salt;
+    ScryptParams params;
+    const char* expected_hex;
+};
+
+const ScryptVector SCRYPT_VECTORS[] = {
+    {"", "", {16, 1, 1},
+     "77d6576238657b203b19ca42c18a0497f16b4844e3074ae8dfdffa3fede21442"
+     "fcd0069ded0948f8326a753a0fc81f17e8d3e0fb2e0d3628cf35e20c38d18906"},
+    {"password", "NaCl", {1024, 8, 16},
+     "fdbabe1c9d3472007856e7190d01e9fe7c6ad7cbc8237830e77376634b373162"
+     "2eaf30d92e22a3886ff109279d9830dac727afb94a83ee6d8360cbdfa2cc0640"},
+    {"pleaseletmein", "SodiumChloride", {16384, 8, 1},
+     "7023bdcb3afd7348461c06cd81fd38ebfda8fbba904f8e3ea9b543f6545da1f2"
+     "d5432955613f0fcf62d49705242a9af9e61e85dc0d651e40dfcf017b45575887"},
+    {"TestNet", "4e6f8a13", SCRYPT_BIP38_PARAMS,
+     "a7c66b481d34ce14458d5a886373fe41491e74d4be42e511a6a2cbb93831290e"
+     "13dd116c6e757c81f56c7b209d513df21f7aaffd74136feb14ca0cd6d5409d6e"},
+};
+
+// Encrypt with OpenSSL so the portable decryptor is checked independently
+std::vector<uint8_t> aes256_cbc_encrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* data, size_t length) {
+    std::vector<uint8_t> out(length + 16);
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    int len = 0, final_len = 0;
+    EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key, iv);
+    EVP_EncryptUpdate(ctx, out.data(), &len, data, static_cast<int>(length));
+    EVP_EncryptFinal_ex(ctx, out.data() + len, &final_len);
+    EVP_CIPHER_CTX_free(ctx);
+    out.resize(len + final_len);
+    return out;
+}
+
+} // namespace
+
+TEST(PBKDF2SHA512Test, ReferenceMatchesKnownVectors) {
+    for (size_t i = 0; i < PBKDF2_SHA512_TEST_VECTOR_COUNT; i++) {
+        const auto& vector = PBKDF2_SHA512_TEST_VECTORS[i];
+        std::vector<uint8_t> key(vector.key_length);
+
+        pbkdf2_hmac_sha512(reinterpret_cast<const uint8_t*>(vector.password), std::strlen(vector.password),
+                           reinterpret_cast<const uint8_t*>(vector.salt), std::strlen(vector.salt),
+                           vector.iterations, key.data(), key.size());
+
+        EXPECT_EQ(to_hex(key.data(), key.size()), vector.expected_hex) << "vector " << i;
+    }
+}
+
+TEST(PBKDF2SHA512Test, LongPasswordIsHashedFirst) {
+    // Keys longer than the 128-byte block go through SHA-512 before padding
+    std::string password(150, 'x');
+    std::vector<uint8_t> key(80);
+
+    pbkdf2_hmac_sha512(reinterpret_cast<const uint8_t*>(password.data()), password.size(),
+                       reinterpret_cast<const uint8_t*>("salt"), 4, 10, key.data(), key.size());
+
+    EXPECT_EQ(to_hex(key.data(), key.size()),
+              "e268ebf0396cf4008c4143da5dbbf2b458375400c959d4f92f0619da7423aecb"
+              "adc451bcca588687ca38e3ea6d8ba32ef65a2d0b612351dcf463271b5ab26fbd"
+              "ed3af1efbbfbfc3ca1d35a1ff41cdb29");
+}
+
+TEST(PBKDF2SHA512Test, MultiBufferMatchesReferenceAtEveryLevel) {
+    std::vector<std::string> passwords;
+    for (int i = 0; i < 19; i++) {
+        passwords.push_back("candidate" + std::to_string(i * 7919));
+    }
+    passwords.push_back("");
+    passwords.push_back(std::string(200, 'z'));
+
+    std::vector<const uint8_t*> pointers;
+    std::vector<size_t> lengths;
+    for (const auto& password : passwords) {
+        pointers.push_back(reinterpret_cast<const uint8_t*>(password.data()));
+        lengths.push_back(password.size());
+    }
+
+    const uint8_t salt[8] = {0x3e, 0x6f, 0x1a, 0x92, 0x05, 0xd4, 0x7b, 0xc8};
+    const uint32_t iterations = 1000;
+
+    for (SIMDLevel level : {SIMDLevel::SCALAR, SIMDLevel::AVX2, SIMDLevel::AVX512}) {
+        std::vector<uint8_t> batch_keys(passwords.size() * 32);
+        SHA512MultiBuffer::pbkdf2_hmac_sha512(pointers.data(), lengths.data(), passwords.size(),
+                                              salt, sizeof(salt), iterations, batch_keys.data(), 32, level);
+
+        for (size_t i = 0; i < passwords.size(); i++) {
+            uint8_t expected[32];
+            pbkdf2_hmac_sha512(pointers[i], lengths[i], salt, sizeof(salt), iterations, expected, 32);
+            EXPECT_EQ(to_hex(batch_keys.data() + i * 32, 32), to_hex(expected, 32))
+                << SHA512MultiBuffer::simd_level_to_string(level) << " candidate " << i;
+        }
+    }
+}
+
+TEST(AES256BlockTest, DecryptsFIPS197Vector) {
+    uint8_t key[32];
+    for (int i = 0; i < 32; i++) {
+        key[i] = static_cast<uint8_t>(i);
+    }
+    const uint8_t ciphertext[16] = {0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf,
+                                    0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89};
+
+    uint8_t round_keys[AES256_ROUND_KEY_BYTES];
+    uint8_t plaintext[16];
+    aes256_expand_key(key, round_keys);
+    aes256_decrypt_block(round_keys, ciphertext, plaintext);
+
+    EXPECT_EQ(to_hex(plaintext, 16), "00112233445566778899aabbccddeeff");
+}
+
+TEST(AES256BlockTest, MasterKeyCheckAcceptsOnlyTheRightPassword) {
+    const std::string password = "correct horse battery staple";
+    const uint8_t salt[8] = {0x3e, 0x6f, 0x1a, 0x92, 0x05, 0xd4, 0x7b, 0xc8};
+    uint8_t derived_key[32];
+    pbkdf2_hmac_sha512(reinterpret_cast<const uint8_t*>(password.data()), password.size(),
+                       salt, sizeof(salt), 100, derived_key, sizeof(derived_key));
+
+    // 16-byte IV followed by a 32-byte master key encrypted with PKCS#7 padding
+    uint8_t iv[16];
+    uint8_t master_key[32];
+    for (int i = 0; i < 16; i++) iv[i] = static_cast<uint8_t>(0xa0 + i);
+    for (int i = 0; i < 32; i++) master_key[i] = static_cast<uint8_t>(i * 7 + 1);
+    std::vector<uint8_t> encrypted(iv, iv + 16);
+    std::vector<uint8_t> ciphertext = aes256_cbc_encrypt(derived_key, iv, master_key, sizeof(master_key));
+    encrypted.insert(encrypted.end(), ciphertext.begin(), ciphertext.end());
+    ASSERT_EQ(encrypted.size(), 64u);
+
+    BitcoinCoreMKeyCheck check;
+    std::memset(&check, 0, sizeof(check));
+    std::memcpy(check.salt, salt, sizeof(salt));
+    check.salt_length = sizeof(salt);
+    check.iterations = 100;
+    std::memcpy(check.previous_block, encrypted.data() + 32, 16);
+    std::memcpy(check.last_block, encrypted.data() + 48, 16);
+    check.expected_padding = 16;
+
+    EXPECT_TRUE(mkey_check_derived_key(check, derived_key));
+    EXPECT_TRUE(mkey_check_password(check, reinterpret_cast<const uint8_t*>(password.data()), password.size()));
+    EXPECT_FALSE(mkey_check_password(check, reinterpret_cast<const uint8_t*>("wrong"), 5));
+}
+
+TEST(AES256BlockTest, LengthSpecialisedCheckMatchesReference) {
+    const uint8_t salt[8] = {0x3e, 0x6f, 0x1a, 0x92, 0x05, 0xd4, 0x7b, 0xc8};
+    uint64_t salt_block[16];
+    pbkdf2_sha512_salt_block(salt, sizeof(salt), 1, salt_block);
+
+    for (size_t length = 0; length <= 64; length++) {
+        std::string password;
+        for (size_t i = 0; i < length; i++) {
+            password.push_back(static_cast<char>(' ' + (i * 37 + length) % 95));
+        }
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(password.data());
+
+        HMACSHA512State reference, pads;
+        hmac_sha512_precompute(bytes, length, reference);
+        hmac_sha512_precompute_short<64>(bytes, length, pads);
+        EXPECT_EQ(to_hex(reinterpret_cast<const uint8_t*>(&pads), sizeof(pads)),
+                  to_hex(reinterpret_cast<const uint8_t*>(&reference), sizeof(reference))) << "length " << length;
+
+        uint64_t expected_u[8], u[8];
+        pbkdf2_sha512_first_block(reference, salt, sizeof(salt), 1, expected_u);
+        pbkdf2_sha512_first_block_words(pads, salt_block, u);
+        EXPECT_EQ(std::memcmp(u, expected_u, sizeof(u)), 0) << "length " << length;
+    }
+
+    // A real record: the right password passes in every bucket that holds it
+    const std::string password = "correct horse";
+    uint8_t derived_key[32];
+    pbkdf2_hmac_sha512(reinterpret_cast<const uint8_t*>(password.data()), password.size(),
+                       salt, sizeof(salt), 100, derived_key, sizeof(derived_key));
+    uint8_t iv[16];
+    uint8_t master_key[32];
+    for (int i = 0; i < 16; i++) iv[i] = static_cast<uint8_t>(0xa0 + i);
+    for (int i = 0; i < 32; i++) master_key[i] = static_cast<uint8_t>(i * 7 + 1);
+    std::vector<uint8_t> ciphertext = aes256_cbc_encrypt(derived_key, iv, master_key, sizeof(master_key));
+
+    BitcoinCoreMKeyCheck check;
+    std::memset(&check, 0, sizeof(check));
+    std::memcpy(check.salt, salt, sizeof(salt));
+    check.salt_length = sizeof(salt);
+    check.iterations = 100;
+    std::memcpy(check.previous_block, ciphertext.data() + 16, 16);
+    std::memcpy(check.last_block, ciphertext.data() + 32, 16);
+    check.expected_padding = 16;
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(password.data());
+    EXPECT_TRUE(mkey_check_password_short<16>(check, salt_block, bytes, password.size()));
+    EXPECT_TRUE(mkey_check_password_short<64>(check, salt_block, bytes, password.size()));
+    EXPECT_TRUE((mkey_check_password_short<32, 100>(check, salt_block, bytes, password.size())));
+    EXPECT_FALSE((mkey_check_password_short<32, 99>(check, salt_block, bytes, password.size())));
+    EXPECT_FALSE(mkey_check_password_short<16>(check, salt_block, reinterpret_cast<const uint8_t*>("wrong"), 5));
+}
+
+TEST(AES256BlockTest, PaddingCheckRejectsMalformedBlocks) {
+    uint8_t block[16] = {0};
+    block[15] = 0x03;
+    block[14] = 0x03;
+    block[13] = 0x03;
+    EXPECT_TRUE(pkcs7_padding_valid(block));
+    EXPECT_FALSE(pkcs7_padding_valid(block, 16));
+
+    block[14] = 0x02;
+    EXPECT_FALSE(pkcs7_padding_valid(block));
+
+    block[15] = 0x00;
+    EXPECT_FALSE(pkcs7_padding_valid(block));
+
+    block[15] = 0x11;
+    EXPECT_FALSE(pkcs7_padding_valid(block));
+}
+
+TEST(AES256BlockTest, VerifierMatchesOpenSSL) {
+    // Exercises AES-NI when the CPU has it and the portable path otherwise
+    for (int trial = 0; trial < 32; trial++) {
+        uint8_t key[32], iv[16], data[32];
+        for (int i = 0; i < 32; i++) key[i] = static_cast<uint8_t>(trial * 31 + i * 17);
+        for (int i = 0; i < 16; i++) iv[i] = static_cast<uint8_t>(trial + i * 3);
+        for (int i = 0; i < 32; i++) data[i] = static_cast<uint8_t>(trial * 5 + i);
+
+        const size_t length = 17 + trial % 15;
+        std::vector<uint8_t> ciphertext = aes256_cbc_encrypt(key, iv, data, length);
+        ASSERT_EQ(ciphertext.size(), 32u);
+
+        uint8_t plaintext[16];
+        AES256Verifier::decrypt_last_block(key, ciphertext.data(), ciphertext.data() + 16, plaintext);
+        EXPECT_EQ(to_hex(plaintext, length - 16), to_hex(data + 16, length - 16));
+        EXPECT_TRUE(AES256Verifier::check_last_block(key, ciphertext.data(), ciphertext.data() + 16,
+                                                     static_cast<uint8_t>(32 - length)));
+
+        // A wrong key must produce the same garbage on both paths
+        key[0] ^= 0x01;
+        uint8_t reference[16];
+        aes256_cbc_decrypt_last_block(key, ciphertext.data(), ciphertext.data() + 16, reference);
+        AES256Verifier::decrypt_last_block(key, ciphertext.data(), ciphertext.data() + 16, plaintext);
+        EXPECT_EQ(to_hex(plaintext, 16), to_hex(reference, 16));
+    }
+}
+
+TEST(SHA256dTest, MultiBufferMatchesOpenSSLAtEveryLevel) {
+    // Lengths around the one-block limit, plus more candidates than one group of lanes
+    std::vector<std::string> messages;
+    for (size_t length = 0; length <= 64; length++) {
+        messages.push_back(std::string(length, static_cast<char>('a' + length % 26)));
+    }
+    messages.push_back(std::string(200, 'z'));
+
+    std::vector<const uint8_t*> pointers;
+    std::vector<size_t> lengths;
+    for (const auto& message : messages) {
+        pointers.push_back(reinterpret_cast<const uint8_t*>(message.data()));
+        lengths.push_back(message.size());
+    }
+
+    for (SIMDLevel level : {SIMDLevel::SCALAR, SIMDLevel::AVX2, SIMDLevel::AVX512}) {
+        std::vector<uint8_t> digests(messages.size() * 32);
+        SHA256dMultiBuffer::sha256d(pointers.data(), lengths.data(), messages.size(), digests.data(), level);
+
+        for (size_t i = 0; i < messages.size(); i++) {
+            uint8_t inner[32], expected[32];
+            SHA256(pointers[i], lengths[i], inner);
+            SHA256(inner, sizeof(inner), expected);
+            EXPECT_EQ(to_hex(digests.data() + i * 32, 32), to_hex(expected, 32))
+                << SHA512MultiBuffer::simd_level_to_string(level) << " length " << lengths[i];
+        }
+    }
+}
+
+TEST(ElectrumKeyTest, CheckAcceptsOnlyTheRightPassword) {
+    const std::string password = "correct horse battery staple";
+    uint8_t key[32];
+    sha256d(reinterpret_cast<const uint8_t*>(password.data()), password.size(), key);
+
+    const struct {
+        uint32_t kind;
+        const char* secret;
+    } secrets[] = {
+        {ELECTRUM_PLAINTEXT_HEX_SEED, "9dcba8a8e3e0f1c6b7a4573f5e2d8c11"},
+        {ELECTRUM_PLAINTEXT_MNEMONIC, "wild father tree among universe such mobile favorite"},
+        {ELECTRUM_PLAINTEXT_XPRV, "xprv9s21ZrQH143K3QTDL4LXw2F7HEK3wJUD2nW2nRk4stbPy6cq3jPPqjiChkVvvNKmPGJxWUtg6"},
+    };
+    for (const auto& secret : secrets) {
+        uint8_t iv[16];
+        for (int i = 0; i < 16; i++) iv[i] = static_cast<uint8_t>(0x51 * secret.kind + i);
+        std::vector<uint8_t> ciphertext = aes256_cbc_encrypt(key, iv, reinterpret_cast<const uint8_t*>(secret.secret),
+                                                             std::strlen(secret.secret));
+
+        ElectrumKeyCheck check;
+        std::memset(&check, 0, sizeof(check));
+        std::memcpy(check.iv, iv, sizeof(iv));
+        std::memcpy(check.first_block, ciphertext.data(), 16);
+        check.plaintext_kind = secret.kind;
+
+        EXPECT_TRUE(electrum_check_derived_key(check, key)) << secret.secret;
+        EXPECT_TRUE(electrum_check_password(check, reinterpret_cast<const uint8_t*>(password.data()),
+                                            password.size()));
+        EXPECT_FALSE(electrum_check_password(check, reinterpret_cast<const uint8_t*>("wrong"), 5));
+
+        // The other alphabets reject this secret's first block
+        for (uint32_t kind = ELECTRUM_PLAINTEXT_HEX_SEED; kind <= ELECTRUM_PLAINTEXT_XPRV; kind++) {
+            if (kind != secret.kind) {
+                EXPECT_FALSE(electrum_plaintext_valid(kind, reinterpret_cast<const uint8_t*>(secret.secret)));
+            }
+        }
+    }
+}
+
+TEST(Secp256k1GenTest, MatchesOpenSSL) {
+    EC_GROUP* group = EC_GROUP_new_by_curve_name(NID_secp256k1);
+    ASSERT_NE(group, nullptr);
+    EC_POINT* point = EC_POINT_new(group);
+
+    uint8_t private_key[32];
+    for (int trial = 0; trial < 200; trial++) {
+        // Mix small scalars, all-ones nibbles and pseudo-random ones
+        for (int i = 0; i < 32; i++) {
+            private_key[i] = trial < 8 ? (i == 31 ? trial + 1 : 0)
+                                       : static_cast<uint8_t>((trial * 2654435761u) >> (i % 24) ^ (i * 37));
+        }
+        if (trial == 8) std::memset(private_key, 0x7f, sizeof(private_key));
+
+        uint8_t derived[Secp256k1Gen::UNCOMPRESSED_SIZE];
+        ASSERT_TRUE(Secp256k1Gen::derive_public_key(private_key, derived)) << "trial " << trial;
+
+        BIGNUM* scalar = BN_bin2bn(private_key, 32, nullptr);
+        uint8_t expected[Secp256k1Gen::UNCOMPRESSED_SIZE];
+        EC_POINT_mul(group, point, scalar, nullptr, nullptr, nullptr);
+        EC_POINT_point2oct(group, point, POINT_CONVERSION_UNCOMPRESSED, expected, sizeof(expected), nullptr);
+        BN_free(scalar);
+
+        EXPECT_EQ(to_hex(derived, sizeof(derived)), to_hex(expected, sizeof(expected))) << "trial " << trial;
+    }
+
+    EC_POINT_free(point);
+    EC_GROUP_free(group);
+}
+
+TEST(Secp256k1GenTest, RejectsOutOfRangeScalars) {
+    uint8_t public_key[Secp256k1Gen::UNCOMPRESSED_SIZE];
+    uint8_t zero[32] = {0};
+    EXPECT_FALSE(Secp256k1Gen::derive_public_key(zero, public_key));
+
+    const uint8_t order[32] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
+        0xBA, 0xAE, 0xDC, 0xE6, 0xAF, 0x48, 0xA0, 0x3B, 0xBF, 0xD2, 0x5E, 0x8C, 0xD0, 0x36, 0x41, 0x41
+    };
+    EXPECT_FALSE(Secp256k1Gen::derive_public_key(order, public_key));
+
+    uint8_t below_order[32];
+    std::memcpy(below_order, order, 32);
+    below_order[31] = 0x40;
+    EXPECT_TRUE(Secp256k1Gen::derive_public_key(below_order, public_key));
+}
+
+TEST(Base58Test, KnownVectors) {
+    EXPECT_EQ(Base58::encode(reinterpret_cast<const uint8_t*>("hello world"), 11), "StV1DL6CwTryKyV");
+    const uint8_t leading_zeros[] = {0x00, 0x00, 0x28, 0x7f, 0xb4, 0xcd};
+    EXPECT_EQ(Base58::encode(leading_zeros, sizeof(leading_zeros)), "11233QC4");
+    EXPECT_EQ(Base58::encode(leading_zeros, 0), "");
+
+    // Bitcoin wiki address example: version 0 + hash160
+    const uint8_t hash160[] = {0x00, 0x01, 0x09, 0x66, 0x77, 0x60, 0x06, 0x95, 0x3D, 0x55, 0x67,
+                               0x43, 0x9E, 0x5E, 0x39, 0xF8, 0x6A, 0x0D, 0x27, 0x3B, 0xEE};
+    EXPECT_EQ(Base58::encode_check(hash160, sizeof(hash160)), "16UwLL9Risc3QfPqBUvKofHmBQ7wMtjvM");
+}
+
+TEST(ScryptTest, ReferenceMatchesKnownVectorsAtEveryLookupGap) {
+    // The BIP38 vector is left to the engine test, which runs its lanes in parallel
+    for (size_t i = 0; i < 3; i++) {
+        const ScryptVector& vector = SCRYPT_VECTORS[i];
+        const ScryptParams& params = vector.params;
+        for (uint32_t gap : {1u, 3u, 16u}) {
+            std::vector<uint8_t> blocks(params.p * 128 * params.r);
+            std::vector<uint32_t> scratch(scrypt_scratch_words(params, gap) + scrypt_block_words(params.r));
+            uint8_t key[64];
+            scrypt_derive(reinterpret_cast<const uint8_t*>(vector.password), strlen(vector.password),
+                          reinterpret_cast<const uint8_t*>(vector.salt), strlen(vector.salt), params,
+                          key, sizeof(key), blocks.data(), scratch.data(), gap);
+            EXPECT_EQ(to_hex(key, sizeof(key)), vector.expected_hex) << "vector " << i << " gap " << gap;
+        }
+    }
+}
+
+TEST(ScryptTest, EngineMatchesKnownVectorsWithAndWithoutSIMD) {
+    for (bool simd : {false, true}) {
+        for (const ScryptVector& vector : SCRYPT_VECTORS) {
+            ScryptEngine engine(vector.params, 4, simd);
+            const uint8_t* password = reinterpret_cast<const uint8_t*>(vector.password);
+            const size_t length = strlen(vector.password);
+
+            // Same password twice to check each candidate gets its own blocks
+            const uint8_t* passwords[] = {password, password};
+            const size_t lengths[] = {length, length};
+            uint8_t keys[128];
+            ASSERT_TRUE(engine.derive(passwords, lengths, 2, reinterpret_cast<const uint8_t*>(vector.salt),
+                                      strlen(vector.salt), keys, 64)) << engine.get_last_error();
+            EXPECT_EQ(to_hex(keys, 64), vector.expected_hex) << "simd " << simd;
+            EXPECT_EQ(to_hex(keys + 64, 64), vector.expected_hex) << "simd " << simd;
+        }
+    }
+}
+
+TEST(ScryptTest, TmtoKeepsFullTablesWhenTheyFitAndTradesComputeWhenNot) {
+    const size_t full_table = 16384 * 1024;   // N * 128 * r for BIP38
+
+    ScryptTmtoPlan plan = scrypt_plan_tmto(SCRYPT_BIP38_PARAMS, 64 * full_table, 64);
+    EXPECT_EQ(plan.lookup_gap, 1u);
+    EXPECT_EQ(plan.lanes, 64u);
+    EXPECT_EQ(plan.bytes_per_lane, full_table);
+
+    // 8 GB for 16384 lanes: full tables fit 512, so a gap wins
+    plan = scrypt_plan_tmto(SCRYPT_BIP38_PARAMS, 8ULL << 30, 16384);
+    EXPECT_GT(plan.lookup_gap, 1u);
+    EXPECT_GT(plan.lanes, 512u);
+    EXPECT_LE(plan.lanes * plan.bytes_per_lane, 8ULL << 30);
+
+    plan = scrypt_plan_tmto(SCRYPT_BIP38_PARAMS, 1024, 16);
+    EXPECT_EQ(plan.lanes, 0u);
+}
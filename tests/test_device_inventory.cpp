@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include "gpu/device_inventory.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace {
+
+DeviceInventory laptop_inventory() {
+    DeviceInventory inventory;
+    inventory.fingerprint = "3f2a9c0d11e4b875";
+
+    InventoryDevice iris;
+    iris.backend = InventoryBackend::OPENCL;
+    iris.index = 0;
+    iris.name = "Intel(R) Iris(R) Xe Graphics";
+    iris.vendor = "Intel";
+    iris.device_version = "OpenCL 3.0 NEO";
+    iris.driver_version = "23.22.26516.18";
+    iris.global_memory = 13ull * 1024 * 1024 * 1024;
+    iris.compute_units = 96;
+    iris.max_work_group_size = 512;
+    iris.max_clock_mhz = 1300;
+    iris.integrated = true;
+    inventory.devices.push_back(iris);
+
+    InventoryDevice mx;
+    mx.backend = InventoryBackend::CUDA;
+    mx.index = 0;
+    mx.name = "NVIDIA GeForce MX450";
+    mx.vendor = "NVIDIA";
+    mx.device_version = "7.5";
+    mx.driver_version = "12020";
+    mx.global_memory = 2ull * 1024 * 1024 * 1024;
+    mx.compute_units = 14;
+    mx.max_work_group_size = 1024;
+    mx.max_clock_mhz = 1575;
+    mx.unified_addressing = true;
+    mx.shared_memory_per_block = 49152;
+    mx.max_threads_per_multiprocessor = 1024;
+    mx.warp_size = 32;
+    mx.max_grid_size[0] = 2147483647;
+    mx.max_grid_size[1] = 65535;
+    mx.max_grid_size[2] = 65535;
+    mx.max_block_size[0] = 1024;
+    mx.max_block_size[1] = 1024;
+    mx.max_block_size[2] = 64;
+    mx.memory_bus_width = 64;
+    mx.memory_clock_khz = 5001000;
+    mx.clock_khz = 1575000;
+    inventory.devices.push_back(mx);
+    return inventory;
+}
+
+} // namespace
+
+TEST(DeviceInventoryTest, InventoryRoundTripsUnderTheSameFingerprint) {
+    const std::string path = ::testing::TempDir() + "btc_recovery_devices_roundtrip.tsv";
+    std::remove(path.c_str());
+    DeviceInventoryCache cache(path);
+    const DeviceInventory stored = laptop_inventory();
+
+    DeviceInventory loaded;
+    EXPECT_FALSE(cache.load(stored.fingerprint, loaded));
+    ASSERT_TRUE(cache.store(stored)) << cache.get_last_error();
+    ASSERT_TRUE(cache.load(stored.fingerprint, loaded));
+    EXPECT_TRUE(loaded.from_cache);
+    ASSERT_EQ(loaded.devices.size(), 2u);
+
+    const InventoryDevice* iris = loaded.find(InventoryBackend::OPENCL, 0);
+    ASSERT_NE(iris, nullptr);
+    EXPECT_EQ(iris->name, "Intel(R) Iris(R) Xe Graphics");
+    EXPECT_EQ(iris->driver_version, "23.22.26516.18");
+    EXPECT_EQ(iris->global_memory, 13ull * 1024 * 1024 * 1024);
+    EXPECT_TRUE(iris->integrated);
+
+    const InventoryDevice* mx = loaded.find(InventoryBackend::CUDA, 0);
+    ASSERT_NE(mx, nullptr);
+    EXPECT_EQ(mx->device_version, "7.5");
+    EXPECT_EQ(mx->compute_units, 14);
+    EXPECT_TRUE(mx->unified_addressing);
+    EXPECT_EQ(mx->max_grid_size[0], 2147483647);
+    EXPECT_EQ(mx->max_block_size[2], 64);
+    EXPECT_EQ(mx->memory_clock_khz, 5001000);
+    EXPECT_EQ(loaded.find(InventoryBackend::CUDA, 1), nullptr);
+    std::remove(path.c_str());
+}
+
+TEST(DeviceInventoryTest, ChangedFingerprintIsAMiss) {
+    const std::string path = ::testing::TempDir() + "btc_recovery_devices_fingerprint.tsv";
+    DeviceInventoryCache cache(path);
+    ASSERT_TRUE(cache.store(laptop_inventory()));
+
+    // A driver upgrade or a new ICD changes the fingerprint
+    DeviceInventory loaded;
+    EXPECT_FALSE(cache.load("77c0e1d2a4b5f609", loaded));
+    EXPECT_TRUE(loaded.devices.empty());
+    std::remove(path.c_str());
+}
+
+TEST(DeviceInventoryTest, TruncatedFileIsAMiss) {
+    const std::string path = ::testing::TempDir() + "btc_recovery_devices_truncated.tsv";
+    DeviceInventoryCache cache(path);
+    const DeviceInventory stored = laptop_inventory();
+    ASSERT_TRUE(cache.store(stored));
+
+    // Drop the last device line, as a crash mid-copy would
+    std::ifstream in(path);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    contents.erase(contents.rfind('\n', contents.size() - 2) + 1);
+    std::ofstream(path, std::ios::trunc) << contents;
+
+    DeviceInventory loaded;
+    EXPECT_FALSE(cache.load(stored.fingerprint, loaded));
+    std::remove(path.c_str());
+}
+
+TEST(DeviceInventoryTest, BackendDevicesAreInIndexOrder) {
+    DeviceInventory inventory = laptop_inventory();
+    InventoryDevice vega;
+    vega.backend = InventoryBackend::OPENCL;
+    vega.index = 1;
+    vega.name = "gfx90c";
+    vega.vendor = "AMD";
+    inventory.devices.insert(inventory.devices.begin(), vega);
+
+    const auto opencl = inventory.backend_devices(InventoryBackend::OPENCL);
+    ASSERT_EQ(opencl.size(), 2u);
+    EXPECT_EQ(opencl[0].vendor, "Intel");
+    EXPECT_EQ(opencl[1].vendor, "AMD");
+    EXPECT_EQ(inventory.backend_devices(InventoryBackend::CUDA).size(), 1u);
+}
+
+TEST(DeviceInventoryTest, FingerprintIsStableWithinARun) {
+    EXPECT_EQ(device_fingerprint(), device_fingerprint());
+    EXPECT_EQ(device_fingerprint().size(), 16u);
+}
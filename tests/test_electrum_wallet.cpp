@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include "wallets/electrum_wallet.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <openssl/evp.h>
+
+namespace {
+
+const std::string PASSWORD = "correct horse battery";
+const std::string OLD_SEED = "5e9a2f0b7c1d48e3a6b90f21c4d87e35";
+const std::string MNEMONIC = "wild father tree among universe such mobile favorite target dynamic credit identify";
+const std::string XPRV = "xprv9s21ZrQH143K3QTDL4LXw2F7HEK3wJUD2nW2nRk4stbPy6cq3jPPqjiChkVvvNKmPGJxWUtg6LnF5kejMRNNU3TGtRBeJgk33yuGBxrMPHi";
+
+// Electrum's pw_encode: base64(IV || AES-256-CBC(secret)) under SHA-256d(password),
+// computed here with OpenSSL rather than the verifier's own hashing
+std::string pw_encode(const std::string& secret, const std::string& password, uint8_t iv_seed = 0x31) {
+    uint8_t once[32];
+    uint8_t key[32];
+    unsigned int length = 0;
+    EVP_Digest(password.data(), password.size(), once, &length, EVP_sha256(), nullptr);
+    EVP_Digest(once, sizeof(once), key, &length, EVP_sha256(), nullptr);
+
+    std::vector<uint8_t> data(16 + secret.size() + 16);
+    for (int i = 0; i < 16; i++) data[i] = static_cast<uint8_t>(iv_seed + i * 7);
+    int written = 0;
+    int final_written = 0;
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key, data.data());
+    EVP_EncryptUpdate(ctx, data.data() + 16, &written, reinterpret_cast<const uint8_t*>(secret.data()),
+                      static_cast<int>(secret.size()));
+    EVP_EncryptFinal_ex(ctx, data.data() + 16 + written, &final_written);
+    EVP_CIPHER_CTX_free(ctx);
+    data.resize(16 + written + final_written);
+
+    std::string encoded(4 * ((data.size() + 2) / 3), '\0');
+    EVP_EncodeBlock(reinterpret_cast<unsigned char*>(&encoded[0]), data.data(), static_cast<int>(data.size()));
+    return encoded;
+}
+
+std::string write_wallet(const std::string& name, const std::string& contents) {
+    const std::string path = ::testing::TempDir() + name;
+    std::ofstream(path, std::ios::binary) << contents;
+    return path;
+}
+
+// Electrum 1.x: a Python dict literal
+std::string electrum1_wallet(const std::string& password) {
+    return "{'seed_version': 4, 'use_encryption': True, 'fee': 50000, 'master_public_key': "
+           "'8d1a3b0c0f2e4d5c6b7a8998a7b6c5d4e3f201f2e3d4c5b6a79889a7b6c5d4e3f2018d1a3b0c0f2e4d5c6b7a"
+           "8998a7b6c5d4e3f201f2e3d4c5b6a79889a7b6c5d4e3f201', 'seed': '" + pw_encode(OLD_SEED, password) +
+           "', 'accounts': {0: {0: ['1Nx3NRoM7ZvKzPu5SSBQ8vCVb8n7VXCGyN'], 1: []}}, 'imported_keys': {}}";
+}
+
+// Electrum 2.7: JSON with a BIP32 keystore
+std::string electrum2_wallet(const std::string& password) {
+    return "{\n    \"addr_history\": {},\n    \"keystore\": {\n        \"seed\": \"" + pw_encode(MNEMONIC, password) +
+           "\",\n        \"type\": \"bip32\",\n        \"xprv\": \"" + pw_encode(XPRV, password, 0x52) +
+           "\",\n        \"xpub\": \"xpub661MyMwAqRbcFtXgS5sYJABqqG9YLmC4Q1Rdap9gSE8NqtwybGhePY2gZ29ESFjqJoCu1Rupje8YtGqsefD265TMg7usUDFdp6W1EGMcet8\"\n"
+           "    },\n    \"seed_type\": \"standard\",\n    \"seed_version\": 13,\n    \"use_encryption\": true,\n"
+           "    \"wallet_type\": \"standard\"\n}";
+}
+
+} // namespace
+
+TEST(ElectrumWalletTest, Base64DecodeSkipsWhitespaceAndStopsAtPadding) {
+    std::vector<uint8_t> out;
+    ASSERT_TRUE(ElectrumWallet::base64_decode("aGVs\nbG8g d29y bGQ=", out));
+    EXPECT_EQ(std::string(out.begin(), out.end()), "hello world");
+    ASSERT_TRUE(ElectrumWallet::base64_decode("", out));
+    EXPECT_TRUE(out.empty());
+    EXPECT_FALSE(ElectrumWallet::base64_decode("aGVs*bG8=", out));
+    // A seed stored in the clear is not base64
+    EXPECT_FALSE(ElectrumWallet::base64_decode(MNEMONIC.substr(0, 10) + "-", out));
+}
+
+TEST(ElectrumWalletTest, FindsFieldsInDictsAndJson) {
+    std::string value;
+    ASSERT_TRUE(ElectrumWallet::find_string_field("{'seed_version': 4, 'seed': 'abc'}", "seed", value));
+    EXPECT_EQ(value, "abc");
+    ASSERT_TRUE(ElectrumWallet::find_string_field("{\"seed\" :  \"xyz\"}", "seed", value));
+    EXPECT_EQ(value, "xyz");
+
+    // A key appearing as a value, or with a non-string value, is skipped
+    ASSERT_TRUE(ElectrumWallet::find_string_field("{\"label\": \"seed\", \"seed\": \"real\"}", "seed", value));
+    EXPECT_EQ(value, "real");
+    EXPECT_FALSE(ElectrumWallet::find_string_field("{'seed': None}", "seed", value));
+    EXPECT_FALSE(ElectrumWallet::find_string_field("{'seed_version': 4}", "seed", value));
+
+    std::string token;
+    ASSERT_TRUE(ElectrumWallet::find_token_field("{'seed_version': 4, 'use_encryption': True}", "use_encryption", token));
+    EXPECT_EQ(token, "True");
+    ASSERT_TRUE(ElectrumWallet::find_token_field("{\"seed_version\": 13}", "seed_version", token));
+    EXPECT_EQ(token, "13");
+}
+
+TEST(ElectrumWalletTest, LoadsElectrum1HexSeed) {
+    const std::string path = write_wallet("btc_recovery_electrum1", electrum1_wallet(PASSWORD));
+    ElectrumWallet wallet(path);
+    ASSERT_TRUE(wallet.load()) << wallet.get_last_error();
+    EXPECT_EQ(wallet.get_seed_version(), 4);
+
+    ElectrumKeyCheck check;
+    ASSERT_TRUE(wallet.get_key_check(check));
+    EXPECT_EQ(check.plaintext_kind, static_cast<uint32_t>(ELECTRUM_PLAINTEXT_HEX_SEED));
+
+    std::string secret;
+    ASSERT_TRUE(wallet.decrypt_secret(PASSWORD, secret));
+    EXPECT_EQ(secret, OLD_SEED);
+    EXPECT_FALSE(wallet.test_password("correct horse battery!"));
+    std::remove(path.c_str());
+}
+
+TEST(ElectrumWalletTest, LoadsElectrum2KeystorePreferringTheXprv) {
+    const std::string path = write_wallet("btc_recovery_electrum2", electrum2_wallet(PASSWORD));
+    ElectrumWallet wallet(path);
+    ASSERT_TRUE(wallet.load()) << wallet.get_last_error();
+    EXPECT_EQ(wallet.get_seed_version(), 13);
+
+    ElectrumKeyCheck check;
+    ASSERT_TRUE(wallet.get_key_check(check));
+    EXPECT_EQ(check.plaintext_kind, static_cast<uint32_t>(ELECTRUM_PLAINTEXT_XPRV));
+
+    std::string secret;
+    ASSERT_TRUE(wallet.decrypt_secret(PASSWORD, secret));
+    EXPECT_EQ(secret, XPRV);
+
+    const std::vector<std::string> candidates = {"hunter2", "Correct horse battery", PASSWORD, "letmein"};
+    EXPECT_EQ(wallet.test_passwords(candidates), 2);
+    std::remove(path.c_str());
+}
+
+TEST(ElectrumWalletTest, OldKeystoreSeedIsHex) {
+    // A 1.x seed restored into Electrum 2.7 keeps its hex seed under a keystore of type "old"
+    const std::string keystore =
+        "{\"addr_history\": {}, \"keystore\": {\"mpk\": \"e9d4b7866dd1e91c862aebf62a49548c7dbf7bcc6e4b7b8c9da820c7737968df"
+        "9c09d5a3e271dc814a29981f81b3faaf2737b551ef5dcc6189cf0f8252c442b3\", \"seed\": \"" + pw_encode(OLD_SEED, PASSWORD) +
+        "\", \"type\": \"old\"}, \"seed_version\": 13, \"use_encryption\": true, \"wallet_type\": \"standard\"}";
+    // Electrum 2.0 to 2.6 marked an upgraded 1.x wallet with wallet_type "old"
+    const std::string upgraded =
+        "{\"seed\": \"" + pw_encode(OLD_SEED, PASSWORD) + "\", \"seed_version\": 11, \"use_encryption\": true, "
+        "\"wallet_type\": \"old\"}";
+
+    for (const std::string& contents : {keystore, upgraded}) {
+        const std::string path = write_wallet("btc_recovery_electrum_old", contents);
+        ElectrumWallet wallet(path);
+        ASSERT_TRUE(wallet.load()) << wallet.get_last_error();
+        ElectrumKeyCheck check;
+        ASSERT_TRUE(wallet.get_key_check(check));
+        EXPECT_EQ(check.plaintext_kind, static_cast<uint32_t>(ELECTRUM_PLAINTEXT_HEX_SEED));
+        EXPECT_TRUE(wallet.test_password(PASSWORD));
+        std::remove(path.c_str());
+    }
+}
+
+TEST(ElectrumWalletTest, MnemonicSeedWithoutXprv) {
+    const std::string contents = "{\"master_public_keys\": {\"x/\": \"xpub661MyMwAqRbcF\"}, \"seed\": \"" +
+                                 pw_encode(MNEMONIC, PASSWORD) + "\", \"seed_version\": 11, "
+                                 "\"use_encryption\": true, \"wallet_type\": \"standard\"}";
+    const std::string path = write_wallet("btc_recovery_electrum_mnemonic", contents);
+    ElectrumWallet wallet(path);
+    ASSERT_TRUE(wallet.load()) << wallet.get_last_error();
+    ElectrumKeyCheck check;
+    ASSERT_TRUE(wallet.get_key_check(check));
+    EXPECT_EQ(check.plaintext_kind, static_cast<uint32_t>(ELECTRUM_PLAINTEXT_MNEMONIC));
+    std::string secret;
+    ASSERT_TRUE(wallet.decrypt_secret(PASSWORD, secret));
+    EXPECT_EQ(secret, MNEMONIC);
+    std::remove(path.c_str());
+}
+
+TEST(ElectrumWalletTest, FullDecryptConfirmsPastTheFirstBlock) {
+    // The first block is valid hex, so only the full decrypt can reject it
+    const std::string corrupt = OLD_SEED.substr(0, 16) + "0123456789ABCDEF";
+    const std::string contents = "{'seed_version': 4, 'use_encryption': True, 'seed': '" +
+                                 pw_encode(corrupt, PASSWORD) + "'}";
+    const std::string path = write_wallet("btc_recovery_electrum_corrupt", contents);
+    ElectrumWallet wallet(path);
+    ASSERT_TRUE(wallet.load()) << wallet.get_last_error();
+    std::string secret;
+    EXPECT_FALSE(wallet.decrypt_secret(PASSWORD, secret));
+    EXPECT_FALSE(wallet.test_password(PASSWORD));
+    std::remove(path.c_str());
+}
+
+TEST(ElectrumWalletTest, RejectsUnsupportedAndUnencryptedWallets) {
+    // Electrum 2.8 and later: the whole file is base64 of a "BIE1" ECIES envelope
+    const std::string ecies = write_wallet("btc_recovery_electrum_ecies",
+                                           "QklFMQOe0Rk5mvmLhVhBJ0nXtR6QVjYBDGW0sUcrK4HnPo9ZHJqzNQiM4Mz1Q7Y8n");
+    ElectrumWallet encrypted_file(ecies);
+    EXPECT_FALSE(encrypted_file.load());
+    EXPECT_NE(encrypted_file.get_last_error().find("ECIES"), std::string::npos);
+
+    const std::string clear = write_wallet("btc_recovery_electrum_clear",
+                                           "{\"seed\": \"" + MNEMONIC + "\", \"seed_version\": 11, "
+                                           "\"use_encryption\": false, \"wallet_type\": \"standard\"}");
+    ElectrumWallet unencrypted(clear);
+    EXPECT_FALSE(unencrypted.load());
+
+    const std::string watching = write_wallet("btc_recovery_electrum_watching",
+                                              "{\"keystore\": {\"type\": \"bip32\", \"xpub\": \"xpub661MyMwAqRbcF\"}, "
+                                              "\"seed_version\": 13, \"use_encryption\": true}");
+    ElectrumWallet watch_only(watching);
+    EXPECT_FALSE(watch_only.load());
+    EXPECT_NE(watch_only.get_last_error().find("No seed"), std::string::npos);
+
+    std::remove(ecies.c_str());
+    std::remove(clear.c_str());
+    std::remove(watching.c_str());
+}
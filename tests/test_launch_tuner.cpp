@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+#include "gpu/kernel_variants.h"
+#include "gpu/launch_tuner.h"
+#include "gpu/thermal_governor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+TEST(LaunchTunerTest, SearchSpaceStaysWithinDeviceLimits) {
+    LaunchConfig base;
+    base.threads_per_block = 192;
+    base.batch_size = 75000;
+    const LaunchSearchSpace space = LaunchSearchSpace::around(512, 200000, base);
+
+    EXPECT_EQ(space.threads_per_block.front(), 32);
+    EXPECT_EQ(space.threads_per_block.back(), 512);
+    EXPECT_NE(std::find(space.threads_per_block.begin(), space.threads_per_block.end(), 192),
+              space.threads_per_block.end());
+    EXPECT_EQ(space.batch_size.back(), 200000);
+    EXPECT_EQ(space.batch_size.front(), 37500);
+
+    LaunchConfig config;
+    config.threads_per_block = 256;
+    config.candidates_per_thread = 4;
+    config.batch_size = 10000;
+    EXPECT_EQ(config.blocks_per_grid(), 10);
+}
+
+TEST(LaunchTunerTest, FindsTheFastestConfiguration) {
+    LaunchSearchSpace space;
+    space.threads_per_block = {64, 128, 256, 512};
+    space.candidates_per_thread = {1, 2, 4, 8};
+    space.batch_size = {1000, 2000, 4000, 8000};
+
+    // Peaks at 256 threads, 2 per thread and the largest batch; 1024 threads cannot launch
+    int measurements = 0;
+    auto measure = [&](const LaunchConfig& config) {
+        measurements++;
+        if (config.threads_per_block > 512) return 0.0;
+        const double threads = std::log2(config.threads_per_block / 256.0);
+        const double per_thread = std::log2(config.candidates_per_thread / 2.0);
+        return 1000.0 * config.batch_size / (config.batch_size + 500.0) / (1.0 + threads * threads) /
+               (1.0 + per_thread * per_thread);
+    };
+
+    LaunchConfig start;
+    start.threads_per_block = 1024;
+    start.candidates_per_thread = 1;
+    start.batch_size = 1000;
+    double rate = 0.0;
+    const LaunchConfig best = autotune_launch(space, start, measure, rate);
+
+    EXPECT_EQ(best.threads_per_block, 256);
+    EXPECT_EQ(best.candidates_per_thread, 2);
+    EXPECT_EQ(best.batch_size, 8000);
+    EXPECT_GT(rate, 900.0);
+    EXPECT_LT(measurements, 4 * 4 * 4);
+}
+
+TEST(LaunchTunerTest, CacheIsKeyedByDeviceDriverAndKdfCost) {
+    const std::string path = ::testing::TempDir() + "btc_recovery_tuning/launch_tuning.tsv";
+    std::remove(path.c_str());
+
+    TuningKey key;
+    key.device_name = "NVIDIA GeForce GTX 1650 Ti";
+    key.compute_capability = "7.5";
+    key.driver_version = 12020;
+    key.kdf_iterations = 25000;
+    LaunchConfig config;
+    config.threads_per_block = 128;
+    config.candidates_per_thread = 4;
+    config.batch_size = 65536;
+
+    {
+        TuningCache cache(path);
+        ASSERT_TRUE(cache.load());
+        ASSERT_TRUE(cache.store(key, config, 4321.5)) << cache.get_last_error();
+    }
+
+    TuningCache cache(path);
+    ASSERT_TRUE(cache.load()) << cache.get_last_error();
+    LaunchConfig loaded;
+    double rate = 0.0;
+    ASSERT_TRUE(cache.lookup(key, loaded, &rate));
+    EXPECT_TRUE(loaded == config);
+    EXPECT_DOUBLE_EQ(rate, 4321.5);
+
+    // A driver update or a wallet with a different KDF cost needs a new sweep
+    TuningKey updated = key;
+    updated.driver_version = 12040;
+    EXPECT_FALSE(cache.lookup(updated, loaded));
+    TuningKey other_wallet = key;
+    other_wallet.kdf_iterations = 100000;
+    EXPECT_FALSE(cache.lookup(other_wallet, loaded));
+
+    // A corrupt cache is reported, not trusted
+    std::ofstream(path) << "something else\n";
+    TuningCache corrupt(path);
+    EXPECT_FALSE(corrupt.load());
+    EXPECT_EQ(corrupt.size(), 0u);
+    std::remove(path.c_str());
+}
+
+namespace {
+
+// First-order laptop GPU: the die heads for 40 C plus 60 C per unit of work
+// with a 20 s time constant, and the firmware drops clocks to 35% at 87 C
+// until the die is back under 70 C
+struct SimulatedGpu {
+    double temperature = 45.0;
+    bool throttled = false;
+
+    // One second at a work level; returns candidates tested
+    double run(double level) {
+        const double clocks = throttled ? 0.35 : 1.0;
+        const double work = level * clocks;
+        temperature += (40.0 + 60.0 * work - temperature) / 20.0;
+        if (temperature >= 87.0) {
+            throttled = true;
+        } else if (temperature < 70.0) {
+            throttled = false;
+        }
+        return work * 1000.0;
+    }
+
+    GpuSensorReading read() const {
+        GpuSensorReading reading;
+        reading.temperature_c = (float)temperature;
+        reading.thermal_throttling = throttled;
+        return reading;
+    }
+};
+
+} // namespace
+
+TEST(ThermalGovernorTest, SustainsMoreThroughputThanRunningIntoTheLimit) {
+    ThermalLimits limits;
+    limits.throttle_temperature_c = 87.0f;
+    ThermalGovernor governor(limits);
+    SimulatedGpu governed;
+    SimulatedGpu flat_out;
+
+    double governed_total = 0.0;
+    double flat_out_total = 0.0;
+    double hottest_settled = 0.0;
+    for (int second = 0; second < 3600; second++) {
+        const double now = second;
+        if (governor.due(now)) {
+            governor.update(governed.read(), now);
+        }
+        const ThermalSetting& setting = governor.setting();
+        const double tested = governed.run(setting.occupancy * setting.duty_cycle);
+        governor.record((uint64_t)tested);
+        governed_total += tested;
+        flat_out_total += flat_out.run(1.0);
+        if (second >= 600) {
+            hottest_settled = std::max(hottest_settled, governed.temperature);
+        }
+    }
+
+    // Settled just under the throttle point, never into it
+    EXPECT_LT(hottest_settled, 87.0);
+    EXPECT_GT(hottest_settled, 75.0);
+    EXPECT_FALSE(governed.throttled);
+    EXPECT_GT(governed_total, flat_out_total * 1.05);
+    EXPECT_NEAR(governor.sustained_rate(), governed_total / 3600.0, governed_total / 3600.0 * 0.1);
+}
+
+TEST(ThermalGovernorTest, SpendsOccupancyBeforeTheDutyCycle) {
+    ThermalSetting full = ThermalGovernor::setting_for(1.0);
+    EXPECT_DOUBLE_EQ(full.occupancy, 1.0);
+    EXPECT_DOUBLE_EQ(full.duty_cycle, 1.0);
+    EXPECT_DOUBLE_EQ(full.idle_after(0.5), 0.0);
+
+    ThermalSetting reduced = ThermalGovernor::setting_for(0.6);
+    EXPECT_DOUBLE_EQ(reduced.occupancy, 0.6);
+    EXPECT_DOUBLE_EQ(reduced.duty_cycle, 1.0);
+
+    // Under the occupancy floor the device idles a share of the time instead
+    ThermalSetting paced = ThermalGovernor::setting_for(0.25);
+    EXPECT_DOUBLE_EQ(paced.occupancy, ThermalGovernor::OCCUPANCY_FLOOR);
+    EXPECT_DOUBLE_EQ(paced.duty_cycle, 0.5);
+    EXPECT_DOUBLE_EQ(paced.batch_fraction, 0.5);
+    EXPECT_DOUBLE_EQ(paced.idle_after(0.2), 0.2);
+    EXPECT_DOUBLE_EQ(ThermalGovernor::setting_for(0.0).duty_cycle,
+                     ThermalGovernor::MIN_LEVEL / ThermalGovernor::OCCUPANCY_FLOOR);
+}
+
+TEST(ThermalGovernorTest, FollowsThePowerLimitAndIgnoresMissingSensors) {
+    ThermalLimits limits;
+    limits.power_limit_w = 15.0f;
+    ThermalGovernor governor(limits);
+
+    GpuSensorReading none;
+    EXPECT_FALSE(governor.update(none, 0.0));
+    EXPECT_DOUBLE_EQ(governor.level(), 1.0);
+    EXPECT_FALSE(governor.due(0.5));
+    EXPECT_TRUE(governor.due(1.0));
+
+    // A cool die over its power budget still backs off
+    GpuSensorReading over;
+    over.temperature_c = 50.0f;
+    over.power_w = 18.0f;
+    EXPECT_TRUE(governor.update(over, 1.0));
+    EXPECT_TRUE(governor.is_limiting());
+    EXPECT_DOUBLE_EQ(governor.level(), ThermalGovernor::DECREASE);
+
+    // Inside the band the level holds; with headroom it climbs back
+    GpuSensorReading near_limit = over;
+    near_limit.power_w = 14.5f;
+    EXPECT_FALSE(governor.update(near_limit, 2.0));
+    GpuSensorReading under = over;
+    under.power_w = 10.0f;
+    EXPECT_TRUE(governor.update(under, 3.0));
+    EXPECT_DOUBLE_EQ(governor.level(), std::min(1.0, ThermalGovernor::DECREASE + ThermalGovernor::INCREASE));
+}
+
+TEST(KernelVariantsTest, BucketsCoverEachBatchWithTheSmallestVariant) {
+    EXPECT_EQ(kernel_length_bucket(0), 8u);
+    EXPECT_EQ(kernel_length_bucket(8), 8u);
+    EXPECT_EQ(kernel_length_bucket(9), 16u);
+    EXPECT_EQ(kernel_length_bucket(63), 64u);
+    EXPECT_EQ(kernel_length_bucket(65), 0u);
+    EXPECT_EQ(kernel_length_bucket_index(32), 2);
+    EXPECT_EQ(kernel_length_bucket_index(0), -1);
+}
+
+TEST(KernelVariantsTest, SpecialisedSourceBakesInTheWallet) {
+    BitcoinCoreMKeyCheck check;
+    std::memset(&check, 0, sizeof(check));
+    const uint8_t salt[8] = {0x3e, 0x6f, 0x1a, 0x92, 0x05, 0xd4, 0x7b, 0xc8};
+    std::memcpy(check.salt, salt, sizeof(salt));
+    check.salt_length = sizeof(salt);
+    check.iterations = 25000;
+    check.expected_padding = 16;
+
+    const std::string source = nvrtc_mkey_kernel_source(check, 16);
+    EXPECT_NE(source.find(NVRTC_MKEY_KERNEL_NAME), std::string::npos);
+    EXPECT_NE(source.find("mkey_check_password_short<16, 25000u>"), std::string::npos);
+    // Salt, INT(1) and the 0x80 pad start the first message word pair
+    EXPECT_NE(source.find("0x3e6f1a9205d47bc8ULL, 0x0000000180000000ULL"), std::string::npos);
+    EXPECT_NE(nvrtc_mkey_kernel_source(check, 32), source);
+}
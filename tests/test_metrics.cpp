@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include "core/device_scheduler.h"
+#include "gpu/gpu_sensors.h"
+#include "utils/metrics.h"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+bool contains(const std::string& text, const std::string& line) {
+    return text.find(line) != std::string::npos;
+}
+
+void write_file(const std::filesystem::path& path, const std::string& contents) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path) << contents;
+}
+
+} // namespace
+
+TEST(MetricsTest, RendersCountersGaugesAndCumulativeHistograms) {
+    MetricsRegistry registry;
+    registry.counter("test_candidates_total", "Candidates", {{"backend", "cuda"}, {"device", "0"}}).add(1500);
+    registry.gauge("test_in_flight", "Batches in flight").set(3);
+
+    LatencyHistogram& latency = registry.histogram("test_phase_seconds", "Phase time", {{"phase", "kernel"}});
+    latency.observe(0.0004);   // le 0.0005
+    latency.observe(0.02);     // le 0.025
+    latency.observe(120.0);    // +Inf only
+
+    const std::string text = registry.render();
+    EXPECT_TRUE(contains(text, "# TYPE test_candidates_total counter\n"));
+    EXPECT_TRUE(contains(text, "test_candidates_total{backend=\"cuda\",device=\"0\"} 1500\n"));
+    EXPECT_TRUE(contains(text, "# TYPE test_in_flight gauge\ntest_in_flight 3\n"));
+    EXPECT_TRUE(contains(text, "# TYPE test_phase_seconds histogram\n"));
+    EXPECT_TRUE(contains(text, "test_phase_seconds_bucket{phase=\"kernel\",le=\"0.00025\"} 0\n"));
+    EXPECT_TRUE(contains(text, "test_phase_seconds_bucket{phase=\"kernel\",le=\"0.0005\"} 1\n"));
+    EXPECT_TRUE(contains(text, "test_phase_seconds_bucket{phase=\"kernel\",le=\"0.025\"} 2\n"));
+    EXPECT_TRUE(contains(text, "test_phase_seconds_bucket{phase=\"kernel\",le=\"60\"} 2\n"));
+    EXPECT_TRUE(contains(text, "test_phase_seconds_bucket{phase=\"kernel\",le=\"+Inf\"} 3\n"));
+    EXPECT_TRUE(contains(text, "test_phase_seconds_count{phase=\"kernel\"} 3\n"));
+    EXPECT_NEAR(latency.sum(), 120.0204, 1e-6);
+}
+
+TEST(MetricsTest, SameNameAndLabelsIsTheSameMetric) {
+    MetricsRegistry registry;
+    MetricCounter& first = registry.counter("test_total", "Total", {{"device", "1"}});
+    MetricCounter& again = registry.counter("test_total", "Total", {{"device", "1"}});
+    MetricCounter& other = registry.counter("test_total", "Total", {{"device", "2"}});
+    EXPECT_EQ(&first, &again);
+    EXPECT_NE(&first, &other);
+    EXPECT_THROW(registry.gauge("test_total", "Total"), std::logic_error);
+
+    // Counters may be bumped from every device thread at once
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&first] {
+            for (int i = 0; i < 10000; i++) {
+                first.add();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(again.value(), 40000u);
+}
+
+TEST(MetricsTest, CallbacksAreSampledAtRenderUntilRemoved) {
+    MetricsRegistry registry;
+    int owner = 0;
+    int samples = 0;
+    registry.add_callback(&owner, "test_temperature_celsius", "Temperature", {{"device", "0"}}, [&samples] {
+        samples++;
+        return 61.5;
+    });
+    registry.add_callback(&owner, "test_temperature_celsius", "Temperature", {{"device", "1"}},
+                          [] { return std::nan(""); });
+    EXPECT_EQ(samples, 0);
+
+    const std::string text = registry.render();
+    EXPECT_EQ(samples, 1);
+    EXPECT_TRUE(contains(text, "test_temperature_celsius{device=\"0\"} 61.5\n"));
+    EXPECT_FALSE(contains(text, "device=\"1\""));   // NaN: sensor unavailable
+
+    registry.remove_callbacks(&owner);
+    EXPECT_FALSE(contains(registry.render(), "test_temperature_celsius"));
+    EXPECT_EQ(samples, 1);
+}
+
+TEST(MetricsTest, DeviceSchedulerExportsProgressAndPerDeviceCounts) {
+    ComputeDevice gpu;
+    gpu.kind = ComputeDeviceKind::CUDA;
+    gpu.device_id = 7;
+    {
+        DeviceScheduler scheduler({gpu}, {{0, 4000}});
+        scheduler.report(0, 1000, 0.5);
+        const std::string text = MetricsRegistry::global().render();
+        EXPECT_TRUE(contains(text, "btc_recovery_keyspace_completed_percent 25\n"));
+        EXPECT_TRUE(contains(text, "btc_recovery_device_candidates_per_second{backend=\"cuda\",device=\"7\"} 2000\n"));
+        EXPECT_TRUE(contains(text, "btc_recovery_chunk_seconds_count{backend=\"cuda\",device=\"7\"}"));
+    }
+    // Progress of a finished scheduler is no longer exported
+    EXPECT_FALSE(contains(MetricsRegistry::global().render(), "btc_recovery_keyspace_completed_percent"));
+}
+
+TEST(GpuSensorsTest, ReadsTegraThermalZoneAndDevfreqClock) {
+    namespace fs = std::filesystem;
+    const fs::path root = fs::path(::testing::TempDir()) / "btc_recovery_fake_sysfs";
+    fs::remove_all(root);
+    write_file(root / "class/thermal/thermal_zone0/type", "CPU-therm\n");
+    write_file(root / "class/thermal/thermal_zone0/temp", "48000\n");
+    write_file(root / "class/thermal/thermal_zone1/type", "GPU-therm\n");
+    write_file(root / "class/thermal/thermal_zone1/temp", "52500\n");
+    write_file(root / "class/devfreq/17000000.gv11b/cur_freq", "1377000000\n");
+
+    GpuSensors sensors(root.string());
+    GpuSensorReading reading;
+    ASSERT_TRUE(sensors.read("", reading));
+    EXPECT_FLOAT_EQ(reading.temperature_c, 52.5f);
+    EXPECT_EQ(reading.graphics_clock_mhz, 1377);
+    EXPECT_EQ(reading.memory_clock_mhz, -1);
+
+    fs::remove_all(root);
+    EXPECT_FALSE(sensors.read("", reading));
+    EXPECT_FLOAT_EQ(reading.temperature_c, -1.0f);
+}
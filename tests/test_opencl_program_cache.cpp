@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include "gpu/opencl_program_cache.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+ProgramCacheKey iris_key() {
+    ProgramCacheKey key;
+    key.device_name = "Intel(R) Iris(R) Xe Graphics";
+    key.device_version = "OpenCL 3.0 NEO";
+    key.driver_version = "23.22.26516.18";
+    key.platform_version = "OpenCL 3.0";
+    key.build_options = "-cl-fast-relaxed-math -cl-mad-enable";
+    key.source = "__kernel void verify_master_key() {}";
+    return key;
+}
+
+} // namespace
+
+TEST(OpenCLProgramCacheTest, BinaryRoundTripsForTheSameKey) {
+    ProgramBinaryCache cache(::testing::TempDir() + "btc_recovery_clbin_roundtrip");
+    const ProgramCacheKey key = iris_key();
+    cache.remove(key);
+
+    std::vector<unsigned char> binary;
+    EXPECT_FALSE(cache.load(key, binary));
+
+    // Binaries are arbitrary bytes, newlines and NULs included
+    const std::vector<unsigned char> compiled = {0x7f, 'E', 'L', 'F', '\n', 0x00, 0xff, '\n', 0x01};
+    ASSERT_TRUE(cache.store(key, compiled)) << cache.get_last_error();
+    ASSERT_TRUE(cache.load(key, binary));
+    EXPECT_EQ(binary, compiled);
+
+    cache.remove(key);
+    EXPECT_FALSE(cache.load(key, binary));
+}
+
+TEST(OpenCLProgramCacheTest, DriverOptionsOrSourceChangeIsAMiss) {
+    ProgramBinaryCache cache(::testing::TempDir() + "btc_recovery_clbin_keys");
+    const ProgramCacheKey key = iris_key();
+    ASSERT_TRUE(cache.store(key, {1, 2, 3, 4}));
+
+    std::vector<unsigned char> binary;
+    ProgramCacheKey updated_driver = key;
+    updated_driver.driver_version = "24.09.28717.12";
+    EXPECT_FALSE(cache.load(updated_driver, binary));
+
+    ProgramCacheKey other_options = key;
+    other_options.build_options = "-cl-fast-relaxed-math";
+    EXPECT_FALSE(cache.load(other_options, binary));
+
+    ProgramCacheKey edited_source = key;
+    edited_source.source += "\n";
+    EXPECT_FALSE(cache.load(edited_source, binary));
+
+    EXPECT_TRUE(cache.load(key, binary));
+    cache.remove(key);
+}
+
+TEST(OpenCLProgramCacheTest, TruncatedOrForeignFileIsAMiss) {
+    ProgramBinaryCache cache(::testing::TempDir() + "btc_recovery_clbin_corrupt");
+    const ProgramCacheKey key = iris_key();
+    const std::vector<unsigned char> compiled(4096, 0x5a);
+    ASSERT_TRUE(cache.store(key, compiled));
+
+    // Cut the file short, as a crash during an unsafe copy would
+    const std::string path = cache.path_for(key);
+    std::ifstream in(path, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << contents.substr(0, contents.size() - 100);
+
+    std::vector<unsigned char> binary;
+    EXPECT_FALSE(cache.load(key, binary));
+
+    // Same name, different identity: never trusted even on a hash collision
+    std::ofstream(path, std::ios::binary | std::ios::trunc)
+        << "btc_recovery_clbin 1\nsome other device\n4\nabcd";
+    EXPECT_FALSE(cache.load(key, binary));
+
+    cache.remove(key);
+}
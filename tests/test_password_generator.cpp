@@ -0,0 +1,905 @@
+#include <gtest/gtest.h>
+#include "core/candidate_batch.h"
+#include "core/checkpoint.h"
+#include "core/device_scheduler.h"
+#include "core/dictionary_source.h"
+#include "core/keyspace_scheduler.h"
+#include "core/markov_model.h"
+#include "core/mask_generator.h"
+#include "core/rule_engine.h"
+#include "core/tested_candidates.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(CandidateBatchTest, PushRejectsFullBatchesAndOverlongCandidates) {
+    CandidateBatch batch(2, 8);
+    EXPECT_EQ(batch.max_length(), 7u);
+    EXPECT_TRUE(batch.push("abc"));
+    EXPECT_FALSE(batch.push("abcdefgh"));   // One byte past max_length()
+    EXPECT_TRUE(batch.push("abcdefg"));
+    EXPECT_TRUE(batch.full());
+    EXPECT_FALSE(batch.push("x"));
+    EXPECT_EQ(batch.size(), 2u);
+    EXPECT_EQ(batch.to_string(0), "abc");
+    EXPECT_EQ(batch.to_string(1), "abcdefg");
+    EXPECT_EQ(batch.longest(), 7u);
+
+    // A shorter candidate over a longer one leaves only zeros behind it
+    batch.clear();
+    ASSERT_TRUE(batch.push(std::string("x")));
+    ASSERT_TRUE(batch.push(std::string("y")));
+    const uint8_t expected[8] = {1, 'y', 0, 0, 0, 0, 0, 0};
+    EXPECT_EQ(std::memcmp(batch.slot(1), expected, sizeof(expected)), 0);
+}
+
+TEST(CandidateBatchTest, TruncateAndAppend) {
+    CandidateBatch batch(4, 16);
+    for (const char* word : {"alpha", "beta", "gamma"}) {
+        ASSERT_TRUE(batch.push(word));
+    }
+    batch.truncate(5);   // Larger than the batch: no change
+    EXPECT_EQ(batch.size(), 3u);
+    batch.truncate(1);
+    EXPECT_EQ(batch.size(), 1u);
+    EXPECT_EQ(batch.buffer_size(), 16u);
+    ASSERT_TRUE(batch.push("delta"));
+    EXPECT_EQ(batch.to_string(1), "delta");
+
+    // Same stride block-copies; another stride re-pushes and stops at what fits
+    CandidateBatch same(3, 16);
+    EXPECT_EQ(same.append(batch, 0, 10), 2u);
+    EXPECT_EQ(same.to_string(1), "delta");
+    CandidateBatch narrow(4, 6);
+    ASSERT_TRUE(batch.push("epsilon"));
+    EXPECT_EQ(narrow.append(batch, 1, 10), 1u);   // "epsilon" is longer than 5
+    EXPECT_EQ(narrow.to_string(0), "delta");
+    EXPECT_EQ(narrow.append(batch, 3, 1), 0u);
+}
+
+TEST(CandidateBatchTest, AppendSlotZeroesARecycledSlot) {
+    CandidateBatch batch(1, 8);
+    ASSERT_TRUE(batch.push("abcdefg"));
+    EXPECT_EQ(batch.append_slot(), nullptr);
+
+    batch.clear();
+    uint8_t* slot = batch.append_slot();
+    ASSERT_NE(slot, nullptr);
+    slot[0] = 'z';
+    batch.set_length(0, 1);
+    const uint8_t expected[8] = {1, 'z', 0, 0, 0, 0, 0, 0};
+    EXPECT_EQ(std::memcmp(batch.slot(0), expected, sizeof(expected)), 0);
+}
+
+TEST(CandidateBatchTest, GeneratorsPadRecycledSlots) {
+    // Generators take unzeroed slots and write the padding themselves
+    CandidateBatch batch(4, 16);
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(batch.push("stalestalestale"));
+    }
+    batch.clear();
+    MaskGenerator generator;
+    ASSERT_TRUE(generator.add_mask("?d?d"));
+    ASSERT_EQ(generator.fill(0, 2, batch), 2u);
+
+    RuleEngine rules;
+    ASSERT_TRUE(rules.add_rule(":"));
+    CandidateBatch words(1, 16);
+    ASSERT_TRUE(words.push("abc"));
+    size_t word_index = 0;
+    size_t rule_index = 0;
+    ASSERT_EQ(rules.expand(words, word_index, rule_index, batch), 1u);
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        const uint8_t* data = batch.data(i);
+        for (size_t p = batch.length(i); p < batch.max_length(); p++) {
+            ASSERT_EQ(data[p], 0) << "candidate " << i << " byte " << p;
+        }
+    }
+    EXPECT_EQ(batch.to_string(2), "abc");
+}
+
+TEST(CandidateBatchTest, RejectsStridesOutsideTheSlotFormat) {
+    uint8_t storage[4 * 8];
+    EXPECT_THROW(CandidateBatch(4, 1), std::invalid_argument);
+    EXPECT_THROW(CandidateBatch(storage, 4, 1), std::invalid_argument);
+    EXPECT_THROW(CandidateBatch(4, CandidateBatch::MAX_STRIDE + 1), std::invalid_argument);
+    EXPECT_THROW(CandidateArena(4, CandidateBatch::MAX_STRIDE + 1), std::invalid_argument);
+    EXPECT_EQ(CandidateBatch(1, CandidateBatch::MAX_STRIDE).max_length(), 255u);
+}
+
+TEST(CandidateArenaTest, BatchesAreRecycledUpToTheLimit) {
+    size_t allocations = 0;
+    size_t frees = 0;
+    {
+        CandidateArena arena(4, 16, 2,
+                             [&](size_t size) { allocations++; return new uint8_t[size]; },
+                             [&](uint8_t* storage) { frees++; delete[] storage; });
+        CandidateBatch* first = nullptr;
+        {
+            CandidateArena::BatchPtr batch = arena.acquire();
+            first = batch.get();
+            ASSERT_TRUE(batch->push("stale"));
+        }
+        EXPECT_EQ(arena.get_free_batches(), 1u);
+
+        // The returned batch comes back empty instead of a new allocation
+        CandidateArena::BatchPtr a = arena.acquire();
+        EXPECT_EQ(a.get(), first);
+        EXPECT_TRUE(a->empty());
+        EXPECT_EQ(a->stride(), 16u);
+
+        CandidateArena::BatchPtr b = arena.try_acquire();
+        ASSERT_TRUE(b);
+        EXPECT_FALSE(arena.try_acquire());
+        EXPECT_EQ(arena.get_allocated_batches(), 2u);
+
+        // acquire() waits for a consumer at the limit
+        CandidateBatch* handed_back = b.get();
+        std::thread consumer([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            b.reset();
+        });
+        CandidateArena::BatchPtr c = arena.acquire();
+        consumer.join();
+        EXPECT_EQ(c.get(), handed_back);
+        EXPECT_EQ(allocations, 2u);
+    }
+    EXPECT_EQ(frees, 2u);
+}
+
+TEST(MaskGeneratorTest, BuiltInClassesAndLiterals) {
+    MaskGenerator generator;
+    ASSERT_TRUE(generator.add_mask("?u?l-?d??"));
+    EXPECT_EQ(generator.size(), static_cast<KeyspaceIndex>(26 * 26 * 10));
+    EXPECT_EQ(generator.max_length(), 5u);
+
+    std::string candidate;
+    ASSERT_TRUE(generator.candidate_at(0, candidate));
+    EXPECT_EQ(candidate, "Aa-0?");
+    ASSERT_TRUE(generator.candidate_at(generator.size() - 1, candidate));
+    EXPECT_EQ(candidate, "Zz-9?");
+    EXPECT_FALSE(generator.candidate_at(generator.size(), candidate));
+}
+
+TEST(MaskGeneratorTest, RejectsInvalidMasks) {
+    MaskGenerator generator;
+    EXPECT_FALSE(generator.add_mask("?q"));
+    EXPECT_FALSE(generator.add_mask("abc?"));
+    EXPECT_FALSE(generator.add_mask("?1"));
+    EXPECT_FALSE(generator.add_mask(""));
+
+    // 95^20 does not fit in 128 bits
+    std::string too_large;
+    for (int i = 0; i < 20; i++) too_large += "?a";
+    EXPECT_FALSE(generator.add_mask(too_large));
+    EXPECT_EQ(generator.size(), static_cast<KeyspaceIndex>(0));
+}
+
+TEST(MaskGeneratorTest, IndexRoundTripsAcrossLengths) {
+    MaskGenerator generator;
+    // Kept disjoint from ?l so no candidate appears under two masks
+    ASSERT_TRUE(generator.set_custom_charset(1, "?dXYZ"));
+    ASSERT_TRUE(generator.add_charset_range("lowercase", "", 1, 3, "", ""));
+    ASSERT_TRUE(generator.add_mask("?1?1"));
+    EXPECT_EQ(generator.size(), static_cast<KeyspaceIndex>(26 + 26 * 26 + 26 * 26 * 26 + 13 * 13));
+
+    std::set<std::string> seen;
+    for (KeyspaceIndex i = 0; i < generator.size(); i++) {
+        std::string candidate;
+        ASSERT_TRUE(generator.candidate_at(i, candidate));
+        KeyspaceIndex index = 0;
+        ASSERT_TRUE(generator.index_of(candidate, index)) << candidate;
+        EXPECT_EQ(index, i) << candidate;
+        seen.insert(candidate);
+    }
+    EXPECT_EQ(seen.size(), static_cast<size_t>(generator.size()));
+
+    KeyspaceIndex index = 0;
+    EXPECT_FALSE(generator.index_of("ABC", index));
+    EXPECT_FALSE(generator.index_of("abcd", index));
+}
+
+TEST(MaskGeneratorTest, PrefixAndSuffixArePinned) {
+    MaskGenerator generator;
+    ASSERT_TRUE(generator.add_charset_range("digits", "", 6, 7, "btc", "!"));
+    EXPECT_EQ(generator.size(), static_cast<KeyspaceIndex>(100 + 1000));
+
+    std::string candidate;
+    ASSERT_TRUE(generator.candidate_at(0, candidate));
+    EXPECT_EQ(candidate, "btc00!");
+    ASSERT_TRUE(generator.candidate_at(100, candidate));
+    EXPECT_EQ(candidate, "btc000!");
+}
+
+TEST(MaskGeneratorTest, FillMatchesRandomAccess) {
+    MaskGenerator generator;
+    ASSERT_TRUE(generator.add_mask("?d?d"));
+    ASSERT_TRUE(generator.add_mask("?h?l?d"));
+
+    // Start mid-way through the first mask so the fill crosses into the second
+    CandidateBatch batch(500, 16);
+    const KeyspaceIndex start = 37;
+    size_t produced = generator.fill(start, 1000, batch);
+    EXPECT_EQ(produced, batch.capacity());
+
+    for (size_t i = 0; i < produced; i++) {
+        std::string expected;
+        ASSERT_TRUE(generator.candidate_at(start + i, expected));
+        EXPECT_EQ(batch.to_string(i), expected) << "slot " << i;
+
+        // Padding stays zero even where a longer candidate preceded a shorter one
+        for (size_t b = batch.length(i); b < batch.max_length(); b++) {
+            ASSERT_EQ(batch.data(i)[b], 0) << "slot " << i;
+        }
+    }
+    EXPECT_EQ(batch.longest(), 3u);
+
+    // A fill stops at the end of the keyspace
+    batch.clear();
+    EXPECT_EQ(generator.fill(generator.size() - 3, 10, batch), 3u);
+    EXPECT_EQ(generator.fill(generator.size(), 10, batch), 0u);
+}
+
+TEST(MaskGeneratorTest, DeviceSegmentsMatchRandomAccess) {
+    MaskGenerator generator;
+    ASSERT_TRUE(generator.add_mask("?d?d"));
+    ASSERT_TRUE(generator.add_mask("x?h?l?d"));
+    std::vector<uint8_t> charsets;
+    ASSERT_TRUE(generator.device_charsets(charsets));
+
+    // Walk a range crossing from the first mask into the second the way a
+    // device would: one segment per mask, digits seeded from the segment
+    // at a stride and advanced by increments in between
+    KeyspaceIndex index = 37;
+    const KeyspaceIndex end = 37 + 2000;
+    size_t segments = 0;
+    while (index < end) {
+        DeviceMaskSegment segment;
+        ASSERT_TRUE(generator.device_segment(index, static_cast<uint64_t>(end - index), segment));
+        ASSERT_GT(segment.count, 0u);
+        segments++;
+
+        uint16_t digits[DEVICE_MASK_MAX_LENGTH];
+        for (uint32_t i = 0; i < segment.count; i++) {
+            if (i % 7 == 0) {
+                device_mask_digits(segment, i, digits);
+            } else {
+                device_mask_increment(segment, digits);
+            }
+            uint8_t candidate[DEVICE_MASK_MAX_LENGTH];
+            device_mask_write(segment, charsets.data(), digits, candidate);
+
+            std::string expected;
+            ASSERT_TRUE(generator.candidate_at(index + i, expected));
+            ASSERT_EQ(std::string(reinterpret_cast<const char*>(candidate), segment.length), expected)
+                << "index " << static_cast<uint64_t>(index + i);
+        }
+        index += segment.count;
+    }
+    EXPECT_EQ(segments, 2u);
+
+    // Markov order has no odometer walk to describe
+    DeviceMaskSegment segment;
+    EXPECT_FALSE(generator.device_segment(generator.size(), 1, segment));
+    generator.set_markov_model(std::make_shared<MarkovModel>());
+    EXPECT_FALSE(generator.device_segment(0, 1, segment));
+}
+
+TEST(MaskGeneratorTest, HandlesKeyspacesBeyond64Bits) {
+    MaskGenerator generator;
+    ASSERT_TRUE(generator.add_mask("?a?a?a?a?a?a?a?a?a?a?a?a"));
+    const KeyspaceIndex expected = [] {
+        KeyspaceIndex size = 1;
+        for (int i = 0; i < 12; i++) size *= 95;
+        return size;
+    }();
+    EXPECT_EQ(generator.size(), expected);
+    EXPECT_GT(generator.size(), static_cast<KeyspaceIndex>(UINT64_MAX));
+
+    std::string candidate;
+    ASSERT_TRUE(generator.candidate_at(generator.size() - 1, candidate));
+    EXPECT_EQ(candidate, std::string(12, '~'));
+
+    KeyspaceIndex index = 0;
+    ASSERT_TRUE(generator.index_of(candidate, index));
+    EXPECT_TRUE(index == generator.size() - 1);
+}
+
+TEST(MarkovOrderTest, LevelsFollowTrainingCounts) {
+    MarkovModel model;
+    model.train("ab", 8);
+    model.train("ac", 2);
+    model.train("b");
+
+    uint8_t levels[4];
+    model.levels(0, MarkovModel::START, "abcz", levels);
+    EXPECT_EQ(levels[0], 0);
+    EXPECT_EQ(levels[1], 2);   // 2 against 11 after smoothing
+    EXPECT_EQ(levels[3], 3);
+    model.levels(1, 'a', "bcz", levels);
+    EXPECT_EQ(levels[0], 0);
+    EXPECT_EQ(levels[1], 1);
+    EXPECT_EQ(levels[2], 3);
+
+    // An unseen context falls back to the position's own counts
+    model.levels(1, 'q', "bcz", levels);
+    EXPECT_EQ(levels[0], 0);
+    EXPECT_EQ(levels[1], 1);
+
+    MarkovModel other;
+    other.train("ab", 8);
+    EXPECT_NE(model.digest(), other.digest());
+}
+
+TEST(MarkovOrderTest, ReordersTheSameKeyspaceMostProbableFirst) {
+    auto model = std::make_shared<MarkovModel>();
+    for (const char* word : {"cab", "cab", "cab", "cat", "cat", "bat", "ab"}) {
+        model->train(word);
+    }
+
+    MaskGenerator plain;
+    ASSERT_TRUE(plain.add_charset_range("lowercase", "", 1, 3, "", ""));
+    MaskGenerator ordered;
+    ordered.set_markov_model(model);
+    ASSERT_TRUE(ordered.add_charset_range("lowercase", "", 1, 3, "", ""));
+    ASSERT_TRUE(ordered.is_markov_ordered());
+    ASSERT_EQ(ordered.size(), plain.size());
+
+    // A bijection onto the plain keyspace that round-trips through index_of
+    std::set<std::string> seen;
+    for (KeyspaceIndex i = 0; i < ordered.size(); i++) {
+        std::string candidate;
+        ASSERT_TRUE(ordered.candidate_at(i, candidate));
+        KeyspaceIndex index = 0;
+        ASSERT_TRUE(ordered.index_of(candidate, index)) << candidate;
+        ASSERT_TRUE(index == i) << candidate;
+        ASSERT_TRUE(plain.index_of(candidate, index)) << candidate;
+        seen.insert(candidate);
+    }
+    EXPECT_EQ(seen.size(), static_cast<size_t>(plain.size()));
+
+    // The training favourites come long before their lexicographic places
+    std::string first;
+    ASSERT_TRUE(ordered.candidate_at(0, first));
+    EXPECT_EQ(first, "c");
+    KeyspaceIndex cab = 0;
+    KeyspaceIndex cat = 0;
+    KeyspaceIndex zzz = 0;
+    ASSERT_TRUE(ordered.index_of("cab", cab));
+    ASSERT_TRUE(ordered.index_of("cat", cat));
+    ASSERT_TRUE(ordered.index_of("zzz", zzz));
+    EXPECT_TRUE(cab < 100);
+    EXPECT_TRUE(cab < cat);
+    EXPECT_TRUE(zzz > ordered.size() / 2);
+
+    // fill() agrees with random access across block boundaries
+    CandidateBatch batch(700, 8);
+    ASSERT_EQ(ordered.fill(5, 700, batch), 700u);
+    for (size_t i = 0; i < batch.size(); i++) {
+        std::string expected;
+        ASSERT_TRUE(ordered.candidate_at(5 + i, expected));
+        ASSERT_EQ(batch.to_string(i), expected) << "slot " << i;
+    }
+
+    ordered.set_markov_model(nullptr);
+    ASSERT_TRUE(ordered.candidate_at(0, first));
+    EXPECT_EQ(first, "a");
+}
+
+namespace {
+
+std::string write_wordlist(const std::string& contents) {
+    std::string path = ::testing::TempDir() + "btc_recovery_wordlist.txt";
+    std::ofstream(path, std::ios::binary) << contents;
+    return path;
+}
+
+} // namespace
+
+TEST(DictionarySourceTest, SplitRangesCoverEveryWordOnce) {
+    std::string contents;
+    std::vector<std::string> words;
+    for (int i = 0; i < 5000; i++) {
+        words.push_back("word" + std::to_string(i * 31));
+        contents += words.back() + (i % 3 == 0 ? "\r\n" : "\n");
+        if (i % 100 == 0) contents += "\n";  // Blank lines are skipped
+    }
+    contents += "unterminated";
+    words.push_back("unterminated");
+
+    DictionarySource source;
+    ASSERT_TRUE(source.open(write_wordlist(contents)));
+
+    std::multiset<std::string> seen;
+    const auto ranges = source.split(7);
+    ASSERT_EQ(ranges.size(), 7u);
+    for (const auto& range : ranges) {
+        DictionaryCursor cursor = source.cursor(range);
+        std::string_view word;
+        while (cursor.next(word)) {
+            seen.insert(std::string(word));
+        }
+        EXPECT_EQ(cursor.offset(), range.end);
+    }
+
+    EXPECT_EQ(seen, std::multiset<std::string>(words.begin(), words.end()));
+}
+
+TEST(DictionarySourceTest, CursorOffsetResumesWhereFillStopped) {
+    DictionarySource source;
+    ASSERT_TRUE(source.open(write_wordlist("alpha\nbeta\n" + std::string(80, 'x') + "\ngamma\ndelta\n")));
+
+    CandidateBatch batch(2, 32);
+    DictionaryCursor cursor = source.cursor();
+    ASSERT_EQ(cursor.fill(batch), 2u);
+    EXPECT_EQ(batch.to_string(1), "beta");
+
+    // A fresh cursor from the saved offset sees the rest; the overlong line is skipped
+    DictionaryCursor resumed = source.cursor({cursor.offset(), source.size()});
+    batch.clear();
+    ASSERT_EQ(resumed.fill(batch), 2u);
+    EXPECT_EQ(batch.to_string(0), "gamma");
+    EXPECT_EQ(batch.to_string(1), "delta");
+    EXPECT_EQ(resumed.skipped(), 1u);
+    EXPECT_TRUE(resumed.done());
+}
+
+TEST(RuleEngineTest, CompilesSampleRulesFormat) {
+    RuleEngine rules;
+    ASSERT_TRUE(rules.add_line("# Format: rule_name:pattern:transformations"));
+    ASSERT_TRUE(rules.add_line("append_years:$word:$2020,$2021"));
+    ASSERT_TRUE(rules.add_line("prepend_digits:$word:0$,1$"));
+    ASSERT_TRUE(rules.add_line("capitalize:$word:c"));
+    ASSERT_TRUE(rules.add_line("leet_speak:$word:sa@,so0"));
+    ASSERT_TRUE(rules.add_line("c $! sa4"));
+    ASSERT_EQ(rules.size(), 8u);
+
+    const std::vector<std::string> expected = {
+        "bAnana2020", "bAnana2021", "0bAnana", "1bAnana", "Banana", "bAn@n@", "bAnana", "B4n4n4!"
+    };
+    for (size_t i = 0; i < expected.size(); i++) {
+        std::string result;
+        ASSERT_TRUE(rules.apply(i, "bAnana", result));
+        EXPECT_EQ(result, expected[i]) << "rule " << i;
+    }
+
+    EXPECT_FALSE(rules.add_line("broken:$word:x"));
+    EXPECT_FALSE(rules.add_line("broken:$word:"));
+    EXPECT_FALSE(rules.add_rule("$"));
+    EXPECT_EQ(rules.size(), 8u);
+}
+
+TEST(RuleEngineTest, SubstituteWithDollarIsNotAPrepend) {
+    RuleEngine rules;
+    ASSERT_TRUE(rules.add_rule("sa$"));
+    ASSERT_TRUE(rules.add_rule("ss$"));
+    ASSERT_TRUE(rules.add_rule("a$ s$"));
+
+    const uint8_t* program = rules.program(0);
+    EXPECT_EQ(program[0], RULE_OP_SUBSTITUTE);
+    EXPECT_EQ(program[1], 'a');
+    EXPECT_EQ(program[2], '$');
+    EXPECT_EQ(program[3], RULE_OP_END);
+
+    // The host result is the one the CUDA kernels compute from the same bytecode
+    const std::vector<std::string> expected = {"b$n$n$", "gla$$", "saglass"};
+    const std::vector<std::string> words = {"banana", "glass", "glass"};
+    for (size_t i = 0; i < expected.size(); i++) {
+        std::string result;
+        ASSERT_TRUE(rules.apply(i, words[i], result));
+        EXPECT_EQ(result, expected[i]) << "rule " << i;
+
+        uint8_t buffer[CandidateBatch::MAX_STRIDE] = {};
+        std::memcpy(buffer, words[i].data(), words[i].size());
+        const int length = rule_apply(rules.program(i), buffer, static_cast<int>(words[i].size()),
+                                      CandidateBatch::MAX_STRIDE - 1);
+        ASSERT_GE(length, 0);
+        EXPECT_EQ(std::string(reinterpret_cast<const char*>(buffer), static_cast<size_t>(length)), expected[i]);
+    }
+}
+
+TEST(RuleEngineTest, ExpandDropsResultsThatDoNotFit) {
+    RuleEngine rules;
+    ASSERT_TRUE(rules.add_rule(":"));
+    ASSERT_TRUE(rules.add_rule("d"));
+    ASSERT_TRUE(rules.add_rule("r u"));
+
+    CandidateBatch words(3, 16);
+    words.push("abc");
+    words.push("0123456789");
+    words.push("xy");
+
+    // Stop part-way through the second word, then continue from the saved position
+    CandidateBatch first(4, 16);
+    size_t word_index = 0;
+    size_t rule_index = 0;
+    ASSERT_EQ(rules.expand(words, word_index, rule_index, first), 4u);
+    EXPECT_EQ(word_index, 1u);
+    EXPECT_EQ(rule_index, 1u);
+
+    CandidateBatch rest(8, 16);
+    ASSERT_EQ(rules.expand(words, word_index, rule_index, rest), 4u);
+
+    std::vector<std::string> results;
+    for (size_t i = 0; i < first.size(); i++) results.push_back(first.to_string(i));
+    for (size_t i = 0; i < rest.size(); i++) results.push_back(rest.to_string(i));
+    const std::vector<std::string> expected = {
+        "abc", "abcabc", "CBA", "0123456789", "9876543210", "xy", "xyxy", "YX"
+    };
+    EXPECT_EQ(results, expected);
+    EXPECT_EQ(rest.length(0), 10u);
+    EXPECT_EQ(rest.data(0)[10], 0);
+}
+
+TEST(RuleEngineTest, ExpanderResumesFromWordOffsetAndRule) {
+    DictionarySource source;
+    ASSERT_TRUE(source.open(write_wordlist("one\ntwo\nthree\n")));
+
+    RuleEngine rules;
+    ASSERT_TRUE(rules.add_line("suffixes:$word:$1,$2,u"));
+
+    std::vector<std::string> all;
+    DictionaryCursor cursor = source.cursor();
+    RuleExpander expander(rules, cursor);
+    CandidateBatch batch(4, 32);
+    ASSERT_EQ(expander.fill(batch), 4u);
+    for (size_t i = 0; i < batch.size(); i++) all.push_back(batch.to_string(i));
+
+    // Resume a fresh cursor and expander from the saved position
+    DictionaryCursor resumed = source.cursor({expander.word_offset(), source.size()});
+    RuleExpander rest(rules, resumed, expander.rule_index());
+    batch.clear();
+    while (!rest.done()) {
+        rest.fill(batch);
+        for (size_t i = 0; i < batch.size(); i++) all.push_back(batch.to_string(i));
+        batch.clear();
+    }
+
+    const std::vector<std::string> expected = {
+        "one1", "one2", "ONE", "two1", "two2", "TWO", "three1", "three2", "THREE"
+    };
+    EXPECT_EQ(all, expected);
+}
+
+TEST(KeyspaceSchedulerTest, InitialSplitIsEven) {
+    KeyspaceScheduler scheduler(KeyspaceRange{0, 10}, 3, 1);
+
+    // The first (10 % 3) workers get one extra index
+    const auto ranges = scheduler.unclaimed_ranges();
+    ASSERT_EQ(ranges.size(), 3u);
+    EXPECT_TRUE(ranges[0].begin == 0 && ranges[0].end == 4);
+    EXPECT_TRUE(ranges[1].begin == 4 && ranges[1].end == 7);
+    EXPECT_TRUE(ranges[2].begin == 7 && ranges[2].end == 10);
+    EXPECT_TRUE(scheduler.remaining() == 10);
+
+    KeyspaceRange chunk;
+    ASSERT_TRUE(scheduler.next_chunk(1, 100, chunk));
+    EXPECT_TRUE(chunk.begin == 4 && chunk.end == 7);
+    EXPECT_EQ(scheduler.steal_count(), 0u);
+}
+
+TEST(KeyspaceSchedulerTest, IdleWorkerStealsTheBackHalf) {
+    KeyspaceScheduler scheduler(KeyspaceRange{0, 1000}, 2, 8);
+
+    KeyspaceRange chunk;
+    ASSERT_TRUE(scheduler.next_chunk(0, 500, chunk));
+    EXPECT_TRUE(chunk.begin == 0 && chunk.end == 500);
+
+    // Worker 0 is out of work and takes [750, 1000) from worker 1
+    ASSERT_TRUE(scheduler.next_chunk(0, 1000, chunk));
+    EXPECT_TRUE(chunk.begin == 750 && chunk.end == 1000);
+    EXPECT_EQ(scheduler.steal_count(), 1u);
+
+    ASSERT_TRUE(scheduler.next_chunk(1, 1000, chunk));
+    EXPECT_TRUE(chunk.begin == 500 && chunk.end == 750);
+    EXPECT_FALSE(scheduler.next_chunk(1, 1000, chunk));
+    EXPECT_FALSE(scheduler.next_chunk(0, 1000, chunk));
+    EXPECT_TRUE(scheduler.unclaimed_ranges().empty());
+}
+
+TEST(KeyspaceSchedulerTest, SmallRangesAreStolenWhole) {
+    // 50 left is at the threshold, so the thief takes all of it
+    KeyspaceScheduler whole(KeyspaceRange{0, 100}, 2, 50);
+    KeyspaceRange chunk;
+    ASSERT_TRUE(whole.next_chunk(0, 50, chunk));
+    ASSERT_TRUE(whole.next_chunk(0, 100, chunk));
+    EXPECT_TRUE(chunk.begin == 50 && chunk.end == 100);
+    EXPECT_FALSE(whole.next_chunk(1, 100, chunk));
+
+    // 51 left is above it and is split
+    KeyspaceScheduler split(KeyspaceRange{0, 102}, 2, 50);
+    ASSERT_TRUE(split.next_chunk(0, 51, chunk));
+    ASSERT_TRUE(split.next_chunk(0, 100, chunk));
+    EXPECT_TRUE(chunk.begin == 76 && chunk.end == 102);
+    ASSERT_TRUE(split.next_chunk(1, 100, chunk));
+    EXPECT_TRUE(chunk.begin == 51 && chunk.end == 76);
+}
+
+TEST(KeyspaceSchedulerTest, FastWorkersStealFromASlowOne) {
+    const size_t total = 40000;
+    KeyspaceScheduler scheduler(KeyspaceRange{0, total}, 4, 64);
+
+    std::vector<int> seen(total, 0);
+    std::vector<size_t> processed(4, 0);
+    std::mutex lock;
+    scheduler.run(64, [&](size_t worker, const KeyspaceRange& chunk) {
+        if (worker == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (KeyspaceIndex i = chunk.begin; i < chunk.end; i++) seen[static_cast<size_t>(i)]++;
+            processed[worker] += static_cast<size_t>(chunk.size());
+        }
+        scheduler.report(worker, static_cast<uint64_t>(chunk.size()));
+        return true;
+    });
+
+    for (size_t i = 0; i < seen.size(); i++) {
+        ASSERT_EQ(seen[i], 1) << "index " << i;
+    }
+    EXPECT_GT(scheduler.steal_count(), 0u);
+    EXPECT_LT(processed[0], total / 4);  // The others took part of its share
+    EXPECT_TRUE(scheduler.completed() == total);
+}
+
+TEST(KeyspaceSchedulerTest, RangesCrossTheSixtyFourBitBoundary) {
+    const KeyspaceIndex boundary = static_cast<KeyspaceIndex>(UINT64_MAX);
+    KeyspaceScheduler scheduler(KeyspaceRange{boundary - 10, boundary + 10}, 2, 1);
+
+    const auto ranges = scheduler.unclaimed_ranges();
+    ASSERT_EQ(ranges.size(), 2u);
+    EXPECT_TRUE(ranges[0].end == boundary && ranges[1].begin == boundary);
+
+    KeyspaceRange chunk;
+    ASSERT_TRUE(scheduler.next_chunk(0, 100, chunk));
+    EXPECT_TRUE(chunk.begin == boundary - 10 && chunk.end == boundary);
+    ASSERT_TRUE(scheduler.next_chunk(0, 100, chunk));
+    EXPECT_TRUE(chunk.begin == boundary + 5 && chunk.end == boundary + 10);
+    ASSERT_TRUE(scheduler.next_chunk(1, 100, chunk));
+    EXPECT_TRUE(chunk.begin == boundary && chunk.end == boundary + 5);
+
+    // Per-worker hints saturate instead of wrapping
+    const KeyspaceIndex huge = static_cast<KeyspaceIndex>(1) << 100;
+    KeyspaceScheduler wide(KeyspaceRange{huge, huge * 2}, 2, 1);
+    EXPECT_TRUE(wide.remaining() == boundary * 2);
+    ASSERT_TRUE(wide.next_chunk(1, UINT64_MAX, chunk));
+    EXPECT_TRUE(chunk.begin == huge + huge / 2 && chunk.size() == boundary);
+
+    KeyspaceIndex parsed = 0;
+    EXPECT_EQ(keyspace_index_to_string(huge), "1267650600228229401496703205376");
+    ASSERT_TRUE(keyspace_index_from_string("340282366920938463463374607431768211455", parsed));
+    EXPECT_TRUE(parsed == ~static_cast<KeyspaceIndex>(0));
+    EXPECT_FALSE(keyspace_index_from_string("340282366920938463463374607431768211456", parsed));
+}
+
+TEST(CheckpointTest, CompletedRangesResumeOnlyTheGaps) {
+    CompletedRanges completed;
+    completed.add({100, 200});
+    completed.add({300, 400});
+    completed.add({200, 250});   // Extends the first range
+    completed.add({390, 500});   // Overlaps the second
+    completed.add({0, 10});
+
+    const auto ranges = completed.ranges();
+    ASSERT_EQ(ranges.size(), 3u);
+    EXPECT_TRUE(ranges[1].begin == 100 && ranges[1].end == 250);
+    EXPECT_TRUE(ranges[2].begin == 300 && ranges[2].end == 500);
+    EXPECT_TRUE(completed.count() == 360);
+
+    const KeyspaceRange keyspace{0, 1000};
+    const auto remaining = completed.remaining(keyspace);
+    ASSERT_EQ(remaining.size(), 3u);
+    EXPECT_TRUE(remaining[0].begin == 10 && remaining[0].end == 100);
+    EXPECT_TRUE(remaining[2].begin == 500 && remaining[2].end == 1000);
+
+    // A scheduler over the gaps hands out each remaining index exactly once
+    KeyspaceScheduler scheduler(remaining, 4, 8);
+    std::vector<int> seen(1000, 0);
+    std::mutex lock;
+    scheduler.run(16, [&](size_t, const KeyspaceRange& chunk) {
+        std::lock_guard<std::mutex> guard(lock);
+        for (KeyspaceIndex i = chunk.begin; i < chunk.end; i++) seen[static_cast<size_t>(i)]++;
+        completed.add(chunk);
+        return true;
+    });
+    for (size_t i = 0; i < seen.size(); i++) {
+        const bool done_before = i < 10 || (i >= 100 && i < 250) || (i >= 300 && i < 500);
+        EXPECT_EQ(seen[i], done_before ? 0 : 1) << "index " << i;
+    }
+    EXPECT_TRUE(completed.remaining(keyspace).empty());
+}
+
+TEST(CheckpointTest, SaveAndLoadRoundTrip) {
+    const std::string path = ::testing::TempDir() + "btc_recovery_test.checkpoint";
+    const KeyspaceIndex large = static_cast<KeyspaceIndex>(1) << 100;
+
+    CheckpointState state;
+    state.fingerprint = Checkpoint::fingerprint(write_wordlist("wallet bytes"), "brute_force mixed 6 12");
+    state.keyspace = {0, large * 3};
+    state.completed = {{0, 5}, {large, large + 12345}};
+    state.dictionary = {{1024, 4096, 7}};
+    state.candidates_tested = 12350;
+    state.elapsed_seconds = 3.25;
+    state.candidates_per_second = 3800.0;
+
+    Checkpoint checkpoint(path, 0);
+    ASSERT_TRUE(checkpoint.save(state)) << checkpoint.get_last_error();
+    EXPECT_FALSE(std::ifstream(path + ".tmp").good());
+
+    CheckpointState loaded;
+    ASSERT_TRUE(checkpoint.load(loaded)) << checkpoint.get_last_error();
+    EXPECT_EQ(loaded.fingerprint.size(), 16u);
+    EXPECT_EQ(loaded.fingerprint, state.fingerprint);
+    EXPECT_TRUE(loaded.keyspace.end == large * 3);
+    ASSERT_EQ(loaded.completed.size(), 2u);
+    EXPECT_TRUE(loaded.completed[1].begin == large && loaded.completed[1].end == large + 12345);
+    ASSERT_EQ(loaded.dictionary.size(), 1u);
+    EXPECT_EQ(loaded.dictionary[0].offset, 1024u);
+    EXPECT_EQ(loaded.dictionary[0].rule, 7u);
+    EXPECT_EQ(loaded.candidates_tested, 12350u);
+    EXPECT_DOUBLE_EQ(loaded.elapsed_seconds, 3.25);
+
+    // A different search on the same wallet gets a different fingerprint
+    EXPECT_NE(Checkpoint::fingerprint(write_wordlist("wallet bytes"), "brute_force mixed 6 13"), state.fingerprint);
+
+    std::ofstream(path) << "not a checkpoint\n";
+    EXPECT_FALSE(checkpoint.load(loaded));
+    checkpoint.remove();
+}
+
+TEST(TestedCandidateIndexTest, FiltersCandidatesTestedInEarlierRuns) {
+    const std::string path = ::testing::TempDir() + "btc_recovery_test.tested";
+    std::remove(path.c_str());
+    const uint8_t salt[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+    {
+        TestedCandidateIndex index;
+        ASSERT_TRUE(index.open(path, salt, sizeof(salt), 25000)) << index.get_last_error();
+        CandidateBatch batch(8);
+        batch.push("alpha");
+        batch.push("bravo");
+        batch.push("alpha");
+        EXPECT_EQ(index.filter(batch), 1u);
+        ASSERT_EQ(batch.size(), 2u);
+        EXPECT_EQ(batch.to_string(1), "bravo");
+        index.record(batch);
+        EXPECT_EQ(index.pending_count(), 2u);
+        // Closing flushes what was recorded
+    }
+
+    TestedCandidateIndex index;
+    ASSERT_TRUE(index.open(path, salt, sizeof(salt), 25000)) << index.get_last_error();
+    EXPECT_EQ(index.size(), 2u);
+    EXPECT_EQ(index.run_count(), 1u);
+    CandidateBatch batch(8);
+    batch.push("charlie");
+    batch.push("alpha");
+    batch.push("delta");
+    batch.push("bravo");
+    EXPECT_EQ(index.filter(batch), 2u);
+    ASSERT_EQ(batch.size(), 2u);
+    EXPECT_EQ(batch.to_string(0), "charlie");
+    EXPECT_EQ(batch.to_string(1), "delta");
+    index.close();
+
+    // The same salt with another iteration count is another wallet
+    TestedCandidateIndex other;
+    EXPECT_FALSE(other.open(path, salt, sizeof(salt), 25001));
+    EXPECT_NE(TestedCandidateIndex::file_name(salt, sizeof(salt), 25000),
+              TestedCandidateIndex::file_name(salt, sizeof(salt), 25001));
+    std::remove(path.c_str());
+}
+
+TEST(TestedCandidateIndexTest, MergesRunsAndRecoversFromATornFlush) {
+    const std::string path = ::testing::TempDir() + "btc_recovery_runs.tested";
+    std::remove(path.c_str());
+    const uint8_t salt[4] = {9, 9, 9, 9};
+
+    TestedCandidateIndex index;
+    ASSERT_TRUE(index.open(path, salt, sizeof(salt), 1000)) << index.get_last_error();
+    for (size_t run = 0; run < TestedCandidateIndex::MAX_RUNS + 1; run++) {
+        for (int i = 0; i < 50; i++) {
+            index.record(reinterpret_cast<const uint8_t*>(std::to_string(run * 1000 + i).data()),
+                         std::to_string(run * 1000 + i).size());
+        }
+        ASSERT_TRUE(index.flush()) << index.get_last_error();
+    }
+    EXPECT_EQ(index.run_count(), 1u);
+    EXPECT_EQ(index.size(), 50u * (TestedCandidateIndex::MAX_RUNS + 1));
+    index.close();
+
+    // A count with no fingerprints behind it, as a crash mid-append leaves
+    {
+        std::ofstream tail(path, std::ios::binary | std::ios::app);
+        const uint64_t count = 1000;
+        tail.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    }
+    ASSERT_TRUE(index.open(path, salt, sizeof(salt), 1000)) << index.get_last_error();
+    EXPECT_TRUE(index.contains(reinterpret_cast<const uint8_t*>("8049"), 4));
+    EXPECT_FALSE(index.contains(reinterpret_cast<const uint8_t*>("8050"), 4));
+    index.record(reinterpret_cast<const uint8_t*>("new"), 3);
+    ASSERT_TRUE(index.flush()) << index.get_last_error();
+    index.close();
+
+    ASSERT_TRUE(index.open(path, salt, sizeof(salt), 1000)) << index.get_last_error();
+    EXPECT_EQ(index.size(), 50u * (TestedCandidateIndex::MAX_RUNS + 1) + 1);
+    EXPECT_TRUE(index.contains(reinterpret_cast<const uint8_t*>("new"), 3));
+    index.close();
+    std::remove(path.c_str());
+}
+
+TEST(DeviceSchedulerTest, ThroughputWindowFollowsRecentWork) {
+    ThroughputWindow window(5.0);
+    EXPECT_EQ(window.rate(), 0.0);
+    for (int i = 0; i < 10; i++) window.add(100, 1.0);
+    EXPECT_DOUBLE_EQ(window.rate(), 100.0);
+
+    // After a full window at the new speed the old samples no longer count
+    for (int i = 0; i < 5; i++) window.add(1000, 1.0);
+    EXPECT_DOUBLE_EQ(window.rate(), 1000.0);
+    EXPECT_EQ(window.sample_count(), 5u);
+
+    // One chunk longer than the window still gives a rate
+    window.add(600000, 60.0);
+    EXPECT_DOUBLE_EQ(window.rate(), 10000.0);
+}
+
+TEST(DeviceSchedulerTest, ChunksFollowMeasuredThroughput) {
+    std::vector<ComputeDevice> devices(2);
+    devices[0].name = "slow";
+    devices[0].min_chunk = 10;
+    devices[1].name = "fast";
+    devices[1].kind = ComputeDeviceKind::CUDA;
+    devices[1].min_chunk = 10;
+    DeviceScheduler scheduler(devices, {{0, 1000000}}, 0.5);
+
+    EXPECT_EQ(scheduler.chunk_size(0), 10u);
+    scheduler.report(0, 1000, 1.0);
+    scheduler.report(1, 10000, 1.0);
+    EXPECT_EQ(scheduler.chunk_size(0), 500u);
+    EXPECT_EQ(scheduler.chunk_size(1), 5000u);
+    const auto shares = scheduler.shares();
+    EXPECT_NEAR(shares[1], 10.0 / 11.0, 1e-9);
+
+    // Near the end each device gets no more than its share of what is left
+    std::vector<int> seen(1000000, 0);
+    KeyspaceRange chunk;
+    for (size_t device = 0; scheduler.next_chunk(device, chunk); device ^= 1) {
+        for (KeyspaceIndex i = chunk.begin; i < chunk.end; i++) seen[static_cast<size_t>(i)]++;
+        if (scheduler.keyspace().remaining() < 1000) {
+            EXPECT_LE(scheduler.chunk_size(0), 100u);
+        }
+    }
+    for (size_t i = 0; i < seen.size(); i++) {
+        ASSERT_EQ(seen[i], 1) << "index " << i;
+    }
+}
+
+TEST(DeviceSchedulerTest, RunCoversEveryIndexOnce) {
+    std::vector<ComputeDevice> devices(3);
+    for (auto& device : devices) device.min_chunk = 16;
+    DeviceScheduler scheduler(devices, {{0, 200}, {500, 20000}}, 0.001);
+
+    std::vector<int> seen(20000, 0);
+    std::mutex lock;
+    scheduler.run([&](size_t, const KeyspaceRange& chunk) {
+        std::lock_guard<std::mutex> guard(lock);
+        for (KeyspaceIndex i = chunk.begin; i < chunk.end; i++) seen[static_cast<size_t>(i)]++;
+        return true;
+    });
+    for (size_t i = 0; i < seen.size(); i++) {
+        ASSERT_EQ(seen[i], (i < 200 || i >= 500) ? 1 : 0) << "index " << i;
+    }
+    EXPECT_TRUE(scheduler.keyspace().completed() == 200 + 19500);
+}